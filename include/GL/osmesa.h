@@ -106,6 +106,8 @@ extern "C" {
 #define OSMESA_COMPAT_PROFILE        0x35
 #define OSMESA_CONTEXT_MAJOR_VERSION 0x36
 #define OSMESA_CONTEXT_MINOR_VERSION 0x37
+#define OSMESA_NUM_THREADS           0x38
+#define OSMESA_PIN_THREADS           0x39
 
 
 typedef struct osmesa_context *OSMesaContext;
@@ -153,9 +155,17 @@ OSMesaCreateContextExt( GLenum format, GLint depthBits, GLint stencilBits,
  * OSMESA_PROFILE                OSMESA_COMPAT_PROFILE*, OSMESA_CORE_PROFILE
  * OSMESA_CONTEXT_MAJOR_VERSION  1*, 2, 3
  * OSMESA_CONTEXT_MINOR_VERSION  0+
+ * OSMESA_NUM_THREADS            -1*, 0+
+ * OSMESA_PIN_THREADS            0*, 1
  *
  * Note: * = default value
  *
+ * OSMESA_NUM_THREADS is the number of threads the driver renders with, 0
+ * renders in the thread calling GL and -1 keeps the driver's default.
+ * OSMESA_PIN_THREADS pins each of those threads to its own CPU.  All
+ * contexts share the driver's threads, so these only take effect for the
+ * first context created in the process and are ignored later on.
+ *
  * We return a context version >= what's specified by OSMESA_CONTEXT_MAJOR/
  * MINOR_VERSION for the given profile.  For example, if you request a GL 1.4
  * compat profile, you might get a GL 3.0 compat profile.
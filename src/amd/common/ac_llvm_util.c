@@ -174,7 +174,7 @@ static LLVMTargetMachineRef ac_create_target_machine(enum radeon_family family,
 }
 
 static LLVMPassManagerRef ac_create_passmgr(LLVMTargetLibraryInfoRef target_library_info,
-					    bool check_ir)
+					    bool check_ir, bool fast_compile)
 {
 	LLVMPassManagerRef passmgr = LLVMCreatePassManager();
 	if (!passmgr)
@@ -196,6 +196,13 @@ static LLVMPassManagerRef ac_create_passmgr(LLVMTargetLibraryInfoRef target_libr
 	ac_llvm_add_barrier_noop_pass(passmgr);
 	/* This pass should eliminate all the load and store instructions. */
 	LLVMAddPromoteMemoryToRegisterPass(passmgr);
+	if (fast_compile) {
+		/* Only clean up what the NIR translation leaves behind and
+		 * leave the rest to the backend.
+		 */
+		LLVMAddCFGSimplificationPass(passmgr);
+		return passmgr;
+	}
 	LLVMAddScalarReplAggregatesPass(passmgr);
 	LLVMAddLICMPass(passmgr);
 	LLVMAddAggressiveDCEPass(passmgr);
@@ -308,7 +315,9 @@ ac_init_llvm_compiler(struct ac_llvm_compiler *compiler,
 	memset(compiler, 0, sizeof(*compiler));
 
 	compiler->tm = ac_create_target_machine(family, tm_options,
-						LLVMCodeGenLevelDefault,
+						tm_options & AC_TM_FAST_COMPILE ?
+							LLVMCodeGenLevelLess :
+							LLVMCodeGenLevelDefault,
 						&triple);
 	if (!compiler->tm)
 		return false;
@@ -329,7 +338,8 @@ ac_init_llvm_compiler(struct ac_llvm_compiler *compiler,
 	}
 
 	compiler->passmgr = ac_create_passmgr(compiler->target_library_info,
-					      tm_options & AC_TM_CHECK_IR);
+					      tm_options & AC_TM_CHECK_IR,
+					      tm_options & AC_TM_FAST_COMPILE);
 	if (!compiler->passmgr)
 		goto fail;
 
@@ -890,6 +890,28 @@ radv_emit_graphics_pipeline(struct radv_cmd_buffer *cmd_buffer)
 	cmd_buffer->state.dirty &= ~RADV_CMD_DIRTY_PIPELINE;
 }
 
+/* Emit SET_CONTEXT_REG for count consecutive tracked registers, unless
+ * they all already hold the given values.
+ */
+static void
+radv_opt_set_context_reg_seq(struct radv_cmd_buffer *cmd_buffer,
+			     unsigned offset, enum radv_tracked_reg reg,
+			     unsigned count, const uint32_t *values)
+{
+	struct radv_tracked_regs *tracked = &cmd_buffer->state.tracked_regs;
+	uint32_t mask = u_bit_consecutive(reg, count);
+
+	if ((tracked->reg_saved & mask) == mask &&
+	    !memcmp(&tracked->reg_value[reg], values, count * 4))
+		return;
+
+	radeon_set_context_reg_seq(cmd_buffer->cs, offset, count);
+	radeon_emit_array(cmd_buffer->cs, values, count);
+
+	memcpy(&tracked->reg_value[reg], values, count * 4);
+	tracked->reg_saved |= mask;
+}
+
 static void
 radv_emit_viewport(struct radv_cmd_buffer *cmd_buffer)
 {
@@ -928,9 +950,11 @@ static void
 radv_emit_line_width(struct radv_cmd_buffer *cmd_buffer)
 {
 	unsigned width = cmd_buffer->state.dynamic.line_width * 8;
+	uint32_t pa_su_line_cntl = S_028A08_WIDTH(CLAMP(width, 0, 0xFFF));
 
-	radeon_set_context_reg(cmd_buffer->cs, R_028A08_PA_SU_LINE_CNTL,
-			       S_028A08_WIDTH(CLAMP(width, 0, 0xFFF)));
+	radv_opt_set_context_reg_seq(cmd_buffer, R_028A08_PA_SU_LINE_CNTL,
+				     RADV_TRACKED_PA_SU_LINE_CNTL, 1,
+				     &pa_su_line_cntl);
 }
 
 static void
@@ -938,38 +962,41 @@ radv_emit_blend_constants(struct radv_cmd_buffer *cmd_buffer)
 {
 	struct radv_dynamic_state *d = &cmd_buffer->state.dynamic;
 
-	radeon_set_context_reg_seq(cmd_buffer->cs, R_028414_CB_BLEND_RED, 4);
-	radeon_emit_array(cmd_buffer->cs, (uint32_t *)d->blend_constants, 4);
+	radv_opt_set_context_reg_seq(cmd_buffer, R_028414_CB_BLEND_RED,
+				     RADV_TRACKED_CB_BLEND_RED, 4,
+				     (uint32_t *)d->blend_constants);
 }
 
 static void
 radv_emit_stencil(struct radv_cmd_buffer *cmd_buffer)
 {
 	struct radv_dynamic_state *d = &cmd_buffer->state.dynamic;
+	uint32_t values[2];
 
-	radeon_set_context_reg_seq(cmd_buffer->cs,
-				   R_028430_DB_STENCILREFMASK, 2);
-	radeon_emit(cmd_buffer->cs,
-		    S_028430_STENCILTESTVAL(d->stencil_reference.front) |
+	values[0] = S_028430_STENCILTESTVAL(d->stencil_reference.front) |
 		    S_028430_STENCILMASK(d->stencil_compare_mask.front) |
 		    S_028430_STENCILWRITEMASK(d->stencil_write_mask.front) |
-		    S_028430_STENCILOPVAL(1));
-	radeon_emit(cmd_buffer->cs,
-		    S_028434_STENCILTESTVAL_BF(d->stencil_reference.back) |
+		    S_028430_STENCILOPVAL(1);
+	values[1] = S_028434_STENCILTESTVAL_BF(d->stencil_reference.back) |
 		    S_028434_STENCILMASK_BF(d->stencil_compare_mask.back) |
 		    S_028434_STENCILWRITEMASK_BF(d->stencil_write_mask.back) |
-		    S_028434_STENCILOPVAL_BF(1));
+		    S_028434_STENCILOPVAL_BF(1);
+
+	radv_opt_set_context_reg_seq(cmd_buffer, R_028430_DB_STENCILREFMASK,
+				     RADV_TRACKED_DB_STENCILREFMASK, 2, values);
 }
 
 static void
 radv_emit_depth_bounds(struct radv_cmd_buffer *cmd_buffer)
 {
 	struct radv_dynamic_state *d = &cmd_buffer->state.dynamic;
+	uint32_t values[2] = {
+		fui(d->depth_bounds.min),
+		fui(d->depth_bounds.max),
+	};
 
-	radeon_set_context_reg(cmd_buffer->cs, R_028020_DB_DEPTH_BOUNDS_MIN,
-			       fui(d->depth_bounds.min));
-	radeon_set_context_reg(cmd_buffer->cs, R_028024_DB_DEPTH_BOUNDS_MAX,
-			       fui(d->depth_bounds.max));
+	radv_opt_set_context_reg_seq(cmd_buffer, R_028020_DB_DEPTH_BOUNDS_MIN,
+				     RADV_TRACKED_DB_DEPTH_BOUNDS_MIN, 2, values);
 }
 
 static void
@@ -978,15 +1005,17 @@ radv_emit_depth_bias(struct radv_cmd_buffer *cmd_buffer)
 	struct radv_dynamic_state *d = &cmd_buffer->state.dynamic;
 	unsigned slope = fui(d->depth_bias.slope * 16.0f);
 	unsigned bias = fui(d->depth_bias.bias * cmd_buffer->state.offset_scale);
+	uint32_t values[5] = {
+		fui(d->depth_bias.clamp), /* CLAMP */
+		slope, /* FRONT SCALE */
+		bias, /* FRONT OFFSET */
+		slope, /* BACK SCALE */
+		bias, /* BACK OFFSET */
+	};
 
-
-	radeon_set_context_reg_seq(cmd_buffer->cs,
-				   R_028B7C_PA_SU_POLY_OFFSET_CLAMP, 5);
-	radeon_emit(cmd_buffer->cs, fui(d->depth_bias.clamp)); /* CLAMP */
-	radeon_emit(cmd_buffer->cs, slope); /* FRONT SCALE */
-	radeon_emit(cmd_buffer->cs, bias); /* FRONT OFFSET */
-	radeon_emit(cmd_buffer->cs, slope); /* BACK SCALE */
-	radeon_emit(cmd_buffer->cs, bias); /* BACK OFFSET */
+	radv_opt_set_context_reg_seq(cmd_buffer, R_028B7C_PA_SU_POLY_OFFSET_CLAMP,
+				     RADV_TRACKED_PA_SU_POLY_OFFSET_CLAMP, 5,
+				     values);
 }
 
 static void
@@ -2437,8 +2466,16 @@ radv_bind_descriptor_set(struct radv_cmd_buffer *cmd_buffer,
 			 struct radv_descriptor_set *set, unsigned idx)
 {
 	struct radeon_winsys *ws = cmd_buffer->device->ws;
+	struct radv_descriptor_state *descriptors_state =
+		radv_get_descriptors_state(cmd_buffer, bind_point);
 
-	radv_set_descriptor_set(cmd_buffer, bind_point, set, idx);
+	/* The address of a set never changes, so rebinding the same set
+	 * doesn't need its pointer to be emitted again. Binding a different
+	 * pipeline marks all sets dirty anyway.
+	 */
+	if (!(descriptors_state->valid & (1u << idx)) ||
+	    descriptors_state->sets[idx] != set)
+		radv_set_descriptor_set(cmd_buffer, bind_point, set, idx);
 
 	assert(set);
 	assert(!(set->layout->flags & VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR));
@@ -2754,6 +2791,11 @@ void radv_CmdSetViewport(
 	assert(firstViewport < MAX_VIEWPORTS);
 	assert(total_count >= 1 && total_count <= MAX_VIEWPORTS);
 
+	/* The viewport state doesn't change, so don't re-emit it. */
+	if (!memcmp(state->dynamic.viewport.viewports + firstViewport,
+		    pViewports, viewportCount * sizeof(*pViewports)))
+		return;
+
 	memcpy(state->dynamic.viewport.viewports + firstViewport, pViewports,
 	       viewportCount * sizeof(*pViewports));
 
@@ -2773,6 +2815,10 @@ void radv_CmdSetScissor(
 	assert(firstScissor < MAX_SCISSORS);
 	assert(total_count >= 1 && total_count <= MAX_SCISSORS);
 
+	if (!memcmp(state->dynamic.scissor.scissors + firstScissor,
+		    pScissors, scissorCount * sizeof(*pScissors)))
+		return;
+
 	memcpy(state->dynamic.scissor.scissors + firstScissor, pScissors,
 	       scissorCount * sizeof(*pScissors));
 
@@ -2972,6 +3018,7 @@ void radv_CmdExecuteCommands(
 	primary->state.dirty |= RADV_CMD_DIRTY_PIPELINE |
 				RADV_CMD_DIRTY_INDEX_BUFFER |
 				RADV_CMD_DIRTY_DYNAMIC_ALL;
+	primary->state.tracked_regs.reg_saved = 0;
 	radv_mark_descriptor_sets_dirty(primary, VK_PIPELINE_BIND_POINT_GRAPHICS);
 	radv_mark_descriptor_sets_dirty(primary, VK_PIPELINE_BIND_POINT_COMPUTE);
 }
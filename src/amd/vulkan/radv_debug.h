@@ -50,6 +50,8 @@ enum {
 	RADV_DEBUG_STARTUP           = 0x100000,
 	RADV_DEBUG_CHECKIR           = 0x200000,
 	RADV_DEBUG_NOTHREADLLVM      = 0x400000,
+	RADV_DEBUG_NOCOMPILETHREADS  = 0x800000,
+	RADV_DEBUG_CACHE_STATS       = 0x1000000,
 };
 
 enum {
@@ -59,6 +61,7 @@ enum {
 	RADV_PERFTEST_BINNING     =   0x8,
 	RADV_PERFTEST_OUT_OF_ORDER   =  0x10,
 	RADV_PERFTEST_DCC_MSAA       =  0x20,
+	RADV_PERFTEST_FAST_COMPILE   =  0x40,
 };
 
 bool
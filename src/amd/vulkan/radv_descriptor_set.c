@@ -397,34 +397,103 @@ void radv_DestroyPipelineLayout(
 
 #define EMPTY 1
 
+#define RADV_DESCRIPTOR_POOL_MIN_HOST_SIZE_LOG2 6
+
 static VkResult
-radv_descriptor_set_create(struct radv_device *device,
-			   struct radv_descriptor_pool *pool,
-			   const struct radv_descriptor_set_layout *layout,
-			   const uint32_t *variable_count,
-			   struct radv_descriptor_set **out_set)
+radv_descriptor_pool_alloc_host(struct radv_device *device,
+				struct radv_descriptor_pool *pool,
+				unsigned mem_size,
+				struct radv_descriptor_set **out_set)
 {
 	struct radv_descriptor_set *set;
-	unsigned range_offset = sizeof(struct radv_descriptor_set) +
-		sizeof(struct radeon_winsys_bo *) * layout->buffer_count;
-	unsigned mem_size = range_offset +
-		sizeof(struct radv_descriptor_range) * layout->dynamic_offset_count;
+	unsigned host_class, class_size;
 
-	if (pool->host_memory_base) {
+	if (!pool->allow_free) {
 		if (pool->host_memory_end - pool->host_memory_ptr < mem_size)
 			return vk_error(device->instance, VK_ERROR_OUT_OF_POOL_MEMORY_KHR);
 
 		set = (struct radv_descriptor_set*)pool->host_memory_ptr;
 		pool->host_memory_ptr += mem_size;
+
+		memset(set, 0, mem_size);
+		*out_set = set;
+		return VK_SUCCESS;
+	}
+
+	host_class = util_logbase2_ceil(MAX2(mem_size, 1u << RADV_DESCRIPTOR_POOL_MIN_HOST_SIZE_LOG2)) -
+		     RADV_DESCRIPTOR_POOL_MIN_HOST_SIZE_LOG2;
+	if (host_class >= RADV_DESCRIPTOR_POOL_HOST_CLASSES)
+		return vk_error(device->instance, VK_ERROR_OUT_OF_HOST_MEMORY);
+
+	class_size = 1u << (host_class + RADV_DESCRIPTOR_POOL_MIN_HOST_SIZE_LOG2);
+
+	set = pool->host_free_sets[host_class];
+	if (set) {
+		pool->host_free_sets[host_class] = set->next_free;
+	} else if (pool->host_memory_end - pool->host_memory_ptr >= class_size) {
+		set = (struct radv_descriptor_set*)pool->host_memory_ptr;
+		pool->host_memory_ptr += class_size;
 	} else {
-		set = vk_alloc2(&device->alloc, NULL, mem_size, 8,
-		                VK_SYSTEM_ALLOCATION_SCOPE_OBJECT);
+		struct radv_descriptor_pool_heap_block *block;
 
-		if (!set)
+		block = vk_alloc2(&device->alloc, NULL, sizeof(*block) + class_size, 8,
+		                  VK_SYSTEM_ALLOCATION_SCOPE_OBJECT);
+		if (!block)
 			return vk_error(device->instance, VK_ERROR_OUT_OF_HOST_MEMORY);
+
+		block->next = pool->host_heap_blocks;
+		pool->host_heap_blocks = block;
+		set = (struct radv_descriptor_set*)(block + 1);
 	}
 
 	memset(set, 0, mem_size);
+	set->host_class = host_class;
+	*out_set = set;
+	return VK_SUCCESS;
+}
+
+static void
+radv_descriptor_pool_free_host(struct radv_descriptor_pool *pool,
+			       struct radv_descriptor_set *set)
+{
+	assert(pool->allow_free);
+
+	set->next_free = pool->host_free_sets[set->host_class];
+	pool->host_free_sets[set->host_class] = set;
+}
+
+static void
+radv_descriptor_pool_reset_host(struct radv_device *device,
+				struct radv_descriptor_pool *pool)
+{
+	while (pool->host_heap_blocks) {
+		struct radv_descriptor_pool_heap_block *block = pool->host_heap_blocks;
+
+		pool->host_heap_blocks = block->next;
+		vk_free2(&device->alloc, NULL, block);
+	}
+
+	memset(pool->host_free_sets, 0, sizeof(pool->host_free_sets));
+	pool->host_memory_ptr = pool->host_memory_base;
+}
+
+static VkResult
+radv_descriptor_set_create(struct radv_device *device,
+			   struct radv_descriptor_pool *pool,
+			   const struct radv_descriptor_set_layout *layout,
+			   const uint32_t *variable_count,
+			   struct radv_descriptor_set **out_set)
+{
+	struct radv_descriptor_set *set;
+	unsigned range_offset = sizeof(struct radv_descriptor_set) +
+		sizeof(struct radeon_winsys_bo *) * layout->buffer_count;
+	unsigned mem_size = range_offset +
+		sizeof(struct radv_descriptor_range) * layout->dynamic_offset_count;
+	VkResult result;
+
+	result = radv_descriptor_pool_alloc_host(device, pool, mem_size, &set);
+	if (result != VK_SUCCESS)
+		return result;
 
 	if (layout->dynamic_offset_count) {
 		set->dynamic_descriptors = (struct radv_descriptor_range*)((uint8_t*)set + range_offset);
@@ -435,8 +504,8 @@ radv_descriptor_set_create(struct radv_device *device,
 	if (layout_size) {
 		set->size = layout_size;
 
-		if (!pool->host_memory_base && pool->entry_count == pool->max_entry_count) {
-			vk_free2(&device->alloc, NULL, set);
+		if (pool->allow_free && pool->entry_count == pool->max_entry_count) {
+			radv_descriptor_pool_free_host(pool, set);
 			return vk_error(device->instance, VK_ERROR_OUT_OF_POOL_MEMORY_KHR);
 		}
 
@@ -447,14 +516,14 @@ radv_descriptor_set_create(struct radv_device *device,
 			set->bo = pool->bo;
 			set->mapped_ptr = (uint32_t*)(pool->mapped_ptr + pool->current_offset);
 			set->va = radv_buffer_get_va(set->bo) + pool->current_offset;
-			if (!pool->host_memory_base) {
+			if (pool->allow_free) {
 				pool->entries[pool->entry_count].offset = pool->current_offset;
 				pool->entries[pool->entry_count].size = layout_size;
 				pool->entries[pool->entry_count].set = set;
 				pool->entry_count++;
 			}
 			pool->current_offset += layout_size;
-		} else if (!pool->host_memory_base) {
+		} else if (pool->allow_free) {
 			uint64_t offset = 0;
 			int index;
 
@@ -465,7 +534,7 @@ radv_descriptor_set_create(struct radv_device *device,
 			}
 
 			if (pool->size - offset < layout_size) {
-				vk_free2(&device->alloc, NULL, set);
+				radv_descriptor_pool_free_host(pool, set);
 				return vk_error(device->instance, VK_ERROR_OUT_OF_POOL_MEMORY_KHR);
 			}
 			set->bo = pool->bo;
@@ -477,6 +546,11 @@ radv_descriptor_set_create(struct radv_device *device,
 			pool->entries[index].size = layout_size;
 			pool->entries[index].set = set;
 			pool->entry_count++;
+
+			/* Keep the linear allocations above every entry, so
+			 * that they neither overlap nor break the ordering. */
+			pool->current_offset = MAX2(pool->current_offset,
+			                            offset + layout_size);
 		} else
 			return vk_error(device->instance, VK_ERROR_OUT_OF_POOL_MEMORY_KHR);
 	}
@@ -504,25 +578,33 @@ radv_descriptor_set_create(struct radv_device *device,
 }
 
 static void
-radv_descriptor_set_destroy(struct radv_device *device,
-			    struct radv_descriptor_pool *pool,
-			    struct radv_descriptor_set *set,
-			    bool free_bo)
+radv_descriptor_set_destroy(struct radv_descriptor_pool *pool,
+			    struct radv_descriptor_set *set)
 {
-	assert(!pool->host_memory_base);
+	assert(pool->allow_free);
 
-	if (free_bo && set->size && !pool->host_memory_base) {
+	if (set->size) {
 		uint32_t offset = (uint8_t*)set->mapped_ptr - pool->mapped_ptr;
-		for (int i = 0; i < pool->entry_count; ++i) {
-			if (pool->entries[i].offset == offset) {
-				memmove(&pool->entries[i], &pool->entries[i+1],
-					sizeof(pool->entries[i]) * (pool->entry_count - i - 1));
-				--pool->entry_count;
-				break;
-			}
+		unsigned lo = 0, hi = pool->entry_count;
+
+		/* The entries are sorted by offset. */
+		while (lo < hi) {
+			unsigned mid = (lo + hi) / 2;
+
+			if (pool->entries[mid].offset < offset)
+				lo = mid + 1;
+			else
+				hi = mid;
+		}
+
+		if (lo < pool->entry_count && pool->entries[lo].offset == offset) {
+			memmove(&pool->entries[lo], &pool->entries[lo + 1],
+				sizeof(pool->entries[lo]) * (pool->entry_count - lo - 1));
+			--pool->entry_count;
 		}
 	}
-	vk_free2(&device->alloc, NULL, set);
+
+	radv_descriptor_pool_free_host(pool, set);
 }
 
 VkResult radv_CreateDescriptorPool(
@@ -533,8 +615,9 @@ VkResult radv_CreateDescriptorPool(
 {
 	RADV_FROM_HANDLE(radv_device, device, _device);
 	struct radv_descriptor_pool *pool;
-	int size = sizeof(struct radv_descriptor_pool);
+	uint64_t size = sizeof(struct radv_descriptor_pool);
 	uint64_t bo_size = 0, bo_count = 0, range_count = 0;
+	uint64_t host_size;
 
 
 	for (unsigned i = 0; i < pCreateInfo->poolSizeCount; ++i) {
@@ -568,14 +651,17 @@ VkResult radv_CreateDescriptorPool(
 		}
 	}
 
-	if (!(pCreateInfo->flags & VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT)) {
-		uint64_t host_size = pCreateInfo->maxSets * sizeof(struct radv_descriptor_set);
-		host_size += sizeof(struct radeon_winsys_bo*) * bo_count;
-		host_size += sizeof(struct radv_descriptor_range) * range_count;
-		size += host_size;
-	} else {
+	host_size = pCreateInfo->maxSets * sizeof(struct radv_descriptor_set);
+	host_size += sizeof(struct radeon_winsys_bo*) * bo_count;
+	host_size += sizeof(struct radv_descriptor_range) * range_count;
+
+	if (pCreateInfo->flags & VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT) {
 		size += sizeof(struct radv_descriptor_pool_entry) * pCreateInfo->maxSets;
+		/* Sets are rounded up to their size class, which at most
+		 * doubles them. Anything beyond goes to heap blocks. */
+		host_size *= 2;
 	}
+	size += host_size;
 
 	pool = vk_alloc2(&device->alloc, pAllocator, size, 8,
 	                 VK_SYSTEM_ALLOCATION_SCOPE_OBJECT);
@@ -584,11 +670,10 @@ VkResult radv_CreateDescriptorPool(
 
 	memset(pool, 0, sizeof(*pool));
 
-	if (!(pCreateInfo->flags & VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT)) {
-		pool->host_memory_base = (uint8_t*)pool + sizeof(struct radv_descriptor_pool);
-		pool->host_memory_ptr = pool->host_memory_base;
-		pool->host_memory_end = (uint8_t*)pool + size;
-	}
+	pool->allow_free = pCreateInfo->flags & VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
+	pool->host_memory_end = (uint8_t*)pool + size;
+	pool->host_memory_base = pool->host_memory_end - host_size;
+	pool->host_memory_ptr = pool->host_memory_base;
 
 	if (bo_size) {
 		pool->bo = device->ws->buffer_create(device->ws, bo_size, 32,
@@ -616,11 +701,7 @@ void radv_DestroyDescriptorPool(
 	if (!pool)
 		return;
 
-	if (!pool->host_memory_base) {
-		for(int i = 0; i < pool->entry_count; ++i) {
-			radv_descriptor_set_destroy(device, pool, pool->entries[i].set, false);
-		}
-	}
+	radv_descriptor_pool_reset_host(device, pool);
 
 	if (pool->bo)
 		device->ws->buffer_destroy(pool->bo);
@@ -635,15 +716,12 @@ VkResult radv_ResetDescriptorPool(
 	RADV_FROM_HANDLE(radv_device, device, _device);
 	RADV_FROM_HANDLE(radv_descriptor_pool, pool, descriptorPool);
 
-	if (!pool->host_memory_base) {
-		for(int i = 0; i < pool->entry_count; ++i) {
-			radv_descriptor_set_destroy(device, pool, pool->entries[i].set, false);
-		}
-		pool->entry_count = 0;
-	}
+	/* Every set lives in the pool's host memory or in one of its heap
+	 * blocks, so there is nothing to free per set. */
+	radv_descriptor_pool_reset_host(device, pool);
 
+	pool->entry_count = 0;
 	pool->current_offset = 0;
-	pool->host_memory_ptr = pool->host_memory_base;
 
 	return VK_SUCCESS;
 }
@@ -698,14 +776,13 @@ VkResult radv_FreeDescriptorSets(
 	uint32_t                                    count,
 	const VkDescriptorSet*                      pDescriptorSets)
 {
-	RADV_FROM_HANDLE(radv_device, device, _device);
 	RADV_FROM_HANDLE(radv_descriptor_pool, pool, descriptorPool);
 
 	for (uint32_t i = 0; i < count; i++) {
 		RADV_FROM_HANDLE(radv_descriptor_set, set, pDescriptorSets[i]);
 
-		if (set && !pool->host_memory_base)
-			radv_descriptor_set_destroy(device, pool, set, true);
+		if (set && pool->allow_free)
+			radv_descriptor_set_destroy(pool, set);
 	}
 	return VK_SUCCESS;
 }
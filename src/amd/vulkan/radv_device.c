@@ -466,6 +466,8 @@ static const struct debug_control radv_debug_options[] = {
 	{"startup", RADV_DEBUG_STARTUP},
 	{"checkir", RADV_DEBUG_CHECKIR},
 	{"nothreadllvm", RADV_DEBUG_NOTHREADLLVM},
+	{"nocompilethreads", RADV_DEBUG_NOCOMPILETHREADS},
+	{"cachestats", RADV_DEBUG_CACHE_STATS},
 	{NULL, 0}
 };
 
@@ -482,6 +484,7 @@ static const struct debug_control radv_perftest_options[] = {
 	{"localbos", RADV_PERFTEST_LOCAL_BOS},
 	{"binning", RADV_PERFTEST_BINNING},
 	{"dccmsaa", RADV_PERFTEST_DCC_MSAA},
+	{"fastcompile", RADV_PERFTEST_FAST_COMPILE},
 	{NULL, 0}
 };
 
@@ -1518,8 +1521,18 @@ VkResult radv_CreateDevice(
 	device->use_global_bo_list =
 		device->enabled_extensions.EXT_descriptor_indexing;
 
-	mtx_init(&device->shader_slab_mutex, mtx_plain);
-	list_inithead(&device->shader_slabs);
+	radv_init_shader_slabs(device);
+
+	/* The thread creating the pipelines compiles as well, so one core is
+	 * left for it. Without the queue everything is compiled serially.
+	 */
+	int hw_threads = sysconf(_SC_NPROCESSORS_ONLN);
+	if (hw_threads > 1 &&
+	    !(device->instance->debug_flags & RADV_DEBUG_NOCOMPILETHREADS)) {
+		util_queue_init(&device->compile_queue, "radv_sh", 64,
+				MIN2(hw_threads - 1, 16),
+				UTIL_QUEUE_INIT_RESIZE_IF_FULL);
+	}
 
 	radv_bo_list_init(&device->bo_list);
 
@@ -1659,6 +1672,9 @@ VkResult radv_CreateDevice(
 fail_meta:
 	radv_device_finish_meta(device);
 fail:
+	if (util_queue_is_initialized(&device->compile_queue))
+		util_queue_destroy(&device->compile_queue);
+
 	radv_bo_list_finish(&device->bo_list);
 
 	if (device->trace_bo)
@@ -1703,6 +1719,9 @@ void radv_DestroyDevice(
 	}
 	radv_device_finish_meta(device);
 
+	if (util_queue_is_initialized(&device->compile_queue))
+		util_queue_destroy(&device->compile_queue);
+
 	VkPipelineCache pc = radv_pipeline_cache_to_handle(device->mem_cache);
 	radv_DestroyPipelineCache(radv_device_to_handle(device), pc, NULL);
 
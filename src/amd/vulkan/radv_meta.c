@@ -28,8 +28,11 @@
 #include <fcntl.h>
 #include <limits.h>
 #include <pwd.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 
+#include "util/u_atomic.h"
+
 void
 radv_meta_save(struct radv_meta_saved_state *state,
 	       struct radv_cmd_buffer *cmd_buffer, uint32_t flags)
@@ -262,7 +265,7 @@ radv_load_meta_pipeline(struct radv_device *device)
 {
 	char path[PATH_MAX + 1];
 	struct stat st;
-	void *data = NULL;
+	void *data;
 
 	if (!radv_builtin_cache_path(path))
 		return;
@@ -270,17 +273,19 @@ radv_load_meta_pipeline(struct radv_device *device)
 	int fd = open(path, O_RDONLY);
 	if (fd < 0)
 		return;
-	if (fstat(fd, &st))
+	if (fstat(fd, &st) || !st.st_size)
 		goto fail;
-	data = malloc(st.st_size);
-	if (!data)
-		goto fail;
-	if(read(fd, data, st.st_size) == -1)
+
+	/* The cache copies what it needs, so the file doesn't have to be read
+	 * into a buffer first.
+	 */
+	data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (data == MAP_FAILED)
 		goto fail;
 
 	radv_pipeline_cache_load(&device->meta_state.cache, data, st.st_size);
+	munmap(data, st.st_size);
 fail:
-	free(data);
 	close(fd);
 }
 
@@ -325,6 +330,75 @@ fail:
 	unlink(path2);
 }
 
+static const struct {
+	VkResult (*init)(struct radv_device *device);
+	void (*finish)(struct radv_device *device);
+} radv_meta_families[RADV_META_NUM_FAMILIES] = {
+	[RADV_META_FAMILY_RESOLVE] = {
+		radv_device_init_meta_resolve_state,
+		radv_device_finish_meta_resolve_state,
+	},
+	[RADV_META_FAMILY_BLIT] = {
+		radv_device_init_meta_blit_state,
+		radv_device_finish_meta_blit_state,
+	},
+	[RADV_META_FAMILY_BLIT2D] = {
+		radv_device_init_meta_blit2d_state,
+		radv_device_finish_meta_blit2d_state,
+	},
+	[RADV_META_FAMILY_DEPTH_DECOMP] = {
+		radv_device_init_meta_depth_decomp_state,
+		radv_device_finish_meta_depth_decomp_state,
+	},
+	[RADV_META_FAMILY_QUERY] = {
+		radv_device_init_meta_query_state,
+		radv_device_finish_meta_query_state,
+	},
+	[RADV_META_FAMILY_FAST_CLEAR_FLUSH] = {
+		radv_device_init_meta_fast_clear_flush_state,
+		radv_device_finish_meta_fast_clear_flush_state,
+	},
+	[RADV_META_FAMILY_RESOLVE_COMPUTE] = {
+		radv_device_init_meta_resolve_compute_state,
+		radv_device_finish_meta_resolve_compute_state,
+	},
+	[RADV_META_FAMILY_RESOLVE_FRAGMENT] = {
+		radv_device_init_meta_resolve_fragment_state,
+		radv_device_finish_meta_resolve_fragment_state,
+	},
+};
+
+/**
+ * Create the objects of a meta family if this is the first time it's used.
+ * Returns false and records the error in the command buffer on failure.
+ */
+bool
+radv_meta_init_family(struct radv_cmd_buffer *cmd_buffer,
+		      enum radv_meta_family family)
+{
+	struct radv_device *device = cmd_buffer->device;
+	struct radv_meta_state *state = &device->meta_state;
+	VkResult result = VK_SUCCESS;
+
+	if (p_atomic_read(&state->families) & (1u << family))
+		return true;
+
+	mtx_lock(&state->mtx);
+	if (!(state->families & (1u << family))) {
+		result = radv_meta_families[family].init(device);
+		if (result == VK_SUCCESS)
+			p_atomic_set(&state->families,
+				     state->families | (1u << family));
+	}
+	mtx_unlock(&state->mtx);
+
+	if (result != VK_SUCCESS) {
+		cmd_buffer->record_result = result;
+		return false;
+	}
+	return true;
+}
+
 VkResult
 radv_device_init_meta(struct radv_device *device)
 {
@@ -341,72 +415,32 @@ radv_device_init_meta(struct radv_device *device)
 	radv_pipeline_cache_init(&device->meta_state.cache, device);
 	radv_load_meta_pipeline(device);
 
+	mtx_init(&device->meta_state.mtx, mtx_plain);
+	device->meta_state.families = 0;
+
 	result = radv_device_init_meta_clear_state(device);
 	if (result != VK_SUCCESS)
 		goto fail_clear;
 
-	result = radv_device_init_meta_resolve_state(device);
-	if (result != VK_SUCCESS)
-		goto fail_resolve;
-
-	result = radv_device_init_meta_blit_state(device);
-	if (result != VK_SUCCESS)
-		goto fail_blit;
-
-	result = radv_device_init_meta_blit2d_state(device);
-	if (result != VK_SUCCESS)
-		goto fail_blit2d;
-
 	result = radv_device_init_meta_bufimage_state(device);
 	if (result != VK_SUCCESS)
 		goto fail_bufimage;
 
-	result = radv_device_init_meta_depth_decomp_state(device);
-	if (result != VK_SUCCESS)
-		goto fail_depth_decomp;
-
 	result = radv_device_init_meta_buffer_state(device);
 	if (result != VK_SUCCESS)
 		goto fail_buffer;
 
-	result = radv_device_init_meta_query_state(device);
-	if (result != VK_SUCCESS)
-		goto fail_query;
-
-	result = radv_device_init_meta_fast_clear_flush_state(device);
-	if (result != VK_SUCCESS)
-		goto fail_fast_clear;
-
-	result = radv_device_init_meta_resolve_compute_state(device);
-	if (result != VK_SUCCESS)
-		goto fail_resolve_compute;
-
-	result = radv_device_init_meta_resolve_fragment_state(device);
-	if (result != VK_SUCCESS)
-		goto fail_resolve_fragment;
+	/* The other families are created on first use, see
+	 * radv_meta_init_family().
+	 */
 	return VK_SUCCESS;
 
-fail_resolve_fragment:
-	radv_device_finish_meta_resolve_compute_state(device);
-fail_resolve_compute:
-	radv_device_finish_meta_fast_clear_flush_state(device);
-fail_fast_clear:
-	radv_device_finish_meta_query_state(device);
-fail_query:
-	radv_device_finish_meta_buffer_state(device);
 fail_buffer:
-	radv_device_finish_meta_depth_decomp_state(device);
-fail_depth_decomp:
 	radv_device_finish_meta_bufimage_state(device);
 fail_bufimage:
-	radv_device_finish_meta_blit2d_state(device);
-fail_blit2d:
-	radv_device_finish_meta_blit_state(device);
-fail_blit:
-	radv_device_finish_meta_resolve_state(device);
-fail_resolve:
 	radv_device_finish_meta_clear_state(device);
 fail_clear:
+	mtx_destroy(&device->meta_state.mtx);
 	radv_pipeline_cache_finish(&device->meta_state.cache);
 	return result;
 }
@@ -415,19 +449,17 @@ void
 radv_device_finish_meta(struct radv_device *device)
 {
 	radv_device_finish_meta_clear_state(device);
-	radv_device_finish_meta_resolve_state(device);
-	radv_device_finish_meta_blit_state(device);
-	radv_device_finish_meta_blit2d_state(device);
 	radv_device_finish_meta_bufimage_state(device);
-	radv_device_finish_meta_depth_decomp_state(device);
-	radv_device_finish_meta_query_state(device);
 	radv_device_finish_meta_buffer_state(device);
-	radv_device_finish_meta_fast_clear_flush_state(device);
-	radv_device_finish_meta_resolve_compute_state(device);
-	radv_device_finish_meta_resolve_fragment_state(device);
+
+	for (unsigned i = 0; i < RADV_META_NUM_FAMILIES; i++) {
+		if (device->meta_state.families & (1u << i))
+			radv_meta_families[i].finish(device);
+	}
 
 	radv_store_meta_pipeline(device);
 	radv_pipeline_cache_finish(&device->meta_state.cache);
+	mtx_destroy(&device->meta_state.mtx);
 }
 
 nir_ssa_def *radv_meta_gen_rect_vertices_comp2(nir_builder *vs_b, nir_ssa_def *comp2)
@@ -58,6 +58,22 @@ struct radv_meta_saved_state {
 	VkRect2D render_area;
 };
 
+/* Groups of meta objects that are created the first time they are used. */
+enum radv_meta_family {
+	RADV_META_FAMILY_RESOLVE,
+	RADV_META_FAMILY_BLIT,
+	RADV_META_FAMILY_BLIT2D,
+	RADV_META_FAMILY_DEPTH_DECOMP,
+	RADV_META_FAMILY_QUERY,
+	RADV_META_FAMILY_FAST_CLEAR_FLUSH,
+	RADV_META_FAMILY_RESOLVE_COMPUTE,
+	RADV_META_FAMILY_RESOLVE_FRAGMENT,
+	RADV_META_NUM_FAMILIES,
+};
+
+bool radv_meta_init_family(struct radv_cmd_buffer *cmd_buffer,
+			   enum radv_meta_family family);
+
 VkResult radv_device_init_meta_clear_state(struct radv_device *device);
 void radv_device_finish_meta_clear_state(struct radv_device *device);
 
@@ -522,6 +522,9 @@ void radv_CmdBlitImage(
 	struct radv_meta_saved_state saved_state;
 	bool old_predicating;
 
+	if (!radv_meta_init_family(cmd_buffer, RADV_META_FAMILY_BLIT))
+		return;
+
 	/* From the Vulkan 1.0 spec:
 	 *
 	 *    vkCmdBlitImage must not be used for multisampled source or
@@ -379,6 +379,10 @@ radv_meta_blit2d(struct radv_cmd_buffer *cmd_buffer,
 		(src_img && src_img->image->type == VK_IMAGE_TYPE_3D);
 	enum blit2d_src_type src_type = src_buf ? BLIT2D_SRC_TYPE_BUFFER :
 		use_3d ? BLIT2D_SRC_TYPE_IMAGE_3D : BLIT2D_SRC_TYPE_IMAGE;
+
+	if (!radv_meta_init_family(cmd_buffer, RADV_META_FAMILY_BLIT2D))
+		return;
+
 	radv_meta_blit2d_normal_dst(cmd_buffer, src_img, src_buf, dst,
 				    num_rects, rects, src_type,
 				    src_img ? util_logbase2(src_img->image->info.samples) : 0);
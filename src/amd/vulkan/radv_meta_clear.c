@@ -325,6 +325,68 @@ radv_device_finish_meta_clear_state(struct radv_device *device)
 				   &state->alloc);
 }
 
+static VkFormat pipeline_formats[] = {
+	VK_FORMAT_R8G8B8A8_UNORM,
+	VK_FORMAT_R8G8B8A8_UINT,
+	VK_FORMAT_R8G8B8A8_SINT,
+	VK_FORMAT_A2R10G10B10_UINT_PACK32,
+	VK_FORMAT_A2R10G10B10_SINT_PACK32,
+	VK_FORMAT_R16G16B16A16_UNORM,
+	VK_FORMAT_R16G16B16A16_SNORM,
+	VK_FORMAT_R16G16B16A16_UINT,
+	VK_FORMAT_R16G16B16A16_SINT,
+	VK_FORMAT_R32_SFLOAT,
+	VK_FORMAT_R32G32_SFLOAT,
+	VK_FORMAT_R32G32B32A32_SFLOAT
+};
+
+/* The clear pipelines are created the first time a clear needs them, as
+ * most applications only ever use a handful of the format/sample count
+ * combinations.
+ */
+static VkResult
+get_color_pipeline(struct radv_device *device,
+		   uint32_t samples_log2,
+		   unsigned fs_key,
+		   VkPipeline *pipeline_out)
+{
+	struct radv_meta_state *state = &device->meta_state;
+	uint32_t samples = 1 << samples_log2;
+	VkResult result = VK_SUCCESS;
+
+	mtx_lock(&state->mtx);
+	if (state->clear[samples_log2].color_pipelines[fs_key])
+		goto out;
+
+	if (!state->clear[samples_log2].render_pass[fs_key]) {
+		VkFormat format = VK_FORMAT_UNDEFINED;
+
+		/* Use the same format as the eager path did, so that the
+		 * pipeline matches the one in the meta cache.
+		 */
+		for (uint32_t j = 0; j < ARRAY_SIZE(pipeline_formats); ++j) {
+			if (radv_format_meta_fs_key(pipeline_formats[j]) == fs_key) {
+				format = pipeline_formats[j];
+				break;
+			}
+		}
+		assert(format != VK_FORMAT_UNDEFINED);
+
+		result = create_color_renderpass(device, format, samples,
+						 &state->clear[samples_log2].render_pass[fs_key]);
+		if (result != VK_SUCCESS)
+			goto out;
+	}
+
+	result = create_color_pipeline(device, samples, 0,
+				       &state->clear[samples_log2].color_pipelines[fs_key],
+				       state->clear[samples_log2].render_pass[fs_key]);
+out:
+	*pipeline_out = state->clear[samples_log2].color_pipelines[fs_key];
+	mtx_unlock(&state->mtx);
+	return result;
+}
+
 static void
 emit_color_clear(struct radv_cmd_buffer *cmd_buffer,
                  const VkClearAttachment *clear_att,
@@ -351,8 +413,12 @@ emit_color_clear(struct radv_cmd_buffer *cmd_buffer,
 
 	pipeline = device->meta_state.clear[samples_log2].color_pipelines[fs_key];
 	if (!pipeline) {
-		radv_finishme("color clears incomplete");
-		return;
+		VkResult ret = get_color_pipeline(device, samples_log2, fs_key,
+						  &pipeline);
+		if (ret != VK_SUCCESS) {
+			cmd_buffer->record_result = ret;
+			return;
+		}
 	}
 	assert(samples_log2 < ARRAY_SIZE(device->meta_state.clear));
 	assert(pipeline);
@@ -579,6 +645,8 @@ pick_depthstencil_pipeline(struct radv_cmd_buffer *cmd_buffer,
 {
 	bool fast = depth_view_can_fast_clear(cmd_buffer, iview, aspects, layout, clear_rect, clear_value);
 	int index = DEPTH_CLEAR_SLOW;
+	VkPipeline *pipeline;
+	VkResult result = VK_SUCCESS;
 
 	if (fast) {
 		/* we don't know the previous clear values, so we always have
@@ -588,13 +656,44 @@ pick_depthstencil_pipeline(struct radv_cmd_buffer *cmd_buffer,
 
 	switch (aspects) {
 	case VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT:
-		return meta_state->clear[samples_log2].depthstencil_pipeline[index];
+		pipeline = &meta_state->clear[samples_log2].depthstencil_pipeline[index];
+		break;
 	case VK_IMAGE_ASPECT_DEPTH_BIT:
-		return meta_state->clear[samples_log2].depth_only_pipeline[index];
+		pipeline = &meta_state->clear[samples_log2].depth_only_pipeline[index];
+		break;
 	case VK_IMAGE_ASPECT_STENCIL_BIT:
-		return meta_state->clear[samples_log2].stencil_only_pipeline[index];
+		pipeline = &meta_state->clear[samples_log2].stencil_only_pipeline[index];
+		break;
+	default:
+		unreachable("expected depth or stencil aspect");
+	}
+
+	if (*pipeline)
+		return *pipeline;
+
+	mtx_lock(&meta_state->mtx);
+	if (!meta_state->clear[samples_log2].depthstencil_rp) {
+		result = create_depthstencil_renderpass(cmd_buffer->device,
+							1u << samples_log2,
+							&meta_state->clear[samples_log2].depthstencil_rp);
+		if (result != VK_SUCCESS)
+			goto out;
+	}
+
+	if (!*pipeline) {
+		result = create_depthstencil_pipeline(cmd_buffer->device, aspects,
+						      1u << samples_log2, index,
+						      pipeline,
+						      meta_state->clear[samples_log2].depthstencil_rp);
+	}
+out:
+	mtx_unlock(&meta_state->mtx);
+
+	if (result != VK_SUCCESS) {
+		cmd_buffer->record_result = result;
+		return VK_NULL_HANDLE;
 	}
-	unreachable("expected depth or stencil aspect");
+	return *pipeline;
 }
 
 static void
@@ -619,6 +718,17 @@ emit_depthstencil_clear(struct radv_cmd_buffer *cmd_buffer,
 	if (!(aspects & VK_IMAGE_ASPECT_DEPTH_BIT))
 		clear_value.depth = 1.0f;
 
+	VkPipeline pipeline = pick_depthstencil_pipeline(cmd_buffer,
+							 meta_state,
+							 iview,
+							 samples_log2,
+							 aspects,
+							 subpass->depth_stencil_attachment.layout,
+							 clear_rect,
+							 clear_value);
+	if (!pipeline)
+		return;
+
 	radv_CmdPushConstants(radv_cmd_buffer_to_handle(cmd_buffer),
 			      device->meta_state.clear_depth_p_layout,
 			      VK_SHADER_STAGE_VERTEX_BIT, 0, 4,
@@ -630,15 +740,6 @@ emit_depthstencil_clear(struct radv_cmd_buffer *cmd_buffer,
 						  clear_value.stencil);
 	}
 
-	VkPipeline pipeline = pick_depthstencil_pipeline(cmd_buffer,
-							 meta_state,
-							 iview,
-							 samples_log2,
-							 aspects,
-							 subpass->depth_stencil_attachment.layout,
-							 clear_rect,
-							 clear_value);
-
 	radv_CmdBindPipeline(cmd_buffer_h, VK_PIPELINE_BIND_POINT_GRAPHICS,
 			     pipeline);
 
@@ -757,26 +858,10 @@ fail:
 	return false;
 }
 
-static VkFormat pipeline_formats[] = {
-	VK_FORMAT_R8G8B8A8_UNORM,
-	VK_FORMAT_R8G8B8A8_UINT,
-	VK_FORMAT_R8G8B8A8_SINT,
-	VK_FORMAT_A2R10G10B10_UINT_PACK32,
-	VK_FORMAT_A2R10G10B10_SINT_PACK32,
-	VK_FORMAT_R16G16B16A16_UNORM,
-	VK_FORMAT_R16G16B16A16_SNORM,
-	VK_FORMAT_R16G16B16A16_UINT,
-	VK_FORMAT_R16G16B16A16_SINT,
-	VK_FORMAT_R32_SFLOAT,
-	VK_FORMAT_R32G32_SFLOAT,
-	VK_FORMAT_R32G32B32A32_SFLOAT
-};
-
 VkResult
 radv_device_init_meta_clear_state(struct radv_device *device)
 {
 	VkResult res;
-	struct radv_meta_state *state = &device->meta_state;
 
 	VkPipelineLayoutCreateInfo pl_color_create_info = {
 		.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
@@ -806,61 +891,7 @@ radv_device_init_meta_clear_state(struct radv_device *device)
 	if (res != VK_SUCCESS)
 		goto fail;
 
-	for (uint32_t i = 0; i < ARRAY_SIZE(state->clear); ++i) {
-		uint32_t samples = 1 << i;
-		for (uint32_t j = 0; j < ARRAY_SIZE(pipeline_formats); ++j) {
-			VkFormat format = pipeline_formats[j];
-			unsigned fs_key = radv_format_meta_fs_key(format);
-			assert(!state->clear[i].color_pipelines[fs_key]);
-
-			res = create_color_renderpass(device, format, samples,
-						      &state->clear[i].render_pass[fs_key]);
-			if (res != VK_SUCCESS)
-				goto fail;
-
-			res = create_color_pipeline(device, samples, 0, &state->clear[i].color_pipelines[fs_key],
-						    state->clear[i].render_pass[fs_key]);
-			if (res != VK_SUCCESS)
-				goto fail;
-
-		}
-
-		res = create_depthstencil_renderpass(device,
-						     samples,
-						     &state->clear[i].depthstencil_rp);
-		if (res != VK_SUCCESS)
-			goto fail;
-
-		for (uint32_t j = 0; j < NUM_DEPTH_CLEAR_PIPELINES; j++) {
-			res = create_depthstencil_pipeline(device,
-							   VK_IMAGE_ASPECT_DEPTH_BIT,
-							   samples,
-							   j,
-							   &state->clear[i].depth_only_pipeline[j],
-							   state->clear[i].depthstencil_rp);
-			if (res != VK_SUCCESS)
-				goto fail;
-
-			res = create_depthstencil_pipeline(device,
-							   VK_IMAGE_ASPECT_STENCIL_BIT,
-							   samples,
-							   j,
-							   &state->clear[i].stencil_only_pipeline[j],
-							   state->clear[i].depthstencil_rp);
-			if (res != VK_SUCCESS)
-				goto fail;
-
-			res = create_depthstencil_pipeline(device,
-							   VK_IMAGE_ASPECT_DEPTH_BIT |
-							   VK_IMAGE_ASPECT_STENCIL_BIT,
-							   samples,
-							   j,
-							   &state->clear[i].depthstencil_pipeline[j],
-							   state->clear[i].depthstencil_rp);
-			if (res != VK_SUCCESS)
-				goto fail;
-		}
-	}
+	/* The render passes and pipelines are created on demand. */
 	return VK_SUCCESS;
 
 fail:
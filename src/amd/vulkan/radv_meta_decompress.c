@@ -343,6 +343,9 @@ static void radv_process_depth_image_inplace(struct radv_cmd_buffer *cmd_buffer,
 	if (!radv_image_has_htile(image))
 		return;
 
+	if (!radv_meta_init_family(cmd_buffer, RADV_META_FAMILY_DEPTH_DECOMP))
+		return;
+
 	radv_meta_save(&saved_state, cmd_buffer,
 		       RADV_META_SAVE_GRAPHICS_PIPELINE |
 		       RADV_META_SAVE_PASS);
@@ -591,6 +591,9 @@ radv_emit_color_decompress(struct radv_cmd_buffer *cmd_buffer,
 
 	assert(cmd_buffer->queue_family_index == RADV_QUEUE_GENERAL);
 
+	if (!radv_meta_init_family(cmd_buffer, RADV_META_FAMILY_FAST_CLEAR_FLUSH))
+		return;
+
 	radv_meta_save(&saved_state, cmd_buffer,
 		       RADV_META_SAVE_GRAPHICS_PIPELINE |
 		       RADV_META_SAVE_PASS);
@@ -719,6 +722,9 @@ radv_decompress_dcc_compute(struct radv_cmd_buffer *cmd_buffer,
 	/* This assumes the image is 2d with 1 layer and 1 mipmap level */
 	struct radv_cmd_state *state = &cmd_buffer->state;
 
+	if (!radv_meta_init_family(cmd_buffer, RADV_META_FAMILY_FAST_CLEAR_FLUSH))
+		return;
+
 	state->flush_bits |= RADV_CMD_FLAG_FLUSH_AND_INV_CB |
 			     RADV_CMD_FLAG_FLUSH_AND_INV_CB_META;
 
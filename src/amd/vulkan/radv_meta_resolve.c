@@ -427,6 +427,9 @@ void radv_CmdResolveImage(
 		return;
 	}
 
+	if (!radv_meta_init_family(cmd_buffer, RADV_META_FAMILY_RESOLVE))
+		return;
+
 	radv_meta_save(&saved_state, cmd_buffer,
 		       RADV_META_SAVE_GRAPHICS_PIPELINE);
 
@@ -638,6 +641,9 @@ radv_cmd_buffer_resolve_subpass(struct radv_cmd_buffer *cmd_buffer)
 		return;
 	}
 
+	if (!radv_meta_init_family(cmd_buffer, RADV_META_FAMILY_RESOLVE))
+		return;
+
 	radv_meta_save(&saved_state, cmd_buffer,
 		       RADV_META_SAVE_GRAPHICS_PIPELINE);
 
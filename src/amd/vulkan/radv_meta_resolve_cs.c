@@ -388,6 +388,9 @@ void radv_meta_resolve_compute_image(struct radv_cmd_buffer *cmd_buffer,
 {
 	struct radv_meta_saved_state saved_state;
 
+	if (!radv_meta_init_family(cmd_buffer, RADV_META_FAMILY_RESOLVE_COMPUTE))
+		return;
+
 	radv_decompress_resolve_src(cmd_buffer, src_image, src_image_layout,
 				    region_count, regions);
 
@@ -475,6 +478,9 @@ radv_cmd_buffer_resolve_subpass_cs(struct radv_cmd_buffer *cmd_buffer)
 	struct radv_meta_saved_state saved_state;
 	struct radv_subpass_barrier barrier;
 
+	if (!radv_meta_init_family(cmd_buffer, RADV_META_FAMILY_RESOLVE_COMPUTE))
+		return;
+
 	/* Resolves happen before the end-of-subpass barriers get executed, so
 	 * we have to make the attachment shader-readable.
 	 */
@@ -458,6 +458,9 @@ void radv_meta_resolve_fragment_image(struct radv_cmd_buffer *cmd_buffer,
 	unsigned dst_layout = radv_meta_dst_layout_from_layout(dest_image_layout);
 	VkRenderPass rp;
 
+	if (!radv_meta_init_family(cmd_buffer, RADV_META_FAMILY_RESOLVE_FRAGMENT))
+		return;
+
 	radv_decompress_resolve_src(cmd_buffer, src_image, src_image_layout,
 				    region_count, regions);
 
@@ -582,6 +585,9 @@ radv_cmd_buffer_resolve_subpass_fs(struct radv_cmd_buffer *cmd_buffer)
 	struct radv_meta_saved_state saved_state;
 	struct radv_subpass_barrier barrier;
 
+	if (!radv_meta_init_family(cmd_buffer, RADV_META_FAMILY_RESOLVE_FRAGMENT))
+		return;
+
 	/* Resolves happen before the end-of-subpass barriers get executed,
 	 * so we have to make the attachment shader-readable */
 	barrier.src_stage_mask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
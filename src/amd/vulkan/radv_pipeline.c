@@ -136,6 +136,8 @@ static uint32_t get_hash_flags(struct radv_device *device)
 		hash_flags |= RADV_HASH_SHADER_UNSAFE_MATH;
 	if (device->instance->perftest_flags & RADV_PERFTEST_SISCHED)
 		hash_flags |= RADV_HASH_SHADER_SISCHED;
+	if (device->instance->perftest_flags & RADV_PERFTEST_FAST_COMPILE)
+		hash_flags |= RADV_HASH_SHADER_FAST_COMPILE;
 	return hash_flags;
 }
 
@@ -1764,6 +1766,10 @@ radv_link_shaders(struct radv_pipeline *pipeline, nir_shader **shaders)
 		nir_lower_io_arrays_to_elements(ordered_shaders[i],
 						ordered_shaders[i - 1]);
 
+		if (nir_link_opt_varyings(ordered_shaders[i],
+					  ordered_shaders[i - 1]))
+			radv_optimize_nir(ordered_shaders[i - 1], false);
+
 		nir_remove_dead_variables(ordered_shaders[i],
 					  nir_var_shader_out);
 		nir_remove_dead_variables(ordered_shaders[i - 1],
@@ -1954,6 +1960,168 @@ merge_tess_info(struct shader_info *tes_info,
 	tes_info->tess.point_mode |= tcs_info->tess.point_mode;
 }
 
+/* Compiles a stage, or takes it from the cache when another pipeline already
+ * compiled the same NIR with the same key.
+ */
+static struct radv_shader_variant *
+radv_shader_variant_create_cached(struct radv_device *device,
+				  struct radv_pipeline_cache *cache,
+				  struct radv_shader_module *module,
+				  struct nir_shader *const *shaders,
+				  int shader_count,
+				  struct radv_pipeline_layout *layout,
+				  const struct radv_shader_variant_key *key,
+				  bool gs_copy_shader,
+				  void **code_out,
+				  unsigned *code_size_out)
+{
+	struct radv_shader_variant *variants[MESA_SHADER_STAGES] = {0};
+	void *codes[MESA_SHADER_STAGES] = {0};
+	unsigned code_sizes[MESA_SHADER_STAGES] = {0};
+	gl_shader_stage stage = shaders[shader_count - 1]->info.stage;
+	unsigned char hash[20];
+
+	radv_hash_shader_stage(hash, shaders, shader_count, layout, key,
+			       gs_copy_shader, get_hash_flags(device));
+
+	if (radv_create_shader_variants_from_pipeline_cache(device, cache, hash,
+							    variants, codes,
+							    code_sizes) &&
+	    variants[stage] && codes[stage]) {
+		*code_out = codes[stage];
+		*code_size_out = code_sizes[stage];
+		return variants[stage];
+	}
+
+	for (int i = 0; i < MESA_SHADER_STAGES; ++i) {
+		if (variants[i])
+			radv_shader_variant_destroy(device, variants[i]);
+		free(codes[i]);
+		variants[i] = NULL;
+		codes[i] = NULL;
+		code_sizes[i] = 0;
+	}
+
+	if (gs_copy_shader) {
+		variants[stage] = radv_create_gs_copy_shader(device, shaders[0],
+							     code_out, code_size_out,
+							     key->has_multiview_view_index);
+	} else {
+		variants[stage] = radv_shader_variant_create(device, module,
+							     shaders, shader_count,
+							     layout, key,
+							     code_out, code_size_out);
+	}
+	if (!variants[stage])
+		return NULL;
+
+	codes[stage] = *code_out;
+	code_sizes[stage] = *code_size_out;
+	radv_pipeline_cache_insert_shaders(device, cache, hash, variants,
+					   (const void**)codes, code_sizes);
+	return variants[stage];
+}
+
+/* A piece of pipeline compilation that can run on the device compile queue.
+ * Jobs that no worker has picked up yet are run by the thread waiting for
+ * them, so a job may itself wait for other jobs without deadlocking the
+ * queue.
+ */
+struct radv_compile_job {
+	struct util_queue_fence fence;
+	void (*execute)(struct radv_compile_job *job);
+	bool done;
+};
+
+static void
+radv_compile_job_execute(void *data, int thread_index)
+{
+	struct radv_compile_job *job = data;
+
+	job->execute(job);
+	job->done = true;
+}
+
+static void
+radv_compile_job_submit(struct radv_device *device,
+			struct radv_compile_job *job,
+			void (*execute)(struct radv_compile_job *job))
+{
+	job->execute = execute;
+	job->done = false;
+
+	if (!util_queue_is_initialized(&device->compile_queue)) {
+		radv_compile_job_execute(job, 0);
+		return;
+	}
+
+	util_queue_fence_init(&job->fence);
+	util_queue_add_job(&device->compile_queue, job, &job->fence,
+			   radv_compile_job_execute, NULL);
+}
+
+static void
+radv_compile_job_finish(struct radv_device *device,
+			struct radv_compile_job *job)
+{
+	if (!util_queue_is_initialized(&device->compile_queue))
+		return;
+
+	util_queue_drop_job(&device->compile_queue, &job->fence);
+	if (!job->done)
+		radv_compile_job_execute(job, 0);
+	util_queue_fence_destroy(&job->fence);
+}
+
+struct radv_shader_job {
+	struct radv_compile_job base;
+	struct radv_device *device;
+	struct radv_pipeline_cache *cache;
+	struct radv_shader_module *module;
+	struct radv_pipeline_layout *layout;
+	struct nir_shader *nir;
+	struct radv_shader_variant_key key;
+	bool gs_copy_shader;
+
+	struct radv_shader_variant *variant;
+	void *code;
+	unsigned code_size;
+};
+
+static void
+radv_shader_job_execute(struct radv_compile_job *base)
+{
+	struct radv_shader_job *job = (struct radv_shader_job *)base;
+
+	job->variant = radv_shader_variant_create_cached(job->device, job->cache,
+							 job->module, &job->nir, 1,
+							 job->layout, &job->key,
+							 job->gs_copy_shader,
+							 &job->code,
+							 &job->code_size);
+}
+
+static void
+radv_shader_job_submit(struct radv_device *device,
+		       struct radv_pipeline_cache *cache,
+		       struct radv_shader_job *job,
+		       struct radv_shader_module *module,
+		       struct radv_pipeline_layout *layout,
+		       struct nir_shader *nir,
+		       const struct radv_shader_variant_key *key,
+		       bool gs_copy_shader)
+{
+	job->device = device;
+	job->cache = cache;
+	job->module = module;
+	job->layout = layout;
+	job->nir = nir;
+	job->key = *key;
+	job->gs_copy_shader = gs_copy_shader;
+
+	radv_compile_job_submit(device, &job->base, radv_shader_job_execute);
+}
+
 static
 void radv_create_shaders(struct radv_pipeline *pipeline,
                          struct radv_device *device,
@@ -1988,11 +2156,11 @@ void radv_create_shaders(struct radv_pipeline *pipeline,
 
 	if (modules[MESA_SHADER_GEOMETRY]) {
 		struct radv_shader_variant *variants[MESA_SHADER_STAGES] = {0};
-		radv_create_shader_variants_from_pipeline_cache(device, cache, gs_copy_hash, variants);
+		radv_create_shader_variants_from_pipeline_cache(device, cache, gs_copy_hash, variants, NULL, NULL);
 		pipeline->gs_copy_shader = variants[MESA_SHADER_GEOMETRY];
 	}
 
-	if (radv_create_shader_variants_from_pipeline_cache(device, cache, hash, pipeline->shaders) &&
+	if (radv_create_shader_variants_from_pipeline_cache(device, cache, hash, pipeline->shaders, NULL, NULL) &&
 	    (!modules[MESA_SHADER_GEOMETRY] || pipeline->gs_copy_shader)) {
 		return;
 	}
@@ -2065,23 +2233,60 @@ void radv_create_shaders(struct radv_pipeline *pipeline,
 
 	radv_fill_shader_keys(keys, &key, nir);
 
+	/* The fragment shader, the GS copy shader and, before GFX9, the
+	 * geometry shader don't depend on the other stages. They are compiled
+	 * on the compile queue while this thread goes through the rest.
+	 */
+	struct radv_shader_job jobs[MESA_SHADER_STAGES] = {0};
+	struct radv_shader_job gs_copy_job = {0};
+	bool has_job[MESA_SHADER_STAGES] = {0};
+
+	if (modules[MESA_SHADER_GEOMETRY] && !pipeline->gs_copy_shader) {
+		struct nir_shader *gs_nir = nir[MESA_SHADER_GEOMETRY];
+
+		/* Compiling the geometry shader variant writes to its NIR. */
+		if (util_queue_is_initialized(&device->compile_queue))
+			gs_nir = nir_shader_clone(NULL, gs_nir);
+
+		radv_shader_job_submit(device, cache, &gs_copy_job, NULL, NULL, gs_nir,
+				       &keys[MESA_SHADER_GEOMETRY], true);
+	}
+
+	if (device->physical_device->rad_info.chip_class < GFX9 &&
+	    modules[MESA_SHADER_GEOMETRY] && !pipeline->shaders[MESA_SHADER_GEOMETRY]) {
+		radv_shader_job_submit(device, cache, &jobs[MESA_SHADER_GEOMETRY],
+				       modules[MESA_SHADER_GEOMETRY], pipeline->layout,
+				       nir[MESA_SHADER_GEOMETRY],
+				       &keys[MESA_SHADER_GEOMETRY], false);
+		has_job[MESA_SHADER_GEOMETRY] = true;
+	}
+
 	if (nir[MESA_SHADER_FRAGMENT]) {
+		struct radv_shader_info ps_info = {0};
+
 		if (!pipeline->shaders[MESA_SHADER_FRAGMENT]) {
-			pipeline->shaders[MESA_SHADER_FRAGMENT] =
-			       radv_shader_variant_create(device, modules[MESA_SHADER_FRAGMENT], &nir[MESA_SHADER_FRAGMENT], 1,
-			                                  pipeline->layout, keys + MESA_SHADER_FRAGMENT,
-			                                  &codes[MESA_SHADER_FRAGMENT], &code_sizes[MESA_SHADER_FRAGMENT]);
+			/* Gather the inputs of the fragment shader up front so
+			 * the earlier stages don't have to wait for it.
+			 */
+			struct radv_nir_compiler_options options = {0};
+
+			options.layout = pipeline->layout;
+			radv_nir_shader_info_pass(nir[MESA_SHADER_FRAGMENT], &options, &ps_info);
+
+			radv_shader_job_submit(device, cache, &jobs[MESA_SHADER_FRAGMENT],
+					       modules[MESA_SHADER_FRAGMENT], pipeline->layout,
+					       nir[MESA_SHADER_FRAGMENT],
+					       &keys[MESA_SHADER_FRAGMENT], false);
+			has_job[MESA_SHADER_FRAGMENT] = true;
+		} else {
+			ps_info = pipeline->shaders[MESA_SHADER_FRAGMENT]->info.info;
 		}
 
 		/* TODO: These are no longer used as keys we should refactor this */
-		keys[MESA_SHADER_VERTEX].vs.export_prim_id =
-		        pipeline->shaders[MESA_SHADER_FRAGMENT]->info.info.ps.prim_id_input;
-		keys[MESA_SHADER_VERTEX].vs.export_layer_id =
-		        pipeline->shaders[MESA_SHADER_FRAGMENT]->info.info.ps.layer_input;
-		keys[MESA_SHADER_TESS_EVAL].tes.export_prim_id =
-		        pipeline->shaders[MESA_SHADER_FRAGMENT]->info.info.ps.prim_id_input;
-		keys[MESA_SHADER_TESS_EVAL].tes.export_layer_id =
-		        pipeline->shaders[MESA_SHADER_FRAGMENT]->info.info.ps.layer_input;
+		keys[MESA_SHADER_VERTEX].vs.export_prim_id = ps_info.ps.prim_id_input;
+		keys[MESA_SHADER_VERTEX].vs.export_layer_id = ps_info.ps.layer_input;
+		keys[MESA_SHADER_TESS_EVAL].tes.export_prim_id = ps_info.ps.prim_id_input;
+		keys[MESA_SHADER_TESS_EVAL].tes.export_layer_id = ps_info.ps.layer_input;
 	}
 
 	if (device->physical_device->rad_info.chip_class >= GFX9 && modules[MESA_SHADER_TESS_CTRL]) {
@@ -2089,10 +2294,10 @@ void radv_create_shaders(struct radv_pipeline *pipeline,
 			struct nir_shader *combined_nir[] = {nir[MESA_SHADER_VERTEX], nir[MESA_SHADER_TESS_CTRL]};
 			struct radv_shader_variant_key key = keys[MESA_SHADER_TESS_CTRL];
 			key.tcs.vs_key = keys[MESA_SHADER_VERTEX].vs;
-			pipeline->shaders[MESA_SHADER_TESS_CTRL] = radv_shader_variant_create(device, modules[MESA_SHADER_TESS_CTRL], combined_nir, 2,
-			                                                                      pipeline->layout,
-			                                                                      &key, &codes[MESA_SHADER_TESS_CTRL],
-			                                                                      &code_sizes[MESA_SHADER_TESS_CTRL]);
+			pipeline->shaders[MESA_SHADER_TESS_CTRL] = radv_shader_variant_create_cached(device, cache, modules[MESA_SHADER_TESS_CTRL], combined_nir, 2,
+			                                                                             pipeline->layout,
+			                                                                             &key, false, &codes[MESA_SHADER_TESS_CTRL],
+			                                                                             &code_sizes[MESA_SHADER_TESS_CTRL]);
 		}
 		modules[MESA_SHADER_VERTEX] = NULL;
 		keys[MESA_SHADER_TESS_EVAL].tes.num_patches = pipeline->shaders[MESA_SHADER_TESS_CTRL]->info.tcs.num_patches;
@@ -2103,16 +2308,16 @@ void radv_create_shaders(struct radv_pipeline *pipeline,
 		gl_shader_stage pre_stage = modules[MESA_SHADER_TESS_EVAL] ? MESA_SHADER_TESS_EVAL : MESA_SHADER_VERTEX;
 		if (!pipeline->shaders[MESA_SHADER_GEOMETRY]) {
 			struct nir_shader *combined_nir[] = {nir[pre_stage], nir[MESA_SHADER_GEOMETRY]};
-			pipeline->shaders[MESA_SHADER_GEOMETRY] = radv_shader_variant_create(device, modules[MESA_SHADER_GEOMETRY], combined_nir, 2,
-			                                                                     pipeline->layout,
-			                                                                     &keys[pre_stage] , &codes[MESA_SHADER_GEOMETRY],
-		                                                                     &code_sizes[MESA_SHADER_GEOMETRY]);
+			pipeline->shaders[MESA_SHADER_GEOMETRY] = radv_shader_variant_create_cached(device, cache, modules[MESA_SHADER_GEOMETRY], combined_nir, 2,
+			                                                                            pipeline->layout,
+			                                                                            &keys[pre_stage], false, &codes[MESA_SHADER_GEOMETRY],
+			                                                                            &code_sizes[MESA_SHADER_GEOMETRY]);
 		}
 		modules[pre_stage] = NULL;
 	}
 
 	for (int i = 0; i < MESA_SHADER_STAGES; ++i) {
-		if(modules[i] && !pipeline->shaders[i]) {
+		if(modules[i] && !pipeline->shaders[i] && !has_job[i]) {
 			if (i == MESA_SHADER_TESS_CTRL) {
 				keys[MESA_SHADER_TESS_CTRL].tcs.num_inputs = util_last_bit64(pipeline->shaders[MESA_SHADER_VERTEX]->info.info.vs.ls_outputs_written);
 			}
@@ -2120,21 +2325,34 @@ void radv_create_shaders(struct radv_pipeline *pipeline,
 				keys[MESA_SHADER_TESS_EVAL].tes.num_patches = pipeline->shaders[MESA_SHADER_TESS_CTRL]->info.tcs.num_patches;
 				keys[MESA_SHADER_TESS_EVAL].tes.tcs_num_outputs = util_last_bit64(pipeline->shaders[MESA_SHADER_TESS_CTRL]->info.info.tcs.outputs_written);
 			}
-			pipeline->shaders[i] = radv_shader_variant_create(device, modules[i], &nir[i], 1,
-									  pipeline->layout,
-									  keys + i, &codes[i],
-									  &code_sizes[i]);
+			pipeline->shaders[i] = radv_shader_variant_create_cached(device, cache, modules[i], &nir[i], 1,
+										 pipeline->layout,
+										 keys + i, false, &codes[i],
+										 &code_sizes[i]);
 		}
 	}
 
+	for (int i = 0; i < MESA_SHADER_STAGES; ++i) {
+		if (!has_job[i])
+			continue;
+
+		radv_compile_job_finish(device, &jobs[i].base);
+		pipeline->shaders[i] = jobs[i].variant;
+		codes[i] = jobs[i].code;
+		code_sizes[i] = jobs[i].code_size;
+	}
+
 	if(modules[MESA_SHADER_GEOMETRY]) {
 		void *gs_copy_code = NULL;
 		unsigned gs_copy_code_size = 0;
 		if (!pipeline->gs_copy_shader) {
-			pipeline->gs_copy_shader = radv_create_gs_copy_shader(
-					device, nir[MESA_SHADER_GEOMETRY], &gs_copy_code,
-					&gs_copy_code_size,
-					keys[MESA_SHADER_GEOMETRY].has_multiview_view_index);
+			radv_compile_job_finish(device, &gs_copy_job.base);
+			pipeline->gs_copy_shader = gs_copy_job.variant;
+			gs_copy_code = gs_copy_job.code;
+			gs_copy_code_size = gs_copy_job.code_size;
+
+			if (gs_copy_job.nir != nir[MESA_SHADER_GEOMETRY])
+				ralloc_free(gs_copy_job.nir);
 		}
 
 		if (pipeline->gs_copy_shader) {
@@ -3542,6 +3760,74 @@ radv_graphics_pipeline_create(
 	return VK_SUCCESS;
 }
 
+struct radv_pipeline_job {
+	struct radv_compile_job base;
+	VkDevice device;
+	VkPipelineCache cache;
+	const void *create_info;
+	const VkAllocationCallbacks *alloc;
+	VkPipeline *pipeline;
+	VkResult result;
+};
+
+/* Creates the pipelines of a vkCreate*Pipelines call in parallel. Returns
+ * false without creating anything when there is a single pipeline or no
+ * compile queue, so the caller falls back to creating them one by one.
+ */
+static bool
+radv_create_pipelines_threaded(VkDevice _device,
+			       VkPipelineCache pipelineCache,
+			       uint32_t count,
+			       const void *pCreateInfos,
+			       size_t create_info_size,
+			       const VkAllocationCallbacks *pAllocator,
+			       VkPipeline *pPipelines,
+			       void (*execute)(struct radv_compile_job *job),
+			       VkResult *result)
+{
+	RADV_FROM_HANDLE(radv_device, device, _device);
+	struct radv_pipeline_job *jobs;
+
+	if (count < 2 || !util_queue_is_initialized(&device->compile_queue))
+		return false;
+
+	jobs = vk_zalloc2(&device->alloc, pAllocator, count * sizeof(*jobs), 8,
+			  VK_SYSTEM_ALLOCATION_SCOPE_COMMAND);
+	if (!jobs)
+		return false;
+
+	for (unsigned i = 0; i < count; i++) {
+		jobs[i].device = _device;
+		jobs[i].cache = pipelineCache;
+		jobs[i].create_info = (const char *)pCreateInfos + i * create_info_size;
+		jobs[i].alloc = pAllocator;
+		jobs[i].pipeline = &pPipelines[i];
+		radv_compile_job_submit(device, &jobs[i].base, execute);
+	}
+
+	*result = VK_SUCCESS;
+	for (unsigned i = 0; i < count; i++) {
+		radv_compile_job_finish(device, &jobs[i].base);
+		if (jobs[i].result != VK_SUCCESS) {
+			*result = jobs[i].result;
+			pPipelines[i] = VK_NULL_HANDLE;
+		}
+	}
+
+	vk_free2(&device->alloc, pAllocator, jobs);
+	return true;
+}
+
+static void
+radv_graphics_pipeline_job_execute(struct radv_compile_job *base)
+{
+	struct radv_pipeline_job *job = (struct radv_pipeline_job *)base;
+
+	job->result = radv_graphics_pipeline_create(job->device, job->cache,
+						    job->create_info, NULL,
+						    job->alloc, job->pipeline);
+}
+
 VkResult radv_CreateGraphicsPipelines(
 	VkDevice                                    _device,
 	VkPipelineCache                             pipelineCache,
@@ -3553,6 +3839,13 @@ VkResult radv_CreateGraphicsPipelines(
 	VkResult result = VK_SUCCESS;
 	unsigned i = 0;
 
+	if (radv_create_pipelines_threaded(_device, pipelineCache, count,
+					   pCreateInfos, sizeof(*pCreateInfos),
+					   pAllocator, pPipelines,
+					   radv_graphics_pipeline_job_execute,
+					   &result))
+		return result;
+
 	for (; i < count; i++) {
 		VkResult r;
 		r = radv_graphics_pipeline_create(_device,
@@ -3671,6 +3964,16 @@ static VkResult radv_compute_pipeline_create(
 	return VK_SUCCESS;
 }
 
+static void
+radv_compute_pipeline_job_execute(struct radv_compile_job *base)
+{
+	struct radv_pipeline_job *job = (struct radv_pipeline_job *)base;
+
+	job->result = radv_compute_pipeline_create(job->device, job->cache,
+						   job->create_info,
+						   job->alloc, job->pipeline);
+}
+
 VkResult radv_CreateComputePipelines(
 	VkDevice                                    _device,
 	VkPipelineCache                             pipelineCache,
@@ -3681,6 +3984,13 @@ VkResult radv_CreateComputePipelines(
 {
 	VkResult result = VK_SUCCESS;
 
+	if (radv_create_pipelines_threaded(_device, pipelineCache, count,
+					   pCreateInfos, sizeof(*pCreateInfos),
+					   pAllocator, pPipelines,
+					   radv_compute_pipeline_job_execute,
+					   &result))
+		return result;
+
 	unsigned i = 0;
 	for (; i < count; i++) {
 		VkResult r;
@@ -21,6 +21,8 @@
  * IN THE SOFTWARE.
  */
 
+#include "compiler/blob.h"
+#include "nir/nir_serialize.h"
 #include "util/mesa-sha1.h"
 #include "util/debug.h"
 #include "util/disk_cache.h"
@@ -52,40 +54,101 @@ radv_pipeline_cache_init(struct radv_pipeline_cache *cache,
 			 struct radv_device *device)
 {
 	cache->device = device;
-	pthread_mutex_init(&cache->mutex, NULL);
-
 	cache->modified = false;
-	cache->kernel_count = 0;
-	cache->total_size = 0;
-	cache->table_size = 1024;
-	const size_t byte_size = cache->table_size * sizeof(cache->hash_table[0]);
-	cache->hash_table = malloc(byte_size);
-
-	/* We don't consider allocation failure fatal, we just start with a 0-sized
-	 * cache. Disable caching when we want to keep shader debug info, since
-	 * we don't get the debug info on cached shaders. */
-	if (cache->hash_table == NULL ||
-	    (device->instance->debug_flags & RADV_DEBUG_NO_CACHE) ||
-	    device->keep_shader_info)
-		cache->table_size = 0;
-	else
-		memset(cache->hash_table, 0, byte_size);
+	cache->data = NULL;
+	cache->data_size = 0;
+
+	for (unsigned s = 0; s < RADV_PIPELINE_CACHE_SHARDS; s++) {
+		struct radv_pipeline_cache_shard *shard = &cache->shards[s];
+
+		memset(shard, 0, sizeof(*shard));
+		pthread_mutex_init(&shard->mutex, NULL);
+
+		shard->table_size = 1024 / RADV_PIPELINE_CACHE_SHARDS;
+		const size_t byte_size = shard->table_size * sizeof(shard->hash_table[0]);
+		shard->hash_table = malloc(byte_size);
+
+		/* We don't consider allocation failure fatal, we just start with a 0-sized
+		 * cache. Disable caching when we want to keep shader debug info, since
+		 * we don't get the debug info on cached shaders. */
+		if (shard->hash_table == NULL ||
+		    (device->instance->debug_flags & RADV_DEBUG_NO_CACHE) ||
+		    device->keep_shader_info)
+			shard->table_size = 0;
+		else
+			memset(shard->hash_table, 0, byte_size);
+	}
+}
+
+static void
+radv_pipeline_cache_print_stats(struct radv_pipeline_cache *cache)
+{
+	unsigned entries = 0, hits = 0, disk_hits = 0, misses = 0, contended = 0;
+
+	for (unsigned s = 0; s < RADV_PIPELINE_CACHE_SHARDS; s++) {
+		entries += cache->shards[s].kernel_count;
+		hits += cache->shards[s].hits;
+		disk_hits += cache->shards[s].disk_hits;
+		misses += cache->shards[s].misses;
+		contended += cache->shards[s].contended;
+	}
+
+	fprintf(stderr, "radv: pipeline cache %p: %u entries, %u hits, "
+		"%u disk cache hits, %u misses, %u contended lookups\n",
+		cache, entries, hits, disk_hits, misses, contended);
+}
+
+/* Whether the entry lives in the data the cache was loaded from. */
+static bool
+radv_pipeline_cache_entry_is_loaded(const struct radv_pipeline_cache *cache,
+				    const struct cache_entry *entry)
+{
+	return (const char *)entry >= (const char *)cache->data &&
+	       (const char *)entry < (const char *)cache->data + cache->data_size;
 }
 
 void
 radv_pipeline_cache_finish(struct radv_pipeline_cache *cache)
 {
-	for (unsigned i = 0; i < cache->table_size; ++i)
-		if (cache->hash_table[i]) {
-			for(int j = 0; j < MESA_SHADER_STAGES; ++j)  {
-				if (cache->hash_table[i]->variants[j])
-					radv_shader_variant_destroy(cache->device,
-								    cache->hash_table[i]->variants[j]);
+	if (cache->device->instance->debug_flags & RADV_DEBUG_CACHE_STATS)
+		radv_pipeline_cache_print_stats(cache);
+
+	for (unsigned s = 0; s < RADV_PIPELINE_CACHE_SHARDS; s++) {
+		struct radv_pipeline_cache_shard *shard = &cache->shards[s];
+
+		for (unsigned i = 0; i < shard->table_size; ++i)
+			if (shard->hash_table[i]) {
+				for(int j = 0; j < MESA_SHADER_STAGES; ++j)  {
+					if (shard->hash_table[i]->variants[j])
+						radv_shader_variant_destroy(cache->device,
+									    shard->hash_table[i]->variants[j]);
+				}
+				if (!radv_pipeline_cache_entry_is_loaded(cache, shard->hash_table[i]))
+					vk_free(&cache->alloc, shard->hash_table[i]);
 			}
-			vk_free(&cache->alloc, cache->hash_table[i]);
-		}
-	pthread_mutex_destroy(&cache->mutex);
-	free(cache->hash_table);
+		pthread_mutex_destroy(&shard->mutex);
+		free(shard->hash_table);
+	}
+	vk_free(&cache->alloc, cache->data);
+}
+
+static struct radv_pipeline_cache_shard *
+radv_pipeline_cache_get_shard(struct radv_pipeline_cache *cache,
+			      const unsigned char *sha1)
+{
+	/* The first dword is the start of the probe sequence within the shard,
+	 * so pick the shard with a different part of the hash.
+	 */
+	return &cache->shards[sha1[4] % RADV_PIPELINE_CACHE_SHARDS];
+}
+
+static void
+radv_pipeline_cache_lock(struct radv_pipeline_cache_shard *shard)
+{
+	if (pthread_mutex_trylock(&shard->mutex) != 0) {
+		pthread_mutex_lock(&shard->mutex);
+		shard->contended++;
+	}
 }
 
 static uint32_t
@@ -98,6 +161,17 @@ entry_size(struct cache_entry *entry)
 	return ret;
 }
 
+/* Entries are padded to this in the serialized cache, so that they can be
+ * used in place after loading it.
+ */
+#define CACHE_ENTRY_ALIGNMENT 8
+
+static uint32_t
+entry_stride(struct cache_entry *entry)
+{
+	return align_u32(entry_size(entry), CACHE_ENTRY_ALIGNMENT);
+}
+
 void
 radv_hash_shaders(unsigned char *hash,
 		  const VkPipelineShaderStageCreateInfo **stages,
@@ -131,20 +205,57 @@ radv_hash_shaders(unsigned char *hash,
 	_mesa_sha1_final(&ctx, hash);
 }
 
+/* Hash of a single compiled stage. Its NIR is taken after linking, so this
+ * covers everything the other stages and the pipeline state change about
+ * it, and pipelines that only differ in something else share the binary.
+ */
+void
+radv_hash_shader_stage(unsigned char *hash,
+		       struct nir_shader *const *shaders,
+		       int shader_count,
+		       const struct radv_pipeline_layout *layout,
+		       const struct radv_shader_variant_key *key,
+		       bool gs_copy_shader,
+		       uint32_t flags)
+{
+	static const char tag[] = "radv stage";
+	struct mesa_sha1 ctx;
+
+	_mesa_sha1_init(&ctx);
+	_mesa_sha1_update(&ctx, tag, sizeof(tag));
+
+	for (int i = 0; i < shader_count; ++i) {
+		struct blob blob;
+
+		blob_init(&blob);
+		nir_serialize(&blob, shaders[i]);
+		_mesa_sha1_update(&ctx, blob.data, blob.size);
+		blob_finish(&blob);
+	}
+
+	if (layout)
+		_mesa_sha1_update(&ctx, layout->sha1, sizeof(layout->sha1));
+	if (key)
+		_mesa_sha1_update(&ctx, key, sizeof(*key));
+	_mesa_sha1_update(&ctx, &gs_copy_shader, sizeof(gs_copy_shader));
+	_mesa_sha1_update(&ctx, &flags, 4);
+	_mesa_sha1_final(&ctx, hash);
+}
+
 
 static struct cache_entry *
-radv_pipeline_cache_search_unlocked(struct radv_pipeline_cache *cache,
+radv_pipeline_cache_search_unlocked(struct radv_pipeline_cache_shard *shard,
 				    const unsigned char *sha1)
 {
-	const uint32_t mask = cache->table_size - 1;
+	const uint32_t mask = shard->table_size - 1;
 	const uint32_t start = (*(uint32_t *) sha1);
 
-	if (cache->table_size == 0)
+	if (shard->table_size == 0)
 		return NULL;
 
-	for (uint32_t i = 0; i < cache->table_size; i++) {
+	for (uint32_t i = 0; i < shard->table_size; i++) {
 		const uint32_t index = (start + i) & mask;
-		struct cache_entry *entry = cache->hash_table[index];
+		struct cache_entry *entry = shard->hash_table[index];
 
 		if (!entry)
 			return NULL;
@@ -157,69 +268,55 @@ radv_pipeline_cache_search_unlocked(struct radv_pipeline_cache *cache,
 	unreachable("hash table should never be full");
 }
 
-static struct cache_entry *
-radv_pipeline_cache_search(struct radv_pipeline_cache *cache,
-			   const unsigned char *sha1)
-{
-	struct cache_entry *entry;
-
-	pthread_mutex_lock(&cache->mutex);
-
-	entry = radv_pipeline_cache_search_unlocked(cache, sha1);
-
-	pthread_mutex_unlock(&cache->mutex);
-
-	return entry;
-}
-
 static void
-radv_pipeline_cache_set_entry(struct radv_pipeline_cache *cache,
+radv_pipeline_cache_set_entry(struct radv_pipeline_cache_shard *shard,
 			      struct cache_entry *entry)
 {
-	const uint32_t mask = cache->table_size - 1;
+	const uint32_t mask = shard->table_size - 1;
 	const uint32_t start = entry->sha1_dw[0];
 
 	/* We'll always be able to insert when we get here. */
-	assert(cache->kernel_count < cache->table_size / 2);
+	assert(shard->kernel_count < shard->table_size / 2);
 
-	for (uint32_t i = 0; i < cache->table_size; i++) {
+	for (uint32_t i = 0; i < shard->table_size; i++) {
 		const uint32_t index = (start + i) & mask;
-		if (!cache->hash_table[index]) {
-			cache->hash_table[index] = entry;
+		if (!shard->hash_table[index]) {
+			shard->hash_table[index] = entry;
 			break;
 		}
 	}
 
-	cache->total_size += entry_size(entry);
-	cache->kernel_count++;
+	shard->total_size += entry_stride(entry);
+	shard->kernel_count++;
 }
 
 
 static VkResult
-radv_pipeline_cache_grow(struct radv_pipeline_cache *cache)
+radv_pipeline_cache_grow(struct radv_pipeline_cache *cache,
+			 struct radv_pipeline_cache_shard *shard)
 {
-	const uint32_t table_size = cache->table_size * 2;
-	const uint32_t old_table_size = cache->table_size;
-	const size_t byte_size = table_size * sizeof(cache->hash_table[0]);
+	const uint32_t table_size = shard->table_size * 2;
+	const uint32_t old_table_size = shard->table_size;
+	const size_t byte_size = table_size * sizeof(shard->hash_table[0]);
 	struct cache_entry **table;
-	struct cache_entry **old_table = cache->hash_table;
+	struct cache_entry **old_table = shard->hash_table;
 
 	table = malloc(byte_size);
 	if (table == NULL)
 		return vk_error(cache->device->instance, VK_ERROR_OUT_OF_HOST_MEMORY);
 
-	cache->hash_table = table;
-	cache->table_size = table_size;
-	cache->kernel_count = 0;
-	cache->total_size = 0;
+	shard->hash_table = table;
+	shard->table_size = table_size;
+	shard->kernel_count = 0;
+	shard->total_size = 0;
 
-	memset(cache->hash_table, 0, byte_size);
+	memset(shard->hash_table, 0, byte_size);
 	for (uint32_t i = 0; i < old_table_size; i++) {
 		struct cache_entry *entry = old_table[i];
 		if (!entry)
 			continue;
 
-		radv_pipeline_cache_set_entry(cache, entry);
+		radv_pipeline_cache_set_entry(shard, entry);
 	}
 
 	free(old_table);
@@ -229,16 +326,17 @@ radv_pipeline_cache_grow(struct radv_pipeline_cache *cache)
 
 static void
 radv_pipeline_cache_add_entry(struct radv_pipeline_cache *cache,
+			      struct radv_pipeline_cache_shard *shard,
 			      struct cache_entry *entry)
 {
-	if (cache->kernel_count == cache->table_size / 2)
-		radv_pipeline_cache_grow(cache);
+	if (shard->kernel_count == shard->table_size / 2)
+		radv_pipeline_cache_grow(cache, shard);
 
 	/* Failing to grow that hash table isn't fatal, but may mean we don't
 	 * have enough space to add this new kernel. Only add it if there's room.
 	 */
-	if (cache->kernel_count < cache->table_size / 2)
-		radv_pipeline_cache_set_entry(cache, entry);
+	if (shard->kernel_count < shard->table_size / 2)
+		radv_pipeline_cache_set_entry(shard, entry);
 }
 
 static bool
@@ -255,50 +353,60 @@ bool
 radv_create_shader_variants_from_pipeline_cache(struct radv_device *device,
 					        struct radv_pipeline_cache *cache,
 					        const unsigned char *sha1,
-					        struct radv_shader_variant **variants)
+					        struct radv_shader_variant **variants,
+					        void **codes,
+					        unsigned *code_sizes)
 {
+	struct radv_pipeline_cache_shard *shard;
 	struct cache_entry *entry;
 
 	if (!cache)
 		cache = device->mem_cache;
 
-	pthread_mutex_lock(&cache->mutex);
+	shard = radv_pipeline_cache_get_shard(cache, sha1);
+	radv_pipeline_cache_lock(shard);
 
-	entry = radv_pipeline_cache_search_unlocked(cache, sha1);
+	entry = radv_pipeline_cache_search_unlocked(shard, sha1);
 
-	if (!entry) {
+	if (entry) {
+		shard->hits++;
+	} else {
 		/* Don't cache when we want debug info, since this isn't
 		 * present in the cache.
 		 */
 		if (radv_is_cache_disabled(device) || !device->physical_device->disk_cache) {
-			pthread_mutex_unlock(&cache->mutex);
+			shard->misses++;
+			pthread_mutex_unlock(&shard->mutex);
 			return false;
 		}
 
 		uint8_t disk_sha1[20];
+		struct disk_cache_mapped_entry disk_entry;
 		disk_cache_compute_key(device->physical_device->disk_cache,
 				       sha1, 20, disk_sha1);
-		entry = (struct cache_entry *)
-			disk_cache_get(device->physical_device->disk_cache,
-				       disk_sha1, NULL);
-		if (!entry) {
-			pthread_mutex_unlock(&cache->mutex);
+		if (!disk_cache_get_mapped(device->physical_device->disk_cache,
+					   disk_sha1, &disk_entry)) {
+			shard->misses++;
+			pthread_mutex_unlock(&shard->mutex);
 			return false;
 		} else {
-			size_t size = entry_size(entry);
-			struct cache_entry *new_entry = vk_alloc(&cache->alloc, size, 8,
+			/* The mapped data may be unaligned, so only look at it
+			 * once it has been copied into the in-memory cache.
+			 */
+			struct cache_entry *new_entry = vk_alloc(&cache->alloc, disk_entry.size, 8,
 								 VK_SYSTEM_ALLOCATION_SCOPE_CACHE);
 			if (!new_entry) {
-				free(entry);
-				pthread_mutex_unlock(&cache->mutex);
+				disk_cache_release_mapped(&disk_entry);
+				pthread_mutex_unlock(&shard->mutex);
 				return false;
 			}
 
-			memcpy(new_entry, entry, entry_size(entry));
-			free(entry);
+			memcpy(new_entry, disk_entry.data, disk_entry.size);
+			disk_cache_release_mapped(&disk_entry);
 			entry = new_entry;
 
-			radv_pipeline_cache_add_entry(cache, new_entry);
+			radv_pipeline_cache_add_entry(cache, shard, new_entry);
+			shard->disk_hits++;
 		}
 	}
 
@@ -310,7 +418,7 @@ radv_create_shader_variants_from_pipeline_cache(struct radv_device *device,
 
 			variant = calloc(1, sizeof(struct radv_shader_variant));
 			if (!variant) {
-				pthread_mutex_unlock(&cache->mutex);
+				pthread_mutex_unlock(&shard->mutex);
 				return false;
 			}
 
@@ -324,15 +432,30 @@ radv_create_shader_variants_from_pipeline_cache(struct radv_device *device,
 			variant->code_size = entry->code_sizes[i];
 			variant->ref_count = 1;
 
-			void *ptr = radv_alloc_shader_memory(device, variant);
-			memcpy(ptr, p, entry->code_sizes[i]);
-			p += entry->code_sizes[i];
+			if (!radv_upload_shader_code(device, variant, p,
+						     entry->code_sizes[i])) {
+				radv_shader_variant_destroy(device, variant);
+				pthread_mutex_unlock(&shard->mutex);
+				return false;
+			}
 
 			entry->variants[i] = variant;
 		} else if (entry->code_sizes[i]) {
-			p += sizeof(struct cache_entry_variant_info) + entry->code_sizes[i];
+			p += sizeof(struct cache_entry_variant_info);
 		}
 
+		if (entry->code_sizes[i]) {
+			/* The code of the shaders is wanted to add them to
+			 * another entry.
+			 */
+			if (codes) {
+				codes[i] = malloc(entry->code_sizes[i]);
+				if (codes[i])
+					memcpy(codes[i], p, entry->code_sizes[i]);
+				code_sizes[i] = codes[i] ? entry->code_sizes[i] : 0;
+			}
+			p += entry->code_sizes[i];
+		}
 	}
 
 	for (int i = 0; i < MESA_SHADER_STAGES; ++i)
@@ -340,7 +463,7 @@ radv_create_shader_variants_from_pipeline_cache(struct radv_device *device,
 			p_atomic_inc(&entry->variants[i]->ref_count);
 
 	memcpy(variants, entry->variants, sizeof(entry->variants));
-	pthread_mutex_unlock(&cache->mutex);
+	pthread_mutex_unlock(&shard->mutex);
 	return true;
 }
 
@@ -355,8 +478,11 @@ radv_pipeline_cache_insert_shaders(struct radv_device *device,
 	if (!cache)
 		cache = device->mem_cache;
 
-	pthread_mutex_lock(&cache->mutex);
-	struct cache_entry *entry = radv_pipeline_cache_search_unlocked(cache, sha1);
+	struct radv_pipeline_cache_shard *shard =
+		radv_pipeline_cache_get_shard(cache, sha1);
+
+	radv_pipeline_cache_lock(shard);
+	struct cache_entry *entry = radv_pipeline_cache_search_unlocked(shard, sha1);
 	if (entry) {
 		for (int i = 0; i < MESA_SHADER_STAGES; ++i) {
 			if (entry->variants[i]) {
@@ -368,7 +494,7 @@ radv_pipeline_cache_insert_shaders(struct radv_device *device,
 			if (variants[i])
 				p_atomic_inc(&variants[i]->ref_count);
 		}
-		pthread_mutex_unlock(&cache->mutex);
+		pthread_mutex_unlock(&shard->mutex);
 		return;
 	}
 
@@ -376,7 +502,7 @@ radv_pipeline_cache_insert_shaders(struct radv_device *device,
 	 * present in the cache.
 	 */
 	if (radv_is_cache_disabled(device)) {
-		pthread_mutex_unlock(&cache->mutex);
+		pthread_mutex_unlock(&shard->mutex);
 		return;
 	}
 
@@ -389,7 +515,7 @@ radv_pipeline_cache_insert_shaders(struct radv_device *device,
 	entry = vk_alloc(&cache->alloc, size, 8,
 			   VK_SYSTEM_ALLOCATION_SCOPE_CACHE);
 	if (!entry) {
-		pthread_mutex_unlock(&cache->mutex);
+		pthread_mutex_unlock(&shard->mutex);
 		return;
 	}
 
@@ -440,10 +566,10 @@ radv_pipeline_cache_insert_shaders(struct radv_device *device,
 		p_atomic_inc(&variants[i]->ref_count);
 	}
 
-	radv_pipeline_cache_add_entry(cache, entry);
+	radv_pipeline_cache_add_entry(cache, shard, entry);
 
-	cache->modified = true;
-	pthread_mutex_unlock(&cache->mutex);
+	p_atomic_set(&cache->modified, true);
+	pthread_mutex_unlock(&shard->mutex);
 	return;
 }
 
@@ -475,26 +601,37 @@ radv_pipeline_cache_load(struct radv_pipeline_cache *cache,
 		return;
 	if (memcmp(header.uuid, device->physical_device->cache_uuid, VK_UUID_SIZE) != 0)
 		return;
+	if (header.header_size > size)
+		return;
+
+	/* Copy all the entries at once and use them in place. The shader
+	 * variants are only created and uploaded when an entry is looked up.
+	 */
+	assert(!cache->data);
+	cache->data_size = size - header.header_size;
+	cache->data = vk_alloc(&cache->alloc, cache->data_size,
+			       CACHE_ENTRY_ALIGNMENT, VK_SYSTEM_ALLOCATION_SCOPE_CACHE);
+	if (!cache->data) {
+		cache->data_size = 0;
+		return;
+	}
+	memcpy(cache->data, (const char *)data + header.header_size, cache->data_size);
 
-	char *end = (void *) data + size;
-	char *p = (void *) data + header.header_size;
+	char *end = (char *)cache->data + cache->data_size;
+	char *p = cache->data;
 
 	while (end - p >= sizeof(struct cache_entry)) {
 		struct cache_entry *entry = (struct cache_entry*)p;
-		struct cache_entry *dest_entry;
 		size_t size = entry_size(entry);
 		if(end - p < size)
 			break;
 
-		dest_entry = vk_alloc(&cache->alloc, size,
-					8, VK_SYSTEM_ALLOCATION_SCOPE_CACHE);
-		if (dest_entry) {
-			memcpy(dest_entry, entry, size);
-			for (int i = 0; i < MESA_SHADER_STAGES; ++i)
-				dest_entry->variants[i] = NULL;
-			radv_pipeline_cache_add_entry(cache, dest_entry);
-		}
-		p += size;
+		for (int i = 0; i < MESA_SHADER_STAGES; ++i)
+			entry->variants[i] = NULL;
+		radv_pipeline_cache_add_entry(cache,
+					      radv_pipeline_cache_get_shard(cache, entry->sha1),
+					      entry);
+		p += entry_stride(entry);
 	}
 }
 
@@ -559,19 +696,22 @@ VkResult radv_GetPipelineCacheData(
 	RADV_FROM_HANDLE(radv_pipeline_cache, cache, _cache);
 	struct cache_header *header;
 	VkResult result = VK_SUCCESS;
+	size_t size = sizeof(*header);
 
-	pthread_mutex_lock(&cache->mutex);
+	/* Always taken in the same order, the other paths only ever hold one. */
+	for (unsigned s = 0; s < RADV_PIPELINE_CACHE_SHARDS; s++) {
+		pthread_mutex_lock(&cache->shards[s].mutex);
+		size += cache->shards[s].total_size;
+	}
 
-	const size_t size = sizeof(*header) + cache->total_size;
 	if (pData == NULL) {
-		pthread_mutex_unlock(&cache->mutex);
 		*pDataSize = size;
-		return VK_SUCCESS;
+		goto out;
 	}
 	if (*pDataSize < sizeof(*header)) {
-		pthread_mutex_unlock(&cache->mutex);
 		*pDataSize = 0;
-		return VK_INCOMPLETE;
+		result = VK_INCOMPLETE;
+		goto out;
 	}
 	void *p = pData, *end = pData + *pDataSize;
 	header = p;
@@ -583,24 +723,32 @@ VkResult radv_GetPipelineCacheData(
 	p += header->header_size;
 
 	struct cache_entry *entry;
-	for (uint32_t i = 0; i < cache->table_size; i++) {
-		if (!cache->hash_table[i])
-			continue;
-		entry = cache->hash_table[i];
-		const uint32_t size = entry_size(entry);
-		if (end < p + size) {
-			result = VK_INCOMPLETE;
-			break;
-		}
+	for (unsigned s = 0; s < RADV_PIPELINE_CACHE_SHARDS && result == VK_SUCCESS; s++) {
+		struct radv_pipeline_cache_shard *shard = &cache->shards[s];
+
+		for (uint32_t i = 0; i < shard->table_size; i++) {
+			if (!shard->hash_table[i])
+				continue;
+			entry = shard->hash_table[i];
+			const uint32_t size = entry_size(entry);
+			const uint32_t stride = entry_stride(entry);
+			if (end < p + stride) {
+				result = VK_INCOMPLETE;
+				break;
+			}
 
-		memcpy(p, entry, size);
-		for(int j = 0; j < MESA_SHADER_STAGES; ++j)
-			((struct cache_entry*)p)->variants[j] = NULL;
-		p += size;
+			memcpy(p, entry, size);
+			memset(p + size, 0, stride - size);
+			for(int j = 0; j < MESA_SHADER_STAGES; ++j)
+				((struct cache_entry*)p)->variants[j] = NULL;
+			p += stride;
+		}
 	}
 	*pDataSize = p - pData;
 
-	pthread_mutex_unlock(&cache->mutex);
+out:
+	for (unsigned s = 0; s < RADV_PIPELINE_CACHE_SHARDS; s++)
+		pthread_mutex_unlock(&cache->shards[s].mutex);
 	return result;
 }
 
@@ -608,14 +756,34 @@ static void
 radv_pipeline_cache_merge(struct radv_pipeline_cache *dst,
 			  struct radv_pipeline_cache *src)
 {
-	for (uint32_t i = 0; i < src->table_size; i++) {
-		struct cache_entry *entry = src->hash_table[i];
-		if (!entry || radv_pipeline_cache_search(dst, entry->sha1))
-			continue;
+	/* Entries always map to the same shard, whatever the cache. */
+	for (unsigned s = 0; s < RADV_PIPELINE_CACHE_SHARDS; s++) {
+		struct radv_pipeline_cache_shard *src_shard = &src->shards[s];
+		struct radv_pipeline_cache_shard *dst_shard = &dst->shards[s];
+
+		radv_pipeline_cache_lock(dst_shard);
+		for (uint32_t i = 0; i < src_shard->table_size; i++) {
+			struct cache_entry *entry = src_shard->hash_table[i];
+			if (!entry || radv_pipeline_cache_search_unlocked(dst_shard, entry->sha1))
+				continue;
+
+			/* Loaded entries go away with the data of src. */
+			if (radv_pipeline_cache_entry_is_loaded(src, entry)) {
+				struct cache_entry *copy =
+					vk_alloc(&dst->alloc, entry_size(entry), 8,
+						 VK_SYSTEM_ALLOCATION_SCOPE_CACHE);
+				if (!copy)
+					continue;
+
+				memcpy(copy, entry, entry_size(entry));
+				entry = copy;
+			}
 
-		radv_pipeline_cache_add_entry(dst, entry);
+			radv_pipeline_cache_add_entry(dst, dst_shard, entry);
 
-		src->hash_table[i] = NULL;
+			src_shard->hash_table[i] = NULL;
+		}
+		pthread_mutex_unlock(&dst_shard->mutex);
 	}
 }
 
@@ -48,6 +48,7 @@
 #include "compiler/shader_enums.h"
 #include "util/macros.h"
 #include "util/list.h"
+#include "util/u_queue.h"
 #include "main/macros.h"
 #include "vk_alloc.h"
 #include "vk_debug_report.h"
@@ -340,16 +341,38 @@ bool radv_physical_device_extension_supported(struct radv_physical_device *dev,
 
 struct cache_entry;
 
-struct radv_pipeline_cache {
-	struct radv_device *                          device;
+/* The pipeline cache is split in shards, picked by the hash of the entries,
+ * that each have their own lock so that pipelines can be created from many
+ * threads without all of them waiting for the same mutex.
+ */
+#define RADV_PIPELINE_CACHE_SHARDS 16
+
+struct radv_pipeline_cache_shard {
 	pthread_mutex_t                              mutex;
 
 	uint32_t                                     total_size;
 	uint32_t                                     table_size;
 	uint32_t                                     kernel_count;
 	struct cache_entry **                        hash_table;
+
+	/* Statistics, printed with RADV_DEBUG=cachestats. */
+	uint32_t                                     hits;
+	uint32_t                                     disk_hits;
+	uint32_t                                     misses;
+	uint32_t                                     contended;
+};
+
+struct radv_pipeline_cache {
+	struct radv_device *                          device;
+	struct radv_pipeline_cache_shard             shards[RADV_PIPELINE_CACHE_SHARDS];
 	bool                                         modified;
 
+	/* Copy of the data the cache was loaded from. The loaded entries point
+	 * into it instead of having an allocation each.
+	 */
+	void *                                       data;
+	size_t                                       data_size;
+
 	VkAllocationCallbacks                        alloc;
 };
 
@@ -382,7 +405,9 @@ bool
 radv_create_shader_variants_from_pipeline_cache(struct radv_device *device,
 					        struct radv_pipeline_cache *cache,
 					        const unsigned char *sha1,
-					        struct radv_shader_variant **variants);
+					        struct radv_shader_variant **variants,
+					        void **codes,
+					        unsigned *code_sizes);
 
 void
 radv_pipeline_cache_insert_shaders(struct radv_device *device,
@@ -429,6 +454,12 @@ struct radv_meta_state {
 
 	struct radv_pipeline_cache cache;
 
+	/* Protects the on-demand creation of the meta objects. */
+	mtx_t mtx;
+
+	/* Mask of the radv_meta_family objects that have been created. */
+	uint32_t families;
+
 	/**
 	 * Use array element `i` for images with `2^i` samples.
 	 */
@@ -567,6 +598,7 @@ struct radv_meta_state {
 		VkPipelineLayout p_layout;
 		VkPipeline occlusion_query_pipeline;
 		VkPipeline pipeline_statistics_query_pipeline;
+		VkPipeline timestamp_query_pipeline;
 	} query;
 };
 
@@ -612,6 +644,15 @@ struct radv_bo_list {
 	pthread_mutex_t mutex;
 };
 
+/* Shader code is sub-allocated from slabs in 256 byte units. Free blocks
+ * are kept in one list per power-of-two size class, from 256 bytes up to
+ * the slab size.
+ */
+#define RADV_SHADER_SLAB_SIZE (256 * 1024)
+#define RADV_SHADER_ALLOC_ALIGNMENT 256
+#define RADV_SHADER_ALLOC_MIN_SIZE_CLASS 8
+#define RADV_SHADER_ALLOC_NUM_FREE_LISTS 11
+
 struct radv_device {
 	VK_LOADER_DATA                              _loader_data;
 
@@ -669,6 +710,28 @@ struct radv_device {
 	struct list_head shader_slabs;
 	mtx_t shader_slab_mutex;
 
+	/* Free blocks of the shader slabs, by size class. */
+	struct list_head shader_free_lists[RADV_SHADER_ALLOC_NUM_FREE_LISTS];
+	uint32_t shader_free_list_mask;
+
+	/* When set, the shader slabs are in CPU-invisible VRAM and the code
+	 * is copied there with CP DMA from a staging buffer, on a context of
+	 * its own. Created on the first upload.
+	 */
+	bool shader_use_invisible_vram;
+	mtx_t shader_upload_mutex;
+	struct radeon_winsys_ctx *shader_upload_hw_ctx;
+	struct radeon_cmdbuf *shader_upload_cs;
+	struct radeon_winsys_bo *shader_upload_bo;
+	uint64_t shader_upload_bo_size;
+	char *shader_upload_ptr;
+
+	/* Worker threads for compiling the shaders of a pipeline and the
+	 * pipelines of a vkCreate*Pipelines call in parallel. Not initialized
+	 * with RADV_DEBUG=nocompilethreads.
+	 */
+	struct util_queue compile_queue;
+
 	/* For detecting VM faults reported by dmesg. */
 	uint64_t dmesg_timestamp;
 
@@ -701,6 +764,12 @@ struct radv_descriptor_set {
 	const struct radv_descriptor_set_layout *layout;
 	uint32_t size;
 
+	/* Size class of the host allocation and link in the pool's free
+	 * lists, only used by pools that allow freeing sets.
+	 */
+	uint32_t host_class;
+	struct radv_descriptor_set *next_free;
+
 	struct radeon_winsys_bo *bo;
 	uint64_t va;
 	uint32_t *mapped_ptr;
@@ -721,6 +790,12 @@ struct radv_descriptor_pool_entry {
 	struct radv_descriptor_set *set;
 };
 
+#define RADV_DESCRIPTOR_POOL_HOST_CLASSES 24
+
+struct radv_descriptor_pool_heap_block {
+	struct radv_descriptor_pool_heap_block *next;
+};
+
 struct radv_descriptor_pool {
 	struct radeon_winsys_bo *bo;
 	uint8_t *mapped_ptr;
@@ -731,6 +806,15 @@ struct radv_descriptor_pool {
 	uint8_t *host_memory_ptr;
 	uint8_t *host_memory_end;
 
+	/* Pools created with FREE_DESCRIPTOR_SET_BIT round host allocations
+	 * up to a power of two and recycle freed sets by size class. Heap
+	 * blocks are only used once the host memory block is exhausted and
+	 * are released on reset.
+	 */
+	bool allow_free;
+	struct radv_descriptor_set *host_free_sets[RADV_DESCRIPTOR_POOL_HOST_CLASSES];
+	struct radv_descriptor_pool_heap_block *host_heap_blocks;
+
 	uint32_t entry_count;
 	uint32_t max_entry_count;
 	struct radv_descriptor_pool_entry entries[0];
@@ -937,6 +1021,38 @@ struct radv_descriptor_state {
 	uint32_t dynamic_buffers[4 * MAX_DYNAMIC_BUFFERS];
 };
 
+/* The list of context registers whose emitted values are remembered by
+ * radv_cmd_state, so that the dynamic state emitters can skip redundant
+ * writes.
+ */
+enum radv_tracked_reg {
+	RADV_TRACKED_PA_SU_LINE_CNTL,
+
+	RADV_TRACKED_CB_BLEND_RED, /* 4 consecutive registers */
+	RADV_TRACKED_CB_BLEND_GREEN,
+	RADV_TRACKED_CB_BLEND_BLUE,
+	RADV_TRACKED_CB_BLEND_ALPHA,
+
+	RADV_TRACKED_DB_STENCILREFMASK, /* 2 consecutive registers */
+	RADV_TRACKED_DB_STENCILREFMASK_BF,
+
+	RADV_TRACKED_DB_DEPTH_BOUNDS_MIN, /* 2 consecutive registers */
+	RADV_TRACKED_DB_DEPTH_BOUNDS_MAX,
+
+	RADV_TRACKED_PA_SU_POLY_OFFSET_CLAMP, /* 5 consecutive registers */
+	RADV_TRACKED_PA_SU_POLY_OFFSET_FRONT_SCALE,
+	RADV_TRACKED_PA_SU_POLY_OFFSET_FRONT_OFFSET,
+	RADV_TRACKED_PA_SU_POLY_OFFSET_BACK_SCALE,
+	RADV_TRACKED_PA_SU_POLY_OFFSET_BACK_OFFSET,
+
+	RADV_NUM_TRACKED_REGS,
+};
+
+struct radv_tracked_regs {
+	uint32_t reg_saved;
+	uint32_t reg_value[RADV_NUM_TRACKED_REGS];
+};
+
 struct radv_cmd_state {
 	/* Vertex descriptors */
 	uint64_t                                      vb_va;
@@ -955,6 +1071,7 @@ struct radv_cmd_state {
 	struct radv_render_pass *                     pass;
 	const struct radv_subpass *                         subpass;
 	struct radv_dynamic_state                     dynamic;
+	struct radv_tracked_regs                      tracked_regs;
 	struct radv_attachment_state *                attachments;
 	VkRect2D                                     render_area;
 
@@ -1102,6 +1219,10 @@ void si_cp_dma_prefetch(struct radv_cmd_buffer *cmd_buffer, uint64_t va,
 void si_cp_dma_clear_buffer(struct radv_cmd_buffer *cmd_buffer, uint64_t va,
 			    uint64_t size, unsigned value);
 void si_cp_dma_wait_for_idle(struct radv_cmd_buffer *cmd_buffer);
+void si_cs_cp_dma_buffer_copy(struct radv_device *device,
+			      struct radeon_cmdbuf *cs,
+			      uint64_t dst_va, uint64_t src_va,
+			      uint64_t size);
 
 void radv_set_db_count_control(struct radv_cmd_buffer *cmd_buffer);
 bool
@@ -1214,6 +1335,7 @@ struct radv_shader_module;
 #define RADV_HASH_SHADER_IS_GEOM_COPY_SHADER (1 << 0)
 #define RADV_HASH_SHADER_SISCHED             (1 << 1)
 #define RADV_HASH_SHADER_UNSAFE_MATH         (1 << 2)
+#define RADV_HASH_SHADER_FAST_COMPILE        (1 << 3)
 void
 radv_hash_shaders(unsigned char *hash,
 		  const VkPipelineShaderStageCreateInfo **stages,
@@ -1221,6 +1343,17 @@ radv_hash_shaders(unsigned char *hash,
 		  const struct radv_pipeline_key *key,
 		  uint32_t flags);
 
+struct radv_shader_variant_key;
+
+void
+radv_hash_shader_stage(unsigned char *hash,
+		       struct nir_shader *const *shaders,
+		       int shader_count,
+		       const struct radv_pipeline_layout *layout,
+		       const struct radv_shader_variant_key *key,
+		       bool gs_copy_shader,
+		       uint32_t flags);
+
 static inline gl_shader_stage
 vk_to_mesa_shader_stage(VkShaderStageFlagBits vk_stage)
 {
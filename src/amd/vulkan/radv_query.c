@@ -28,14 +28,31 @@
 #include <string.h>
 #include <unistd.h>
 #include <fcntl.h>
+#include <sched.h>
 
 #include "nir/nir_builder.h"
+#include "util/bitset.h"
 #include "radv_meta.h"
 #include "radv_private.h"
 #include "radv_cs.h"
 #include "sid.h"
 
 
+/* Copies of fewer timestamps are done with COPY_DATA packets on the CP,
+ * larger ones with a compute shader.
+ */
+#define RADV_TIMESTAMP_COPY_SHADER_THRESHOLD 32
+
+/* Number of queries whose availability is gathered at once by
+ * radv_GetQueryPoolResults.
+ */
+#define RADV_QUERY_RESULT_BATCH 256
+
+/* How long radv_GetQueryPoolResults sleeps on the query pool before checking
+ * the availability again.
+ */
+#define RADV_QUERY_WAIT_TIMEOUT_NS 1000000
+
 static const int pipelinestat_block_size = 11 * 8;
 static const unsigned pipeline_statistics_indices[] = {7, 6, 3, 4, 5, 2, 1, 0, 8, 9, 10};
 
@@ -511,14 +528,167 @@ build_pipeline_statistics_query_shader(struct radv_device *device) {
 	return b.shader;
 }
 
+static nir_shader *
+build_timestamp_query_shader(struct radv_device *device) {
+	/* the shader this builds is roughly
+	 *
+	 * push constants {
+	 * 	uint32_t flags;
+	 * 	uint32_t dst_stride;
+	 * 	uint32_t unused;
+	 * 	uint32_t avail_offset;
+	 * };
+	 *
+	 * uint32_t src_stride = 8;
+	 *
+	 * location(binding = 0) buffer dst_buf;
+	 * location(binding = 1) buffer src_buf;
+	 *
+	 * void main() {
+	 * 	uint64_t src_offset = src_stride * global_id.x;
+	 * 	uint64_t dst_offset = dst_stride * global_id.x;
+	 * 	uint32_t elem_size = flags & VK_QUERY_RESULT_64_BIT ? 8 : 4;
+	 * 	uint32_t available = src_buf[avail_offset + 4 * global_id.x];
+	 * 	if (flags & VK_QUERY_RESULT_WITH_AVAILABILITY_BIT) {
+	 * 		dst_buf[dst_offset + elem_size] = available;
+	 * 	}
+	 * 	if (available || (flags & VK_QUERY_RESULT_PARTIAL_BIT)) {
+	 * 		uint64_t timestamp = src_buf[src_offset];
+	 * 		if (flags & VK_QUERY_RESULT_64_BIT)
+	 * 			dst_buf[dst_offset] = timestamp;
+	 * 		else
+	 * 			dst_buf[dst_offset] = (uint32_t)timestamp;
+	 * 	}
+	 * }
+	 */
+	nir_builder b;
+	nir_builder_init_simple_shader(&b, NULL, MESA_SHADER_COMPUTE, NULL);
+	b.shader->info.name = ralloc_strdup(b.shader, "timestamp_query");
+	b.shader->info.cs.local_size[0] = 64;
+	b.shader->info.cs.local_size[1] = 1;
+	b.shader->info.cs.local_size[2] = 1;
+
+	nir_ssa_def *flags = radv_load_push_int(&b, 0, "flags");
+	nir_ssa_def *avail_offset = radv_load_push_int(&b, 12, "avail_offset");
+
+	nir_intrinsic_instr *dst_buf = nir_intrinsic_instr_create(b.shader,
+	                                                          nir_intrinsic_vulkan_resource_index);
+	dst_buf->src[0] = nir_src_for_ssa(nir_imm_int(&b, 0));
+	nir_intrinsic_set_desc_set(dst_buf, 0);
+	nir_intrinsic_set_binding(dst_buf, 0);
+	nir_ssa_dest_init(&dst_buf->instr, &dst_buf->dest, 1, 32, NULL);
+	nir_builder_instr_insert(&b, &dst_buf->instr);
+
+	nir_intrinsic_instr *src_buf = nir_intrinsic_instr_create(b.shader,
+	                                                          nir_intrinsic_vulkan_resource_index);
+	src_buf->src[0] = nir_src_for_ssa(nir_imm_int(&b, 0));
+	nir_intrinsic_set_desc_set(src_buf, 0);
+	nir_intrinsic_set_binding(src_buf, 1);
+	nir_ssa_dest_init(&src_buf->instr, &src_buf->dest, 1, 32, NULL);
+	nir_builder_instr_insert(&b, &src_buf->instr);
+
+	nir_ssa_def *invoc_id = nir_load_system_value(&b, nir_intrinsic_load_local_invocation_id, 0);
+	nir_ssa_def *wg_id = nir_load_system_value(&b, nir_intrinsic_load_work_group_id, 0);
+	nir_ssa_def *block_size = nir_imm_ivec4(&b,
+	                                        b.shader->info.cs.local_size[0],
+	                                        b.shader->info.cs.local_size[1],
+	                                        b.shader->info.cs.local_size[2], 0);
+	nir_ssa_def *global_id = nir_iadd(&b, nir_imul(&b, wg_id, block_size), invoc_id);
+	global_id = nir_channel(&b, global_id, 0); // We only care about x here.
+
+	nir_ssa_def *input_base = nir_imul(&b, nir_imm_int(&b, 8), global_id);
+	nir_ssa_def *output_stride = radv_load_push_int(&b, 4, "output_stride");
+	nir_ssa_def *output_base = nir_imul(&b, output_stride, global_id);
+
+	avail_offset = nir_iadd(&b, avail_offset,
+	                            nir_imul(&b, global_id, nir_imm_int(&b, 4)));
+
+	nir_intrinsic_instr *load = nir_intrinsic_instr_create(b.shader, nir_intrinsic_load_ssbo);
+	load->src[0] = nir_src_for_ssa(&src_buf->dest.ssa);
+	load->src[1] = nir_src_for_ssa(avail_offset);
+	nir_ssa_dest_init(&load->instr, &load->dest, 1, 32, NULL);
+	load->num_components = 1;
+	nir_builder_instr_insert(&b, &load->instr);
+	nir_ssa_def *available = &load->dest.ssa;
+
+	nir_ssa_def *result_is_64bit = nir_iand(&b, flags,
+	                                        nir_imm_int(&b, VK_QUERY_RESULT_64_BIT));
+	nir_ssa_def *elem_size = nir_bcsel(&b, result_is_64bit, nir_imm_int(&b, 8), nir_imm_int(&b, 4));
+
+	/* Store the availability bit if requested. */
+
+	nir_if *availability_if = nir_if_create(b.shader);
+	availability_if->condition = nir_src_for_ssa(nir_iand(&b, flags, nir_imm_int(&b, VK_QUERY_RESULT_WITH_AVAILABILITY_BIT)));
+	nir_cf_node_insert(b.cursor, &availability_if->cf_node);
+
+	b.cursor = nir_after_cf_list(&availability_if->then_list);
+
+	nir_intrinsic_instr *store = nir_intrinsic_instr_create(b.shader, nir_intrinsic_store_ssbo);
+	store->src[0] = nir_src_for_ssa(available);
+	store->src[1] = nir_src_for_ssa(&dst_buf->dest.ssa);
+	store->src[2] = nir_src_for_ssa(nir_iadd(&b, output_base, elem_size));
+	nir_intrinsic_set_write_mask(store, 0x1);
+	store->num_components = 1;
+	nir_builder_instr_insert(&b, &store->instr);
+
+	b.cursor = nir_after_cf_node(&availability_if->cf_node);
+
+	/* Store the timestamp if it is available or partial results are ok. */
+
+	nir_if *available_if = nir_if_create(b.shader);
+	available_if->condition = nir_src_for_ssa(nir_ior(&b, nir_ine(&b, available, nir_imm_int(&b, 0)),
+	                                                      nir_ine(&b, nir_iand(&b, flags, nir_imm_int(&b, VK_QUERY_RESULT_PARTIAL_BIT)),
+	                                                                  nir_imm_int(&b, 0))));
+	nir_cf_node_insert(b.cursor, &available_if->cf_node);
+
+	b.cursor = nir_after_cf_list(&available_if->then_list);
+
+	load = nir_intrinsic_instr_create(b.shader, nir_intrinsic_load_ssbo);
+	load->src[0] = nir_src_for_ssa(&src_buf->dest.ssa);
+	load->src[1] = nir_src_for_ssa(input_base);
+	nir_ssa_dest_init(&load->instr, &load->dest, 1, 64, NULL);
+	load->num_components = 1;
+	nir_builder_instr_insert(&b, &load->instr);
+	nir_ssa_def *timestamp = &load->dest.ssa;
+
+	nir_if *store_64bit_if = nir_if_create(b.shader);
+	store_64bit_if->condition = nir_src_for_ssa(result_is_64bit);
+	nir_cf_node_insert(b.cursor, &store_64bit_if->cf_node);
+
+	b.cursor = nir_after_cf_list(&store_64bit_if->then_list);
+
+	store = nir_intrinsic_instr_create(b.shader, nir_intrinsic_store_ssbo);
+	store->src[0] = nir_src_for_ssa(timestamp);
+	store->src[1] = nir_src_for_ssa(&dst_buf->dest.ssa);
+	store->src[2] = nir_src_for_ssa(output_base);
+	nir_intrinsic_set_write_mask(store, 0x1);
+	store->num_components = 1;
+	nir_builder_instr_insert(&b, &store->instr);
+
+	b.cursor = nir_after_cf_list(&store_64bit_if->else_list);
+
+	store = nir_intrinsic_instr_create(b.shader, nir_intrinsic_store_ssbo);
+	store->src[0] = nir_src_for_ssa(nir_u2u32(&b, timestamp));
+	store->src[1] = nir_src_for_ssa(&dst_buf->dest.ssa);
+	store->src[2] = nir_src_for_ssa(output_base);
+	nir_intrinsic_set_write_mask(store, 0x1);
+	store->num_components = 1;
+	nir_builder_instr_insert(&b, &store->instr);
+
+	b.cursor = nir_after_cf_node(&available_if->cf_node);
+	return b.shader;
+}
+
 VkResult radv_device_init_meta_query_state(struct radv_device *device)
 {
 	VkResult result;
 	struct radv_shader_module occlusion_cs = { .nir = NULL };
 	struct radv_shader_module pipeline_statistics_cs = { .nir = NULL };
+	struct radv_shader_module timestamp_cs = { .nir = NULL };
 
 	occlusion_cs.nir = build_occlusion_query_shader(device);
 	pipeline_statistics_cs.nir = build_pipeline_statistics_query_shader(device);
+	timestamp_cs.nir = build_timestamp_query_shader(device);
 
 	VkDescriptorSetLayoutCreateInfo occlusion_ds_create_info = {
 		.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
@@ -605,17 +775,45 @@ VkResult radv_device_init_meta_query_state(struct radv_device *device)
 					     radv_pipeline_cache_to_handle(&device->meta_state.cache),
 					     1, &pipeline_statistics_vk_pipeline_info, NULL,
 					     &device->meta_state.query.pipeline_statistics_query_pipeline);
+	if (result != VK_SUCCESS)
+		goto fail;
+
+	VkPipelineShaderStageCreateInfo timestamp_pipeline_shader_stage = {
+		.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+		.stage = VK_SHADER_STAGE_COMPUTE_BIT,
+		.module = radv_shader_module_to_handle(&timestamp_cs),
+		.pName = "main",
+		.pSpecializationInfo = NULL,
+	};
+
+	VkComputePipelineCreateInfo timestamp_vk_pipeline_info = {
+		.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+		.stage = timestamp_pipeline_shader_stage,
+		.flags = 0,
+		.layout = device->meta_state.query.p_layout,
+	};
+
+	result = radv_CreateComputePipelines(radv_device_to_handle(device),
+					     radv_pipeline_cache_to_handle(&device->meta_state.cache),
+					     1, &timestamp_vk_pipeline_info, NULL,
+					     &device->meta_state.query.timestamp_query_pipeline);
 
 fail:
 	if (result != VK_SUCCESS)
 		radv_device_finish_meta_query_state(device);
 	ralloc_free(occlusion_cs.nir);
 	ralloc_free(pipeline_statistics_cs.nir);
+	ralloc_free(timestamp_cs.nir);
 	return result;
 }
 
 void radv_device_finish_meta_query_state(struct radv_device *device)
 {
+	if (device->meta_state.query.timestamp_query_pipeline)
+		radv_DestroyPipeline(radv_device_to_handle(device),
+				     device->meta_state.query.timestamp_query_pipeline,
+				     &device->meta_state.alloc);
+
 	if (device->meta_state.query.pipeline_statistics_query_pipeline)
 		radv_DestroyPipeline(radv_device_to_handle(device),
 				     device->meta_state.query.pipeline_statistics_query_pipeline,
@@ -812,6 +1010,65 @@ void radv_DestroyQueryPool(
 	vk_free2(&device->alloc, pAllocator, pool);
 }
 
+static bool radv_query_is_available(struct radv_device *device,
+				    struct radv_query_pool *pool,
+				    unsigned query)
+{
+	if (pool->type == VK_QUERY_TYPE_OCCLUSION) {
+		volatile uint64_t const *src64 =
+			(volatile uint64_t const *)(pool->ptr + query * pool->stride);
+		int db_count = get_max_db(device);
+
+		for (int i = 0; i < db_count; ++i) {
+			if (!(src64[2 * i] & (1ull << 63)) ||
+			    !(src64[2 * i + 1] & (1ull << 63)))
+				return false;
+		}
+		return true;
+	}
+
+	return *(volatile uint32_t*)(pool->ptr + pool->availability_offset + 4 * query);
+}
+
+/* Sets the bits of the queries that became available since the last call
+ * and returns how many are still pending.
+ */
+static unsigned radv_query_update_availability(struct radv_device *device,
+					       struct radv_query_pool *pool,
+					       unsigned first_query,
+					       unsigned count,
+					       BITSET_WORD *available)
+{
+	unsigned pending = 0;
+
+	for (unsigned i = 0; i < count; ++i) {
+		if (BITSET_TEST(available, i))
+			continue;
+
+		if (radv_query_is_available(device, pool, first_query + i))
+			BITSET_SET(available, i);
+		else
+			pending++;
+	}
+	return pending;
+}
+
+static void radv_query_wait_available(struct radv_device *device,
+				      struct radv_query_pool *pool,
+				      unsigned first_query,
+				      unsigned count,
+				      BITSET_WORD *available)
+{
+	while (radv_query_update_availability(device, pool, first_query,
+					      count, available)) {
+		/* Sleep on the submissions writing the pool. If it is idle the
+		 * queries haven't been submitted yet, so just yield.
+		 */
+		if (device->ws->buffer_wait_idle(pool->bo, RADV_QUERY_WAIT_TIMEOUT_NS))
+			sched_yield();
+	}
+}
+
 VkResult radv_GetQueryPoolResults(
 	VkDevice                                    _device,
 	VkQueryPool                                 queryPool,
@@ -824,6 +1081,7 @@ VkResult radv_GetQueryPoolResults(
 {
 	RADV_FROM_HANDLE(radv_device, device, _device);
 	RADV_FROM_HANDLE(radv_query_pool, pool, queryPool);
+	BITSET_DECLARE(available_set, RADV_QUERY_RESULT_BATCH);
 	char *data = pData;
 	VkResult result = VK_SUCCESS;
 
@@ -831,15 +1089,27 @@ VkResult radv_GetQueryPoolResults(
 		char *dest = data;
 		unsigned query = firstQuery + i;
 		char *src = pool->ptr + query * pool->stride;
+		unsigned batch_index = i % RADV_QUERY_RESULT_BATCH;
 		uint32_t available;
 
-		if (pool->type != VK_QUERY_TYPE_OCCLUSION) {
+		/* Gather the availability of the whole batch up front, so
+		 * that waiting blocks once per batch instead of spinning on
+		 * every query.
+		 */
+		if (batch_index == 0) {
+			unsigned batch_count = MIN2(queryCount - i, RADV_QUERY_RESULT_BATCH);
+
+			BITSET_ZERO(available_set);
 			if (flags & VK_QUERY_RESULT_WAIT_BIT)
-				while(!*(volatile uint32_t*)(pool->ptr + pool->availability_offset + 4 * query))
-					;
-			available = *(uint32_t*)(pool->ptr + pool->availability_offset + 4 * query);
+				radv_query_wait_available(device, pool, query,
+							  batch_count, available_set);
+			else
+				radv_query_update_availability(device, pool, query,
+							       batch_count, available_set);
 		}
 
+		available = BITSET_TEST(available_set, batch_index) ? 1 : 0;
+
 		switch (pool->type) {
 		case VK_QUERY_TYPE_TIMESTAMP: {
 			if (!available && !(flags & VK_QUERY_RESULT_PARTIAL_BIT)) {
@@ -861,20 +1131,13 @@ VkResult radv_GetQueryPoolResults(
 			volatile uint64_t const *src64 = (volatile uint64_t const *)src;
 			uint64_t sample_count = 0;
 			int db_count = get_max_db(device);
-			available = 1;
 
 			for (int i = 0; i < db_count; ++i) {
-				uint64_t start, end;
-				do {
-					start = src64[2 * i];
-					end = src64[2 * i + 1];
-				} while ((!(start & (1ull << 63)) || !(end & (1ull << 63))) && (flags & VK_QUERY_RESULT_WAIT_BIT));
-
-				if (!(start & (1ull << 63)) || !(end & (1ull << 63)))
-					available = 0;
-				else {
+				uint64_t start = src64[2 * i];
+				uint64_t end = src64[2 * i + 1];
+
+				if ((start & (1ull << 63)) && (end & (1ull << 63)))
 					sample_count += end - start;
-				}
 			}
 
 			if (!available && !(flags & VK_QUERY_RESULT_PARTIAL_BIT)) {
@@ -974,6 +1237,8 @@ void radv_CmdCopyQueryPoolResults(
 				radeon_emit(cs, 4); /* poll interval */
 			}
 		}
+		if (!radv_meta_init_family(cmd_buffer, RADV_META_FAMILY_QUERY))
+			return;
 		radv_query_shader(cmd_buffer, cmd_buffer->device->meta_state.query.occlusion_query_pipeline,
 		                  pool->bo, dst_buffer->bo, firstQuery * pool->stride,
 		                  dst_buffer->offset + dstOffset,
@@ -993,6 +1258,8 @@ void radv_CmdCopyQueryPoolResults(
 				si_emit_wait_fence(cs, avail_va, 1, 0xffffffff);
 			}
 		}
+		if (!radv_meta_init_family(cmd_buffer, RADV_META_FAMILY_QUERY))
+			return;
 		radv_query_shader(cmd_buffer, cmd_buffer->device->meta_state.query.pipeline_statistics_query_pipeline,
 		                  pool->bo, dst_buffer->bo, firstQuery * pool->stride,
 		                  dst_buffer->offset + dstOffset,
@@ -1001,6 +1268,28 @@ void radv_CmdCopyQueryPoolResults(
 		                  pool->availability_offset + 4 * firstQuery);
 		break;
 	case VK_QUERY_TYPE_TIMESTAMP:
+		if (queryCount >= RADV_TIMESTAMP_COPY_SHADER_THRESHOLD) {
+			if (flags & VK_QUERY_RESULT_WAIT_BIT) {
+				for(unsigned i = 0; i < queryCount; ++i) {
+					unsigned query = firstQuery + i;
+					uint64_t avail_va = va + pool->availability_offset + 4 * query;
+
+					radeon_check_space(cmd_buffer->device->ws, cs, 7);
+
+					/* This waits on the ME. */
+					si_emit_wait_fence(cs, avail_va, 1, 0xffffffff);
+				}
+			}
+			if (!radv_meta_init_family(cmd_buffer, RADV_META_FAMILY_QUERY))
+				return;
+			radv_query_shader(cmd_buffer, cmd_buffer->device->meta_state.query.timestamp_query_pipeline,
+			                  pool->bo, dst_buffer->bo, firstQuery * pool->stride,
+			                  dst_buffer->offset + dstOffset,
+			                  pool->stride, stride, queryCount, flags, 0,
+			                  pool->availability_offset + 4 * firstQuery);
+			break;
+		}
+
 		for(unsigned i = 0; i < queryCount; ++i, dest_va += stride) {
 			unsigned query = firstQuery + i;
 			uint64_t local_src_va = va  + query * pool->stride;
@@ -221,6 +221,10 @@ struct radeon_winsys {
 
 	void (*buffer_unmap)(struct radeon_winsys_bo *bo);
 
+	/* Waits up to timeout ns for all submissions using the buffer to
+	 * finish. Returns false if it is still busy. */
+	bool (*buffer_wait_idle)(struct radeon_winsys_bo *bo, uint64_t timeout);
+
 	void (*buffer_set_metadata)(struct radeon_winsys_bo *bo,
 				    struct radeon_bo_metadata *md);
 
@@ -259,6 +263,11 @@ struct radeon_winsys {
 	void (*cs_add_buffer)(struct radeon_cmdbuf *cs,
 			      struct radeon_winsys_bo *bo);
 
+	/* Executes the commands of a finalized child CS from the parent. When
+	 * the winsys uses IB BOs the child is referenced in place with an
+	 * INDIRECT_BUFFER packet, so it must stay alive and unmodified until
+	 * the parent has completed; otherwise its contents are copied.
+	 */
 	void (*cs_execute_secondary)(struct radeon_cmdbuf *parent,
 				    struct radeon_cmdbuf *child);
 
@@ -46,6 +46,7 @@
 #include "ac_nir_to_llvm.h"
 #include "vk_format.h"
 #include "util/debug.h"
+#include "util/u_math.h"
 #include "ac_exp_param.h"
 
 #include "util/string_buffer.h"
@@ -118,6 +119,16 @@ void radv_DestroyShaderModule(
 	vk_free2(&device->alloc, pAllocator, module);
 }
 
+static bool
+radv_should_vectorize_mem(nir_intrinsic_op op, unsigned align,
+			  unsigned bit_size, unsigned num_components,
+			  void *data)
+{
+	/* Buffer and LDS loads/stores of up to 128 bits are single
+	 * instructions when they are dword aligned. */
+	return bit_size == 32 && align >= 4 && num_components <= 4;
+}
+
 void
 radv_optimize_nir(struct nir_shader *shader, bool optimize_conservatively)
 {
@@ -153,6 +164,8 @@ radv_optimize_nir(struct nir_shader *shader, bool optimize_conservatively)
                 }
         } while (progress && !optimize_conservatively);
 
+        NIR_PASS(progress, shader, nir_opt_load_store_vectorize,
+                 radv_should_vectorize_mem, NULL);
         NIR_PASS(progress, shader, nir_opt_shrink_load);
         NIR_PASS(progress, shader, nir_opt_move_load_ubo);
 }
@@ -329,62 +342,347 @@ radv_shader_compile_to_nir(struct radv_device *device,
 	return nir;
 }
 
-void *
-radv_alloc_shader_memory(struct radv_device *device,
-			 struct radv_shader_variant *shader)
+void
+radv_init_shader_slabs(struct radv_device *device)
+{
+	const struct radeon_info *info = &device->physical_device->rad_info;
+
+	mtx_init(&device->shader_slab_mutex, mtx_plain);
+	mtx_init(&device->shader_upload_mutex, mtx_plain);
+	list_inithead(&device->shader_slabs);
+	for (unsigned i = 0; i < RADV_SHADER_ALLOC_NUM_FREE_LISTS; i++)
+		list_inithead(&device->shader_free_lists[i]);
+	device->shader_free_list_mask = 0;
+
+	/* Keep the CPU-visible VRAM window, which is usually small on dGPUs,
+	 * for the things which really need it.
+	 */
+	device->shader_use_invisible_vram = info->vram_vis_size < info->vram_size;
+}
+
+static unsigned
+get_size_class(unsigned size, bool round_up)
 {
+	size = round_up ? util_logbase2_ceil(size) : util_logbase2(size);
+	unsigned size_class = MAX2(size, RADV_SHADER_ALLOC_MIN_SIZE_CLASS) -
+			      RADV_SHADER_ALLOC_MIN_SIZE_CLASS;
+	return MIN2(size_class, RADV_SHADER_ALLOC_NUM_FREE_LISTS - 1);
+}
+
+static void
+add_hole(struct radv_device *device, struct radv_shader_slab_block *hole)
+{
+	unsigned size_class = get_size_class(hole->size, false);
+
+	list_addtail(&hole->freelist, &device->shader_free_lists[size_class]);
+	device->shader_free_list_mask |= 1u << size_class;
+	hole->free = true;
+}
+
+static void
+remove_hole(struct radv_device *device, struct radv_shader_slab_block *hole)
+{
+	unsigned size_class = get_size_class(hole->size, false);
+
+	list_del(&hole->freelist);
+	if (list_empty(&device->shader_free_lists[size_class]))
+		device->shader_free_list_mask &= ~(1u << size_class);
+	hole->free = false;
+}
+
+static struct radv_shader_slab *
+radv_create_shader_slab(struct radv_device *device, unsigned min_size)
+{
+	struct radeon_winsys *ws = device->ws;
+	enum radeon_bo_flag flags = RADEON_FLAG_NO_INTERPROCESS_SHARING;
+	struct radv_shader_slab *slab = calloc(1, sizeof(struct radv_shader_slab));
+	struct radv_shader_slab_block *block =
+		calloc(1, sizeof(struct radv_shader_slab_block));
+
+	if (!slab || !block)
+		goto fail;
+
+	/* The invisible slabs are written by CP DMA so they can't be
+	 * read-only.
+	 */
+	if (device->shader_use_invisible_vram)
+		flags |= RADEON_FLAG_NO_CPU_ACCESS;
+	else if (!device->physical_device->cpdma_prefetch_writes_memory)
+		flags |= RADEON_FLAG_READ_ONLY;
+
+	slab->size = MAX2(RADV_SHADER_SLAB_SIZE, util_next_power_of_two(min_size));
+	slab->bo = ws->buffer_create(ws, slab->size, 256, RADEON_DOMAIN_VRAM,
+				     flags);
+	if (!slab->bo)
+		goto fail;
+
+	if (!device->shader_use_invisible_vram) {
+		slab->ptr = (char*)ws->buffer_map(slab->bo);
+		if (!slab->ptr) {
+			ws->buffer_destroy(slab->bo);
+			goto fail;
+		}
+	}
+
+	list_inithead(&slab->blocks);
+	block->slab = slab;
+	block->offset = 0;
+	block->size = slab->size;
+	list_addtail(&block->list, &slab->blocks);
+	add_hole(device, block);
+
+	list_add(&slab->slabs, &device->shader_slabs);
+	return slab;
+
+fail:
+	free(block);
+	free(slab);
+	return NULL;
+}
+
+static struct radv_shader_slab_block *
+radv_alloc_shader_block(struct radv_device *device, unsigned size)
+{
+	struct radv_shader_slab_block *hole = NULL;
+
+	size = align(size, RADV_SHADER_ALLOC_ALIGNMENT);
+
 	mtx_lock(&device->shader_slab_mutex);
-	list_for_each_entry(struct radv_shader_slab, slab, &device->shader_slabs, slabs) {
-		uint64_t offset = 0;
-		list_for_each_entry(struct radv_shader_variant, s, &slab->shaders, slab_list) {
-			if (s->bo_offset - offset >= shader->code_size) {
-				shader->bo = slab->bo;
-				shader->bo_offset = offset;
-				list_addtail(&shader->slab_list, &s->slab_list);
-				mtx_unlock(&device->shader_slab_mutex);
-				return slab->ptr + offset;
+
+	/* Every hole of the rounded up size class or above is big enough,
+	 * except in the last class which has no upper bound.
+	 */
+	uint32_t mask = device->shader_free_list_mask &
+			(~0u << get_size_class(size, true));
+	while (mask && !hole) {
+		unsigned i = u_bit_scan(&mask);
+
+		list_for_each_entry(struct radv_shader_slab_block, block,
+				    &device->shader_free_lists[i], freelist) {
+			if (block->size >= size) {
+				hole = block;
+				break;
 			}
-			offset = align_u64(s->bo_offset + s->code_size, 256);
 		}
-		if (slab->size - offset >= shader->code_size) {
-			shader->bo = slab->bo;
-			shader->bo_offset = offset;
-			list_addtail(&shader->slab_list, &slab->shaders);
+	}
+
+	if (!hole) {
+		struct radv_shader_slab *slab = radv_create_shader_slab(device, size);
+		if (!slab) {
 			mtx_unlock(&device->shader_slab_mutex);
-			return slab->ptr + offset;
+			return NULL;
+		}
+
+		hole = list_first_entry(&slab->blocks,
+					struct radv_shader_slab_block, list);
+	}
+
+	remove_hole(device, hole);
+
+	if (hole->size > size) {
+		/* If this fails, the whole hole is handed out. */
+		struct radv_shader_slab_block *rest =
+			calloc(1, sizeof(struct radv_shader_slab_block));
+		if (rest) {
+			rest->slab = hole->slab;
+			rest->offset = hole->offset + size;
+			rest->size = hole->size - size;
+			list_add(&rest->list, &hole->list);
+			add_hole(device, rest);
+
+			hole->size = size;
 		}
 	}
 
 	mtx_unlock(&device->shader_slab_mutex);
-	struct radv_shader_slab *slab = calloc(1, sizeof(struct radv_shader_slab));
+	return hole;
+}
 
-	slab->size = 256 * 1024;
-	slab->bo = device->ws->buffer_create(device->ws, slab->size, 256,
-	                                     RADEON_DOMAIN_VRAM,
-					     RADEON_FLAG_NO_INTERPROCESS_SHARING |
-					     (device->physical_device->cpdma_prefetch_writes_memory ?
-					             0 : RADEON_FLAG_READ_ONLY));
-	slab->ptr = (char*)device->ws->buffer_map(slab->bo);
-	list_inithead(&slab->shaders);
+static void
+radv_free_shader_block(struct radv_device *device,
+		       struct radv_shader_slab_block *block)
+{
+	struct list_head *head = &block->slab->blocks;
 
 	mtx_lock(&device->shader_slab_mutex);
-	list_add(&slab->slabs, &device->shader_slabs);
 
-	shader->bo = slab->bo;
-	shader->bo_offset = 0;
-	list_add(&shader->slab_list, &slab->shaders);
+	/* Merge with the free neighbours. */
+	if (block->list.prev != head) {
+		struct radv_shader_slab_block *prev =
+			LIST_ENTRY(struct radv_shader_slab_block, block->list.prev, list);
+
+		if (prev->free) {
+			remove_hole(device, prev);
+			prev->size += block->size;
+			list_del(&block->list);
+			free(block);
+			block = prev;
+		}
+	}
+
+	if (block->list.next != head) {
+		struct radv_shader_slab_block *next =
+			LIST_ENTRY(struct radv_shader_slab_block, block->list.next, list);
+
+		if (next->free) {
+			remove_hole(device, next);
+			block->size += next->size;
+			list_del(&next->list);
+			free(next);
+		}
+	}
+
+	add_hole(device, block);
+
 	mtx_unlock(&device->shader_slab_mutex);
-	return slab->ptr;
+}
+
+static void
+radv_write_shader_code(char *dst, const struct radv_shader_variant *shader,
+		       const void *code, unsigned code_size)
+{
+	memcpy(dst, code, code_size);
+
+	/* Add end-of-code markers for the UMR disassembler. */
+	uint32_t *ptr32 = (uint32_t *)(dst + code_size);
+	for (unsigned i = code_size; i + 4 <= shader->code_size; i += 4)
+		*ptr32++ = DEBUGGER_END_OF_CODE_MARKER;
+}
+
+static bool
+radv_upload_shader_code_staged(struct radv_device *device,
+			       struct radv_shader_variant *shader,
+			       const void *code, unsigned code_size)
+{
+	const struct radeon_info *info = &device->physical_device->rad_info;
+	struct radeon_winsys *ws = device->ws;
+	bool ret = false;
+
+	/* Use a compute ring when possible, so that the uploads don't wait
+	 * behind the rendering of the application.
+	 */
+	enum ring_type ring = info->num_compute_rings > 0 &&
+			      info->chip_class >= CIK ? RING_COMPUTE : RING_GFX;
+
+	mtx_lock(&device->shader_upload_mutex);
+
+	if (!device->shader_upload_hw_ctx) {
+		device->shader_upload_hw_ctx =
+			ws->ctx_create(ws, RADEON_CTX_PRIORITY_MEDIUM);
+		if (!device->shader_upload_hw_ctx)
+			goto out;
+	}
+
+	if (!device->shader_upload_cs) {
+		device->shader_upload_cs = ws->cs_create(ws, ring);
+		if (!device->shader_upload_cs)
+			goto out;
+	}
+
+	if (device->shader_upload_bo_size < shader->code_size) {
+		uint64_t size = MAX2(64 * 1024,
+				     util_next_power_of_two(shader->code_size));
+
+		if (device->shader_upload_bo) {
+			ws->buffer_destroy(device->shader_upload_bo);
+			device->shader_upload_bo = NULL;
+			device->shader_upload_bo_size = 0;
+		}
+
+		device->shader_upload_bo =
+			ws->buffer_create(ws, size, 256, RADEON_DOMAIN_GTT,
+					  RADEON_FLAG_CPU_ACCESS |
+					  RADEON_FLAG_GTT_WC |
+					  RADEON_FLAG_NO_INTERPROCESS_SHARING |
+					  RADEON_FLAG_READ_ONLY);
+		if (!device->shader_upload_bo)
+			goto out;
+
+		device->shader_upload_ptr = ws->buffer_map(device->shader_upload_bo);
+		if (!device->shader_upload_ptr) {
+			ws->buffer_destroy(device->shader_upload_bo);
+			device->shader_upload_bo = NULL;
+			goto out;
+		}
+		device->shader_upload_bo_size = size;
+	}
+
+	radv_write_shader_code(device->shader_upload_ptr, shader,
+			       code, code_size);
+
+	struct radeon_cmdbuf *cs = device->shader_upload_cs;
+	ws->cs_reset(cs);
+	radv_cs_add_buffer(ws, cs, device->shader_upload_bo);
+	radv_cs_add_buffer(ws, cs, shader->bo);
+	si_cs_cp_dma_buffer_copy(device, cs,
+				 radv_buffer_get_va(shader->bo) + shader->bo_offset,
+				 radv_buffer_get_va(device->shader_upload_bo),
+				 shader->code_size);
+	if (!ws->cs_finalize(cs))
+		goto out;
+
+	struct radv_winsys_sem_info sem_info = {0};
+	if (ws->cs_submit(device->shader_upload_hw_ctx, 0, &cs, 1, NULL, NULL,
+			  &sem_info, NULL, false, NULL))
+		goto out;
+
+	/* The staging buffer is reused by the next upload. */
+	ret = ws->ctx_wait_idle(device->shader_upload_hw_ctx, ring, 0);
+
+out:
+	mtx_unlock(&device->shader_upload_mutex);
+	return ret;
+}
+
+/**
+ * Allocate memory for the shader and upload code_size bytes of code to it.
+ * The rest of shader->code_size is filled with end-of-code markers.
+ */
+bool
+radv_upload_shader_code(struct radv_device *device,
+			struct radv_shader_variant *shader,
+			const void *code, unsigned code_size)
+{
+	struct radv_shader_slab_block *block =
+		radv_alloc_shader_block(device, shader->code_size);
+
+	if (!block)
+		return false;
+
+	shader->alloc = block;
+	shader->bo = block->slab->bo;
+	shader->bo_offset = block->offset;
+
+	if (block->slab->ptr) {
+		radv_write_shader_code(block->slab->ptr + block->offset, shader,
+				       code, code_size);
+		return true;
+	}
+
+	return radv_upload_shader_code_staged(device, shader, code, code_size);
 }
 
 void
 radv_destroy_shader_slabs(struct radv_device *device)
 {
+	struct radeon_winsys *ws = device->ws;
+
 	list_for_each_entry_safe(struct radv_shader_slab, slab, &device->shader_slabs, slabs) {
-		device->ws->buffer_destroy(slab->bo);
+		list_for_each_entry_safe(struct radv_shader_slab_block, block,
+					 &slab->blocks, list)
+			free(block);
+		ws->buffer_destroy(slab->bo);
 		free(slab);
 	}
 	mtx_destroy(&device->shader_slab_mutex);
+
+	if (device->shader_upload_bo)
+		ws->buffer_destroy(device->shader_upload_bo);
+	if (device->shader_upload_cs)
+		ws->cs_destroy(device->shader_upload_cs);
+	if (device->shader_upload_hw_ctx)
+		ws->ctx_destroy(device->shader_upload_hw_ctx);
+	mtx_destroy(&device->shader_upload_mutex);
 }
 
 /* For the UMR disassembler. */
@@ -397,7 +695,7 @@ radv_get_shader_binary_size(struct ac_shader_binary *binary)
 	return binary->code_size + DEBUGGER_NUM_MARKERS * 4;
 }
 
-static void
+static bool
 radv_fill_shader_variant(struct radv_device *device,
 			 struct radv_shader_variant *variant,
 			 struct ac_shader_binary *binary,
@@ -486,14 +784,8 @@ radv_fill_shader_variant(struct radv_device *device,
 		variant->rsrc1 |= S_00B128_VGPR_COMP_CNT(vgpr_comp_cnt);
 	}
 
-	void *ptr = radv_alloc_shader_memory(device, variant);
-	memcpy(ptr, binary->code, binary->code_size);
-
-	/* Add end-of-code markers for the UMR disassembler. */
-       uint32_t *ptr32 = (uint32_t *)ptr + binary->code_size / 4;
-       for (unsigned i = 0; i < DEBUGGER_NUM_MARKERS; i++)
-		ptr32[i] = DEBUGGER_END_OF_CODE_MARKER;
-
+	return radv_upload_shader_code(device, variant, binary->code,
+				       binary->code_size);
 }
 
 static void radv_init_llvm_target()
@@ -566,6 +858,10 @@ shader_variant_create(struct radv_device *device,
 		tm_options |= AC_TM_SISCHED;
 	if (options->check_ir)
 		tm_options |= AC_TM_CHECK_IR;
+	/* Trade code quality for compile time where it matters most. */
+	if ((device->instance->perftest_flags & RADV_PERFTEST_FAST_COMPILE) &&
+	    (stage == MESA_SHADER_COMPUTE || stage == MESA_SHADER_FRAGMENT))
+		tm_options |= AC_TM_FAST_COMPILE;
 
 	thread_compiler = !(device->instance->debug_flags & RADV_DEBUG_NOTHREADLLVM);
 	radv_init_llvm_once();
@@ -585,9 +881,9 @@ shader_variant_create(struct radv_device *device,
 
 	radv_destroy_llvm_compiler(&ac_llvm, thread_compiler);
 
-	radv_fill_shader_variant(device, variant, &binary, stage);
+	bool uploaded = radv_fill_shader_variant(device, variant, &binary, stage);
 
-	if (code_out) {
+	if (code_out && uploaded) {
 		*code_out = binary.code;
 		*code_size_out = binary.code_size;
 	} else
@@ -596,6 +892,13 @@ shader_variant_create(struct radv_device *device,
 	free(binary.rodata);
 	free(binary.global_symbol_offsets);
 	free(binary.relocs);
+
+	if (!uploaded) {
+		if (variant->alloc)
+			radv_free_shader_block(device, variant->alloc);
+		free(variant);
+		return NULL;
+	}
 	variant->ref_count = 1;
 
 	if (device->keep_shader_info) {
@@ -658,9 +961,8 @@ radv_shader_variant_destroy(struct radv_device *device,
 	if (!p_atomic_dec_zero(&variant->ref_count))
 		return;
 
-	mtx_lock(&device->shader_slab_mutex);
-	list_del(&variant->slab_list);
-	mtx_unlock(&device->shader_slab_mutex);
+	if (variant->alloc)
+		radv_free_shader_block(device, variant->alloc);
 
 	ralloc_free(variant->nir);
 	free(variant->disasm_string);
@@ -286,15 +286,26 @@ struct radv_shader_variant {
 	char *disasm_string;
 	char *llvm_ir_string;
 
-	struct list_head slab_list;
+	struct radv_shader_slab_block *alloc;
 };
 
 struct radv_shader_slab {
 	struct list_head slabs;
-	struct list_head shaders;
+	/* All the blocks of the slab, by increasing offset. */
+	struct list_head blocks;
 	struct radeon_winsys_bo *bo;
 	uint64_t size;
-	char *ptr;
+	char *ptr; /* NULL for CPU-invisible slabs */
+};
+
+struct radv_shader_slab_block {
+	struct list_head list;
+	/* Link in the device free list of its size class, if free. */
+	struct list_head freelist;
+	struct radv_shader_slab *slab;
+	uint32_t offset;
+	uint32_t size;
+	bool free;
 };
 
 void
@@ -308,9 +319,13 @@ radv_shader_compile_to_nir(struct radv_device *device,
 			   const VkSpecializationInfo *spec_info,
 			   const VkPipelineCreateFlags flags);
 
-void *
-radv_alloc_shader_memory(struct radv_device *device,
-			  struct radv_shader_variant *shader);
+bool
+radv_upload_shader_code(struct radv_device *device,
+			struct radv_shader_variant *shader,
+			const void *code, unsigned code_size);
+
+void
+radv_init_shader_slabs(struct radv_device *device);
 
 void
 radv_destroy_shader_slabs(struct radv_device *device);
@@ -285,3 +285,23 @@ VkResult radv_GetDeviceGroupSurfacePresentModesKHR(
 
    return VK_SUCCESS;
 }
+
+VkResult radv_GetRefreshCycleDurationGOOGLE(
+    VkDevice                                    device,
+    VkSwapchainKHR                              swapchain,
+    VkRefreshCycleDurationGOOGLE*               pDisplayTimingProperties)
+{
+   return wsi_common_get_refresh_cycle_duration(swapchain,
+                                                pDisplayTimingProperties);
+}
+
+VkResult radv_GetPastPresentationTimingGOOGLE(
+    VkDevice                                    device,
+    VkSwapchainKHR                              swapchain,
+    uint32_t*                                   pPresentationTimingCount,
+    VkPastPresentationTimingGOOGLE*             pPresentationTimings)
+{
+   return wsi_common_get_past_presentation_timing(swapchain,
+                                                  pPresentationTimingCount,
+                                                  pPresentationTimings);
+}
@@ -1049,9 +1049,9 @@ si_emit_set_predication_state(struct radv_cmd_buffer *cmd_buffer,
 #define SI_CPDMA_ALIGNMENT	32
 
 /* The max number of bytes that can be copied per packet. */
-static inline unsigned cp_dma_max_byte_count(struct radv_cmd_buffer *cmd_buffer)
+static inline unsigned si_cp_dma_max_byte_count(enum chip_class chip_class)
 {
-	unsigned max = cmd_buffer->device->physical_device->rad_info.chip_class >= GFX9 ?
+	unsigned max = chip_class >= GFX9 ?
 			       S_414_BYTE_COUNT_GFX9(~0u) :
 			       S_414_BYTE_COUNT_GFX6(~0u);
 
@@ -1059,21 +1059,27 @@ static inline unsigned cp_dma_max_byte_count(struct radv_cmd_buffer *cmd_buffer)
 	return max & ~(SI_CPDMA_ALIGNMENT - 1);
 }
 
+static inline unsigned cp_dma_max_byte_count(struct radv_cmd_buffer *cmd_buffer)
+{
+	return si_cp_dma_max_byte_count(cmd_buffer->device->physical_device->rad_info.chip_class);
+}
+
 /* Emit a CP DMA packet to do a copy from one buffer to another, or to clear
  * a buffer. The size must fit in bits [20:0]. If CP_DMA_CLEAR is set, src_va is a 32-bit
  * clear value.
  */
-static void si_emit_cp_dma(struct radv_cmd_buffer *cmd_buffer,
-			   uint64_t dst_va, uint64_t src_va,
-			   unsigned size, unsigned flags)
+static void si_cs_emit_cp_dma(struct radv_device *device,
+			      struct radeon_cmdbuf *cs, bool predicating,
+			      uint64_t dst_va, uint64_t src_va,
+			      unsigned size, unsigned flags)
 {
-	struct radeon_cmdbuf *cs = cmd_buffer->cs;
+	enum chip_class chip_class = device->physical_device->rad_info.chip_class;
 	uint32_t header = 0, command = 0;
 
-	assert(size <= cp_dma_max_byte_count(cmd_buffer));
+	assert(size <= si_cp_dma_max_byte_count(chip_class));
 
-	radeon_check_space(cmd_buffer->device->ws, cmd_buffer->cs, 9);
-	if (cmd_buffer->device->physical_device->rad_info.chip_class >= GFX9)
+	radeon_check_space(device->ws, cs, 9);
+	if (chip_class >= GFX9)
 		command |= S_414_BYTE_COUNT_GFX9(size);
 	else
 		command |= S_414_BYTE_COUNT_GFX6(size);
@@ -1082,7 +1088,7 @@ static void si_emit_cp_dma(struct radv_cmd_buffer *cmd_buffer,
 	if (flags & CP_DMA_SYNC)
 		header |= S_411_CP_SYNC(1);
 	else {
-		if (cmd_buffer->device->physical_device->rad_info.chip_class >= GFX9)
+		if (chip_class >= GFX9)
 			command |= S_414_DISABLE_WR_CONFIRM_GFX9(1);
 		else
 			command |= S_414_DISABLE_WR_CONFIRM_GFX6(1);
@@ -1092,7 +1098,7 @@ static void si_emit_cp_dma(struct radv_cmd_buffer *cmd_buffer,
 		command |= S_414_RAW_WAIT(1);
 
 	/* Src and dst flags. */
-	if (cmd_buffer->device->physical_device->rad_info.chip_class >= GFX9 &&
+	if (chip_class >= GFX9 &&
 	    !(flags & CP_DMA_CLEAR) &&
 	    src_va == dst_va)
 		header |= S_411_DST_SEL(V_411_NOWHERE); /* prefetch only */
@@ -1104,8 +1110,8 @@ static void si_emit_cp_dma(struct radv_cmd_buffer *cmd_buffer,
 	else if (flags & CP_DMA_USE_L2)
 		header |= S_411_SRC_SEL(V_411_SRC_ADDR_TC_L2);
 
-	if (cmd_buffer->device->physical_device->rad_info.chip_class >= CIK) {
-		radeon_emit(cs, PKT3(PKT3_DMA_DATA, 5, cmd_buffer->state.predicating));
+	if (chip_class >= CIK) {
+		radeon_emit(cs, PKT3(PKT3_DMA_DATA, 5, predicating));
 		radeon_emit(cs, header);
 		radeon_emit(cs, src_va);		/* SRC_ADDR_LO [31:0] */
 		radeon_emit(cs, src_va >> 32);		/* SRC_ADDR_HI [31:0] */
@@ -1115,13 +1121,45 @@ static void si_emit_cp_dma(struct radv_cmd_buffer *cmd_buffer,
 	} else {
 		assert(!(flags & CP_DMA_USE_L2));
 		header |= S_411_SRC_ADDR_HI(src_va >> 32);
-		radeon_emit(cs, PKT3(PKT3_CP_DMA, 4, cmd_buffer->state.predicating));
+		radeon_emit(cs, PKT3(PKT3_CP_DMA, 4, predicating));
 		radeon_emit(cs, src_va);			/* SRC_ADDR_LO [31:0] */
 		radeon_emit(cs, header);			/* SRC_ADDR_HI [15:0] + flags. */
 		radeon_emit(cs, dst_va);			/* DST_ADDR_LO [31:0] */
 		radeon_emit(cs, (dst_va >> 32) & 0xffff);	/* DST_ADDR_HI [15:0] */
 		radeon_emit(cs, command);
 	}
+}
+
+/* Copy between two buffers from a bare CS, outside of any command buffer.
+ * The last packet waits for all of the DMAs to complete.
+ */
+void si_cs_cp_dma_buffer_copy(struct radv_device *device,
+			      struct radeon_cmdbuf *cs,
+			      uint64_t dst_va, uint64_t src_va,
+			      uint64_t size)
+{
+	unsigned max = si_cp_dma_max_byte_count(device->physical_device->rad_info.chip_class);
+
+	while (size) {
+		unsigned byte_count = MIN2(size, max);
+
+		size -= byte_count;
+		si_cs_emit_cp_dma(device, cs, false, dst_va, src_va, byte_count,
+				  size ? 0 : CP_DMA_SYNC);
+
+		dst_va += byte_count;
+		src_va += byte_count;
+	}
+}
+
+static void si_emit_cp_dma(struct radv_cmd_buffer *cmd_buffer,
+			   uint64_t dst_va, uint64_t src_va,
+			   unsigned size, unsigned flags)
+{
+	struct radeon_cmdbuf *cs = cmd_buffer->cs;
+
+	si_cs_emit_cp_dma(cmd_buffer->device, cs, cmd_buffer->state.predicating,
+			  dst_va, src_va, size, flags);
 
 	/* CP DMA is executed in ME, but index buffers are read by PFP.
 	 * This ensures that ME (CP DMA) is idle before PFP starts fetching
@@ -406,6 +406,20 @@ radv_amdgpu_winsys_bo_unmap(struct radeon_winsys_bo *_bo)
 	amdgpu_bo_cpu_unmap(bo->bo);
 }
 
+static bool
+radv_amdgpu_winsys_bo_wait_idle(struct radeon_winsys_bo *_bo, uint64_t timeout)
+{
+	struct radv_amdgpu_winsys_bo *bo = radv_amdgpu_winsys_bo(_bo);
+	bool busy = false;
+
+	if (bo->is_virtual)
+		return true;
+
+	if (amdgpu_bo_wait_for_idle(bo->bo, timeout, &busy))
+		return true;
+	return !busy;
+}
+
 static struct radeon_winsys_bo *
 radv_amdgpu_winsys_bo_from_ptr(struct radeon_winsys *_ws,
                                void *pointer,
@@ -595,6 +609,7 @@ void radv_amdgpu_bo_init_functions(struct radv_amdgpu_winsys *ws)
 	ws->base.buffer_destroy = radv_amdgpu_winsys_bo_destroy;
 	ws->base.buffer_map = radv_amdgpu_winsys_bo_map;
 	ws->base.buffer_unmap = radv_amdgpu_winsys_bo_unmap;
+	ws->base.buffer_wait_idle = radv_amdgpu_winsys_bo_wait_idle;
 	ws->base.buffer_from_ptr = radv_amdgpu_winsys_bo_from_ptr;
 	ws->base.buffer_from_fd = radv_amdgpu_winsys_bo_from_fd;
 	ws->base.buffer_get_fd = radv_amdgpu_winsys_get_fd;
@@ -571,6 +571,10 @@ static void radv_amdgpu_cs_execute_secondary(struct radeon_cmdbuf *_parent,
 	}
 
 	if (parent->ws->use_ib_bos) {
+		/* The child was finalized, so its IB chain is terminated and
+		 * the parent can jump into it without copying anything. The
+		 * child's IB BOs have been added to the parent's list above.
+		 */
 		if (parent->base.cdw + 4 > parent->base.max_dw)
 			radv_amdgpu_cs_grow(&parent->base, 4);
 
@@ -579,6 +583,9 @@ static void radv_amdgpu_cs_execute_secondary(struct radeon_cmdbuf *_parent,
 		radeon_emit(&parent->base, child->ib.ib_mc_address >> 32);
 		radeon_emit(&parent->base, child->ib.size);
 	} else {
+		/* System memory command streams are only copied into a BO at
+		 * submit time, so there is nothing to point the parent at.
+		 */
 		if (parent->base.cdw + child->base.cdw > parent->base.max_dw)
 			radv_amdgpu_cs_grow(&parent->base, child->base.cdw);
 
@@ -26,6 +26,10 @@
 #include "main/macros.h"
 #include "blob.h"
 
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
 #ifdef HAVE_VALGRIND
 #include <valgrind.h>
 #include <memcheck.h>
@@ -36,6 +40,41 @@
 
 #define BLOB_INITIAL_SIZE 4096
 
+#ifdef MREMAP_MAYMOVE
+/* Blobs growing past this size are moved to an anonymous mapping, which
+ * mremap() can grow by moving page table entries instead of copying what
+ * has been written so far.  Large serializations then cost one copy of the
+ * first megabyte instead of copying all of the data on every doubling.
+ */
+#define BLOB_MAP_THRESHOLD (1024 * 1024)
+#endif
+
+#ifdef BLOB_MAP_THRESHOLD
+static uint8_t *
+grow_mapping(struct blob *blob, size_t to_allocate)
+{
+   void *new_data;
+
+   if (blob->mapped) {
+      new_data = mremap(blob->data, blob->allocated, to_allocate,
+                        MREMAP_MAYMOVE);
+      return new_data == MAP_FAILED ? NULL : new_data;
+   }
+
+   new_data = mmap(NULL, to_allocate, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+   if (new_data == MAP_FAILED)
+      return NULL;
+
+   if (blob->size)
+      memcpy(new_data, blob->data, blob->size);
+   free(blob->data);
+   blob->mapped = true;
+
+   return new_data;
+}
+#endif
+
 /* Ensure that \blob will be able to fit an additional object of size
  * \additional.  The growing (if any) will occur by doubling the existing
  * allocation.
@@ -64,7 +103,12 @@ grow_to_fit(struct blob *blob, size_t additional)
 
    to_allocate = MAX2(to_allocate, blob->allocated + additional);
 
-   new_data = realloc(blob->data, to_allocate);
+#ifdef BLOB_MAP_THRESHOLD
+   if (to_allocate >= BLOB_MAP_THRESHOLD)
+      new_data = grow_mapping(blob, to_allocate);
+   else
+#endif
+      new_data = realloc(blob->data, to_allocate);
    if (new_data == NULL) {
       blob->out_of_memory = true;
       return false;
@@ -112,6 +156,7 @@ blob_init(struct blob *blob)
    blob->allocated = 0;
    blob->size = 0;
    blob->fixed_allocation = false;
+   blob->mapped = false;
    blob->out_of_memory = false;
 }
 
@@ -122,9 +167,24 @@ blob_init_fixed(struct blob *blob, void *data, size_t size)
    blob->allocated = size;
    blob->size = 0;
    blob->fixed_allocation = true;
+   blob->mapped = false;
    blob->out_of_memory = false;
 }
 
+void
+blob_finish(struct blob *blob)
+{
+#ifdef BLOB_MAP_THRESHOLD
+   if (blob->mapped) {
+      munmap(blob->data, blob->allocated);
+      return;
+   }
+#endif
+
+   if (!blob->fixed_allocation)
+      free(blob->data);
+}
+
 bool
 blob_overwrite_bytes(struct blob *blob,
                      size_t offset,
@@ -313,7 +373,7 @@ blob_read_uint32(struct blob_reader *blob)
    if (! ensure_can_read(blob, size))
       return 0;
 
-   ret = *((uint32_t*) blob->current);
+   memcpy(&ret, blob->current, size);
 
    blob->current += size;
 
@@ -331,7 +391,7 @@ blob_read_uint64(struct blob_reader *blob)
    if (! ensure_can_read(blob, size))
       return 0;
 
-   ret = *((uint64_t*) blob->current);
+   memcpy(&ret, blob->current, size);
 
    blob->current += size;
 
@@ -349,7 +409,7 @@ blob_read_intptr(struct blob_reader *blob)
    if (! ensure_can_read(blob, size))
       return 0;
 
-   ret = *((intptr_t *) blob->current);
+   memcpy(&ret, blob->current, size);
 
    blob->current += size;
 
@@ -62,6 +62,11 @@ struct blob {
     */
    bool fixed_allocation;
 
+   /** True if \c data is an anonymous mapping rather than a malloc'ed
+    * allocation, which happens to large blobs on Linux.
+    */
+   bool mapped;
+
    /**
     * True if we've ever failed to realloc or if we go pas the end of a fixed
     * allocation blob.
@@ -110,12 +115,8 @@ blob_init_fixed(struct blob *blob, void *data, size_t size);
  * If \blob was initialized with blob_init_fixed, the data pointer is
  * considered to be owned by the user and will not be freed.
  */
-static inline void
-blob_finish(struct blob *blob)
-{
-   if (!blob->fixed_allocation)
-      free(blob->data);
-}
+void
+blob_finish(struct blob *blob);
 
 /**
  * Add some unstructured, fixed-size data to a blob.
@@ -270,6 +271,9 @@ blob_write_string(struct blob *blob, const char *str);
  * remaining, the functions will do nothing, (perhaps returning default values
  * such as 0). The caller can detect this by noting that the blob_reader's
  * current value is unchanged before and after the call.
+ *
+ * The data is never copied and need not be aligned, so a reader can work
+ * directly on an item returned by disk_cache_get_mapped().
  */
 void
 blob_reader_init(struct blob_reader *blob, const void *data, size_t size);
@@ -40,6 +40,7 @@
 #include "ir_optimization.h"
 #include "loop_analysis.h"
 #include "builtin_functions.h"
+#include "shader_cache.h"
 
 /**
  * Format a short human-readable description of the given GLSL version.
@@ -2057,8 +2058,7 @@ _mesa_glsl_compile_shader(struct gl_context *ctx, struct gl_shader *shader,
    if (!force_recompile) {
       if (ctx->Cache) {
          char buf[41];
-         disk_cache_compute_key(ctx->Cache, source, strlen(source),
-                                shader->sha1);
+         shader_cache_compute_shader_key(ctx, source, shader->sha1);
          if (disk_cache_has_key(ctx->Cache, shader->sha1)) {
             /* We've seen this shader before and know it compiles */
             if (ctx->_Shader->Flags & GLSL_CACHE_INFO) {
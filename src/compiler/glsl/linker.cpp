@@ -83,6 +83,7 @@
 #include "ir_uniform.h"
 #include "builtin_functions.h"
 #include "shader_cache.h"
+#include "util/u_queue.h"
 #include "util/u_string.h"
 
 #include "main/imports.h"
@@ -4746,6 +4747,86 @@ linker_optimisation_loop(struct gl_context *ctx, exec_list *ir,
       }
 }
 
+/**
+ * The per-stage optimization done before assigning storage for attributes,
+ * uniforms and varyings only touches the IR of its own linked shader, so
+ * the stages are optimized in parallel on a process-wide queue.
+ */
+struct link_optimisation_job {
+   struct gl_context *ctx;
+   struct gl_linked_shader *shader;
+   unsigned stage;
+   struct util_queue_fence fence;
+};
+
+static struct util_queue link_queue;
+static once_flag link_queue_once = ONCE_FLAG_INIT;
+
+static void
+link_queue_init(void)
+{
+   util_queue_init(&link_queue, "glsl_link", 32, MESA_SHADER_STAGES - 1,
+                   UTIL_QUEUE_INIT_RESIZE_IF_FULL);
+}
+
+static void
+linker_optimise_stage(void *data, int thread_index)
+{
+   struct link_optimisation_job *job = (struct link_optimisation_job *) data;
+   exec_list *ir = job->shader->ir;
+
+   /* Call opts before lowering const arrays to uniforms so we can const
+    * propagate any elements accessed directly.
+    */
+   linker_optimisation_loop(job->ctx, ir, job->stage);
+
+   /* Call opts after lowering const arrays to copy propagate things. */
+   if (lower_const_arrays_to_uniforms(ir, job->stage))
+      linker_optimisation_loop(job->ctx, ir, job->stage);
+
+   propagate_invariance(ir);
+}
+
+static void
+linker_optimise_stages(struct gl_context *ctx, struct gl_shader_program *prog)
+{
+   struct link_optimisation_job jobs[MESA_SHADER_STAGES];
+   unsigned num_jobs = 0;
+
+   for (unsigned i = 0; i < MESA_SHADER_STAGES; i++) {
+      if (prog->_LinkedShaders[i] == NULL)
+         continue;
+
+      jobs[num_jobs].ctx = ctx;
+      jobs[num_jobs].shader = prog->_LinkedShaders[i];
+      jobs[num_jobs].stage = i;
+      num_jobs++;
+   }
+
+   if (num_jobs > 1)
+      call_once(&link_queue_once, link_queue_init);
+
+   if (num_jobs <= 1 || !util_queue_is_initialized(&link_queue)) {
+      for (unsigned i = 0; i < num_jobs; i++)
+         linker_optimise_stage(&jobs[i], 0);
+      return;
+   }
+
+   /* Keep the last stage for this thread. */
+   for (unsigned i = 0; i < num_jobs - 1; i++) {
+      util_queue_fence_init(&jobs[i].fence);
+      util_queue_add_job(&link_queue, &jobs[i], &jobs[i].fence,
+                         linker_optimise_stage, NULL);
+   }
+
+   linker_optimise_stage(&jobs[num_jobs - 1], 0);
+
+   for (unsigned i = 0; i < num_jobs - 1; i++) {
+      util_queue_fence_wait(&jobs[i].fence);
+      util_queue_fence_destroy(&jobs[i].fence);
+   }
+}
+
 void
 link_shaders(struct gl_context *ctx, struct gl_shader_program *prog)
 {
@@ -5054,19 +5135,10 @@ link_shaders(struct gl_context *ctx, struct gl_shader_program *prog)
       if (ctx->Const.LowerTessLevel) {
          lower_tess_level(prog->_LinkedShaders[i]);
       }
-
-      /* Call opts before lowering const arrays to uniforms so we can const
-       * propagate any elements accessed directly.
-       */
-      linker_optimisation_loop(ctx, prog->_LinkedShaders[i]->ir, i);
-
-      /* Call opts after lowering const arrays to copy propagate things. */
-      if (lower_const_arrays_to_uniforms(prog->_LinkedShaders[i]->ir, i))
-         linker_optimisation_loop(ctx, prog->_LinkedShaders[i]->ir, i);
-
-      propagate_invariance(prog->_LinkedShaders[i]->ir);
    }
 
+   linker_optimise_stages(ctx, prog);
+
    /* Validation for special cases where we allow sampler array indexing
     * with loop induction variable. This check emits a warning or error
     * depending if backend can handle dynamic indexing.
@@ -81,6 +81,62 @@ create_binding_str(const char *key, unsigned value, void *closure)
    ralloc_asprintf_append(bindings_str, "%s:%u,", key, value);
 }
 
+/**
+ * Append everything besides the source that changes what the front-end makes
+ * of a shader to a cache key string.
+ */
+static void
+append_compiler_env(struct gl_context *ctx, char **buf)
+{
+   /* A shader might end up producing different output depending on the glsl
+    * version supported by the compiler. For example a different path might be
+    * taken by the preprocessor, so add the version to the hash input.
+    */
+   ralloc_asprintf_append(buf, "api: %d glsl: %d fglsl: %d\n",
+                          ctx->API, ctx->Const.GLSLVersion,
+                          ctx->Const.ForceGLSLVersion);
+
+   /* We run the preprocessor on shaders after hashing them, so we need to
+    * add any extension override vars to the hash. If we don't do this the
+    * preprocessor could result in different output and we could load the
+    * wrong shader.
+    */
+   char *ext_override = getenv("MESA_EXTENSION_OVERRIDE");
+   if (ext_override) {
+      ralloc_asprintf_append(buf, "ext:%s", ext_override);
+   }
+
+   /* DRI config options may also change the output from the compiler so
+    * include them as an input to sha1 creation.
+    */
+   char sha1buf[41];
+   _mesa_sha1_format(sha1buf, ctx->Const.dri_config_options_sha1);
+   ralloc_strcat(buf, sha1buf);
+}
+
+/**
+ * Compute the key glCompileShader looks up to decide whether the compile can
+ * be deferred until link time. Hashing the source alone isn't enough: the
+ * same source may fail to compile for another API or GLSL version, and
+ * skipping it would then report success for a broken shader.
+ */
+void
+shader_cache_compute_shader_key(struct gl_context *ctx, const char *source,
+                                unsigned char *sha1)
+{
+   unsigned char source_sha1[20];
+   char sha1buf[41];
+
+   _mesa_sha1_compute(source, strlen(source), source_sha1);
+   _mesa_sha1_format(sha1buf, source_sha1);
+
+   char *buf = ralloc_asprintf(NULL, "src: %s\n", sha1buf);
+   append_compiler_env(ctx, &buf);
+
+   disk_cache_compute_key(ctx->Cache, buf, strlen(buf), sha1);
+   ralloc_free(buf);
+}
+
 void
 shader_cache_write_program_metadata(struct gl_context *ctx,
                                     struct gl_shader_program *prog)
@@ -181,31 +237,9 @@ shader_cache_read_program_metadata(struct gl_context *ctx,
    ralloc_asprintf_append(&buf, "sso: %s\n",
                           prog->SeparateShader ? "T" : "F");
 
-   /* A shader might end up producing different output depending on the glsl
-    * version supported by the compiler. For example a different path might be
-    * taken by the preprocessor, so add the version to the hash input.
-    */
-   ralloc_asprintf_append(&buf, "api: %d glsl: %d fglsl: %d\n",
-                          ctx->API, ctx->Const.GLSLVersion,
-                          ctx->Const.ForceGLSLVersion);
+   append_compiler_env(ctx, &buf);
 
-   /* We run the preprocessor on shaders after hashing them, so we need to
-    * add any extension override vars to the hash. If we don't do this the
-    * preprocessor could result in different output and we could load the
-    * wrong shader.
-    */
-   char *ext_override = getenv("MESA_EXTENSION_OVERRIDE");
-   if (ext_override) {
-      ralloc_asprintf_append(&buf, "ext:%s", ext_override);
-   }
-
-   /* DRI config options may also change the output from the compiler so
-    * include them as an input to sha1 creation.
-    */
    char sha1buf[41];
-   _mesa_sha1_format(sha1buf, ctx->Const.dri_config_options_sha1);
-   ralloc_strcat(&buf, sha1buf);
-
    for (unsigned i = 0; i < prog->NumShaders; i++) {
       struct gl_shader *sh = prog->Shaders[i];
       _mesa_sha1_format(sha1buf, sh->sha1);
@@ -215,10 +249,8 @@ shader_cache_read_program_metadata(struct gl_context *ctx,
    disk_cache_compute_key(cache, buf, strlen(buf), prog->data->sha1);
    ralloc_free(buf);
 
-   size_t size;
-   uint8_t *buffer = (uint8_t *) disk_cache_get(cache, prog->data->sha1,
-                                                &size);
-   if (buffer == NULL) {
+   struct disk_cache_mapped_entry entry;
+   if (!disk_cache_get_mapped(cache, prog->data->sha1, &entry)) {
       /* Cached program not found. We may have seen the individual shaders
        * before and skipped compiling but they may not have been used together
        * in this combination before. Fall back to linking shaders but first
@@ -240,7 +272,7 @@ shader_cache_read_program_metadata(struct gl_context *ctx,
    }
 
    struct blob_reader metadata;
-   blob_reader_init(&metadata, buffer, size);
+   blob_reader_init(&metadata, entry.data, entry.size);
 
    bool deserialized = deserialize_glsl_program(&metadata, ctx, prog);
 
@@ -257,7 +289,7 @@ shader_cache_read_program_metadata(struct gl_context *ctx,
 
       disk_cache_remove(cache, prog->data->sha1);
       compile_shaders(ctx, prog);
-      free(buffer);
+      disk_cache_release_mapped(&entry);
       return false;
    }
 
@@ -281,7 +313,7 @@ shader_cache_read_program_metadata(struct gl_context *ctx,
       }
    }
 
-   free (buffer);
+   disk_cache_release_mapped(&entry);
 
    return true;
 }
@@ -37,4 +37,8 @@ bool
 shader_cache_read_program_metadata(struct gl_context *ctx,
                                    struct gl_shader_program *prog);
 
+void
+shader_cache_compute_shader_key(struct gl_context *ctx, const char *source,
+                                unsigned char *sha1);
+
 #endif /* SHADER_CACHE_H */
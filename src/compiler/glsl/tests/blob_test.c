@@ -268,7 +268,8 @@ test_overrun(void)
 }
 
 /* Test that we can read and write some large objects, (exercising the code in
- * the blob_write functions to realloc blob->data.
+ * the blob_write functions to realloc blob->data, and to move it to a mapping
+ * and grow that several times where that is supported).
  */
 static void
 test_big_objects(void)
@@ -277,7 +278,7 @@ test_big_objects(void)
    struct blob blob;
    struct blob_reader reader;
    int size = 1000;
-   int count = 1000;
+   int count = 5000;
    size_t i;
    char *buf;
 
@@ -312,6 +313,40 @@ test_big_objects(void)
    ralloc_free(ctx);
 }
 
+/* Test that values can be read from data which isn't aligned, like items
+ * returned by disk_cache_get_mapped().
+ */
+static void
+test_unaligned_reader(void)
+{
+   struct blob blob;
+   struct blob_reader reader;
+   uint8_t *unaligned;
+
+   blob_init(&blob);
+   blob_write_uint32(&blob, 0x12345678);
+   blob_write_uint64(&blob, 0x1234567890abcdefULL);
+   blob_write_intptr(&blob, (intptr_t) 0x1234);
+
+   unaligned = malloc(blob.size + 1);
+   memcpy(unaligned + 1, blob.data, blob.size);
+
+   blob_reader_init(&reader, unaligned + 1, blob.size);
+
+   expect_equal(0x12345678, blob_read_uint32(&reader),
+                "blob_read_uint32 from unaligned data");
+   expect_equal(0x1234567890abcdefULL, blob_read_uint64(&reader),
+                "blob_read_uint64 from unaligned data");
+   expect_equal((intptr_t) 0x1234, blob_read_intptr(&reader),
+                "blob_read_intptr from unaligned data");
+
+   expect_equal(false, reader.overrun,
+                "overrun flag not set reading unaligned data");
+
+   free(unaligned);
+   blob_finish(&blob);
+}
+
 int
 main (void)
 {
@@ -319,6 +354,7 @@ main (void)
    test_alignment ();
    test_overrun ();
    test_big_objects ();
+   test_unaligned_reader ();
 
    return error ? 1 : 0;
 }
@@ -37,6 +37,7 @@
 
 #include "util/mesa-sha1.h"
 #include "util/disk_cache.h"
+#include "util/u_queue.h"
 
 bool error = false;
 
@@ -442,6 +443,183 @@ test_put_and_get(void)
    disk_cache_destroy(cache);
 }
 
+static void
+test_single_file_put_and_get(void)
+{
+   struct disk_cache *cache;
+   char blob[] = "This is a blob of thirty-seven bytes";
+   uint8_t blob_key[20];
+   uint8_t *big_a, *big_b;
+   uint8_t big_a_key[20], big_b_key[20];
+   char *result;
+   size_t size;
+   int i;
+
+   setenv("MESA_GLSL_CACHE_SINGLE_FILE", "true", 1);
+   setenv("MESA_GLSL_CACHE_MAX_SIZE", "1M", 1);
+
+   cache = disk_cache_create("test", "make_check", 0);
+   disk_cache_compute_key(cache, blob, sizeof(blob), blob_key);
+
+   result = disk_cache_get(cache, blob_key, &size);
+   expect_null(result, "single file disk_cache_get with non-existent item");
+
+   disk_cache_put(cache, blob_key, blob, sizeof(blob), NULL);
+   wait_until_file_written(cache, blob_key);
+
+   result = disk_cache_get(cache, blob_key, &size);
+   expect_equal_str(blob, result, "single file disk_cache_get (pointer)");
+   expect_equal(size, sizeof(blob), "single file disk_cache_get (size)");
+   free(result);
+
+   /* Entries must survive re-opening the database. */
+   disk_cache_destroy(cache);
+   cache = disk_cache_create("test", "make_check", 0);
+
+   expect_true(does_cache_contain(cache, blob_key),
+               "single file entry persists across disk_cache_create");
+
+   disk_cache_remove(cache, blob_key);
+   expect_true(!does_cache_contain(cache, blob_key),
+               "single file disk_cache_remove");
+
+   /* With a 1K limit, a second incompressible item of 600 bytes forces the
+    * first one out.
+    */
+   disk_cache_destroy(cache);
+   setenv("MESA_GLSL_CACHE_MAX_SIZE", "1K", 1);
+   cache = disk_cache_create("test", "make_check", 0);
+
+   big_a = malloc(600);
+   big_b = malloc(600);
+   srand(42);
+   for (i = 0; i < 600; i++) {
+      big_a[i] = rand();
+      big_b[i] = rand();
+   }
+   disk_cache_compute_key(cache, big_a, 600, big_a_key);
+   disk_cache_compute_key(cache, big_b, 600, big_b_key);
+
+   disk_cache_put(cache, big_a_key, big_a, 600, NULL);
+   wait_until_file_written(cache, big_a_key);
+   expect_true(does_cache_contain(cache, big_a_key),
+               "single file put of first item with MAX_SIZE=1K");
+
+   disk_cache_put(cache, big_b_key, big_b, 600, NULL);
+   wait_until_file_written(cache, big_b_key);
+   expect_true(does_cache_contain(cache, big_b_key),
+               "single file put of second item with MAX_SIZE=1K");
+   expect_true(!does_cache_contain(cache, big_a_key),
+               "single file eviction with MAX_SIZE=1K");
+
+   free(big_a);
+   free(big_b);
+   disk_cache_destroy(cache);
+
+   unsetenv("MESA_GLSL_CACHE_SINGLE_FILE");
+}
+
+static void
+test_single_file_get_mapped(void)
+{
+   struct disk_cache *cache;
+   struct disk_cache_mapped_entry entry;
+   char blob[] = "This is a blob of thirty-seven bytes";
+   char compressed_blob[] = "This blob is stored compressed";
+   uint8_t blob_key[20], compressed_blob_key[20];
+
+   setenv("MESA_GLSL_CACHE_SINGLE_FILE", "true", 1);
+   setenv("MESA_GLSL_CACHE_MAX_SIZE", "1M", 1);
+
+   /* Write one compressed entry first, it has to be returned as a copy. */
+   cache = disk_cache_create("test", "make_check", 0);
+   disk_cache_compute_key(cache, compressed_blob, sizeof(compressed_blob),
+                          compressed_blob_key);
+   disk_cache_put(cache, compressed_blob_key, compressed_blob,
+                  sizeof(compressed_blob), NULL);
+   wait_until_file_written(cache, compressed_blob_key);
+   disk_cache_destroy(cache);
+
+   setenv("MESA_GLSL_CACHE_UNCOMPRESSED", "true", 1);
+   cache = disk_cache_create("test", "make_check", 0);
+   disk_cache_compute_key(cache, blob, sizeof(blob), blob_key);
+
+   expect_true(!disk_cache_get_mapped(cache, blob_key, &entry),
+               "disk_cache_get_mapped with non-existent item");
+
+   disk_cache_put(cache, blob_key, blob, sizeof(blob), NULL);
+   wait_until_file_written(cache, blob_key);
+
+   expect_true(disk_cache_get_mapped(cache, blob_key, &entry),
+               "disk_cache_get_mapped of uncompressed item");
+   expect_equal_str(blob, entry.data, "disk_cache_get_mapped (pointer)");
+   expect_equal(entry.size, sizeof(blob), "disk_cache_get_mapped (size)");
+   expect_true(entry.copy == NULL,
+               "disk_cache_get_mapped of uncompressed item is not copied");
+
+   /* The mapped data must outlive the cache. */
+   disk_cache_destroy(cache);
+   expect_equal_str(blob, entry.data,
+                    "disk_cache_get_mapped data after disk_cache_destroy");
+   disk_cache_release_mapped(&entry);
+
+   cache = disk_cache_create("test", "make_check", 0);
+   expect_true(disk_cache_get_mapped(cache, compressed_blob_key, &entry),
+               "disk_cache_get_mapped of compressed item");
+   expect_equal_str(compressed_blob, entry.data,
+                    "disk_cache_get_mapped of compressed item (pointer)");
+   expect_true(entry.copy != NULL,
+               "disk_cache_get_mapped of compressed item is copied");
+   disk_cache_release_mapped(&entry);
+   disk_cache_destroy(cache);
+
+   unsetenv("MESA_GLSL_CACHE_UNCOMPRESSED");
+   unsetenv("MESA_GLSL_CACHE_SINGLE_FILE");
+}
+
+static void
+test_get_batch(void)
+{
+   struct disk_cache *cache;
+   struct util_queue_fence fence;
+   char blob[] = "This is a blob of thirty-seven bytes";
+   char string[] = "While this string has thirty-four";
+   cache_key keys[3];
+   void *data[3];
+   size_t sizes[3];
+
+   setenv("MESA_GLSL_CACHE_MAX_SIZE", "1M", 1);
+   cache = disk_cache_create("test", "make_check", 0);
+
+   disk_cache_compute_key(cache, blob, sizeof(blob), keys[0]);
+   disk_cache_compute_key(cache, string, sizeof(string), keys[1]);
+   disk_cache_compute_key(cache, "missing", 8, keys[2]);
+
+   disk_cache_put(cache, keys[0], blob, sizeof(blob), NULL);
+   disk_cache_put(cache, keys[1], string, sizeof(string), NULL);
+   wait_until_file_written(cache, keys[0]);
+   wait_until_file_written(cache, keys[1]);
+
+   util_queue_fence_init(&fence);
+   disk_cache_get_batch(cache, 3, keys, data, sizes, &fence);
+   util_queue_fence_wait(&fence);
+   util_queue_fence_destroy(&fence);
+
+   expect_equal_str(data[0], blob, "disk_cache_get_batch 1st item (pointer)");
+   expect_equal(sizes[0], sizeof(blob), "disk_cache_get_batch 1st item (size)");
+   expect_equal_str(data[1], string, "disk_cache_get_batch 2nd item (pointer)");
+   expect_equal(sizes[1], sizeof(string),
+                "disk_cache_get_batch 2nd item (size)");
+   expect_null(data[2], "disk_cache_get_batch with non-existent item");
+   expect_equal(sizes[2], 0, "disk_cache_get_batch with non-existent item "
+                "(size)");
+
+   free(data[0]);
+   free(data[1]);
+
+   disk_cache_destroy(cache);
+}
+
 static void
 test_put_key_and_get_key(void)
 {
@@ -505,6 +683,12 @@ main(void)
 
    test_put_and_get();
 
+   test_single_file_put_and_get();
+
+   test_single_file_get_mapped();
+
+   test_get_batch();
+
    test_put_key_and_get_key();
 
    err = rmrf_local(CACHE_TEST_TMP);
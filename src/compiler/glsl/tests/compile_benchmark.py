@@ -0,0 +1,157 @@
+# encoding=utf-8
+# Copyright © 2018 Intel Corporation
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+
+# The above copyright notice and this permission notice shall be included in
+# all copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+
+"""Compile a corpus of shaders with the standalone glsl compiler and report
+compile time, peak memory and the size of the resulting IR as JSON."""
+
+from __future__ import print_function
+import argparse
+import json
+import os
+import subprocess
+import sys
+import time
+
+SHADER_EXTENSIONS = ('.vert', '.tesc', '.tese', '.geom', '.frag', '.comp')
+
+
+def arg_parser():
+    parser = argparse.ArgumentParser()
+    parser.add_argument(
+        '--glsl-compiler',
+        required=True,
+        help='Path to the standalone glsl compiler')
+    parser.add_argument(
+        '--shader-directory',
+        required=True,
+        help='Directory containing the shaders to compile, searched '
+             'recursively.')
+    parser.add_argument(
+        '--version',
+        default='150',
+        help='GLSL version to compile the shaders with.')
+    parser.add_argument(
+        '--link',
+        action='store_true',
+        help='Also link each shader.')
+    parser.add_argument(
+        '--runs',
+        type=int,
+        default=1,
+        help='Number of times each shader is compiled; the fastest run is '
+             'reported.')
+    parser.add_argument(
+        '--output',
+        help='Write the JSON report to this file instead of stdout.')
+    return parser.parse_args()
+
+
+def find_shaders(directory):
+    for root, _, files in os.walk(directory):
+        for f in sorted(files):
+            if f.endswith(SHADER_EXTENSIONS):
+                yield os.path.join(root, f)
+
+
+def count_instructions(lir):
+    """Count the instructions in a --dump-lir dump.
+
+    Every instruction is printed on a line of its own, starting with an
+    opening parenthesis.
+    """
+    return sum(1 for l in lir.splitlines() if l.lstrip().startswith('('))
+
+
+def compile_shader(args, shader):
+    """Returns the exit status, the wall time in seconds, the peak resident
+    set size in kilobytes and the output of one compilation."""
+    cmd = [args.glsl_compiler, '--dump-lir', '--version', args.version]
+    if args.link:
+        cmd.append('--link')
+    cmd.append(shader)
+
+    start = time.time()
+    proc = subprocess.Popen(cmd, stdout=subprocess.PIPE,
+                            stderr=subprocess.STDOUT)
+    out = proc.stdout.read()
+    proc.stdout.close()
+    _, status, rusage = os.wait4(proc.pid, 0)
+    wall = time.time() - start
+
+    return (os.WEXITSTATUS(status) if os.WIFEXITED(status) else -1,
+            wall, rusage.ru_maxrss, out.decode('utf-8', 'replace'))
+
+
+def main():
+    args = arg_parser()
+    shaders = list(find_shaders(args.shader_directory))
+
+    if not shaders:
+        print('Could not find any shaders', file=sys.stderr)
+        exit(1)
+
+    results = []
+    failed = 0
+    for shader in shaders:
+        best = None
+        peak_kb = 0
+        for _ in range(max(args.runs, 1)):
+            status, wall, rss, out = compile_shader(args, shader)
+            if best is None or wall < best:
+                best = wall
+            peak_kb = max(peak_kb, rss)
+
+        if status != 0:
+            failed += 1
+
+        results.append({
+            'shader': os.path.relpath(shader, args.shader_directory),
+            'status': 'pass' if status == 0 else 'fail',
+            'compile_time_ms': round(best * 1000.0, 3),
+            'peak_rss_kb': peak_kb,
+            'instructions': count_instructions(out) if status == 0 else None,
+        })
+
+    report = {
+        'compiler': os.path.basename(args.glsl_compiler),
+        'version': args.version,
+        'link': args.link,
+        'total_compile_time_ms': round(
+            sum(r['compile_time_ms'] for r in results), 3),
+        'total_instructions': sum(r['instructions'] or 0 for r in results),
+        'failed': failed,
+        'shaders': results,
+    }
+
+    if args.output:
+        with open(args.output, 'w') as f:
+            json.dump(report, f, indent=2, sort_keys=True,
+                      separators=(',', ': '))
+    else:
+        json.dump(report, sys.stdout, indent=2, sort_keys=True,
+                  separators=(',', ': '))
+        print()
+
+    exit(0 if failed == 0 else 1)
+
+
+if __name__ == '__main__':
+    main()
@@ -36,6 +36,7 @@
 #include "util/set.h"
 #include "util/bitset.h"
 #include "util/macros.h"
+#include "util/u_cpu_trace.h"
 #include "compiler/nir_types.h"
 #include "compiler/shader_enums.h"
 #include "compiler/shader_info.h"
@@ -465,7 +466,7 @@ typedef struct nir_register {
 #define nir_foreach_register_safe(reg, reg_list) \
    foreach_list_typed_safe(nir_register, reg, node, reg_list)
 
-typedef enum {
+typedef enum ENUM_PACKED {
    nir_instr_type_alu,
    nir_instr_type_deref,
    nir_instr_type_call,
@@ -480,16 +481,20 @@ typedef enum {
 
 typedef struct nir_instr {
    struct exec_node node;
-   nir_instr_type type;
    struct nir_block *block;
 
-   /** generic instruction index. */
-   unsigned index;
+   /* The type and the pass flags share a word with the index, which keeps
+    * the header of every instruction at four pointers on 64-bit.
+    */
+   nir_instr_type type;
 
    /* A temporary for optimization and analysis passes to use for storing
     * flags.  For instance, DCE uses this to store the "dead/live" info.
     */
    uint8_t pass_flags;
+
+   /** generic instruction index. */
+   unsigned index;
 } nir_instr;
 
 static inline nir_instr *
@@ -1770,6 +1775,11 @@ typedef struct {
    /* Unroll the loop regardless of its size */
    bool force_unroll;
 
+   /* Number of array derefs indexed by an induction variable, these become
+    * directly indexed when the loop is completely unrolled.
+    */
+   unsigned num_induction_indirects;
+
    nir_loop_terminator *limiting_terminator;
 
    /* A list of loop_terminators terminating this loop. */
@@ -2067,6 +2077,22 @@ typedef struct nir_shader_compiler_options {
    bool vs_inputs_dual_locations;
 
    unsigned max_unroll_iterations;
+
+   /**
+    * Maximum number of copies of the body a loop with an unknown trip count
+    * may be partially unrolled into, 0 or 1 disables partial unrolling.
+    */
+   unsigned max_partial_unroll_factor;
+
+   /**
+    * Allocate instructions from an arena owned by the shader.
+    *
+    * Instructions stay regular ralloc blocks, but their memory is only
+    * released together with the shader, so nir_sweep() can't reclaim it.
+    * This trades memory for far fewer malloc/free calls and is meant for
+    * shaders that are compiled once and thrown away.
+    */
+   bool use_instr_arena;
 } nir_shader_compiler_options;
 
 typedef struct nir_shader {
@@ -2119,6 +2145,9 @@ typedef struct nir_shader {
     */
    void *constant_data;
    unsigned constant_data_size;
+
+   /** Arena for instructions, see nir_shader_compiler_options::use_instr_arena */
+   void *instr_arena;
 } nir_shader;
 
 static inline nir_function_impl *
@@ -2584,6 +2613,20 @@ static inline bool should_serialize_deserialize_nir(void) { return false; }
 static inline bool should_print_nir(void) { return false; }
 #endif /* NDEBUG */
 
+/* Pass timing, see nir_pass_stats.c.  Available in release builds too. */
+int64_t nir_pass_stats_begin(void);
+void nir_pass_stats_end(const char *name, int64_t start, bool progress);
+
+static inline bool
+should_collect_nir_pass_stats(void)
+{
+   static int collect_stats = -1;
+   if (collect_stats < 0)
+      collect_stats = env_var_as_boolean("NIR_PASS_STATS", false);
+
+   return collect_stats;
+}
+
 #define _PASS(nir, do_pass) do {                                     \
    do_pass                                                           \
    nir_validate_shader(nir);                                         \
@@ -2602,7 +2645,16 @@ static inline bool should_print_nir(void) { return false; }
    nir_metadata_set_validation_flag(nir);                            \
    if (should_print_nir())                                           \
       printf("%s\n", #pass);                                         \
-   if (pass(nir, ##__VA_ARGS__)) {                                   \
+   int64_t _pass_start = should_collect_nir_pass_stats() ?           \
+                         nir_pass_stats_begin() : 0;                 \
+   bool _pass_progress;                                              \
+   {                                                                 \
+      MESA_TRACE_SCOPE(#pass);                                       \
+      _pass_progress = pass(nir, ##__VA_ARGS__);                     \
+   }                                                                 \
+   if (should_collect_nir_pass_stats())                              \
+      nir_pass_stats_end(#pass, _pass_start, _pass_progress);        \
+   if (_pass_progress) {                                             \
       progress = true;                                               \
       if (should_print_nir())                                        \
          nir_print_shader(nir, stdout);                              \
@@ -2613,11 +2665,36 @@ static inline bool should_print_nir(void) { return false; }
 #define NIR_PASS_V(nir, pass, ...) _PASS(nir,                        \
    if (should_print_nir())                                           \
       printf("%s\n", #pass);                                         \
-   pass(nir, ##__VA_ARGS__);                                         \
+   int64_t _pass_start = should_collect_nir_pass_stats() ?           \
+                         nir_pass_stats_begin() : 0;                 \
+   {                                                                 \
+      MESA_TRACE_SCOPE(#pass);                                       \
+      pass(nir, ##__VA_ARGS__);                                      \
+   }                                                                 \
+   if (should_collect_nir_pass_stats())                              \
+      nir_pass_stats_end(#pass, _pass_start, false);                 \
    if (should_print_nir())                                           \
       nir_print_shader(nir, stdout);                                 \
 )
 
+/** A pass for nir_optimize_loop() */
+typedef struct {
+   const char *name;
+   bool (*run)(nir_shader *shader);
+
+   /**
+    * Set if the pass runs to its own fixed point, like nir_opt_algebraic,
+    * so that running it again right after it made progress is pointless.
+    */
+   bool fixed_point;
+} nir_loop_pass;
+
+#define NIR_LOOP_PASS(pass) { #pass, pass, false }
+#define NIR_LOOP_PASS_FIXED_POINT(pass) { #pass, pass, true }
+
+bool nir_optimize_loop(nir_shader **shader, const nir_loop_pass *passes,
+                       unsigned num_passes);
+
 void nir_calc_dominance_impl(nir_function_impl *impl);
 void nir_calc_dominance(nir_shader *shader);
 
@@ -2671,6 +2748,7 @@ void nir_assign_var_locations(struct exec_list *var_list, unsigned *size,
 bool nir_remove_unused_varyings(nir_shader *producer, nir_shader *consumer);
 void nir_compact_varyings(nir_shader *producer, nir_shader *consumer,
                           bool default_to_smooth_interp);
+bool nir_link_opt_varyings(nir_shader *producer, nir_shader *consumer);
 
 typedef enum {
    /* If set, this forces all non-flat fragment shader inputs to be
@@ -2957,6 +3035,16 @@ bool nir_opt_large_constants(nir_shader *shader,
 
 bool nir_opt_loop_unroll(nir_shader *shader, nir_variable_mode indirect_mask);
 
+typedef bool (*nir_should_vectorize_mem_func)(nir_intrinsic_op op,
+                                              unsigned align,
+                                              unsigned bit_size,
+                                              unsigned num_components,
+                                              void *data);
+
+bool nir_opt_load_store_vectorize(nir_shader *shader,
+                                  nir_should_vectorize_mem_func callback,
+                                  void *data);
+
 bool nir_opt_move_comparisons(nir_shader *shader);
 
 bool nir_opt_move_load_ubo(nir_shader *shader);
@@ -509,6 +509,7 @@ _algebraic_pass_template = mako.template.Template("""
 #include "nir.h"
 #include "nir_search.h"
 #include "nir_search_helpers.h"
+#include "nir_worklist.h"
 
 #ifndef NIR_OPT_ALGEBRAIC_STRUCT_DEFS
 #define NIR_OPT_ALGEBRAIC_STRUCT_DEFS
@@ -534,52 +535,101 @@ static const struct transform ${pass_name}_${opcode}_xforms[] = {
 };
 % endfor
 
-static bool
-${pass_name}_block(nir_block *block, const bool *condition_flags,
-                   void *mem_ctx)
+static void
+${pass_name}_push(nir_instr_worklist *worklist, nir_instr *instr)
 {
-   bool progress = false;
-
-   nir_foreach_instr_reverse_safe(instr, block) {
-      if (instr->type != nir_instr_type_alu)
-         continue;
-
-      nir_alu_instr *alu = nir_instr_as_alu(instr);
-      if (!alu->dest.dest.is_ssa)
-         continue;
+   /* pass_flags tells whether the instruction is already queued. */
+   if (instr->type == nir_instr_type_alu && !instr->pass_flags) {
+      instr->pass_flags = 1;
+      nir_instr_worklist_push_tail(worklist, instr);
+   }
+}
 
-      switch (alu->op) {
-      % for opcode in xform_dict.keys():
-      case nir_op_${opcode}:
-         for (unsigned i = 0; i < ARRAY_SIZE(${pass_name}_${opcode}_xforms); i++) {
-            const struct transform *xform = &${pass_name}_${opcode}_xforms[i];
-            if (condition_flags[xform->condition_offset] &&
-                nir_replace_instr(alu, xform->search, xform->replace,
-                                  mem_ctx)) {
-               progress = true;
+static bool
+${pass_name}_instr(nir_alu_instr *alu, const bool *condition_flags,
+                   void *mem_ctx, nir_instr_worklist *worklist)
+{
+% if fixed_point:
+   nir_instr *prev = nir_instr_prev(&alu->instr);
+   nir_block *block = alu->instr.block;
+% endif
+   nir_alu_instr *mov = NULL;
+
+   switch (alu->op) {
+   % for opcode in xform_dict.keys():
+   case nir_op_${opcode}:
+      for (unsigned i = 0; i < ARRAY_SIZE(${pass_name}_${opcode}_xforms); i++) {
+         const struct transform *xform = &${pass_name}_${opcode}_xforms[i];
+         if (condition_flags[xform->condition_offset]) {
+            mov = nir_replace_instr(alu, xform->search, xform->replace,
+                                    mem_ctx);
+            if (mov)
                break;
-            }
          }
-         break;
-      % endfor
-      default:
-         break;
       }
+      break;
+   % endfor
+   default:
+      break;
    }
 
-   return progress;
+   if (!mov)
+      return false;
+
+% if fixed_point:
+   /* The replacement expression is built right before the new mov.  It may
+    * match other patterns itself, and so may the users of its value.
+    */
+   nir_instr *instr = prev ? nir_instr_next(prev) : nir_block_first_instr(block);
+   for (; instr != &mov->instr; instr = nir_instr_next(instr))
+      ${pass_name}_push(worklist, instr);
+
+   nir_foreach_use(use, &mov->dest.dest.ssa)
+      ${pass_name}_push(worklist, use->parent_instr);
+% else:
+   (void) worklist;
+% endif
+
+   return true;
 }
 
 static bool
 ${pass_name}_impl(nir_function_impl *impl, const bool *condition_flags)
 {
    void *mem_ctx = ralloc_parent(impl);
+   nir_instr_worklist *worklist = nir_instr_worklist_create();
    bool progress = false;
 
+% if fixed_point:
+   /* Start with every instruction, bottom up like a plain walk would.  From
+    * then on only the code a replacement touched is looked at again, which
+    * takes the pass to its fixed point without rescanning the shader.
+    */
+% else:
+   /* Visit every instruction once, bottom up.  Replacements aren't looked at
+    * again since they may match the pattern they were built from.
+    */
+% endif
    nir_foreach_block_reverse(block, impl) {
-      progress |= ${pass_name}_block(block, condition_flags, mem_ctx);
+      nir_foreach_instr_reverse(instr, block) {
+         instr->pass_flags = 0;
+         ${pass_name}_push(worklist, instr);
+      }
+   }
+
+   nir_foreach_instr_in_worklist(instr, worklist) {
+      instr->pass_flags = 0;
+
+      nir_alu_instr *alu = nir_instr_as_alu(instr);
+      if (!alu->dest.dest.is_ssa)
+         continue;
+
+      if (${pass_name}_instr(alu, condition_flags, mem_ctx, worklist))
+         progress = true;
    }
 
+   nir_instr_worklist_destroy(worklist);
+
    if (progress)
       nir_metadata_preserve(impl, nir_metadata_block_index |
                                   nir_metadata_dominance);
@@ -610,9 +660,17 @@ ${pass_name}(nir_shader *shader)
 """)
 
 class AlgebraicPass(object):
-   def __init__(self, pass_name, transforms):
+   """Generates an algebraic optimization pass.
+
+   With fixed_point set, the pass also tries the transforms again on the
+   instructions created by a replacement and on the users of its result, so
+   that it only returns once no transform matches anymore.  This requires
+   that no chain of transforms can go on forever.
+   """
+   def __init__(self, pass_name, transforms, fixed_point=False):
       self.xform_dict = OrderedDict()
       self.pass_name = pass_name
+      self.fixed_point = fixed_point
 
       error = False
 
@@ -639,4 +697,5 @@ class AlgebraicPass(object):
    def render(self):
       return _algebraic_pass_template.render(pass_name=self.pass_name,
                                              xform_dict=self.xform_dict,
-                                             condition_list=condition_list)
+                                             condition_list=condition_list,
+                                             fixed_point=self.fixed_point)
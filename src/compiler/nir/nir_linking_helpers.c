@@ -22,12 +22,14 @@
  */
 
 #include "nir.h"
+#include "nir_builder.h"
 #include "util/set.h"
 #include "util/hash_table.h"
 
 /* This file contains various little helpers for doing simple linking in
  * NIR.  Eventually, we'll probably want a full-blown varying packing
- * implementation in here.  Right now, it just deletes unused things.
+ * implementation in here.  Right now, it deletes unused things, packs
+ * components and forwards constant and duplicated outputs.
  */
 
 /**
@@ -504,3 +506,187 @@ nir_compact_varyings(nir_shader *producer, nir_shader *consumer,
    compact_components(producer, consumer, comps, interp_type, interp_loc,
                       default_to_smooth_interp);
 }
+
+static bool
+can_replace_varying(nir_variable *out_var, nir_intrinsic_instr *store)
+{
+   /* Only plain vectors and scalars are handled.  Arrays, matrices and
+    * structs have normally been split into elements by the time this runs.
+    */
+   if (!glsl_type_is_vector_or_scalar(out_var->type) ||
+       glsl_type_is_dual_slot(out_var->type))
+      return false;
+
+   if (out_var->data.location < VARYING_SLOT_VAR0)
+      return false;
+
+   /* The whole variable has to be written by this one store */
+   nir_deref_instr *deref = nir_src_as_deref(store->src[0]);
+   return deref->deref_type == nir_deref_type_var &&
+          nir_intrinsic_write_mask(store) ==
+             (1u << glsl_get_vector_elements(out_var->type)) - 1;
+}
+
+static bool
+does_varying_match(nir_variable *out_var, nir_variable *in_var)
+{
+   return in_var->data.location == out_var->data.location &&
+          in_var->data.location_frac == out_var->data.location_frac &&
+          in_var->type == out_var->type;
+}
+
+static nir_variable *
+get_matching_input_var(nir_shader *consumer, nir_variable *out_var)
+{
+   nir_foreach_variable(var, &consumer->inputs) {
+      if (does_varying_match(out_var, var))
+         return var;
+   }
+
+   return NULL;
+}
+
+/* Replaces every direct load of the consumer input matching out_var with
+ * either the constant stored to out_var or a load of replacement.
+ */
+static bool
+replace_varying_input(nir_shader *consumer, nir_variable *out_var,
+                      nir_load_const_instr *value, nir_variable *replacement)
+{
+   nir_function_impl *impl = nir_shader_get_entrypoint(consumer);
+
+   nir_builder b;
+   nir_builder_init(&b, impl);
+
+   bool progress = false;
+   nir_foreach_block(block, impl) {
+      nir_foreach_instr_safe(instr, block) {
+         if (instr->type != nir_instr_type_intrinsic)
+            continue;
+
+         nir_intrinsic_instr *intr = nir_instr_as_intrinsic(instr);
+         if (intr->intrinsic != nir_intrinsic_load_deref)
+            continue;
+
+         nir_deref_instr *in_deref = nir_src_as_deref(intr->src[0]);
+         if (in_deref->mode != nir_var_shader_in ||
+             in_deref->deref_type != nir_deref_type_var)
+            continue;
+
+         nir_variable *in_var = in_deref->var;
+         if (in_var == replacement || !does_varying_match(out_var, in_var))
+            continue;
+
+         if (replacement &&
+             (in_var->data.interpolation != replacement->data.interpolation ||
+              get_interp_loc(in_var) != get_interp_loc(replacement)))
+            continue;
+
+         b.cursor = nir_before_instr(instr);
+
+         nir_ssa_def *def;
+         if (value) {
+            def = nir_build_imm(&b, value->def.num_components,
+                                value->def.bit_size, value->value);
+         } else {
+            def = nir_load_var(&b, replacement);
+         }
+
+         nir_ssa_def_rewrite_uses(&intr->dest.ssa, nir_src_for_ssa(def));
+         nir_instr_remove(instr);
+         nir_deref_instr_remove_if_unused(in_deref);
+
+         progress = true;
+      }
+   }
+
+   if (progress) {
+      nir_metadata_preserve(impl, nir_metadata_block_index |
+                                  nir_metadata_dominance);
+   }
+
+   return progress;
+}
+
+/**
+ * Forwards producer outputs whose value is known at link time into the
+ * consumer.  Loads of inputs fed by a constant are replaced by that constant
+ * and inputs fed by the same SSA value as another input are replaced by
+ * loads of that other input.
+ *
+ * This relies on the producer having been through nir_lower_returns and
+ * nir_lower_io_to_temporaries, so that the final value of each output is
+ * stored unconditionally in the last block of the entrypoint.  Removing the
+ * now unread varyings is left to nir_remove_dead_variables and
+ * nir_remove_unused_varyings.
+ */
+bool
+nir_link_opt_varyings(nir_shader *producer, nir_shader *consumer)
+{
+   /* Interpolation is the only thing between a vertex or tessellation
+    * evaluation output and a fragment input, so an input is exactly as
+    * constant or as duplicated as the output feeding it.
+    */
+   if (consumer->info.stage != MESA_SHADER_FRAGMENT ||
+       (producer->info.stage != MESA_SHADER_VERTEX &&
+        producer->info.stage != MESA_SHADER_TESS_EVAL))
+      return false;
+
+   nir_function_impl *impl = nir_shader_get_entrypoint(producer);
+
+   struct hash_table *varying_values =
+      _mesa_hash_table_create(NULL, _mesa_hash_pointer,
+                              _mesa_key_pointer_equal);
+   struct set *written =
+      _mesa_set_create(NULL, _mesa_hash_pointer, _mesa_key_pointer_equal);
+
+   bool progress = false;
+
+   /* Walk backwards so that only the last store to each output is used */
+   nir_block *last_block = nir_impl_last_block(impl);
+   nir_foreach_instr_reverse(instr, last_block) {
+      if (instr->type != nir_instr_type_intrinsic)
+         continue;
+
+      nir_intrinsic_instr *intr = nir_instr_as_intrinsic(instr);
+      if (intr->intrinsic != nir_intrinsic_store_deref)
+         continue;
+
+      nir_deref_instr *out_deref = nir_src_as_deref(intr->src[0]);
+      if (out_deref->mode != nir_var_shader_out)
+         continue;
+
+      nir_variable *out_var = nir_deref_instr_get_variable(out_deref);
+      if (_mesa_set_search(written, out_var))
+         continue;
+      _mesa_set_add(written, out_var);
+
+      if (!can_replace_varying(out_var, intr))
+         continue;
+
+      nir_ssa_def *value = intr->src[1].ssa;
+      if (value->parent_instr->type == nir_instr_type_load_const) {
+         progress |=
+            replace_varying_input(consumer, out_var,
+                                  nir_instr_as_load_const(value->parent_instr),
+                                  NULL);
+         continue;
+      }
+
+      struct hash_entry *entry =
+         _mesa_hash_table_search(varying_values, value);
+      if (entry) {
+         progress |= replace_varying_input(consumer, out_var, NULL,
+                                           (nir_variable *) entry->data);
+      } else {
+         nir_variable *in_var = get_matching_input_var(consumer, out_var);
+         if (in_var)
+            _mesa_hash_table_insert(varying_values, value, in_var);
+      }
+   }
+
+   _mesa_hash_table_destroy(varying_values, NULL);
+   _mesa_set_destroy(written, NULL);
+
+   return progress;
+}
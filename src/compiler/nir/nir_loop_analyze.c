@@ -633,6 +633,8 @@ force_unroll_array_access(loop_info_state *state, nir_shader *ns,
       if (array_index->type != basic_induction)
          continue;
 
+      state->loop->info->num_induction_indirects++;
+
       nir_deref_instr *parent = nir_deref_instr_parent(d);
       assert(glsl_type_is_array(parent->type) ||
              glsl_type_is_matrix(parent->type));
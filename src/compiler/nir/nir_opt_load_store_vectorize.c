@@ -0,0 +1,508 @@
+/*
+ * Copyright © 2018 Advanced Micro Devices, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+ * \file nir_opt_load_store_vectorize.c
+ *
+ * Merges memory accesses of the same block into wider ones.  Two loads (or
+ * two stores) are combined when they use the same intrinsic and buffer,
+ * their offsets only differ by a constant and the second one starts right
+ * where the first one ends.  The driver decides through a callback which
+ * widths and alignments are worth it.
+ *
+ * Loads are combined at the position of the first load and stores at the
+ * position of the last store, so that everything they use is still
+ * available.  An access of the same kind of memory which may alias, or any
+ * other intrinsic with side effects, ends the search for partners.
+ */
+
+#include "nir.h"
+#include "nir_builder.h"
+#include "util/bitscan.h"
+
+enum vectorize_mode {
+   MODE_UBO,
+   MODE_SSBO,
+   MODE_SHARED,
+};
+
+struct mem_access {
+   nir_intrinsic_instr *intrin;
+   enum vectorize_mode mode;
+   bool is_store;
+
+   /* Buffer index, or NULL for shared memory */
+   nir_src *resource;
+
+   /* The offset is base + offset, base is NULL for constant offsets */
+   nir_ssa_def *base;
+   int64_t offset;
+
+   unsigned bit_size;
+   unsigned num_components;
+};
+
+struct vectorize_state {
+   nir_builder b;
+   nir_should_vectorize_mem_func callback;
+   void *data;
+
+   /* Candidates of the current block which can still be combined with a
+    * later access.  Entries are removed when something between them and the
+    * current instruction could alias.
+    */
+   struct mem_access *pending;
+   unsigned num_pending;
+   unsigned pending_size;
+};
+
+static unsigned
+value_src_index(nir_intrinsic_op op)
+{
+   return (op == nir_intrinsic_store_ssbo || op == nir_intrinsic_store_shared) ?
+          0 : ~0u;
+}
+
+static bool
+get_access_info(nir_intrinsic_instr *intrin, struct mem_access *access)
+{
+   int resource_src, offset_src;
+
+   switch (intrin->intrinsic) {
+   case nir_intrinsic_load_ubo:
+      access->mode = MODE_UBO;
+      access->is_store = false;
+      resource_src = 0;
+      offset_src = 1;
+      break;
+   case nir_intrinsic_load_ssbo:
+      access->mode = MODE_SSBO;
+      access->is_store = false;
+      resource_src = 0;
+      offset_src = 1;
+      break;
+   case nir_intrinsic_store_ssbo:
+      access->mode = MODE_SSBO;
+      access->is_store = true;
+      resource_src = 1;
+      offset_src = 2;
+      break;
+   case nir_intrinsic_load_shared:
+      access->mode = MODE_SHARED;
+      access->is_store = false;
+      resource_src = -1;
+      offset_src = 0;
+      break;
+   case nir_intrinsic_store_shared:
+      access->mode = MODE_SHARED;
+      access->is_store = true;
+      resource_src = -1;
+      offset_src = 1;
+      break;
+   default:
+      return false;
+   }
+
+   if (access->is_store) {
+      nir_src *value = &intrin->src[value_src_index(intrin->intrinsic)];
+      assert(value->is_ssa);
+
+      /* Partial writes would need the hole to be preserved */
+      if (nir_intrinsic_write_mask(intrin) !=
+          (1u << intrin->num_components) - 1)
+         return false;
+
+      access->bit_size = value->ssa->bit_size;
+   } else {
+      assert(intrin->dest.is_ssa);
+      access->bit_size = intrin->dest.ssa.bit_size;
+   }
+
+   access->intrin = intrin;
+   access->num_components = intrin->num_components;
+   access->resource = resource_src >= 0 ? &intrin->src[resource_src] : NULL;
+
+   nir_src *offset = &intrin->src[offset_src];
+   if (!offset->is_ssa)
+      return false;
+
+   access->base = offset->ssa;
+   access->offset = 0;
+
+   if (access->mode == MODE_SHARED)
+      access->offset += nir_intrinsic_base(intrin);
+
+   nir_const_value *const_offset = nir_src_as_const_value(*offset);
+   if (const_offset) {
+      access->base = NULL;
+      access->offset += const_offset->u32[0];
+   } else if (offset->ssa->parent_instr->type == nir_instr_type_alu) {
+      nir_alu_instr *alu = nir_instr_as_alu(offset->ssa->parent_instr);
+      if (alu->op == nir_op_iadd) {
+         for (unsigned i = 0; i < 2; i++) {
+            nir_const_value *c = nir_src_as_const_value(alu->src[i].src);
+            nir_alu_src *other = &alu->src[1 - i];
+            if (c && other->src.is_ssa &&
+                other->src.ssa->num_components == 1 &&
+                !other->negate && !other->abs) {
+               access->base = other->src.ssa;
+               access->offset += (int32_t)c->u32[alu->src[i].swizzle[0]];
+               break;
+            }
+         }
+      }
+   }
+
+   return true;
+}
+
+/**
+ * Returns the largest power of two we know the SSA value to be a multiple
+ * of, capped at 1 << 16.
+ */
+static unsigned
+get_base_align(nir_ssa_def *base, unsigned elem_size)
+{
+   if (base == NULL)
+      return 1u << 16;
+
+   if (base->parent_instr->type == nir_instr_type_alu) {
+      nir_alu_instr *alu = nir_instr_as_alu(base->parent_instr);
+      for (unsigned i = 0; i < 2; i++) {
+         if (alu->op != nir_op_imul && alu->op != nir_op_ishl)
+            break;
+
+         /* Only the second source of a shift is a shift count */
+         if (alu->op == nir_op_ishl && i == 0)
+            continue;
+
+         nir_const_value *c = nir_src_as_const_value(alu->src[i].src);
+         if (!c)
+            continue;
+
+         uint32_t value = c->u32[alu->src[i].swizzle[0]];
+         if (alu->op == nir_op_ishl)
+            return 1u << MIN2(value & 31, 16);
+         if (value != 0)
+            return 1u << MIN2(ffs(value) - 1, 16);
+      }
+   }
+
+   /* Accesses are always aligned to their element size */
+   return elem_size;
+}
+
+static bool
+resources_equal(const nir_src *a, const nir_src *b)
+{
+   if (a == NULL || b == NULL)
+      return a == b;
+
+   if (a->is_ssa && b->is_ssa && a->ssa == b->ssa)
+      return true;
+
+   nir_const_value *ca = nir_src_as_const_value(*a);
+   nir_const_value *cb = nir_src_as_const_value(*b);
+   return ca && cb && ca->u32[0] == cb->u32[0];
+}
+
+static bool
+can_vectorize(struct vectorize_state *state,
+              const struct mem_access *low, const struct mem_access *high)
+{
+   if (low->intrin->intrinsic != high->intrin->intrinsic ||
+       low->bit_size != high->bit_size ||
+       low->base != high->base ||
+       !resources_equal(low->resource, high->resource))
+      return false;
+
+   const unsigned elem_size = low->bit_size / 8;
+   if (high->offset != low->offset + low->num_components * elem_size)
+      return false;
+
+   const unsigned num_components = low->num_components + high->num_components;
+   if (num_components > 4)
+      return false;
+
+   unsigned align = get_base_align(low->base, elem_size);
+   if (low->offset != 0)
+      align = MIN2(align, 1u << (ffsll(low->offset) - 1));
+
+   return state->callback(low->intrin->intrinsic, align, low->bit_size,
+                          num_components, state->data);
+}
+
+static nir_ssa_def *
+build_offset(nir_builder *b, const struct mem_access *access)
+{
+   /* Shared memory takes the constant part through the base index */
+   int64_t offset = access->mode == MODE_SHARED ? 0 : access->offset;
+
+   if (access->base == NULL)
+      return nir_imm_int(b, offset);
+
+   if (offset == 0)
+      return access->base;
+
+   return nir_iadd(b, access->base, nir_imm_int(b, offset));
+}
+
+static nir_intrinsic_instr *
+vectorize_loads(struct vectorize_state *state,
+                const struct mem_access *first,
+                const struct mem_access *low, const struct mem_access *high)
+{
+   nir_builder *b = &state->b;
+   nir_intrinsic_op op = low->intrin->intrinsic;
+   const unsigned num_components = low->num_components + high->num_components;
+
+   b->cursor = nir_before_instr(&first->intrin->instr);
+
+   nir_intrinsic_instr *load = nir_intrinsic_instr_create(b->shader, op);
+   load->num_components = num_components;
+   if (low->resource)
+      nir_src_copy(&load->src[0], low->resource, load);
+   load->src[nir_intrinsic_infos[op].num_srcs - 1] =
+      nir_src_for_ssa(build_offset(b, low));
+   if (low->mode == MODE_SHARED)
+      nir_intrinsic_set_base(load, low->offset);
+   nir_ssa_dest_init(&load->instr, &load->dest, num_components,
+                     low->bit_size, NULL);
+   nir_builder_instr_insert(b, &load->instr);
+
+   nir_ssa_def *low_def =
+      nir_channels(b, &load->dest.ssa, (1 << low->num_components) - 1);
+   nir_ssa_def *high_def =
+      nir_channels(b, &load->dest.ssa,
+                   ((1 << high->num_components) - 1) << low->num_components);
+
+   nir_ssa_def_rewrite_uses(&low->intrin->dest.ssa, nir_src_for_ssa(low_def));
+   nir_ssa_def_rewrite_uses(&high->intrin->dest.ssa,
+                            nir_src_for_ssa(high_def));
+
+   nir_instr_remove(&low->intrin->instr);
+   nir_instr_remove(&high->intrin->instr);
+
+   return load;
+}
+
+static nir_intrinsic_instr *
+vectorize_stores(struct vectorize_state *state,
+                 const struct mem_access *second,
+                 const struct mem_access *low, const struct mem_access *high)
+{
+   nir_builder *b = &state->b;
+   nir_intrinsic_op op = low->intrin->intrinsic;
+   const unsigned num_components = low->num_components + high->num_components;
+   const unsigned value_src = value_src_index(op);
+
+   b->cursor = nir_before_instr(&second->intrin->instr);
+
+   nir_ssa_def *comps[4];
+   for (unsigned i = 0; i < low->num_components; i++)
+      comps[i] = nir_channel(b, low->intrin->src[value_src].ssa, i);
+   for (unsigned i = 0; i < high->num_components; i++) {
+      comps[low->num_components + i] =
+         nir_channel(b, high->intrin->src[value_src].ssa, i);
+   }
+   nir_ssa_def *value = nir_vec(b, comps, num_components);
+
+   nir_intrinsic_instr *store = nir_intrinsic_instr_create(b->shader, op);
+   store->num_components = num_components;
+   store->src[value_src] = nir_src_for_ssa(value);
+   if (low->resource)
+      nir_src_copy(&store->src[1], low->resource, store);
+   store->src[nir_intrinsic_infos[op].num_srcs - 1] =
+      nir_src_for_ssa(build_offset(b, low));
+   if (low->mode == MODE_SHARED)
+      nir_intrinsic_set_base(store, low->offset);
+   nir_intrinsic_set_write_mask(store, (1 << num_components) - 1);
+   nir_builder_instr_insert(b, &store->instr);
+
+   nir_instr_remove(&low->intrin->instr);
+   nir_instr_remove(&high->intrin->instr);
+
+   return store;
+}
+
+static void
+remove_pending(struct vectorize_state *state, unsigned index)
+{
+   state->pending[index] = state->pending[--state->num_pending];
+}
+
+static bool
+may_alias(const struct mem_access *a, const struct mem_access *b)
+{
+   if (a->mode != b->mode)
+      return false;
+
+   /* Only accesses relative to the same value can be told apart */
+   if (a->base != b->base || !resources_equal(a->resource, b->resource))
+      return true;
+
+   const int64_t a_end = a->offset + a->num_components * (a->bit_size / 8);
+   const int64_t b_end = b->offset + b->num_components * (b->bit_size / 8);
+   return a->offset < b_end && b->offset < a_end;
+}
+
+/**
+ * Drops the candidates which can't be moved across the given access, or
+ * across any side effect when access is NULL.
+ */
+static void
+invalidate_pending(struct vectorize_state *state,
+                   const struct mem_access *access)
+{
+   for (unsigned i = 0; i < state->num_pending;) {
+      struct mem_access *p = &state->pending[i];
+      bool conflict;
+
+      if (p->mode == MODE_UBO)
+         conflict = false;
+      else if (access == NULL)
+         conflict = true;
+      else if (p->is_store)
+         conflict = may_alias(p, access);
+      else
+         /* The load which gets combined with p hasn't been seen yet, so we
+          * can't tell whether the store aliases it.
+          */
+         conflict = access->is_store && p->mode == access->mode;
+
+      if (conflict)
+         remove_pending(state, i);
+      else
+         i++;
+   }
+}
+
+static void
+add_pending(struct vectorize_state *state, const struct mem_access *access)
+{
+   if (state->num_pending == state->pending_size) {
+      state->pending_size = MAX2(16, state->pending_size * 2);
+      state->pending = reralloc(NULL, state->pending, struct mem_access,
+                                state->pending_size);
+   }
+   state->pending[state->num_pending++] = *access;
+}
+
+static bool
+vectorize_block(struct vectorize_state *state, nir_block *block)
+{
+   bool progress = false;
+
+   state->num_pending = 0;
+
+   nir_foreach_instr_safe(instr, block) {
+      if (instr->type == nir_instr_type_call) {
+         invalidate_pending(state, NULL);
+         continue;
+      }
+
+      if (instr->type != nir_instr_type_intrinsic)
+         continue;
+
+      nir_intrinsic_instr *intrin = nir_instr_as_intrinsic(instr);
+      struct mem_access access;
+      if (!get_access_info(intrin, &access)) {
+         /* Anything with side effects, such as atomics, barriers or
+          * partial stores, may observe or modify any of the candidates.
+          */
+         const unsigned flags = nir_intrinsic_infos[intrin->intrinsic].flags;
+         if (!(flags & NIR_INTRINSIC_CAN_ELIMINATE))
+            invalidate_pending(state, NULL);
+         continue;
+      }
+
+      /* Loads are moved up and stores are moved down when combined, which
+       * is only fine if nothing in between touches the same memory.
+       */
+      invalidate_pending(state, &access);
+
+      for (unsigned i = 0; i < state->num_pending; i++) {
+         struct mem_access *p = &state->pending[i];
+         if (p->is_store != access.is_store || p->mode != access.mode)
+            continue;
+
+         const struct mem_access *low, *high;
+         if (can_vectorize(state, p, &access)) {
+            low = p;
+            high = &access;
+         } else if (can_vectorize(state, &access, p)) {
+            low = &access;
+            high = p;
+         } else {
+            continue;
+         }
+
+         nir_intrinsic_instr *merged = access.is_store ?
+            vectorize_stores(state, &access, low, high) :
+            vectorize_loads(state, p, low, high);
+
+         remove_pending(state, i);
+         get_access_info(merged, &access);
+         progress = true;
+         break;
+      }
+
+      add_pending(state, &access);
+   }
+
+   return progress;
+}
+
+bool
+nir_opt_load_store_vectorize(nir_shader *shader,
+                             nir_should_vectorize_mem_func callback,
+                             void *data)
+{
+   bool progress = false;
+
+   struct vectorize_state state = {
+      .callback = callback,
+      .data = data,
+   };
+
+   nir_foreach_function(function, shader) {
+      if (!function->impl)
+         continue;
+
+      nir_builder_init(&state.b, function->impl);
+
+      bool impl_progress = false;
+      nir_foreach_block(block, function->impl)
+         impl_progress |= vectorize_block(&state, block);
+
+      if (impl_progress) {
+         nir_metadata_preserve(function->impl, nir_metadata_block_index |
+                                               nir_metadata_dominance);
+         progress = true;
+      }
+   }
+
+   ralloc_free(state.pending);
+
+   return progress;
+}
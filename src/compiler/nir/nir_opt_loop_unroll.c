@@ -36,6 +36,13 @@
  */
 #define LOOP_UNROLL_LIMIT 26
 
+/* Number of vec4s worth of values which may stay live across iterations
+ * before we stop allowing loops to grow past LOOP_UNROLL_LIMIT for the sake
+ * of removing indirect array accesses.  Unrolling hands the scheduler all
+ * iterations at once, which tends to raise register pressure with it.
+ */
+#define LOOP_UNROLL_PRESSURE_LIMIT 16
+
 /* Prepare this loop for unrolling by first converting to lcssa and then
  * converting the phis from the top level of the loop body to regs.
  * Partially converting out of SSA allows us to unroll the loop without having
@@ -468,9 +475,74 @@ complex_unroll(nir_loop *loop, nir_loop_terminator *unlimit_term,
    _mesa_hash_table_destroy(remap_table, NULL);
 }
 
+/* Partially unroll a loop with an unknown trip count by placing factor
+ * copies of the body, including its terminators, inside the loop.  For
+ * example:
+ *
+ *     loop {
+ *        if (cond) break;
+ *        ...instrs...
+ *     }
+ *
+ * with a factor of 2 becomes:
+ *
+ *     loop {
+ *        if (cond) break;
+ *        ...instrs...
+ *        if (cond) break;
+ *        ...instrs...
+ *     }
+ */
+static void
+partial_unroll(nir_loop *loop, unsigned factor)
+{
+   loop_prepare_for_unroll(loop);
+
+   nir_cf_list loop_body;
+   nir_cf_extract(&loop_body, nir_before_block(nir_loop_first_block(loop)),
+                  nir_after_block(nir_loop_last_block(loop)));
+
+   struct hash_table *remap_table =
+      _mesa_hash_table_create(NULL, _mesa_hash_pointer,
+                              _mesa_key_pointer_equal);
+
+   for (unsigned i = 0; i < factor; i++) {
+      nir_cf_list cloned_body;
+      nir_cf_list_clone(&cloned_body, &loop_body, &loop->cf_node,
+                        remap_table);
+      nir_cf_reinsert(&cloned_body, nir_after_cf_list(&loop->body));
+   }
+
+   nir_cf_delete(&loop_body);
+
+   _mesa_hash_table_destroy(remap_table, NULL);
+}
+
+/* Returns the number of vec4s worth of values carried from one iteration to
+ * the next, which is what every iteration keeps live.
+ */
+static unsigned
+estimate_loop_pressure(nir_loop *loop)
+{
+   unsigned num_components = 0;
+
+   nir_foreach_instr(instr, nir_loop_first_block(loop)) {
+      if (instr->type != nir_instr_type_phi)
+         break;
+
+      nir_phi_instr *phi = nir_instr_as_phi(instr);
+      assert(phi->dest.is_ssa);
+      num_components += phi->dest.ssa.num_components *
+                        DIV_ROUND_UP(phi->dest.ssa.bit_size, 32);
+   }
+
+   return DIV_ROUND_UP(num_components, 4);
+}
+
 static bool
-is_loop_small_enough_to_unroll(nir_shader *shader, nir_loop_info *li)
+is_loop_small_enough_to_unroll(nir_shader *shader, nir_loop *loop)
 {
+   nir_loop_info *li = loop->info;
    unsigned max_iter = shader->options->max_unroll_iterations;
 
    if (li->trip_count > max_iter)
@@ -479,12 +551,61 @@ is_loop_small_enough_to_unroll(nir_shader *shader, nir_loop_info *li)
    if (li->force_unroll)
       return true;
 
-   bool loop_not_too_large =
-      li->num_instructions * li->trip_count <= max_iter * LOOP_UNROLL_LIMIT;
+   unsigned limit = max_iter * LOOP_UNROLL_LIMIT;
+
+   /* Every induction-indexed array access turns into a direct access once
+    * the loop is unrolled, which saves address computation and, for arrays
+    * which end up in registers, the indirect moves.  Allow the loop to grow
+    * by roughly what they would cost as long as that doesn't hurt register
+    * pressure too much.
+    */
+   if (li->num_induction_indirects &&
+       estimate_loop_pressure(loop) <= LOOP_UNROLL_PRESSURE_LIMIT)
+      limit += li->num_induction_indirects * li->trip_count * 4;
+
+   bool loop_not_too_large = li->num_instructions * li->trip_count <= limit;
 
    return loop_not_too_large;
 }
 
+/* Returns how many copies of the body a loop with an unknown trip count
+ * should be partially unrolled into, or 0 if it shouldn't be.
+ */
+static unsigned
+get_partial_unroll_factor(nir_shader *shader, nir_loop *loop)
+{
+   nir_loop_info *li = loop->info;
+   unsigned factor = shader->options->max_partial_unroll_factor;
+
+   if (factor < 2)
+      return 0;
+
+   /* Only handle loops with a single simple terminator, this also makes
+    * sure that we don't unroll the same loop again on the next pass since
+    * unrolling duplicates the terminator.
+    */
+   if (list_length(&li->loop_terminator_list) != 1)
+      return 0;
+
+   nir_loop_terminator *term =
+      list_first_entry(&li->loop_terminator_list, nir_loop_terminator,
+                       loop_terminator_link);
+   if (!nir_is_trivial_loop_if(term->nif, term->break_block))
+      return 0;
+
+   /* Partial unrolling only pays off for small bodies where the loop
+    * overhead is significant.
+    */
+   while (factor > 1 && li->num_instructions * factor > LOOP_UNROLL_LIMIT)
+      factor--;
+
+   if (factor < 2 ||
+       estimate_loop_pressure(loop) > LOOP_UNROLL_PRESSURE_LIMIT)
+      return 0;
+
+   return factor;
+}
+
 static bool
 process_loops(nir_shader *sh, nir_cf_node *cf_node, bool *innermost_loop)
 {
@@ -518,10 +639,16 @@ process_loops(nir_shader *sh, nir_cf_node *cf_node, bool *innermost_loop)
        */
       *innermost_loop = false;
 
-      if (loop->info->limiting_terminator == NULL)
+      if (loop->info->limiting_terminator == NULL) {
+         unsigned factor = get_partial_unroll_factor(sh, loop);
+         if (factor) {
+            partial_unroll(loop, factor);
+            progress = true;
+         }
          return progress;
+      }
 
-      if (!is_loop_small_enough_to_unroll(sh, loop->info))
+      if (!is_loop_small_enough_to_unroll(sh, loop))
          return progress;
 
       if (loop->info->is_trip_count_known) {
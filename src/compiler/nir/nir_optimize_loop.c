@@ -0,0 +1,91 @@
+/*
+ * Copyright © 2018 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ */
+
+#include "nir.h"
+
+/**
+ * Run \p passes over the shader in turn until none of them makes progress.
+ *
+ * This is the usual
+ *
+ *    do {
+ *       progress = false;
+ *       NIR_PASS(progress, nir, pass_a);
+ *       NIR_PASS(progress, nir, pass_b);
+ *       ...
+ *    } while (progress);
+ *
+ * loop, except that it stops as soon as every pass has run once on the
+ * current version of the shader, rather than finishing the round and then
+ * running another full one.  A pass that is marked as reaching its own fixed
+ * point isn't re-run until another pass has made progress.
+ *
+ * The shader may be replaced when NIR_TEST_CLONE or NIR_TEST_SERIALIZE are
+ * set, hence the double pointer.
+ *
+ * \return true if any pass made progress.
+ */
+bool
+nir_optimize_loop(nir_shader **shader, const nir_loop_pass *passes,
+                  unsigned num_passes)
+{
+   nir_shader *nir = *shader;
+   bool progress = false;
+
+   /* Number of passes in a row that found nothing to do.  Once that covers
+    * all of them, we're done.
+    */
+   unsigned idle = 0;
+
+   for (unsigned i = 0; idle < num_passes; i = (i + 1) % num_passes) {
+      const nir_loop_pass *pass = &passes[i];
+      bool pass_progress = false;
+
+      _PASS(nir,
+         nir_metadata_set_validation_flag(nir);
+         if (should_print_nir())
+            printf("%s\n", pass->name);
+         int64_t pass_start = should_collect_nir_pass_stats() ?
+                              nir_pass_stats_begin() : 0;
+         pass_progress = pass->run(nir);
+         if (should_collect_nir_pass_stats())
+            nir_pass_stats_end(pass->name, pass_start, pass_progress);
+         if (pass_progress) {
+            if (should_print_nir())
+               nir_print_shader(nir, stdout);
+            nir_metadata_check_validation_flag(nir);
+         }
+      );
+
+      if (pass_progress) {
+         progress = true;
+         idle = pass->fixed_point ? 1 : 0;
+      } else {
+         idle++;
+      }
+   }
+
+   *shader = nir;
+   return progress;
+}
@@ -0,0 +1,138 @@
+/*
+ * Copyright © 2018 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ */
+
+/**
+ * \file nir_pass_stats.c
+ *
+ * Per-process accounting of the time spent in each NIR pass, enabled with
+ * NIR_PASS_STATS=true.  Passes are aggregated by name across all shaders
+ * compiled by the process and the totals are printed to stderr at exit.
+ */
+
+#include "nir.h"
+#include "util/os_time.h"
+#include "util/simple_mtx.h"
+
+struct nir_pass_stats {
+   const char *name;
+   unsigned calls;
+   unsigned progress;
+   int64_t total_ns;
+};
+
+static simple_mtx_t stats_mutex = _SIMPLE_MTX_INITIALIZER_NP;
+static struct hash_table *stats_table;
+
+static int
+compare_stats(const void *a, const void *b)
+{
+   const struct nir_pass_stats *sa = *(const struct nir_pass_stats **)a;
+   const struct nir_pass_stats *sb = *(const struct nir_pass_stats **)b;
+
+   if (sa->total_ns != sb->total_ns)
+      return sa->total_ns < sb->total_ns ? 1 : -1;
+   return strcmp(sa->name, sb->name);
+}
+
+static void
+nir_pass_stats_dump(void)
+{
+   simple_mtx_lock(&stats_mutex);
+
+   unsigned count = stats_table->entries;
+   struct nir_pass_stats **sorted = malloc(count * sizeof(*sorted));
+   int64_t total_ns = 0;
+   unsigned i = 0;
+
+   if (!sorted) {
+      simple_mtx_unlock(&stats_mutex);
+      return;
+   }
+
+   struct hash_entry *entry;
+   hash_table_foreach(stats_table, entry) {
+      sorted[i++] = entry->data;
+      total_ns += ((struct nir_pass_stats *)entry->data)->total_ns;
+   }
+   qsort(sorted, count, sizeof(*sorted), compare_stats);
+
+   fprintf(stderr, "NIR pass statistics (%.3f ms total):\n",
+           total_ns / 1000000.0);
+   fprintf(stderr, "  %10s %6s %8s %8s  %s\n",
+           "ms", "%", "calls", "progress", "pass");
+   for (i = 0; i < count; i++) {
+      fprintf(stderr, "  %10.3f %6.2f %8u %8u  %s\n",
+              sorted[i]->total_ns / 1000000.0,
+              total_ns ? sorted[i]->total_ns * 100.0 / total_ns : 0.0,
+              sorted[i]->calls, sorted[i]->progress, sorted[i]->name);
+   }
+
+   free(sorted);
+   simple_mtx_unlock(&stats_mutex);
+}
+
+int64_t
+nir_pass_stats_begin(void)
+{
+   return os_time_get_nano();
+}
+
+void
+nir_pass_stats_end(const char *name, int64_t start, bool progress)
+{
+   int64_t elapsed = os_time_get_nano() - start;
+
+   simple_mtx_lock(&stats_mutex);
+
+   if (!stats_table) {
+      stats_table = _mesa_hash_table_create(NULL, _mesa_hash_string,
+                                            _mesa_key_string_equal);
+      if (!stats_table) {
+         simple_mtx_unlock(&stats_mutex);
+         return;
+      }
+      atexit(nir_pass_stats_dump);
+   }
+
+   struct hash_entry *entry = _mesa_hash_table_search(stats_table, name);
+   struct nir_pass_stats *stats;
+   if (entry) {
+      stats = entry->data;
+   } else {
+      stats = rzalloc(stats_table, struct nir_pass_stats);
+      if (!stats) {
+         simple_mtx_unlock(&stats_mutex);
+         return;
+      }
+      stats->name = ralloc_strdup(stats, name);
+      _mesa_hash_table_insert(stats_table, stats->name, stats);
+   }
+
+   stats->calls++;
+   if (progress)
+      stats->progress++;
+   stats->total_ns += elapsed;
+
+   simple_mtx_unlock(&stats_mutex);
+}
@@ -23,13 +23,13 @@
 
 #include "nir_serialize.h"
 #include "nir_control_flow.h"
-#include "util/u_dynarray.h"
 
-typedef struct {
-   size_t blob_offset;
-   nir_ssa_def *src;
-   nir_block *block;
-} write_phi_fixup;
+/* SSA definitions and blocks are by far the most common objects, so rather
+ * than going through the remap table they are referenced by their index in
+ * the function_impl, which is recomputed by write_function_impl().  The
+ * reader assigns the same indices by simply counting the objects it creates
+ * and resolves them through plain arrays.
+ */
 
 typedef struct {
    const nir_shader *nir;
@@ -41,11 +41,6 @@ typedef struct {
 
    /* the next index to assign to a NIR in-memory object */
    uintptr_t next_idx;
-
-   /* Array of write_phi_fixup structs representing phi sources that need to
-    * be resolved in the second pass.
-    */
-   struct util_dynarray phi_fixups;
 } write_ctx;
 
 typedef struct {
@@ -62,6 +57,15 @@ typedef struct {
    /* map from index to deserialized pointer */
    void **idx_table;
 
+   /* SSA definitions and blocks of the current function_impl by index */
+   nir_ssa_def **ssa_table;
+   unsigned num_ssa_defs;
+   unsigned ssa_table_len;
+
+   nir_block **block_table;
+   unsigned num_blocks;
+   unsigned block_table_len;
+
    /* List of phi sources. */
    struct list_head phi_srcs;
 
@@ -108,6 +112,27 @@ read_object(read_ctx *ctx)
    return read_lookup_object(ctx, blob_read_intptr(ctx->blob));
 }
 
+static void
+read_add_ssa_def(read_ctx *ctx, nir_ssa_def *def)
+{
+   assert(ctx->num_ssa_defs < ctx->ssa_table_len);
+   ctx->ssa_table[ctx->num_ssa_defs++] = def;
+}
+
+static nir_ssa_def *
+read_lookup_ssa_def(read_ctx *ctx, uintptr_t idx)
+{
+   assert(idx < ctx->ssa_table_len);
+   return ctx->ssa_table[idx];
+}
+
+static nir_block *
+read_lookup_block(read_ctx *ctx, uintptr_t idx)
+{
+   assert(idx < ctx->block_table_len);
+   return ctx->block_table[idx];
+}
+
 static void
 write_constant(write_ctx *ctx, const nir_constant *c)
 {
@@ -286,7 +311,7 @@ write_src(write_ctx *ctx, const nir_src *src)
     * address space would've been exhausted allocating the remap table!
     */
    if (src->is_ssa) {
-      uintptr_t idx = write_lookup_object(ctx, src->ssa) << 2;
+      uintptr_t idx = (uintptr_t)src->ssa->index << 2;
       idx |= 1;
       blob_write_intptr(ctx->blob, idx);
    } else {
@@ -308,7 +333,7 @@ read_src(read_ctx *ctx, nir_src *src, void *mem_ctx)
    uintptr_t idx = val >> 2;
    src->is_ssa = val & 0x1;
    if (src->is_ssa) {
-      src->ssa = read_lookup_object(ctx, idx);
+      src->ssa = read_lookup_ssa_def(ctx, idx);
    } else {
       bool is_indirect = val & 0x2;
       src->reg.reg = read_lookup_object(ctx, idx);
@@ -335,7 +360,6 @@ write_dest(write_ctx *ctx, const nir_dest *dst)
    }
    blob_write_uint32(ctx->blob, val);
    if (dst->is_ssa) {
-      write_add_object(ctx, &dst->ssa);
       if (dst->ssa.name)
          blob_write_string(ctx->blob, dst->ssa.name);
    } else {
@@ -357,7 +381,7 @@ read_dest(read_ctx *ctx, nir_dest *dst, nir_instr *instr)
       unsigned bit_size = val >> 5;
       char *name = has_name ? blob_read_string(ctx->blob) : NULL;
       nir_ssa_dest_init(instr, dst, num_components, bit_size, name);
-      read_add_object(ctx, &dst->ssa);
+      read_add_ssa_def(ctx, &dst->ssa);
    } else {
       bool is_indirect = val & 0x2;
       dst->reg.reg = read_object(ctx);
@@ -540,8 +564,10 @@ write_load_const(write_ctx *ctx, const nir_load_const_instr *lc)
    uint32_t val = lc->def.num_components;
    val |= lc->def.bit_size << 3;
    blob_write_uint32(ctx->blob, val);
-   blob_write_bytes(ctx->blob, (uint8_t *) &lc->value, sizeof(lc->value));
-   write_add_object(ctx, &lc->def);
+
+   /* The values of all bit sizes are packed at the start of the union */
+   blob_write_bytes(ctx->blob, (uint8_t *) &lc->value,
+                    lc->def.num_components * lc->def.bit_size / 8);
 }
 
 static nir_load_const_instr *
@@ -552,8 +578,9 @@ read_load_const(read_ctx *ctx)
    nir_load_const_instr *lc =
       nir_load_const_instr_create(ctx->nir, val & 0x7, val >> 3);
 
-   blob_copy_bytes(ctx->blob, (uint8_t *) &lc->value, sizeof(lc->value));
-   read_add_object(ctx, &lc->def);
+   blob_copy_bytes(ctx->blob, (uint8_t *) &lc->value,
+                   lc->def.num_components * lc->def.bit_size / 8);
+   read_add_ssa_def(ctx, &lc->def);
    return lc;
 }
 
@@ -563,7 +590,6 @@ write_ssa_undef(write_ctx *ctx, const nir_ssa_undef_instr *undef)
    uint32_t val = undef->def.num_components;
    val |= undef->def.bit_size << 3;
    blob_write_uint32(ctx->blob, val);
-   write_add_object(ctx, &undef->def);
 }
 
 static nir_ssa_undef_instr *
@@ -574,7 +600,7 @@ read_ssa_undef(read_ctx *ctx)
    nir_ssa_undef_instr *undef =
       nir_ssa_undef_instr_create(ctx->nir, val & 0x7, val >> 3);
 
-   read_add_object(ctx, &undef->def);
+   read_add_ssa_def(ctx, &undef->def);
    return undef;
 }
 
@@ -653,10 +679,9 @@ read_tex(read_ctx *ctx)
 static void
 write_phi(write_ctx *ctx, const nir_phi_instr *phi)
 {
-   /* Phi nodes are special, since they may reference SSA definitions and
-    * basic blocks that don't exist yet. We leave two empty uintptr_t's here,
-    * and then store enough information so that a later fixup pass can fill
-    * them in correctly.
+   /* Phi nodes may reference SSA definitions and basic blocks that come
+    * later in the shader.  Their indices are already known, so they can be
+    * written directly; only the reader needs a fixup pass.
     */
    write_dest(ctx, &phi->dest);
 
@@ -664,28 +689,9 @@ write_phi(write_ctx *ctx, const nir_phi_instr *phi)
 
    nir_foreach_phi_src(src, phi) {
       assert(src->src.is_ssa);
-      size_t blob_offset = blob_reserve_intptr(ctx->blob);
-      MAYBE_UNUSED size_t blob_offset2 = blob_reserve_intptr(ctx->blob);
-      assert(blob_offset + sizeof(uintptr_t) == blob_offset2);
-      write_phi_fixup fixup = {
-         .blob_offset = blob_offset,
-         .src = src->src.ssa,
-         .block = src->pred,
-      };
-      util_dynarray_append(&ctx->phi_fixups, write_phi_fixup, fixup);
-   }
-}
-
-static void
-write_fixup_phis(write_ctx *ctx)
-{
-   util_dynarray_foreach(&ctx->phi_fixups, write_phi_fixup, fixup) {
-      uintptr_t *blob_ptr = (uintptr_t *)(ctx->blob->data + fixup->blob_offset);
-      blob_ptr[0] = write_lookup_object(ctx, fixup->src);
-      blob_ptr[1] = write_lookup_object(ctx, fixup->block);
+      blob_write_intptr(ctx->blob, src->src.ssa->index);
+      blob_write_intptr(ctx->blob, src->pred->index);
    }
-
-   util_dynarray_clear(&ctx->phi_fixups);
 }
 
 static nir_phi_instr *
@@ -735,8 +741,8 @@ static void
 read_fixup_phis(read_ctx *ctx)
 {
    list_for_each_entry_safe(nir_phi_src, src, &ctx->phi_srcs, src.use_link) {
-      src->pred = read_lookup_object(ctx, (uintptr_t)src->pred);
-      src->src.ssa = read_lookup_object(ctx, (uintptr_t)src->src.ssa);
+      src->pred = read_lookup_block(ctx, (uintptr_t)src->pred);
+      src->src.ssa = read_lookup_ssa_def(ctx, (uintptr_t)src->src.ssa);
 
       /* Remove from this list */
       list_del(&src->src.use_link);
@@ -870,7 +876,6 @@ read_instr(read_ctx *ctx, nir_block *block)
 static void
 write_block(write_ctx *ctx, const nir_block *block)
 {
-   write_add_object(ctx, block);
    blob_write_uint32(ctx->blob, exec_list_length(&block->instr_list));
    nir_foreach_instr(instr, block)
       write_instr(ctx, instr);
@@ -886,7 +891,9 @@ read_block(read_ctx *ctx, struct exec_list *cf_list)
    nir_block *block =
       exec_node_data(nir_block, exec_list_get_tail(cf_list), cf_node.node);
 
-   read_add_object(ctx, block);
+   assert(ctx->num_blocks < ctx->block_table_len);
+   ctx->block_table[ctx->num_blocks++] = block;
+
    unsigned num_instrs = blob_read_uint32(ctx->blob);
    for (unsigned i = 0; i < num_instrs; i++) {
       read_instr(ctx, block);
@@ -997,12 +1004,21 @@ read_cf_list(read_ctx *ctx, struct exec_list *cf_list)
 static void
 write_function_impl(write_ctx *ctx, const nir_function_impl *fi)
 {
+   /* Renumbering doesn't change the shader, but it does make the liveness
+    * information, which is stored by SSA index, stale.
+    */
+   nir_function_impl *impl = (nir_function_impl *) fi;
+   nir_index_ssa_defs(impl);
+   nir_index_blocks(impl);
+   impl->valid_metadata &= ~nir_metadata_live_ssa_defs;
+
    write_var_list(ctx, &fi->locals);
    write_reg_list(ctx, &fi->registers);
    blob_write_uint32(ctx->blob, fi->reg_alloc);
+   blob_write_uint32(ctx->blob, fi->ssa_alloc);
+   blob_write_uint32(ctx->blob, fi->num_blocks);
 
    write_cf_list(ctx, &fi->body);
-   write_fixup_phis(ctx);
 }
 
 static nir_function_impl *
@@ -1015,9 +1031,21 @@ read_function_impl(read_ctx *ctx, nir_function *fxn)
    read_reg_list(ctx, &fi->registers);
    fi->reg_alloc = blob_read_uint32(ctx->blob);
 
+   ctx->ssa_table_len = blob_read_uint32(ctx->blob);
+   ctx->ssa_table = malloc(ctx->ssa_table_len * sizeof(nir_ssa_def *));
+   ctx->num_ssa_defs = 0;
+   ctx->block_table_len = blob_read_uint32(ctx->blob);
+   ctx->block_table = malloc(ctx->block_table_len * sizeof(nir_block *));
+   ctx->num_blocks = 0;
+
    read_cf_list(ctx, &fi->body);
    read_fixup_phis(ctx);
 
+   assert(ctx->num_ssa_defs == ctx->ssa_table_len);
+   assert(ctx->num_blocks == ctx->block_table_len);
+   free(ctx->ssa_table);
+   free(ctx->block_table);
+
    fi->valid_metadata = 0;
 
    return fi;
@@ -1075,7 +1103,6 @@ nir_serialize(struct blob *blob, const nir_shader *nir)
    ctx.next_idx = 0;
    ctx.blob = blob;
    ctx.nir = nir;
-   util_dynarray_init(&ctx.phi_fixups, NULL);
 
    size_t idx_size_offset = blob_reserve_intptr(blob);
 
@@ -1123,7 +1150,6 @@ nir_serialize(struct blob *blob, const nir_shader *nir)
    *(uintptr_t *)(blob->data + idx_size_offset) = ctx.next_idx;
 
    _mesa_hash_table_destroy(ctx.remap_table, NULL);
-   util_dynarray_fini(&ctx.phi_fixups);
 }
 
 nir_shader *
@@ -31,6 +31,7 @@
 extern "C" {
 #endif
 
+/* Note that this renumbers the SSA definitions and blocks of the shader. */
 void nir_serialize(struct blob *blob, const nir_shader *nir);
 nir_shader *nir_deserialize(void *mem_ctx,
                             const struct nir_shader_compiler_options *options,
@@ -33,6 +33,9 @@
  * The expectation is that drivers should call this when finished compiling the shader
  * (after any optimization, lowering, and so on).  However, it's also fine to call it
  * earlier, and even many times, trading CPU cycles for memory savings.
+ *
+ * Instructions allocated from the shader's instruction arena only get their children
+ * freed; their own memory stays in the arena until the shader is destroyed.
  */
 
 #define steal_list(mem_ctx, type, list) \
@@ -33,7 +33,7 @@ vtn_load_param_pointer(struct vtn_builder *b,
    if (param_type->base_type != vtn_base_type_pointer) {
       assert(param_type->base_type == vtn_base_type_image ||
              param_type->base_type == vtn_base_type_sampler);
-      ptr_type = rzalloc(b, struct vtn_type);
+      ptr_type = vtn_zalloc(b, struct vtn_type);
       ptr_type->base_type = vtn_base_type_pointer;
       ptr_type->deref = param_type;
       ptr_type->storage_class = SpvStorageClassUniformConstant;
@@ -49,7 +49,7 @@ vtn_cfg_handle_prepass_instruction(struct vtn_builder *b, SpvOp opcode,
    switch (opcode) {
    case SpvOpFunction: {
       vtn_assert(b->func == NULL);
-      b->func = rzalloc(b, struct vtn_function);
+      b->func = vtn_zalloc(b, struct vtn_function);
 
       list_inithead(&b->func->body);
       b->func->control = w[3];
@@ -145,10 +145,10 @@ vtn_cfg_handle_prepass_instruction(struct vtn_builder *b, SpvOp opcode,
          struct vtn_value *val =
             vtn_push_value(b, w[2], vtn_value_type_sampled_image);
 
-         val->sampled_image = ralloc(b, struct vtn_sampled_image);
+         val->sampled_image = vtn_alloc(b, struct vtn_sampled_image);
          val->sampled_image->type = type;
 
-         struct vtn_type *sampler_type = rzalloc(b, struct vtn_type);
+         struct vtn_type *sampler_type = vtn_zalloc(b, struct vtn_type);
          sampler_type->base_type = vtn_base_type_sampler;
          sampler_type->type = glsl_bare_sampler_type();
 
@@ -182,7 +182,7 @@ vtn_cfg_handle_prepass_instruction(struct vtn_builder *b, SpvOp opcode,
 
    case SpvOpLabel: {
       vtn_assert(b->block == NULL);
-      b->block = rzalloc(b, struct vtn_block);
+      b->block = vtn_zalloc(b, struct vtn_block);
       b->block->node.type = vtn_cf_node_type_block;
       b->block->label = w;
       vtn_push_value(b, w[1], vtn_value_type_block)->block = b->block;
@@ -237,7 +237,7 @@ vtn_add_case(struct vtn_builder *b, struct vtn_switch *swtch,
       return;
 
    if (case_block->switch_case == NULL) {
-      struct vtn_case *c = ralloc(b, struct vtn_case);
+      struct vtn_case *c = vtn_alloc(b, struct vtn_case);
 
       list_inithead(&c->body);
       c->start_block = case_block;
@@ -321,7 +321,7 @@ vtn_cfg_walk_blocks(struct vtn_builder *b, struct list_head *cf_list,
    while (block != end) {
       if (block->merge && (*block->merge & SpvOpCodeMask) == SpvOpLoopMerge &&
           !block->loop) {
-         struct vtn_loop *loop = ralloc(b, struct vtn_loop);
+         struct vtn_loop *loop = vtn_alloc(b, struct vtn_loop);
 
          loop->node.type = vtn_cf_node_type_loop;
          list_inithead(&loop->body);
@@ -406,7 +406,7 @@ vtn_cfg_walk_blocks(struct vtn_builder *b, struct list_head *cf_list,
          struct vtn_block *else_block =
             vtn_value(b, block->branch[3], vtn_value_type_block)->block;
 
-         struct vtn_if *if_stmt = ralloc(b, struct vtn_if);
+         struct vtn_if *if_stmt = vtn_alloc(b, struct vtn_if);
 
          if_stmt->node.type = vtn_cf_node_type_if;
          if_stmt->condition = block->branch[1];
@@ -483,7 +483,7 @@ vtn_cfg_walk_blocks(struct vtn_builder *b, struct list_head *cf_list,
          struct vtn_block *break_block =
             vtn_value(b, block->merge[1], vtn_value_type_block)->block;
 
-         struct vtn_switch *swtch = ralloc(b, struct vtn_switch);
+         struct vtn_switch *swtch = vtn_alloc(b, struct vtn_switch);
 
          swtch->node.type = vtn_cf_node_type_switch;
          swtch->selector = block->branch[1];
@@ -541,6 +541,15 @@ struct vtn_decoration {
    };
 };
 
+#define vtn_alloc(b, type) \
+   ((type *) linear_alloc_child((b)->lin_ctx, sizeof(type)))
+#define vtn_zalloc(b, type) \
+   ((type *) linear_zalloc_child((b)->lin_ctx, sizeof(type)))
+#define vtn_alloc_array(b, type, count) \
+   ((type *) linear_alloc_child((b)->lin_ctx, sizeof(type) * (count)))
+#define vtn_zalloc_array(b, type, count) \
+   ((type *) linear_zalloc_child((b)->lin_ctx, sizeof(type) * (count)))
+
 struct vtn_builder {
    nir_builder nb;
 
@@ -554,6 +563,12 @@ struct vtn_builder {
    const struct spirv_to_nir_options *options;
    struct vtn_block *block;
 
+   /* Linear allocator for the vtn_* objects.  None of them are ever freed
+    * individually or used as a ralloc parent, so they all live until the
+    * builder is destroyed.
+    */
+   void *lin_ctx;
+
    /* Current offset, file, line, and column.  Useful for debugging.  Set
     * automatically by vtn_foreach_instruction.
     */
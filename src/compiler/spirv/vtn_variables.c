@@ -108,7 +108,7 @@ vtn_access_chain_pointer_dereference(struct vtn_builder *b,
       }
    }
 
-   struct vtn_pointer *ptr = rzalloc(b, struct vtn_pointer);
+   struct vtn_pointer *ptr = vtn_zalloc(b, struct vtn_pointer);
    ptr->mode = base->mode;
    ptr->type = type;
    ptr->var = base->var;
@@ -336,7 +336,7 @@ vtn_ssa_offset_pointer_dereference(struct vtn_builder *b,
       }
    }
 
-   struct vtn_pointer *ptr = rzalloc(b, struct vtn_pointer);
+   struct vtn_pointer *ptr = vtn_zalloc(b, struct vtn_pointer);
    ptr->mode = base->mode;
    ptr->type = type;
    ptr->block_index = block_index;
@@ -362,7 +362,7 @@ struct vtn_pointer *
 vtn_pointer_for_variable(struct vtn_builder *b,
                          struct vtn_variable *var, struct vtn_type *ptr_type)
 {
-   struct vtn_pointer *pointer = rzalloc(b, struct vtn_pointer);
+   struct vtn_pointer *pointer = vtn_zalloc(b, struct vtn_pointer);
 
    pointer->mode = var->mode;
    pointer->type = var->type;
@@ -873,9 +873,9 @@ _vtn_variable_load_store(struct vtn_builder *b, bool load,
       unsigned elems = glsl_get_length(ptr->type->type);
       if (load) {
          vtn_assert(*inout == NULL);
-         *inout = rzalloc(b, struct vtn_ssa_value);
+         *inout = vtn_zalloc(b, struct vtn_ssa_value);
          (*inout)->type = ptr->type->type;
-         (*inout)->elems = rzalloc_array(b, struct vtn_ssa_value *, elems);
+         (*inout)->elems = vtn_zalloc_array(b, struct vtn_ssa_value *, elems);
       }
 
       struct vtn_access_chain chain = {
@@ -1582,7 +1582,7 @@ vtn_pointer_from_ssa(struct vtn_builder *b, nir_ssa_def *ssa,
    while (interface_type->base_type == vtn_base_type_array)
       interface_type = interface_type->array_element;
 
-   struct vtn_pointer *ptr = rzalloc(b, struct vtn_pointer);
+   struct vtn_pointer *ptr = vtn_zalloc(b, struct vtn_pointer);
    nir_variable_mode nir_mode;
    ptr->mode = vtn_storage_class_to_mode(b, ptr_type->storage_class,
                                          interface_type, &nir_mode);
@@ -1666,7 +1666,7 @@ vtn_create_variable(struct vtn_builder *b, struct vtn_value *val,
       break;
    }
 
-   struct vtn_variable *var = rzalloc(b, struct vtn_variable);
+   struct vtn_variable *var = vtn_zalloc(b, struct vtn_variable);
    var->type = type;
    var->mode = mode;
 
@@ -1906,7 +1906,7 @@ vtn_handle_variables(struct vtn_builder *b, SpvOp opcode,
           */
          struct vtn_value *val =
             vtn_push_value(b, w[2], vtn_value_type_sampled_image);
-         val->sampled_image = ralloc(b, struct vtn_sampled_image);
+         val->sampled_image = vtn_alloc(b, struct vtn_sampled_image);
          val->sampled_image->type = base_val->sampled_image->type;
          val->sampled_image->image =
             vtn_pointer_dereference(b, base_val->sampled_image->image, chain);
@@ -108,16 +108,25 @@ dri_set_background_context(void *loaderPrivate)
    _eglBindContextToThread(ctx, t);
 }
 
+static void (*dri2_glFlush)(void);
+
+static void
+dri2_gl_flush_lookup(void)
+{
+   dri2_glFlush = _glapi_get_proc_address("glFlush");
+}
+
 static void
 dri2_gl_flush()
 {
-   static void (*glFlush)(void);
-   static mtx_t glFlushMutex = _MTX_INITIALIZER_NP;
+   static once_flag glFlushOnce = ONCE_FLAG_INIT;
+   void (*glFlush)(void);
 
-   mtx_lock(&glFlushMutex);
-   if (!glFlush)
-      glFlush = _glapi_get_proc_address("glFlush");
-   mtx_unlock(&glFlushMutex);
+   /* This runs on every context switch, so avoid taking a lock once the
+    * entry point is known.
+    */
+   call_once(&glFlushOnce, dri2_gl_flush_lookup);
+   glFlush = dri2_glFlush;
 
    /* if glFlush is not available things are horribly broken */
    if (!glFlush) {
@@ -1513,6 +1522,17 @@ dri2_make_current(_EGLDriver *drv, _EGLDisplay *disp, _EGLSurface *dsurf,
       return EGL_FALSE;
    }
 
+   /* Re-binding what is already current is a no-op: there is nothing to
+    * flush and the driver already has these drawables.  Just drop the
+    * references _eglBindContext handed back to us.
+    */
+   if (old_ctx == ctx && old_dsurf == dsurf && old_rsurf == rsurf) {
+      _eglPutSurface(old_dsurf);
+      _eglPutSurface(old_rsurf);
+      _eglPutContext(old_ctx);
+      return EGL_TRUE;
+   }
+
    /* flush before context switch */
    if (old_ctx)
       dri2_gl_flush();
@@ -36,8 +36,33 @@
 #include "cso_hash.h"
 
 
+/**
+ * Open-addressing lookup table in front of each cso_hash.
+ *
+ * The cso_hash allocates a node per entry and chains them, so lookups
+ * chase pointers all over the heap.  The slots here keep the hash key
+ * next to the state pointer, so that a lookup normally touches a single
+ * cache line before comparing the state template itself.  Slots are filled
+ * on insertion and on hits in the cso_hash, and the whole table is dropped
+ * whenever states are removed, so it never outlives a state.
+ */
+struct cso_lookup_slot {
+   unsigned hash_key;
+   void *state;         /**< NULL for empty slots */
+};
+
+struct cso_lookup_table {
+   struct cso_lookup_slot *slots;
+   unsigned size;       /**< power of two, or zero */
+   unsigned shift;      /**< 32 - log2(size) */
+   unsigned count;
+};
+
+#define CSO_LOOKUP_MIN_ORDER 6
+
 struct cso_cache {
    struct cso_hash *hashes[CSO_CACHE_MAX];
+   struct cso_lookup_table tables[CSO_CACHE_MAX];
    int    max_size;
 
    cso_sanitize_callback sanitize_cb;
@@ -80,6 +105,97 @@ unsigned cso_construct_key(void *item, int item_size)
    return hash_key((item), item_size);
 }
 
+static inline unsigned
+lookup_table_index(const struct cso_lookup_table *table, unsigned hash_key)
+{
+   /* The keys are plain xors of the states, spread them over the table */
+   return (uint32_t)(hash_key * 2654435761u) >> table->shift;
+}
+
+static void *
+lookup_table_find(const struct cso_lookup_table *table, unsigned hash_key,
+                  const void *templ, unsigned size)
+{
+   unsigned i;
+
+   if (!table->count)
+      return NULL;
+
+   for (i = lookup_table_index(table, hash_key);
+        table->slots[i].state;
+        i = (i + 1) & (table->size - 1)) {
+      if (table->slots[i].hash_key == hash_key &&
+          !memcmp(table->slots[i].state, templ, size))
+         return table->slots[i].state;
+   }
+
+   return NULL;
+}
+
+static void
+lookup_table_put(struct cso_lookup_table *table, unsigned hash_key,
+                 void *state)
+{
+   unsigned i = lookup_table_index(table, hash_key);
+
+   while (table->slots[i].state)
+      i = (i + 1) & (table->size - 1);
+
+   table->slots[i].hash_key = hash_key;
+   table->slots[i].state = state;
+   table->count++;
+}
+
+static boolean
+lookup_table_grow(struct cso_lookup_table *table)
+{
+   struct cso_lookup_table old = *table;
+   unsigned order = CSO_LOOKUP_MIN_ORDER;
+   unsigned i;
+
+   if (old.size)
+      order = 32 - old.shift + 1;
+
+   table->slots = CALLOC(1 << order, sizeof(*table->slots));
+   if (!table->slots) {
+      *table = old;
+      return FALSE;
+   }
+   table->size = 1 << order;
+   table->shift = 32 - order;
+   table->count = 0;
+
+   for (i = 0; i < old.size; i++) {
+      if (old.slots[i].state)
+         lookup_table_put(table, old.slots[i].hash_key, old.slots[i].state);
+   }
+   FREE(old.slots);
+
+   return TRUE;
+}
+
+static void
+lookup_table_add(struct cso_lookup_table *table, unsigned hash_key,
+                 void *state)
+{
+   /* Keep at least half of the slots empty so probe sequences stay short.
+    * Failing to grow just means the state is only found the slow way.
+    */
+   if ((table->count + 1) * 2 > table->size && !lookup_table_grow(table))
+      return;
+
+   lookup_table_put(table, hash_key, state);
+}
+
+static void
+lookup_table_clear(struct cso_lookup_table *table)
+{
+   if (table->count) {
+      memset(table->slots, 0, table->size * sizeof(*table->slots));
+      table->count = 0;
+   }
+}
+
 static inline struct cso_hash *_cso_hash_for_type(struct cso_cache *sc, enum cso_cache_type type)
 {
    struct cso_hash *hash;
@@ -157,8 +273,15 @@ static inline void sanitize_hash(struct cso_cache *sc,
                                  enum cso_cache_type type,
                                  int max_size)
 {
-   if (sc->sanitize_cb)
+   if (sc->sanitize_cb) {
+      int size = cso_hash_size(hash);
+
       sc->sanitize_cb(hash, type, max_size, sc->sanitize_data);
+
+      /* States may have been deleted */
+      if (cso_hash_size(hash) != size)
+         lookup_table_clear(&sc->tables[type]);
+   }
 }
 
 
@@ -188,9 +311,15 @@ cso_insert_state(struct cso_cache *sc,
                  void *state)
 {
    struct cso_hash *hash = _cso_hash_for_type(sc, type);
+   struct cso_hash_iter iter;
+
    sanitize_hash(sc, hash, type, sc->max_size);
 
-   return cso_hash_insert(hash, hash_key, state);
+   iter = cso_hash_insert(hash, hash_key, state);
+   if (!cso_hash_iter_is_null(iter))
+      lookup_table_add(&sc->tables[type], hash_key, state);
+
+   return iter;
 }
 
 struct cso_hash_iter
@@ -236,16 +365,44 @@ struct cso_hash_iter cso_find_state_template(struct cso_cache *sc,
    return iter;
 }
 
+/**
+ * Return the state matching the first \p size bytes of \p templ, or NULL.
+ * Unlike cso_find_state_template() this mostly avoids walking the cso_hash,
+ * which is what state changes go through.
+ */
+void *cso_lookup_state(struct cso_cache *sc,
+                       unsigned hash_key, enum cso_cache_type type,
+                       const void *templ, unsigned size)
+{
+   struct cso_lookup_table *table = &sc->tables[type];
+   struct cso_hash_iter iter;
+   void *state;
+
+   state = lookup_table_find(table, hash_key, templ, size);
+   if (state)
+      return state;
+
+   iter = cso_find_state_template(sc, hash_key, type, (void *)templ, size);
+   if (cso_hash_iter_is_null(iter))
+      return NULL;
+
+   state = cso_hash_iter_data(iter);
+   lookup_table_add(table, hash_key, state);
+   return state;
+}
+
 void * cso_take_state(struct cso_cache *sc,
                       unsigned hash_key, enum cso_cache_type type)
 {
    struct cso_hash *hash = _cso_hash_for_type(sc, type);
+
+   lookup_table_clear(&sc->tables[type]);
    return cso_hash_take(hash, hash_key);
 }
 
 struct cso_cache *cso_cache_create(void)
 {
-   struct cso_cache *sc = MALLOC_STRUCT(cso_cache);
+   struct cso_cache *sc = CALLOC_STRUCT(cso_cache);
    int i;
    if (!sc)
       return NULL;
@@ -291,8 +448,10 @@ void cso_cache_delete(struct cso_cache *sc)
    cso_for_each_state(sc, CSO_SAMPLER, delete_sampler_state, 0);
    cso_for_each_state(sc, CSO_VELEMENTS, delete_velements, 0);
 
-   for (i = 0; i < CSO_CACHE_MAX; i++)
+   for (i = 0; i < CSO_CACHE_MAX; i++) {
       cso_hash_delete(sc->hashes[i]);
+      FREE(sc->tables[i].slots);
+   }
 
    FREE(sc);
 }
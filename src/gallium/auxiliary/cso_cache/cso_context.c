@@ -86,6 +86,11 @@ struct cso_context {
     * It tracks the highest sampler seen in cso_single_sampler.
     */
    int max_sampler_seen;
+   /* Whether cso_single_sampler changed any slot since the last
+    * cso_single_sampler_done, and how many samplers were last bound.
+    */
+   bool samplers_changed;
+   unsigned nr_samplers_bound[PIPE_SHADER_TYPES];
 
    struct pipe_vertex_buffer vertex_buffer0_current;
    struct pipe_vertex_buffer vertex_buffer0_saved;
@@ -115,6 +120,7 @@ struct cso_context {
    void *tesseval_shader, *tesseval_shader_saved;
    void *compute_shader;
    void *velements, *velements_saved;
+   struct cso_velements *velements_cso; /**< CSO of velements, if known */
    struct pipe_query *render_condition, *render_condition_saved;
    uint render_condition_mode, render_condition_mode_saved;
    boolean render_condition_cond, render_condition_cond_saved;
@@ -454,18 +460,19 @@ enum pipe_error cso_set_blend(struct cso_context *ctx,
                               const struct pipe_blend_state *templ)
 {
    unsigned key_size, hash_key;
-   struct cso_hash_iter iter;
+   struct cso_blend *cso;
    void *handle;
 
    key_size = templ->independent_blend_enable ?
       sizeof(struct pipe_blend_state) :
       (char *)&(templ->rt[1]) - (char *)templ;
    hash_key = cso_construct_key((void*)templ, key_size);
-   iter = cso_find_state_template(ctx->cache, hash_key, CSO_BLEND,
-                                  (void*)templ, key_size);
+   cso = cso_lookup_state(ctx->cache, hash_key, CSO_BLEND, templ, key_size);
+
+   if (!cso) {
+      struct cso_hash_iter iter;
 
-   if (cso_hash_iter_is_null(iter)) {
-      struct cso_blend *cso = MALLOC(sizeof(struct cso_blend));
+      cso = MALLOC(sizeof(struct cso_blend));
       if (!cso)
          return PIPE_ERROR_OUT_OF_MEMORY;
 
@@ -480,13 +487,10 @@ enum pipe_error cso_set_blend(struct cso_context *ctx,
          FREE(cso);
          return PIPE_ERROR_OUT_OF_MEMORY;
       }
-
-      handle = cso->data;
-   }
-   else {
-      handle = ((struct cso_blend *)cso_hash_iter_data(iter))->data;
    }
 
+   handle = cso->data;
+
    if (ctx->blend != handle) {
       ctx->blend = handle;
       ctx->pipe->bind_blend_state(ctx->pipe, handle);
@@ -519,15 +523,15 @@ cso_set_depth_stencil_alpha(struct cso_context *ctx,
 {
    unsigned key_size = sizeof(struct pipe_depth_stencil_alpha_state);
    unsigned hash_key = cso_construct_key((void*)templ, key_size);
-   struct cso_hash_iter iter = cso_find_state_template(ctx->cache,
-                                                       hash_key,
-                                                       CSO_DEPTH_STENCIL_ALPHA,
-                                                       (void*)templ, key_size);
+   struct cso_depth_stencil_alpha *cso =
+      cso_lookup_state(ctx->cache, hash_key, CSO_DEPTH_STENCIL_ALPHA,
+                       templ, key_size);
    void *handle;
 
-   if (cso_hash_iter_is_null(iter)) {
-      struct cso_depth_stencil_alpha *cso =
-         MALLOC(sizeof(struct cso_depth_stencil_alpha));
+   if (!cso) {
+      struct cso_hash_iter iter;
+
+      cso = MALLOC(sizeof(struct cso_depth_stencil_alpha));
       if (!cso)
          return PIPE_ERROR_OUT_OF_MEMORY;
 
@@ -544,14 +548,10 @@ cso_set_depth_stencil_alpha(struct cso_context *ctx,
          FREE(cso);
          return PIPE_ERROR_OUT_OF_MEMORY;
       }
-
-      handle = cso->data;
-   }
-   else {
-      handle = ((struct cso_depth_stencil_alpha *)
-                cso_hash_iter_data(iter))->data;
    }
 
+   handle = cso->data;
+
    if (ctx->depth_stencil != handle) {
       ctx->depth_stencil = handle;
       ctx->pipe->bind_depth_stencil_alpha_state(ctx->pipe, handle);
@@ -584,10 +584,8 @@ enum pipe_error cso_set_rasterizer(struct cso_context *ctx,
 {
    unsigned key_size = sizeof(struct pipe_rasterizer_state);
    unsigned hash_key = cso_construct_key((void*)templ, key_size);
-   struct cso_hash_iter iter = cso_find_state_template(ctx->cache,
-                                                       hash_key,
-                                                       CSO_RASTERIZER,
-                                                       (void*)templ, key_size);
+   struct cso_rasterizer *cso =
+      cso_lookup_state(ctx->cache, hash_key, CSO_RASTERIZER, templ, key_size);
    void *handle = NULL;
 
    /* We can't have both point_quad_rasterization (sprites) and point_smooth
@@ -595,8 +593,10 @@ enum pipe_error cso_set_rasterizer(struct cso_context *ctx,
     */
    assert(!(templ->point_quad_rasterization && templ->point_smooth));
 
-   if (cso_hash_iter_is_null(iter)) {
-      struct cso_rasterizer *cso = MALLOC(sizeof(struct cso_rasterizer));
+   if (!cso) {
+      struct cso_hash_iter iter;
+
+      cso = MALLOC(sizeof(struct cso_rasterizer));
       if (!cso)
          return PIPE_ERROR_OUT_OF_MEMORY;
 
@@ -611,13 +611,10 @@ enum pipe_error cso_set_rasterizer(struct cso_context *ctx,
          FREE(cso);
          return PIPE_ERROR_OUT_OF_MEMORY;
       }
-
-      handle = cso->data;
-   }
-   else {
-      handle = ((struct cso_rasterizer *)cso_hash_iter_data(iter))->data;
    }
 
+   handle = cso->data;
+
    if (ctx->rasterizer != handle) {
       ctx->rasterizer = handle;
       ctx->pipe->bind_rasterizer_state(ctx->pipe, handle);
@@ -1055,7 +1052,7 @@ cso_set_vertex_elements(struct cso_context *ctx,
 {
    struct u_vbuf *vbuf = ctx->vbuf;
    unsigned key_size, hash_key;
-   struct cso_hash_iter iter;
+   struct cso_velements *cso;
    void *handle;
    struct cso_velems_state velems_state;
 
@@ -1064,6 +1061,18 @@ cso_set_vertex_elements(struct cso_context *ctx,
       return PIPE_OK;
    }
 
+   /* The state tracker sets the vertex elements for every change of vertex
+    * arrays, but their layout rarely changes, so check the bound CSO first.
+    * It is never deleted from the cache while it's bound.
+    */
+   cso = ctx->velements_cso;
+   if (cso && cso->state.count == count &&
+       memcmp(cso->state.velems, states,
+              sizeof(struct pipe_vertex_element) * count) == 0) {
+      assert(ctx->velements == cso->data);
+      return PIPE_OK;
+   }
+
    /* Need to include the count into the stored state data too.
     * Otherwise first few count pipe_vertex_elements could be identical
     * even if count is different, and there's no guarantee the hash would
@@ -1074,11 +1083,13 @@ cso_set_vertex_elements(struct cso_context *ctx,
    memcpy(velems_state.velems, states,
           sizeof(struct pipe_vertex_element) * count);
    hash_key = cso_construct_key((void*)&velems_state, key_size);
-   iter = cso_find_state_template(ctx->cache, hash_key, CSO_VELEMENTS,
-                                  (void*)&velems_state, key_size);
+   cso = cso_lookup_state(ctx->cache, hash_key, CSO_VELEMENTS,
+                          &velems_state, key_size);
+
+   if (!cso) {
+      struct cso_hash_iter iter;
 
-   if (cso_hash_iter_is_null(iter)) {
-      struct cso_velements *cso = MALLOC(sizeof(struct cso_velements));
+      cso = MALLOC(sizeof(struct cso_velements));
       if (!cso)
          return PIPE_ERROR_OUT_OF_MEMORY;
 
@@ -1094,13 +1105,11 @@ cso_set_vertex_elements(struct cso_context *ctx,
          FREE(cso);
          return PIPE_ERROR_OUT_OF_MEMORY;
       }
-
-      handle = cso->data;
-   }
-   else {
-      handle = ((struct cso_velements *)cso_hash_iter_data(iter))->data;
    }
 
+   handle = cso->data;
+   ctx->velements_cso = cso;
+
    if (ctx->velements != handle) {
       ctx->velements = handle;
       ctx->pipe->bind_vertex_elements_state(ctx->pipe, handle);
@@ -1134,6 +1143,7 @@ cso_restore_vertex_elements(struct cso_context *ctx)
 
    if (ctx->velements != ctx->velements_saved) {
       ctx->velements = ctx->velements_saved;
+      ctx->velements_cso = NULL;
       ctx->pipe->bind_vertex_elements_state(ctx->pipe, ctx->velements_saved);
    }
    ctx->velements_saved = NULL;
@@ -1203,38 +1213,44 @@ cso_single_sampler(struct cso_context *ctx, enum pipe_shader_type shader_stage,
                    unsigned idx, const struct pipe_sampler_state *templ)
 {
    if (templ) {
-      unsigned key_size = sizeof(struct pipe_sampler_state);
-      unsigned hash_key = cso_construct_key((void*)templ, key_size);
-      struct cso_sampler *cso;
-      struct cso_hash_iter iter =
-         cso_find_state_template(ctx->cache,
-                                 hash_key, CSO_SAMPLER,
-                                 (void *) templ, key_size);
-
-      if (cso_hash_iter_is_null(iter)) {
-         cso = MALLOC(sizeof(struct cso_sampler));
-         if (!cso)
-            return;
-
-         memcpy(&cso->state, templ, sizeof(*templ));
-         cso->data = ctx->pipe->create_sampler_state(ctx->pipe, &cso->state);
-         cso->delete_state =
-            (cso_state_callback) ctx->pipe->delete_sampler_state;
-         cso->context = ctx->pipe;
-         cso->hash_key = hash_key;
-
-         iter = cso_insert_state(ctx->cache, hash_key, CSO_SAMPLER, cso);
-         if (cso_hash_iter_is_null(iter)) {
-            FREE(cso);
-            return;
+      struct sampler_info *info = &ctx->samplers[shader_stage];
+      struct cso_sampler *cso = info->cso_samplers[idx];
+
+      /* Skip the hash lookup if the slot already holds this state. */
+      if (!cso || memcmp(&cso->state, templ, sizeof(*templ)) != 0) {
+         unsigned key_size = sizeof(struct pipe_sampler_state);
+         unsigned hash_key = cso_construct_key((void*)templ, key_size);
+
+         cso = cso_lookup_state(ctx->cache, hash_key, CSO_SAMPLER, templ,
+                                key_size);
+
+         if (!cso) {
+            struct cso_hash_iter iter;
+
+            cso = MALLOC(sizeof(struct cso_sampler));
+            if (!cso)
+               return;
+
+            memcpy(&cso->state, templ, sizeof(*templ));
+            cso->data = ctx->pipe->create_sampler_state(ctx->pipe,
+                                                        &cso->state);
+            cso->delete_state =
+               (cso_state_callback) ctx->pipe->delete_sampler_state;
+            cso->context = ctx->pipe;
+            cso->hash_key = hash_key;
+
+            iter = cso_insert_state(ctx->cache, hash_key, CSO_SAMPLER, cso);
+            if (cso_hash_iter_is_null(iter)) {
+               FREE(cso);
+               return;
+            }
          }
-      }
-      else {
-         cso = cso_hash_iter_data(iter);
+
+         ctx->samplers_changed |= info->samplers[idx] != cso->data;
       }
 
-      ctx->samplers[shader_stage].cso_samplers[idx] = cso;
-      ctx->samplers[shader_stage].samplers[idx] = cso->data;
+      info->cso_samplers[idx] = cso;
+      info->samplers[idx] = cso->data;
       ctx->max_sampler_seen = MAX2(ctx->max_sampler_seen, (int)idx);
    }
 }
@@ -1248,14 +1264,23 @@ cso_single_sampler_done(struct cso_context *ctx,
                         enum pipe_shader_type shader_stage)
 {
    struct sampler_info *info = &ctx->samplers[shader_stage];
+   unsigned count = ctx->max_sampler_seen + 1;
 
    if (ctx->max_sampler_seen == -1)
       return;
 
-   ctx->pipe->bind_sampler_states(ctx->pipe, shader_stage, 0,
-                                  ctx->max_sampler_seen + 1,
-                                  info->samplers);
+   /* Drivers only accept bindings starting at slot 0, so the best we can do
+    * is to skip the call when the bound samplers didn't change.
+    */
+   if (ctx->samplers_changed ||
+       count != ctx->nr_samplers_bound[shader_stage]) {
+      ctx->pipe->bind_sampler_states(ctx->pipe, shader_stage, 0, count,
+                                     info->samplers);
+      ctx->nr_samplers_bound[shader_stage] = count;
+   }
+
    ctx->max_sampler_seen = -1;
+   ctx->samplers_changed = false;
 }
 
 
@@ -1305,6 +1330,8 @@ cso_restore_fragment_samplers(struct cso_context *ctx)
       }
    }
 
+   ctx->samplers_changed = true;
+
    cso_single_sampler_done(ctx, PIPE_SHADER_FRAGMENT);
 }
 
@@ -1708,6 +1735,43 @@ cso_draw_vbo(struct cso_context *cso,
    }
 }
 
+/**
+ * Draw the given ranges with pipe_context::multi_draw, or one by one if the
+ * driver doesn't have it or vertex buffers might need translation.
+ */
+void
+cso_multi_draw(struct cso_context *cso,
+               const struct pipe_draw_info *info,
+               const struct pipe_draw_range *draws,
+               unsigned num_draws)
+{
+   struct pipe_context *pipe = cso->pipe;
+
+   assert(!info->has_user_indices);
+   assert(!info->indirect && !info->count_from_stream_output);
+
+   if (!cso->vbuf && pipe->multi_draw) {
+      pipe->multi_draw(pipe, info, draws, num_draws);
+   } else {
+      struct pipe_draw_info draw = *info;
+
+      for (unsigned i = 0; i < num_draws; i++) {
+         if (!draws[i].count)
+            continue;
+
+         draw.start = draws[i].start;
+         draw.count = draws[i].count;
+         draw.index_bias = draws[i].index_bias;
+         draw.drawid = info->drawid + i;
+         if (!info->index_size) {
+            draw.min_index = draw.start;
+            draw.max_index = draw.start + draw.count - 1;
+         }
+         cso_draw_vbo(cso, &draw);
+      }
+   }
+}
+
 void
 cso_draw_arrays(struct cso_context *cso, uint mode, uint start, uint count)
 {
@@ -119,6 +119,26 @@ draw_create_with_llvm_context(struct pipe_context *pipe,
 {
    return draw_create_context(pipe, context, TRUE);
 }
+
+
+/**
+ * Let the driver provide a cache for the machine code of the vertex and
+ * geometry shader variants, see gallivm_get_ir_cache_key().
+ */
+void
+draw_set_disk_cache_callbacks(struct draw_context *draw,
+                              void *data_cookie,
+                              void (*find_shader)(void *cookie,
+                                                  struct lp_cached_code *cache,
+                                                  unsigned char ir_sha1_cache_key[20]),
+                              void (*insert_shader)(void *cookie,
+                                                    struct lp_cached_code *cache,
+                                                    unsigned char ir_sha1_cache_key[20]))
+{
+   draw->disk_cache_find_shader = find_shader;
+   draw->disk_cache_insert_shader = insert_shader;
+   draw->disk_cache_cookie = data_cookie;
+}
 #endif
 
 /**
@@ -1086,6 +1106,19 @@ draw_collect_pipeline_statistics(struct draw_context *draw,
    draw->collect_statistics = enable;
 }
 
+/**
+ * Return the number of indexed vertices which went through the vsplit
+ * vertex cache since the context was created, and how many of them had
+ * to be shaded.
+ */
+void
+draw_get_vertex_cache_stats(const struct draw_context *draw,
+                            uint64_t *lookups, uint64_t *misses)
+{
+   *lookups = draw->pt.vcache_lookups;
+   *misses = draw->pt.vcache_misses;
+}
+
 /**
  * Computes clipper invocation statistics.
  *
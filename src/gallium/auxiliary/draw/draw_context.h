@@ -68,6 +68,18 @@ struct draw_context *draw_create( struct pipe_context *pipe );
 #if HAVE_LLVM
 struct draw_context *draw_create_with_llvm_context(struct pipe_context *pipe,
                                                    void *context);
+
+struct lp_cached_code;
+
+void
+draw_set_disk_cache_callbacks(struct draw_context *draw,
+                              void *data_cookie,
+                              void (*find_shader)(void *cookie,
+                                                  struct lp_cached_code *cache,
+                                                  unsigned char ir_sha1_cache_key[20]),
+                              void (*insert_shader)(void *cookie,
+                                                    struct lp_cached_code *cache,
+                                                    unsigned char ir_sha1_cache_key[20]));
 #endif
 
 struct draw_context *draw_create_no_llvm(struct pipe_context *pipe);
@@ -291,6 +303,9 @@ void draw_set_force_passthrough( struct draw_context *draw,
 void draw_collect_pipeline_statistics(struct draw_context *draw,
                                       boolean enable);
 
+void draw_get_vertex_cache_stats(const struct draw_context *draw,
+                                 uint64_t *lookups, uint64_t *misses);
+
 /*******************************************************************************
  * Draw pipeline 
  */
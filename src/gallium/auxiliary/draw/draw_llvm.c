@@ -539,6 +539,47 @@ draw_llvm_destroy(struct draw_llvm *llvm)
 }
 
 
+/**
+ * Compile the module of a variant and return the code of \p function,
+ * going through the driver's shader cache if there is one.
+ * This frees the IR.
+ */
+static func_pointer
+draw_llvm_compile_variant(struct draw_llvm *llvm,
+                          struct gallivm_state *gallivm,
+                          LLVMValueRef function)
+{
+   struct draw_context *draw = llvm->draw;
+   struct lp_cached_code cached = { 0 };
+   unsigned char ir_sha1_cache_key[20];
+   boolean needs_caching = FALSE;
+   func_pointer jit_func;
+
+   if (draw->disk_cache_find_shader) {
+      gallivm_get_ir_cache_key(gallivm, ir_sha1_cache_key);
+      draw->disk_cache_find_shader(draw->disk_cache_cookie, &cached,
+                                   ir_sha1_cache_key);
+      if (!cached.data_size)
+         needs_caching = TRUE;
+      gallivm->cache = &cached;
+   }
+
+   gallivm_compile_module(gallivm);
+
+   jit_func = gallivm_jit_function(gallivm, function);
+
+   if (needs_caching) {
+      draw->disk_cache_insert_shader(draw->disk_cache_cookie, &cached,
+                                     ir_sha1_cache_key);
+   }
+
+   gallivm_free_ir(gallivm);
+   free(cached.data);
+
+   return jit_func;
+}
+
+
 /**
  * Create LLVM-generated code for a vertex shader.
  */
@@ -582,12 +623,8 @@ draw_llvm_create_variant(struct draw_llvm *llvm,
 
    draw_llvm_generate(llvm, variant);
 
-   gallivm_compile_module(variant->gallivm);
-
    variant->jit_func = (draw_jit_vert_func)
-         gallivm_jit_function(variant->gallivm, variant->function);
-
-   gallivm_free_ir(variant->gallivm);
+         draw_llvm_compile_variant(llvm, variant->gallivm, variant->function);
 
    variant->list_item_global.base = variant;
    variant->list_item_local.base = variant;
@@ -2403,12 +2440,8 @@ draw_gs_llvm_create_variant(struct draw_llvm *llvm,
 
    draw_gs_llvm_generate(llvm, variant);
 
-   gallivm_compile_module(variant->gallivm);
-
    variant->jit_func = (draw_gs_jit_func)
-         gallivm_jit_function(variant->gallivm, variant->function);
-
-   gallivm_free_ir(variant->gallivm);
+         draw_llvm_compile_variant(llvm, variant->gallivm, variant->function);
 
    variant->list_item_global.base = variant;
    variant->list_item_local.base = variant;
@@ -35,6 +35,7 @@
 #include "util/u_bitcast.h"
 #include "util/u_memory.h"
 #include "util/u_math.h"
+#include "util/u_sse.h"
 
 #include "pipe/p_shader_tokens.h"
 
@@ -99,15 +100,23 @@ draw_viewport_index(struct draw_context *draw,
 
 /* All attributes are float[4], so this is easy:
  */
-static void interp_attr(float dst[4],
-                        float t,
-                        const float in[4],
-                        const float out[4])
+static inline void interp_attr(float dst[4],
+                               float t,
+                               const float in[4],
+                               const float out[4])
 {
+#if defined(PIPE_ARCH_SSE)
+   /* Same operations as LINTERP, so the results are bit identical */
+   const __m128 vout = _mm_loadu_ps(out);
+   const __m128 vin = _mm_loadu_ps(in);
+   _mm_storeu_ps(dst, _mm_add_ps(vout, _mm_mul_ps(_mm_set1_ps(t),
+                                                  _mm_sub_ps(vin, vout))));
+#else
    dst[0] = LINTERP( t, out[0], in[0] );
    dst[1] = LINTERP( t, out[1], in[1] );
    dst[2] = LINTERP( t, out[2], in[2] );
    dst[3] = LINTERP( t, out[3], in[3] );
+#endif
 }
 
 
@@ -166,9 +175,18 @@ static void interp(const struct clip_stage *clip,
          clip->stage.draw->viewports[viewport_index].translate;
       const float oow = 1.0f / pos[3];
 
+#if defined(PIPE_ARCH_SSE)
+      /* w of the result is overwritten below, the fourth lane is junk */
+      const __m128 vscale = _mm_setr_ps(scale[0], scale[1], scale[2], 0.0f);
+      const __m128 vtrans = _mm_setr_ps(trans[0], trans[1], trans[2], 0.0f);
+      __m128 win = _mm_mul_ps(_mm_loadu_ps(pos), _mm_set1_ps(oow));
+      win = _mm_add_ps(_mm_mul_ps(win, vscale), vtrans);
+      _mm_storeu_ps(dst->data[pos_attr], win);
+#else
       dst->data[pos_attr][0] = pos[0] * oow * scale[0] + trans[0];
       dst->data[pos_attr][1] = pos[1] * oow * scale[1] + trans[1];
       dst->data[pos_attr][2] = pos[2] * oow * scale[2] + trans[2];
+#endif
       dst->data[pos_attr][3] = oow;
    }
    
@@ -28,6 +28,7 @@
 #include "util/u_math.h"
 #include "util/u_memory.h"
 #include "util/u_prim.h"
+#include "util/u_queue.h"
 #include "draw/draw_context.h"
 #include "draw/draw_gs.h"
 #include "draw/draw_vbuf.h"
@@ -40,6 +41,32 @@
 #include "gallivm/lp_bld_debug.h"
 
 
+/** Max number of helper threads running the vertex shader */
+#define DRAW_MAX_VS_THREADS 15
+
+/** Smallest number of vertices worth shading on a helper thread */
+#define DRAW_VS_CHUNK_SIZE 256
+
+
+struct llvm_middle_end;
+
+/**
+ * A contiguous range of the vertices being shaded.  Chunks write disjoint
+ * parts of the same output buffer, so once they're done the vertices are
+ * in the same order as if they were shaded in one go.
+ */
+struct llvm_vs_chunk {
+   struct llvm_middle_end *fpme;
+   struct vertex_header *verts;
+   unsigned count;
+   unsigned start_or_maxelt;
+   unsigned vid_base;
+   const unsigned *elts;
+   boolean clipped;
+   struct util_queue_fence fence;
+};
+
+
 struct llvm_middle_end {
    struct draw_pt_middle_end base;
    struct draw_context *draw;
@@ -57,6 +84,11 @@ struct llvm_middle_end {
 
    struct draw_llvm *llvm;
    struct draw_llvm_variant *current_variant;
+
+   /* Helper threads for large batches of vertices, see DRAW_VS_THREADS */
+   unsigned num_vs_threads;
+   struct util_queue vs_queue;
+   struct llvm_vs_chunk vs_chunks[DRAW_MAX_VS_THREADS + 1];
 };
 
 
@@ -317,6 +349,102 @@ llvm_middle_end_bind_parameters(struct draw_pt_middle_end *middle)
 }
 
 
+static void
+run_vs_chunk(struct llvm_vs_chunk *chunk)
+{
+   struct llvm_middle_end *fpme = chunk->fpme;
+   struct draw_context *draw = fpme->draw;
+
+   chunk->clipped = fpme->current_variant->jit_func(&fpme->llvm->jit_context,
+                                                    chunk->verts,
+                                                    draw->pt.user.vbuffer,
+                                                    chunk->count,
+                                                    chunk->start_or_maxelt,
+                                                    fpme->vertex_size,
+                                                    draw->pt.vertex_buffer,
+                                                    draw->instance_id,
+                                                    chunk->vid_base,
+                                                    draw->start_instance,
+                                                    chunk->elts);
+}
+
+
+static void
+vs_chunk_job(void *data, int thread_index)
+{
+   /* Same float environment as draw_vbo() sets up on the calling thread */
+   util_fpstate_set_denorms_to_zero(util_fpstate_get());
+
+   run_vs_chunk((struct llvm_vs_chunk *) data);
+}
+
+
+/**
+ * Fetch and shade the vertices, splitting them between the helper threads
+ * and this one when there are enough of them.
+ *
+ * \return TRUE if any vertex was clipped or has a non-one edgeflag.
+ */
+static boolean
+run_vs(struct llvm_middle_end *fpme,
+       const struct draw_fetch_info *fetch_info,
+       struct vertex_header *verts,
+       unsigned start_or_maxelt,
+       unsigned vid_base,
+       const unsigned *elts)
+{
+   unsigned count = fetch_info->count;
+   unsigned num_chunks = MIN2(fpme->num_vs_threads + 1,
+                              count / DRAW_VS_CHUNK_SIZE);
+   unsigned chunk_size, start, i;
+   boolean clipped = FALSE;
+
+   if (num_chunks < 2)
+      num_chunks = 1;
+
+   /*
+    * The shader writes whole vectors of vertices, so make every chunk but
+    * the last a multiple of any vector length.
+    */
+   chunk_size = align(DIV_ROUND_UP(count, num_chunks), 16);
+
+   for (i = 0, start = 0; start < count; i++, start += chunk_size) {
+      struct llvm_vs_chunk *chunk = &fpme->vs_chunks[i];
+
+      chunk->fpme = fpme;
+      chunk->verts = (struct vertex_header *)
+         ((char *)verts + start * fpme->vertex_size);
+      chunk->count = MIN2(chunk_size, count - start);
+      chunk->vid_base = vid_base;
+      if (elts) {
+         chunk->start_or_maxelt = start_or_maxelt;
+         chunk->elts = elts + start;
+      }
+      else {
+         chunk->start_or_maxelt = start_or_maxelt + start;
+         chunk->elts = NULL;
+      }
+      chunk->clipped = FALSE;
+
+      /* The first chunk is shaded on this thread, once the others are queued */
+      if (i > 0)
+         util_queue_add_job(&fpme->vs_queue, chunk, &chunk->fence,
+                            vs_chunk_job, NULL);
+   }
+   num_chunks = i;
+
+   run_vs_chunk(&fpme->vs_chunks[0]);
+   clipped = fpme->vs_chunks[0].clipped;
+
+   for (i = 1; i < num_chunks; i++) {
+      util_queue_fence_wait(&fpme->vs_chunks[i].fence);
+      clipped |= fpme->vs_chunks[i].clipped;
+   }
+
+   return clipped;
+}
+
+
 static void
 pipeline(struct llvm_middle_end *llvm,
          const struct draw_vertex_info *vert_info,
@@ -397,17 +525,8 @@ llvm_pipeline_generic(struct draw_pt_middle_end *middle,
       vid_base = draw->pt.user.eltBias;
       elts = fetch_info->elts;
    }
-   clipped = fpme->current_variant->jit_func(&fpme->llvm->jit_context,
-                                             llvm_vert_info.verts,
-                                             draw->pt.user.vbuffer,
-                                             fetch_info->count,
-                                             start_or_maxelt,
-                                             fpme->vertex_size,
-                                             draw->pt.vertex_buffer,
-                                             draw->instance_id,
-                                             vid_base,
-                                             draw->start_instance,
-                                             elts);
+   clipped = run_vs(fpme, fetch_info, llvm_vert_info.verts,
+                    start_or_maxelt, vid_base, elts);
 
    /* Finished with fetch and vs:
     */
@@ -606,6 +725,13 @@ static void
 llvm_middle_end_destroy(struct draw_pt_middle_end *middle)
 {
    struct llvm_middle_end *fpme = llvm_middle_end(middle);
+   unsigned i;
+
+   if (util_queue_is_initialized(&fpme->vs_queue))
+      util_queue_destroy(&fpme->vs_queue);
+
+   for (i = 0; i < ARRAY_SIZE(fpme->vs_chunks); i++)
+      util_queue_fence_destroy(&fpme->vs_chunks[i].fence);
 
    if (fpme->fetch)
       draw_pt_fetch_destroy( fpme->fetch );
@@ -627,6 +753,7 @@ struct draw_pt_middle_end *
 draw_pt_fetch_pipeline_or_emit_llvm(struct draw_context *draw)
 {
    struct llvm_middle_end *fpme = 0;
+   unsigned i;
 
    if (!draw->llvm)
       return NULL;
@@ -635,6 +762,9 @@ draw_pt_fetch_pipeline_or_emit_llvm(struct draw_context *draw)
    if (!fpme)
       goto fail;
 
+   for (i = 0; i < ARRAY_SIZE(fpme->vs_chunks); i++)
+      util_queue_fence_init(&fpme->vs_chunks[i].fence);
+
    fpme->base.prepare         = llvm_middle_end_prepare;
    fpme->base.bind_parameters = llvm_middle_end_bind_parameters;
    fpme->base.run             = llvm_middle_end_run;
@@ -667,6 +797,13 @@ draw_pt_fetch_pipeline_or_emit_llvm(struct draw_context *draw)
 
    fpme->current_variant = NULL;
 
+   fpme->num_vs_threads = debug_get_num_option("DRAW_VS_THREADS", 0);
+   fpme->num_vs_threads = MIN2(fpme->num_vs_threads, DRAW_MAX_VS_THREADS);
+   if (fpme->num_vs_threads &&
+       !util_queue_init(&fpme->vs_queue, "drawvs", DRAW_MAX_VS_THREADS,
+                        fpme->num_vs_threads, 0))
+      fpme->num_vs_threads = 0;
+
    return &fpme->base;
 
  fail:
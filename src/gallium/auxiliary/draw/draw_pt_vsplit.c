@@ -32,6 +32,7 @@
 
 #define SEGMENT_SIZE 1024
 #define MAP_SIZE     256
+#define MAX_CACHE_WAYS 8
 
 /* The largest possible index within an index buffer */
 #define MAX_ELT_IDX 0xffffffff
@@ -53,9 +54,17 @@ struct vsplit_frontend {
    ushort identity_draw_elts[SEGMENT_SIZE];
 
    struct {
-      /* map a fetch element to a draw element */
-      unsigned fetches[MAP_SIZE];
-      ushort draws[MAP_SIZE];
+      /*
+       * map a fetch element to a draw element
+       *
+       * Way w of set s is entry w * MAP_SIZE + s, so that a direct mapped
+       * cache only uses (and clears) the first MAP_SIZE entries.
+       */
+      unsigned fetches[MAP_SIZE * MAX_CACHE_WAYS];
+      ushort draws[MAP_SIZE * MAX_CACHE_WAYS];
+      /* next way to replace in each set, FIFO order */
+      ubyte next_way[MAP_SIZE];
+      unsigned ways;
       boolean has_max_fetch;
 
       ushort num_fetch_elts;
@@ -67,7 +76,10 @@ struct vsplit_frontend {
 static void
 vsplit_clear_cache(struct vsplit_frontend *vsplit)
 {
-   memset(vsplit->cache.fetches, 0xff, sizeof(vsplit->cache.fetches));
+   memset(vsplit->cache.fetches, 0xff,
+          sizeof(vsplit->cache.fetches[0]) * MAP_SIZE * vsplit->cache.ways);
+   if (vsplit->cache.ways > 1)
+      memset(vsplit->cache.next_way, 0, sizeof(vsplit->cache.next_way));
    vsplit->cache.has_max_fetch = FALSE;
    vsplit->cache.num_fetch_elts = 0;
    vsplit->cache.num_draw_elts = 0;
@@ -76,11 +88,62 @@ vsplit_clear_cache(struct vsplit_frontend *vsplit)
 static void
 vsplit_flush_cache(struct vsplit_frontend *vsplit, unsigned flags)
 {
+   vsplit->draw->pt.vcache_lookups += vsplit->cache.num_draw_elts;
+   vsplit->draw->pt.vcache_misses += vsplit->cache.num_fetch_elts;
+
    vsplit->middle->run(vsplit->middle,
          vsplit->fetch_elts, vsplit->cache.num_fetch_elts,
          vsplit->draw_elts, vsplit->cache.num_draw_elts, flags);
 }
 
+/**
+ * Make sure DRAW_MAX_FETCH_IDX, which is also the value of the unused
+ * entries, misses the cache the first time it is looked up.
+ */
+static inline void
+vsplit_reserve_max_fetch(struct vsplit_frontend *vsplit)
+{
+   const unsigned hash = DRAW_MAX_FETCH_IDX % MAP_SIZE;
+   unsigned way;
+
+   /* force update - any value will do except DRAW_MAX_FETCH_IDX */
+   for (way = 0; way < vsplit->cache.ways; way++)
+      vsplit->cache.fetches[way * MAP_SIZE + hash] = 0;
+   vsplit->cache.has_max_fetch = TRUE;
+}
+
+/**
+ * Set associative version of vsplit_add_cache(), replacing the oldest
+ * entry of the set on a miss.
+ */
+static void
+vsplit_add_cache_assoc(struct vsplit_frontend *vsplit, unsigned fetch)
+{
+   const unsigned hash = fetch % MAP_SIZE;
+   unsigned way, entry;
+
+   for (way = 0; way < vsplit->cache.ways; way++) {
+      entry = way * MAP_SIZE + hash;
+      if (vsplit->cache.fetches[entry] == fetch) {
+         vsplit->draw_elts[vsplit->cache.num_draw_elts++] =
+            vsplit->cache.draws[entry];
+         return;
+      }
+   }
+
+   way = vsplit->cache.next_way[hash];
+   vsplit->cache.next_way[hash] = (way + 1) % vsplit->cache.ways;
+   entry = way * MAP_SIZE + hash;
+
+   vsplit->cache.fetches[entry] = fetch;
+   vsplit->cache.draws[entry] = vsplit->cache.num_fetch_elts;
+
+   assert(vsplit->cache.num_fetch_elts < vsplit->segment_size);
+   vsplit->fetch_elts[vsplit->cache.num_fetch_elts++] = fetch;
+
+   vsplit->draw_elts[vsplit->cache.num_draw_elts++] = vsplit->cache.draws[entry];
+}
+
 /**
  * Add a fetch element and add it to the draw elements.
  */
@@ -89,6 +152,11 @@ vsplit_add_cache(struct vsplit_frontend *vsplit, unsigned fetch)
 {
    unsigned hash;
 
+   if (vsplit->cache.ways > 1) {
+      vsplit_add_cache_assoc(vsplit, fetch);
+      return;
+   }
+
    hash = fetch % MAP_SIZE;
 
    /* If the value isn't in the cache or it's an overflow due to the
@@ -126,11 +194,8 @@ vsplit_add_cache_ubyte(struct vsplit_frontend *vsplit, const ubyte *elts,
    elt_idx = vsplit_get_base_idx(start, fetch);
    elt_idx = (unsigned)((int)(DRAW_GET_IDX(elts, elt_idx)) + elt_bias);
    /* unlike the uint case this can only happen with elt_bias */
-   if (elt_bias && elt_idx == DRAW_MAX_FETCH_IDX && !vsplit->cache.has_max_fetch) {
-      unsigned hash = elt_idx % MAP_SIZE;
-      vsplit->cache.fetches[hash] = 0;
-      vsplit->cache.has_max_fetch = TRUE;
-   }
+   if (elt_bias && elt_idx == DRAW_MAX_FETCH_IDX && !vsplit->cache.has_max_fetch)
+      vsplit_reserve_max_fetch(vsplit);
    vsplit_add_cache(vsplit, elt_idx);
 }
 
@@ -143,11 +208,8 @@ vsplit_add_cache_ushort(struct vsplit_frontend *vsplit, const ushort *elts,
    elt_idx = vsplit_get_base_idx(start, fetch);
    elt_idx = (unsigned)((int)(DRAW_GET_IDX(elts, elt_idx)) + elt_bias);
    /* unlike the uint case this can only happen with elt_bias */
-   if (elt_bias && elt_idx == DRAW_MAX_FETCH_IDX && !vsplit->cache.has_max_fetch) {
-      unsigned hash = elt_idx % MAP_SIZE;
-      vsplit->cache.fetches[hash] = 0;
-      vsplit->cache.has_max_fetch = TRUE;
-   }
+   if (elt_bias && elt_idx == DRAW_MAX_FETCH_IDX && !vsplit->cache.has_max_fetch)
+      vsplit_reserve_max_fetch(vsplit);
    vsplit_add_cache(vsplit, elt_idx);
 }
 
@@ -168,12 +230,8 @@ vsplit_add_cache_uint(struct vsplit_frontend *vsplit, const uint *elts,
    elt_idx = vsplit_get_base_idx(start, fetch);
    elt_idx = (unsigned)((int)(DRAW_GET_IDX(elts, elt_idx)) + elt_bias);
    /* Take care for DRAW_MAX_FETCH_IDX (since cache is initialized to -1). */
-   if (elt_idx == DRAW_MAX_FETCH_IDX && !vsplit->cache.has_max_fetch) {
-      unsigned hash = elt_idx % MAP_SIZE;
-      /* force update - any value will do except DRAW_MAX_FETCH_IDX */
-      vsplit->cache.fetches[hash] = 0;
-      vsplit->cache.has_max_fetch = TRUE;
-   }
+   if (elt_idx == DRAW_MAX_FETCH_IDX && !vsplit->cache.has_max_fetch)
+      vsplit_reserve_max_fetch(vsplit);
    vsplit_add_cache(vsplit, elt_idx);
 }
 
@@ -263,6 +321,9 @@ struct draw_pt_front_end *draw_pt_vsplit(struct draw_context *draw)
    vsplit->base.destroy = vsplit_destroy;
    vsplit->draw = draw;
 
+   vsplit->cache.ways = debug_get_num_option("DRAW_VCACHE_WAYS", 1);
+   vsplit->cache.ways = CLAMP(vsplit->cache.ways, 1, MAX_CACHE_WAYS);
+
    for (i = 0; i < SEGMENT_SIZE; i++)
       vsplit->identity_draw_elts[i] = i;
 
@@ -0,0 +1,315 @@
+/**************************************************************************
+ *
+ * Copyright 2018 Advanced Micro Devices, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+/**
+ * @file
+ * Binary trace writer (GALLIUM_TRACE_BINARY).
+ *
+ * The tokens are appended to a chunk in memory. Full chunks are handed to
+ * a writer thread, so the traced thread never waits for the file unless
+ * the writer falls behind by more than TRACE_BINARY_MAX_CHUNKS chunks.
+ */
+
+#include <string.h>
+
+#include "util/hash_table.h"
+#include "util/mesa-sha1.h"
+#include "util/ralloc.h"
+#include "util/set.h"
+#include "util/u_math.h"
+#include "util/u_memory.h"
+#include "util/u_queue.h"
+
+#include "tr_dump_binary.h"
+
+#define TRACE_BINARY_CHUNK_SIZE  (256 * 1024)
+#define TRACE_BINARY_MAX_CHUNKS  32
+
+struct trace_binary_chunk {
+   struct util_queue_fence fence;
+   size_t size;
+   uint8_t data[TRACE_BINARY_CHUNK_SIZE];
+};
+
+static struct {
+   FILE *stream;
+   struct util_queue queue;
+   struct trace_binary_chunk *chunk; /* being filled */
+
+   void *mem_ctx;
+   struct hash_table *strings; /* string -> id + 1 */
+   uint32_t num_strings;
+   struct set *blobs; /* SHA-1s of the blobs written so far, or NULL */
+} bin;
+
+static void
+trace_binary_write_chunk(void *job, int thread_index)
+{
+   struct trace_binary_chunk *chunk = job;
+
+   fwrite(chunk->data, chunk->size, 1, bin.stream);
+   fflush(bin.stream);
+}
+
+static void
+trace_binary_free_chunk(void *job, int thread_index)
+{
+   struct trace_binary_chunk *chunk = job;
+
+   util_queue_fence_destroy(&chunk->fence);
+   FREE(chunk);
+}
+
+/**
+ * Hand the current chunk to the writer thread.
+ */
+void
+trace_binary_flush(void)
+{
+   struct trace_binary_chunk *chunk = bin.chunk;
+
+   if (!chunk || !chunk->size)
+      return;
+
+   bin.chunk = NULL;
+   util_queue_add_job(&bin.queue, chunk, &chunk->fence,
+                      trace_binary_write_chunk, trace_binary_free_chunk);
+}
+
+static void
+trace_binary_write(const void *data, size_t size)
+{
+   const uint8_t *p = data;
+
+   while (size) {
+      struct trace_binary_chunk *chunk = bin.chunk;
+      size_t n;
+
+      if (!chunk) {
+         chunk = bin.chunk = MALLOC_STRUCT(trace_binary_chunk);
+         if (!chunk)
+            return;
+
+         util_queue_fence_init(&chunk->fence);
+         chunk->size = 0;
+      }
+
+      n = MIN2(size, TRACE_BINARY_CHUNK_SIZE - chunk->size);
+      memcpy(chunk->data + chunk->size, p, n);
+      chunk->size += n;
+      p += n;
+      size -= n;
+
+      if (chunk->size == TRACE_BINARY_CHUNK_SIZE)
+         trace_binary_flush();
+   }
+}
+
+static inline void
+trace_binary_u8(uint8_t value)
+{
+   trace_binary_write(&value, 1);
+}
+
+static inline void
+trace_binary_u32(uint32_t value)
+{
+   value = util_cpu_to_le32(value);
+   trace_binary_write(&value, 4);
+}
+
+static inline void
+trace_binary_u64(uint64_t value)
+{
+   value = util_cpu_to_le64(value);
+   trace_binary_write(&value, 8);
+}
+
+/**
+ * Return the id of a string, defining it first if it's new. Strings must be
+ * defined before the token that uses them.
+ */
+static uint32_t
+trace_binary_str(const char *str)
+{
+   struct hash_entry *entry = _mesa_hash_table_search(bin.strings, str);
+   uint32_t id;
+   size_t len;
+
+   if (entry)
+      return (uintptr_t)entry->data - 1;
+
+   len = strlen(str);
+   id = bin.num_strings++;
+   _mesa_hash_table_insert(bin.strings, ralloc_strdup(bin.mem_ctx, str),
+                           (void*)(uintptr_t)(id + 1));
+
+   trace_binary_u8(TRACE_BIN_STRDEF);
+   trace_binary_u32(id);
+   trace_binary_u32(len);
+   trace_binary_write(str, len);
+   return id;
+}
+
+static uint32_t
+trace_binary_hash_sha1(const void *key)
+{
+   uint32_t hash;
+
+   memcpy(&hash, key, sizeof(hash));
+   return hash;
+}
+
+static bool
+trace_binary_sha1_equal(const void *a, const void *b)
+{
+   return memcmp(a, b, 20) == 0;
+}
+
+boolean
+trace_binary_begin(FILE *stream, boolean dedup)
+{
+   bin.stream = stream;
+   bin.mem_ctx = ralloc_context(NULL);
+   bin.strings = _mesa_hash_table_create(bin.mem_ctx, _mesa_key_hash_string,
+                                         _mesa_key_string_equal);
+   if (dedup) {
+      bin.blobs = _mesa_set_create(bin.mem_ctx, trace_binary_hash_sha1,
+                                   trace_binary_sha1_equal);
+   }
+
+   if (!bin.strings || (dedup && !bin.blobs) ||
+       !util_queue_init(&bin.queue, "trace", TRACE_BINARY_MAX_CHUNKS, 1, 0)) {
+      ralloc_free(bin.mem_ctx);
+      memset(&bin, 0, sizeof(bin));
+      return FALSE;
+   }
+
+   trace_binary_write(TRACE_BINARY_MAGIC, 8);
+   trace_binary_u32(TRACE_BINARY_VERSION);
+   return TRUE;
+}
+
+void
+trace_binary_end(void)
+{
+   trace_binary_flush();
+   util_queue_finish(&bin.queue);
+   util_queue_destroy(&bin.queue);
+   ralloc_free(bin.mem_ctx);
+   memset(&bin, 0, sizeof(bin));
+}
+
+void
+trace_binary_token(enum trace_binary_token token)
+{
+   trace_binary_u8(token);
+}
+
+void
+trace_binary_token_str(enum trace_binary_token token, const char *str)
+{
+   uint32_t id = trace_binary_str(str);
+
+   trace_binary_u8(token);
+   trace_binary_u32(id);
+}
+
+void
+trace_binary_token_u64(enum trace_binary_token token, uint64_t value)
+{
+   trace_binary_u8(token);
+   if (token == TRACE_BIN_BOOL)
+      trace_binary_u8(!!value);
+   else
+      trace_binary_u64(value);
+}
+
+void
+trace_binary_call_begin(unsigned long call_no,
+                        const char *klass, const char *method)
+{
+   uint32_t klass_id = trace_binary_str(klass);
+   uint32_t method_id = trace_binary_str(method);
+
+   trace_binary_u8(TRACE_BIN_CALL_BEGIN);
+   trace_binary_u32(call_no);
+   trace_binary_u32(klass_id);
+   trace_binary_u32(method_id);
+}
+
+void
+trace_binary_float(double value)
+{
+   uint64_t bits;
+
+   memcpy(&bits, &value, sizeof(bits));
+   trace_binary_u8(TRACE_BIN_FLOAT);
+   trace_binary_u64(bits);
+}
+
+void
+trace_binary_bytes(const void *data, size_t size)
+{
+   unsigned char sha1[20];
+
+   if (!bin.blobs) {
+      trace_binary_u8(TRACE_BIN_BYTES);
+      trace_binary_u32(size);
+      trace_binary_write(data, size);
+      return;
+   }
+
+   _mesa_sha1_compute(data, size, sha1);
+
+   if (!_mesa_set_search(bin.blobs, sha1)) {
+      void *key = ralloc_size(bin.mem_ctx, sizeof(sha1));
+
+      if (key) {
+         memcpy(key, sha1, sizeof(sha1));
+         _mesa_set_add(bin.blobs, key);
+      }
+
+      trace_binary_u8(TRACE_BIN_BLOBDEF);
+      trace_binary_write(sha1, sizeof(sha1));
+      trace_binary_u32(size);
+      trace_binary_write(data, size);
+   }
+
+   trace_binary_u8(TRACE_BIN_BYTES_REF);
+   trace_binary_write(sha1, sizeof(sha1));
+}
+
+void
+trace_binary_string(const char *str)
+{
+   size_t len = strlen(str);
+
+   trace_binary_u8(TRACE_BIN_STRING);
+   trace_binary_u32(len);
+   trace_binary_write(str, len);
+}
@@ -0,0 +1,99 @@
+/**************************************************************************
+ *
+ * Copyright 2018 Advanced Micro Devices, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+/**
+ * @file
+ * Binary trace format.
+ *
+ * The file starts with TRACE_BINARY_MAGIC and a uint32_t version, followed
+ * by a stream of tokens. Every token is one byte of enum trace_binary_token
+ * followed by its operands. All numbers are little endian.
+ *
+ * Strings that name things (classes, methods, arguments, members, enums)
+ * are sent once with TRACE_BIN_STRDEF and referenced by their uint32_t id
+ * afterwards. Byte blobs may be deduplicated: TRACE_BIN_BLOBDEF sends the
+ * data of a blob with its SHA-1, and TRACE_BIN_BYTES_REF refers to it.
+ *
+ * src/gallium/tools/trace/bin2xml.py converts this back to the XML format.
+ */
+
+#ifndef TR_DUMP_BINARY_H
+#define TR_DUMP_BINARY_H
+
+#include <stdio.h>
+
+#include "pipe/p_compiler.h"
+
+#define TRACE_BINARY_MAGIC "GALTRACE"
+#define TRACE_BINARY_VERSION 1
+
+enum trace_binary_token {
+   TRACE_BIN_STRDEF = 1,   /* u32 id, u32 length, chars */
+   TRACE_BIN_CALL_BEGIN,   /* u32 call number, str class, str method */
+   TRACE_BIN_CALL_END,     /* i64 time in microseconds */
+   TRACE_BIN_ARG_BEGIN,    /* str name */
+   TRACE_BIN_ARG_END,
+   TRACE_BIN_RET_BEGIN,
+   TRACE_BIN_RET_END,
+   TRACE_BIN_BOOL,         /* u8 */
+   TRACE_BIN_INT,          /* i64 */
+   TRACE_BIN_UINT,         /* u64 */
+   TRACE_BIN_FLOAT,        /* f64 */
+   TRACE_BIN_BYTES,        /* u32 size, data */
+   TRACE_BIN_BLOBDEF,      /* u8 sha1[20], u32 size, data */
+   TRACE_BIN_BYTES_REF,    /* u8 sha1[20] */
+   TRACE_BIN_STRING,       /* u32 length, chars */
+   TRACE_BIN_ENUM,         /* str */
+   TRACE_BIN_ARRAY_BEGIN,
+   TRACE_BIN_ARRAY_END,
+   TRACE_BIN_ELEM_BEGIN,
+   TRACE_BIN_ELEM_END,
+   TRACE_BIN_STRUCT_BEGIN, /* str name */
+   TRACE_BIN_STRUCT_END,
+   TRACE_BIN_MEMBER_BEGIN, /* str name */
+   TRACE_BIN_MEMBER_END,
+   TRACE_BIN_NULL,
+   TRACE_BIN_PTR,          /* u64 */
+};
+
+/*
+ * All of these must be called with the trace call mutex held.
+ */
+boolean trace_binary_begin(FILE *stream, boolean dedup);
+void trace_binary_end(void);
+void trace_binary_flush(void);
+
+void trace_binary_token(enum trace_binary_token token);
+void trace_binary_token_str(enum trace_binary_token token, const char *str);
+void trace_binary_token_u64(enum trace_binary_token token, uint64_t value);
+void trace_binary_call_begin(unsigned long call_no,
+                             const char *klass, const char *method);
+void trace_binary_float(double value);
+void trace_binary_bytes(const void *data, size_t size);
+void trace_binary_string(const char *str);
+
+#endif /* TR_DUMP_BINARY_H */
@@ -112,10 +112,14 @@ lp_build_min_simple(struct lp_build_context *bld,
             intrinsic = "llvm.x86.sse.min.ps";
             intr_size = 128;
          }
-         else {
+         else if (type.length <= 8 || !util_cpu_caps.has_avx512f) {
             intrinsic = "llvm.x86.avx.min.ps.256";
             intr_size = 256;
          }
+         /* The avx512 min intrinsic takes an extra rounding operand, but
+          * llvm turns the generic compare/select below into vminps on zmm
+          * registers anyway.
+          */
       }
       if (type.width == 64 && util_cpu_caps.has_sse2) {
          if (type.length == 1) {
@@ -126,7 +130,7 @@ lp_build_min_simple(struct lp_build_context *bld,
             intrinsic = "llvm.x86.sse2.min.pd";
             intr_size = 128;
          }
-         else {
+         else if (type.length <= 4 || !util_cpu_caps.has_avx512f) {
             intrinsic = "llvm.x86.avx.min.pd.256";
             intr_size = 256;
          }
@@ -330,10 +334,14 @@ lp_build_max_simple(struct lp_build_context *bld,
             intrinsic = "llvm.x86.sse.max.ps";
             intr_size = 128;
          }
-         else {
+         else if (type.length <= 8 || !util_cpu_caps.has_avx512f) {
             intrinsic = "llvm.x86.avx.max.ps.256";
             intr_size = 256;
          }
+         /* The avx512 max intrinsic takes an extra rounding operand, but
+          * llvm turns the generic compare/select below into vmaxps on zmm
+          * registers anyway.
+          */
       }
       if (type.width == 64 && util_cpu_caps.has_sse2) {
          if (type.length == 1) {
@@ -344,7 +352,7 @@ lp_build_max_simple(struct lp_build_context *bld,
             intrinsic = "llvm.x86.sse2.max.pd";
             intr_size = 128;
          }
-         else {
+         else if (type.length <= 4 || !util_cpu_caps.has_avx512f) {
             intrinsic = "llvm.x86.avx.max.pd.256";
             intr_size = 256;
          }
@@ -2011,6 +2019,21 @@ lp_build_iround_nearest_sse2(struct lp_build_context *bld,
       if (type.width* type.length == 128) {
          intrinsic = "llvm.x86.sse2.cvtps2dq";
       }
+      else if (type.width*type.length == 512) {
+         LLVMValueRef args[4];
+
+         assert(util_cpu_caps.has_avx512f);
+
+         /* passthru, write mask, and use the current rounding mode */
+         args[0] = a;
+         args[1] = LLVMGetUndef(ret_type);
+         args[2] = LLVMConstInt(LLVMInt16TypeInContext(bld->gallivm->context),
+                                0xffff, 0);
+         args[3] = LLVMConstInt(i32t, 4, 0);
+
+         return lp_build_intrinsic(builder, "llvm.x86.avx512.mask.cvtps2dq.512",
+                                   ret_type, args, 4, 0);
+      }
       else {
          assert(type.width*type.length == 256);
          assert(util_cpu_caps.has_avx);
@@ -2435,7 +2458,8 @@ lp_build_iround(struct lp_build_context *bld,
 
    if ((util_cpu_caps.has_sse2 &&
        ((type.width == 32) && (type.length == 1 || type.length == 4))) ||
-       (util_cpu_caps.has_avx && type.width == 32 && type.length == 8)) {
+       (util_cpu_caps.has_avx && type.width == 32 && type.length == 8) ||
+       (util_cpu_caps.has_avx512f && type.width == 32 && type.length == 16)) {
       return lp_build_iround_nearest_sse2(bld, a);
    }
    if (arch_rounding_available(type)) {
@@ -2841,7 +2865,8 @@ lp_build_fast_rsqrt_available(struct lp_type type)
    assert(type.floating);
 
    if ((util_cpu_caps.has_sse && type.width == 32 && type.length == 4) ||
-       (util_cpu_caps.has_avx && type.width == 32 && type.length == 8)) {
+       (util_cpu_caps.has_avx && type.width == 32 && type.length == 8) ||
+       (util_cpu_caps.has_avx512f && type.width == 32 && type.length == 16)) {
       return true;
    }
    return false;
@@ -2869,9 +2894,20 @@ lp_build_fast_rsqrt(struct lp_build_context *bld,
       if (type.length == 4) {
          intrinsic = "llvm.x86.sse.rsqrt.ps";
       }
-      else {
+      else if (type.length == 8) {
          intrinsic = "llvm.x86.avx.rsqrt.ps.256";
       }
+      else {
+         /* rsqrt14 is even a bit more precise than rsqrtps */
+         LLVMValueRef args[3];
+
+         args[0] = a;
+         args[1] = bld->undef;
+         args[2] = LLVMConstInt(LLVMInt16TypeInContext(bld->gallivm->context),
+                                0xffff, 0);
+         return lp_build_intrinsic(builder, "llvm.x86.avx512.rsqrt14.ps.512",
+                                   bld->vec_type, args, 3, 0);
+      }
       return lp_build_intrinsic_unary(builder, intrinsic, bld->vec_type, a);
    }
    else {
@@ -33,6 +33,7 @@
 #include "util/u_memory.h"
 #include "util/simple_list.h"
 #include "util/os_time.h"
+#include "util/mesa-sha1.h"
 #include "lp_bld.h"
 #include "lp_bld_debug.h"
 #include "lp_bld_misc.h"
@@ -192,6 +193,12 @@ gallivm_free_ir(struct gallivm_state *gallivm)
       LLVMDisposeModule(gallivm->module);
    }
 
+   /* The object cache must outlive the engine, the data is the caller's */
+   if (gallivm->cache) {
+      lp_free_objcache(gallivm->cache->jit_obj_cache);
+      gallivm->cache->jit_obj_cache = NULL;
+   }
+
    FREE(gallivm->module_name);
 
    if (!use_mcjit) {
@@ -214,6 +221,7 @@ gallivm_free_ir(struct gallivm_state *gallivm)
    gallivm->passmgr = NULL;
    gallivm->context = NULL;
    gallivm->builder = NULL;
+   gallivm->cache = NULL;
 }
 
 
@@ -240,7 +248,7 @@ init_gallivm_engine(struct gallivm_state *gallivm)
       char *error = NULL;
       int ret;
 
-      if (gallivm_debug & GALLIVM_DEBUG_NO_OPT) {
+      if ((gallivm_debug & GALLIVM_DEBUG_NO_OPT) || gallivm->fast_compile) {
          optlevel = None;
       }
       else {
@@ -249,6 +257,7 @@ init_gallivm_engine(struct gallivm_state *gallivm)
 
       ret = lp_build_create_jit_compiler_for_module(&gallivm->engine,
                                                     &gallivm->code,
+                                                    gallivm->cache,
                                                     gallivm->module,
                                                     gallivm->memorymgr,
                                                     (unsigned) optlevel,
@@ -436,6 +445,7 @@ lp_build_init(void)
       util_cpu_caps.has_avx2 = 0;
       util_cpu_caps.has_f16c = 0;
       util_cpu_caps.has_fma = 0;
+      util_cpu_caps.has_avx512f = 0;
    }
 #endif
 
@@ -477,6 +487,23 @@ lp_build_init(void)
        * MCJIT. */
       util_cpu_caps.has_avx2 = 0;
    }
+   if (lp_native_vector_width < 512 || !util_cpu_caps.has_avx2 ||
+       HAVE_LLVM < 0x0700 || !use_mcjit) {
+      /* AVX-512 is only used for 16-wide code, which has to be requested
+       * explicitly with LP_NATIVE_VECTOR_WIDTH=512: the clock penalty of
+       * 512-bit instructions on current Intel parts means it isn't always
+       * a win.  The intrinsics used need LLVM 7.
+       */
+      util_cpu_caps.has_avx512f = 0;
+      util_cpu_caps.has_avx512dq = 0;
+      util_cpu_caps.has_avx512ifma = 0;
+      util_cpu_caps.has_avx512pf = 0;
+      util_cpu_caps.has_avx512er = 0;
+      util_cpu_caps.has_avx512cd = 0;
+      util_cpu_caps.has_avx512bw = 0;
+      util_cpu_caps.has_avx512vl = 0;
+      util_cpu_caps.has_avx512vbmi = 0;
+   }
 
 #ifdef PIPE_ARCH_PPC_64
    /* Set the NJ bit in VSCR to 0 so denormalized values are handled as
@@ -564,9 +591,47 @@ gallivm_verify_function(struct gallivm_state *gallivm,
 }
 
 
+/**
+ * Compute a key identifying the machine code the module compiles to, for
+ * looking it up in a shader cache.  Must be called before
+ * gallivm_compile_module().
+ *
+ * Besides the IR, this covers the CPU features the code is generated for.
+ * Any host pointer embedded in the IR is part of the key too, so a cached
+ * object can never refer to another process' address space.
+ */
+void
+gallivm_get_ir_cache_key(struct gallivm_state *gallivm,
+                         unsigned char key[20])
+{
+   struct util_cpu_caps caps = util_cpu_caps;
+   struct mesa_sha1 ctx;
+   char *ir_text;
+
+   assert(!gallivm->compiled);
+
+   /* only the features matter, not how many of them there are */
+   caps.nr_cpus = 0;
+
+   ir_text = LLVMPrintModuleToString(gallivm->module);
+
+   _mesa_sha1_init(&ctx);
+   _mesa_sha1_update(&ctx, ir_text, strlen(ir_text));
+   _mesa_sha1_update(&ctx, &caps, sizeof caps);
+   _mesa_sha1_update(&ctx, &lp_native_vector_width,
+                     sizeof lp_native_vector_width);
+   _mesa_sha1_final(&ctx, key);
+
+   LLVMDisposeMessage(ir_text);
+}
+
+
 /**
  * Compile a module.
  * This does IR optimization on all functions in the module.
+ *
+ * If gallivm::cache holds an object, it is loaded instead of compiling the
+ * module, otherwise the cache (if any) receives the compiled object.
  */
 void
 gallivm_compile_module(struct gallivm_state *gallivm)
@@ -600,9 +665,11 @@ gallivm_compile_module(struct gallivm_state *gallivm)
    if (gallivm_debug & GALLIVM_DEBUG_PERF)
       time_begin = os_time_get();
 
-   /* Run optimization passes */
+   /* Run optimization passes, pointless if the code comes from the cache */
    LLVMInitializeFunctionPassManager(gallivm->passmgr);
    func = LLVMGetFirstFunction(gallivm->module);
+   if (gallivm->cache && gallivm->cache->data_size)
+      func = NULL;
    while (func) {
       if (0) {
          debug_printf("optimizing func %s...\n", LLVMGetValueName(func));
@@ -39,6 +39,19 @@
 extern "C" {
 #endif
 
+/**
+ * Machine code of a module, as an object file, to be loaded instead of
+ * running LLVM codegen, or filled in once the module has been compiled.
+ */
+struct lp_cached_code
+{
+   void *data;
+   size_t data_size;
+   boolean dont_cache;
+   void *jit_obj_cache;
+};
+
+
 struct gallivm_state
 {
    char *module_name;
@@ -50,7 +63,10 @@ struct gallivm_state
    LLVMBuilderRef builder;
    LLVMMCJITMemoryManagerRef memorymgr;
    struct lp_generated_code *code;
+   struct lp_cached_code *cache;
    unsigned compiled;
+   /** Generate code without codegen optimizations (MCJIT only) */
+   boolean fast_compile;
 };
 
 
@@ -71,6 +87,10 @@ void
 gallivm_verify_function(struct gallivm_state *gallivm,
                         LLVMValueRef func);
 
+void
+gallivm_get_ir_cache_key(struct gallivm_state *gallivm,
+                         unsigned char key[20]);
+
 void
 gallivm_compile_module(struct gallivm_state *gallivm);
 
@@ -118,6 +118,7 @@ lp_sampler_static_texture_state(struct lp_static_texture_state *state,
    state->pot_height        = util_is_power_of_two_or_zero(texture->height0);
    state->pot_depth         = util_is_power_of_two_or_zero(texture->depth0);
    state->level_zero_only   = !view->u.tex.last_level;
+   state->tiled             = !!(texture->flags & LP_RESOURCE_FLAG_TILED);
 
    /*
     * the layer / element / level parameters are all either dynamic
@@ -2023,10 +2024,40 @@ lp_build_sample_partial_offset(struct lp_build_context *bld,
 }
 
 
+/**
+ * Compute the offset of a texel in a LP_RESOURCE_FLAG_TILED image along
+ * one axis.  The tile coordinate is multiplied by tile_stride and the
+ * coordinate within the tile by texel_stride.
+ */
+static LLVMValueRef
+lp_build_sample_tiled_partial_offset(struct lp_build_context *bld,
+                                     LLVMValueRef coord,
+                                     LLVMValueRef tile_stride,
+                                     unsigned texel_stride)
+{
+   LLVMBuilderRef builder = bld->gallivm->builder;
+   LLVMValueRef tile_shift, tile_mask;
+   LLVMValueRef tile, subcoord;
+
+   tile_shift = lp_build_const_int_vec(bld->gallivm, bld->type,
+                                       LP_TEX_TILE_ORDER);
+   tile_mask = lp_build_const_int_vec(bld->gallivm, bld->type,
+                                      LP_TEX_TILE_SIZE - 1);
+   tile = LLVMBuildLShr(builder, coord, tile_shift, "");
+   subcoord = LLVMBuildAnd(builder, coord, tile_mask, "");
+
+   return lp_build_add(bld,
+                       lp_build_mul(bld, tile, tile_stride),
+                       lp_build_mul_imm(bld, subcoord, texel_stride));
+}
+
+
 /**
  * Compute the offset of a pixel block.
  *
  * x, y, z, y_stride, z_stride are vectors, and they refer to pixels.
+ * If tiled is set the image uses the LP_RESOURCE_FLAG_TILED layout and
+ * y_stride is the stride between rows of tiles.
  *
  * Returns the relative offset and i,j sub-block coordinates
  */
@@ -2038,6 +2069,7 @@ lp_build_sample_offset(struct lp_build_context *bld,
                        LLVMValueRef z,
                        LLVMValueRef y_stride,
                        LLVMValueRef z_stride,
+                       boolean tiled,
                        LLVMValueRef *out_offset,
                        LLVMValueRef *out_i,
                        LLVMValueRef *out_j)
@@ -2045,24 +2077,44 @@ lp_build_sample_offset(struct lp_build_context *bld,
    LLVMValueRef x_stride;
    LLVMValueRef offset;
 
-   x_stride = lp_build_const_vec(bld->gallivm, bld->type,
-                                 format_desc->block.bits/8);
+   if (tiled && y && y_stride) {
+      const unsigned texel_size = format_desc->block.bits/8;
+      const unsigned tile_row_size = texel_size * LP_TEX_TILE_SIZE;
+      LLVMValueRef y_offset;
 
-   lp_build_sample_partial_offset(bld,
-                                  format_desc->block.width,
-                                  x, x_stride,
-                                  &offset, out_i);
+      /* tiled textures are never compressed */
+      assert(format_desc->block.width == 1 && format_desc->block.height == 1);
 
-   if (y && y_stride) {
-      LLVMValueRef y_offset;
-      lp_build_sample_partial_offset(bld,
-                                     format_desc->block.height,
-                                     y, y_stride,
-                                     &y_offset, out_j);
+      x_stride = lp_build_const_int_vec(bld->gallivm, bld->type,
+                                        tile_row_size * LP_TEX_TILE_SIZE);
+      offset = lp_build_sample_tiled_partial_offset(bld, x, x_stride,
+                                                    texel_size);
+      y_offset = lp_build_sample_tiled_partial_offset(bld, y, y_stride,
+                                                      tile_row_size);
       offset = lp_build_add(bld, offset, y_offset);
+      *out_i = bld->zero;
+      *out_j = bld->zero;
    }
    else {
-      *out_j = bld->zero;
+      x_stride = lp_build_const_vec(bld->gallivm, bld->type,
+                                    format_desc->block.bits/8);
+
+      lp_build_sample_partial_offset(bld,
+                                     format_desc->block.width,
+                                     x, x_stride,
+                                     &offset, out_i);
+
+      if (y && y_stride) {
+         LLVMValueRef y_offset;
+         lp_build_sample_partial_offset(bld,
+                                        format_desc->block.height,
+                                        y, y_stride,
+                                        &y_offset, out_j);
+         offset = lp_build_add(bld, offset, y_offset);
+      }
+      else {
+         *out_j = bld->zero;
+      }
    }
 
    if (z && z_stride) {
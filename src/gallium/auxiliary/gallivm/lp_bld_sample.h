@@ -96,6 +96,17 @@ enum lp_sampler_op_type {
 #define LP_SAMPLER_LOD_PROPERTY_SHIFT       6
 #define LP_SAMPLER_LOD_PROPERTY_MASK  (3 << 6)
 
+
+/**
+ * Resource flag for textures stored in the tiled layout: each 2D image is
+ * split into LP_TEX_TILE_SIZE x LP_TEX_TILE_SIZE texel tiles, laid out in
+ * row-major order, and the texels within a tile are row-major too.
+ * row_stride is then the distance between rows of tiles, not texel rows.
+ */
+#define LP_RESOURCE_FLAG_TILED        (PIPE_RESOURCE_FLAG_DRV_PRIV << 0)
+#define LP_TEX_TILE_ORDER             2
+#define LP_TEX_TILE_SIZE              (1 << LP_TEX_TILE_ORDER)
+
 struct lp_sampler_params
 {
    struct lp_type type;
@@ -143,6 +154,7 @@ struct lp_static_texture_state
    unsigned pot_height:1;
    unsigned pot_depth:1;
    unsigned level_zero_only:1;
+   unsigned tiled:1;         /**< LP_RESOURCE_FLAG_TILED layout */
 };
 
 
@@ -598,6 +610,7 @@ lp_build_sample_offset(struct lp_build_context *bld,
                        LLVMValueRef z,
                        LLVMValueRef y_stride,
                        LLVMValueRef z_stride,
+                       boolean tiled,
                        LLVMValueRef *out_offset,
                        LLVMValueRef *out_i,
                        LLVMValueRef *out_j);
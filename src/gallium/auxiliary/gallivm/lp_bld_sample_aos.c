@@ -814,6 +814,7 @@ lp_build_sample_image_nearest_afloat(struct lp_build_sample_context *bld,
                           x_icoord, y_icoord,
                           z_icoord,
                           row_stride_vec, img_stride_vec,
+                          FALSE,
                           &offset,
                           &x_subcoord, &y_subcoord);
    if (mipoffsets) {
@@ -1622,6 +1623,8 @@ lp_build_sample_aos(struct lp_build_sample_context *bld,
    if (dims >= 3)
       assert(lp_is_simple_wrap_mode(bld->static_sampler_state->wrap_r));
 
+   /* only linear layouts are handled here */
+   assert(!bld->static_texture_state->tiled);
 
    /* make 8-bit unorm builder context */
    lp_build_context_init(&u8n_bld, bld->gallivm, lp_type_unorm(8, bld->vector_width));
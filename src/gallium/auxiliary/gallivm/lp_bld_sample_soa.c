@@ -140,6 +140,7 @@ lp_build_sample_texel_soa(struct lp_build_sample_context *bld,
    lp_build_sample_offset(&bld->int_coord_bld,
                           bld->format_desc,
                           x, y, z, y_stride, z_stride,
+                          bld->static_texture_state->tiled,
                           &offset, &i, &j);
    if (mipoffsets) {
       offset = lp_build_add(&bld->int_coord_bld, offset, mipoffsets);
@@ -2674,6 +2675,7 @@ lp_build_fetch_texel(struct lp_build_sample_context *bld,
    lp_build_sample_offset(int_coord_bld,
                           bld->format_desc,
                           x, y, z, row_stride_vec, img_stride_vec,
+                          bld->static_texture_state->tiled,
                           &offset, &i, &j);
 
    if (bld->static_texture_state->target != PIPE_BUFFER) {
@@ -3103,7 +3105,9 @@ lp_build_sample_soa_code(struct gallivm_state *gallivm,
       LLVMValueRef ilevel0 = NULL, ilevel1 = NULL, lod = NULL;
       boolean use_aos;
 
+      /* The aos path computes linear offsets of its own. */
       use_aos = util_format_fits_8unorm(bld.format_desc) &&
+                !static_texture_state->tiled &&
                 op_is_tex &&
                 /* not sure this is strictly needed or simply impossible */
                 derived_sampler_state.compare_mode == PIPE_TEX_COMPARE_NONE &&
@@ -3166,9 +3170,12 @@ lp_build_sample_soa_code(struct gallivm_state *gallivm,
       /*
        * we only try 8-wide sampling with soa or if we have AVX2
        * as it appears to be a loss with just AVX)
+       * 16-wide aos sampling additionally needs AVX-512BW, otherwise
+       * all the 16bit fixed point math gets split anyway.
        */
       if (num_quads == 1 || !use_aos ||
           (util_cpu_caps.has_avx2 &&
+           (num_quads <= 2 || util_cpu_caps.has_avx512bw) &&
            (bld.num_lods == 1 ||
             derived_sampler_state.min_img_filter == derived_sampler_state.mag_img_filter))) {
          if (use_aos) {
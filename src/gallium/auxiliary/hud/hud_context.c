@@ -639,6 +639,19 @@ hud_stop_queries(struct hud_context *hud, struct pipe_context *pipe)
    struct hud_pane *pane;
    struct hud_graph *gr, *next;
 
+   /* Headless: only record the values. */
+   if (hud->stream) {
+      hud_batch_query_update(hud->batch_query, pipe);
+
+      LIST_FOR_EACH_ENTRY(pane, &hud->pane_list, head) {
+         LIST_FOR_EACH_ENTRY(gr, &pane->graph_list, head) {
+            gr->query_new_value(gr, pipe);
+         }
+      }
+      hud_stream_flush(hud->stream);
+      return;
+   }
+
    /* prepare vertex buffers */
    hud_prepare_vertices(hud, &hud->bg, 16 * 256, 2 * sizeof(float));
    hud_prepare_vertices(hud, &hud->whitelines, 4 * 256, 2 * sizeof(float));
@@ -954,6 +967,9 @@ hud_pane_add_graph(struct hud_pane *pane, struct hud_graph *gr)
 void
 hud_graph_add_value(struct hud_graph *gr, double value)
 {
+   if (gr->pane->hud->stream)
+      hud_stream_add_sample(gr->pane->hud->stream, gr->stream_id, value);
+
    gr->current_value = value;
    value = value > gr->pane->ceiling ? gr->pane->ceiling : value;
 
@@ -1558,6 +1574,11 @@ print_help(struct pipe_screen *screen)
    puts("  You can change behavior of the whole HUD by adding these options at");
    puts("  the beginning of the environment variable:");
    puts("  'simple,' disables all the fancy stuff and only draws text.");
+   puts("  'stream,' draws nothing and streams the raw values with timestamps");
+   puts("            from a background thread instead. GALLIUM_HUD_STREAM sets");
+   puts("            the destination (a file or unix:<socket path>, stderr by");
+   puts("            default), GALLIUM_HUD_STREAM_BINARY=1 selects packed");
+   puts("            binary records instead of CSV.");
    puts("");
    puts("  Example: GALLIUM_HUD=\".w256.h64.x1600.y520.d.c1000fps+cpu,.datom-count\"");
    puts("");
@@ -1801,7 +1822,7 @@ hud_create(struct cso_context *cso, struct hud_context *share)
          hud_set_record_context(share, cso_get_pipe_context(cso));
       }
 
-      if (context_id == draw_ctx) {
+      if (context_id == draw_ctx && !share->stream) {
          assert(!share->pipe);
          hud_set_draw_context(share, cso);
       }
@@ -1832,8 +1853,18 @@ hud_create(struct cso_context *cso, struct hud_context *share)
    if (!hud)
       return NULL;
 
+   if (util_strncmp(env, "stream,", 7) == 0) {
+      hud->stream = hud_stream_create();
+      if (!hud->stream) {
+         FREE(hud);
+         return NULL;
+      }
+      env += 7;
+   }
+
    /* font (the context is only used for the texture upload) */
-   if (!util_font_create(cso_get_pipe_context(cso),
+   if (!hud->stream &&
+       !util_font_create(cso_get_pipe_context(cso),
                          UTIL_FONT_FIXED_8X13, &hud->font)) {
       FREE(hud);
       return NULL;
@@ -1904,10 +1935,13 @@ hud_create(struct cso_context *cso, struct hud_context *share)
 
    if (record_ctx == 0)
       hud_set_record_context(hud, cso_get_pipe_context(cso));
-   if (draw_ctx == 0)
+   if (draw_ctx == 0 && !hud->stream)
       hud_set_draw_context(hud, cso);
 
    hud_parse_env_var(hud, screen, env);
+
+   if (hud->stream)
+      hud_stream_begin(hud->stream, &hud->pane_list);
    return hud;
 }
 
@@ -1925,6 +1959,8 @@ hud_destroy(struct hud_context *hud, struct cso_context *cso)
       hud_unset_draw_context(hud);
 
    if (p_atomic_dec_zero(&hud->refcount)) {
+      if (hud->stream)
+         hud_stream_destroy(hud->stream);
       pipe_resource_reference(&hud->font.texture, NULL);
       FREE(hud);
    }
@@ -43,6 +43,9 @@ struct hud_context {
    int refcount;
    bool simple;
 
+   /* Headless mode: values are streamed out instead of drawn. */
+   struct hud_stream *stream;
+
    /* Context where queries are executed. */
    struct pipe_context *record_pipe;
 
@@ -114,6 +117,7 @@ struct hud_graph {
    unsigned index; /* vertex index being updated */
    double current_value;
    FILE *fd;
+   unsigned stream_id;
 };
 
 struct hud_pane {
@@ -149,6 +153,16 @@ void hud_pane_add_graph(struct hud_pane *pane, struct hud_graph *gr);
 void hud_pane_set_max_value(struct hud_pane *pane, uint64_t value);
 void hud_graph_add_value(struct hud_graph *gr, double value);
 
+/* headless streaming */
+struct hud_stream;
+
+struct hud_stream *hud_stream_create(void);
+void hud_stream_destroy(struct hud_stream *stream);
+void hud_stream_begin(struct hud_stream *stream, struct list_head *pane_list);
+void hud_stream_add_sample(struct hud_stream *stream, unsigned id,
+                           double value);
+void hud_stream_flush(struct hud_stream *stream);
+
 /* graphs/queries */
 struct hud_batch_query_context;
 
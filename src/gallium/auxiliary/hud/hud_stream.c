@@ -0,0 +1,277 @@
+/**************************************************************************
+ *
+ * Copyright 2018 Advanced Micro Devices, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+/* This file implements the headless HUD mode ("GALLIUM_HUD=stream,...").
+ * Instead of drawing, every value added to a graph is recorded as a raw
+ * sample (timestamp, graph id, value). The samples of a frame are handed
+ * to a background thread, which formats them and writes them out, so the
+ * application thread only appends to an array.
+ *
+ * GALLIUM_HUD_STREAM selects the destination: a file name, or
+ * "unix:<path>" to connect to a Unix domain socket. The default is stderr.
+ * The output is CSV unless GALLIUM_HUD_STREAM_BINARY is set.
+ */
+
+#include "hud/hud_private.h"
+#include "pipe/p_config.h"
+#include "util/os_time.h"
+#include "util/u_debug.h"
+#include "util/u_memory.h"
+#include "util/u_queue.h"
+#include "util/u_string.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+
+#ifdef PIPE_OS_UNIX
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#define HUD_STREAM_BATCH_SIZE    256
+#define HUD_STREAM_MAX_BATCHES   16
+
+/* The binary stream starts with this, followed by a uint32_t number of
+ * graphs and a hud_stream_binary_graph for each graph. All values are in
+ * host byte order.
+ */
+#define HUD_STREAM_BINARY_MAGIC  "MESAHUD1"
+
+struct hud_stream_binary_graph {
+   uint32_t id;
+   char name[128];
+};
+
+struct hud_stream_sample {
+   uint64_t timestamp; /* nanoseconds, os_time_get_nano */
+   uint32_t id;
+   uint32_t padding;
+   double value;
+};
+
+struct hud_stream_batch {
+   struct util_queue_fence fence;
+   struct hud_stream *stream;
+   unsigned num_samples;
+   struct hud_stream_sample samples[HUD_STREAM_BATCH_SIZE];
+};
+
+struct hud_stream {
+   struct util_queue queue;
+   FILE *file;
+   bool binary;
+   unsigned num_graphs;
+   struct hud_stream_batch *batch; /* being filled */
+};
+
+static FILE *
+hud_stream_open(const char *dest)
+{
+   if (!dest || !*dest)
+      return stderr;
+
+#ifdef PIPE_OS_UNIX
+   if (!strncmp(dest, "unix:", 5)) {
+      struct sockaddr_un addr = {0};
+      FILE *file;
+      int fd;
+
+      addr.sun_family = AF_UNIX;
+      util_snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", dest + 5);
+
+      fd = socket(AF_UNIX, SOCK_STREAM, 0);
+      if (fd < 0)
+         return NULL;
+
+      if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0 ||
+          !(file = fdopen(fd, "w"))) {
+         close(fd);
+         return NULL;
+      }
+      return file;
+   }
+#endif
+
+   return fopen(dest, "w");
+}
+
+static void
+hud_stream_write_batch(void *job, int thread_index)
+{
+   struct hud_stream_batch *batch = job;
+   FILE *file = batch->stream->file;
+
+   if (batch->stream->binary) {
+      fwrite(batch->samples, sizeof(batch->samples[0]), batch->num_samples,
+             file);
+   } else {
+      for (unsigned i = 0; i < batch->num_samples; i++) {
+         struct hud_stream_sample *s = &batch->samples[i];
+
+         fprintf(file, "%" PRIu64 ",%u,%.17g\n", s->timestamp, s->id,
+                 s->value);
+      }
+   }
+   fflush(file);
+}
+
+static void
+hud_stream_free_batch(void *job, int thread_index)
+{
+   struct hud_stream_batch *batch = job;
+
+   util_queue_fence_destroy(&batch->fence);
+   FREE(batch);
+}
+
+struct hud_stream *
+hud_stream_create(void)
+{
+   const char *dest = debug_get_option("GALLIUM_HUD_STREAM", NULL);
+   struct hud_stream *stream = CALLOC_STRUCT(hud_stream);
+
+   if (!stream)
+      return NULL;
+
+   stream->file = hud_stream_open(dest);
+   if (!stream->file) {
+      fprintf(stderr, "gallium_hud: can't open the stream \"%s\"\n", dest);
+      goto fail;
+   }
+
+   if (!util_queue_init(&stream->queue, "hudstream", HUD_STREAM_MAX_BATCHES,
+                        1, 0)) {
+      fprintf(stderr, "gallium_hud: can't create the stream thread\n");
+      goto fail;
+   }
+
+   stream->binary = debug_get_bool_option("GALLIUM_HUD_STREAM_BINARY", false);
+   return stream;
+
+fail:
+   if (stream->file && stream->file != stderr)
+      fclose(stream->file);
+   FREE(stream);
+   return NULL;
+}
+
+/**
+ * Assign stream ids to all graphs and write the header, which maps the ids
+ * to the graph names. Call once after all graphs have been created.
+ */
+void
+hud_stream_begin(struct hud_stream *stream, struct list_head *pane_list)
+{
+   struct hud_pane *pane;
+   struct hud_graph *gr;
+
+   LIST_FOR_EACH_ENTRY(pane, pane_list, head) {
+      LIST_FOR_EACH_ENTRY(gr, &pane->graph_list, head) {
+         gr->stream_id = stream->num_graphs++;
+      }
+   }
+
+   if (stream->binary) {
+      uint32_t num_graphs = stream->num_graphs;
+
+      fwrite(HUD_STREAM_BINARY_MAGIC, 1, 8, stream->file);
+      fwrite(&num_graphs, sizeof(num_graphs), 1, stream->file);
+   }
+
+   LIST_FOR_EACH_ENTRY(pane, pane_list, head) {
+      LIST_FOR_EACH_ENTRY(gr, &pane->graph_list, head) {
+         if (stream->binary) {
+            struct hud_stream_binary_graph desc = {0};
+
+            desc.id = gr->stream_id;
+            util_snprintf(desc.name, sizeof(desc.name), "%s", gr->name);
+            fwrite(&desc, sizeof(desc), 1, stream->file);
+         } else {
+            fprintf(stream->file, "# %u,%s\n", gr->stream_id, gr->name);
+         }
+      }
+   }
+
+   if (!stream->binary)
+      fprintf(stream->file, "timestamp_ns,id,value\n");
+   fflush(stream->file);
+}
+
+/**
+ * Queue the recorded samples for writing.
+ */
+void
+hud_stream_flush(struct hud_stream *stream)
+{
+   struct hud_stream_batch *batch = stream->batch;
+
+   if (!batch)
+      return;
+
+   stream->batch = NULL;
+   util_queue_add_job(&stream->queue, batch, &batch->fence,
+                      hud_stream_write_batch, hud_stream_free_batch);
+}
+
+void
+hud_stream_add_sample(struct hud_stream *stream, unsigned id, double value)
+{
+   struct hud_stream_batch *batch = stream->batch;
+   struct hud_stream_sample *s;
+
+   if (!batch) {
+      batch = stream->batch = MALLOC_STRUCT(hud_stream_batch);
+      if (!batch)
+         return;
+
+      util_queue_fence_init(&batch->fence);
+      batch->stream = stream;
+      batch->num_samples = 0;
+   }
+
+   s = &batch->samples[batch->num_samples++];
+   s->timestamp = os_time_get_nano();
+   s->id = id;
+   s->padding = 0;
+   s->value = value;
+
+   if (batch->num_samples == HUD_STREAM_BATCH_SIZE)
+      hud_stream_flush(stream);
+}
+
+void
+hud_stream_destroy(struct hud_stream *stream)
+{
+   hud_stream_flush(stream);
+   util_queue_finish(&stream->queue);
+   util_queue_destroy(&stream->queue);
+
+   if (stream->file != stderr)
+      fclose(stream->file);
+   FREE(stream);
+}
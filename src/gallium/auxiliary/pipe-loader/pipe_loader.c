@@ -36,6 +36,10 @@
 
 #include <string.h>
 
+#ifdef HAVE_LIBDRM
+#include <unistd.h>
+#endif
+
 #ifdef _MSC_VER
 #include <stdlib.h>
 #define PATH_MAX _MAX_PATH
@@ -137,6 +141,28 @@ pipe_loader_create_screen(struct pipe_loader_device *dev)
    return dev->ops->create_screen(dev, &config);
 }
 
+/**
+ * Build the path of the module of \p driver_name in the directory made of
+ * the first \p len characters of \p dir, or a bare module name for the
+ * dynamic linker to look up if \p len is zero.
+ */
+static bool
+module_path(char *path, size_t size, const char *dir, int len,
+            const char *driver_name)
+{
+   int ret;
+
+   if (len)
+      ret = util_snprintf(path, size, "%.*s/%s%s%s",
+                          len, dir,
+                          MODULE_PREFIX, driver_name, UTIL_DL_EXT);
+   else
+      ret = util_snprintf(path, size, "%s%s%s",
+                          MODULE_PREFIX, driver_name, UTIL_DL_EXT);
+
+   return ret > 0 && ret < size;
+}
+
 struct util_dl_library *
 pipe_loader_find_module(const char *driver_name,
                         const char *library_paths)
@@ -144,21 +170,13 @@ pipe_loader_find_module(const char *driver_name,
    struct util_dl_library *lib;
    const char *next;
    char path[PATH_MAX];
-   int len, ret;
+   int len;
 
    for (next = library_paths; *next; library_paths = next + 1) {
       next = util_strchrnul(library_paths, ':');
       len = next - library_paths;
 
-      if (len)
-         ret = util_snprintf(path, sizeof(path), "%.*s/%s%s%s",
-                             len, library_paths,
-                             MODULE_PREFIX, driver_name, UTIL_DL_EXT);
-      else
-         ret = util_snprintf(path, sizeof(path), "%s%s%s",
-                             MODULE_PREFIX, driver_name, UTIL_DL_EXT);
-
-      if (ret > 0 && ret < sizeof(path)) {
+      if (module_path(path, sizeof(path), library_paths, len, driver_name)) {
          lib = util_dl_open(path);
          if (lib) {
             return lib;
@@ -168,3 +186,36 @@ pipe_loader_find_module(const char *driver_name,
 
    return NULL;
 }
+
+#ifdef HAVE_LIBDRM
+bool
+pipe_loader_module_exists(const char *driver_name,
+                          const char *library_paths)
+{
+   const char *next;
+   char path[PATH_MAX];
+   int len;
+
+   for (next = library_paths; *next; library_paths = next + 1) {
+      next = util_strchrnul(library_paths, ':');
+      len = next - library_paths;
+
+      if (!module_path(path, sizeof(path), library_paths, len, driver_name))
+         continue;
+
+      if (len) {
+         if (access(path, R_OK) == 0)
+            return true;
+      } else {
+         /* Only the dynamic linker knows where to find it. */
+         struct util_dl_library *lib = util_dl_open(path);
+         if (lib) {
+            util_dl_close(lib);
+            return true;
+         }
+      }
+   }
+
+   return false;
+}
+#endif
@@ -30,9 +30,12 @@
  *
  **************************************************************************/
 
+#include <dirent.h>
 #include <fcntl.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
 #include <xf86drm.h>
 #include <unistd.h>
 
@@ -44,6 +47,7 @@
 #include "util/u_memory.h"
 #include "util/u_dl.h"
 #include "util/u_debug.h"
+#include "c11/threads.h"
 
 #define DRM_RENDER_NODE_DEV_NAME_FORMAT "%s/renderD%d"
 #define DRM_RENDER_NODE_MAX_NODES 63
@@ -52,7 +56,7 @@
 
 struct pipe_loader_drm_device {
    struct pipe_loader_device base;
-   const struct drm_driver_descriptor *dd;
+   const struct drm_driver_descriptor *dd; /**< loaded on first use */
 #ifndef GALLIUM_STATIC_TARGETS
    struct util_dl_library *lib;
 #endif
@@ -168,6 +172,40 @@ get_driver_descriptor(const char *driver_name, struct util_dl_library **plib)
    return NULL;
 }
 
+/**
+ * Check whether there is a driver for \p driver_name, without loading it.
+ */
+static bool
+driver_available(const char *driver_name)
+{
+#ifdef GALLIUM_STATIC_TARGETS
+   return get_driver_descriptor(driver_name, NULL) != NULL;
+#else
+   return pipe_loader_module_exists(driver_name, PIPE_SEARCH_DIR);
+#endif
+}
+
+/**
+ * Return the driver descriptor of the device, loading the driver module if
+ * this is the first time it is needed.
+ */
+static const struct drm_driver_descriptor *
+pipe_loader_drm_get_descriptor(struct pipe_loader_drm_device *ddev)
+{
+   if (!ddev->dd) {
+      struct util_dl_library **plib = NULL;
+#ifndef GALLIUM_STATIC_TARGETS
+      /* The module was loaded before but didn't provide the driver. */
+      if (ddev->lib)
+         return NULL;
+      plib = &ddev->lib;
+#endif
+      ddev->dd = get_driver_descriptor(ddev->base.driver_name, plib);
+   }
+
+   return ddev->dd;
+}
+
 bool
 pipe_loader_drm_probe_fd(struct pipe_loader_device **dev, int fd)
 {
@@ -191,50 +229,117 @@ pipe_loader_drm_probe_fd(struct pipe_loader_device **dev, int fd)
    if (!ddev->base.driver_name)
       goto fail;
 
-   struct util_dl_library **plib = NULL;
-#ifndef GALLIUM_STATIC_TARGETS
-   plib = &ddev->lib;
-#endif
-   ddev->dd = get_driver_descriptor(ddev->base.driver_name, plib);
-   if (!ddev->dd)
+   /* The driver is only loaded once a screen or its configuration is
+    * needed, so that probing devices that end up unused stays cheap.
+    */
+   if (!driver_available(ddev->base.driver_name))
       goto fail;
 
    *dev = &ddev->base;
    return true;
 
   fail:
-#ifndef GALLIUM_STATIC_TARGETS
-   if (ddev->lib)
-      util_dl_close(ddev->lib);
-#endif
    FREE(ddev->base.driver_name);
    FREE(ddev);
    return false;
 }
 
-static int
-open_drm_render_node_minor(int minor)
+/**
+ * Outcome of probing a render node, kept for later probes in the same
+ * process.  Applications usually probe once to count the devices and then
+ * again to get them.
+ */
+struct render_node_probe {
+   bool probed;
+   bool supported;
+   dev_t rdev;
+};
+
+static struct render_node_probe render_node_probes[DRM_RENDER_NODE_MAX_NODES + 1];
+static mtx_t render_node_probes_mutex = _MTX_INITIALIZER_NP;
+
+/**
+ * Return a mask of the render node minors present in DRM_DIR_NAME, relative
+ * to DRM_RENDER_NODE_MIN_MINOR, so that only existing nodes get opened.
+ */
+static uint64_t
+list_drm_render_node_minors(void)
 {
-   char path[PATH_MAX];
-   snprintf(path, sizeof(path), DRM_RENDER_NODE_DEV_NAME_FORMAT, DRM_DIR_NAME,
-            minor);
-   return loader_open_device(path);
+   uint64_t minors = 0;
+   struct dirent *entry;
+   DIR *dir;
+
+   dir = opendir(DRM_DIR_NAME);
+   if (!dir)
+      return 0;
+
+   while ((entry = readdir(dir))) {
+      char *end;
+      long minor;
+
+      if (strncmp(entry->d_name, "renderD", 7) != 0)
+         continue;
+
+      minor = strtol(entry->d_name + 7, &end, 10);
+      if (*end || minor < DRM_RENDER_NODE_MIN_MINOR ||
+          minor > DRM_RENDER_NODE_MAX_MINOR)
+         continue;
+
+      minors |= 1ull << (minor - DRM_RENDER_NODE_MIN_MINOR);
+   }
+
+   closedir(dir);
+   return minors;
 }
 
 int
 pipe_loader_drm_probe(struct pipe_loader_device **devs, int ndev)
 {
+   uint64_t minors = list_drm_render_node_minors();
    int i, j, fd;
 
    for (i = DRM_RENDER_NODE_MIN_MINOR, j = 0;
         i <= DRM_RENDER_NODE_MAX_MINOR; i++) {
+      struct render_node_probe *probe =
+         &render_node_probes[i - DRM_RENDER_NODE_MIN_MINOR];
       struct pipe_loader_device *dev;
+      char path[PATH_MAX];
+      struct stat st;
+      bool known, supported;
+
+      if (!(minors & (1ull << (i - DRM_RENDER_NODE_MIN_MINOR))))
+         continue;
+
+      snprintf(path, sizeof(path), DRM_RENDER_NODE_DEV_NAME_FORMAT,
+               DRM_DIR_NAME, i);
+      if (stat(path, &st) != 0)
+         continue;
 
-      fd = open_drm_render_node_minor(i);
+      mtx_lock(&render_node_probes_mutex);
+      known = probe->probed && probe->rdev == st.st_rdev;
+      supported = probe->supported;
+      mtx_unlock(&render_node_probes_mutex);
+
+      /* Devices that are only counted don't need to be opened again. */
+      if (known && (!supported || j >= ndev)) {
+         if (supported)
+            j++;
+         continue;
+      }
+
+      fd = loader_open_device(path);
       if (fd < 0)
          continue;
 
-      if (!pipe_loader_drm_probe_fd(&dev, fd)) {
+      supported = pipe_loader_drm_probe_fd(&dev, fd);
+
+      mtx_lock(&render_node_probes_mutex);
+      probe->probed = true;
+      probe->supported = supported;
+      probe->rdev = st.st_rdev;
+      mtx_unlock(&render_node_probes_mutex);
+
+      if (!supported) {
          close(fd);
          continue;
       }
@@ -242,7 +347,7 @@ pipe_loader_drm_probe(struct pipe_loader_device **devs, int ndev)
       if (j < ndev) {
          devs[j] = dev;
       } else {
-         close(fd);
+         /* This closes the fd. */
          dev->ops->release(&dev);
       }
       j++;
@@ -271,11 +376,13 @@ pipe_loader_drm_configuration(struct pipe_loader_device *dev,
                               enum drm_conf conf)
 {
    struct pipe_loader_drm_device *ddev = pipe_loader_drm_device(dev);
+   const struct drm_driver_descriptor *dd =
+      pipe_loader_drm_get_descriptor(ddev);
 
-   if (!ddev->dd->configuration)
+   if (!dd || !dd->configuration)
       return NULL;
 
-   return ddev->dd->configuration(conf);
+   return dd->configuration(conf);
 }
 
 static struct pipe_screen *
@@ -283,8 +390,13 @@ pipe_loader_drm_create_screen(struct pipe_loader_device *dev,
                               const struct pipe_screen_config *config)
 {
    struct pipe_loader_drm_device *ddev = pipe_loader_drm_device(dev);
+   const struct drm_driver_descriptor *dd =
+      pipe_loader_drm_get_descriptor(ddev);
+
+   if (!dd)
+      return NULL;
 
-   return ddev->dd->create_screen(ddev->fd, config);
+   return dd->create_screen(ddev->fd, config);
 }
 
 char *
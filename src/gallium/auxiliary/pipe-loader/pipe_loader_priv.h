@@ -47,6 +47,14 @@ struct util_dl_library *
 pipe_loader_find_module(const char *driver_name,
                         const char *library_paths);
 
+/**
+ * Check whether the pipe driver module that contains the specified driver
+ * exists, without loading it.
+ */
+bool
+pipe_loader_module_exists(const char *driver_name,
+                          const char *library_paths);
+
 /**
  * Free the base device structure.
  *
@@ -46,10 +46,29 @@ destroy_buffer_locked(struct pb_cache_entry *entry)
       assert(mgr->num_buffers);
       --mgr->num_buffers;
       mgr->cache_size -= buf->size;
+      mgr->stats[entry->bucket_index].size -= buf->size;
    }
    mgr->destroy_buffer(buf);
 }
 
+/**
+ * Destroy a buffer that timed out.  The first expiration after a quiet
+ * period lets the bucket's timeout shrink back towards the default.
+ */
+static void
+destroy_expired_buffer_locked(struct pb_cache_entry *entry,
+                              int64_t current_time)
+{
+   struct pb_cache *mgr = entry->mgr;
+   struct pb_cache_bucket_stats *stats = &mgr->stats[entry->bucket_index];
+
+   if (current_time - stats->last_expired > stats->usecs)
+      stats->usecs = MAX2(stats->usecs / 2, mgr->usecs);
+   stats->last_expired = current_time;
+
+   destroy_buffer_locked(entry);
+}
+
 /**
  * Free as many cache buffers from the list head as possible.
  */
@@ -68,7 +87,7 @@ release_expired_buffers_locked(struct list_head *cache,
       if (!os_time_timeout(entry->start, entry->end, current_time))
          break;
 
-      destroy_buffer_locked(entry);
+      destroy_expired_buffer_locked(entry, current_time);
 
       curr = next;
       next = curr->next;
@@ -103,10 +122,11 @@ pb_cache_add_buffer(struct pb_cache_entry *entry)
    }
 
    entry->start = os_time_get();
-   entry->end = entry->start + mgr->usecs;
+   entry->end = entry->start + mgr->stats[entry->bucket_index].usecs;
    LIST_ADDTAIL(&entry->head, cache);
    ++mgr->num_buffers;
    mgr->cache_size += buf->size;
+   mgr->stats[entry->bucket_index].size += buf->size;
    mtx_unlock(&mgr->mutex);
 }
 
@@ -156,8 +176,10 @@ pb_cache_reclaim_buffer(struct pb_cache *mgr, pb_size size,
 
    assert(bucket_index < mgr->num_heaps);
    struct list_head *cache = &mgr->buckets[bucket_index];
+   struct pb_cache_bucket_stats *stats = &mgr->stats[bucket_index];
 
    mtx_lock(&mgr->mutex);
+   stats->requested += size;
 
    entry = NULL;
    cur = cache->next;
@@ -172,7 +194,7 @@ pb_cache_reclaim_buffer(struct pb_cache *mgr, pb_size size,
                                                      alignment, usage)) > 0)
          entry = cur_entry;
       else if (os_time_timeout(cur_entry->start, cur_entry->end, now))
-         destroy_buffer_locked(cur_entry);
+         destroy_expired_buffer_locked(cur_entry, now);
       else
          /* This buffer (and all hereafter) are still hot in cache */
          break;
@@ -208,14 +230,27 @@ pb_cache_reclaim_buffer(struct pb_cache *mgr, pb_size size,
       struct pb_buffer *buf = entry->buffer;
 
       mgr->cache_size -= buf->size;
+      stats->size -= buf->size;
       LIST_DEL(&entry->head);
       --mgr->num_buffers;
+      ++mgr->num_hits;
+      ++stats->num_hits;
       mtx_unlock(&mgr->mutex);
       /* Increase refcount */
       pipe_reference_init(&buf->reference, 1);
       return buf;
    }
 
+   ++mgr->num_misses;
+   ++stats->num_misses;
+
+   /* A buffer of this bucket timed out shortly before it would have been
+    * reused, so keep them around for longer.
+    */
+   if (now - stats->last_expired < stats->usecs)
+      stats->usecs = MIN2(stats->usecs * 2,
+                          mgr->usecs * PB_CACHE_MAX_TIMEOUT_SCALE);
+
    mtx_unlock(&mgr->mutex);
    return NULL;
 }
@@ -246,6 +281,44 @@ pb_cache_release_all_buffers(struct pb_cache *mgr)
    mtx_unlock(&mgr->mutex);
 }
 
+/**
+ * Release the unused buffers the recent allocations don't justify keeping.
+ *
+ * Each bucket keeps at most as many bytes as were requested from it since
+ * the previous call, or half of its previous budget if that's more, so the
+ * budget follows bursts quickly and decays over a few calls.  The oldest
+ * buffers are released first.
+ *
+ * Meant to be called when the driver is likely to be idle for a moment,
+ * such as at the end of a frame.
+ */
+void
+pb_cache_trim(struct pb_cache *mgr)
+{
+   struct list_head *curr, *next;
+   struct pb_cache_entry *buf;
+   unsigned i;
+
+   mtx_lock(&mgr->mutex);
+   for (i = 0; i < mgr->num_heaps; i++) {
+      struct list_head *cache = &mgr->buckets[i];
+      struct pb_cache_bucket_stats *stats = &mgr->stats[i];
+
+      stats->budget = MAX2(stats->requested, stats->budget / 2);
+      stats->requested = 0;
+
+      curr = cache->next;
+      next = curr->next;
+      while (curr != cache && stats->size > stats->budget) {
+         buf = LIST_ENTRY(struct pb_cache_entry, curr, head);
+         destroy_buffer_locked(buf);
+         curr = next;
+         next = curr->next;
+      }
+   }
+   mtx_unlock(&mgr->mutex);
+}
+
 void
 pb_cache_init_entry(struct pb_cache *mgr, struct pb_cache_entry *entry,
                     struct pb_buffer *buf, unsigned bucket_index)
@@ -266,7 +339,9 @@ pb_cache_init_entry(struct pb_cache *mgr, struct pb_cache_entry *entry,
  *                   for faster buffer matching (alternative to slower
  *                   "usage"-based matching).
  * @param usecs   Unused buffers may be released from the cache after this
- *                time
+ *                time.  Buckets whose buffers keep timing out right before
+ *                they're needed again use a longer timeout, up to
+ *                PB_CACHE_MAX_TIMEOUT_SCALE times this.
  * @param size_factor  Declare buffers that are size_factor times bigger than
  *                     the requested size as cache hits.
  * @param bypass_usage  Bitmask. If (requested usage & bypass_usage) != 0,
@@ -289,12 +364,23 @@ pb_cache_init(struct pb_cache *mgr, uint num_heaps,
    if (!mgr->buckets)
       return;
 
-   for (i = 0; i < num_heaps; i++)
+   mgr->stats = CALLOC(num_heaps, sizeof(struct pb_cache_bucket_stats));
+   if (!mgr->stats) {
+      FREE(mgr->buckets);
+      mgr->buckets = NULL;
+      return;
+   }
+
+   for (i = 0; i < num_heaps; i++) {
       LIST_INITHEAD(&mgr->buckets[i]);
+      mgr->stats[i].usecs = usecs;
+   }
 
    (void) mtx_init(&mgr->mutex, mtx_plain);
    mgr->cache_size = 0;
    mgr->max_cache_size = maximum_cache_size;
+   mgr->num_hits = 0;
+   mgr->num_misses = 0;
    mgr->num_heaps = num_heaps;
    mgr->usecs = usecs;
    mgr->num_buffers = 0;
@@ -313,5 +399,7 @@ pb_cache_deinit(struct pb_cache *mgr)
    pb_cache_release_all_buffers(mgr);
    mtx_destroy(&mgr->mutex);
    FREE(mgr->buckets);
+   FREE(mgr->stats);
    mgr->buckets = NULL;
+   mgr->stats = NULL;
 }
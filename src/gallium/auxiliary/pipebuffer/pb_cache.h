@@ -33,6 +33,12 @@
 #include "util/list.h"
 #include "os/os_thread.h"
 
+/**
+ * How far a bucket's timeout can grow when its buffers keep timing out
+ * right before they're needed again.
+ */
+#define PB_CACHE_MAX_TIMEOUT_SCALE 8
+
 /**
  * Statically inserted into the driver-specific buffer structure.
  */
@@ -45,16 +51,39 @@ struct pb_cache_entry
    unsigned bucket_index;
 };
 
+/**
+ * Per-bucket statistics and adaptive limits.
+ */
+struct pb_cache_bucket_stats
+{
+   uint64_t num_hits;
+   uint64_t num_misses;
+   uint64_t size;       /**< Bytes of unused buffers in the bucket */
+
+   /* Bytes requested since the last pb_cache_trim, and the budget the
+    * bucket was trimmed to then.
+    */
+   uint64_t requested;
+   uint64_t budget;
+
+   int64_t last_expired; /**< When a buffer last timed out */
+   unsigned usecs;       /**< Current timeout, between usecs and
+                          *   usecs * PB_CACHE_MAX_TIMEOUT_SCALE */
+};
+
 struct pb_cache
 {
    /* The cache is divided into buckets for minimizing cache misses.
     * The driver controls which buffer goes into which bucket.
     */
    struct list_head *buckets;
+   struct pb_cache_bucket_stats *stats;
 
    mtx_t mutex;
    uint64_t cache_size;
    uint64_t max_cache_size;
+   uint64_t num_hits;
+   uint64_t num_misses;
    unsigned num_heaps;
    unsigned usecs;
    unsigned num_buffers;
@@ -70,6 +99,7 @@ struct pb_buffer *pb_cache_reclaim_buffer(struct pb_cache *mgr, pb_size size,
                                           unsigned alignment, unsigned usage,
                                           unsigned bucket_index);
 void pb_cache_release_all_buffers(struct pb_cache *mgr);
+void pb_cache_trim(struct pb_cache *mgr);
 void pb_cache_init_entry(struct pb_cache *mgr, struct pb_cache_entry *entry,
                          struct pb_buffer *buf, unsigned bucket_index);
 void pb_cache_init(struct pb_cache *mgr, uint num_heaps,
@@ -58,9 +58,11 @@
 #include "tgsi/tgsi_parse.h"
 #include "tgsi/tgsi_util.h"
 #include "tgsi_exec.h"
+#include "tgsi_sse2.h"
 #include "util/u_half.h"
 #include "util/u_memory.h"
 #include "util/u_math.h"
+#include "util/u_sse.h"
 #include "util/rounding.h"
 
 
@@ -90,10 +92,15 @@ static void
 micro_abs(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src)
 {
+#if defined(PIPE_ARCH_SSE)
+   _mm_storeu_ps(dst->f,
+                 _mm_andnot_ps(_mm_set1_ps(-0.0f), _mm_loadu_ps(src->f)));
+#else
    dst->f[0] = fabsf(src->f[0]);
    dst->f[1] = fabsf(src->f[1]);
    dst->f[2] = fabsf(src->f[2]);
    dst->f[3] = fabsf(src->f[3]);
+#endif
 }
 
 static void
@@ -496,10 +503,19 @@ micro_lrp(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src1,
           const union tgsi_exec_channel *src2)
 {
+#if defined(PIPE_ARCH_SSE)
+   const __m128 s2 = _mm_loadu_ps(src2->f);
+
+   _mm_storeu_ps(dst->f,
+                 _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(src0->f),
+                                       _mm_sub_ps(_mm_loadu_ps(src1->f), s2)),
+                            s2));
+#else
    dst->f[0] = src0->f[0] * (src1->f[0] - src2->f[0]) + src2->f[0];
    dst->f[1] = src0->f[1] * (src1->f[1] - src2->f[1]) + src2->f[1];
    dst->f[2] = src0->f[2] * (src1->f[2] - src2->f[2]) + src2->f[2];
    dst->f[3] = src0->f[3] * (src1->f[3] - src2->f[3]) + src2->f[3];
+#endif
 }
 
 static void
@@ -508,10 +524,17 @@ micro_mad(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src1,
           const union tgsi_exec_channel *src2)
 {
+#if defined(PIPE_ARCH_SSE)
+   _mm_storeu_ps(dst->f,
+                 _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(src0->f),
+                                       _mm_loadu_ps(src1->f)),
+                            _mm_loadu_ps(src2->f)));
+#else
    dst->f[0] = src0->f[0] * src1->f[0] + src2->f[0];
    dst->f[1] = src0->f[1] * src1->f[1] + src2->f[1];
    dst->f[2] = src0->f[2] * src1->f[2] + src2->f[2];
    dst->f[3] = src0->f[3] * src1->f[3] + src2->f[3];
+#endif
 }
 
 static void
@@ -534,10 +557,15 @@ micro_rcp(union tgsi_exec_channel *dst,
    assert(src->f[2] != 0.0f);
    assert(src->f[3] != 0.0f);
 #endif
+#if defined(PIPE_ARCH_SSE)
+   _mm_storeu_ps(dst->f,
+                 _mm_div_ps(_mm_set1_ps(1.0f), _mm_loadu_ps(src->f)));
+#else
    dst->f[0] = 1.0f / src->f[0];
    dst->f[1] = 1.0f / src->f[1];
    dst->f[2] = 1.0f / src->f[2];
    dst->f[3] = 1.0f / src->f[3];
+#endif
 }
 
 static void
@@ -560,20 +588,31 @@ micro_rsq(union tgsi_exec_channel *dst,
    assert(src->f[2] != 0.0f);
    assert(src->f[3] != 0.0f);
 #endif
+#if defined(PIPE_ARCH_SSE)
+   /* Not rsqrtps, whose precision is far too low */
+   _mm_storeu_ps(dst->f,
+                 _mm_div_ps(_mm_set1_ps(1.0f),
+                            _mm_sqrt_ps(_mm_loadu_ps(src->f))));
+#else
    dst->f[0] = 1.0f / sqrtf(src->f[0]);
    dst->f[1] = 1.0f / sqrtf(src->f[1]);
    dst->f[2] = 1.0f / sqrtf(src->f[2]);
    dst->f[3] = 1.0f / sqrtf(src->f[3]);
+#endif
 }
 
 static void
 micro_sqrt(union tgsi_exec_channel *dst,
            const union tgsi_exec_channel *src)
 {
+#if defined(PIPE_ARCH_SSE)
+   _mm_storeu_ps(dst->f, _mm_sqrt_ps(_mm_loadu_ps(src->f)));
+#else
    dst->f[0] = sqrtf(src->f[0]);
    dst->f[1] = sqrtf(src->f[1]);
    dst->f[2] = sqrtf(src->f[2]);
    dst->f[3] = sqrtf(src->f[3]);
+#endif
 }
 
 static void
@@ -581,10 +620,15 @@ micro_seq(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src0,
           const union tgsi_exec_channel *src1)
 {
+#if defined(PIPE_ARCH_SSE)
+   _mm_storeu_ps(dst->f, _mm_and_ps(_mm_cmpeq_ps(_mm_loadu_ps(src0->f), _mm_loadu_ps(src1->f)),
+                                    _mm_set1_ps(1.0f)));
+#else
    dst->f[0] = src0->f[0] == src1->f[0] ? 1.0f : 0.0f;
    dst->f[1] = src0->f[1] == src1->f[1] ? 1.0f : 0.0f;
    dst->f[2] = src0->f[2] == src1->f[2] ? 1.0f : 0.0f;
    dst->f[3] = src0->f[3] == src1->f[3] ? 1.0f : 0.0f;
+#endif
 }
 
 static void
@@ -592,10 +636,15 @@ micro_sge(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src0,
           const union tgsi_exec_channel *src1)
 {
+#if defined(PIPE_ARCH_SSE)
+   _mm_storeu_ps(dst->f, _mm_and_ps(_mm_cmpge_ps(_mm_loadu_ps(src0->f), _mm_loadu_ps(src1->f)),
+                                    _mm_set1_ps(1.0f)));
+#else
    dst->f[0] = src0->f[0] >= src1->f[0] ? 1.0f : 0.0f;
    dst->f[1] = src0->f[1] >= src1->f[1] ? 1.0f : 0.0f;
    dst->f[2] = src0->f[2] >= src1->f[2] ? 1.0f : 0.0f;
    dst->f[3] = src0->f[3] >= src1->f[3] ? 1.0f : 0.0f;
+#endif
 }
 
 static void
@@ -655,10 +704,15 @@ micro_slt(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src0,
           const union tgsi_exec_channel *src1)
 {
+#if defined(PIPE_ARCH_SSE)
+   _mm_storeu_ps(dst->f, _mm_and_ps(_mm_cmplt_ps(_mm_loadu_ps(src0->f), _mm_loadu_ps(src1->f)),
+                                    _mm_set1_ps(1.0f)));
+#else
    dst->f[0] = src0->f[0] < src1->f[0] ? 1.0f : 0.0f;
    dst->f[1] = src0->f[1] < src1->f[1] ? 1.0f : 0.0f;
    dst->f[2] = src0->f[2] < src1->f[2] ? 1.0f : 0.0f;
    dst->f[3] = src0->f[3] < src1->f[3] ? 1.0f : 0.0f;
+#endif
 }
 
 static void
@@ -666,10 +720,15 @@ micro_sne(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src0,
           const union tgsi_exec_channel *src1)
 {
+#if defined(PIPE_ARCH_SSE)
+   _mm_storeu_ps(dst->f, _mm_and_ps(_mm_cmpneq_ps(_mm_loadu_ps(src0->f), _mm_loadu_ps(src1->f)),
+                                    _mm_set1_ps(1.0f)));
+#else
    dst->f[0] = src0->f[0] != src1->f[0] ? 1.0f : 0.0f;
    dst->f[1] = src0->f[1] != src1->f[1] ? 1.0f : 0.0f;
    dst->f[2] = src0->f[2] != src1->f[2] ? 1.0f : 0.0f;
    dst->f[3] = src0->f[3] != src1->f[3] ? 1.0f : 0.0f;
+#endif
 }
 
 static void
@@ -1117,6 +1176,9 @@ tgsi_exec_machine_bind_shader(
    mach->Image = image;
    mach->Buffer = buffer;
 
+   tgsi_sse2_destroy(mach->Sse2);
+   mach->Sse2 = NULL;
+
    if (!tokens) {
       /* unbind and free all */
       FREE(mach->Declarations);
@@ -1273,6 +1335,8 @@ tgsi_exec_machine_bind_shader(
    FREE(mach->Instructions);
    mach->Instructions = instructions;
    mach->NumInstructions = numInstructions;
+
+   mach->Sse2 = tgsi_sse2_create(mach);
 }
 
 
@@ -1335,6 +1399,7 @@ void
 tgsi_exec_machine_destroy(struct tgsi_exec_machine *mach)
 {
    if (mach) {
+      tgsi_sse2_destroy(mach->Sse2);
       FREE(mach->Instructions);
       FREE(mach->Declarations);
 
@@ -1350,10 +1415,14 @@ micro_add(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src0,
           const union tgsi_exec_channel *src1)
 {
+#if defined(PIPE_ARCH_SSE)
+   _mm_storeu_ps(dst->f, _mm_add_ps(_mm_loadu_ps(src0->f), _mm_loadu_ps(src1->f)));
+#else
    dst->f[0] = src0->f[0] + src1->f[0];
    dst->f[1] = src0->f[1] + src1->f[1];
    dst->f[2] = src0->f[2] + src1->f[2];
    dst->f[3] = src0->f[3] + src1->f[3];
+#endif
 }
 
 static void
@@ -1395,10 +1464,14 @@ micro_max(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src0,
           const union tgsi_exec_channel *src1)
 {
+#if defined(PIPE_ARCH_SSE)
+   _mm_storeu_ps(dst->f, _mm_max_ps(_mm_loadu_ps(src0->f), _mm_loadu_ps(src1->f)));
+#else
    dst->f[0] = src0->f[0] > src1->f[0] ? src0->f[0] : src1->f[0];
    dst->f[1] = src0->f[1] > src1->f[1] ? src0->f[1] : src1->f[1];
    dst->f[2] = src0->f[2] > src1->f[2] ? src0->f[2] : src1->f[2];
    dst->f[3] = src0->f[3] > src1->f[3] ? src0->f[3] : src1->f[3];
+#endif
 }
 
 static void
@@ -1406,10 +1479,15 @@ micro_min(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src0,
           const union tgsi_exec_channel *src1)
 {
+#if defined(PIPE_ARCH_SSE)
+   /* minps returns the second operand when unordered, like the ?: below */
+   _mm_storeu_ps(dst->f, _mm_min_ps(_mm_loadu_ps(src0->f), _mm_loadu_ps(src1->f)));
+#else
    dst->f[0] = src0->f[0] < src1->f[0] ? src0->f[0] : src1->f[0];
    dst->f[1] = src0->f[1] < src1->f[1] ? src0->f[1] : src1->f[1];
    dst->f[2] = src0->f[2] < src1->f[2] ? src0->f[2] : src1->f[2];
    dst->f[3] = src0->f[3] < src1->f[3] ? src0->f[3] : src1->f[3];
+#endif
 }
 
 static void
@@ -1417,10 +1495,14 @@ micro_mul(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src0,
           const union tgsi_exec_channel *src1)
 {
+#if defined(PIPE_ARCH_SSE)
+   _mm_storeu_ps(dst->f, _mm_mul_ps(_mm_loadu_ps(src0->f), _mm_loadu_ps(src1->f)));
+#else
    dst->f[0] = src0->f[0] * src1->f[0];
    dst->f[1] = src0->f[1] * src1->f[1];
    dst->f[2] = src0->f[2] * src1->f[2];
    dst->f[3] = src0->f[3] * src1->f[3];
+#endif
 }
 
 static void
@@ -1428,10 +1510,15 @@ micro_neg(
    union tgsi_exec_channel *dst,
    const union tgsi_exec_channel *src )
 {
+#if defined(PIPE_ARCH_SSE)
+   _mm_storeu_ps(dst->f,
+                 _mm_xor_ps(_mm_set1_ps(-0.0f), _mm_loadu_ps(src->f)));
+#else
    dst->f[0] = -src->f[0];
    dst->f[1] = -src->f[1];
    dst->f[2] = -src->f[2];
    dst->f[3] = -src->f[3];
+#endif
 }
 
 static void
@@ -1469,10 +1556,14 @@ micro_sub(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src0,
           const union tgsi_exec_channel *src1)
 {
+#if defined(PIPE_ARCH_SSE)
+   _mm_storeu_ps(dst->f, _mm_sub_ps(_mm_loadu_ps(src0->f), _mm_loadu_ps(src1->f)));
+#else
    dst->f[0] = src0->f[0] - src1->f[0];
    dst->f[1] = src0->f[1] - src1->f[1];
    dst->f[2] = src0->f[2] - src1->f[2];
    dst->f[3] = src0->f[3] - src1->f[3];
+#endif
 }
 
 static void
@@ -1963,10 +2054,23 @@ store_dest(struct tgsi_exec_machine *mach,
       return;
 
    if (!inst->Instruction.Saturate) {
+      if (execmask == 0xf) {
+         *dst = *chan;
+         return;
+      }
       for (i = 0; i < TGSI_QUAD_SIZE; i++)
          if (execmask & (1 << i))
             dst->i[i] = chan->i[i];
    }
+#if defined(PIPE_ARCH_SSE)
+   else if (execmask == 0xf) {
+      /* Operand order keeps NaN, as the comparisons below do */
+      _mm_storeu_ps(dst->f,
+                    _mm_min_ps(_mm_set1_ps(1.0f),
+                               _mm_max_ps(_mm_setzero_ps(),
+                                          _mm_loadu_ps(chan->f))));
+   }
+#endif
    else {
       for (i = 0; i < TGSI_QUAD_SIZE; i++)
          if (execmask & (1 << i)) {
@@ -6101,6 +6205,9 @@ tgsi_exec_machine_run( struct tgsi_exec_machine *mach, int start_pc )
       for (i = 0; i < mach->NumDeclarations; i++) {
          exec_declaration( mach, mach->Declarations+i );
       }
+
+      if (mach->Sse2 && tgsi_sse2_run(mach->Sse2, mach))
+         return ~mach->Temps[TEMP_KILMASK_I].xyzw[TEMP_KILMASK_C].u[0];
    }
 
    {
@@ -445,6 +445,9 @@ struct tgsi_exec_machine
    struct tgsi_full_declaration *Declarations;
    uint NumDeclarations;
 
+   /** Native code for the bound shader, if it could be compiled */
+   struct tgsi_sse2_shader *Sse2;
+
    struct tgsi_declaration_sampler_view
       SamplerViews[PIPE_MAX_SHADER_SAMPLER_VIEWS];
 
@@ -0,0 +1,616 @@
+/**************************************************************************
+ * 
+ * Copyright 2018 VMware, Inc.
+ * All Rights Reserved.
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ * 
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL VMWARE AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ **************************************************************************/
+
+/**
+ * Translation of simple TGSI shaders to SSE2 code.
+ *
+ * Only straight-line shaders built from plain float ALU instructions
+ * reading and writing directly addressed registers are handled.  Anything
+ * else (control flow, texturing, kill, integer/double opcodes, indirect
+ * addressing, ...) makes tgsi_sse2_create() fail and the caller keeps
+ * using the interpreter.
+ *
+ * The generated code follows the interpreter's operation order and NaN
+ * behaviour, so both paths agree.  Every channel is a 4-wide SoA vector,
+ * which means one TGSI channel maps onto one XMM register.  All four
+ * lanes are written unconditionally: without control flow the execution
+ * mask only excludes lanes whose results are thrown away anyway.
+ */
+
+#include "pipe/p_config.h"
+
+#include "tgsi_sse2.h"
+
+#if (defined(PIPE_ARCH_X86) || defined(PIPE_ARCH_X86_64)) && !defined(PIPE_SUBSYSTEM_EMBEDDED)
+
+#include "pipe/p_shader_tokens.h"
+#include "util/u_debug.h"
+#include "util/u_memory.h"
+#include "tgsi/tgsi_exec.h"
+#include "tgsi/tgsi_parse.h"
+#include "tgsi/tgsi_util.h"
+
+#include "rtasm/rtasm_cpu.h"
+#include "rtasm/rtasm_x86sse.h"
+
+
+typedef void (*tgsi_sse2_func)(struct tgsi_exec_machine *mach);
+
+struct tgsi_sse2_shader {
+   struct x86_function func;
+   tgsi_sse2_func run;
+
+   /** Highest CONST[0] register read by the shader, or -1 */
+   int max_const;
+};
+
+struct gen_context {
+   struct x86_function *func;
+
+   struct x86_reg machine;
+   struct x86_reg inputs;
+   struct x86_reg outputs;
+   struct x86_reg consts;
+
+   int max_const;
+};
+
+
+/**
+ * Registers.  XMM0-3 hold the per channel results of an instruction and
+ * XMM4-5 are scratch.  XMM6 and up are callee-saved on Win64, so they
+ * are never used.
+ */
+static struct x86_reg
+make_xmm(unsigned idx)
+{
+   return x86_make_reg(file_XMM, idx);
+}
+
+#define XMM_TMP0 4
+#define XMM_TMP1 5
+
+
+static struct x86_reg
+get_temp(const struct gen_context *ctx, unsigned index, unsigned chan)
+{
+   return x86_make_disp(ctx->machine,
+                        offsetof(struct tgsi_exec_machine, Temps) +
+                        index * sizeof(struct tgsi_exec_vector) +
+                        chan * sizeof(union tgsi_exec_channel));
+}
+
+static struct x86_reg
+get_vector(struct x86_reg base, unsigned index, unsigned chan)
+{
+   return x86_make_disp(base,
+                        index * sizeof(struct tgsi_exec_vector) +
+                        chan * sizeof(union tgsi_exec_channel));
+}
+
+#define GET_CONST(ctx, name) \
+   get_temp(ctx, TGSI_EXEC_TEMP_##name##_I, TGSI_EXEC_TEMP_##name##_C)
+
+
+static void
+load_ptr(struct gen_context *ctx, struct x86_reg dst, struct x86_reg src)
+{
+   if (x86_target(ctx->func) != X86_32)
+      x64_mov64(ctx->func, dst, src);
+   else
+      x86_mov(ctx->func, dst, src);
+}
+
+/**
+ * Load a scalar float and replicate it across all lanes.
+ */
+static void
+emit_broadcast(struct gen_context *ctx, struct x86_reg dst,
+               struct x86_reg src)
+{
+   sse_movss(ctx->func, dst, src);
+   sse_shufps(ctx->func, dst, dst, SHUF(0, 0, 0, 0));
+}
+
+static void
+emit_fetch(struct gen_context *ctx, unsigned xmm,
+           const struct tgsi_full_src_register *reg, unsigned chan)
+{
+   struct x86_function *func = ctx->func;
+   struct x86_reg dst = make_xmm(xmm);
+   const unsigned index = reg->Register.Index;
+   const unsigned swizzle =
+      tgsi_util_get_full_src_register_swizzle(reg, chan);
+
+   switch (reg->Register.File) {
+   case TGSI_FILE_CONSTANT:
+      ctx->max_const = MAX2(ctx->max_const, (int) index);
+      emit_broadcast(ctx, dst,
+                     x86_make_disp(ctx->consts,
+                                   (index * 4 + swizzle) * sizeof(float)));
+      break;
+
+   case TGSI_FILE_IMMEDIATE:
+      emit_broadcast(ctx, dst,
+                     x86_make_disp(ctx->machine,
+                                   offsetof(struct tgsi_exec_machine, Imms) +
+                                   (index * 4 + swizzle) * sizeof(float)));
+      break;
+
+   case TGSI_FILE_INPUT:
+      sse_movups(func, dst, get_vector(ctx->inputs, index, swizzle));
+      break;
+
+   case TGSI_FILE_OUTPUT:
+      sse_movups(func, dst, get_vector(ctx->outputs, index, swizzle));
+      break;
+
+   case TGSI_FILE_TEMPORARY:
+      sse_movaps(func, dst, get_temp(ctx, index, swizzle));
+      break;
+
+   default:
+      assert(0);
+   }
+
+   if (reg->Register.Absolute)
+      sse_andps(func, dst, GET_CONST(ctx, 7FFFFFFF));
+
+   if (reg->Register.Negate)
+      sse_xorps(func, dst, GET_CONST(ctx, 80000000));
+}
+
+static void
+emit_store(struct gen_context *ctx, unsigned xmm,
+           const struct tgsi_full_instruction *inst, unsigned chan)
+{
+   struct x86_function *func = ctx->func;
+   const struct tgsi_full_dst_register *reg = &inst->Dst[0];
+   struct x86_reg src = make_xmm(xmm);
+
+   if (inst->Instruction.Saturate) {
+      /* Ordered so that NaN passes through, as in the interpreter. */
+      sse_xorps(func, make_xmm(XMM_TMP0), make_xmm(XMM_TMP0));
+      sse_maxps(func, make_xmm(XMM_TMP0), src);
+      sse_movaps(func, make_xmm(XMM_TMP1), GET_CONST(ctx, ONE));
+      sse_minps(func, make_xmm(XMM_TMP1), make_xmm(XMM_TMP0));
+      src = make_xmm(XMM_TMP1);
+   }
+
+   switch (reg->Register.File) {
+   case TGSI_FILE_OUTPUT:
+      sse_movups(func, get_vector(ctx->outputs, reg->Register.Index, chan),
+                 src);
+      break;
+
+   case TGSI_FILE_TEMPORARY:
+      sse_movaps(func, get_temp(ctx, reg->Register.Index, chan), src);
+      break;
+
+   default:
+      assert(0);
+   }
+}
+
+static void
+emit_compare(struct gen_context *ctx, unsigned xmm,
+             const struct tgsi_full_instruction *inst, unsigned chan,
+             enum sse_cc cc, boolean swap)
+{
+   struct x86_function *func = ctx->func;
+   unsigned a = swap ? XMM_TMP0 : xmm;
+   unsigned b = swap ? xmm : XMM_TMP0;
+
+   emit_fetch(ctx, xmm, &inst->Src[0], chan);
+   emit_fetch(ctx, XMM_TMP0, &inst->Src[1], chan);
+   sse_cmpps(func, make_xmm(a), make_xmm(b), cc);
+   sse_andps(func, make_xmm(a), GET_CONST(ctx, ONE));
+   if (a != xmm)
+      sse_movaps(func, make_xmm(xmm), make_xmm(a));
+}
+
+/**
+ * Compute one channel of a component-wise instruction into XMM<chan>.
+ */
+static void
+emit_vector_chan(struct gen_context *ctx,
+                 const struct tgsi_full_instruction *inst, unsigned chan)
+{
+   struct x86_function *func = ctx->func;
+   struct x86_reg dst = make_xmm(chan);
+   struct x86_reg tmp0 = make_xmm(XMM_TMP0);
+   struct x86_reg tmp1 = make_xmm(XMM_TMP1);
+
+   switch (inst->Instruction.Opcode) {
+   case TGSI_OPCODE_MOV:
+      emit_fetch(ctx, chan, &inst->Src[0], chan);
+      break;
+
+   case TGSI_OPCODE_ADD:
+   case TGSI_OPCODE_MUL:
+   case TGSI_OPCODE_MIN:
+   case TGSI_OPCODE_MAX:
+      emit_fetch(ctx, chan, &inst->Src[0], chan);
+      emit_fetch(ctx, XMM_TMP0, &inst->Src[1], chan);
+      switch (inst->Instruction.Opcode) {
+      case TGSI_OPCODE_ADD:
+         sse_addps(func, dst, tmp0);
+         break;
+      case TGSI_OPCODE_MUL:
+         sse_mulps(func, dst, tmp0);
+         break;
+      case TGSI_OPCODE_MIN:
+         /* minps/maxps return the second operand when unordered, which is
+          * what the "a < b ? a : b" of the interpreter does too.
+          */
+         sse_minps(func, dst, tmp0);
+         break;
+      default:
+         sse_maxps(func, dst, tmp0);
+         break;
+      }
+      break;
+
+   case TGSI_OPCODE_MAD:
+      emit_fetch(ctx, chan, &inst->Src[0], chan);
+      emit_fetch(ctx, XMM_TMP0, &inst->Src[1], chan);
+      sse_mulps(func, dst, tmp0);
+      emit_fetch(ctx, XMM_TMP0, &inst->Src[2], chan);
+      sse_addps(func, dst, tmp0);
+      break;
+
+   case TGSI_OPCODE_LRP:
+      /* src0 * (src1 - src2) + src2 */
+      emit_fetch(ctx, chan, &inst->Src[1], chan);
+      emit_fetch(ctx, XMM_TMP0, &inst->Src[2], chan);
+      sse_subps(func, dst, tmp0);
+      emit_fetch(ctx, XMM_TMP1, &inst->Src[0], chan);
+      sse_mulps(func, dst, tmp1);
+      sse_addps(func, dst, tmp0);
+      break;
+
+   case TGSI_OPCODE_SLT:
+      emit_compare(ctx, chan, inst, chan, cc_LessThan, FALSE);
+      break;
+
+   case TGSI_OPCODE_SGE:
+      /* a >= b as b <= a, so that NaN compares false */
+      emit_compare(ctx, chan, inst, chan, cc_LessThanEqual, TRUE);
+      break;
+
+   case TGSI_OPCODE_SEQ:
+      emit_compare(ctx, chan, inst, chan, cc_Equal, FALSE);
+      break;
+
+   case TGSI_OPCODE_SNE:
+      emit_compare(ctx, chan, inst, chan, cc_NotEqual, FALSE);
+      break;
+
+   default:
+      assert(0);
+   }
+}
+
+/**
+ * Compute the replicated result of a scalar instruction into XMM0.
+ */
+static void
+emit_scalar(struct gen_context *ctx, const struct tgsi_full_instruction *inst)
+{
+   struct x86_function *func = ctx->func;
+   struct x86_reg dst = make_xmm(0);
+   struct x86_reg tmp0 = make_xmm(XMM_TMP0);
+   struct x86_reg tmp1 = make_xmm(XMM_TMP1);
+   unsigned num_chans, chan;
+
+   switch (inst->Instruction.Opcode) {
+   case TGSI_OPCODE_RCP:
+      emit_fetch(ctx, XMM_TMP0, &inst->Src[0], TGSI_CHAN_X);
+      sse_movaps(func, dst, GET_CONST(ctx, ONE));
+      sse_divps(func, dst, tmp0);
+      break;
+
+   case TGSI_OPCODE_RSQ:
+      /* Not rsqrtps, its precision is way too low. */
+      emit_fetch(ctx, XMM_TMP0, &inst->Src[0], TGSI_CHAN_X);
+      sse_sqrtps(func, tmp0, tmp0);
+      sse_movaps(func, dst, GET_CONST(ctx, ONE));
+      sse_divps(func, dst, tmp0);
+      break;
+
+   case TGSI_OPCODE_SQRT:
+      emit_fetch(ctx, 0, &inst->Src[0], TGSI_CHAN_X);
+      sse_sqrtps(func, dst, dst);
+      break;
+
+   case TGSI_OPCODE_DP2:
+   case TGSI_OPCODE_DP3:
+   case TGSI_OPCODE_DP4:
+      num_chans = inst->Instruction.Opcode == TGSI_OPCODE_DP2 ? 2 :
+                  inst->Instruction.Opcode == TGSI_OPCODE_DP3 ? 3 : 4;
+
+      emit_fetch(ctx, 0, &inst->Src[0], TGSI_CHAN_X);
+      emit_fetch(ctx, XMM_TMP0, &inst->Src[1], TGSI_CHAN_X);
+      sse_mulps(func, dst, tmp0);
+      for (chan = TGSI_CHAN_Y; chan < num_chans; chan++) {
+         emit_fetch(ctx, XMM_TMP0, &inst->Src[0], chan);
+         emit_fetch(ctx, XMM_TMP1, &inst->Src[1], chan);
+         sse_mulps(func, tmp0, tmp1);
+         sse_addps(func, dst, tmp0);
+      }
+      break;
+
+   default:
+      assert(0);
+   }
+}
+
+static void
+emit_instruction(struct gen_context *ctx,
+                 const struct tgsi_full_instruction *inst)
+{
+   const unsigned writemask = inst->Dst[0].Register.WriteMask;
+   unsigned chan;
+
+   switch (inst->Instruction.Opcode) {
+   case TGSI_OPCODE_END:
+      break;
+
+   case TGSI_OPCODE_RCP:
+   case TGSI_OPCODE_RSQ:
+   case TGSI_OPCODE_SQRT:
+   case TGSI_OPCODE_DP2:
+   case TGSI_OPCODE_DP3:
+   case TGSI_OPCODE_DP4:
+      emit_scalar(ctx, inst);
+      for (chan = 0; chan < TGSI_NUM_CHANNELS; chan++) {
+         if (writemask & (1 << chan))
+            emit_store(ctx, 0, inst, chan);
+      }
+      break;
+
+   default:
+      /* Compute all channels before storing any, the destination may be
+       * one of the sources.
+       */
+      for (chan = 0; chan < TGSI_NUM_CHANNELS; chan++) {
+         if (writemask & (1 << chan))
+            emit_vector_chan(ctx, inst, chan);
+      }
+      for (chan = 0; chan < TGSI_NUM_CHANNELS; chan++) {
+         if (writemask & (1 << chan))
+            emit_store(ctx, chan, inst, chan);
+      }
+      break;
+   }
+}
+
+
+static boolean
+src_supported(const struct tgsi_full_src_register *reg)
+{
+   if (reg->Register.Indirect)
+      return FALSE;
+
+   switch (reg->Register.File) {
+   case TGSI_FILE_CONSTANT:
+      /* CONST[0][n] is fine, other buffers are not */
+      return !reg->Register.Dimension ||
+             (!reg->Dimension.Indirect && reg->Dimension.Index == 0);
+   case TGSI_FILE_TEMPORARY:
+      return !reg->Register.Dimension &&
+             reg->Register.Index < TGSI_EXEC_NUM_TEMPS;
+   case TGSI_FILE_IMMEDIATE:
+   case TGSI_FILE_INPUT:
+   case TGSI_FILE_OUTPUT:
+      return !reg->Register.Dimension;
+   default:
+      return FALSE;
+   }
+}
+
+static boolean
+instruction_supported(const struct tgsi_full_instruction *inst)
+{
+   unsigned i;
+
+   switch (inst->Instruction.Opcode) {
+   case TGSI_OPCODE_END:
+      return TRUE;
+
+   case TGSI_OPCODE_MOV:
+      /* The interpreter moves raw bits, so modifiers would be integer
+       * abs/negate.
+       */
+      if (inst->Src[0].Register.Absolute || inst->Src[0].Register.Negate)
+         return FALSE;
+      break;
+
+   case TGSI_OPCODE_ADD:
+   case TGSI_OPCODE_MUL:
+   case TGSI_OPCODE_MAD:
+   case TGSI_OPCODE_MIN:
+   case TGSI_OPCODE_MAX:
+   case TGSI_OPCODE_LRP:
+   case TGSI_OPCODE_SLT:
+   case TGSI_OPCODE_SGE:
+   case TGSI_OPCODE_SEQ:
+   case TGSI_OPCODE_SNE:
+   case TGSI_OPCODE_RCP:
+   case TGSI_OPCODE_RSQ:
+   case TGSI_OPCODE_SQRT:
+   case TGSI_OPCODE_DP2:
+   case TGSI_OPCODE_DP3:
+   case TGSI_OPCODE_DP4:
+      break;
+
+   default:
+      return FALSE;
+   }
+
+   if (inst->Instruction.NumDstRegs != 1)
+      return FALSE;
+
+   if (inst->Dst[0].Register.Indirect ||
+       inst->Dst[0].Register.Dimension)
+      return FALSE;
+
+   switch (inst->Dst[0].Register.File) {
+   case TGSI_FILE_TEMPORARY:
+      if (inst->Dst[0].Register.Index >= TGSI_EXEC_NUM_TEMPS)
+         return FALSE;
+      break;
+   case TGSI_FILE_OUTPUT:
+      break;
+   default:
+      return FALSE;
+   }
+
+   for (i = 0; i < inst->Instruction.NumSrcRegs; i++) {
+      if (!src_supported(&inst->Src[i]))
+         return FALSE;
+   }
+
+   return TRUE;
+}
+
+
+struct tgsi_sse2_shader *
+tgsi_sse2_create(const struct tgsi_exec_machine *mach)
+{
+   struct tgsi_sse2_shader *shader;
+   struct gen_context ctx;
+   unsigned i;
+
+   if (mach->ShaderType != PIPE_SHADER_VERTEX &&
+       mach->ShaderType != PIPE_SHADER_FRAGMENT)
+      return NULL;
+
+   if (!rtasm_cpu_has_sse2())
+      return NULL;
+
+   for (i = 0; i < mach->NumInstructions; i++) {
+      if (!instruction_supported(&mach->Instructions[i]))
+         return NULL;
+   }
+
+   shader = CALLOC_STRUCT(tgsi_sse2_shader);
+   if (!shader)
+      return NULL;
+
+   ctx.func = &shader->func;
+   ctx.machine = x86_make_reg(file_REG32, reg_AX);
+   ctx.inputs = x86_make_reg(file_REG32, reg_CX);
+   ctx.outputs = x86_make_reg(file_REG32, reg_DX);
+   ctx.consts = x86_make_reg(file_REG32, reg_BX);
+   ctx.max_const = -1;
+
+   x86_init_func(ctx.func);
+
+   x86_push(ctx.func, ctx.consts);
+
+   /* Read the argument first, on Win64 it lives in ECX. */
+   load_ptr(&ctx, ctx.machine, x86_fn_arg(ctx.func, 1));
+   load_ptr(&ctx, ctx.inputs,
+            x86_make_disp(ctx.machine,
+                          offsetof(struct tgsi_exec_machine, Inputs)));
+   load_ptr(&ctx, ctx.outputs,
+            x86_make_disp(ctx.machine,
+                          offsetof(struct tgsi_exec_machine, Outputs)));
+   load_ptr(&ctx, ctx.consts,
+            x86_make_disp(ctx.machine,
+                          offsetof(struct tgsi_exec_machine, Consts)));
+
+   for (i = 0; i < mach->NumInstructions; i++)
+      emit_instruction(&ctx, &mach->Instructions[i]);
+
+   x86_pop(ctx.func, ctx.consts);
+   x86_ret(ctx.func);
+
+   shader->max_const = ctx.max_const;
+   shader->run = (tgsi_sse2_func) x86_get_func(ctx.func);
+   if (!shader->run) {
+      tgsi_sse2_destroy(shader);
+      return NULL;
+   }
+
+   return shader;
+}
+
+
+/**
+ * Run the compiled shader.  Returns FALSE, without touching the machine,
+ * if the interpreter has to be used instead.
+ */
+boolean
+tgsi_sse2_run(const struct tgsi_sse2_shader *shader,
+              struct tgsi_exec_machine *mach)
+{
+   /* Out of bounds constants read as zero in the interpreter, leave those
+    * cases to it rather than checking every access.
+    */
+   if (shader->max_const >= 0 &&
+       (!mach->Consts[0] ||
+        shader->max_const * 4 + 3 >= (int) mach->ConstsSize[0]))
+      return FALSE;
+
+   shader->run(mach);
+   return TRUE;
+}
+
+
+void
+tgsi_sse2_destroy(struct tgsi_sse2_shader *shader)
+{
+   if (shader) {
+      x86_release_func(&shader->func);
+      FREE(shader);
+   }
+}
+
+
+#else
+
+struct tgsi_sse2_shader *
+tgsi_sse2_create(const struct tgsi_exec_machine *mach)
+{
+   return NULL;
+}
+
+boolean
+tgsi_sse2_run(const struct tgsi_sse2_shader *shader,
+              struct tgsi_exec_machine *mach)
+{
+   return FALSE;
+}
+
+void
+tgsi_sse2_destroy(struct tgsi_sse2_shader *shader)
+{
+}
+
+#endif
@@ -64,7 +64,7 @@ struct translate_buffer_variant
 
 #define ELEMENT_BUFFER_INSTANCE_ID  1001
 
-#define NUM_CONSTS 7
+#define NUM_CONSTS 11
 
 enum
 {
@@ -74,7 +74,11 @@ enum
    CONST_INV_32767,
    CONST_INV_65535,
    CONST_INV_2147483647,
-   CONST_255
+   CONST_255,
+   CONST_SIGN_MASK,
+   CONST_HALF_MAGIC,
+   CONST_65536,
+   CONST_EXP_MASK
 };
 
 #define C(v) {(float)(v), (float)(v), (float)(v), (float)(v)}
@@ -85,7 +89,11 @@ static float consts[NUM_CONSTS][4] = {
    C(1.0 / 32767.0),
    C(1.0 / 65535.0),
    C(1.0 / 2147483647.0),
-   C(255.0)
+   C(255.0),
+   C(-0.0),
+   C(5192296858534827628530496329220096.0), /* 2^(127 - 15) */
+   C(65536.0),
+   C(0) /* filled with the +inf bit pattern at creation */
 };
 
 #undef C
@@ -222,6 +230,33 @@ emit_load_sse2(struct translate_sse *p,
 }
 
 
+/* Convert the half floats in the low word of each dword of data to
+ * floats, using tmp as a scratch register.
+ *
+ * Shifting the exponent and mantissa in place and scaling by 2^112
+ * rebiases the exponent, which also handles denormals (unless the cpu
+ * flushes float denormals to zero). Inf and NaN end up >= 65536 and get
+ * their exponent saturated.
+ */
+static void
+emit_half_to_float(struct translate_sse *p,
+                   struct x86_reg data, struct x86_reg tmp)
+{
+   sse_movaps(p->func, tmp, data);
+   sse2_pslld_imm(p->func, tmp, 17);
+   sse2_psrld_imm(p->func, tmp, 4);
+   sse_mulps(p->func, tmp, get_const(p, CONST_HALF_MAGIC));
+
+   sse2_pslld_imm(p->func, data, 16);
+   sse_andps(p->func, data, get_const(p, CONST_SIGN_MASK));
+   sse_orps(p->func, data, tmp);
+
+   sse_cmpps(p->func, tmp, get_const(p, CONST_65536), cc_NotLessThan);
+   sse_andps(p->func, tmp, get_const(p, CONST_EXP_MASK));
+   sse_orps(p->func, data, tmp);
+}
+
+
 /* this value can be passed for the out_chans argument */
 #define CHANNELS_0001 5
 
@@ -455,6 +490,21 @@ emit_memcpy(struct translate_sse *p, struct x86_reg dst, struct x86_reg src,
    }
 }
 
+/**
+ * Compare two channels ignoring their shift, which differs for every
+ * channel of a multi-channel format.
+ */
+static boolean
+same_channel_type(const struct util_format_channel_description *a,
+                  const struct util_format_channel_description *b)
+{
+   return a->type == b->type &&
+          a->normalized == b->normalized &&
+          a->pure_integer == b->pure_integer &&
+          a->size == b->size;
+}
+
+
 static boolean
 translate_attr_convert(struct translate_sse *p,
                        const struct translate_element *a,
@@ -483,18 +533,14 @@ translate_attr_convert(struct translate_sse *p,
       return FALSE;
 
    for (i = 1; i < input_desc->nr_channels; ++i) {
-      if (memcmp
-          (&input_desc->channel[i], &input_desc->channel[0],
-           sizeof(input_desc->channel[0])))
+      if (!same_channel_type(&input_desc->channel[i], &input_desc->channel[0]))
          return FALSE;
    }
 
    for (i = 1; i < output_desc->nr_channels; ++i) {
-      if (memcmp
-          (&output_desc->channel[i], &output_desc->channel[0],
-           sizeof(output_desc->channel[0]))) {
+      if (!same_channel_type(&output_desc->channel[i],
+                             &output_desc->channel[0]))
          return FALSE;
-      }
    }
 
    for (i = 0; i < output_desc->nr_channels; ++i) {
@@ -626,6 +672,16 @@ translate_attr_convert(struct translate_sse *p,
 
             break;
          case UTIL_FORMAT_TYPE_FLOAT:
+            if (input_desc->channel[0].size == 16) {
+               if (!(x86_target_caps(p->func) & X86_SSE2))
+                  return FALSE;
+               emit_load_sse2(p, dataXMM, src,
+                              input_desc->channel[0].size *
+                              input_desc->nr_channels >> 3);
+               sse2_punpcklwd(p->func, dataXMM, get_const(p, CONST_IDENTITY));
+               emit_half_to_float(p, dataXMM, x86_make_reg(file_XMM, 1));
+               break;
+            }
             if (input_desc->channel[0].size != 32
                 && input_desc->channel[0].size != 64) {
                return FALSE;
@@ -1491,6 +1547,8 @@ translate_sse2_create(const struct translate_key *key)
 
    memset(p, 0, sizeof(*p));
    memcpy(p->consts, consts, sizeof(consts));
+   for (i = 0; i < 4; i++)
+      p->consts[CONST_EXP_MASK][i] = uif(0x7f800000);
 
    p->translate.key = *key;
    p->translate.release = translate_sse_release;
@@ -57,6 +57,14 @@
 #define NUM_RESOLVE_FRAG_SHADERS 5 /* MSAA 2x, 4x, 8x, 16x, 32x */
 #define GET_MSAA_RESOLVE_FS_IDX(nr_samples) (util_logbase2(nr_samples)-1)
 
+enum {
+   BLITTER_TOUCHED_GS          = 1 << 0,
+   BLITTER_TOUCHED_TESS        = 1 << 1,
+   BLITTER_TOUCHED_SO          = 1 << 2,
+   BLITTER_TOUCHED_STENCIL_REF = 1 << 3,
+   BLITTER_TOUCHED_ALL         = (1 << 4) - 1,
+};
+
 struct blitter_context_priv
 {
    struct blitter_context base;
@@ -142,6 +150,11 @@ struct blitter_context_priv
    bool cube_as_2darray;
    bool cached_all_shaders;
 
+   /* Optional states changed by the current operation (BLITTER_TOUCHED_x).
+    * Only these are rebound on restore, so that a blit doesn't dirty
+    * stages the application wasn't using in the first place. */
+   unsigned touched;
+
    /* The Draw module overrides these functions.
     * Always create the blitter before Draw. */
    void   (*bind_fs_state)(struct pipe_context *, void *);
@@ -589,25 +602,30 @@ void util_blitter_restore_vertex_states(struct blitter_context *blitter)
 
    /* Geometry shader. */
    if (ctx->has_geometry_shader) {
-      pipe->bind_gs_state(pipe, ctx->base.saved_gs);
+      if (ctx->touched & BLITTER_TOUCHED_GS)
+         pipe->bind_gs_state(pipe, ctx->base.saved_gs);
       ctx->base.saved_gs = INVALID_PTR;
    }
 
    if (ctx->has_tessellation) {
-      pipe->bind_tcs_state(pipe, ctx->base.saved_tcs);
-      pipe->bind_tes_state(pipe, ctx->base.saved_tes);
+      if (ctx->touched & BLITTER_TOUCHED_TESS) {
+         pipe->bind_tcs_state(pipe, ctx->base.saved_tcs);
+         pipe->bind_tes_state(pipe, ctx->base.saved_tes);
+      }
       ctx->base.saved_tcs = INVALID_PTR;
       ctx->base.saved_tes = INVALID_PTR;
    }
 
    /* Stream outputs. */
    if (ctx->has_stream_out) {
-      unsigned offsets[PIPE_MAX_SO_BUFFERS];
-      for (i = 0; i < ctx->base.saved_num_so_targets; i++)
-         offsets[i] = (unsigned)-1;
-      pipe->set_stream_output_targets(pipe,
-                                      ctx->base.saved_num_so_targets,
-                                      ctx->base.saved_so_targets, offsets);
+      if (ctx->touched & BLITTER_TOUCHED_SO) {
+         unsigned offsets[PIPE_MAX_SO_BUFFERS];
+         for (i = 0; i < ctx->base.saved_num_so_targets; i++)
+            offsets[i] = (unsigned)-1;
+         pipe->set_stream_output_targets(pipe,
+                                         ctx->base.saved_num_so_targets,
+                                         ctx->base.saved_so_targets, offsets);
+      }
 
       for (i = 0; i < ctx->base.saved_num_so_targets; i++)
          pipe_so_target_reference(&ctx->base.saved_so_targets[i], NULL);
@@ -618,6 +636,9 @@ void util_blitter_restore_vertex_states(struct blitter_context *blitter)
    /* Rasterizer. */
    pipe->bind_rasterizer_state(pipe, ctx->base.saved_rs_state);
    ctx->base.saved_rs_state = INVALID_PTR;
+
+   ctx->touched &= ~(BLITTER_TOUCHED_GS | BLITTER_TOUCHED_TESS |
+                     BLITTER_TOUCHED_SO);
 }
 
 static void blitter_check_saved_fragment_states(MAYBE_UNUSED struct blitter_context_priv *ctx)
@@ -651,14 +672,54 @@ void util_blitter_restore_fragment_states(struct blitter_context *blitter)
    }
 
    /* Miscellaneous states. */
-   /* XXX check whether these are saved and whether they need to be restored
-    * (depending on the operation) */
-   pipe->set_stencil_ref(pipe, &ctx->base.saved_stencil_ref);
+   if (ctx->touched & BLITTER_TOUCHED_STENCIL_REF) {
+      pipe->set_stencil_ref(pipe, &ctx->base.saved_stencil_ref);
+      ctx->touched &= ~BLITTER_TOUCHED_STENCIL_REF;
+   }
 
    if (!blitter->skip_viewport_restore)
       pipe->set_viewport_states(pipe, 0, 1, &ctx->base.saved_viewport);
 }
 
+/* Disable the GS and tessellation stages, skipping the ones that aren't
+ * bound anyway. */
+static void blitter_disable_optional_stages(struct blitter_context_priv *ctx)
+{
+   struct pipe_context *pipe = ctx->base.pipe;
+
+   if (ctx->has_geometry_shader && ctx->base.saved_gs) {
+      pipe->bind_gs_state(pipe, NULL);
+      ctx->touched |= BLITTER_TOUCHED_GS;
+   }
+   if (ctx->has_tessellation &&
+       (ctx->base.saved_tcs || ctx->base.saved_tes)) {
+      pipe->bind_tcs_state(pipe, NULL);
+      pipe->bind_tes_state(pipe, NULL);
+      ctx->touched |= BLITTER_TOUCHED_TESS;
+   }
+}
+
+static void blitter_set_stream_output_targets(struct blitter_context_priv *ctx,
+                                              unsigned num_targets,
+                                              struct pipe_stream_output_target **targets,
+                                              const unsigned *offsets)
+{
+   struct pipe_context *pipe = ctx->base.pipe;
+
+   if (!num_targets && !ctx->base.saved_num_so_targets)
+      return;
+
+   pipe->set_stream_output_targets(pipe, num_targets, targets, offsets);
+   ctx->touched |= BLITTER_TOUCHED_SO;
+}
+
+static void blitter_set_stencil_ref(struct blitter_context_priv *ctx,
+                                    const struct pipe_stencil_ref *sr)
+{
+   ctx->base.pipe->set_stencil_ref(ctx->base.pipe, sr);
+   ctx->touched |= BLITTER_TOUCHED_STENCIL_REF;
+}
+
 static void blitter_check_saved_fb_state(MAYBE_UNUSED struct blitter_context_priv *ctx)
 {
    assert(ctx->base.saved_fb_state.nr_cbufs != (ubyte) ~0);
@@ -1226,14 +1287,9 @@ static void blitter_set_common_draw_rect_state(struct blitter_context_priv *ctx,
 
    pipe->bind_rasterizer_state(pipe, scissor ? ctx->rs_state_scissor
                                              : ctx->rs_state);
-   if (ctx->has_geometry_shader)
-      pipe->bind_gs_state(pipe, NULL);
-   if (ctx->has_tessellation) {
-      pipe->bind_tcs_state(pipe, NULL);
-      pipe->bind_tes_state(pipe, NULL);
-   }
+   blitter_disable_optional_stages(ctx);
    if (ctx->has_stream_out)
-      pipe->set_stream_output_targets(pipe, 0, NULL, NULL);
+      blitter_set_stream_output_targets(ctx, 0, NULL, NULL);
 }
 
 static void blitter_draw(struct blitter_context_priv *ctx,
@@ -1343,10 +1399,10 @@ static void *get_clear_blend_state(struct blitter_context_priv *ctx,
    return ctx->blend_clear[index];
 }
 
-void util_blitter_common_clear_setup(struct blitter_context *blitter,
-                                     unsigned width, unsigned height,
-                                     unsigned clear_buffers,
-                                     void *custom_blend, void *custom_dsa)
+static void blitter_common_clear_setup(struct blitter_context *blitter,
+                                       unsigned width, unsigned height,
+                                       unsigned clear_buffers,
+                                       void *custom_blend, void *custom_dsa)
 {
    struct blitter_context_priv *ctx = (struct blitter_context_priv*)blitter;
    struct pipe_context *pipe = ctx->base.pipe;
@@ -1379,6 +1435,21 @@ void util_blitter_common_clear_setup(struct blitter_context *blitter,
    blitter_set_dst_dimensions(ctx, width, height);
 }
 
+void util_blitter_common_clear_setup(struct blitter_context *blitter,
+                                     unsigned width, unsigned height,
+                                     unsigned clear_buffers,
+                                     void *custom_blend, void *custom_dsa)
+{
+   struct blitter_context_priv *ctx = (struct blitter_context_priv*)blitter;
+
+   blitter_common_clear_setup(blitter, width, height, clear_buffers,
+                              custom_blend, custom_dsa);
+
+   /* The caller binds the rest of the states itself, so restore all of
+    * them. */
+   ctx->touched |= BLITTER_TOUCHED_ALL;
+}
+
 static void util_blitter_clear_custom(struct blitter_context *blitter,
                                       unsigned width, unsigned height,
                                       unsigned num_layers,
@@ -1388,16 +1459,15 @@ static void util_blitter_clear_custom(struct blitter_context *blitter,
                                       void *custom_blend, void *custom_dsa)
 {
    struct blitter_context_priv *ctx = (struct blitter_context_priv*)blitter;
-   struct pipe_context *pipe = ctx->base.pipe;
    struct pipe_stencil_ref sr = { { 0 } };
 
    assert(ctx->has_layered || num_layers <= 1);
 
-   util_blitter_common_clear_setup(blitter, width, height, clear_buffers,
-                                   custom_blend, custom_dsa);
+   blitter_common_clear_setup(blitter, width, height, clear_buffers,
+                              custom_blend, custom_dsa);
 
    sr.ref_value[0] = stencil & 0xff;
-   pipe->set_stencil_ref(pipe, &sr);
+   blitter_set_stencil_ref(ctx, &sr);
 
    bind_fs_write_all_cbufs(ctx);
 
@@ -2225,7 +2295,7 @@ void util_blitter_clear_depth_stencil(struct blitter_context *blitter,
    if ((clear_flags & PIPE_CLEAR_DEPTHSTENCIL) == PIPE_CLEAR_DEPTHSTENCIL) {
       sr.ref_value[0] = stencil & 0xff;
       pipe->bind_depth_stencil_alpha_state(pipe, ctx->dsa_write_depth_stencil);
-      pipe->set_stencil_ref(pipe, &sr);
+      blitter_set_stencil_ref(ctx, &sr);
    }
    else if (clear_flags & PIPE_CLEAR_DEPTH) {
       pipe->bind_depth_stencil_alpha_state(pipe, ctx->dsa_write_depth_keep_stencil);
@@ -2233,7 +2303,7 @@ void util_blitter_clear_depth_stencil(struct blitter_context *blitter,
    else if (clear_flags & PIPE_CLEAR_STENCIL) {
       sr.ref_value[0] = stencil & 0xff;
       pipe->bind_depth_stencil_alpha_state(pipe, ctx->dsa_keep_depth_write_stencil);
-      pipe->set_stencil_ref(pipe, &sr);
+      blitter_set_stencil_ref(ctx, &sr);
    }
    else
       /* hmm that should be illegal probably, or make it a no-op somewhere */
@@ -2381,16 +2451,11 @@ void util_blitter_copy_buffer(struct blitter_context *blitter,
    pipe->set_vertex_buffers(pipe, ctx->base.vb_slot, 1, &vb);
    pipe->bind_vertex_elements_state(pipe, ctx->velem_state_readbuf[0]);
    bind_vs_pos_only(ctx, 1);
-   if (ctx->has_geometry_shader)
-      pipe->bind_gs_state(pipe, NULL);
-   if (ctx->has_tessellation) {
-      pipe->bind_tcs_state(pipe, NULL);
-      pipe->bind_tes_state(pipe, NULL);
-   }
+   blitter_disable_optional_stages(ctx);
    pipe->bind_rasterizer_state(pipe, ctx->rs_discard_state);
 
    so_target = pipe->create_stream_output_target(pipe, dst, dstx, size);
-   pipe->set_stream_output_targets(pipe, 1, &so_target, offsets);
+   blitter_set_stream_output_targets(ctx, 1, &so_target, offsets);
 
    util_draw_arrays(pipe, PIPE_PRIM_POINTS, 0, size / 4);
 
@@ -2448,16 +2513,11 @@ void util_blitter_clear_buffer(struct blitter_context *blitter,
    pipe->bind_vertex_elements_state(pipe,
                                     ctx->velem_state_readbuf[num_channels-1]);
    bind_vs_pos_only(ctx, num_channels);
-   if (ctx->has_geometry_shader)
-      pipe->bind_gs_state(pipe, NULL);
-   if (ctx->has_tessellation) {
-      pipe->bind_tcs_state(pipe, NULL);
-      pipe->bind_tes_state(pipe, NULL);
-   }
+   blitter_disable_optional_stages(ctx);
    pipe->bind_rasterizer_state(pipe, ctx->rs_discard_state);
 
    so_target = pipe->create_stream_output_target(pipe, dst, offset, size);
-   pipe->set_stream_output_targets(pipe, 1, &so_target, offsets);
+   blitter_set_stream_output_targets(ctx, 1, &so_target, offsets);
 
    util_draw_arrays(pipe, PIPE_PRIM_POINTS, 0, size / 4);
 
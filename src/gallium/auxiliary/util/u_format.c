@@ -37,6 +37,7 @@
 #include "u_format.h"
 #include "u_format_s3tc.h"
 #include "u_surface.h"
+#include "u_sse.h"
 
 #include "pipe/p_defines.h"
 
@@ -587,6 +588,164 @@ util_format_fits_8unorm(const struct util_format_description *format_desc)
 }
 
 
+/**
+ * A conversion between two 4 x 8bit unorm array formats whose channels are
+ * a permutation of each other (e.g. RGBA8 <-> BGRA8, A <-> X), expressed
+ * on little-endian 32bit pixels as a few shift-and-mask terms.
+ */
+struct util_format_swizzle_4x8
+{
+   unsigned num_terms;
+   int shift[4];        /**< left shift in bits, negative for right shifts */
+   uint32_t mask[4];
+   uint32_t fill;       /**< constant bytes, for 0/1 swizzles and padding */
+};
+
+static boolean
+util_format_get_swizzle_4x8(const struct util_format_description *dst_desc,
+                            const struct util_format_description *src_desc,
+                            struct util_format_swizzle_4x8 *swz)
+{
+#ifdef PIPE_ARCH_LITTLE_ENDIAN
+   uint32_t masks[7] = { 0 };
+   unsigned i, j;
+
+   if (src_desc->layout != UTIL_FORMAT_LAYOUT_PLAIN ||
+       dst_desc->layout != UTIL_FORMAT_LAYOUT_PLAIN ||
+       !src_desc->is_array || !dst_desc->is_array ||
+       src_desc->block.bits != 32 || dst_desc->block.bits != 32 ||
+       src_desc->colorspace != dst_desc->colorspace ||
+       src_desc->colorspace == UTIL_FORMAT_COLORSPACE_ZS) {
+      return FALSE;
+   }
+
+   memset(swz, 0, sizeof *swz);
+
+   for (j = 0; j < 4; j++) {
+      const struct util_format_channel_description *dst_chan =
+         &dst_desc->channel[j];
+      enum pipe_swizzle src_swizzle = PIPE_SWIZZLE_1;
+
+      if (dst_chan->size != 8)
+         return FALSE;
+
+      if (dst_chan->type != UTIL_FORMAT_TYPE_VOID) {
+         if (dst_chan->type != UTIL_FORMAT_TYPE_UNSIGNED ||
+             !dst_chan->normalized)
+            return FALSE;
+
+         for (i = 0; i < 4; i++) {
+            if (dst_desc->swizzle[i] == j)
+               break;
+         }
+         if (i == 4)
+            return FALSE;
+         src_swizzle = src_desc->swizzle[i];
+      }
+
+      if (src_swizzle < 4) {
+         const struct util_format_channel_description *src_chan =
+            &src_desc->channel[src_swizzle];
+
+         if (src_chan->size != 8 ||
+             src_chan->type != UTIL_FORMAT_TYPE_UNSIGNED ||
+             !src_chan->normalized)
+            return FALSE;
+
+         masks[j - src_swizzle + 3] |= 0xffu << (j * 8);
+      } else if (src_swizzle == PIPE_SWIZZLE_1) {
+         swz->fill |= 0xffu << (j * 8);
+      } else if (src_swizzle != PIPE_SWIZZLE_0) {
+         return FALSE;
+      }
+   }
+
+   for (i = 0; i < ARRAY_SIZE(masks); i++) {
+      if (masks[i]) {
+         swz->shift[swz->num_terms] = ((int)i - 3) * 8;
+         swz->mask[swz->num_terms] = masks[i];
+         swz->num_terms++;
+      }
+   }
+
+   return TRUE;
+#else
+   return FALSE;
+#endif
+}
+
+static inline uint32_t
+util_format_swizzle_4x8_pixel(const struct util_format_swizzle_4x8 *swz,
+                              uint32_t pixel)
+{
+   uint32_t value = swz->fill;
+   unsigned i;
+
+   for (i = 0; i < swz->num_terms; i++) {
+      const int shift = swz->shift[i];
+
+      value |= (shift >= 0 ? pixel << shift : pixel >> -shift) & swz->mask[i];
+   }
+
+   return value;
+}
+
+static void
+util_format_swizzle_4x8_rect(const struct util_format_swizzle_4x8 *swz,
+                             uint8_t *dst_row, unsigned dst_stride,
+                             const uint8_t *src_row, unsigned src_stride,
+                             unsigned width, unsigned height)
+{
+#if defined(PIPE_ARCH_SSE)
+   __m128i left[4], right[4], mask[4];
+   const __m128i fill = _mm_set1_epi32(swz->fill);
+   unsigned i;
+
+   for (i = 0; i < swz->num_terms; i++) {
+      left[i] = _mm_cvtsi32_si128(MAX2(swz->shift[i], 0));
+      right[i] = _mm_cvtsi32_si128(MAX2(-swz->shift[i], 0));
+      mask[i] = _mm_set1_epi32(swz->mask[i]);
+   }
+#endif
+
+   while (height--) {
+      const uint8_t *src = src_row;
+      uint8_t *dst = dst_row;
+      unsigned x = 0;
+
+#if defined(PIPE_ARCH_SSE)
+      for (; x + 4 <= width; x += 4) {
+         const __m128i pixels = _mm_loadu_si128((const __m128i *)src);
+         __m128i value = fill;
+
+         for (i = 0; i < swz->num_terms; i++) {
+            __m128i term = _mm_srl_epi32(_mm_sll_epi32(pixels, left[i]),
+                                         right[i]);
+            value = _mm_or_si128(value, _mm_and_si128(term, mask[i]));
+         }
+
+         _mm_storeu_si128((__m128i *)dst, value);
+         src += 16;
+         dst += 16;
+      }
+#endif
+
+      for (; x < width; x++) {
+         uint32_t pixel;
+
+         memcpy(&pixel, src, 4);
+         pixel = util_format_swizzle_4x8_pixel(swz, pixel);
+         memcpy(dst, &pixel, 4);
+         src += 4;
+         dst += 4;
+      }
+
+      dst_row += dst_stride;
+      src_row += src_stride;
+   }
+}
+
+
 boolean
 util_format_translate(enum pipe_format dst_format,
                       void *dst, unsigned dst_stride,
@@ -603,6 +762,7 @@ util_format_translate(enum pipe_format dst_format,
    unsigned x_step, y_step;
    unsigned dst_step;
    unsigned src_step;
+   struct util_format_swizzle_4x8 swz;
 
    dst_format_desc = util_format_description(dst_format);
    src_format_desc = util_format_description(src_format);
@@ -618,6 +778,20 @@ util_format_translate(enum pipe_format dst_format,
       return TRUE;
    }
 
+   if (util_format_get_swizzle_4x8(dst_format_desc, src_format_desc, &swz)) {
+      /*
+       * Channel reordering of 8bit unorm formats, e.g. BGRA8 -> RGBA8.
+       */
+
+      util_format_swizzle_4x8_rect(&swz,
+                                   (uint8_t *)dst + dst_y * dst_stride +
+                                   dst_x * 4, dst_stride,
+                                   (const uint8_t *)src + src_y * src_stride +
+                                   src_x * 4, src_stride,
+                                   width, height);
+      return TRUE;
+   }
+
    assert(dst_x % dst_format_desc->block.width == 0);
    assert(dst_y % dst_format_desc->block.height == 0);
    assert(src_x % src_format_desc->block.width == 0);
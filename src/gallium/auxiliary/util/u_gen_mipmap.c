@@ -38,6 +38,78 @@
 #include "util/u_gen_mipmap.h"
 #include "util/u_format.h"
 #include "util/u_inlines.h"
+#include "util/u_math.h"
+#include "util/u_memory.h"
+#include "util/u_sampler.h"
+#include "cso_cache/cso_context.h"
+#include "tgsi/tgsi_ureg.h"
+
+
+/** Workgroup size of the compute shaders, in texels of the first level. */
+#define GEN_MIPMAP_CS_BLOCK_SIZE 8
+
+/** Number of levels one dispatch can produce from an 8x8 workgroup. */
+#define GEN_MIPMAP_CS_MAX_LEVELS 3
+
+struct util_gen_mipmap_compute
+{
+   struct pipe_context *pipe;
+   struct cso_context *cso;
+
+   /** Shaders, indexed by [is_array][num_levels - 1], created on demand. */
+   void *cs[2][GEN_MIPMAP_CS_MAX_LEVELS];
+
+   unsigned max_levels;
+   boolean has_view_target;
+};
+
+
+static void
+init_gen_mipmap_blit(struct pipe_blit_info *blit, struct pipe_resource *pt,
+                     enum pipe_format format, uint filter)
+{
+   memset(blit, 0, sizeof(*blit));
+   blit->src.resource = blit->dst.resource = pt;
+   blit->src.format = blit->dst.format = format;
+   /* don't set the stencil mask, stencil shouldn't be changed */
+   blit->mask = util_format_is_depth_or_stencil(format) ? PIPE_MASK_Z
+                                                        : PIPE_MASK_RGBA;
+   blit->filter = filter;
+}
+
+
+/**
+ * Generate dst_level from the level above it with a single blit.
+ */
+static void
+gen_mipmap_blit_level(struct pipe_context *pipe, struct pipe_blit_info *blit,
+                      uint dst_level, uint first_layer, uint last_layer)
+{
+   struct pipe_resource *pt = blit->dst.resource;
+
+   blit->src.level = dst_level - 1;
+   blit->dst.level = dst_level;
+
+   blit->src.box.width = u_minify(pt->width0, blit->src.level);
+   blit->src.box.height = u_minify(pt->height0, blit->src.level);
+
+   blit->dst.box.width = u_minify(pt->width0, blit->dst.level);
+   blit->dst.box.height = u_minify(pt->height0, blit->dst.level);
+
+   if (pt->target == PIPE_TEXTURE_3D) {
+      /* generate all layers/slices at once */
+      blit->src.box.z = blit->dst.box.z = 0;
+      blit->src.box.depth = util_num_layers(pt, blit->src.level);
+      blit->dst.box.depth = util_num_layers(pt, blit->dst.level);
+   }
+   else {
+      blit->src.box.z = blit->dst.box.z = first_layer;
+      blit->src.box.depth = blit->dst.box.depth =
+         (last_layer + 1 - first_layer);
+   }
+
+   pipe->blit(pipe, blit);
+}
 
 
 /**
@@ -93,36 +165,423 @@ util_gen_mipmap(struct pipe_context *pipe, struct pipe_resource *pt,
    assert(filter == PIPE_TEX_FILTER_LINEAR ||
           filter == PIPE_TEX_FILTER_NEAREST);
 
-   memset(&blit, 0, sizeof(blit));
-   blit.src.resource = blit.dst.resource = pt;
-   blit.src.format = blit.dst.format = format;
-   /* don't set the stencil mask, stencil shouldn't be changed */
-   blit.mask = is_zs ? PIPE_MASK_Z : PIPE_MASK_RGBA;
-   blit.filter = filter;
+   init_gen_mipmap_blit(&blit, pt, format, filter);
+
+   for (dstLevel = base_level + 1; dstLevel <= last_level; dstLevel++)
+      gen_mipmap_blit_level(pipe, &blit, dstLevel, first_layer, last_layer);
+
+   return TRUE;
+}
+
+
+/**
+ * Create a compute shader that generates num_levels levels below the level
+ * bound as sampler view 0, writing level i to image i.
+ *
+ * Each thread of an 8x8 workgroup box-filters a 2x2 footprint of the source
+ * level for the first destination level.  The results are then reduced
+ * further through shared memory, so one dispatch covers an 8x8, 4x4 and 2x2
+ * tile of the three levels without reading them back from the texture.
+ */
+static void *
+create_gen_mipmap_cs(struct pipe_context *pipe, boolean is_array,
+                     unsigned num_levels)
+{
+   enum tgsi_texture_type tgsi_target =
+      is_array ? TGSI_TEXTURE_2D_ARRAY : TGSI_TEXTURE_2D;
+   struct ureg_program *ureg;
+   struct ureg_src tid, bid, sview, shared = ureg_src_undef();
+   struct ureg_src image[GEN_MIPMAP_CS_MAX_LEVELS];
+   struct ureg_dst coord, tmp, addr, color, texel;
+   struct pipe_compute_state state = {0};
+   const struct tgsi_token *tokens;
+   void *cs;
+   unsigned i, j;
+
+   assert(num_levels >= 1 && num_levels <= GEN_MIPMAP_CS_MAX_LEVELS);
+
+   ureg = ureg_create(PIPE_SHADER_COMPUTE);
+   if (!ureg)
+      return NULL;
+
+   ureg_property(ureg, TGSI_PROPERTY_CS_FIXED_BLOCK_WIDTH,
+                 GEN_MIPMAP_CS_BLOCK_SIZE);
+   ureg_property(ureg, TGSI_PROPERTY_CS_FIXED_BLOCK_HEIGHT,
+                 GEN_MIPMAP_CS_BLOCK_SIZE);
+   ureg_property(ureg, TGSI_PROPERTY_CS_FIXED_BLOCK_DEPTH, 1);
+
+   tid = ureg_DECL_system_value(ureg, TGSI_SEMANTIC_THREAD_ID, 0);
+   bid = ureg_DECL_system_value(ureg, TGSI_SEMANTIC_BLOCK_ID, 0);
+   sview = ureg_DECL_sampler_view(ureg, 0, tgsi_target,
+                                  TGSI_RETURN_TYPE_FLOAT,
+                                  TGSI_RETURN_TYPE_FLOAT,
+                                  TGSI_RETURN_TYPE_FLOAT,
+                                  TGSI_RETURN_TYPE_FLOAT);
+
+   /* writeonly images do not require an explicitly given format. */
+   for (i = 0; i < num_levels; i++)
+      image[i] = ureg_DECL_image(ureg, i, tgsi_target, PIPE_FORMAT_NONE,
+                                 true, false);
+
+   if (num_levels > 1)
+      shared = ureg_DECL_memory(ureg, TGSI_MEMORY_TYPE_SHARED);
 
-   for (dstLevel = base_level + 1; dstLevel <= last_level; dstLevel++) {
-      blit.src.level = dstLevel - 1;
-      blit.dst.level = dstLevel;
+   coord = ureg_DECL_temporary(ureg);
+   tmp = ureg_DECL_temporary(ureg);
+   addr = ureg_DECL_temporary(ureg);
+   color = ureg_DECL_temporary(ureg);
+   texel = ureg_DECL_temporary(ureg);
 
-      blit.src.box.width = u_minify(pt->width0, blit.src.level);
-      blit.src.box.height = u_minify(pt->height0, blit.src.level);
+   /* coord.xy = block_id.xy * 8 + thread_id.xy, the first dst texel */
+   ureg_UMAD(ureg, ureg_writemask(coord, TGSI_WRITEMASK_XY), bid,
+             ureg_imm1u(ureg, GEN_MIPMAP_CS_BLOCK_SIZE), tid);
+   /* coord.z = block_id.z (layer), coord.w = 0 (lod) */
+   ureg_MOV(ureg, ureg_writemask(coord, TGSI_WRITEMASK_Z),
+            ureg_scalar(bid, TGSI_SWIZZLE_Z));
+   ureg_MOV(ureg, ureg_writemask(coord, TGSI_WRITEMASK_W),
+            ureg_imm1u(ureg, 0));
 
-      blit.dst.box.width = u_minify(pt->width0, blit.dst.level);
-      blit.dst.box.height = u_minify(pt->height0, blit.dst.level);
+   /* tmp = coord with xy scaled to the source level */
+   ureg_SHL(ureg, ureg_writemask(tmp, TGSI_WRITEMASK_XY), ureg_src(coord),
+            ureg_imm1u(ureg, 1));
+   ureg_MOV(ureg, ureg_writemask(tmp, TGSI_WRITEMASK_ZW), ureg_src(coord));
 
-      if (pt->target == PIPE_TEXTURE_3D) {
-         /* generate all layers/slices at once */
-         blit.src.box.z = blit.dst.box.z = 0;
-         blit.src.box.depth = util_num_layers(pt, blit.src.level);
-         blit.dst.box.depth = util_num_layers(pt, blit.dst.level);
+   /* color = average of the 2x2 source texels */
+   ureg_TXF(ureg, color, tgsi_target, ureg_src(tmp), sview);
+   for (j = 1; j < 4; j++) {
+      ureg_UADD(ureg, ureg_writemask(addr, TGSI_WRITEMASK_XY), ureg_src(tmp),
+                ureg_imm2u(ureg, j & 1, j >> 1));
+      ureg_MOV(ureg, ureg_writemask(addr, TGSI_WRITEMASK_ZW), ureg_src(tmp));
+      ureg_TXF(ureg, texel, tgsi_target, ureg_src(addr), sview);
+      ureg_ADD(ureg, color, ureg_src(color), ureg_src(texel));
+   }
+   ureg_MUL(ureg, color, ureg_src(color), ureg_imm1f(ureg, 0.25f));
+
+   /* store(image[0], coord, color) */
+   {
+      struct ureg_dst out = ureg_dst(image[0]);
+      struct ureg_src op[2] = { ureg_src(coord), ureg_src(color) };
+
+      ureg_memory_insn(ureg, TGSI_OPCODE_STORE, &out, 1, op, 2, 0,
+                       tgsi_target, PIPE_FORMAT_NONE);
+   }
+
+   if (num_levels > 1) {
+      struct ureg_dst out = ureg_dst(shared);
+      struct ureg_src op[2] = { ureg_scalar(ureg_src(addr), TGSI_SWIZZLE_X),
+                                ureg_src(color) };
+
+      /* addr.x = (thread_id.y * 8 + thread_id.x) * 16 */
+      ureg_UMAD(ureg, ureg_writemask(addr, TGSI_WRITEMASK_X),
+                ureg_scalar(tid, TGSI_SWIZZLE_Y),
+                ureg_imm1u(ureg, GEN_MIPMAP_CS_BLOCK_SIZE),
+                ureg_scalar(tid, TGSI_SWIZZLE_X));
+      ureg_SHL(ureg, ureg_writemask(addr, TGSI_WRITEMASK_X),
+               ureg_src(addr), ureg_imm1u(ureg, 4));
+
+      ureg_memory_insn(ureg, TGSI_OPCODE_STORE, &out, 1, op, 2, 0, 0, 0);
+   }
+
+   for (i = 1; i < num_levels; i++) {
+      /* distance to the neighbouring texels of level i - 1, in threads */
+      unsigned step = 1 << (i - 1);
+      unsigned label;
+
+      ureg_insn(ureg, TGSI_OPCODE_BARRIER, NULL, 0, NULL, 0, 0);
+
+      /* Only threads at a multiple of 2^i in both directions own a texel of
+       * level i.  The slots they read were written by threads that are idle
+       * from now on, and the slot they write is only ever read by
+       * themselves, so one barrier per level is enough.
+       */
+      ureg_OR(ureg, ureg_writemask(tmp, TGSI_WRITEMASK_X),
+              ureg_scalar(tid, TGSI_SWIZZLE_X),
+              ureg_scalar(tid, TGSI_SWIZZLE_Y));
+      ureg_AND(ureg, ureg_writemask(tmp, TGSI_WRITEMASK_X),
+               ureg_src(tmp), ureg_imm1u(ureg, (1 << i) - 1));
+      ureg_USEQ(ureg, ureg_writemask(tmp, TGSI_WRITEMASK_X),
+                ureg_src(tmp), ureg_imm1u(ureg, 0));
+      ureg_UIF(ureg, ureg_scalar(ureg_src(tmp), TGSI_SWIZZLE_X), &label);
+      {
+         struct ureg_src op[2];
+         struct ureg_dst out;
+
+         /* color = average of the 2x2 texels of level i - 1 */
+         op[0] = shared;
+         op[1] = ureg_scalar(ureg_src(addr), TGSI_SWIZZLE_X);
+         ureg_memory_insn(ureg, TGSI_OPCODE_LOAD, &color, 1, op, 2, 0, 0, 0);
+         for (j = 1; j < 4; j++) {
+            unsigned offset = ((j >> 1) * GEN_MIPMAP_CS_BLOCK_SIZE +
+                               (j & 1)) * step * 16;
+
+            ureg_UADD(ureg, ureg_writemask(tmp, TGSI_WRITEMASK_Y),
+                      ureg_scalar(ureg_src(addr), TGSI_SWIZZLE_X),
+                      ureg_imm1u(ureg, offset));
+            op[1] = ureg_scalar(ureg_src(tmp), TGSI_SWIZZLE_Y);
+            ureg_memory_insn(ureg, TGSI_OPCODE_LOAD, &texel, 1, op, 2, 0,
+                             0, 0);
+            ureg_ADD(ureg, color, ureg_src(color), ureg_src(texel));
+         }
+         ureg_MUL(ureg, color, ureg_src(color), ureg_imm1f(ureg, 0.25f));
+
+         /* store(image[i], coord >> i, color) */
+         ureg_USHR(ureg, ureg_writemask(tmp, TGSI_WRITEMASK_XY),
+                   ureg_src(coord), ureg_imm1u(ureg, i));
+         ureg_MOV(ureg, ureg_writemask(tmp, TGSI_WRITEMASK_ZW),
+                  ureg_src(coord));
+         out = ureg_dst(image[i]);
+         op[0] = ureg_src(tmp);
+         op[1] = ureg_src(color);
+         ureg_memory_insn(ureg, TGSI_OPCODE_STORE, &out, 1, op, 2, 0,
+                          tgsi_target, PIPE_FORMAT_NONE);
+
+         if (i + 1 < num_levels) {
+            out = ureg_dst(shared);
+            op[0] = ureg_scalar(ureg_src(addr), TGSI_SWIZZLE_X);
+            op[1] = ureg_src(color);
+            ureg_memory_insn(ureg, TGSI_OPCODE_STORE, &out, 1, op, 2, 0,
+                             0, 0);
+         }
       }
-      else {
-         blit.src.box.z = blit.dst.box.z = first_layer;
-         blit.src.box.depth = blit.dst.box.depth =
-            (last_layer + 1 - first_layer);
+      ureg_fixup_label(ureg, label, ureg_get_instruction_number(ureg));
+      ureg_ENDIF(ureg);
+   }
+
+   ureg_END(ureg);
+
+   tokens = ureg_get_tokens(ureg, NULL);
+   ureg_destroy(ureg);
+   if (!tokens)
+      return NULL;
+
+   state.ir_type = PIPE_SHADER_IR_TGSI;
+   state.prog = tokens;
+   if (num_levels > 1)
+      state.req_local_mem = GEN_MIPMAP_CS_BLOCK_SIZE *
+                            GEN_MIPMAP_CS_BLOCK_SIZE * 4 * sizeof(float);
+
+   cs = pipe->create_compute_state(pipe, &state);
+   ureg_free_tokens(tokens);
+   return cs;
+}
+
+
+/**
+ * Create the state needed by util_gen_mipmap_compute().
+ *
+ * Returns NULL if the driver can't run TGSI compute shaders that write
+ * images, in which case callers should just use util_gen_mipmap().
+ */
+struct util_gen_mipmap_compute *
+util_create_gen_mipmap_compute(struct pipe_context *pipe,
+                               struct cso_context *cso)
+{
+   struct pipe_screen *screen = pipe->screen;
+   struct util_gen_mipmap_compute *ctx;
+   int max_images;
+
+   if (!screen->get_param(screen, PIPE_CAP_COMPUTE) ||
+       !(screen->get_shader_param(screen, PIPE_SHADER_COMPUTE,
+                                  PIPE_SHADER_CAP_SUPPORTED_IRS) &
+         (1 << PIPE_SHADER_IR_TGSI)))
+      return NULL;
+
+   max_images = screen->get_shader_param(screen, PIPE_SHADER_COMPUTE,
+                                         PIPE_SHADER_CAP_MAX_SHADER_IMAGES);
+   if (max_images < 1)
+      return NULL;
+
+   ctx = CALLOC_STRUCT(util_gen_mipmap_compute);
+   if (!ctx)
+      return NULL;
+
+   ctx->pipe = pipe;
+   ctx->cso = cso;
+   ctx->max_levels = MIN2(max_images, GEN_MIPMAP_CS_MAX_LEVELS);
+   ctx->has_view_target =
+      screen->get_param(screen, PIPE_CAP_SAMPLER_VIEW_TARGET);
+   return ctx;
+}
+
+
+void
+util_destroy_gen_mipmap_compute(struct util_gen_mipmap_compute *ctx)
+{
+   unsigned i, j;
+
+   for (i = 0; i < ARRAY_SIZE(ctx->cs); i++) {
+      for (j = 0; j < ARRAY_SIZE(ctx->cs[i]); j++) {
+         if (ctx->cs[i][j])
+            cso_delete_compute_shader(ctx->cso, ctx->cs[i][j]);
       }
+   }
+   FREE(ctx);
+}
 
-      pipe->blit(pipe, &blit);
+
+/**
+ * Generate num_levels levels below src_level with one dispatch.
+ */
+static boolean
+gen_mipmap_dispatch(struct util_gen_mipmap_compute *ctx,
+                    struct pipe_resource *pt, enum pipe_format format,
+                    boolean is_array, uint src_level, unsigned num_levels,
+                    uint first_layer, uint last_layer)
+{
+   struct pipe_context *pipe = ctx->pipe;
+   void **cs = &ctx->cs[is_array][num_levels - 1];
+   struct pipe_sampler_view templ, *view;
+   struct pipe_image_view images[GEN_MIPMAP_CS_MAX_LEVELS];
+   struct pipe_grid_info info = {0};
+   unsigned i;
+
+   if (!*cs) {
+      *cs = create_gen_mipmap_cs(pipe, is_array, num_levels);
+      if (!*cs)
+         return FALSE;
+   }
+
+   u_sampler_view_default_template(&templ, pt, format);
+   templ.target = is_array ? PIPE_TEXTURE_2D_ARRAY : PIPE_TEXTURE_2D;
+   templ.u.tex.first_level = templ.u.tex.last_level = src_level;
+   templ.u.tex.first_layer = first_layer;
+   templ.u.tex.last_layer = last_layer;
+   view = pipe->create_sampler_view(pipe, pt, &templ);
+   if (!view)
+      return FALSE;
+
+   memset(images, 0, sizeof(images));
+   for (i = 0; i < num_levels; i++) {
+      images[i].resource = pt;
+      images[i].format = format;
+      images[i].access = PIPE_IMAGE_ACCESS_WRITE;
+      images[i].u.tex.level = src_level + 1 + i;
+      images[i].u.tex.first_layer = first_layer;
+      images[i].u.tex.last_layer = last_layer;
    }
+
+   cso_set_compute_shader_handle(ctx->cso, *cs);
+   pipe->set_sampler_views(pipe, PIPE_SHADER_COMPUTE, 0, 1, &view);
+   pipe->set_shader_images(pipe, PIPE_SHADER_COMPUTE, 0, num_levels, images);
+
+   info.block[0] = info.block[1] = GEN_MIPMAP_CS_BLOCK_SIZE;
+   info.block[2] = 1;
+   info.grid[0] = DIV_ROUND_UP(u_minify(pt->width0, src_level + 1),
+                               GEN_MIPMAP_CS_BLOCK_SIZE);
+   info.grid[1] = DIV_ROUND_UP(u_minify(pt->height0, src_level + 1),
+                               GEN_MIPMAP_CS_BLOCK_SIZE);
+   info.grid[2] = last_layer + 1 - first_layer;
+   pipe->launch_grid(pipe, &info);
+
+   pipe->set_shader_images(pipe, PIPE_SHADER_COMPUTE, 0, num_levels, NULL);
+   pipe_sampler_view_reference(&view, NULL);
+   pipe->set_sampler_views(pipe, PIPE_SHADER_COMPUTE, 0, 1, &view);
+
+   /* The next dispatch or blit samples the levels written here, and so
+    * may whatever the caller does next.
+    */
+   pipe->memory_barrier(pipe, PIPE_BARRIER_TEXTURE | PIPE_BARRIER_IMAGE |
+                              PIPE_BARRIER_FRAMEBUFFER);
+   return TRUE;
+}
+
+
+/**
+ * Generate mipmap images with compute shaders, producing up to three levels
+ * per dispatch for 2D, 2D array and cube (array) textures.
+ *
+ * Levels the compute path can't produce exactly (odd source dimensions) are
+ * generated with a blit as in util_gen_mipmap().  This only handles linear
+ * filtering of color formats that can be written as images, and returns
+ * FALSE without doing anything otherwise.
+ *
+ * The compute shader, sampler view 0 and images of the compute stage are
+ * clobbered; the compute shader is bound through the cso context so that
+ * its cache stays valid, the caller has to rebind the rest.
+ *
+ * The parameters match util_gen_mipmap().
+ */
+boolean
+util_gen_mipmap_compute(struct util_gen_mipmap_compute *ctx,
+                        struct pipe_resource *pt, enum pipe_format format,
+                        uint base_level, uint last_level,
+                        uint first_layer, uint last_layer, uint filter)
+{
+   struct pipe_context *pipe = ctx->pipe;
+   struct pipe_screen *screen = pipe->screen;
+   struct pipe_blit_info blit;
+   boolean is_array;
+   uint level;
+
+   if (filter != PIPE_TEX_FILTER_LINEAR ||
+       pt->nr_samples > 1 ||
+       util_format_is_depth_or_stencil(format) ||
+       util_format_is_pure_integer(format) ||
+       util_format_is_srgb(format) ||
+       util_format_is_compressed(format))
+      return FALSE;
+
+   switch (pt->target) {
+   case PIPE_TEXTURE_2D:
+      is_array = FALSE;
+      break;
+   case PIPE_TEXTURE_2D_ARRAY:
+      is_array = TRUE;
+      break;
+   case PIPE_TEXTURE_CUBE:
+   case PIPE_TEXTURE_CUBE_ARRAY:
+      /* the faces are sampled and written as a 2D array */
+      if (!ctx->has_view_target)
+         return FALSE;
+      is_array = TRUE;
+      break;
+   default:
+      return FALSE;
+   }
+
+   if (!screen->is_format_supported(screen, format, pt->target,
+                                    pt->nr_samples, pt->nr_storage_samples,
+                                    PIPE_BIND_SAMPLER_VIEW |
+                                    PIPE_BIND_SHADER_IMAGE))
+      return FALSE;
+
+   assert(last_level <= pt->last_level);
+   assert(last_level > base_level);
+
+   init_gen_mipmap_blit(&blit, pt, format, filter);
+
+   /* Mipmap generation isn't subject to conditional rendering. */
+   cso_save_state(ctx->cso, CSO_BIT_RENDER_CONDITION);
+   cso_set_render_condition(ctx->cso, NULL, FALSE, 0);
+
+   for (level = base_level; level < last_level;) {
+      unsigned width = u_minify(pt->width0, level);
+      unsigned height = u_minify(pt->height0, level);
+      unsigned num_levels = 0;
+
+      /* A 2x2 box filter only matches the blit when every level of the
+       * dispatch is exactly half the size of the one above it.
+       */
+      while (num_levels < ctx->max_levels &&
+             level + num_levels < last_level &&
+             !(width & 1) && !(height & 1)) {
+         width /= 2;
+         height /= 2;
+         num_levels++;
+      }
+
+      if (!num_levels ||
+          !gen_mipmap_dispatch(ctx, pt, format, is_array, level, num_levels,
+                               first_layer, last_layer)) {
+         gen_mipmap_blit_level(pipe, &blit, level + 1,
+                               first_layer, last_layer);
+         level++;
+         continue;
+      }
+
+      level += num_levels;
+   }
+
+   cso_restore_state(ctx->cso);
    return TRUE;
 }
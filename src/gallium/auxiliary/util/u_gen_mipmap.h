@@ -37,12 +37,27 @@ extern "C" {
 
 
 struct pipe_context;
+struct cso_context;
+struct util_gen_mipmap_compute;
 
 extern boolean
 util_gen_mipmap(struct pipe_context *pipe, struct pipe_resource *pt,
                 enum pipe_format format, uint base_level, uint last_level,
                 uint first_layer, uint last_layer, uint filter);
 
+struct util_gen_mipmap_compute *
+util_create_gen_mipmap_compute(struct pipe_context *pipe,
+                               struct cso_context *cso);
+
+void
+util_destroy_gen_mipmap_compute(struct util_gen_mipmap_compute *ctx);
+
+extern boolean
+util_gen_mipmap_compute(struct util_gen_mipmap_compute *ctx,
+                        struct pipe_resource *pt, enum pipe_format format,
+                        uint base_level, uint last_level,
+                        uint first_layer, uint last_layer, uint filter);
+
 
 #ifdef __cplusplus
 }
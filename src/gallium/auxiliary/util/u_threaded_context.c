@@ -26,10 +26,12 @@
 
 #include "util/u_threaded_context.h"
 #include "util/u_cpu_detect.h"
+#include "util/u_cpu_trace.h"
 #include "util/u_format.h"
 #include "util/u_inlines.h"
 #include "util/u_memory.h"
 #include "util/u_upload_mgr.h"
+#include "tgsi/tgsi_scan.h"
 
 /* 0 = disabled, 1 = assertions, 2 = printfs */
 #define TC_DEBUG 0
@@ -86,6 +88,7 @@ tc_batch_execute(void *job, UNUSED int thread_index)
    struct pipe_context *pipe = batch->pipe;
    struct tc_call *last = &batch->call[batch->num_total_call_slots];
 
+   MESA_TRACE_FUNC();
    tc_batch_check(batch);
 
    assert(!batch->token);
@@ -109,6 +112,8 @@ tc_batch_flush(struct threaded_context *tc)
    tc_batch_check(next);
    tc_debug_check(tc);
    p_atomic_add(&tc->num_offloaded_slots, next->num_total_call_slots);
+   tc->frame_batches++;
+   tc->last_draw = NULL;
 
    if (next->token) {
       next->token->tc = NULL;
@@ -135,7 +140,7 @@ tc_add_sized_call(struct threaded_context *tc, enum tc_call_id id,
 
    tc_debug_check(tc);
 
-   if (unlikely(next->num_total_call_slots + num_call_slots > TC_CALLS_PER_BATCH)) {
+   if (unlikely(next->num_total_call_slots + num_call_slots > tc->batch_calls)) {
       tc_batch_flush(tc);
       next = &tc->batch_slots[tc->next];
       tc_assert(next->num_total_call_slots == 0);
@@ -149,6 +154,7 @@ tc_add_sized_call(struct threaded_context *tc, enum tc_call_id id,
    call->sentinel = TC_SENTINEL;
    call->call_id = id;
    call->num_call_slots = num_call_slots;
+   tc->last_draw = NULL;
 
    tc_debug_check(tc);
    return &call->payload;
@@ -204,6 +210,7 @@ _tc_sync(struct threaded_context *tc, MAYBE_UNUSED const char *info, MAYBE_UNUSE
    /* .. and execute unflushed calls directly. */
    if (next->num_total_call_slots) {
       p_atomic_add(&tc->num_direct_slots, next->num_total_call_slots);
+      tc->last_draw = NULL;
       tc_batch_execute(next, 0);
       synced = true;
    }
@@ -532,11 +539,49 @@ TC_CSO_WHOLE(blend)
 TC_CSO_WHOLE(rasterizer)
 TC_CSO_WHOLE(depth_stencil_alpha)
 TC_CSO_WHOLE(compute)
-TC_CSO_WHOLE2(fs, shader)
-TC_CSO_WHOLE2(vs, shader)
-TC_CSO_WHOLE2(gs, shader)
-TC_CSO_WHOLE2(tcs, shader)
-TC_CSO_WHOLE2(tes, shader)
+
+/* Merged draws look like a single draw to shaders, so they can't be merged
+ * once a shader reads the primitive ID, which restarts for every draw, or
+ * the base vertex, which is the first vertex for non-indexed draws.
+ */
+static void
+tc_check_draw_merging(struct threaded_context *tc,
+                      const struct pipe_shader_state *state)
+{
+   struct tgsi_shader_info info;
+
+   if (tc->no_draw_merging)
+      return;
+
+   if (state->type != PIPE_SHADER_IR_TGSI) {
+      tc->no_draw_merging = true;
+      return;
+   }
+
+   tgsi_scan_shader(state->tokens, &info);
+   if (info.uses_primid || info.uses_basevertex ||
+       info.uses_vertexid_nobase)
+      tc->no_draw_merging = true;
+}
+
+#define TC_CSO_SHADER(name) \
+   static void * \
+   tc_create_##name##_state(struct pipe_context *_pipe, \
+                            const struct pipe_shader_state *state) \
+   { \
+      struct threaded_context *tc = threaded_context(_pipe); \
+      struct pipe_context *pipe = tc->pipe; \
+      tc_check_draw_merging(tc, state); \
+      return pipe->create_##name##_state(pipe, state); \
+   } \
+   TC_CSO_BIND(name) \
+   TC_CSO_DELETE(name)
+
+TC_CSO_SHADER(fs)
+TC_CSO_SHADER(vs)
+TC_CSO_SHADER(gs)
+TC_CSO_SHADER(tcs)
+TC_CSO_SHADER(tes)
 TC_CSO_CREATE(sampler, sampler)
 TC_CSO_DELETE(sampler)
 TC_CSO_BIND(vertex_elements)
@@ -1412,6 +1457,15 @@ tc_improve_map_buffer_flags(struct threaded_context *tc,
       }
    }
 
+   /* Write-only mappings with explicit flushes only modify the flushed
+    * ranges, and those are all that a staging upload copies back, so they
+    * don't need a discard to avoid the synchronization. This must be done
+    * after the whole-resource discard above.
+    */
+   if ((usage & (PIPE_TRANSFER_WRITE | PIPE_TRANSFER_FLUSH_EXPLICIT)) ==
+       (PIPE_TRANSFER_WRITE | PIPE_TRANSFER_FLUSH_EXPLICIT))
+      usage |= PIPE_TRANSFER_DISCARD_RANGE;
+
    /* We won't need this flag anymore. */
    /* TODO: We might not need TC_TRANSFER_MAP_NO_INVALIDATE with this. */
    usage &= ~PIPE_TRANSFER_DISCARD_WHOLE_RESOURCE;
@@ -1938,6 +1992,20 @@ tc_call_flush(struct pipe_context *pipe, union tc_payload *payload)
       tc_flush_queries(p->tc);
 }
 
+/* Adjusts the batch size to the number of batches in the last frame. See
+ * TC_CALLS_PER_BATCH.
+ */
+static void
+tc_end_frame(struct threaded_context *tc)
+{
+   if (tc->frame_batches > TC_MAX_BATCHES)
+      tc->batch_calls = MIN2(tc->batch_calls * 2, TC_CALLS_PER_BATCH);
+   else if (tc->frame_batches < TC_MAX_BATCHES / 4)
+      tc->batch_calls = MAX2(tc->batch_calls / 2, TC_MIN_CALLS_PER_BATCH);
+
+   tc->frame_batches = 0;
+}
+
 static void
 tc_flush(struct pipe_context *_pipe, struct pipe_fence_handle **fence,
          unsigned flags)
@@ -1947,6 +2015,9 @@ tc_flush(struct pipe_context *_pipe, struct pipe_fence_handle **fence,
    struct pipe_screen *screen = pipe->screen;
    bool async = flags & PIPE_FLUSH_DEFERRED;
 
+   if (flags & PIPE_FLUSH_END_OF_FRAME)
+      tc_end_frame(tc);
+
    if (flags & PIPE_FLUSH_ASYNC) {
       struct tc_batch *last = &tc->batch_slots[tc->last];
 
@@ -2028,6 +2099,56 @@ tc_add_draw_vbo(struct pipe_context *_pipe, bool indirect)
                                        sizeof(struct pipe_draw_info));
 }
 
+/* Consecutive draws of independent points, lines or triangles with nothing
+ * in between use the same state, so if they also draw adjacent vertex or
+ * index ranges, the driver can do them as one draw. Index data uploaded for
+ * user indices usually ends up adjacent as well.
+ *
+ * Returns whether the draw was merged into the previous one.
+ */
+static bool
+tc_merge_draw_vbo(struct threaded_context *tc,
+                  const struct pipe_draw_info *info,
+                  struct pipe_resource *index_buffer, unsigned start)
+{
+   struct pipe_draw_info *prev = &tc->last_draw->draw;
+   unsigned verts_per_prim;
+
+   switch (info->mode) {
+   case PIPE_PRIM_POINTS:
+      verts_per_prim = 1;
+      break;
+   case PIPE_PRIM_LINES:
+      verts_per_prim = 2;
+      break;
+   case PIPE_PRIM_TRIANGLES:
+      verts_per_prim = 3;
+      break;
+   default:
+      return false;
+   }
+
+   if (prev->mode != info->mode ||
+       prev->count % verts_per_prim ||
+       prev->start + prev->count != start ||
+       prev->count > UINT_MAX - info->count ||
+       prev->index_size != info->index_size ||
+       (info->index_size && prev->index.resource != index_buffer) ||
+       prev->start_instance != info->start_instance ||
+       prev->instance_count != info->instance_count ||
+       prev->drawid != info->drawid ||
+       prev->index_bias != info->index_bias ||
+       prev->primitive_restart != info->primitive_restart ||
+       (info->primitive_restart &&
+        prev->restart_index != info->restart_index))
+      return false;
+
+   prev->count += info->count;
+   prev->min_index = MIN2(prev->min_index, info->min_index);
+   prev->max_index = MAX2(prev->max_index, info->max_index);
+   return true;
+}
+
 static void
 tc_draw_vbo(struct pipe_context *_pipe, const struct pipe_draw_info *info)
 {
@@ -2035,6 +2156,8 @@ tc_draw_vbo(struct pipe_context *_pipe, const struct pipe_draw_info *info)
    struct pipe_draw_indirect_info *indirect = info->indirect;
    unsigned index_size = info->index_size;
    bool has_user_indices = info->has_user_indices;
+   bool can_merge = !tc->no_draw_merging && !indirect &&
+                    !info->count_from_stream_output;
 
    if (index_size && has_user_indices) {
       unsigned size = info->count * index_size;
@@ -2052,6 +2175,12 @@ tc_draw_vbo(struct pipe_context *_pipe, const struct pipe_draw_info *info)
       if (unlikely(!buffer))
          return;
 
+      if (can_merge && tc->last_draw &&
+          tc_merge_draw_vbo(tc, info, buffer, offset / index_size)) {
+         pipe_resource_reference(&buffer, NULL);
+         return;
+      }
+
       struct tc_full_draw_info *p = tc_add_draw_vbo(_pipe, false);
       p->draw.count_from_stream_output = NULL;
       pipe_so_target_reference(&p->draw.count_from_stream_output,
@@ -2060,8 +2189,15 @@ tc_draw_vbo(struct pipe_context *_pipe, const struct pipe_draw_info *info)
       p->draw.has_user_indices = false;
       p->draw.index.resource = buffer;
       p->draw.start = offset / index_size;
+
+      if (can_merge)
+         tc->last_draw = p;
    } else {
       /* Non-indexed call or indexed with a real index buffer. */
+      if (can_merge && tc->last_draw &&
+          tc_merge_draw_vbo(tc, info, info->index.resource, info->start))
+         return;
+
       struct tc_full_draw_info *p = tc_add_draw_vbo(_pipe, indirect != NULL);
       p->draw.count_from_stream_output = NULL;
       pipe_so_target_reference(&p->draw.count_from_stream_output,
@@ -2079,6 +2215,53 @@ tc_draw_vbo(struct pipe_context *_pipe, const struct pipe_draw_info *info)
          memcpy(&p->indirect, indirect, sizeof(*indirect));
          p->draw.indirect = &p->indirect;
       }
+
+      if (can_merge)
+         tc->last_draw = p;
+   }
+}
+
+/* The number of ranges per multi_draw call, so that it always fits in a
+ * batch.
+ */
+#define TC_MAX_MULTI_DRAWS 128
+
+struct tc_multi_draw {
+   struct pipe_draw_info info;
+   unsigned num_draws;
+   struct pipe_draw_range slot[0]; /* more will be allocated if needed */
+};
+
+static void
+tc_call_multi_draw(struct pipe_context *pipe, union tc_payload *payload)
+{
+   struct tc_multi_draw *p = (struct tc_multi_draw *)payload;
+
+   pipe->multi_draw(pipe, &p->info, p->slot, p->num_draws);
+   if (p->info.index_size)
+      pipe_resource_reference(&p->info.index.resource, NULL);
+}
+
+static void
+tc_multi_draw(struct pipe_context *_pipe, const struct pipe_draw_info *info,
+              const struct pipe_draw_range *draws, unsigned num_draws)
+{
+   struct threaded_context *tc = threaded_context(_pipe);
+
+   for (unsigned i = 0; i < num_draws; i += TC_MAX_MULTI_DRAWS) {
+      unsigned n = MIN2(num_draws - i, TC_MAX_MULTI_DRAWS);
+      struct tc_multi_draw *p =
+         tc_add_slot_based_call(tc, TC_CALL_multi_draw, tc_multi_draw, n);
+
+      memcpy(&p->info, info, sizeof(*info));
+      p->info.drawid = info->drawid + i;
+      if (info->index_size) {
+         p->info.index.resource = NULL;
+         pipe_resource_reference(&p->info.index.resource,
+                                 info->index.resource);
+      }
+      p->num_draws = n;
+      memcpy(p->slot, draws + i, n * sizeof(draws[0]));
    }
 }
 
@@ -2545,6 +2728,7 @@ threaded_context_create(struct pipe_context *pipe,
    pipe->priv = NULL;
 
    tc->pipe = pipe;
+   tc->batch_calls = TC_MIN_CALLS_PER_BATCH;
    tc->replace_buffer_storage = replace_buffer;
    tc->create_fence = create_fence;
    tc->map_buffer_alignment =
@@ -2585,6 +2769,7 @@ threaded_context_create(struct pipe_context *pipe,
 
    CTX_INIT(flush);
    CTX_INIT(draw_vbo);
+   CTX_INIT(multi_draw);
    CTX_INIT(launch_grid);
    CTX_INIT(resource_copy_region);
    CTX_INIT(blit);
@@ -218,9 +218,15 @@ struct tc_unflushed_batch_token;
  * can occupy multiple call slots.
  *
  * The idea is to have batches as small as possible but large enough so that
- * the queuing and mutex overhead is negligible.
+ * the queuing and mutex overhead is negligible. How many call slots are
+ * used before a batch is flushed is adjusted once per frame, between
+ * TC_MIN_CALLS_PER_BATCH and TC_CALLS_PER_BATCH: frames that flush more
+ * than TC_MAX_BATCHES batches get larger batches, so that the driver thread
+ * wakes up less often and the ring fills up less, and frames that flush
+ * only a few get smaller batches, so that the driver thread starts early.
  */
-#define TC_CALLS_PER_BATCH    192
+#define TC_CALLS_PER_BATCH     768
+#define TC_MIN_CALLS_PER_BATCH 192
 
 /* Threshold for when to use the queue or sync. */
 #define TC_MAX_STRING_MARKER_BYTES  512
@@ -346,6 +352,8 @@ struct tc_batch {
    struct tc_call call[TC_CALLS_PER_BATCH];
 };
 
+struct tc_full_draw_info;
+
 struct threaded_context {
    struct pipe_context base;
    struct pipe_context *pipe;
@@ -365,6 +373,19 @@ struct threaded_context {
    struct util_queue_fence *fence;
 
    unsigned last, next;
+
+   /* Batches are flushed once they have this many call slots. */
+   unsigned batch_calls;
+   /* Batches flushed since the last end of frame. */
+   unsigned frame_batches;
+
+   /* The draw_vbo call that was added last, if no other call followed it.
+    * The next draw can be merged into it.
+    */
+   struct tc_full_draw_info *last_draw;
+   /* Set once a shader has been created that could tell merged draws apart. */
+   bool no_draw_merging;
+
    struct tc_batch batch_slots[TC_MAX_BATCHES];
 };
 
@@ -37,11 +37,15 @@
 
 #include "u_upload_mgr.h"
 
+/* How much larger than default_size the upload buffer may grow. */
+#define U_UPLOAD_MAX_GROWTH 4
+
 
 struct u_upload_mgr {
    struct pipe_context *pipe;
 
    unsigned default_size;  /* Minimum size of the upload buffer, in bytes. */
+   unsigned buffer_size;   /* Size of the next upload buffer, in bytes. */
    unsigned bind;          /* Bitmask of PIPE_BIND_* flags. */
    enum pipe_resource_usage usage;
    unsigned flags;
@@ -66,6 +70,7 @@ u_upload_create(struct pipe_context *pipe, unsigned default_size,
 
    upload->pipe = pipe;
    upload->default_size = default_size;
+   upload->buffer_size = default_size;
    upload->bind = bind;
    upload->usage = usage;
    upload->flags = flags;
@@ -158,13 +163,19 @@ u_upload_alloc_buffer(struct u_upload_mgr *upload, unsigned min_size)
    struct pipe_resource buffer;
    unsigned size;
 
-   /* Release the old buffer, if present:
+   /* Release the old buffer, if present. Filling it up means uploads
+    * outgrow the default size, so grow the next one to replace it less
+    * often.
     */
-   u_upload_release_buffer(upload);
+   if (upload->buffer) {
+      u_upload_release_buffer(upload);
+      upload->buffer_size = MIN2(upload->buffer_size * 2,
+                                 upload->default_size * U_UPLOAD_MAX_GROWTH);
+   }
 
    /* Allocate a new one:
     */
-   size = align(MAX2(upload->default_size, min_size), 4096);
+   size = align(MAX2(upload->buffer_size, min_size), 4096);
 
    memset(&buffer, 0, sizeof buffer);
    buffer.target = PIPE_BUFFER;
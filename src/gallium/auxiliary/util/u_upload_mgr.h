@@ -46,7 +46,8 @@ extern "C" {
  * Create the upload manager.
  *
  * \param pipe          Pipe driver.
- * \param default_size  Minimum size of the upload buffer, in bytes.
+ * \param default_size  Minimum size of the upload buffer, in bytes. Buffers
+ *                      replacing a full one are made larger, up to 4 times.
  * \param bind          Bitmask of PIPE_BIND_* flags.
  * \param usage         PIPE_USAGE_*
  * \param flags         bitmask of PIPE_RESOURCE_FLAG_* flags.
@@ -908,9 +908,29 @@ gen_vertex_data(struct vl_compositor *c, struct vl_compositor_state *s, struct u
    u_upload_unmap(c->pipe->stream_uploader);
 }
 
+static bool
+layer_state_equal(const struct vl_compositor_layer *a, void *a_blend,
+                  const struct vl_compositor_layer *b, void *b_blend)
+{
+   unsigned i;
+
+   if (a->fs != b->fs || a_blend != b_blend)
+      return false;
+
+   for (i = 0; i < 3; ++i)
+      if (a->samplers[i] != b->samplers[i] ||
+          a->sampler_views[i] != b->sampler_views[i])
+         return false;
+
+   return memcmp(&a->viewport, &b->viewport, sizeof(a->viewport)) == 0;
+}
+
 static void
 draw_layers(struct vl_compositor *c, struct vl_compositor_state *s, struct u_rect *dirty)
 {
+   struct vl_compositor_layer *batch = NULL;
+   void *batch_blend = NULL;
+   unsigned batch_start = 0, batch_size = 0;
    unsigned vb_index, i;
 
    assert(c);
@@ -922,15 +942,31 @@ draw_layers(struct vl_compositor *c, struct vl_compositor_state *s, struct u_rec
          unsigned num_sampler_views = !samplers[1] ? 1 : !samplers[2] ? 2 : 3;
          void *blend = layer->blend ? layer->blend : i ? c->blend_add : c->blend_clear;
 
-         c->pipe->bind_blend_state(c->pipe, blend);
-         c->pipe->set_viewport_states(c->pipe, 0, 1, &layer->viewport);
-         c->pipe->bind_fs_state(c->pipe, layer->fs);
-         c->pipe->bind_sampler_states(c->pipe, PIPE_SHADER_FRAGMENT, 0,
-                                      num_sampler_views, layer->samplers);
-         c->pipe->set_sampler_views(c->pipe, PIPE_SHADER_FRAGMENT, 0,
-                                    num_sampler_views, samplers);
-
-         util_draw_arrays(c->pipe, PIPE_PRIM_QUADS, vb_index * 4, 4);
+         /* The quads of all layers are consecutive in the vertex buffer and
+          * draw in order, so layers using the same state share one draw.
+          */
+         if (batch && layer_state_equal(batch, batch_blend, layer, blend)) {
+            batch_size++;
+         } else {
+            if (batch)
+               util_draw_arrays(c->pipe, PIPE_PRIM_QUADS, batch_start * 4, batch_size * 4);
+
+            if (!batch || batch_blend != blend)
+               c->pipe->bind_blend_state(c->pipe, blend);
+            if (!batch || memcmp(&batch->viewport, &layer->viewport, sizeof(layer->viewport)))
+               c->pipe->set_viewport_states(c->pipe, 0, 1, &layer->viewport);
+            if (!batch || batch->fs != layer->fs)
+               c->pipe->bind_fs_state(c->pipe, layer->fs);
+            c->pipe->bind_sampler_states(c->pipe, PIPE_SHADER_FRAGMENT, 0,
+                                         num_sampler_views, layer->samplers);
+            c->pipe->set_sampler_views(c->pipe, PIPE_SHADER_FRAGMENT, 0,
+                                       num_sampler_views, samplers);
+
+            batch = layer;
+            batch_blend = blend;
+            batch_start = vb_index;
+            batch_size = 1;
+         }
          vb_index++;
 
          if (dirty) {
@@ -943,6 +979,9 @@ draw_layers(struct vl_compositor *c, struct vl_compositor_state *s, struct u_rec
          }
       }
    }
+
+   if (batch)
+      util_draw_arrays(c->pipe, PIPE_PRIM_QUADS, batch_start * 4, batch_size * 4);
 }
 
 static void
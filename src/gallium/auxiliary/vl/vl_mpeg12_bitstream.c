@@ -27,6 +27,8 @@
  **************************************************************************/
 
 #include "pipe/p_video_codec.h"
+#include "util/u_dynarray.h"
+#include "util/u_math.h"
 #include "util/u_memory.h"
 
 #include "vl_vlc.h"
@@ -805,6 +807,47 @@ entry:
       vl_vlc_eatbits(&bs->vlc, 1);
 }
 
+struct vl_mpg12_slice
+{
+   struct vl_mpg12_bs bs;
+   struct pipe_video_buffer *target;
+
+   /* parsed macroblocks and the coded blocks they reference, in order */
+   struct util_dynarray macroblocks;
+   struct util_dynarray blocks;
+
+   struct util_queue_fence fence;
+};
+
+static inline unsigned
+num_coded_blocks(const struct pipe_mpeg12_macroblock *mb)
+{
+   if (!(mb->macroblock_type & (PIPE_MPEG12_MB_TYPE_INTRA | PIPE_MPEG12_MB_TYPE_PATTERN)))
+      return 0;
+
+   return util_bitcount(mb->coded_block_pattern);
+}
+
+static inline void
+emit_macroblock(struct vl_mpg12_bs *bs, struct pipe_video_buffer *target,
+                struct pipe_mpeg12_macroblock *mb)
+{
+   struct vl_mpg12_slice *slice = bs->slice;
+   unsigned size;
+
+   if (!slice) {
+      bs->decoder->decode_macroblock(bs->decoder, target, &bs->desc->base, &mb->base, 1);
+      return;
+   }
+
+   /* the blocks pointer is fixed up once the slice is handed to the decoder */
+   util_dynarray_append(&slice->macroblocks, struct pipe_mpeg12_macroblock, *mb);
+
+   size = num_coded_blocks(mb) * 64 * sizeof(short);
+   if (size)
+      memcpy(util_dynarray_grow(&slice->blocks, size), mb->blocks, size);
+}
+
 static inline void
 decode_slice(struct vl_mpg12_bs *bs, struct pipe_video_buffer *target)
 {
@@ -852,7 +895,7 @@ decode_slice(struct vl_mpg12_bs *bs, struct pipe_video_buffer *target)
          if (!inc)
             return;
          mb.num_skipped_macroblocks = inc - 1;
-         bs->decoder->decode_macroblock(bs->decoder, target, &bs->desc->base, &mb.base, 1);
+         emit_macroblock(bs, target, &mb);
       }
       mb.x = x += inc;
       if (bs->decoder->profile == PIPE_VIDEO_PROFILE_MPEG1) {
@@ -962,7 +1005,68 @@ decode_slice(struct vl_mpg12_bs *bs, struct pipe_video_buffer *target)
    } while (vl_vlc_bits_left(&bs->vlc) && vl_vlc_peekbits(&bs->vlc, 23));
 
    mb.num_skipped_macroblocks = 0;
-   bs->decoder->decode_macroblock(bs->decoder, target, &bs->desc->base, &mb.base, 1);
+   emit_macroblock(bs, target, &mb);
+}
+
+static void
+decode_slice_job(void *data, int thread_index)
+{
+   struct vl_mpg12_slice *slice = data;
+
+   decode_slice(&slice->bs, slice->target);
+}
+
+static bool
+init_slices(struct vl_mpg12_bs *bs)
+{
+   unsigned i;
+
+   bs->slices = CALLOC(VL_MPG12_MAX_THREADED_SLICES, sizeof(struct vl_mpg12_slice));
+   if (!bs->slices)
+      return false;
+
+   for (i = 0; i < VL_MPG12_MAX_THREADED_SLICES; ++i) {
+      util_dynarray_init(&bs->slices[i].macroblocks, NULL);
+      util_dynarray_init(&bs->slices[i].blocks, NULL);
+      util_queue_fence_init(&bs->slices[i].fence);
+   }
+
+   return true;
+}
+
+/*
+ * Wait for the slices parsed on the helper threads and hand their
+ * macroblocks to the decoder in bitstream order.
+ */
+static void
+flush_slices(struct vl_mpg12_bs *bs, unsigned num_slices)
+{
+   unsigned i, j;
+
+   for (i = 0; i < num_slices; ++i) {
+      struct vl_mpg12_slice *slice = &bs->slices[i];
+      struct pipe_mpeg12_macroblock *mb;
+      unsigned num_mbs;
+      short *blocks;
+
+      util_queue_fence_wait(&slice->fence);
+
+      mb = util_dynarray_begin(&slice->macroblocks);
+      num_mbs = slice->macroblocks.size / sizeof(struct pipe_mpeg12_macroblock);
+      blocks = util_dynarray_begin(&slice->blocks);
+
+      for (j = 0; j < num_mbs; ++j) {
+         mb[j].blocks = blocks;
+         blocks += num_coded_blocks(&mb[j]) * 64;
+      }
+
+      if (num_mbs)
+         bs->decoder->decode_macroblock(bs->decoder, slice->target, &bs->desc->base,
+                                        &mb->base, num_mbs);
+
+      util_dynarray_clear(&slice->macroblocks);
+      util_dynarray_clear(&slice->blocks);
+   }
 }
 
 void
@@ -982,6 +1086,26 @@ vl_mpg12_bs_init(struct vl_mpg12_bs *bs, struct pipe_video_codec *decoder)
    }
 }
 
+void
+vl_mpg12_bs_cleanup(struct vl_mpg12_bs *bs)
+{
+   unsigned i;
+
+   assert(bs);
+
+   if (!bs->slices)
+      return;
+
+   for (i = 0; i < VL_MPG12_MAX_THREADED_SLICES; ++i) {
+      util_dynarray_fini(&bs->slices[i].macroblocks);
+      util_dynarray_fini(&bs->slices[i].blocks);
+      util_queue_fence_destroy(&bs->slices[i].fence);
+   }
+
+   FREE(bs->slices);
+   bs->slices = NULL;
+}
+
 void
 vl_mpg12_bs_decode(struct vl_mpg12_bs *bs,
                    struct pipe_video_buffer *target,
@@ -990,16 +1114,43 @@ vl_mpg12_bs_decode(struct vl_mpg12_bs *bs,
                    const void * const *buffers,
                    const unsigned *sizes)
 {
+   bool threaded;
+   unsigned num_slices = 0;
+
    assert(bs);
 
    bs->desc = picture;
    bs->intra_dct_tbl = picture->intra_vlc_format ? tbl_B15 : tbl_B14_AC;
 
+   threaded = bs->queue && (bs->slices || init_slices(bs));
+
    vl_vlc_init(&bs->vlc, num_buffers, buffers, sizes);
    while (vl_vlc_search_byte(&bs->vlc, ~0, 0x00) && vl_vlc_bits_left(&bs->vlc) > 32) {
       uint32_t code = vl_vlc_peekbits(&bs->vlc, 32);
 
-      if (code >= 0x101 && code <= 0x1AF) {
+      if (code >= 0x101 && code <= 0x1AF && threaded) {
+         struct vl_mpg12_slice *slice;
+
+         if (num_slices == VL_MPG12_MAX_THREADED_SLICES) {
+            flush_slices(bs, num_slices);
+            num_slices = 0;
+         }
+
+         /* Slices are independent of each other, so each one is parsed from
+          * its own copy of the bitstream reader while this thread searches
+          * on for the next start code.
+          */
+         vl_vlc_eatbits(&bs->vlc, 24);
+         slice = &bs->slices[num_slices++];
+         slice->bs = *bs;
+         slice->bs.slice = slice;
+         slice->target = target;
+         util_queue_add_job(bs->queue, slice, &slice->fence, decode_slice_job, NULL);
+
+         /* skip the slice vertical position */
+         vl_vlc_eatbits(&bs->vlc, 8);
+
+      } else if (code >= 0x101 && code <= 0x1AF) {
          vl_vlc_eatbits(&bs->vlc, 24);
          decode_slice(bs, target);
 
@@ -1012,4 +1163,7 @@ vl_mpg12_bs_decode(struct vl_mpg12_bs *bs,
 
       vl_vlc_fillbits(&bs->vlc);
    }
+
+   if (threaded)
+      flush_slices(bs, num_slices);
 }
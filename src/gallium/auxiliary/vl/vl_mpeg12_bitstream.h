@@ -30,6 +30,12 @@
 
 #include "vl_defines.h"
 #include "vl_vlc.h"
+#include "util/u_queue.h"
+
+/* Maximum number of slices per picture handed to helper threads */
+#define VL_MPG12_MAX_THREADED_SLICES 256
+
+struct vl_mpg12_slice;
 
 struct vl_mpg12_bs
 {
@@ -40,11 +46,21 @@ struct vl_mpg12_bs
 
    struct vl_vlc vlc;
    short pred_dc[3];
+
+   /* optional helper threads parsing slices in parallel, owned by the caller */
+   struct util_queue *queue;
+   struct vl_mpg12_slice *slices;
+
+   /* set while parsing on a helper thread, macroblocks are recorded here */
+   struct vl_mpg12_slice *slice;
 };
 
 void
 vl_mpg12_bs_init(struct vl_mpg12_bs *bs, struct pipe_video_codec *decoder);
 
+void
+vl_mpg12_bs_cleanup(struct vl_mpg12_bs *bs);
+
 void
 vl_mpg12_bs_decode(struct vl_mpg12_bs *bs,
                    struct pipe_video_buffer *target,
@@ -28,6 +28,7 @@
 #include <math.h>
 #include <assert.h>
 
+#include "util/u_debug.h"
 #include "util/u_memory.h"
 #include "util/u_sampler.h"
 #include "util/u_surface.h"
@@ -39,6 +40,8 @@
 #define SCALE_FACTOR_SNORM (32768.0f / 256.0f)
 #define SCALE_FACTOR_SSCALED (1.0f / 256.0f)
 
+#define VL_MPEG12_MAX_THREADS 8
+
 struct format_config {
    enum pipe_format zscan_source_format;
    enum pipe_format idct_source_format;
@@ -472,6 +475,7 @@ vl_mpeg12_destroy_buffer(struct vl_mpeg12_buffer *buf)
    cleanup_idct_buffer(buf);
    cleanup_mc_buffer(buf);
    vl_vb_cleanup(&buf->vertex_stream);
+   vl_mpg12_bs_cleanup(&buf->bs);
 
    FREE(buf);
 }
@@ -520,6 +524,9 @@ vl_mpeg12_destroy(struct pipe_video_codec *decoder)
       if (dec->dec_buffers[i])
          vl_mpeg12_destroy_buffer(dec->dec_buffers[i]);
 
+   if (util_queue_is_initialized(&dec->bs_queue))
+      util_queue_destroy(&dec->bs_queue);
+
    dec->context->destroy(dec->context);
 
    FREE(dec);
@@ -560,8 +567,11 @@ vl_mpeg12_get_decode_buffer(struct vl_mpeg12_decoder *dec, struct pipe_video_buf
    if (!init_zscan_buffer(dec, buffer))
       goto error_zscan;
 
-   if (dec->base.entrypoint == PIPE_VIDEO_ENTRYPOINT_BITSTREAM)
+   if (dec->base.entrypoint == PIPE_VIDEO_ENTRYPOINT_BITSTREAM) {
       vl_mpg12_bs_init(&buffer->bs, &dec->base);
+      if (util_queue_is_initialized(&dec->bs_queue))
+         buffer->bs.queue = &dec->bs_queue;
+   }
 
    if (dec->base.expect_chunked_decode)
       priv->buffer = buffer;
@@ -1211,6 +1221,18 @@ vl_create_mpeg12_decoder(struct pipe_context *context,
 
    list_inithead(&dec->buffer_privates);
 
+   /* Optionally parse the slices of a picture on helper threads, the
+    * decoder still receives the macroblocks in bitstream order.
+    */
+   if (templat->entrypoint == PIPE_VIDEO_ENTRYPOINT_BITSTREAM) {
+      unsigned num_threads = MIN2(debug_get_num_option("VL_MPEG12_THREADS", 0),
+                                  VL_MPEG12_MAX_THREADS);
+
+      if (num_threads)
+         util_queue_init(&dec->bs_queue, "vlmpeg12", VL_MPG12_MAX_THREADED_SLICES,
+                         num_threads, 0);
+   }
+
    return &dec->base;
 
 error_pipe_state:
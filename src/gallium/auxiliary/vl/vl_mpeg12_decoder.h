@@ -81,6 +81,9 @@ struct vl_mpeg12_decoder
    struct vl_mpeg12_buffer *dec_buffers[4];
 
    struct list_head buffer_privates;
+
+   /* helper threads parsing bitstream slices, see VL_MPEG12_THREADS */
+   struct util_queue bs_queue;
 };
 
 struct vl_mpeg12_buffer
@@ -117,6 +117,12 @@ vl_mpg12_bs_init(struct vl_mpg12_bs *bs, struct pipe_video_codec *decoder)
    assert(0);
 }
 
+void
+vl_mpg12_bs_cleanup(struct vl_mpg12_bs *bs)
+{
+   assert(0);
+}
+
 void
 vl_mpg12_bs_decode(struct vl_mpg12_bs *bs,
                    struct pipe_video_buffer *target,
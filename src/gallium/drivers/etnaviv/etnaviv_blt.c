@@ -512,7 +512,10 @@ etna_try_blt_blit(struct pipe_context *pctx,
 
    resource_written(ctx, &dst->base);
    dst->seqno++;
-   dst_lev->ts_valid = false;
+
+   /* The TS stays consistent with the memory after a resolve-in-place */
+   if (src != dst)
+      dst_lev->ts_valid = false;
 
    return TRUE;
 }
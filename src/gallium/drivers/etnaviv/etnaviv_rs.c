@@ -730,7 +730,15 @@ etna_try_rs_blit(struct pipe_context *pctx,
    etna_submit_rs_state(ctx, &copy_to_screen);
    resource_written(ctx, &dst->base);
    dst->seqno++;
-   dst->levels[blit_info->dst.level].ts_valid = false;
+
+   /* A resolve-in-place only fills in the cleared tiles with the clear value,
+    * which leaves the memory consistent with what the TS says. Keep the TS
+    * valid in that case, so that rendering and sampling can continue to use
+    * it. Anything else overwrites the destination behind the TS's back.
+    */
+   if (!(src == dst && source_ts_valid && src->base.nr_samples <= 1 &&
+         blit_info->src.level == blit_info->dst.level))
+      dst->levels[blit_info->dst.level].ts_valid = false;
    ctx->dirty |= ETNA_DIRTY_DERIVE_TS;
 
    return TRUE;
@@ -220,6 +220,7 @@ struct fd_context {
 		uint64_t prims_generated;
 		uint64_t draw_calls;
 		uint64_t batch_total, batch_sysmem, batch_gmem, batch_nondraw, batch_restore;
+		uint64_t restore_skipped, resolve_skipped;  /* in bytes */
 		uint64_t staging_uploads, shadow_uploads;
 		uint64_t vs_regs, fs_regs;
 	} stats;
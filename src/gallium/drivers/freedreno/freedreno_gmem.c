@@ -461,6 +461,25 @@ skip_restore(struct pipe_scissor_state *scissor, struct fd_tile *tile)
  * consider the last scissor rect for each buffer, since the common
  * case would be a single clear.
  */
+static uint32_t
+tile_restore_size(struct fd_batch *batch, struct fd_tile *tile,
+		uint32_t buffers)
+{
+	struct fd_gmem_stateobj *gmem = &batch->ctx->gmem;
+	uint32_t restore = batch->restore & buffers;
+	uint32_t cpp = 0;
+
+	for (unsigned i = 0; i < MAX_RENDER_TARGETS; i++)
+		if (restore & (PIPE_CLEAR_COLOR0 << i))
+			cpp += gmem->cbuf_cpp[i];
+	if (restore & FD_BUFFER_DEPTH)
+		cpp += gmem->zsbuf_cpp[0];
+	if (restore & FD_BUFFER_STENCIL)
+		cpp += gmem->zsbuf_cpp[1];
+
+	return tile->bin_w * tile->bin_h * cpp;
+}
+
 bool
 fd_gmem_needs_restore(struct fd_batch *batch, struct fd_tile *tile,
 		uint32_t buffers)
@@ -471,18 +490,19 @@ fd_gmem_needs_restore(struct fd_batch *batch, struct fd_tile *tile,
 	/* if buffers partially cleared, then slow-path to figure out
 	 * if this particular tile needs restoring:
 	 */
-	if ((buffers & FD_BUFFER_COLOR) &&
+	if (((buffers & FD_BUFFER_COLOR) &&
 			(batch->partial_cleared & FD_BUFFER_COLOR) &&
-			skip_restore(&batch->cleared_scissor.color, tile))
-		return false;
-	if ((buffers & FD_BUFFER_DEPTH) &&
+			skip_restore(&batch->cleared_scissor.color, tile)) ||
+		((buffers & FD_BUFFER_DEPTH) &&
 			(batch->partial_cleared & FD_BUFFER_DEPTH) &&
-			skip_restore(&batch->cleared_scissor.depth, tile))
-		return false;
-	if ((buffers & FD_BUFFER_STENCIL) &&
+			skip_restore(&batch->cleared_scissor.depth, tile)) ||
+		((buffers & FD_BUFFER_STENCIL) &&
 			(batch->partial_cleared & FD_BUFFER_STENCIL) &&
-			skip_restore(&batch->cleared_scissor.stencil, tile))
+			skip_restore(&batch->cleared_scissor.stencil, tile))) {
+		batch->ctx->stats.restore_skipped +=
+			tile_restore_size(batch, tile, buffers);
 		return false;
+	}
 
 	return true;
 }
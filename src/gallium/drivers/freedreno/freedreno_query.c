@@ -139,6 +139,8 @@ static const struct pipe_driver_query_info sw_query_list[] = {
 	FQ("batches-gmem", BATCH_GMEM, UINT64, AVERAGE),
 	FQ("batches-nondraw", BATCH_NONDRAW, UINT64, AVERAGE),
 	FQ("restores", BATCH_RESTORE, UINT64, AVERAGE),
+	FQ("restore-skipped", RESTORE_SKIPPED, BYTES, AVERAGE),
+	FQ("resolve-skipped", RESOLVE_SKIPPED, BYTES, AVERAGE),
 	PQ("prims-emitted", PRIMITIVES_EMITTED, UINT64, AVERAGE),
 	FQ("staging", STAGING_UPLOADS, UINT64, AVERAGE),
 	FQ("shadow", SHADOW_UPLOADS, UINT64, AVERAGE),
@@ -69,6 +69,10 @@ read_counter(struct fd_context *ctx, int type)
 		return ctx->stats.batch_nondraw;
 	case FD_QUERY_BATCH_RESTORE:
 		return ctx->stats.batch_restore;
+	case FD_QUERY_RESTORE_SKIPPED:
+		return ctx->stats.restore_skipped;
+	case FD_QUERY_RESOLVE_SKIPPED:
+		return ctx->stats.resolve_skipped;
 	case FD_QUERY_STAGING_UPLOADS:
 		return ctx->stats.staging_uploads;
 	case FD_QUERY_SHADOW_UPLOADS:
@@ -90,6 +94,8 @@ is_time_rate_query(struct fd_query *q)
 	case FD_QUERY_BATCH_GMEM:
 	case FD_QUERY_BATCH_NONDRAW:
 	case FD_QUERY_BATCH_RESTORE:
+	case FD_QUERY_RESTORE_SKIPPED:
+	case FD_QUERY_RESOLVE_SKIPPED:
 	case FD_QUERY_STAGING_UPLOADS:
 	case FD_QUERY_SHADOW_UPLOADS:
 		return true;
@@ -178,6 +184,8 @@ fd_sw_create_query(struct fd_context *ctx, unsigned query_type)
 	case FD_QUERY_BATCH_GMEM:
 	case FD_QUERY_BATCH_NONDRAW:
 	case FD_QUERY_BATCH_RESTORE:
+	case FD_QUERY_RESTORE_SKIPPED:
+	case FD_QUERY_RESOLVE_SKIPPED:
 	case FD_QUERY_STAGING_UPLOADS:
 	case FD_QUERY_SHADOW_UPLOADS:
 	case FD_QUERY_VS_REGS:
@@ -1110,6 +1110,23 @@ fd_blitter_pipe_end(struct fd_context *ctx)
 	ctx->in_blit = false;
 }
 
+static void
+invalidate_attachment(struct fd_batch *batch, struct pipe_surface *psurf,
+		uint32_t buffers)
+{
+	struct fd_context *ctx = batch->ctx;
+	uint32_t size = batch->framebuffer.width * batch->framebuffer.height *
+			util_format_get_blocksize(psurf->format);
+
+	if (batch->restore & buffers)
+		ctx->stats.restore_skipped += size;
+	if (batch->resolve & buffers)
+		ctx->stats.resolve_skipped += size;
+
+	batch->restore &= ~buffers;
+	batch->resolve &= ~buffers;
+}
+
 static void
 fd_invalidate_resource(struct pipe_context *pctx, struct pipe_resource *prsc)
 {
@@ -1121,16 +1138,22 @@ fd_invalidate_resource(struct pipe_context *pctx, struct pipe_resource *prsc)
 	 * even in the non-DISCARD_WHOLE_RESOURCE case?
 	 */
 
+	/* The contents are undefined from here on, so whatever the batch
+	 * writing the resource would have restored into GMEM or resolved
+	 * back out of it is no longer needed:
+	 */
 	if (rsc->write_batch) {
 		struct fd_batch *batch = rsc->write_batch;
 		struct pipe_framebuffer_state *pfb = &batch->framebuffer;
 
 		if (pfb->zsbuf && pfb->zsbuf->texture == prsc)
-			batch->resolve &= ~(FD_BUFFER_DEPTH | FD_BUFFER_STENCIL);
+			invalidate_attachment(batch, pfb->zsbuf,
+					FD_BUFFER_DEPTH | FD_BUFFER_STENCIL);
 
 		for (unsigned i = 0; i < pfb->nr_cbufs; i++) {
 			if (pfb->cbufs[i] && pfb->cbufs[i]->texture == prsc) {
-				batch->resolve &= ~(PIPE_CLEAR_COLOR0 << i);
+				invalidate_attachment(batch, pfb->cbufs[i],
+						PIPE_CLEAR_COLOR0 << i);
 			}
 		}
 	}
@@ -435,6 +435,15 @@ find_eligible_instr(struct ir3_sched_ctx *ctx, struct ir3_sched_notes *notes,
 			continue;
 
 		delay = delay_calc(ctx->block, candidate, soft, false);
+
+		/* back-to-back sfu/mem instructions need a nop between them
+		 * (see schedule()), so account for that and prefer something
+		 * else that could fill the slot instead:
+		 */
+		if (ctx->scheduled && is_sfu_or_mem(ctx->scheduled) &&
+				is_sfu_or_mem(candidate))
+			delay++;
+
 		if (delay < min_delay) {
 			best_instr = candidate;
 			min_delay = delay;
@@ -141,6 +141,8 @@ struct llvmpipe_context {
    struct lp_fs_variant_list_item fs_variants_list;
    unsigned nr_fs_variants;
    unsigned nr_fs_instrs;
+   /** Variants still running unoptimized code, see LP_ASYNC_COMPILE */
+   unsigned nr_fs_variants_pending;
 
    struct lp_setup_variant_list_item setup_variants_list;
    unsigned nr_setup_variants;
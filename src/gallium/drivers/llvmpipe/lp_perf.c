@@ -26,6 +26,7 @@
  **************************************************************************/
 
 #include "util/u_debug.h"
+#include "util/u_math.h"
 #include "lp_debug.h"
 #include "lp_perf.h"
 
@@ -46,6 +47,7 @@ lp_print_counters(void)
 {
    if (LP_DEBUG & DEBUG_COUNTERS) {
       unsigned total_64, total_16, total_4;
+      unsigned i, nr_threads, min_blocks, max_blocks, total_blocks;
       float p1, p2, p3, p4, p5, p6;
 
       debug_printf("llvmpipe: nr_triangles:                 %9u\n", lp_count.nr_tris);
@@ -82,6 +84,7 @@ lp_print_counters(void)
       debug_printf("llvmpipe:   nr_fully_covered_16x16:     %9u (%3.0f%% of %u)\n", lp_count.nr_fully_covered_16, p2, total_16);
       debug_printf("llvmpipe:   nr_partially_covered_16x16: %9u (%3.0f%% of %u)\n", lp_count.nr_partially_covered_16, p3, total_16);
       debug_printf("llvmpipe:   nr_empty_16x16:             %9u (%3.0f%% of %u)\n", lp_count.nr_empty_16, p1, total_16);
+      debug_printf("llvmpipe:   nr_hiz_culled_16x16:        %9u\n", lp_count.nr_hiz_culled_16);
 
       total_4 = (lp_count.nr_empty_4 +
                  lp_count.nr_fully_covered_4 +
@@ -102,6 +105,29 @@ lp_print_counters(void)
       debug_printf("llvmpipe: nr_color_tile_load:           %9u\n", lp_count.nr_color_tile_load);
       debug_printf("llvmpipe: nr_color_tile_store:          %9u\n", lp_count.nr_color_tile_store);
 
+      debug_printf("llvmpipe: nr_heavy_bins:                %9u\n", lp_count.nr_heavy_bins);
+
+      nr_threads = 0;
+      min_blocks = ~0u;
+      max_blocks = 0;
+      total_blocks = 0;
+      for (i = 0; i < LP_MAX_THREADS; i++) {
+         if (lp_count.nr_thread_bins[i]) {
+            nr_threads++;
+            min_blocks = MIN2(min_blocks, lp_count.nr_thread_cmd_blocks[i]);
+            max_blocks = MAX2(max_blocks, lp_count.nr_thread_cmd_blocks[i]);
+            total_blocks += lp_count.nr_thread_cmd_blocks[i];
+            debug_printf("llvmpipe:   thread %2u bins:             %9u (%u cmd blocks)\n",
+                         i, lp_count.nr_thread_bins[i],
+                         lp_count.nr_thread_cmd_blocks[i]);
+         }
+      }
+      if (nr_threads > 1 && total_blocks) {
+         debug_printf("llvmpipe:   cmd blocks per thread:      min %u avg %u max %u (imbalance %.2f)\n",
+                      min_blocks, total_blocks / nr_threads, max_blocks,
+                      (float) max_blocks * nr_threads / (float) total_blocks);
+      }
+
       debug_printf("llvmpipe: nr_llvm_compiles:             %u\n", lp_count.nr_llvm_compiles);
       debug_printf("llvmpipe: total LLVM compile time:      %.2f sec\n", lp_count.llvm_compile_time / 1000000.0);
       debug_printf("llvmpipe: average LLVM compile time:    %.2f sec\n", lp_count.llvm_compile_time / 1000000.0 / lp_count.nr_llvm_compiles);
@@ -34,6 +34,7 @@
 #define LP_PERF_H
 
 #include "pipe/p_compiler.h"
+#include "lp_limits.h"
 
 /**
  * Various counters
@@ -56,12 +57,17 @@ struct lp_counters
    unsigned nr_fully_covered_4;
    unsigned nr_partially_covered_4;
    unsigned nr_non_empty_4;
+   unsigned nr_hiz_culled_16;  /**< 16x16 blocks skipped by coarse depth */
    unsigned nr_llvm_compiles;
    int64_t llvm_compile_time;  /**< total, in microseconds */
 
    unsigned nr_color_tile_clear;
    unsigned nr_color_tile_load;
    unsigned nr_color_tile_store;
+
+   unsigned nr_heavy_bins;  /**< bins scheduled ahead of the others */
+   unsigned nr_thread_bins[LP_MAX_THREADS];
+   unsigned nr_thread_cmd_blocks[LP_MAX_THREADS];
 };
 
 
@@ -1,6 +1,8 @@
 #ifndef LP_PUBLIC_H
 #define LP_PUBLIC_H
 
+#include <stdbool.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -11,6 +13,11 @@ struct sw_winsys;
 struct pipe_screen *
 llvmpipe_create_screen(struct sw_winsys *winsys);
 
+struct pipe_screen *
+llvmpipe_create_screen_with_threads(struct sw_winsys *winsys,
+                                    int num_threads,
+                                    bool pin_threads);
+
 #ifdef __cplusplus
 }
 #endif
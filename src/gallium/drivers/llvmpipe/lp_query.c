@@ -55,7 +55,8 @@ llvmpipe_create_query(struct pipe_context *pipe,
 {
    struct llvmpipe_query *pq;
 
-   assert(type < PIPE_QUERY_TYPES);
+   assert(type < PIPE_QUERY_TYPES ||
+          (type >= PIPE_QUERY_DRIVER_SPECIFIC && type <= LP_QUERY_LAST));
 
    pq = CALLOC_STRUCT( llvmpipe_query );
 
@@ -166,6 +167,17 @@ llvmpipe_get_query_result(struct pipe_context *pipe,
       stats->primitives_storage_needed = pq->num_primitives_generated;
    }
       break;
+   case LP_QUERY_VCACHE_LOOKUPS:
+      *result = pq->vcache_lookups;
+      break;
+   case LP_QUERY_VCACHE_HITS:
+      *result = pq->vcache_lookups - pq->vcache_misses;
+      break;
+   case LP_QUERY_VCACHE_HIT_RATE:
+      if (pq->vcache_lookups)
+         *result = (pq->vcache_lookups - pq->vcache_misses) * 100 /
+                   pq->vcache_lookups;
+      break;
    case PIPE_QUERY_PIPELINE_STATISTICS: {
       struct pipe_query_data_pipeline_statistics *stats =
          (struct pipe_query_data_pipeline_statistics *)vresult;
@@ -230,6 +242,12 @@ llvmpipe_begin_query(struct pipe_context *pipe, struct pipe_query *q)
       memcpy(&pq->stats, &llvmpipe->pipeline_statistics, sizeof(pq->stats));
       llvmpipe->active_statistics_queries++;
       break;
+   case LP_QUERY_VCACHE_LOOKUPS:
+   case LP_QUERY_VCACHE_HITS:
+   case LP_QUERY_VCACHE_HIT_RATE:
+      draw_get_vertex_cache_stats(llvmpipe->draw, &pq->vcache_lookups,
+                                  &pq->vcache_misses);
+      break;
    case PIPE_QUERY_OCCLUSION_COUNTER:
    case PIPE_QUERY_OCCLUSION_PREDICATE:
    case PIPE_QUERY_OCCLUSION_PREDICATE_CONSERVATIVE:
@@ -294,6 +312,15 @@ llvmpipe_end_query(struct pipe_context *pipe, struct pipe_query *q)
 
       llvmpipe->active_statistics_queries--;
       break;
+   case LP_QUERY_VCACHE_LOOKUPS:
+   case LP_QUERY_VCACHE_HITS:
+   case LP_QUERY_VCACHE_HIT_RATE: {
+      uint64_t lookups, misses;
+      draw_get_vertex_cache_stats(llvmpipe->draw, &lookups, &misses);
+      pq->vcache_lookups = lookups - pq->vcache_lookups;
+      pq->vcache_misses = misses - pq->vcache_misses;
+   }
+      break;
    case PIPE_QUERY_OCCLUSION_COUNTER:
    case PIPE_QUERY_OCCLUSION_PREDICATE:
    case PIPE_QUERY_OCCLUSION_PREDICATE_CONSERVATIVE:
@@ -328,6 +355,33 @@ llvmpipe_check_render_cond(struct llvmpipe_context *lp)
       return TRUE;
 }
 
+int
+llvmpipe_get_driver_query_info(struct pipe_screen *screen,
+                               unsigned index,
+                               struct pipe_driver_query_info *info)
+{
+   static const struct pipe_driver_query_info queries[] = {
+      { "draw-vcache-lookups", LP_QUERY_VCACHE_LOOKUPS, { 0 },
+        PIPE_DRIVER_QUERY_TYPE_UINT64,
+        PIPE_DRIVER_QUERY_RESULT_TYPE_CUMULATIVE },
+      { "draw-vcache-hits", LP_QUERY_VCACHE_HITS, { 0 },
+        PIPE_DRIVER_QUERY_TYPE_UINT64,
+        PIPE_DRIVER_QUERY_RESULT_TYPE_CUMULATIVE },
+      { "draw-vcache-hit-rate", LP_QUERY_VCACHE_HIT_RATE, { 100 },
+        PIPE_DRIVER_QUERY_TYPE_PERCENTAGE,
+        PIPE_DRIVER_QUERY_RESULT_TYPE_AVERAGE },
+   };
+
+   if (!info)
+      return ARRAY_SIZE(queries);
+
+   if (index >= ARRAY_SIZE(queries))
+      return 0;
+
+   *info = queries[index];
+   return 1;
+}
+
 static void
 llvmpipe_set_active_query_state(struct pipe_context *pipe, boolean enable)
 {
@@ -39,6 +39,15 @@
 
 
 struct llvmpipe_context;
+struct pipe_screen;
+struct pipe_driver_query_info;
+
+
+/** Vertex cache statistics of the draw module */
+#define LP_QUERY_VCACHE_LOOKUPS  (PIPE_QUERY_DRIVER_SPECIFIC + 0)
+#define LP_QUERY_VCACHE_HITS     (PIPE_QUERY_DRIVER_SPECIFIC + 1)
+#define LP_QUERY_VCACHE_HIT_RATE (PIPE_QUERY_DRIVER_SPECIFIC + 2)
+#define LP_QUERY_LAST            LP_QUERY_VCACHE_HIT_RATE
 
 
 struct llvmpipe_query {
@@ -50,6 +59,9 @@ struct llvmpipe_query {
    unsigned num_primitives_written;
 
    struct pipe_query_data_pipeline_statistics stats;
+
+   uint64_t vcache_lookups;
+   uint64_t vcache_misses;
 };
 
 
@@ -57,4 +69,8 @@ extern void llvmpipe_init_query_funcs(struct llvmpipe_context * );
 
 extern boolean llvmpipe_check_render_cond(struct llvmpipe_context *);
 
+extern int llvmpipe_get_driver_query_info(struct pipe_screen *screen,
+                                          unsigned index,
+                                          struct pipe_driver_query_info *info);
+
 #endif /* LP_QUERY_H */
@@ -77,9 +77,14 @@ lp_rast_begin( struct lp_rasterizer *rast,
 static void
 lp_rast_end( struct lp_rasterizer *rast )
 {
-   lp_scene_end_rasterization( rast->curr_scene );
+   struct lp_scene *scene = rast->curr_scene;
+
+   lp_scene_end_rasterization( scene );
 
    rast->curr_scene = NULL;
+
+   /* hand the scene back to setup */
+   util_queue_fence_signal(&scene->idle);
 }
 
 
@@ -109,6 +114,8 @@ lp_rast_tile_begin(struct lp_rasterizer_task *task,
    task->thread_data.vis_counter = 0;
    task->thread_data.ps_invocations = 0;
 
+   lp_rast_hiz_reset(task, LP_HIZ_UNKNOWN);
+
    for (i = 0; i < task->scene->fb.nr_cbufs; i++) {
       if (task->scene->fb.cbufs[i]) {
          task->color_tiles[i] = scene->cbufs[i].map +
@@ -199,6 +206,7 @@ lp_rast_clear_zstencil(struct lp_rasterizer_task *task,
     */
 
    if (scene->fb.zsbuf) {
+      const struct util_format_description *desc;
       unsigned layer;
       uint8_t *dst_layer = task->depth_tile;
       block_size = util_format_get_blocksize(scene->fb.zsbuf->format);
@@ -281,6 +289,21 @@ lp_rast_clear_zstencil(struct lp_rasterizer_task *task,
          }
          dst_layer += scene->zsbuf.layer_stride;
       }
+
+      /* The whole tile has the same depth now, if depth was cleared */
+      desc = util_format_description(scene->fb.zsbuf->format);
+      if (util_format_has_depth(desc)) {
+         const uint64_t zmask = util_pack64_mask_z(desc->format, ~0);
+
+         if ((clear_mask64 & zmask) == zmask) {
+            float z;
+            desc->unpack_z_float(&z, 0, task->depth_tile, 0, 1, 1);
+            lp_rast_hiz_reset(task, z);
+         }
+         else if (clear_mask64 & zmask) {
+            lp_rast_hiz_reset(task, LP_HIZ_UNKNOWN);
+         }
+      }
    }
 }
 
@@ -300,6 +323,7 @@ lp_rast_shade_tile(struct lp_rasterizer_task *task,
    const struct lp_rast_state *state;
    struct lp_fragment_shader_variant *variant;
    const unsigned tile_x = task->x, tile_y = task->y;
+   unsigned cull_mask;
    unsigned x, y;
 
    if (inputs->disable) {
@@ -316,6 +340,9 @@ lp_rast_shade_tile(struct lp_rasterizer_task *task,
    }
    variant = state->variant;
 
+   cull_mask = lp_rast_hiz_cull_mask(task, inputs);
+   LP_COUNT_ADD(nr_hiz_culled_16, util_bitcount(cull_mask));
+
    /* render the whole 64x64 tile in 4x4 chunks */
    for (y = 0; y < task->height; y += 4){
       for (x = 0; x < task->width; x += 4) {
@@ -325,6 +352,9 @@ lp_rast_shade_tile(struct lp_rasterizer_task *task,
          unsigned depth_stride = 0;
          unsigned i;
 
+         if (cull_mask & (1 << ((y / 16) * 4 + x / 16)))
+            continue;
+
          /* color buffer */
          for (i = 0; i < scene->fb.nr_cbufs; i++){
             if (scene->fb.cbufs[i]) {
@@ -365,6 +395,12 @@ lp_rast_shade_tile(struct lp_rasterizer_task *task,
          END_JIT_CALL();
       }
    }
+
+   if (task->hiz_write) {
+      for (y = 0; y < TILE_SIZE / 16; y++)
+         for (x = 0; x < TILE_SIZE / 16; x++)
+            lp_rast_hiz_update(task, inputs, x, y);
+   }
 }
 
 
@@ -534,7 +570,15 @@ void
 lp_rast_set_state(struct lp_rasterizer_task *task,
                   const union lp_rast_cmd_arg arg)
 {
+   const struct lp_fragment_shader_variant *variant = arg.state->variant;
+
    task->state = arg.state;
+   task->hiz_test = variant->hiz_test;
+   task->hiz_write = variant->hiz_write;
+
+   /* Depth may go up from here on, the coarse depth is no bound anymore */
+   if (variant->hiz_invalidate)
+      lp_rast_hiz_reset(task, LP_HIZ_UNKNOWN);
 }
 
 
@@ -683,8 +727,12 @@ rasterize_scene(struct lp_rasterizer_task *task,
 
          assert(scene);
          while ((bin = lp_scene_bin_iter_next(scene, &i, &j))) {
-            if (!is_empty_bin( bin ))
+            if (!is_empty_bin( bin )) {
+               LP_COUNT(nr_thread_bins[task->thread_index]);
+               LP_COUNT_ADD(nr_thread_cmd_blocks[task->thread_index],
+                            bin->num_blocks);
                rasterize_bin(task, bin, i, j);
+            }
          }
       }
    }
@@ -756,23 +804,6 @@ lp_rast_queue_scene( struct lp_rasterizer *rast,
 }
 
 
-void
-lp_rast_finish( struct lp_rasterizer *rast )
-{
-   if (rast->num_threads == 0) {
-      /* nothing to do */
-   }
-   else {
-      int i;
-
-      /* wait for work to complete */
-      for (i = 0; i < rast->num_threads; i++) {
-         pipe_semaphore_wait(&rast->tasks[i].work_done);
-      }
-   }
-}
-
-
 /**
  * This is the thread's main entrypoint.
  * It's a simple loop:
@@ -798,6 +829,19 @@ thread_function(void *init_data)
    fpstate = util_fpstate_get();
    util_fpstate_set_denorms_to_zero(fpstate);
 
+   if (rast->pin_threads && u_thread_pin_to_cpu(task->thread_index)) {
+      /* Re-allocate the per-thread scratch data from the pinned thread, so
+       * that it gets placed on the local NUMA node when first touched.
+       */
+      struct lp_build_format_cache *cache =
+         align_malloc(sizeof(struct lp_build_format_cache), 16);
+      if (cache) {
+         memset(cache, 0, sizeof *cache);
+         align_free(task->thread_data.cache);
+         task->thread_data.cache = cache;
+      }
+   }
+
    while (1) {
       /* wait for work */
       if (debug)
@@ -831,17 +875,15 @@ thread_function(void *init_data)
       /* wait for all threads to finish with this scene */
       util_barrier_wait( &rast->barrier );
 
-      /* XXX: shouldn't be necessary:
+      /* Unmap the framebuffer and release the scene.  Setup waits on
+       * lp_scene::idle rather than on the threads before reusing it.
        */
       if (task->thread_index == 0) {
          lp_rast_end( rast );
       }
 
-      /* signal done with work */
       if (debug)
          debug_printf("thread %d done working\n", task->thread_index);
-
-      pipe_semaphore_signal(&task->work_done);
    }
 
 #ifdef _WIN32
@@ -875,9 +917,10 @@ create_rast_threads(struct lp_rasterizer *rast)
  * Create new lp_rasterizer.  If num_threads is zero, don't create any
  * new threads, do rendering synchronously.
  * \param num_threads  number of rasterizer threads to create
+ * \param pin_threads  pin each rasterizer thread to its own CPU
  */
 struct lp_rasterizer *
-lp_rast_create( unsigned num_threads )
+lp_rast_create( unsigned num_threads, boolean pin_threads )
 {
    struct lp_rasterizer *rast;
    unsigned i;
@@ -906,6 +949,7 @@ lp_rast_create( unsigned num_threads )
    rast->num_threads = num_threads;
 
    rast->no_rast = debug_get_bool_option("LP_NO_RAST", FALSE);
+   rast->pin_threads = pin_threads;
 
    create_rast_threads(rast);
 
@@ -28,7 +28,10 @@
 #ifndef LP_RAST_PRIV_H
 #define LP_RAST_PRIV_H
 
+#include <float.h>
+
 #include "util/u_format.h"
+#include "util/u_math.h"
 #include "util/u_thread.h"
 #include "gallivm/lp_bld_debug.h"
 #include "lp_memory.h"
@@ -91,6 +94,15 @@ struct lp_rasterizer_task
    uint8_t *color_tiles[PIPE_MAX_COLOR_BUFS];
    uint8_t *depth_tile;
 
+   /**
+    * Coarse depth of the tile: an upper bound of the depth values in each
+    * 16x16 block, or LP_HIZ_UNKNOWN.  Lets triangles skip the blocks in
+    * which they'd fail a LESS/LEQUAL depth test everywhere.
+    */
+   float hiz_zmax[TILE_SIZE / 16][TILE_SIZE / 16];
+   boolean hiz_test;   /**< current state may cull against hiz_zmax */
+   boolean hiz_write;  /**< current state may lower hiz_zmax */
+
    /** "back" pointer */
    struct lp_rasterizer *rast;
 
@@ -114,6 +126,7 @@ struct lp_rasterizer
 {
    boolean exit_flag;
    boolean no_rast;  /**< For debugging/profiling */
+   boolean pin_threads;  /**< Pin each thread to its own CPU */
 
    /** The incoming queue of scenes ready to rasterize */
    struct lp_scene_queue *full_scenes;
@@ -215,6 +228,137 @@ lp_rast_get_depth_block_pointer(struct lp_rasterizer_task *task,
 
 
 
+#define LP_HIZ_UNKNOWN FLT_MAX
+
+/** Margin for the depth quantization of the depth buffer formats */
+#define LP_HIZ_EPSILON (1.0f / (1 << 15))
+
+
+static inline void
+lp_rast_hiz_reset(struct lp_rasterizer_task *task, float zmax)
+{
+   unsigned ix, iy;
+
+   for (iy = 0; iy < TILE_SIZE / 16; iy++)
+      for (ix = 0; ix < TILE_SIZE / 16; ix++)
+         task->hiz_zmax[iy][ix] = zmax;
+}
+
+
+/**
+ * Conservative range of the depth of the triangle over the 16x16 pixels
+ * at (x, y), in window coords.  Padded by a pixel on each side to cover
+ * the pixel center offset, and by some slack for the rounding differences
+ * with the depth interpolation of the fragment shader.
+ */
+static inline void
+lp_rast_hiz_range_16(const struct lp_rast_shader_inputs *inputs,
+                     int x, int y, float *zmin, float *zmax)
+{
+   const float a0 = GET_A0(inputs)[0][2];
+   const float dzdx = GET_DADX(inputs)[0][2];
+   const float dzdy = GET_DADY(inputs)[0][2];
+   const float z = a0 + dzdx * (x - 1) + dzdy * (y - 1);
+   const float ex = dzdx * 18.0f;
+   const float ey = dzdy * 18.0f;
+   const float slack = (fabsf(a0) + fabsf(dzdx * x) + fabsf(dzdy * y))
+                       * (1.0f / (1 << 20));
+
+   *zmin = z + MIN2(ex, 0.0f) + MIN2(ey, 0.0f) - slack;
+   *zmax = z + MAX2(ex, 0.0f) + MAX2(ey, 0.0f) + slack;
+}
+
+
+/**
+ * Whether the triangle fails the depth test everywhere in the 16x16 pixels
+ * at (x, y), in window coords, given the coarse depth \p zmax of the area.
+ * Unorm depth is clamped to 1.0 so don't trust anything above that.
+ */
+static inline boolean
+lp_rast_hiz_occluded_16(const struct lp_rast_shader_inputs *inputs,
+                        int x, int y, float zmax)
+{
+   float ztri_min, ztri_max;
+
+   if (zmax == LP_HIZ_UNKNOWN)
+      return FALSE;
+
+   lp_rast_hiz_range_16(inputs, x, y, &ztri_min, &ztri_max);
+
+   return MIN2(ztri_min, 1.0f) >= zmax + LP_HIZ_EPSILON;
+}
+
+
+/**
+ * Mask of the 16x16 blocks of the tile, in the bit order of the triangle
+ * rasterization functions, where the triangle is known to be occluded.
+ */
+static inline unsigned
+lp_rast_hiz_cull_mask(const struct lp_rasterizer_task *task,
+                      const struct lp_rast_shader_inputs *inputs)
+{
+   unsigned mask = 0;
+   unsigned i;
+
+   if (!task->hiz_test)
+      return 0;
+
+   for (i = 0; i < 16; i++) {
+      const unsigned ix = i & 3, iy = i >> 2;
+      if (lp_rast_hiz_occluded_16(inputs,
+                                  task->x + ix * 16, task->y + iy * 16,
+                                  task->hiz_zmax[iy][ix]))
+         mask |= 1 << i;
+   }
+
+   return mask;
+}
+
+
+/**
+ * As above, for the 16x16 pixels of a small triangle at (x, y), in window
+ * coords, which need not be aligned to the coarse depth blocks.
+ */
+static inline boolean
+lp_rast_hiz_cull_16(const struct lp_rasterizer_task *task,
+                    const struct lp_rast_shader_inputs *inputs,
+                    int x, int y)
+{
+   const unsigned ix0 = (x - task->x) / 16, iy0 = (y - task->y) / 16;
+   const unsigned ix1 = MIN2((x - task->x + 15) / 16, TILE_SIZE / 16 - 1);
+   const unsigned iy1 = MIN2((y - task->y + 15) / 16, TILE_SIZE / 16 - 1);
+   float zmax;
+
+   if (!task->hiz_test)
+      return FALSE;
+
+   zmax = MAX2(MAX2(task->hiz_zmax[iy0][ix0], task->hiz_zmax[iy0][ix1]),
+               MAX2(task->hiz_zmax[iy1][ix0], task->hiz_zmax[iy1][ix1]));
+
+   return lp_rast_hiz_occluded_16(inputs, x, y, zmax);
+}
+
+
+/**
+ * Lower the coarse depth of 16x16 block (ix, iy) of the tile after the
+ * triangle was drawn over all of it.
+ */
+static inline void
+lp_rast_hiz_update(struct lp_rasterizer_task *task,
+                   const struct lp_rast_shader_inputs *inputs,
+                   unsigned ix, unsigned iy)
+{
+   float ztri_min, ztri_max;
+
+   lp_rast_hiz_range_16(inputs, task->x + ix * 16, task->y + iy * 16,
+                        &ztri_min, &ztri_max);
+
+   ztri_max = MAX2(ztri_max, 0.0f) + LP_HIZ_EPSILON;
+   if (ztri_max < task->hiz_zmax[iy][ix])
+      task->hiz_zmax[iy][ix] = ztri_max;
+}
+
+
 /**
  * Shade all pixels in a 4x4 block.  The fragment code omits the
  * triangle in/out tests.
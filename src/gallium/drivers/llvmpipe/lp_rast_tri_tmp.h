@@ -284,6 +284,16 @@ TAG(lp_rast_triangle)(struct lp_rasterizer_task *task,
 
    LP_COUNT_ADD(nr_empty_16, util_bitcount(0xffff & ~(partial_mask | inmask)));
 
+   /* Drop the blocks where the triangle is occluded:
+    */
+   if (partial_mask | inmask) {
+      unsigned cull_mask = lp_rast_hiz_cull_mask(task, &tri->inputs);
+      LP_COUNT_ADD(nr_hiz_culled_16,
+                   util_bitcount((partial_mask | inmask) & cull_mask));
+      partial_mask &= ~cull_mask;
+      inmask &= ~cull_mask;
+   }
+
    /* Iterate over partials:
     */
    while (partial_mask) {
@@ -318,6 +328,9 @@ TAG(lp_rast_triangle)(struct lp_rasterizer_task *task,
 
       LP_COUNT(nr_fully_covered_16);
       block_full_16(task, tri, px, py);
+
+      if (task->hiz_write)
+         lp_rast_hiz_update(task, &tri->inputs, i & 3, i >> 2);
    }
 }
 
@@ -345,6 +358,11 @@ TRI_16(struct lp_rasterizer_task *task,
    x += task->x;
    y += task->y;
 
+   if (lp_rast_hiz_cull_16(task, &tri->inputs, x, y)) {
+      LP_COUNT(nr_hiz_culled_16);
+      return;
+   }
+
    for (j = 0; j < NR_PLANES; j++) {
       const int dcdx = -plane[j].dcdx * 4;
       const int dcdy = plane[j].dcdy * 4;
@@ -34,6 +34,7 @@
 #include "lp_scene.h"
 #include "lp_fence.h"
 #include "lp_debug.h"
+#include "lp_perf.h"
 
 
 #define RESOURCE_REF_SZ 32
@@ -63,6 +64,7 @@ lp_scene_create( struct pipe_context *pipe )
       CALLOC_STRUCT(data_block);
 
    (void) mtx_init(&scene->mutex, mtx_plain);
+   util_queue_fence_init(&scene->idle);
 
 #ifdef DEBUG
    /* Do some scene limit sanity checks here */
@@ -90,6 +92,7 @@ void
 lp_scene_destroy(struct lp_scene *scene)
 {
    lp_fence_reference(&scene->fence, NULL);
+   util_queue_fence_destroy(&scene->idle);
    mtx_destroy(&scene->mutex);
    assert(scene->data.head->next == NULL);
    FREE(scene->data.head);
@@ -139,6 +142,8 @@ lp_scene_bin_reset(struct lp_scene *scene, unsigned x, unsigned y)
 
    bin->last_state = NULL;
    bin->head = bin->tail;
+   bin->num_blocks = bin->tail ? 1 : 0;
+   bin->reset = TRUE;
    if (bin->tail) {
       bin->tail->next = NULL;
       bin->tail->count = 0;
@@ -146,6 +151,124 @@ lp_scene_bin_reset(struct lp_scene *scene, unsigned x, unsigned y)
 }
 
 
+/**
+ * Prepare \p bins for binning part of a vertex batch destined for \p scene
+ * on another thread.  \p bins is a scene of its own which is never
+ * rasterized: once binning is done its commands and data are handed over
+ * to \p scene by lp_scene_merge_bins(), or dropped by lp_scene_discard_bins().
+ */
+void
+lp_scene_begin_thread_bins(struct lp_scene *bins,
+                           const struct lp_scene *scene)
+{
+   assert(bins->data.head->next == NULL);
+
+   bins->tiles_x = scene->tiles_x;
+   bins->tiles_y = scene->tiles_y;
+   bins->fb_max_layer = scene->fb_max_layer;
+   bins->had_queries = scene->had_queries;
+   /* Only looked at by the setup code, no reference needed */
+   bins->fb.zsbuf = scene->fb.zsbuf;
+   bins->scene_size = 0;
+   bins->alloc_failed = FALSE;
+
+   /* The first data block stays with the bins, so keep it full and
+    * allocate everything from blocks which can be handed over.
+    */
+   bins->data.head->used = DATA_BLOCK_SIZE;
+}
+
+
+static void
+lp_scene_clear_bins(struct lp_scene *bins)
+{
+   unsigned i, j;
+
+   for (i = 0; i < bins->tiles_x; i++) {
+      for (j = 0; j < bins->tiles_y; j++) {
+         struct cmd_bin *bin = lp_scene_get_bin(bins, i, j);
+         bin->head = NULL;
+         bin->tail = NULL;
+         bin->last_state = NULL;
+         bin->num_blocks = 0;
+         bin->reset = FALSE;
+      }
+   }
+
+   bins->fb.zsbuf = NULL;
+   bins->scene_size = 0;
+}
+
+
+/**
+ * Append the commands of each of the \p bins to the matching bin of
+ * \p scene, and move the data blocks they live in over to \p scene.
+ * Bins which were reset in \p bins drop the earlier commands of \p scene,
+ * as they would have had the triangles been binned into \p scene directly.
+ */
+void
+lp_scene_merge_bins(struct lp_scene *scene, struct lp_scene *bins)
+{
+   struct data_block *block;
+   unsigned i, j;
+
+   for (i = 0; i < bins->tiles_x; i++) {
+      for (j = 0; j < bins->tiles_y; j++) {
+         struct cmd_bin *src = lp_scene_get_bin(bins, i, j);
+         struct cmd_bin *dst;
+
+         if (!src->head)
+            continue;
+
+         if (src->reset)
+            lp_scene_bin_reset(scene, i, j);
+
+         dst = lp_scene_get_bin(scene, i, j);
+         if (dst->tail)
+            dst->tail->next = src->head;
+         else
+            dst->head = src->head;
+         dst->tail = src->tail;
+         dst->num_blocks += src->num_blocks;
+         if (src->last_state)
+            dst->last_state = src->last_state;
+      }
+   }
+
+   /* Insert behind the current block of the scene, which is the one
+    * still being allocated from.
+    */
+   for (block = bins->data.head; block->next; ) {
+      struct data_block *next = block->next;
+      block->next = scene->data.head->next;
+      scene->data.head->next = block;
+      block = next;
+   }
+   bins->data.head = block;
+   scene->scene_size += bins->scene_size;
+
+   lp_scene_clear_bins(bins);
+}
+
+
+/**
+ * Throw away everything binned into \p bins.
+ */
+void
+lp_scene_discard_bins(struct lp_scene *bins)
+{
+   struct data_block *block, *tmp;
+
+   for (block = bins->data.head; block->next; block = tmp) {
+      tmp = block->next;
+      FREE(block);
+   }
+   bins->data.head = block;
+
+   lp_scene_clear_bins(bins);
+}
+
+
 void
 lp_scene_begin_rasterization(struct lp_scene *scene)
 {
@@ -241,6 +364,9 @@ lp_scene_end_rasterization(struct lp_scene *scene )
          bin->head = NULL;
          bin->tail = NULL;
          bin->last_state = NULL;
+         bin->num_blocks = 0;
+         bin->heavy = FALSE;
+         bin->reset = FALSE;
       }
    }
 
@@ -322,6 +448,7 @@ lp_scene_new_cmd_block( struct lp_scene *scene,
       //memset(block, 0, sizeof *block);
       block->next = NULL;
       block->count = 0;
+      bin->num_blocks++;
    }
    return block;
 }
@@ -449,33 +576,114 @@ lp_scene_is_resource_referenced(const struct lp_scene *scene,
 
 
 
-/** advance curr_x,y to the next bin */
+/**
+ * Map a bin iteration index to bin coordinates.  Returns FALSE for indices
+ * of partially covered groups that fall outside the framebuffer.
+ */
 static boolean
-next_bin(struct lp_scene *scene)
+bin_from_index(const struct lp_scene *scene, unsigned index, int *x, int *y)
+{
+   const unsigned order = scene->group_order;
+   const unsigned group = index >> (2 * order);
+   const unsigned within = index & ((1 << (2 * order)) - 1);
+
+   *x = ((group % scene->groups_x) << order) + (within & ((1 << order) - 1));
+   *y = ((group / scene->groups_x) << order) + (within >> order);
+
+   return *x < scene->tiles_x && *y < scene->tiles_y;
+}
+
+
+/* A bin counts as heavy when it has this many times more command blocks
+ * than the average non-empty bin.
+ */
+#define HEAVY_BIN_FACTOR 4
+
+/**
+ * Collect the most expensive bins, sorted by decreasing cost, into
+ * lp_scene::heavy_bins.
+ */
+static void
+find_heavy_bins(struct lp_scene *scene)
 {
-   scene->curr_x++;
-   if (scene->curr_x >= scene->tiles_x) {
-      scene->curr_x = 0;
-      scene->curr_y++;
+   unsigned total_blocks = 0, num_bins = 0;
+   unsigned x, y, i, threshold;
+
+   scene->num_heavy_bins = 0;
+
+   if (scene->num_threads <= 1)
+      return;
+
+   for (y = 0; y < scene->tiles_y; y++) {
+      for (x = 0; x < scene->tiles_x; x++) {
+         const struct cmd_bin *bin = lp_scene_get_bin(scene, x, y);
+         if (bin->num_blocks) {
+            total_blocks += bin->num_blocks;
+            num_bins++;
+         }
+      }
    }
-   if (scene->curr_y >= scene->tiles_y) {
-      /* no more bins */
-      return FALSE;
+
+   if (num_bins <= scene->num_threads)
+      return;
+
+   threshold = MAX2(HEAVY_BIN_FACTOR * total_blocks / num_bins, 2);
+
+   for (y = 0; y < scene->tiles_y; y++) {
+      for (x = 0; x < scene->tiles_x; x++) {
+         const struct cmd_bin *bin = lp_scene_get_bin(scene, x, y);
+         const struct cmd_bin *last;
+
+         if (bin->num_blocks < threshold)
+            continue;
+
+         /* Insertion sort, dropping the cheapest bin once the list is full. */
+         i = scene->num_heavy_bins;
+         if (i == LP_MAX_HEAVY_BINS) {
+            last = lp_scene_get_bin(scene, scene->heavy_bins[i - 1].x,
+                                    scene->heavy_bins[i - 1].y);
+            if (last->num_blocks >= bin->num_blocks)
+               continue;
+            i--;
+         }
+         else {
+            scene->num_heavy_bins++;
+         }
+
+         while (i > 0) {
+            last = lp_scene_get_bin(scene, scene->heavy_bins[i - 1].x,
+                                    scene->heavy_bins[i - 1].y);
+            if (last->num_blocks >= bin->num_blocks)
+               break;
+            scene->heavy_bins[i] = scene->heavy_bins[i - 1];
+            i--;
+         }
+         scene->heavy_bins[i].x = x;
+         scene->heavy_bins[i].y = y;
+      }
    }
-   return TRUE;
+
+   for (i = 0; i < scene->num_heavy_bins; i++) {
+      lp_scene_get_bin(scene, scene->heavy_bins[i].x,
+                       scene->heavy_bins[i].y)->heavy = TRUE;
+   }
+
+   LP_COUNT_ADD(nr_heavy_bins, scene->num_heavy_bins);
 }
 
 
 void
 lp_scene_bin_iter_begin( struct lp_scene *scene )
 {
-   scene->curr_x = scene->curr_y = -1;
+   find_heavy_bins(scene);
+   scene->curr_heavy_bin = 0;
+   scene->curr_bin = -1;
 }
 
 
 /**
  * Return pointer to next bin to be rendered.
- * The lp_scene::curr_x and ::curr_y fields will be advanced.
+ * The lp_scene::curr_bin field will be advanced.
  * Multiple rendering threads will call this function to get a chunk
  * of work (a bin) to work on.
  */
@@ -486,19 +694,22 @@ lp_scene_bin_iter_next( struct lp_scene *scene , int *x, int *y)
 
    mtx_lock(&scene->mutex);
 
-   if (scene->curr_x < 0) {
-      /* first bin */
-      scene->curr_x = 0;
-      scene->curr_y = 0;
-   }
-   else if (!next_bin(scene)) {
-      /* no more bins left */
+   if (scene->curr_heavy_bin < scene->num_heavy_bins) {
+      *x = scene->heavy_bins[scene->curr_heavy_bin].x;
+      *y = scene->heavy_bins[scene->curr_heavy_bin].y;
+      scene->curr_heavy_bin++;
+      bin = lp_scene_get_bin(scene, *x, *y);
       goto end;
    }
 
-   bin = lp_scene_get_bin(scene, scene->curr_x, scene->curr_y);
-   *x = scene->curr_x;
-   *y = scene->curr_y;
+   while (++scene->curr_bin < (int)scene->num_bin_indices) {
+      if (bin_from_index(scene, scene->curr_bin, x, y)) {
+         bin = lp_scene_get_bin(scene, *x, *y);
+         if (!bin->heavy)
+            break;
+         bin = NULL;
+      }
+   }
 
 end:
    /*printf("return bin %p at %d, %d\n", (void *) bin, *bin_x, *bin_y);*/
@@ -508,7 +719,8 @@ end:
 
 
 void lp_scene_begin_binning(struct lp_scene *scene,
-                            struct pipe_framebuffer_state *fb)
+                            struct pipe_framebuffer_state *fb,
+                            unsigned num_threads)
 {
    int i;
    unsigned max_layer = ~0;
@@ -522,6 +734,24 @@ void lp_scene_begin_binning(struct lp_scene *scene,
    assert(scene->tiles_x <= TILES_X);
    assert(scene->tiles_y <= TILES_Y);
 
+   /* Hand out bins in square groups holding about one tile per rasterizer
+    * thread.  The tiles being worked on at any time then cover a compact
+    * region of the framebuffer rather than a long strip of a row, so that
+    * neighbouring tiles share texture and framebuffer data in the caches.
+    */
+   scene->num_threads = num_threads;
+   scene->group_order = 0;
+   while ((1u << (2 * scene->group_order)) < num_threads &&
+          (2u << scene->group_order) <= MIN2(scene->tiles_x, scene->tiles_y))
+      scene->group_order++;
+
+   scene->groups_x = align(scene->tiles_x, 1 << scene->group_order) >>
+                     scene->group_order;
+   scene->num_bin_indices = scene->groups_x *
+                            (align(scene->tiles_y, 1 << scene->group_order) >>
+                             scene->group_order) <<
+                            (2 * scene->group_order);
+
    /*
     * Determine how many layers the fb has (used for clamping layer value).
     * OpenGL (but not d3d10) permits different amount of layers per rt, however
@@ -36,6 +36,7 @@
 #define LP_SCENE_H
 
 #include "os/os_thread.h"
+#include "util/u_queue.h"
 #include "lp_rast.h"
 #include "lp_debug.h"
 
@@ -58,6 +59,11 @@ struct lp_rast_state;
  */
 #define DATA_BLOCK_SIZE (64 * 1024)
 
+/* Max number of bins handed out ahead of the others because they are much
+ * costlier than the average bin.
+ */
+#define LP_MAX_HEAVY_BINS 32
+
 /* Scene temporary storage is clamped to this size:
  */
 #define LP_SCENE_MAX_SIZE (9*1024*1024)
@@ -97,6 +103,9 @@ struct cmd_bin {
    const struct lp_rast_state *last_state;       /* most recent state set in bin */
    struct cmd_block *head;
    struct cmd_block *tail;
+   unsigned num_blocks;   /* rough measure of the cost of the bin */
+   boolean heavy;         /* in lp_scene::heavy_bins */
+   boolean reset;         /* lp_scene_bin_reset() called, see lp_scene_merge_bins() */
 };
    
 
@@ -129,6 +138,11 @@ struct lp_scene {
    struct pipe_context *pipe;
    struct lp_fence *fence;
 
+   /** Reset while the scene is queued for rasterization, signalled once
+    * the rasterizer is done with it and it can be binned into again.
+    */
+   struct util_queue_fence idle;
+
    /* The queries still active at end of scene */
    struct llvmpipe_query *active_queries[LP_MAX_ACTIVE_BINNED_QUERIES];
    unsigned num_active_queries;
@@ -172,7 +186,27 @@ struct lp_scene {
     */
    unsigned tiles_x, tiles_y;
 
-   int curr_x, curr_y;  /**< for iterating over bins */
+   /**
+    * Bins are handed out in square groups of 2^group_order tiles on a
+    * side, see lp_scene_begin_binning().
+    */
+   unsigned group_order;
+   unsigned groups_x;
+   unsigned num_bin_indices;
+
+   int curr_bin;  /**< for iterating over bins */
+
+   /**
+    * Bins with many more commands than average.  These are rasterized
+    * first, most expensive first, so that a single heavy tile doesn't end
+    * up being processed alone while the other threads are idle.
+    */
+   struct {
+      unsigned x, y;
+   } heavy_bins[LP_MAX_HEAVY_BINS];
+   unsigned num_heavy_bins;
+   unsigned curr_heavy_bin;
+   unsigned num_threads;
    mtx_t mutex;
 
    struct cmd_bin tile[TILES_X][TILES_Y];
@@ -292,6 +326,16 @@ lp_scene_get_bin(struct lp_scene *scene, unsigned x, unsigned y)
 void
 lp_scene_bin_reset(struct lp_scene *scene, unsigned x, unsigned y);
 
+void
+lp_scene_begin_thread_bins(struct lp_scene *bins,
+                           const struct lp_scene *scene);
+
+void
+lp_scene_merge_bins(struct lp_scene *scene, struct lp_scene *bins);
+
+void
+lp_scene_discard_bins(struct lp_scene *bins);
+
 
 /* Add a command to bin[x][y].
  */
@@ -389,7 +433,8 @@ lp_scene_bin_iter_next( struct lp_scene *scene, int *x, int *y );
  */
 void
 lp_scene_begin_binning(struct lp_scene *scene,
-                       struct pipe_framebuffer_state *fb);
+                       struct pipe_framebuffer_state *fb,
+                       unsigned num_threads);
 
 void
 lp_scene_end_binning(struct lp_scene *scene);
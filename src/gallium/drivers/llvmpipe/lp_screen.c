@@ -32,10 +32,12 @@
 #include "util/u_format.h"
 #include "util/u_string.h"
 #include "util/u_format_s3tc.h"
+#include "util/disk_cache.h"
 #include "pipe/p_defines.h"
 #include "pipe/p_screen.h"
 #include "draw/draw_context.h"
 #include "gallivm/lp_bld_type.h"
+#include "gallivm/lp_bld_init.h"
 
 #include "os/os_misc.h"
 #include "util/os_time.h"
@@ -48,6 +50,7 @@
 #include "lp_public.h"
 #include "lp_limits.h"
 #include "lp_rast.h"
+#include "lp_query.h"
 
 #include "state_tracker/sw_winsys.h"
 
@@ -81,6 +84,7 @@ static const struct debug_named_value lp_perf_flags[] = {
    { "no_blend",       PERF_NO_BLEND, NULL },
    { "no_depth",       PERF_NO_DEPTH, NULL },
    { "no_alphatest",   PERF_NO_ALPHATEST, NULL },
+   { "no_hiz",         PERF_NO_HIZ, NULL },
    DEBUG_NAMED_VALUE_END
 };
 
@@ -306,8 +310,9 @@ llvmpipe_get_param(struct pipe_screen *screen, enum pipe_cap param)
       return 1;
    case PIPE_CAP_CLEAR_TEXTURE:
       return 1;
-   case PIPE_CAP_MULTISAMPLE_Z_RESOLVE:
    case PIPE_CAP_RESOURCE_FROM_USER_MEMORY:
+      return 1;
+   case PIPE_CAP_MULTISAMPLE_Z_RESOLVE:
    case PIPE_CAP_DEVICE_RESET_STATUS_QUERY:
    case PIPE_CAP_MAX_SHADER_PATCH_VARYINGS:
    case PIPE_CAP_DEPTH_BOUNDS_TEST:
@@ -586,6 +591,11 @@ llvmpipe_destroy_screen( struct pipe_screen *_screen )
 
    lp_jit_screen_cleanup(screen);
 
+   if (util_queue_is_initialized(&screen->compile_queue))
+      util_queue_destroy(&screen->compile_queue);
+
+   disk_cache_destroy(screen->disk_shader_cache);
+
    if(winsys->destroy)
       winsys->destroy(winsys);
 
@@ -597,6 +607,80 @@ llvmpipe_destroy_screen( struct pipe_screen *_screen )
 
 
 
+/**
+ * The cache is tied to both the llvmpipe build and the LLVM library, as
+ * either changes the code generated for the same IR.
+ */
+static void
+lp_disk_cache_create(struct llvmpipe_screen *screen)
+{
+   uint32_t mesa_timestamp, llvm_timestamp;
+   char timestamp_str[2 * 10 + 2];
+
+   if (!disk_cache_get_function_timestamp(lp_disk_cache_create,
+                                          &mesa_timestamp) ||
+       !disk_cache_get_function_timestamp(LLVMLinkInMCJIT,
+                                          &llvm_timestamp))
+      return;
+
+   util_snprintf(timestamp_str, sizeof timestamp_str, "%u_%u",
+                 mesa_timestamp, llvm_timestamp);
+
+   screen->disk_shader_cache = disk_cache_create("llvmpipe", timestamp_str, 0);
+}
+
+
+/**
+ * Look up the object code for the module with the given IR key
+ * (see gallivm_get_ir_cache_key()).  On a hit, cache->data is set to a
+ * malloc'ed copy of the object, to be freed by the caller.
+ */
+void
+lp_disk_cache_find_shader(struct llvmpipe_screen *screen,
+                          struct lp_cached_code *cache,
+                          unsigned char ir_sha1_cache_key[20])
+{
+   cache_key sha1;
+   size_t binary_size;
+   void *buffer;
+
+   if (!screen->disk_shader_cache)
+      return;
+
+   disk_cache_compute_key(screen->disk_shader_cache, ir_sha1_cache_key, 20,
+                          sha1);
+
+   buffer = disk_cache_get(screen->disk_shader_cache, sha1, &binary_size);
+   if (!buffer) {
+      cache->data_size = 0;
+      return;
+   }
+
+   cache->data = buffer;
+   cache->data_size = binary_size;
+}
+
+
+/**
+ * Store the object code the module with the given IR key was compiled to.
+ */
+void
+lp_disk_cache_insert_shader(struct llvmpipe_screen *screen,
+                            struct lp_cached_code *cache,
+                            unsigned char ir_sha1_cache_key[20])
+{
+   cache_key sha1;
+
+   if (!screen->disk_shader_cache || !cache->data_size || cache->dont_cache)
+      return;
+
+   disk_cache_compute_key(screen->disk_shader_cache, ir_sha1_cache_key, 20,
+                          sha1);
+   disk_cache_put(screen->disk_shader_cache, sha1, cache->data,
+                  cache->data_size, NULL);
+}
+
+
 /**
  * Fence reference counting.
  */
@@ -642,6 +726,21 @@ llvmpipe_get_timestamp(struct pipe_screen *_screen)
  */
 struct pipe_screen *
 llvmpipe_create_screen(struct sw_winsys *winsys)
+{
+   return llvmpipe_create_screen_with_threads(winsys, -1, false);
+}
+
+
+/**
+ * Like llvmpipe_create_screen(), with the rasterizer threads chosen by the
+ * caller instead of LP_NUM_THREADS: num_threads is the number of threads
+ * to create (0 renders in the calling thread, negative picks the default)
+ * and pin_threads pins each of them to its own CPU.
+ */
+struct pipe_screen *
+llvmpipe_create_screen_with_threads(struct sw_winsys *winsys,
+                                    int num_threads,
+                                    bool pin_threads)
 {
    struct llvmpipe_screen *screen;
 
@@ -680,6 +779,7 @@ llvmpipe_create_screen(struct sw_winsys *winsys)
    screen->base.fence_finish = llvmpipe_fence_finish;
 
    screen->base.get_timestamp = llvmpipe_get_timestamp;
+   screen->base.get_driver_query_info = llvmpipe_get_driver_query_info;
 
    llvmpipe_init_screen_resource_funcs(&screen->base);
 
@@ -687,10 +787,15 @@ llvmpipe_create_screen(struct sw_winsys *winsys)
 #ifdef PIPE_SUBSYSTEM_EMBEDDED
    screen->num_threads = 0;
 #endif
-   screen->num_threads = debug_get_num_option("LP_NUM_THREADS", screen->num_threads);
+   if (num_threads >= 0)
+      screen->num_threads = num_threads;
+   else
+      screen->num_threads = debug_get_num_option("LP_NUM_THREADS", screen->num_threads);
    screen->num_threads = MIN2(screen->num_threads, LP_MAX_THREADS);
 
-   screen->rast = lp_rast_create(screen->num_threads);
+   pin_threads |= debug_get_bool_option("LP_PIN_THREADS", FALSE);
+
+   screen->rast = lp_rast_create(screen->num_threads, pin_threads);
    if (!screen->rast) {
       lp_jit_screen_cleanup(screen);
       FREE(screen);
@@ -698,5 +803,15 @@ llvmpipe_create_screen(struct sw_winsys *winsys)
    }
    (void) mtx_init(&screen->rast_mutex, mtx_plain);
 
+   lp_disk_cache_create(screen);
+
+   screen->async_compile = debug_get_bool_option("LP_ASYNC_COMPILE", FALSE);
+   if (screen->async_compile &&
+       !util_queue_init(&screen->compile_queue, "lpcomp", 32, 1,
+                        UTIL_QUEUE_INIT_RESIZE_IF_FULL))
+      screen->async_compile = FALSE;
+
+   screen->tiled_textures = debug_get_bool_option("LP_TILED_TEXTURES", FALSE);
+
    return &screen->base;
 }
@@ -37,6 +37,7 @@
 #include "pipe/p_screen.h"
 #include "pipe/p_defines.h"
 #include "os/os_thread.h"
+#include "util/u_queue.h"
 #include "gallivm/lp_bld.h"
 
 
@@ -57,6 +58,16 @@ struct llvmpipe_screen
 
    struct lp_rasterizer *rast;
    mtx_t rast_mutex;
+
+   /** Cache of the machine code of the shader variants, may be NULL */
+   struct disk_cache *disk_shader_cache;
+
+   /** Background compilation of fragment shader variants */
+   boolean async_compile;
+   struct util_queue compile_queue;
+
+   /** Store sampled-only textures in the tiled layout */
+   boolean tiled_textures;
 };
 
 
@@ -69,5 +80,18 @@ llvmpipe_screen( struct pipe_screen *pipe )
 }
 
 
+struct lp_cached_code;
+
+void
+lp_disk_cache_find_shader(struct llvmpipe_screen *screen,
+                          struct lp_cached_code *cache,
+                          unsigned char ir_sha1_cache_key[20]);
+
+void
+lp_disk_cache_insert_shader(struct llvmpipe_screen *screen,
+                            struct lp_cached_code *cache,
+                            unsigned char ir_sha1_cache_key[20]);
+
+
 
 #endif /* LP_SCREEN_H */
@@ -64,25 +64,38 @@ static boolean set_scene_state( struct lp_setup_context *, enum setup_state,
 static boolean try_update_scene_state( struct lp_setup_context *setup );
 
 
+/**
+ * Wait until the rasterizer is done with scene \p idx.
+ */
+static void
+lp_setup_wait_scene(struct lp_setup_context *setup, unsigned idx)
+{
+   struct lp_scene *scene = setup->scenes[idx];
+
+   if (!util_queue_fence_is_signalled(&scene->idle)) {
+      if (LP_DEBUG & DEBUG_SETUP)
+         debug_printf("%s: wait for scene %u\n", __FUNCTION__, idx);
+
+      util_queue_fence_wait(&scene->idle);
+   }
+
+   setup->queued_size[idx] = 0;
+}
+
+
 static void
 lp_setup_get_empty_scene(struct lp_setup_context *setup)
 {
    assert(setup->scene == NULL);
 
    setup->scene_idx++;
-   setup->scene_idx %= ARRAY_SIZE(setup->scenes);
+   setup->scene_idx %= setup->num_scenes;
 
-   setup->scene = setup->scenes[setup->scene_idx];
-
-   if (setup->scene->fence) {
-      if (LP_DEBUG & DEBUG_SETUP)
-         debug_printf("%s: wait for scene %d\n",
-                      __FUNCTION__, setup->scene->fence->id);
+   lp_setup_wait_scene(setup, setup->scene_idx);
 
-      lp_fence_wait(setup->scene->fence);
-   }
+   setup->scene = setup->scenes[setup->scene_idx];
 
-   lp_scene_begin_binning(setup->scene, &setup->fb);
+   lp_scene_begin_binning(setup->scene, &setup->fb, setup->num_threads);
 
 }
 
@@ -153,6 +166,8 @@ lp_setup_rasterize_scene( struct lp_setup_context *setup )
 {
    struct lp_scene *scene = setup->scene;
    struct llvmpipe_screen *screen = llvmpipe_screen(scene->pipe->screen);
+   uint64_t queued_size;
+   unsigned i;
 
    scene->num_active_queries = setup->active_binned_queries;
    memcpy(scene->active_queries, setup->active_queries,
@@ -165,25 +180,38 @@ lp_setup_rasterize_scene( struct lp_setup_context *setup )
    if (setup->last_fence)
       setup->last_fence->issued = TRUE;
 
-   mtx_lock(&screen->rast_mutex);
+   setup->queued_size[setup->scene_idx] = scene->scene_size;
+   util_queue_fence_reset(&scene->idle);
 
-   /* FIXME: We enqueue the scene then wait on the rasterizer to finish.
-    * This means we never actually run any vertex stuff in parallel to
-    * rasterization (not in the same context at least) which is what the
-    * multiple scenes per setup is about - when we get a new empty scene
-    * any old one is already empty again because we waited here for
-    * raster tasks to be finished. Ideally, we shouldn't need to wait here
-    * and rely on fences elsewhere when waiting is necessary.
-    * Certainly, lp_scene_end_rasterization() would need to be deferred too
-    * and there's probably other bits why this doesn't actually work.
+   /* We don't wait for the rasterizer here: the scene is released by the
+    * rasterizer (see lp_rast_end) and only waited for when setup needs it
+    * again, so that binning of the next scenes overlaps rasterization.
+    * Anything needing the results waits on the scene fence instead.
     */
+   mtx_lock(&screen->rast_mutex);
    lp_rast_queue_scene(screen->rast, scene);
-   lp_rast_finish(screen->rast);
    mtx_unlock(&screen->rast_mutex);
 
-   lp_scene_end_rasterization(setup->scene);
    lp_setup_reset( setup );
 
+   /* Bound the memory held by queued scenes, oldest waited for first.
+    * This always terminates at the scene just queued.
+    */
+   i = setup->scene_idx;
+   for (;;) {
+      unsigned j;
+
+      queued_size = 0;
+      for (j = 0; j < setup->num_scenes; j++)
+         queued_size += setup->queued_size[j];
+
+      if (queued_size <= setup->scene_budget)
+         break;
+
+      i = (i + 1) % setup->num_scenes;
+      lp_setup_wait_scene(setup, i);
+   }
+
    LP_DBG(DEBUG_SETUP, "%s done \n", __FUNCTION__);
 }
 
@@ -984,8 +1012,17 @@ lp_setup_is_resource_referenced( const struct lp_setup_context *setup,
    }
 
    /* check textures referenced by the scene */
-   for (i = 0; i < ARRAY_SIZE(setup->scenes); i++) {
-      if (lp_scene_is_resource_referenced(setup->scenes[i], texture)) {
+   for (i = 0; i < setup->num_scenes; i++) {
+      struct lp_scene *scene = setup->scenes[i];
+
+      /* The resource list and framebuffer of a queued scene belong to the
+       * rasterizer threads, so assume the worst until it is idle again.
+       */
+      if (!util_queue_fence_is_signalled(&scene->idle)) {
+         return LP_REFERENCED_FOR_READ | LP_REFERENCED_FOR_WRITE;
+      }
+
+      if (lp_scene_is_resource_referenced(scene, texture)) {
          return LP_REFERENCED_FOR_READ;
       }
    }
@@ -1266,6 +1303,61 @@ lp_setup_update_state( struct lp_setup_context *setup,
 
 
 
+static void
+lp_setup_destroy_bin_threads(struct lp_setup_context *setup)
+{
+   unsigned i;
+
+   if (util_queue_is_initialized(&setup->bin_queue))
+      util_queue_destroy(&setup->bin_queue);
+
+   for (i = 0; i < LP_MAX_BIN_THREADS; i++) {
+      struct lp_bin_job *job = &setup->bin_jobs[i];
+      if (job->bins) {
+         util_queue_fence_destroy(&job->fence);
+         lp_scene_destroy(job->bins);
+         job->bins = NULL;
+      }
+   }
+
+   setup->num_bin_threads = 0;
+}
+
+
+/**
+ * Create the private bins and the helper threads for binning triangle
+ * batches in parallel, see lp_setup_vbuf.c.  Parallel binning is simply
+ * left disabled if anything fails.
+ */
+static void
+lp_setup_init_bin_threads(struct lp_setup_context *setup)
+{
+   unsigned i;
+
+   if (setup->num_bin_threads < 2) {
+      setup->num_bin_threads = 0;
+      return;
+   }
+
+   for (i = 0; i < setup->num_bin_threads; i++) {
+      struct lp_bin_job *job = &setup->bin_jobs[i];
+      job->bins = lp_scene_create(setup->pipe);
+      if (!job->bins) {
+         lp_setup_destroy_bin_threads(setup);
+         return;
+      }
+      job->setup = setup;
+      util_queue_fence_init(&job->fence);
+   }
+
+   /* The calling thread bins the first part of each batch itself */
+   if (!util_queue_init(&setup->bin_queue, "lpbin", LP_MAX_BIN_THREADS,
+                        setup->num_bin_threads - 1, 0)) {
+      lp_setup_destroy_bin_threads(setup);
+   }
+}
+
+
 /* Only caller is lp_setup_vbuf_destroy()
  */
 void 
@@ -1286,15 +1378,16 @@ lp_setup_destroy( struct lp_setup_context *setup )
    }
 
    /* free the scenes in the 'empty' queue */
-   for (i = 0; i < ARRAY_SIZE(setup->scenes); i++) {
+   for (i = 0; i < setup->num_scenes; i++) {
       struct lp_scene *scene = setup->scenes[i];
 
-      if (scene->fence)
-         lp_fence_wait(scene->fence);
+      util_queue_fence_wait(&scene->idle);
 
       lp_scene_destroy(scene);
    }
 
+   lp_setup_destroy_bin_threads(setup);
+
    lp_fence_reference(&setup->last_fence, NULL);
 
    FREE( setup );
@@ -1319,6 +1412,9 @@ lp_setup_create( struct pipe_context *pipe,
       goto no_setup;
    }
 
+   setup->num_bin_threads = MIN2(debug_get_num_option("LP_BIN_THREADS", 0),
+                                 LP_MAX_BIN_THREADS);
+
    lp_setup_init_vbuf(setup);
    
    /* Used only in update_state():
@@ -1336,13 +1432,22 @@ lp_setup_create( struct pipe_context *pipe,
    draw_set_render(draw, &setup->base);
 
    /* create some empty scenes */
-   for (i = 0; i < MAX_SCENES; i++) {
+   setup->num_scenes = debug_get_num_option("LP_NUM_SCENES",
+                                            LP_DEFAULT_NUM_SCENES);
+   setup->num_scenes = CLAMP(setup->num_scenes, 1, MAX_SCENES);
+   setup->scene_budget = (uint64_t)
+      debug_get_num_option("LP_SCENE_BUDGET", LP_DEFAULT_SCENE_BUDGET)
+      * 1024 * 1024;
+
+   for (i = 0; i < setup->num_scenes; i++) {
       setup->scenes[i] = lp_scene_create( pipe );
       if (!setup->scenes[i]) {
          goto no_scenes;
       }
    }
 
+   lp_setup_init_bin_threads(setup);
+
    setup->triangle = first_triangle;
    setup->line     = first_line;
    setup->point    = first_point;
@@ -1356,7 +1461,7 @@ lp_setup_create( struct pipe_context *pipe,
    return setup;
 
 no_scenes:
-   for (i = 0; i < MAX_SCENES; i++) {
+   for (i = 0; i < setup->num_scenes; i++) {
       if (setup->scenes[i]) {
          lp_scene_destroy(setup->scenes[i]);
       }
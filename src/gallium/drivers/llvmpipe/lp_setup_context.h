@@ -43,6 +43,7 @@
 #include "draw/draw_vbuf.h"
 #include "util/u_rect.h"
 #include "util/u_pack_color.h"
+#include "util/u_queue.h"
 
 #define LP_SETUP_NEW_FS          0x01
 #define LP_SETUP_NEW_CONSTANTS   0x02
@@ -54,9 +55,35 @@
 struct lp_setup_variant;
 
 
-/** Max number of scenes */
-/* XXX: make multiple scenes per context work, see lp_setup_rasterize_scene */
-#define MAX_SCENES 1
+/** Max number of scenes in flight per context, see LP_NUM_SCENES */
+#define MAX_SCENES 8
+
+/** Default number of scenes, and default memory budget (in MB) for the
+ * scenes queued for rasterization, see LP_SCENE_BUDGET.
+ */
+#define LP_DEFAULT_NUM_SCENES 2
+#define LP_DEFAULT_SCENE_BUDGET 64
+
+/** Max number of threads binning a vertex batch, see LP_BIN_THREADS */
+#define LP_MAX_BIN_THREADS 8
+
+/** Batches are only split up into parts of at least this many triangles */
+#define LP_MIN_BIN_TRIANGLES 64
+
+
+/**
+ * One part of a triangle batch binned on its own thread.
+ */
+struct lp_bin_job {
+   struct lp_setup_context *setup;
+   struct lp_scene *bins;         /**< thread private bins, see lp_scene.c */
+   const void *vertex_buffer;
+   const ushort *indices;         /**< NULL for non-indexed batches */
+   unsigned stride;
+   unsigned first, last;          /**< range of triangles to bin */
+   unsigned done;                 /**< first triangle not binned */
+   struct util_queue_fence fence;
+};
 
 
 
@@ -88,9 +115,18 @@ struct lp_setup_context
    struct draw_stage *vbuf;
    unsigned num_threads;
    unsigned scene_idx;
+   unsigned num_scenes;
    struct lp_scene *scenes[MAX_SCENES];  /**< all the scenes */
+   /** scene_size of each scene when it was queued, zero once idle again */
+   unsigned queued_size[MAX_SCENES];
+   uint64_t scene_budget;                /**< max bytes of queued scenes */
    struct lp_scene *scene;               /**< current scene being built */
 
+   /** Parallel binning of triangle batches, job 0 runs on the caller */
+   unsigned num_bin_threads;
+   struct util_queue bin_queue;
+   struct lp_bin_job bin_jobs[LP_MAX_BIN_THREADS];
+
    struct lp_fence *last_fence;
    struct llvmpipe_query *active_queries[LP_MAX_ACTIVE_BINNED_QUERIES];
    unsigned active_binned_queries;
@@ -216,10 +252,20 @@ lp_setup_alloc_triangle(struct lp_scene *scene,
 
 boolean
 lp_setup_bin_triangle(struct lp_setup_context *setup,
+                      struct lp_scene *scene,
                       struct lp_rast_triangle *tri,
                       const struct u_rect *bboxorig,
                       const struct u_rect *bbox,
                       int nr_planes,
                       unsigned scissor_index);
 
+unsigned
+lp_setup_bin_triangles(struct lp_setup_context *setup,
+                       struct lp_scene *scene,
+                       const void *vertex_buffer,
+                       unsigned stride,
+                       const ushort *indices,
+                       unsigned first,
+                       unsigned last);
+
 #endif
@@ -213,11 +213,10 @@ lp_rast_32_tri_tab[MAX_PLANES+1] = {
  */
 static boolean
 lp_setup_whole_tile(struct lp_setup_context *setup,
+                    struct lp_scene *scene,
                     const struct lp_rast_shader_inputs *inputs,
                     int tx, int ty)
 {
-   struct lp_scene *scene = setup->scene;
-
    LP_COUNT(nr_fully_covered_64);
 
    /* if variant is opaque and scissor doesn't effect the tile */
@@ -263,13 +262,13 @@ lp_setup_whole_tile(struct lp_setup_context *setup,
  */
 static boolean
 do_triangle_ccw(struct lp_setup_context *setup,
+                struct lp_scene *scene,
                 struct fixed_position* position,
                 const float (*v0)[4],
                 const float (*v1)[4],
                 const float (*v2)[4],
                 boolean frontfacing )
 {
-   struct lp_scene *scene = setup->scene;
    const struct lp_setup_variant_key *key = &setup->setup.variant->key;
    struct lp_rast_triangle *tri;
    struct lp_rast_plane *plane;
@@ -717,7 +716,8 @@ do_triangle_ccw(struct lp_setup_context *setup,
       assert(plane_s == &plane[nr_planes]);
    }
 
-   return lp_setup_bin_triangle(setup, tri, &bbox, &bboxpos, nr_planes, viewport_index);
+   return lp_setup_bin_triangle(setup, scene, tri, &bbox, &bboxpos, nr_planes,
+                                viewport_index);
 }
 
 /*
@@ -749,13 +749,13 @@ floor_pot(uint32_t n)
 
 boolean
 lp_setup_bin_triangle(struct lp_setup_context *setup,
+                      struct lp_scene *scene,
                       struct lp_rast_triangle *tri,
                       const struct u_rect *bboxorig,
                       const struct u_rect *bbox,
                       int nr_planes,
                       unsigned viewport_index)
 {
-   struct lp_scene *scene = setup->scene;
    struct u_rect trimmed_box = *bbox;   
    int i;
    /* What is the largest power-of-two boundary this triangle crosses:
@@ -947,7 +947,7 @@ lp_setup_bin_triangle(struct lp_setup_context *setup,
                /* triangle covers the whole tile- shade whole tile */
                LP_COUNT(nr_fully_covered_64);
                in = TRUE;
-               if (!lp_setup_whole_tile(setup, &tri->inputs, x, y))
+               if (!lp_setup_whole_tile(setup, scene, &tri->inputs, x, y))
                   goto fail;
             }
 
@@ -984,12 +984,12 @@ static void retry_triangle_ccw( struct lp_setup_context *setup,
                                 const float (*v2)[4],
                                 boolean front)
 {
-   if (!do_triangle_ccw( setup, position, v0, v1, v2, front ))
+   if (!do_triangle_ccw( setup, setup->scene, position, v0, v1, v2, front ))
    {
       if (!lp_setup_flush_and_restart(setup))
          return;
 
-      if (!do_triangle_ccw( setup, position, v0, v1, v2, front ))
+      if (!do_triangle_ccw( setup, setup->scene, position, v0, v1, v2, front ))
          return;
    }
 }
@@ -1118,6 +1118,93 @@ rotate_fixed_position_12( struct fixed_position* position )
 }
 
 
+/**
+ * Bin triangles [first, last) of a PIPE_PRIM_TRIANGLES vertex batch into
+ * \p scene, honoring the current culling state.  \p indices is NULL for
+ * non-indexed batches.
+ *
+ * Unlike the setup->triangle() functions this doesn't count statistics nor
+ * flush on failure, and only reads the setup state, so that several threads
+ * can bin parts of the same batch into scenes of their own.
+ *
+ * \return the first triangle which couldn't be binned because \p scene
+ * ran out of memory, or \p last.
+ */
+unsigned
+lp_setup_bin_triangles(struct lp_setup_context *setup,
+                       struct lp_scene *scene,
+                       const void *vertex_buffer,
+                       unsigned stride,
+                       const ushort *indices,
+                       unsigned first,
+                       unsigned last)
+{
+   const char *vb = (const char *)vertex_buffer;
+   boolean draw_ccw, draw_cw;
+   unsigned i;
+
+   if (setup->rasterizer_discard)
+      return last;
+
+   switch (setup->cullmode) {
+   case PIPE_FACE_NONE:
+      draw_ccw = draw_cw = TRUE;
+      break;
+   case PIPE_FACE_BACK:
+      draw_ccw = setup->ccw_is_frontface;
+      draw_cw = !draw_ccw;
+      break;
+   case PIPE_FACE_FRONT:
+      draw_ccw = !setup->ccw_is_frontface;
+      draw_cw = !draw_ccw;
+      break;
+   default:
+      return last;
+   }
+
+   for (i = first; i < last; i++) {
+      PIPE_ALIGN_VAR(16) struct fixed_position position;
+      const float (*v0)[4], (*v1)[4], (*v2)[4];
+      boolean ok = TRUE;
+
+      if (indices) {
+         v0 = (const float (*)[4])(vb + indices[3*i + 0] * stride);
+         v1 = (const float (*)[4])(vb + indices[3*i + 1] * stride);
+         v2 = (const float (*)[4])(vb + indices[3*i + 2] * stride);
+      }
+      else {
+         v0 = (const float (*)[4])(vb + (3*i + 0) * stride);
+         v1 = (const float (*)[4])(vb + (3*i + 1) * stride);
+         v2 = (const float (*)[4])(vb + (3*i + 2) * stride);
+      }
+
+      calc_fixed_position(setup, &position, v0, v1, v2);
+
+      if (position.area > 0) {
+         if (draw_ccw)
+            ok = do_triangle_ccw(setup, scene, &position, v0, v1, v2,
+                                 setup->ccw_is_frontface);
+      }
+      else if (position.area < 0 && draw_cw) {
+         if (setup->flatshade_first) {
+            rotate_fixed_position_12(&position);
+            ok = do_triangle_ccw(setup, scene, &position, v0, v2, v1,
+                                 !setup->ccw_is_frontface);
+         } else {
+            rotate_fixed_position_01(&position);
+            ok = do_triangle_ccw(setup, scene, &position, v1, v0, v2,
+                                 !setup->ccw_is_frontface);
+         }
+      }
+
+      if (!ok)
+         return i;
+   }
+
+   return last;
+}
+
+
 /**
  * Draw triangle if it's CW, cull otherwise.
  */
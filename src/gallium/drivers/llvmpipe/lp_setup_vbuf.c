@@ -129,6 +129,87 @@ static inline const_float4_ptr get_vert( const void *vertex_buffer,
    return (const_float4_ptr)((char *)vertex_buffer + index * stride);
 }
 
+static void
+lp_setup_bin_job(void *data, int thread_index)
+{
+   struct lp_bin_job *job = (struct lp_bin_job *) data;
+
+   job->done = lp_setup_bin_triangles(job->setup, job->bins,
+                                      job->vertex_buffer, job->stride,
+                                      job->indices, job->first, job->last);
+}
+
+
+/**
+ * Bin a PIPE_PRIM_TRIANGLES batch on several threads, if it's big enough.
+ *
+ * The batch is split into contiguous ranges of triangles, each binned into
+ * private bins by its own thread.  Merging the private bins into the scene
+ * in range order keeps the commands of every tile in submission order.
+ *
+ * \return the number of leading triangles binned, the caller takes care of
+ * the rest the usual way.  That's only ever non-zero if a thread ran out of
+ * memory, in which case the later ranges are thrown away too.
+ */
+static unsigned
+lp_setup_bin_triangles_mt(struct lp_setup_context *setup,
+                          const void *vertex_buffer,
+                          unsigned stride,
+                          const ushort *indices,
+                          unsigned nr_tris)
+{
+   struct llvmpipe_context *lp_context = (struct llvmpipe_context *)setup->pipe;
+   const unsigned num_jobs = MIN2(setup->num_bin_threads,
+                                  nr_tris / LP_MIN_BIN_TRIANGLES);
+   unsigned per_job, done = 0, i;
+   boolean complete = TRUE;
+
+   if (num_jobs < 2)
+      return 0;
+
+   per_job = DIV_ROUND_UP(nr_tris, num_jobs);
+
+   for (i = 0; i < num_jobs; i++) {
+      struct lp_bin_job *job = &setup->bin_jobs[i];
+
+      lp_scene_begin_thread_bins(job->bins, setup->scene);
+      job->vertex_buffer = vertex_buffer;
+      job->indices = indices;
+      job->stride = stride;
+      job->first = i * per_job;
+      job->last = MIN2(job->first + per_job, nr_tris);
+
+      if (i > 0)
+         util_queue_add_job(&setup->bin_queue, job, &job->fence,
+                            lp_setup_bin_job, NULL);
+   }
+
+   lp_setup_bin_job(&setup->bin_jobs[0], 0);
+
+   for (i = 0; i < num_jobs; i++) {
+      struct lp_bin_job *job = &setup->bin_jobs[i];
+
+      if (i > 0)
+         util_queue_fence_wait(&job->fence);
+
+      if (complete) {
+         lp_scene_merge_bins(setup->scene, job->bins);
+         done = job->done;
+         complete = job->done == job->last;
+      }
+      else {
+         lp_scene_discard_bins(job->bins);
+      }
+   }
+
+   if (lp_context->active_statistics_queries) {
+      lp_context->pipeline_statistics.c_primitives += done;
+   }
+
+   return done;
+}
+
+
 /**
  * draw elements / indexed primitives
  */
@@ -184,7 +265,9 @@ lp_setup_draw_elements(struct vbuf_render *vbr, const ushort *indices, uint nr)
       break;
 
    case PIPE_PRIM_TRIANGLES:
-      for (i = 2; i < nr; i += 3) {
+      i = 2 + 3 * lp_setup_bin_triangles_mt(setup, vertex_buffer, stride,
+                                            indices, nr / 3);
+      for (; i < nr; i += 3) {
          setup->triangle( setup,
                           get_vert(vertex_buffer, indices[i-2], stride),
                           get_vert(vertex_buffer, indices[i-1], stride),
@@ -382,7 +465,9 @@ lp_setup_draw_arrays(struct vbuf_render *vbr, uint start, uint nr)
       break;
 
    case PIPE_PRIM_TRIANGLES:
-      for (i = 2; i < nr; i += 3) {
+      i = 2 + 3 * lp_setup_bin_triangles_mt(setup, vertex_buffer, stride,
+                                            NULL, nr / 3);
+      for (; i < nr; i += 3) {
          setup->triangle( setup,
                           get_vert(vertex_buffer, i-2, stride),
                           get_vert(vertex_buffer, i-1, stride),
@@ -585,8 +670,11 @@ lp_setup_pipeline_statistics(
 void
 lp_setup_init_vbuf(struct lp_setup_context *setup)
 {
-   setup->base.max_indices = LP_MAX_VBUF_INDEXES;
-   setup->base.max_vertex_buffer_bytes = LP_MAX_VBUF_SIZE;
+   /* Let batches grow with the number of threads binning them */
+   const unsigned scale = MAX2(setup->num_bin_threads, 1);
+
+   setup->base.max_indices = LP_MAX_VBUF_INDEXES * scale;
+   setup->base.max_vertex_buffer_bytes = LP_MAX_VBUF_SIZE * scale;
 
    setup->base.get_vertex_info = lp_setup_get_vertex_info;
    setup->base.allocate_vertices = lp_setup_allocate_vertices;
@@ -102,6 +102,7 @@
 #include "lp_flush.h"
 #include "lp_state_fs.h"
 #include "lp_rast.h"
+#include "lp_screen.h"
 
 
 /** Fragment shader number (for debugging) */
@@ -215,6 +216,24 @@ find_output_by_semantic( const struct tgsi_shader_info *info,
 }
 
 
+/**
+ * Whether the variant leaves all color buffers untouched, so only depth,
+ * stencil and occlusion results are observable.
+ */
+static boolean
+key_writes_no_color(const struct lp_fragment_shader_variant_key *key)
+{
+   unsigned cbuf;
+
+   for (cbuf = 0; cbuf < key->nr_cbufs; cbuf++) {
+      if (key->cbuf_format[cbuf] != PIPE_FORMAT_NONE &&
+          key->blend.rt[cbuf].colormask)
+         return FALSE;
+   }
+   return TRUE;
+}
+
+
 /**
  * Fetch the specified lp_jit_viewport structure for a given viewport_index.
  */
@@ -330,6 +349,18 @@ generate_fs_loop(struct gallivm_state *gallivm,
                             shader->info.base.num_instructions < 8) && 0;
    const boolean dual_source_blend = key->blend.rt[0].blend_enable &&
                                      util_blend_state_is_dual(&key->blend, 0);
+   /*
+    * Depth-only passes (e.g. shadow maps) don't need to run the shader at
+    * all if nothing but the color outputs depends on it.
+    */
+   const boolean skip_shader = key_writes_no_color(key) &&
+                               !key->alpha.enabled &&
+                               !key->blend.alpha_to_coverage &&
+                               !shader->info.base.uses_kill &&
+                               !shader->info.base.writes_z &&
+                               !shader->info.base.writes_stencil &&
+                               !shader->info.base.writes_samplemask &&
+                               !shader->info.base.writes_memory;
    unsigned attrib;
    unsigned chan;
    unsigned cbuf;
@@ -472,14 +503,16 @@ generate_fs_loop(struct gallivm_state *gallivm,
          lp_build_mask_check(&mask);
    }
 
-   lp_build_interp_soa_update_inputs_dyn(interp, gallivm, loop_state.counter);
+   if (!skip_shader) {
+      lp_build_interp_soa_update_inputs_dyn(interp, gallivm, loop_state.counter);
 
-   /* Build the actual shader */
-   lp_build_tgsi_soa(gallivm, tokens, type, &mask,
-                     consts_ptr, num_consts_ptr, &system_values,
-                     interp->inputs,
-                     outputs, context_ptr, thread_data_ptr,
-                     sampler, &shader->info.base, NULL);
+      /* Build the actual shader */
+      lp_build_tgsi_soa(gallivm, tokens, type, &mask,
+                        consts_ptr, num_consts_ptr, &system_values,
+                        interp->inputs,
+                        outputs, context_ptr, thread_data_ptr,
+                        sampler, &shader->info.base, NULL);
+   }
 
    /* Alpha test */
    if (key->alpha.enabled) {
@@ -1765,6 +1798,7 @@ generate_unswizzled_blend(struct gallivm_state *gallivm,
 
    bool pad_inline = is_arithmetic_format(out_format_desc);
    bool has_alpha = false;
+   bool overwrite;
    const boolean dual_source_blend = variant->key.blend.rt[0].blend_enable &&
                                      util_blend_state_is_dual(&variant->key.blend, 0);
 
@@ -2194,6 +2228,12 @@ generate_unswizzled_blend(struct gallivm_state *gallivm,
    }
 
 
+   /*
+    * With no blending, logic op or color mask and all pixels covered, the
+    * block is simply overwritten: skip loading and converting dst.
+    */
+   overwrite = !partial_mask;
+
    /*
     * Load dst from memory
     */
@@ -2260,7 +2300,10 @@ generate_unswizzled_blend(struct gallivm_state *gallivm,
       }
    }
 
-   if (is_1d) {
+   if (overwrite) {
+      /* dst is entirely replaced by the blend below. */
+   }
+   else if (is_1d) {
       load_unswizzled_block(gallivm, color_ptr, stride, block_width, 1,
                             dst, ls_type, dst_count / 4, dst_alignment);
       for (i = dst_count / 4; i < dst_count; i++) {
@@ -2284,7 +2327,7 @@ generate_unswizzled_blend(struct gallivm_state *gallivm,
     * this will take the 4 dsts and combine them into 1 src so we can perform blending
     * on all 16 pixels in that single vector at once.
     */
-   if (dst_count > src_count) {
+   if (dst_count > src_count && !overwrite) {
       if (ls_type.length != dst_type.length && ls_type.length == 1) {
          LLVMTypeRef elem_type = lp_build_elem_type(gallivm, ls_type);
          LLVMTypeRef ls_vec_type = LLVMVectorType(elem_type, 1);
@@ -2317,8 +2360,14 @@ generate_unswizzled_blend(struct gallivm_state *gallivm,
     * It seems some cleanup could be done here (like skipping conversion/blend
     * when not needed).
     */
-   convert_to_blend_type(gallivm, block_size, out_format_desc, dst_type,
-                         row_type, dst, src_count);
+   if (overwrite) {
+      for (i = 0; i < src_count; ++i)
+         dst[i] = src[i];
+   }
+   else {
+      convert_to_blend_type(gallivm, block_size, out_format_desc, dst_type,
+                            row_type, dst, src_count);
+   }
 
    /*
     * FIXME: Really should get logic ops / masks out of generic blend / row
@@ -2326,7 +2375,7 @@ generate_unswizzled_blend(struct gallivm_state *gallivm,
     * used for SRGB here and I think OpenGL expects this to work as expected
     * (that is incoming values converted to srgb then logic op applied).
     */
-   for (i = 0; i < src_count; ++i) {
+   for (i = 0; i < src_count && !overwrite; ++i) {
       dst[i] = lp_build_blend_aos(gallivm,
                                   &variant->key.blend,
                                   out_format,
@@ -2397,8 +2446,7 @@ generate_unswizzled_blend(struct gallivm_state *gallivm,
  * 2x2 pixels.
  */
 static void
-generate_fragment(struct llvmpipe_context *lp,
-                  struct lp_fragment_shader *shader,
+generate_fragment(struct lp_fragment_shader *shader,
                   struct lp_fragment_shader_variant *variant,
                   unsigned partial_mask)
 {
@@ -2667,7 +2715,9 @@ generate_fragment(struct llvmpipe_context *lp,
    /* Loop over color outputs / color buffers to do blending.
     */
    for(cbuf = 0; cbuf < key->nr_cbufs; cbuf++) {
-      if (key->cbuf_format[cbuf] != PIPE_FORMAT_NONE) {
+      /* Nothing to do for buffers which are masked out entirely. */
+      if (key->cbuf_format[cbuf] != PIPE_FORMAT_NONE &&
+          key->blend.rt[cbuf].colormask) {
          LLVMValueRef color_ptr;
          LLVMValueRef stride;
          LLVMValueRef index = lp_build_const_int32(gallivm, cbuf);
@@ -2791,6 +2841,8 @@ dump_fs_variant_key(const struct lp_fragment_shader_variant_key *key)
                    texture->pot_width,
                    texture->pot_height,
                    texture->pot_depth);
+      debug_printf("  .tiled = %u\n",
+                   texture->tiled);
    }
 }
 
@@ -2807,6 +2859,110 @@ lp_debug_fs_variant(const struct lp_fragment_shader_variant *variant)
 }
 
 
+/**
+ * Generate and compile the code of a variant, unless the machine code is
+ * found in the shader cache.
+ *
+ * \return TRUE if the code came from the shader cache.
+ */
+static boolean
+compile_variant(struct llvmpipe_screen *screen,
+                struct lp_fragment_shader *shader,
+                struct lp_fragment_shader_variant *variant)
+{
+   struct lp_cached_code cached = { 0 };
+   unsigned char ir_sha1_cache_key[20];
+   boolean needs_caching = FALSE;
+   boolean cache_hit;
+
+   lp_jit_init_types(variant);
+   
+   if (variant->jit_function[RAST_EDGE_TEST] == NULL)
+      generate_fragment(shader, variant, RAST_EDGE_TEST);
+
+   if (variant->jit_function[RAST_WHOLE] == NULL) {
+      if (variant->opaque) {
+         /* Specialized shader, which doesn't need to read the color buffer. */
+         generate_fragment(shader, variant, RAST_WHOLE);
+      }
+   }
+
+   /*
+    * Compile everything, unless the code is in the shader cache.
+    * Unoptimized code is never stored in the cache.
+    */
+
+   if (screen->disk_shader_cache) {
+      gallivm_get_ir_cache_key(variant->gallivm, ir_sha1_cache_key);
+      lp_disk_cache_find_shader(screen, &cached, ir_sha1_cache_key);
+      if (!cached.data_size && !variant->gallivm->fast_compile)
+         needs_caching = TRUE;
+      variant->gallivm->cache = &cached;
+   }
+   cache_hit = cached.data_size != 0;
+
+   gallivm_compile_module(variant->gallivm);
+
+   variant->nr_instrs += lp_build_count_ir_module(variant->gallivm->module);
+
+   if (variant->function[RAST_EDGE_TEST]) {
+      variant->jit_function[RAST_EDGE_TEST] = (lp_jit_frag_func)
+            gallivm_jit_function(variant->gallivm,
+                                 variant->function[RAST_EDGE_TEST]);
+   }
+
+   if (variant->function[RAST_WHOLE]) {
+         variant->jit_function[RAST_WHOLE] = (lp_jit_frag_func)
+               gallivm_jit_function(variant->gallivm,
+                                    variant->function[RAST_WHOLE]);
+   } else if (!variant->jit_function[RAST_WHOLE]) {
+      variant->jit_function[RAST_WHOLE] = variant->jit_function[RAST_EDGE_TEST];
+   }
+
+   if (needs_caching) {
+      lp_disk_cache_insert_shader(screen, &cached, ir_sha1_cache_key);
+   }
+
+   gallivm_free_ir(variant->gallivm);
+   free(cached.data);
+
+   return cache_hit;
+}
+
+
+/**
+ * Build the optimized code of a variant on the screen's compile queue.
+ *
+ * The job runs in its own LLVM context, as the context's one isn't
+ * thread safe.  Only the shader tokens and the key are shared with the
+ * application thread, and neither changes while the job is pending.
+ */
+static void
+fs_async_compile(void *data, int thread_index)
+{
+   struct lp_fragment_shader_variant *variant = data;
+   struct lp_fragment_shader_variant *async_variant = variant->async_variant;
+   struct llvmpipe_screen *screen = async_variant->async_screen;
+   LLVMContextRef context;
+   char module_name[64];
+
+   util_snprintf(module_name, sizeof(module_name), "fs%u_variant%u_opt",
+                 variant->shader->no, variant->no);
+
+   context = LLVMContextCreate();
+   if (!context)
+      return;
+
+   async_variant->gallivm = gallivm_create(module_name, context);
+   if (async_variant->gallivm) {
+      compile_variant(screen, variant->shader, async_variant);
+      /* compile_variant() already freed the IR, only the code remains */
+   }
+
+   LLVMContextDispose(context);
+}
+
+
 /**
  * Generate a new fragment shader variant from the shader code and
  * other state indicated by the key.
@@ -2816,6 +2972,7 @@ generate_variant(struct llvmpipe_context *lp,
                  struct lp_fragment_shader *shader,
                  const struct lp_fragment_shader_variant_key *key)
 {
+   struct llvmpipe_screen *screen = llvmpipe_screen(lp->pipe.screen);
    struct lp_fragment_shader_variant *variant;
    const struct util_format_description *cbuf0_format_desc = NULL;
    boolean fullcolormask;
@@ -2862,45 +3019,66 @@ generate_variant(struct llvmpipe_context *lp,
          !shader->info.base.writes_samplemask
       ? TRUE : FALSE;
 
+   /*
+    * Fragments which fail a LESS/LEQUAL depth test may be skipped, unless
+    * the depth test failing has side effects, or the tested depth isn't
+    * the interpolated one.  Only LESS/LEQUAL never increase the depth.
+    */
+   if (key->depth.enabled && !(LP_PERF & PERF_NO_HIZ)) {
+      const boolean less = key->depth.func == PIPE_FUNC_LESS ||
+                           key->depth.func == PIPE_FUNC_LEQUAL;
+      const boolean zfail_writes_stencil =
+         (key->stencil[0].enabled &&
+          key->stencil[0].zfail_op != PIPE_STENCIL_OP_KEEP) ||
+         (key->stencil[1].enabled &&
+          key->stencil[1].zfail_op != PIPE_STENCIL_OP_KEEP);
+
+      variant->hiz_test = less &&
+                          !zfail_writes_stencil &&
+                          !key->depth_clamp &&
+                          !shader->info.base.writes_z;
+      variant->hiz_write = variant->hiz_test &&
+                           key->depth.writemask &&
+                           !key->stencil[0].enabled &&
+                           !key->alpha.enabled &&
+                           !key->blend.alpha_to_coverage &&
+                           !shader->info.base.uses_kill &&
+                           !shader->info.base.writes_samplemask;
+      variant->hiz_invalidate = key->depth.writemask &&
+                                !less &&
+                                key->depth.func != PIPE_FUNC_EQUAL &&
+                                key->depth.func != PIPE_FUNC_NEVER;
+   }
+
    if ((LP_DEBUG & DEBUG_FS) || (gallivm_debug & GALLIVM_DEBUG_IR)) {
       lp_debug_fs_variant(variant);
    }
 
-   lp_jit_init_types(variant);
-   
-   if (variant->jit_function[RAST_EDGE_TEST] == NULL)
-      generate_fragment(lp, shader, variant, RAST_EDGE_TEST);
-
-   if (variant->jit_function[RAST_WHOLE] == NULL) {
-      if (variant->opaque) {
-         /* Specialized shader, which doesn't need to read the color buffer. */
-         generate_fragment(lp, shader, variant, RAST_WHOLE);
-      }
-   }
+   util_queue_fence_init(&variant->async_fence);
 
    /*
-    * Compile everything
+    * In async mode, quickly build unoptimized code to draw with until the
+    * optimized one is ready, unless the optimized code is in the cache.
     */
+   variant->gallivm->fast_compile = screen->async_compile;
 
-   gallivm_compile_module(variant->gallivm);
+   if (compile_variant(screen, shader, variant) ||
+       !variant->gallivm->fast_compile)
+      return variant;
 
-   variant->nr_instrs += lp_build_count_ir_module(variant->gallivm->module);
+   variant->async_variant = CALLOC_STRUCT(lp_fragment_shader_variant);
+   if (!variant->async_variant)
+      return variant;
 
-   if (variant->function[RAST_EDGE_TEST]) {
-      variant->jit_function[RAST_EDGE_TEST] = (lp_jit_frag_func)
-            gallivm_jit_function(variant->gallivm,
-                                 variant->function[RAST_EDGE_TEST]);
-   }
+   memcpy(&variant->async_variant->key, key, shader->variant_key_size);
+   variant->async_variant->shader = shader;
+   variant->async_variant->opaque = variant->opaque;
+   variant->async_variant->async_screen = screen;
+   variant->async_pending = TRUE;
+   lp->nr_fs_variants_pending++;
 
-   if (variant->function[RAST_WHOLE]) {
-         variant->jit_function[RAST_WHOLE] = (lp_jit_frag_func)
-               gallivm_jit_function(variant->gallivm,
-                                    variant->function[RAST_WHOLE]);
-   } else if (!variant->jit_function[RAST_WHOLE]) {
-      variant->jit_function[RAST_WHOLE] = variant->jit_function[RAST_EDGE_TEST];
-   }
-
-   gallivm_free_ir(variant->gallivm);
+   util_queue_add_job(&screen->compile_queue, variant, &variant->async_fence,
+                      fs_async_compile, NULL);
 
    return variant;
 }
@@ -3019,6 +3197,46 @@ llvmpipe_bind_fs_state(struct pipe_context *pipe, void *fs)
 }
 
 
+/**
+ * Switch the variants whose background compilation finished over to the
+ * optimized code.
+ *
+ * Scenes binned with the unoptimized code may still be rasterized, which
+ * is fine as that code is only freed with the variant.
+ */
+void
+llvmpipe_update_fs_async(struct llvmpipe_context *lp)
+{
+   struct lp_fs_variant_list_item *li;
+
+   if (!lp->nr_fs_variants_pending)
+      return;
+
+   li = first_elem(&lp->fs_variants_list);
+   while (!at_end(&lp->fs_variants_list, li)) {
+      struct lp_fragment_shader_variant *variant = li->base;
+
+      if (variant->async_pending &&
+          util_queue_fence_is_signalled(&variant->async_fence)) {
+         const struct lp_fragment_shader_variant *async_variant =
+            variant->async_variant;
+
+         if (async_variant->jit_function[RAST_EDGE_TEST] &&
+             async_variant->jit_function[RAST_WHOLE]) {
+            variant->jit_function[RAST_EDGE_TEST] =
+               async_variant->jit_function[RAST_EDGE_TEST];
+            variant->jit_function[RAST_WHOLE] =
+               async_variant->jit_function[RAST_WHOLE];
+         }
+
+         variant->async_pending = FALSE;
+         lp->nr_fs_variants_pending--;
+      }
+      li = next_elem(li);
+   }
+}
+
+
 /**
  * Remove shader variant from two lists: the shader's variant list
  * and the context's variant list.
@@ -3036,6 +3254,17 @@ llvmpipe_remove_shader_variant(struct llvmpipe_context *lp,
                    lp->nr_fs_variants, variant->nr_instrs, lp->nr_fs_instrs);
    }
 
+   /* The job may still be compiling */
+   util_queue_fence_wait(&variant->async_fence);
+   if (variant->async_pending)
+      lp->nr_fs_variants_pending--;
+   if (variant->async_variant) {
+      if (variant->async_variant->gallivm)
+         gallivm_destroy(variant->async_variant->gallivm);
+      FREE(variant->async_variant);
+   }
+   util_queue_fence_destroy(&variant->async_fence);
+
    gallivm_destroy(variant->gallivm);
 
    /* remove from shader's list */
@@ -3314,6 +3543,18 @@ make_variant_key(struct llvmpipe_context *lp,
          blend_rt->colormask = 0x0;
          blend_rt->blend_enable = 0;
       }
+
+      /*
+       * The blend state of a masked out buffer doesn't matter, clear it so
+       * that e.g. all depth-only passes share variants.
+       */
+      if (!blend_rt->colormask)
+         memset(blend_rt, 0, sizeof *blend_rt);
+   }
+
+   if (key_writes_no_color(key)) {
+      key->blend.logicop_enable = 0;
+      key->blend.logicop_func = 0;
    }
 
    /* This value will be the same for all the variants of a given shader:
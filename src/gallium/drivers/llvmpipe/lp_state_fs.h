@@ -35,11 +35,13 @@
 #include "tgsi/tgsi_scan.h" /* for tgsi_shader_info */
 #include "gallivm/lp_bld_sample.h" /* for struct lp_sampler_static_state */
 #include "gallivm/lp_bld_tgsi.h" /* for lp_tgsi_info */
+#include "util/u_queue.h" /* for util_queue_fence */
 #include "lp_bld_interp.h" /* for struct lp_shader_input */
 
 
 struct tgsi_token;
 struct lp_fragment_shader;
+struct llvmpipe_screen;
 
 
 /** Indexes into jit_function[] array */
@@ -99,6 +101,11 @@ struct lp_fragment_shader_variant
 
    boolean opaque;
 
+   /* Coarse depth culling in the rasterizer, see lp_rast_hiz_*() */
+   boolean hiz_test;        /**< fragments failing LESS/LEQUAL can be skipped */
+   boolean hiz_write;       /**< fully covered blocks get the triangle's depth */
+   boolean hiz_invalidate;  /**< depth values may increase */
+
    struct gallivm_state *gallivm;
 
    LLVMTypeRef jit_context_ptr_type;
@@ -109,6 +116,17 @@ struct lp_fragment_shader_variant
 
    lp_jit_frag_func jit_function[2];
 
+   /*
+    * With LP_ASYNC_COMPILE, jit_function[] first points to unoptimized code
+    * while the optimized code is built in async_variant on a screen thread.
+    * The unoptimized gallivm stays alive until the variant is destroyed, as
+    * binned scenes may still call into it.
+    */
+   struct lp_fragment_shader_variant *async_variant;
+   struct llvmpipe_screen *async_screen;
+   struct util_queue_fence async_fence;
+   boolean async_pending;
+
    /* Total number of LLVM instructions generated */
    unsigned nr_instrs;
 
@@ -149,4 +167,7 @@ void
 llvmpipe_remove_shader_variant(struct llvmpipe_context *lp,
                                struct lp_fragment_shader_variant *variant);
 
+void
+llvmpipe_update_fs_async(struct llvmpipe_context *lp);
+
 #endif /* LP_STATE_FS_H_ */
@@ -43,6 +43,8 @@
 #include "util/simple_list.h"
 #include "util/u_transfer.h"
 
+#include "gallivm/lp_bld_sample.h"
+
 #include "lp_context.h"
 #include "lp_flush.h"
 #include "lp_screen.h"
@@ -91,6 +93,7 @@ llvmpipe_texture_layout(struct llvmpipe_screen *screen,
    for (level = 0; level <= pt->last_level; level++) {
       uint64_t mipsize;
       unsigned align_x, align_y, nblocksx, nblocksy, block_size, num_slices;
+      unsigned nrows;
 
       /* Row stride and image stride */
 
@@ -118,18 +121,30 @@ llvmpipe_texture_layout(struct llvmpipe_screen *screen,
                                           align(height, align_y));
       block_size = util_format_get_blocksize(pt->format);
 
-      if (util_format_is_compressed(pt->format))
-         lpr->row_stride[level] = nblocksx * block_size;
-      else
-         lpr->row_stride[level] = align(nblocksx * block_size, util_cpu_caps.cacheline);
+      if (pt->flags & LP_RESOURCE_FLAG_TILED) {
+         /* One row is a row of tiles, see LP_RESOURCE_FLAG_TILED. The 4x4
+          * alignment above already covers whole tiles.
+          */
+         STATIC_ASSERT(LP_TEX_TILE_SIZE == LP_RASTER_BLOCK_SIZE);
+         lpr->row_stride[level] = align(nblocksx * block_size * LP_TEX_TILE_SIZE,
+                                        util_cpu_caps.cacheline);
+         nrows = nblocksy / LP_TEX_TILE_SIZE;
+      }
+      else {
+         if (util_format_is_compressed(pt->format))
+            lpr->row_stride[level] = nblocksx * block_size;
+         else
+            lpr->row_stride[level] = align(nblocksx * block_size, util_cpu_caps.cacheline);
+         nrows = nblocksy;
+      }
 
       /* if row_stride * height > LP_MAX_TEXTURE_SIZE */
-      if ((uint64_t)lpr->row_stride[level] * nblocksy > LP_MAX_TEXTURE_SIZE) {
+      if ((uint64_t)lpr->row_stride[level] * nrows > LP_MAX_TEXTURE_SIZE) {
          /* image too large */
          goto fail;
       }
 
-      lpr->img_stride[level] = lpr->row_stride[level] * nblocksy;
+      lpr->img_stride[level] = lpr->row_stride[level] * nrows;
 
       /* Number of 3D image slices, cube faces or texture array layers */
       if (lpr->base.target == PIPE_TEXTURE_CUBE) {
@@ -198,6 +213,38 @@ llvmpipe_can_create_resource(struct pipe_screen *screen,
 }
 
 
+/**
+ * Can the texture use the LP_RESOURCE_FLAG_TILED layout?  Only textures
+ * which are sampled but never rendered to or written by shaders are tiled,
+ * as the rasterizer and image stores only handle linear images.
+ */
+static boolean
+llvmpipe_texture_can_tile(const struct llvmpipe_screen *screen,
+                          const struct pipe_resource *pt)
+{
+   const struct util_format_description *desc =
+      util_format_description(pt->format);
+
+   if (!screen->tiled_textures)
+      return FALSE;
+
+   if (pt->bind & (PIPE_BIND_RENDER_TARGET |
+                   PIPE_BIND_DEPTH_STENCIL |
+                   PIPE_BIND_SHADER_IMAGE |
+                   PIPE_BIND_LINEAR))
+      return FALSE;
+
+   if (pt->usage == PIPE_USAGE_STAGING)
+      return FALSE;
+
+   /* no compressed or subsampled formats */
+   if (desc->block.width != 1 || desc->block.height != 1)
+      return FALSE;
+
+   return !llvmpipe_resource_is_1d(pt);
+}
+
+
 static boolean
 llvmpipe_displaytarget_layout(struct llvmpipe_screen *screen,
                               struct llvmpipe_resource *lpr,
@@ -262,6 +309,8 @@ llvmpipe_resource_create_front(struct pipe_screen *_screen,
       }
       else {
          /* texture map */
+         if (llvmpipe_texture_can_tile(screen, &lpr->base))
+            lpr->base.flags |= LP_RESOURCE_FLAG_TILED;
          if (!llvmpipe_texture_layout(screen, lpr, true))
             goto fail;
       }
@@ -327,7 +376,7 @@ llvmpipe_resource_destroy(struct pipe_screen *pscreen,
    }
    else if (llvmpipe_resource_is_texture(pt)) {
       /* free linear image data */
-      if (lpr->tex_data) {
+      if (lpr->tex_data && !lpr->userBuffer) {
          align_free(lpr->tex_data);
          lpr->tex_data = NULL;
       }
@@ -486,6 +535,68 @@ no_lpr:
 }
 
 
+/**
+ * Wrap user memory in a resource.  Textures must be single 2D images which
+ * are laid out exactly as llvmpipe_texture_layout() would do, including
+ * the padding to whole 4x4 pixel blocks which rendering reads and writes;
+ * callers can check the stride with a transfer.
+ */
+static struct pipe_resource *
+llvmpipe_resource_from_user_memory(struct pipe_screen *_screen,
+                                   const struct pipe_resource *resource,
+                                   void *user_memory)
+{
+   struct llvmpipe_screen *screen = llvmpipe_screen(_screen);
+   struct llvmpipe_resource *lpr;
+
+   lpr = CALLOC_STRUCT(llvmpipe_resource);
+   if (!lpr)
+      return NULL;
+
+   lpr->base = *resource;
+   lpr->base.flags &= ~LP_RESOURCE_FLAG_TILED;
+   pipe_reference_init(&lpr->base.reference, 1);
+   lpr->base.screen = _screen;
+
+   if (llvmpipe_resource_is_texture(&lpr->base)) {
+      if ((lpr->base.target != PIPE_TEXTURE_2D &&
+           lpr->base.target != PIPE_TEXTURE_RECT) ||
+          lpr->base.last_level != 0 ||
+          lpr->base.array_size != 1 ||
+          util_format_is_compressed(lpr->base.format) ||
+          lpr->base.height0 % LP_RASTER_BLOCK_SIZE != 0 ||
+          (uintptr_t) user_memory % 16 != 0)
+         goto fail;
+
+      if (!llvmpipe_texture_layout(screen, lpr, false))
+         goto fail;
+
+      lpr->tex_data = user_memory;
+   }
+   else {
+      /* no room for the block sized writes of rendering to buffers */
+      if (lpr->base.bind & PIPE_BIND_RENDER_TARGET)
+         goto fail;
+
+      lpr->data = user_memory;
+      lpr->row_stride[0] = resource->width0;
+   }
+
+   lpr->userBuffer = TRUE;
+   lpr->id = id_counter++;
+
+#ifdef DEBUG
+   insert_at_tail(&resource_list, lpr);
+#endif
+
+   return &lpr->base;
+
+fail:
+   FREE(lpr);
+   return NULL;
+}
+
+
 static boolean
 llvmpipe_resource_get_handle(struct pipe_screen *screen,
                              struct pipe_context *ctx,
@@ -504,6 +615,55 @@ llvmpipe_resource_get_handle(struct pipe_screen *screen,
 }
 
 
+/**
+ * Copy a box of a texture in the LP_RESOURCE_FLAG_TILED layout from or to
+ * a linear buffer.
+ */
+static void
+llvmpipe_copy_tiled_box(struct llvmpipe_resource *lpr,
+                        unsigned level,
+                        const struct pipe_box *box,
+                        ubyte *linear,
+                        unsigned stride,
+                        unsigned layer_stride,
+                        boolean to_tiled)
+{
+   const unsigned texel_size = util_format_get_blocksize(lpr->base.format);
+   const unsigned tile_mask = LP_TEX_TILE_SIZE - 1;
+   int x, y, z;
+
+   for (z = 0; z < box->depth; z++) {
+      ubyte *image = llvmpipe_get_texture_image_address(lpr, box->z + z,
+                                                        level);
+
+      for (y = 0; y < box->height; y++) {
+         const unsigned ty = box->y + y;
+         ubyte *tile_row = image +
+            (ty >> LP_TEX_TILE_ORDER) * lpr->row_stride[level] +
+            (ty & tile_mask) * LP_TEX_TILE_SIZE * texel_size;
+         ubyte *lin = linear + z * layer_stride + y * stride;
+
+         /* copy the run of texels within each tile in one go */
+         for (x = 0; x < box->width; ) {
+            const unsigned tx = box->x + x;
+            const unsigned n = MIN2(LP_TEX_TILE_SIZE - (tx & tile_mask),
+                                    box->width - x);
+            ubyte *tiled = tile_row +
+               ((tx >> LP_TEX_TILE_ORDER) * LP_TEX_TILE_SIZE * LP_TEX_TILE_SIZE +
+                (tx & tile_mask)) * texel_size;
+
+            if (to_tiled)
+               memcpy(tiled, lin + x * texel_size, n * texel_size);
+            else
+               memcpy(lin + x * texel_size, tiled, n * texel_size);
+
+            x += n;
+         }
+      }
+   }
+}
+
+
 static void *
 llvmpipe_transfer_map( struct pipe_context *pipe,
                        struct pipe_resource *resource,
@@ -525,6 +685,10 @@ llvmpipe_transfer_map( struct pipe_context *pipe,
    assert(resource);
    assert(level <= resource->last_level);
 
+   if ((resource->flags & LP_RESOURCE_FLAG_TILED) &&
+       (usage & PIPE_TRANSFER_MAP_DIRECTLY))
+      return NULL;
+
    /*
     * Transfers, like other pipe operations, must happen in order, so flush the
     * context if necessary.
@@ -596,6 +760,32 @@ llvmpipe_transfer_map( struct pipe_context *pipe,
 
    format = lpr->base.format;
 
+   if (resource->flags & LP_RESOURCE_FLAG_TILED) {
+      /*
+       * Hand out a linear copy of the box, it is tiled back on unmap.
+       */
+      pt->stride = box->width * util_format_get_blocksize(format);
+      pt->layer_stride = pt->stride * box->height;
+      lpt->staging = MALLOC(pt->layer_stride * box->depth);
+      if (!lpt->staging) {
+         pipe_resource_reference(&pt->resource, NULL);
+         FREE(lpt);
+         *transfer = NULL;
+         return NULL;
+      }
+
+      if ((usage & PIPE_TRANSFER_READ) ||
+          !(usage & (PIPE_TRANSFER_DISCARD_RANGE |
+                     PIPE_TRANSFER_DISCARD_WHOLE_RESOURCE)))
+         llvmpipe_copy_tiled_box(lpr, level, box, lpt->staging,
+                                 pt->stride, pt->layer_stride, FALSE);
+
+      if (usage & PIPE_TRANSFER_WRITE)
+         screen->timestamp++;
+
+      return lpt->staging;
+   }
+
    map = llvmpipe_resource_map(resource,
                                level,
                                box->z,
@@ -623,16 +813,27 @@ static void
 llvmpipe_transfer_unmap(struct pipe_context *pipe,
                         struct pipe_transfer *transfer)
 {
-   assert(transfer->resource);
+   struct llvmpipe_transfer *lpt = llvmpipe_transfer(transfer);
 
-   llvmpipe_resource_unmap(transfer->resource,
-                           transfer->level,
-                           transfer->box.z);
+   assert(transfer->resource);
 
-   /* Effectively do the texture_update work here - if texture images
-    * needed post-processing to put them into hardware layout, this is
-    * where it would happen.  For llvmpipe, nothing to do.
+   /* Effectively do the texture_update work here - textures in the tiled
+    * layout get the linear copy written back.
     */
+   if (lpt->staging) {
+      if (transfer->usage & PIPE_TRANSFER_WRITE)
+         llvmpipe_copy_tiled_box(llvmpipe_resource(transfer->resource),
+                                 transfer->level, &transfer->box,
+                                 lpt->staging, transfer->stride,
+                                 transfer->layer_stride, TRUE);
+      FREE(lpt->staging);
+   }
+   else {
+      llvmpipe_resource_unmap(transfer->resource,
+                              transfer->level,
+                              transfer->box.z);
+   }
+
    assert (transfer->resource);
    pipe_resource_reference(&transfer->resource, NULL);
    FREE(transfer);
@@ -809,6 +1010,7 @@ llvmpipe_init_screen_resource_funcs(struct pipe_screen *screen)
    screen->resource_destroy = llvmpipe_resource_destroy;
    screen->resource_from_handle = llvmpipe_resource_from_handle;
    screen->resource_get_handle = llvmpipe_resource_get_handle;
+   screen->resource_from_user_memory = llvmpipe_resource_from_user_memory;
    screen->can_create_resource = llvmpipe_can_create_resource;
 }
 
@@ -85,7 +85,7 @@ struct llvmpipe_resource
     */
    void *data;
 
-   boolean userBuffer;  /** Is this a user-space buffer? */
+   boolean userBuffer;  /** Is the data (or tex_data) user memory? */
    unsigned timestamp;
 
    unsigned id;  /**< temporary, for debugging */
@@ -102,6 +102,9 @@ struct llvmpipe_transfer
    struct pipe_transfer base;
 
    unsigned long offset;
+
+   /** Linear copy of the box for textures in the tiled layout */
+   ubyte *staging;
 };
 
 
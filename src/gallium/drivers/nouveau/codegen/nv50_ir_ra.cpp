@@ -24,6 +24,7 @@
 #include "codegen/nv50_ir_target.h"
 
 #include <algorithm>
+#include <queue>
 #include <stack>
 #include <limits>
 #if __cplusplus >= 201103L
@@ -786,8 +787,24 @@ private:
    inline void insertOrderedTail(std::list<RIG_Node *>&, RIG_Node *);
    void checkList(std::list<RIG_Node *>&);
 
+   struct SpillCandidate {
+      float score;
+      int id;
+
+      // lowest score first, ties go to the highest id (ie. the node that
+      // comes first in hi)
+      bool operator<(const SpillCandidate& that) const
+      {
+         if (score != that.score)
+            return score > that.score;
+         return id < that.id;
+      }
+   };
+   typedef std::priority_queue<SpillCandidate> SpillCandidateQueue;
+
 private:
    std::stack<uint32_t> stack;
+   SpillCandidateQueue spillCandidates;
 
    // list headers for simplify() phase
    RIG_Node lo[2];
@@ -1307,6 +1324,16 @@ GCRA::simplifyNode(RIG_Node *node)
 bool
 GCRA::simplify()
 {
+   // Degrees only ever go down during simplification, so a node's score can
+   // only go up.  Scores in the queue are thus lower bounds, and we only need
+   // to refresh the one at the top before trusting it, instead of rescanning
+   // all of hi for every spill candidate.
+   spillCandidates = SpillCandidateQueue();
+   for (RIG_Node *it = hi.next; it != &hi; it = it->next) {
+      SpillCandidate c = { it->weight / (float)it->degree, it->getValue()->id };
+      spillCandidates.push(c);
+   }
+
    for (;;) {
       if (!DLLIST_EMPTY(&lo[0])) {
          do {
@@ -1317,15 +1344,23 @@ GCRA::simplify()
          simplifyNode(lo[1].next);
       } else
       if (!DLLIST_EMPTY(&hi)) {
-         RIG_Node *best = hi.next;
-         float bestScore = best->weight / (float)best->degree;
          // spill candidate
-         for (RIG_Node *it = best->next; it != &hi; it = it->next) {
+         RIG_Node *best = NULL;
+         float bestScore;
+         while (!best) {
+            SpillCandidate c = spillCandidates.top();
+            RIG_Node *it = &nodes[c.id];
+            spillCandidates.pop();
+            if (DLLIST_EMPTY(it) || it->degree < it->degreeLimit)
+               continue; // already simplified or moved to lo[]
             float score = it->weight / (float)it->degree;
-            if (score < bestScore) {
-               best = it;
-               bestScore = score;
+            if (score > c.score) {
+               c.score = score;
+               spillCandidates.push(c);
+               continue;
             }
+            best = it;
+            bestScore = score;
          }
          if (isinf(bestScore)) {
             ERROR("no viable spill candidates left\n");
@@ -44,6 +44,9 @@ struct nvc0_graph_state {
    uint32_t constant_vbos;
    uint32_t constant_elts;
    int32_t index_bias;
+   uint64_t index_array_start;
+   uint32_t index_array_size;
+   uint8_t index_size;
    uint16_t scissor;
    bool flatshade;
    uint8_t patch_vertices;
@@ -961,13 +961,25 @@ nvc0_draw_vbo(struct pipe_context *pipe, const struct pipe_draw_info *info)
       assert(buf);
       assert(nouveau_resource_mapped_by_gpu(&buf->base));
 
-      PUSH_SPACE(push, 6);
-      BEGIN_NVC0(push, NVC0_3D(INDEX_ARRAY_START_HIGH), 5);
-      PUSH_DATAh(push, buf->address);
-      PUSH_DATA (push, buf->address);
-      PUSH_DATAh(push, buf->address + buf->base.width0 - 1);
-      PUSH_DATA (push, buf->address + buf->base.width0 - 1);
-      PUSH_DATA (push, info->index_size >> 1);
+      /* Repeated draws from the same index buffer don't need to set it up
+       * again, as long as no other context touched the 3D state since.
+       */
+      if (screen->cur_ctx != nvc0 ||
+          nvc0->state.index_array_start != buf->address ||
+          nvc0->state.index_array_size != buf->base.width0 ||
+          nvc0->state.index_size != info->index_size) {
+         nvc0->state.index_array_start = buf->address;
+         nvc0->state.index_array_size = buf->base.width0;
+         nvc0->state.index_size = info->index_size;
+
+         PUSH_SPACE(push, 6);
+         BEGIN_NVC0(push, NVC0_3D(INDEX_ARRAY_START_HIGH), 5);
+         PUSH_DATAh(push, buf->address);
+         PUSH_DATA (push, buf->address);
+         PUSH_DATAh(push, buf->address + buf->base.width0 - 1);
+         PUSH_DATA (push, buf->address + buf->base.width0 - 1);
+         PUSH_DATA (push, info->index_size >> 1);
+      }
 
       BCTX_REFN(nvc0->bufctx_3d, 3D_IDX, buf, RD);
    }
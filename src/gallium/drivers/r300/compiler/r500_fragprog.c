@@ -44,7 +44,7 @@ int r500_transform_IF(
 {
 	struct rc_variable * writer;
 	struct rc_list * writer_list, * list_ptr;
-	struct rc_list * var_list = rc_get_variables(c);
+	struct rc_list * var_list;
 	unsigned int generic_if = 0;
 	unsigned int alu_chan;
 
@@ -52,6 +52,9 @@ int r500_transform_IF(
 		return 0;
 	}
 
+	/* This walks the whole program, so only do it for IF instructions. */
+	var_list = rc_get_variables(c);
+
 	writer_list = rc_variable_list_get_writers(
 			var_list, inst_if->Type, &inst_if->U.I.SrcReg[0]);
 	if (!writer_list) {
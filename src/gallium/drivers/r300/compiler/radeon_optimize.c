@@ -712,10 +712,14 @@ static void omod_filter_writer_cb(
 	}
 }
 
+/**
+ * @param var_list The variables of the program, computed on demand if NULL
+ * and reset to NULL when the program is modified.
+ */
 static int peephole_mul_omod(
 	struct radeon_compiler * c,
 	struct rc_instruction * inst_mul,
-	struct rc_list * var_list)
+	struct rc_list ** var_list)
 {
 	unsigned int chan = 0, swz, i;
 	int const_index = -1;
@@ -797,7 +801,10 @@ static int peephole_mul_omod(
 		return 0;
 	}
 
-	writer_list = rc_variable_list_get_writers_one_reader(var_list,
+	if (!*var_list)
+		*var_list = rc_get_variables(c);
+
+	writer_list = rc_variable_list_get_writers_one_reader(*var_list,
 		RC_INSTRUCTION_NORMAL, &inst_mul->U.I.SrcReg[temp_index]);
 
 	if (!writer_list) {
@@ -847,6 +854,7 @@ static int peephole_mul_omod(
 	}
 
 	rc_remove_instruction(inst_mul);
+	*var_list = NULL;
 
 	return 1;
 }
@@ -876,7 +884,7 @@ static int peephole(struct radeon_compiler * c, struct rc_instruction * inst)
 void rc_optimize(struct radeon_compiler * c, void *user)
 {
 	struct rc_instruction * inst = c->Program.Instructions.Next;
-	struct rc_list * var_list;
+	struct rc_list * var_list = NULL;
 	while(inst != &c->Program.Instructions) {
 		struct rc_instruction * cur = inst;
 		inst = inst->Next;
@@ -901,8 +909,9 @@ void rc_optimize(struct radeon_compiler * c, void *user)
 		struct rc_instruction * cur = inst;
 		inst = inst->Next;
 		if (cur->U.I.Opcode == RC_OPCODE_MUL) {
-			var_list = rc_get_variables(c);
-			peephole_mul_omod(c, cur, var_list);
+			/* The variables are only recomputed after a MUL
+			 * has been folded into its writers. */
+			peephole_mul_omod(c, cur, &var_list);
 		}
 	}
 }
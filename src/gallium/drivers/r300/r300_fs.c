@@ -22,11 +22,14 @@
  * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
  * USE OR OTHER DEALINGS IN THE SOFTWARE. */
 
+#include "util/disk_cache.h"
+#include "util/mesa-sha1.h"
 #include "util/u_format.h"
 #include "util/u_math.h"
 #include "util/u_memory.h"
 
 #include "tgsi/tgsi_dump.h"
+#include "tgsi/tgsi_parse.h"
 #include "tgsi/tgsi_ureg.h"
 
 #include "r300_cb.h"
@@ -411,6 +414,161 @@ static void r300_emit_fs_code_to_buffer(
     END_CB;
 }
 
+/* The part of r300_fragment_shader_code produced by the compiler, followed
+ * in the disk cache by the machine code, the constants and the constant
+ * remap table. */
+struct r300_fs_cache_header {
+    uint32_t writes_depth;
+    uint32_t num_constants;
+    uint32_t has_remap_table;
+};
+
+static void r300_fs_cache_key(
+    struct r300_context *r300,
+    struct r300_fragment_shader_code *shader,
+    const struct tgsi_token *tokens,
+    cache_key key)
+{
+    struct mesa_sha1 ctx;
+    unsigned char sha1[20];
+
+    _mesa_sha1_init(&ctx);
+    _mesa_sha1_update(&ctx, tokens,
+                      tgsi_num_tokens(tokens) * sizeof(struct tgsi_token));
+    _mesa_sha1_update(&ctx, &shader->compare_state,
+                      sizeof(shader->compare_state));
+    _mesa_sha1_final(&ctx, sha1);
+
+    disk_cache_compute_key(r300->screen->disk_shader_cache, sha1,
+                           sizeof(sha1), key);
+}
+
+static void r300_fs_cache_put(
+    struct r300_context *r300,
+    struct r300_fragment_shader_code *shader,
+    const cache_key key)
+{
+    struct rX00_fragment_program_code *code = &shader->code;
+    struct r300_fs_cache_header header;
+    size_t constants_size = code->constants.Count * sizeof(struct rc_constant);
+    size_t remap_size = code->constants_remap_table ?
+                        code->constants.Count * sizeof(unsigned) : 0;
+    size_t size = sizeof(header) + sizeof(code->code) +
+                  constants_size + remap_size;
+    uint8_t *data, *ptr;
+
+    data = ptr = MALLOC(size);
+    if (!data)
+        return;
+
+    header.writes_depth = code->writes_depth;
+    header.num_constants = code->constants.Count;
+    header.has_remap_table = code->constants_remap_table != NULL;
+
+    memcpy(ptr, &header, sizeof(header));
+    ptr += sizeof(header);
+    memcpy(ptr, &code->code, sizeof(code->code));
+    ptr += sizeof(code->code);
+    memcpy(ptr, code->constants.Constants, constants_size);
+    ptr += constants_size;
+    memcpy(ptr, code->constants_remap_table, remap_size);
+
+    disk_cache_put(r300->screen->disk_shader_cache, key, data, size, NULL);
+    FREE(data);
+}
+
+static boolean r300_fs_cache_get(
+    struct r300_context *r300,
+    struct r300_fragment_shader_code *shader,
+    const cache_key key)
+{
+    struct rX00_fragment_program_code *code = &shader->code;
+    struct r300_fs_cache_header header;
+    size_t size, constants_size, remap_size;
+    uint8_t *data, *ptr;
+
+    data = disk_cache_get(r300->screen->disk_shader_cache, key, &size);
+    if (!data)
+        return FALSE;
+
+    if (size < sizeof(header))
+        goto fail;
+    memcpy(&header, data, sizeof(header));
+
+    constants_size = header.num_constants * sizeof(struct rc_constant);
+    remap_size = header.has_remap_table ?
+                 header.num_constants * sizeof(unsigned) : 0;
+    if (size != sizeof(header) + sizeof(code->code) +
+                constants_size + remap_size)
+        goto fail;
+
+    ptr = data + sizeof(header);
+    memcpy(&code->code, ptr, sizeof(code->code));
+    ptr += sizeof(code->code);
+
+    code->writes_depth = header.writes_depth;
+    code->constants.Constants = malloc(MAX2(constants_size, 1));
+    code->constants.Count = header.num_constants;
+    code->constants._Reserved = header.num_constants;
+    memcpy(code->constants.Constants, ptr, constants_size);
+    ptr += constants_size;
+
+    if (header.has_remap_table) {
+        code->constants_remap_table = malloc(MAX2(remap_size, 1));
+        memcpy(code->constants_remap_table, ptr, remap_size);
+    }
+
+    free(data);
+    return TRUE;
+
+fail:
+    free(data);
+    return FALSE;
+}
+
+/* Set up the state derived from the compiled code. */
+static void r300_finish_fragment_shader(
+    struct r300_context* r300,
+    struct r300_fragment_shader_code* shader)
+{
+    unsigned i;
+
+    /* Initialize numbers of constants for each type. */
+    shader->externals_count = 0;
+    for (i = 0;
+         i < shader->code.constants.Count &&
+         shader->code.constants.Constants[i].Type == RC_CONSTANT_EXTERNAL; i++) {
+        shader->externals_count = i+1;
+    }
+    shader->immediates_count = 0;
+    shader->rc_state_count = 0;
+
+    for (i = shader->externals_count; i < shader->code.constants.Count; i++) {
+        switch (shader->code.constants.Constants[i].Type) {
+            case RC_CONSTANT_IMMEDIATE:
+                ++shader->immediates_count;
+                break;
+            case RC_CONSTANT_STATE:
+                ++shader->rc_state_count;
+                break;
+            default:
+                assert(0);
+        }
+    }
+
+    /* Setup shader depth output. */
+    if (shader->code.writes_depth) {
+        shader->fg_depth_src = R300_FG_DEPTH_SRC_SHADER;
+        shader->us_out_w = R300_W_FMT_W24 | R300_W_SRC_US;
+    } else {
+        shader->fg_depth_src = R300_FG_DEPTH_SRC_SCAN;
+        shader->us_out_w = R300_W_FMT_W0 | R300_W_SRC_US;
+    }
+
+    /* Build the command buffer. */
+    r300_emit_fs_code_to_buffer(r300, shader);
+}
+
 static void r300_translate_fragment_shader(
     struct r300_context* r300,
     struct r300_fragment_shader_code* shader,
@@ -418,12 +576,26 @@ static void r300_translate_fragment_shader(
 {
     struct r300_fragment_program_compiler compiler;
     struct tgsi_to_rc ttr;
+    cache_key key;
+    boolean use_cache;
     int wpos, face;
-    unsigned i;
 
     tgsi_scan_shader(tokens, &shader->info);
     r300_shader_read_fs_inputs(&shader->info, &shader->inputs);
 
+    shader->write_all =
+          shader->info.properties[TGSI_PROPERTY_FS_COLOR0_WRITES_ALL_CBUFS];
+
+    /* The dummy shader is only used after a failure, don't cache it. */
+    use_cache = r300->screen->disk_shader_cache && !shader->dummy;
+    if (use_cache) {
+        r300_fs_cache_key(r300, shader, tokens, key);
+        if (r300_fs_cache_get(r300, shader, key)) {
+            r300_finish_fragment_shader(r300, shader);
+            return;
+        }
+    }
+
     wpos = shader->inputs.wpos;
     face = shader->inputs.face;
 
@@ -453,9 +625,6 @@ static void r300_translate_fragment_shader(
 
     find_output_registers(&compiler, shader);
 
-    shader->write_all =
-          shader->info.properties[TGSI_PROPERTY_FS_COLOR0_WRITES_ALL_CBUFS];
-
     if (compiler.Base.Debug & RC_DBG_LOG) {
         DBG(r300, DBG_FP, "r300: Initial fragment program\n");
         tgsi_dump(tokens, 0);
@@ -522,43 +691,13 @@ static void r300_translate_fragment_shader(
         return;
     }
 
-    /* Initialize numbers of constants for each type. */
-    shader->externals_count = 0;
-    for (i = 0;
-         i < shader->code.constants.Count &&
-         shader->code.constants.Constants[i].Type == RC_CONSTANT_EXTERNAL; i++) {
-        shader->externals_count = i+1;
-    }
-    shader->immediates_count = 0;
-    shader->rc_state_count = 0;
-
-    for (i = shader->externals_count; i < shader->code.constants.Count; i++) {
-        switch (shader->code.constants.Constants[i].Type) {
-            case RC_CONSTANT_IMMEDIATE:
-                ++shader->immediates_count;
-                break;
-            case RC_CONSTANT_STATE:
-                ++shader->rc_state_count;
-                break;
-            default:
-                assert(0);
-        }
-    }
-
-    /* Setup shader depth output. */
-    if (shader->code.writes_depth) {
-        shader->fg_depth_src = R300_FG_DEPTH_SRC_SHADER;
-        shader->us_out_w = R300_W_FMT_W24 | R300_W_SRC_US;
-    } else {
-        shader->fg_depth_src = R300_FG_DEPTH_SRC_SCAN;
-        shader->us_out_w = R300_W_FMT_W0 | R300_W_SRC_US;
-    }
-
     /* And, finally... */
     rc_destroy(&compiler.Base);
 
-    /* Build the command buffer. */
-    r300_emit_fs_code_to_buffer(r300, shader);
+    if (use_cache)
+        r300_fs_cache_put(r300, shader, key);
+
+    r300_finish_fragment_shader(r300, shader);
 }
 
 boolean r300_pick_fragment_shader(struct r300_context* r300)
@@ -21,6 +21,7 @@
  * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
  * USE OR OTHER DEALINGS IN THE SOFTWARE. */
 
+#include "util/disk_cache.h"
 #include "util/u_format.h"
 #include "util/u_format_s3tc.h"
 #include "util/u_memory.h"
@@ -726,6 +727,7 @@ static void r300_destroy_screen(struct pipe_screen* pscreen)
 
     mtx_destroy(&r300screen->cmask_mutex);
     slab_destroy_parent(&r300screen->pool_transfers);
+    disk_cache_destroy(r300screen->disk_shader_cache);
 
     if (rws)
       rws->destroy(rws);
@@ -752,6 +754,31 @@ static boolean r300_fence_finish(struct pipe_screen *screen,
     return rws->fence_wait(rws, fence, timeout);
 }
 
+static void r300_disk_cache_create(struct r300_screen* r300screen)
+{
+    uint32_t mesa_timestamp;
+    char *timestamp_str;
+
+    /* The compiler only prints its dumps when it runs. */
+    if (SCREEN_DBG_ON(r300screen, DBG_FP | DBG_P_STAT))
+        return;
+
+    if (!disk_cache_get_function_timestamp(r300_disk_cache_create,
+                                           &mesa_timestamp))
+        return;
+
+    if (asprintf(&timestamp_str, "%u", mesa_timestamp) == -1)
+        return;
+
+    /* The chip family covers the r300/r400/r500 code paths, and NO_OPT is
+     * the only debug flag that changes the compiled code. */
+    r300screen->disk_shader_cache =
+        disk_cache_create(chip_families[r300screen->caps.family],
+                          timestamp_str,
+                          r300screen->debug & DBG_NO_OPT);
+    free(timestamp_str);
+}
+
 struct pipe_screen* r300_screen_create(struct radeon_winsys *rws,
                                        const struct pipe_screen_config *config)
 {
@@ -793,5 +820,7 @@ struct pipe_screen* r300_screen_create(struct radeon_winsys *rws,
 
     (void) mtx_init(&r300screen->cmask_mutex, mtx_plain);
 
+    r300_disk_cache_create(r300screen);
+
     return &r300screen->screen;
 }
@@ -49,6 +49,10 @@ struct r300_screen {
     /* The MSAA texture with CMASK access; */
     struct pipe_resource *cmask_resource;
     mtx_t cmask_mutex;
+
+    /* Compiled fragment shaders, keyed on the TGSI and the external
+     * state. NULL if disabled. */
+    struct disk_cache *disk_shader_cache;
 };
 
 
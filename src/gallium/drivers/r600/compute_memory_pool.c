@@ -56,6 +56,9 @@ static int compute_memory_promote_item(struct compute_memory_pool *pool,
 	struct compute_memory_item *item, struct pipe_context *pipe,
 	int64_t allocated);
 
+static int64_t compute_memory_find_hole(struct compute_memory_pool *pool,
+	int64_t size_in_dw);
+
 static void compute_memory_move_item(struct compute_memory_pool *pool,
 	struct pipe_resource *src, struct pipe_resource *dst,
 	struct compute_memory_item *item, uint64_t new_start_in_dw,
@@ -247,6 +250,33 @@ int compute_memory_finalize_pending(struct compute_memory_pool* pool,
 		return 0;
 	}
 
+	/* Put the items that fit in the free space of the pool there first,
+	 * that doesn't need to move or copy anything else. */
+	LIST_FOR_EACH_ENTRY_SAFE(item, next, pool->unallocated_list, link) {
+		int64_t size_in_dw = align(item->size_in_dw, ITEM_ALIGNMENT);
+		int64_t start_in_dw;
+
+		if (!(item->status & ITEM_FOR_PROMOTING))
+			continue;
+
+		start_in_dw = compute_memory_find_hole(pool, size_in_dw);
+		if (start_in_dw == -1)
+			continue;
+
+		err = compute_memory_promote_item(pool, item, pipe, start_in_dw);
+		item->status &= ~ITEM_FOR_PROMOTING;
+
+		allocated += size_in_dw;
+		unallocated -= size_in_dw;
+
+		if (err == -1)
+			return -1;
+	}
+
+	if (unallocated == 0) {
+		return 0;
+	}
+
 	if (pool->size_in_dw < allocated + unallocated) {
 		err = compute_memory_grow_defrag_pool(pool, pipe, allocated + unallocated);
 		if (err == -1)
@@ -280,6 +310,7 @@ int compute_memory_finalize_pending(struct compute_memory_pool* pool,
 
 /**
  * Defragments the pool, so that there's no gap between items.
+ * Only the items after the first gap are moved.
  * \param pool	The pool to be defragmented
  * \param src	The origin resource
  * \param dst	The destination resource
@@ -290,15 +321,41 @@ static void compute_memory_defrag(struct compute_memory_pool *pool,
 	struct pipe_context *pipe)
 {
 	struct compute_memory_item *item;
-	int64_t last_pos;
+	int64_t last_pos, first_hole;
 
 	COMPUTE_DBG(pool->screen, "* compute_memory_defrag()\n");
 
-	last_pos = 0;
+	/* The items before the first hole stay where they are */
+	first_hole = 0;
 	LIST_FOR_EACH_ENTRY(item, pool->item_list, link) {
-		if (src != dst || item->start_in_dw != last_pos) {
-			assert(last_pos <= item->start_in_dw);
+		if (item->start_in_dw != first_hole)
+			break;
 
+		first_hole += align(item->size_in_dw, ITEM_ALIGNMENT);
+	}
+
+	/* When changing resources, copy them all at once */
+	if (src != dst && first_hole) {
+		struct r600_context *rctx = (struct r600_context *)pipe;
+		struct pipe_box box;
+
+		COMPUTE_DBG(pool->screen, "  Copying the first %"PRIi64" bytes\n",
+			first_hole * 4);
+
+		u_box_1d(0, first_hole * 4, &box);
+		rctx->b.b.resource_copy_region(pipe,
+				dst, 0, 0, 0, 0,
+				src, 0, &box);
+	}
+
+	last_pos = first_hole;
+	LIST_FOR_EACH_ENTRY(item, pool->item_list, link) {
+		if (item->start_in_dw < first_hole)
+			continue;
+
+		assert(last_pos <= item->start_in_dw);
+
+		if (src != dst || item->start_in_dw != last_pos) {
 			compute_memory_move_item(pool, src, dst,
 					item, last_pos, pipe);
 		}
@@ -323,6 +380,7 @@ static int compute_memory_promote_item(struct compute_memory_pool *pool,
 	struct r600_context *rctx = (struct r600_context *)pipe;
 	struct pipe_resource *src = (struct pipe_resource *)item->real_buffer;
 	struct pipe_resource *dst = (struct pipe_resource *)pool->bo;
+	struct compute_memory_item *pos;
 	struct pipe_box box;
 
 	COMPUTE_DBG(pool->screen, "* compute_memory_promote_item()\n"
@@ -335,8 +393,12 @@ static int compute_memory_promote_item(struct compute_memory_pool *pool,
 	/* Remove the item from the unallocated list */
 	list_del(&item->link);
 
-	/* Add it back to the item_list */
-	list_addtail(&item->link, pool->item_list);
+	/* Add it back to the item_list, which is sorted by start_in_dw */
+	LIST_FOR_EACH_ENTRY(pos, pool->item_list, link) {
+		if (pos->start_in_dw > start_in_dw)
+			break;
+	}
+	list_addtail(&item->link, &pos->link);
 	item->start_in_dw = start_in_dw;
 
 	if (src) {
@@ -359,6 +421,35 @@ static int compute_memory_promote_item(struct compute_memory_pool *pool,
 	return 0;
 }
 
+/**
+ * Looks for free space of \a size_in_dw between the items of the pool or
+ * after the last one.
+ * \return The start of the free space, or -1 if there isn't enough
+ * \see compute_memory_finalize_pending
+ */
+static int64_t compute_memory_find_hole(struct compute_memory_pool *pool,
+	int64_t size_in_dw)
+{
+	struct compute_memory_item *item;
+	int64_t last_end = 0;
+
+	if (!pool->bo)
+		return -1;
+
+	LIST_FOR_EACH_ENTRY(item, pool->item_list, link) {
+		if (item->start_in_dw - last_end >= size_in_dw)
+			return last_end;
+
+		last_end = item->start_in_dw +
+			align(item->size_in_dw, ITEM_ALIGNMENT);
+	}
+
+	if (pool->size_in_dw - last_end >= size_in_dw)
+		return last_end;
+
+	return -1;
+}
+
 /**
  * Moves an item from the \a item_list to the \a unallocated_list.
  * \param item	The item that will be demoted
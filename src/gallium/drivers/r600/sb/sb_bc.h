@@ -33,6 +33,7 @@
 #include <cstdio>
 #include <string>
 #include <vector>
+#include <map>
 #include <stack>
 
 struct r600_bytecode;
@@ -620,12 +621,23 @@ struct shader_stats {
 	void dump_diff(shader_stats &s);
 };
 
+struct pass_stats {
+	unsigned	count;
+	int64_t		time;	// nanoseconds
+
+	pass_stats() : count(), time() {}
+};
+
 class sb_context {
 
 public:
 
 	shader_stats src_stats, opt_stats;
 
+	// time spent in each pass, collected with dump_stat
+	std::map<std::string, pass_stats> pass_time;
+	unsigned cache_hits;
+
 	r600_isa *isa;
 
 	sb_hw_chip hw_chip;
@@ -657,7 +669,10 @@ public:
 	static unsigned dskip_end;
 	static unsigned dskip_mode;
 
-	sb_context() : src_stats(), opt_stats(), isa(0),
+	// shaders smaller than this (in dwords) aren't optimized
+	static unsigned min_ndw;
+
+	sb_context() : src_stats(), opt_stats(), cache_hits(), isa(0),
 			hw_chip(HW_CHIP_UNKNOWN), hw_class(HW_CLASS_UNKNOWN) {}
 
 	int init(r600_isa *isa, sb_hw_chip chip, sb_hw_class cclass);
@@ -29,6 +29,7 @@
 #include "util/os_time.h"
 #include "r600_pipe.h"
 #include "r600_shader.h"
+#include "util/disk_cache.h"
 
 #include "sb_public.h"
 
@@ -67,6 +68,8 @@ sb_context *r600_sb_context_create(struct r600_context *rctx) {
 	sb_context::dskip_end = debug_get_num_option("R600_SB_DSKIP_END", 0);
 	sb_context::dskip_mode = debug_get_num_option("R600_SB_DSKIP_MODE", 0);
 
+	sb_context::min_ndw = debug_get_num_option("R600_SB_MIN_DW", 16);
+
 	return sctx;
 }
 
@@ -81,12 +84,97 @@ void r600_sb_context_destroy(void * sctx) {
 			ctx->opt_stats.dump();
 			sblog << "context diff: ";
 			ctx->src_stats.dump_diff(ctx->opt_stats);
+
+			sblog << "context pass times:\n";
+			for (std::map<std::string, pass_stats>::iterator
+					I = ctx->pass_time.begin(), E = ctx->pass_time.end();
+					I != E; ++I) {
+				sblog << "  " << I->first << ": " << I->second.count
+						<< " runs, " << I->second.time / 1000000.0 << " ms\n";
+			}
+			sblog << "context cache hits: " << ctx->cache_hits << "\n";
 		}
 
 		delete ctx;
 	}
 }
 
+/* The optimized bytecode only depends on the source bytecode and on the
+ * parts of r600_shader that bc_parser looks at, so that's the cache key.
+ * The chip and the debug flags are part of the cache's driver keys.
+ */
+static void r600_sb_cache_key(struct disk_cache *cache,
+                              struct r600_bytecode *bc,
+                              struct r600_shader *pshader,
+                              cache_key key) {
+	std::vector<uint32_t> data(bc->bytecode, bc->bytecode + bc->ndw);
+
+	data.push_back(bc->type);
+	data.push_back(bc->ngpr);
+	data.push_back(bc->nstack);
+	data.push_back(sb_context::safe_math);
+
+	data.push_back(pshader->vs_as_ls);
+	data.push_back(pshader->vs_as_es);
+	data.push_back(pshader->tes_as_es);
+	data.push_back(pshader->needs_scratch_space);
+	data.push_back(pshader->indirect_files);
+
+	data.push_back(pshader->num_arrays);
+	for (unsigned i = 0; i < pshader->num_arrays; ++i) {
+		data.push_back(pshader->arrays[i].gpr_start);
+		data.push_back(pshader->arrays[i].gpr_count);
+		data.push_back(pshader->arrays[i].comp_mask);
+	}
+
+	data.push_back(pshader->ninput);
+	for (unsigned i = 0; i < pshader->ninput; ++i) {
+		data.push_back(pshader->input[i].gpr);
+		data.push_back(pshader->input[i].spi_sid);
+		data.push_back(pshader->input[i].interpolate);
+		data.push_back(pshader->input[i].interpolate_location);
+	}
+
+	disk_cache_compute_key(cache, data.data(), data.size() * 4, key);
+}
+
+/* Cache entries are { ndw, ngpr, nstack, bytecode[ndw] }. */
+static bool r600_sb_cache_load(struct disk_cache *cache, cache_key key,
+                               struct r600_bytecode *bc) {
+	size_t size;
+	uint32_t *data = (uint32_t*)disk_cache_get(cache, key, &size);
+
+	if (!data)
+		return false;
+
+	if (size < 12 || size != (3 + data[0]) * 4) {
+		free(data);
+		return false;
+	}
+
+	free(bc->bytecode);
+	bc->ndw = data[0];
+	bc->bytecode = (uint32_t*) malloc(bc->ndw << 2);
+	memcpy(bc->bytecode, data + 3, bc->ndw << 2);
+	bc->ngpr = data[1];
+	bc->nstack = data[2];
+
+	free(data);
+	return true;
+}
+
+static void r600_sb_cache_store(struct disk_cache *cache, cache_key key,
+                                struct r600_bytecode *bc) {
+	std::vector<uint32_t> data;
+
+	data.push_back(bc->ndw);
+	data.push_back(bc->ngpr);
+	data.push_back(bc->nstack);
+	data.insert(data.end(), bc->bytecode, bc->bytecode + bc->ndw);
+
+	disk_cache_put(cache, key, data.data(), data.size() * 4, NULL);
+}
+
 int r600_sb_bytecode_process(struct r600_context *rctx,
                              struct r600_bytecode *bc,
                              struct r600_shader *pshader,
@@ -107,6 +195,40 @@ int r600_sb_bytecode_process(struct r600_context *rctx,
 
 	SB_DUMP_STAT( sblog << "\nsb: shader " << shader_id << "\n"; );
 
+	/* Tiny shaders don't gain enough from the optimizer to pay for it;
+	 * keep the bytecode of the default backend.
+	 */
+	if (optimize && bc->ndw < sb_context::min_ndw) {
+		SB_DUMP_STAT( sblog << "sb: shader " << shader_id << " is too small ("
+				<< bc->ndw << " dw), not optimized\n"; );
+		optimize = 0;
+	}
+
+	if (!optimize && !dump_bytecode)
+		return 0;
+
+	/* The optimized bytecode of the same input is the same, so it can be
+	 * reused from the shader cache. Dumping and skipping need the whole
+	 * pipeline, don't use the cache for them.
+	 */
+	struct disk_cache *cache = rctx->screen->b.disk_shader_cache;
+	cache_key key;
+
+	if (!optimize || dump_bytecode || sb_context::dry_run ||
+			sb_context::dump_pass || sb_context::dskip_mode)
+		cache = NULL;
+
+	if (cache) {
+		r600_sb_cache_key(cache, bc, pshader, key);
+
+		if (r600_sb_cache_load(cache, key, bc)) {
+			SB_DUMP_STAT( sblog << "sb: shader " << shader_id
+					<< " loaded from the cache\n"; );
+			ctx->cache_hits++;
+			return 0;
+		}
+	}
+
 	bc_parser parser(*ctx, bc, pshader);
 
 	if ((r = parser.decode())) {
@@ -159,7 +281,13 @@ int r600_sb_bytecode_process(struct r600_context *rctx,
 
 #define SB_RUN_PASS(n, dump) \
 	do { \
+		int64_t pass_start = sb_context::dump_stat ? os_time_get_nano() : 0; \
 		r = n(*sh).run(); \
+		if (sb_context::dump_stat) { \
+			pass_stats &ps = ctx->pass_time[#n]; \
+			ps.count++; \
+			ps.time += os_time_get_nano() - pass_start; \
+		} \
 		if (r) { \
 			sblog << "sb: error (" << r << ") in the " << #n << " pass.\n"; \
 			if (sb_context::no_fallback) \
@@ -262,6 +390,9 @@ int r600_sb_bytecode_process(struct r600_context *rctx,
 
 		bc->ngpr = sh->ngpr;
 		bc->nstack = sh->nstack;
+
+		if (cache)
+			r600_sb_cache_store(cache, key, bc);
 	} else {
 		SB_DUMP_STAT( sblog << "sb: dry run: optimized bytecode is not used\n"; );
 	}
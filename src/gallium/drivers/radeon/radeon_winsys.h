@@ -113,6 +113,13 @@ enum radeon_value_id {
     RADEON_CURRENT_MCLK,
     RADEON_GPU_RESET_COUNTER, /* DRM 2.43.0 */
     RADEON_CS_THREAD_TIME,
+    RADEON_NUM_FENCE_DEPS_SCANNED, /* BO fences checked for dependencies */
+    RADEON_NUM_FENCE_DEPS_ADDED, /* BO fences turned into dependencies */
+    RADEON_BUFFER_CACHE_HITS,
+    RADEON_BUFFER_CACHE_MISSES,
+    RADEON_BUFFER_CACHE_SIZE, /* bytes of unused buffers kept for reuse */
+    RADEON_VA_CACHE_HITS, /* buffers created on a recycled VA range */
+    RADEON_HUGE_ALIGNED_MEMORY, /* bytes of buffers on 2MB-aligned VA */
 };
 
 enum radeon_bo_priority {
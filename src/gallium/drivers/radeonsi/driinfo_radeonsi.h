@@ -3,6 +3,7 @@ DRI_CONF_SECTION_PERFORMANCE
     DRI_CONF_RADEONSI_ENABLE_SISCHED("false")
     DRI_CONF_RADEONSI_ASSUME_NO_Z_FIGHTS("false")
     DRI_CONF_RADEONSI_COMMUTATIVE_BLEND_ADD("false")
+    DRI_CONF_RADEONSI_DPBB_MIN_BIN_SIZE(0)
 DRI_CONF_SECTION_END
 
 DRI_CONF_SECTION_DEBUG
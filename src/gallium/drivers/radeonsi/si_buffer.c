@@ -29,6 +29,9 @@
 #include <inttypes.h>
 #include <stdio.h>
 
+/* Staging uploads at least this large go through SDMA if possible. */
+#define SI_SDMA_UPLOAD_MIN_SIZE (64 * 1024)
+
 bool si_rings_is_buffer_referenced(struct si_context *sctx,
 				   struct pb_buffer *buf,
 				   enum radeon_bo_usage usage)
@@ -436,6 +439,18 @@ static void *si_buffer_transfer_map(struct pipe_context *ctx,
 		}
 	}
 
+	/* Write-only mappings with explicit flushes only modify the flushed
+	 * ranges, and only those are copied from a temporary buffer, so they
+	 * can use one without a discard too.
+	 */
+	if ((usage & (PIPE_TRANSFER_READ |
+		      PIPE_TRANSFER_WRITE |
+		      PIPE_TRANSFER_FLUSH_EXPLICIT |
+		      PIPE_TRANSFER_PERSISTENT |
+		      PIPE_TRANSFER_UNSYNCHRONIZED)) ==
+	    (PIPE_TRANSFER_WRITE | PIPE_TRANSFER_FLUSH_EXPLICIT))
+		usage |= PIPE_TRANSFER_DISCARD_RANGE;
+
 	if ((usage & PIPE_TRANSFER_DISCARD_RANGE) &&
 	    ((!(usage & (PIPE_TRANSFER_UNSYNCHRONIZED |
 			 PIPE_TRANSFER_PERSISTENT))) ||
@@ -517,6 +532,7 @@ static void si_buffer_do_flush_region(struct pipe_context *ctx,
 				      struct pipe_transfer *transfer,
 				      const struct pipe_box *box)
 {
+	struct si_context *sctx = (struct si_context*)ctx;
 	struct si_transfer *stransfer = (struct si_transfer*)transfer;
 	struct r600_resource *rbuffer = r600_resource(transfer->resource);
 
@@ -531,8 +547,19 @@ static void si_buffer_do_flush_region(struct pipe_context *ctx,
 
 		u_box_1d(soffset, box->width, &dma_box);
 
-		/* Copy the staging buffer into the original one. */
-		ctx->resource_copy_region(ctx, dst, 0, box->x, 0, 0, src, 0, &dma_box);
+		/* Copy the staging buffer into the original one.
+		 *
+		 * Large uploads use SDMA, so that they overlap rendering,
+		 * unless the current gfx IB uses the buffer, because then
+		 * si_need_dma_space would have to flush the gfx IB.
+		 */
+		if (sctx->dma_cs &&
+		    box->width >= SI_SDMA_UPLOAD_MIN_SIZE &&
+		    !sctx->ws->cs_is_buffer_referenced(sctx->gfx_cs, rbuffer->buf,
+						       RADEON_USAGE_READWRITE))
+			sctx->dma_copy(ctx, dst, 0, box->x, 0, 0, src, 0, &dma_box);
+		else
+			ctx->resource_copy_region(ctx, dst, 0, box->x, 0, 0, src, 0, &dma_box);
 	}
 
 	util_range_add(&rbuffer->valid_buffer_range, box->x,
@@ -910,8 +910,14 @@ static void si_launch_grid(
 	if (program->ir_type != PIPE_SHADER_IR_NATIVE)
 		si_setup_tgsi_grid(sctx, info);
 
+	if (unlikely(sctx->draw_trace))
+		si_draw_trace_emit_begin(sctx);
+
 	si_emit_dispatch_packets(sctx, info);
 
+	if (unlikely(sctx->draw_trace))
+		si_draw_trace_emit_dispatch_end(sctx, &program->shader, info);
+
 	if (unlikely(sctx->current_saved_cs)) {
 		si_trace_emit(sctx);
 		si_log_compute_state(sctx, sctx->log);
@@ -0,0 +1,314 @@
+/*
+ * Copyright 2018 Advanced Micro Devices, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/* Per-draw GPU timing (AMD_DEBUG=drawtrace).
+ *
+ * Each draw and dispatch is bracketed by two bottom-of-pipe timestamps
+ * written into a buffer that belongs to the IB. The first one is written
+ * when all previous work has finished and the second one when the draw has
+ * finished, so the difference is the time the GPU spent on the draw after
+ * the previous work drained. Overlapping draws are attributed to the later
+ * one.
+ *
+ * The buffers of flushed IBs are read back once their fence has signalled,
+ * without waiting, and the events are appended to a Chrome trace file
+ * (JSON array format) that chrome://tracing and Perfetto can load. Every
+ * context is a separate thread of the trace. The events are tagged with a
+ * hash of the shader binaries, so that the same shader can be found in
+ * traces of different runs.
+ *
+ * AMD_DRAW_TRACE_FILE sets the file name. The default is
+ * radeonsi_draws_<pid>.json in the current directory.
+ */
+
+#include "si_pipe.h"
+#include "sid.h"
+#include "util/hash_table.h"
+#include "util/u_memory.h"
+#include "util/u_string.h"
+
+#include <inttypes.h>
+#include <unistd.h>
+
+/* Draws after this many in one IB are not traced. */
+#define SI_DRAW_TRACE_MAX_EVENTS	4096
+
+struct si_draw_trace_event {
+	bool		compute;
+	uint32_t	hash[2]; /* VS and PS, or CS */
+	uint32_t	count[3]; /* count, instances, indirect; or grid size */
+};
+
+struct si_draw_trace_ib {
+	struct list_head		list;
+	struct r600_resource		*buf; /* 2 timestamps per event */
+	struct pipe_fence_handle	*fence;
+	unsigned			num_events;
+	struct si_draw_trace_event	events[SI_DRAW_TRACE_MAX_EVENTS];
+};
+
+static uint32_t si_shader_trace_hash(struct si_shader *shader)
+{
+	if (!shader || !shader->binary.code)
+		return 0;
+
+	if (!shader->trace_hash) {
+		shader->trace_hash = _mesa_hash_data(shader->binary.code,
+						     shader->binary.code_size);
+	}
+	return shader->trace_hash;
+}
+
+void si_draw_trace_init_screen(struct si_screen *sscreen)
+{
+	char default_name[64];
+	const char *name;
+
+	if (!(sscreen->debug_flags & DBG(DRAW_TRACE)))
+		return;
+
+	util_snprintf(default_name, sizeof(default_name),
+		      "radeonsi_draws_%i.json", (int)getpid());
+	name = debug_get_option("AMD_DRAW_TRACE_FILE", default_name);
+
+	sscreen->draw_trace_file = fopen(name, "w");
+	if (!sscreen->draw_trace_file) {
+		fprintf(stderr, "radeonsi: can't open the draw trace %s\n", name);
+		return;
+	}
+
+	(void) mtx_init(&sscreen->draw_trace_lock, mtx_plain);
+	fprintf(sscreen->draw_trace_file, "[\n");
+}
+
+void si_draw_trace_destroy_screen(struct si_screen *sscreen)
+{
+	if (!sscreen->draw_trace_file)
+		return;
+
+	fprintf(sscreen->draw_trace_file, "\n]\n");
+	fclose(sscreen->draw_trace_file);
+	mtx_destroy(&sscreen->draw_trace_lock);
+}
+
+static void si_draw_trace_write(struct si_context *sctx,
+				struct si_draw_trace_ib *ib)
+{
+	struct si_screen *sscreen = sctx->screen;
+	FILE *f = sscreen->draw_trace_file;
+	/* The timestamps count at the crystal frequency, given in kHz. */
+	double ticks_to_us = 1000.0 / sscreen->info.clock_crystal_freq;
+	uint64_t *ts;
+
+	ts = sctx->ws->buffer_map(ib->buf->buf, NULL,
+				  PIPE_TRANSFER_READ |
+				  PIPE_TRANSFER_UNSYNCHRONIZED);
+	if (!ts)
+		return;
+
+	mtx_lock(&sscreen->draw_trace_lock);
+	for (unsigned i = 0; i < ib->num_events; i++) {
+		struct si_draw_trace_event *e = &ib->events[i];
+		uint64_t begin = ts[i * 2];
+		uint64_t end = MAX2(ts[i * 2 + 1], begin);
+
+		fprintf(f, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":%i,"
+			"\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,\"args\":{",
+			sscreen->draw_trace_has_events ? ",\n" : "",
+			e->compute ? "dispatch" : "draw", (int)getpid(),
+			sctx->draw_trace_id, begin * ticks_to_us,
+			(end - begin) * ticks_to_us);
+
+		if (e->compute) {
+			fprintf(f, "\"cs\":\"%08x\",\"grid\":\"%ux%ux%u\"}}",
+				e->hash[0], e->count[0], e->count[1],
+				e->count[2]);
+		} else if (e->count[2]) {
+			fprintf(f, "\"vs\":\"%08x\",\"ps\":\"%08x\","
+				"\"indirect\":true}}", e->hash[0], e->hash[1]);
+		} else {
+			fprintf(f, "\"vs\":\"%08x\",\"ps\":\"%08x\","
+				"\"count\":%u,\"instances\":%u}}",
+				e->hash[0], e->hash[1], e->count[0],
+				e->count[1]);
+		}
+		sscreen->draw_trace_has_events = true;
+	}
+	fflush(f);
+	mtx_unlock(&sscreen->draw_trace_lock);
+
+	sctx->ws->buffer_unmap(ib->buf->buf);
+}
+
+static void si_draw_trace_free_ib(struct si_context *sctx,
+				  struct si_draw_trace_ib *ib)
+{
+	r600_resource_reference(&ib->buf, NULL);
+	sctx->ws->fence_reference(&ib->fence, NULL);
+	FREE(ib);
+}
+
+/* Write the events of flushed IBs in submission order, stopping at the
+ * first one that is still busy unless "wait" is set.
+ */
+static void si_draw_trace_process(struct si_context *sctx, bool wait)
+{
+	struct si_draw_trace_ib *ib, *tmp;
+
+	LIST_FOR_EACH_ENTRY_SAFE(ib, tmp, &sctx->draw_trace_pending, list) {
+		if (!sctx->ws->fence_wait(sctx->ws, ib->fence,
+					  wait ? PIPE_TIMEOUT_INFINITE : 0))
+			break;
+
+		si_draw_trace_write(sctx, ib);
+		LIST_DEL(&ib->list);
+		si_draw_trace_free_ib(sctx, ib);
+	}
+}
+
+void si_draw_trace_init_context(struct si_context *sctx)
+{
+	LIST_INITHEAD(&sctx->draw_trace_pending);
+
+	if (sctx->screen->draw_trace_file) {
+		sctx->draw_trace_id =
+			p_atomic_inc_return(&sctx->screen->draw_trace_num_contexts);
+	}
+}
+
+void si_draw_trace_destroy_context(struct si_context *sctx)
+{
+	if (!sctx->screen->draw_trace_file)
+		return;
+
+	if (sctx->draw_trace) {
+		si_draw_trace_free_ib(sctx, sctx->draw_trace);
+		sctx->draw_trace = NULL;
+	}
+	si_draw_trace_process(sctx, true);
+}
+
+void si_draw_trace_begin_ib(struct si_context *sctx)
+{
+	struct si_draw_trace_ib *ib;
+
+	if (!sctx->screen->draw_trace_file)
+		return;
+
+	si_draw_trace_process(sctx, false);
+
+	assert(!sctx->draw_trace);
+	ib = CALLOC_STRUCT(si_draw_trace_ib);
+	if (!ib)
+		return;
+
+	ib->buf = r600_resource(
+		pipe_buffer_create(&sctx->screen->b, 0, PIPE_USAGE_STAGING,
+				   SI_DRAW_TRACE_MAX_EVENTS * 16));
+	if (!ib->buf) {
+		FREE(ib);
+		return;
+	}
+	sctx->draw_trace = ib;
+}
+
+/* Call after the IB has been flushed. */
+void si_draw_trace_end_ib(struct si_context *sctx)
+{
+	struct si_draw_trace_ib *ib = sctx->draw_trace;
+
+	if (!ib)
+		return;
+
+	sctx->draw_trace = NULL;
+	if (!ib->num_events) {
+		si_draw_trace_free_ib(sctx, ib);
+		return;
+	}
+
+	sctx->ws->fence_reference(&ib->fence, sctx->last_gfx_fence);
+	LIST_ADDTAIL(&ib->list, &sctx->draw_trace_pending);
+}
+
+static void si_draw_trace_emit_timestamp(struct si_context *sctx,
+					 struct si_draw_trace_ib *ib,
+					 unsigned index)
+{
+	si_gfx_write_event_eop(sctx, V_028A90_BOTTOM_OF_PIPE_TS, 0,
+			       EOP_DATA_SEL_TIMESTAMP, ib->buf,
+			       ib->buf->gpu_address + ib->num_events * 16 +
+			       index * 8, 0, PIPE_QUERY_TIMESTAMP);
+}
+
+void si_draw_trace_emit_begin(struct si_context *sctx)
+{
+	struct si_draw_trace_ib *ib = sctx->draw_trace;
+
+	if (ib && ib->num_events < SI_DRAW_TRACE_MAX_EVENTS)
+		si_draw_trace_emit_timestamp(sctx, ib, 0);
+}
+
+static struct si_draw_trace_event *
+si_draw_trace_emit_end(struct si_context *sctx)
+{
+	struct si_draw_trace_ib *ib = sctx->draw_trace;
+
+	if (!ib || ib->num_events == SI_DRAW_TRACE_MAX_EVENTS)
+		return NULL;
+
+	si_draw_trace_emit_timestamp(sctx, ib, 1);
+	return &ib->events[ib->num_events++];
+}
+
+void si_draw_trace_emit_draw_end(struct si_context *sctx,
+				 const struct pipe_draw_info *info)
+{
+	struct si_draw_trace_event *e = si_draw_trace_emit_end(sctx);
+
+	if (!e)
+		return;
+
+	e->compute = false;
+	e->hash[0] = si_shader_trace_hash(sctx->vs_shader.current);
+	e->hash[1] = si_shader_trace_hash(sctx->ps_shader.current);
+	e->count[0] = info->count;
+	e->count[1] = info->instance_count;
+	e->count[2] = info->indirect != NULL;
+}
+
+void si_draw_trace_emit_dispatch_end(struct si_context *sctx,
+				     struct si_shader *shader,
+				     const struct pipe_grid_info *info)
+{
+	struct si_draw_trace_event *e = si_draw_trace_emit_end(sctx);
+
+	if (!e)
+		return;
+
+	e->compute = true;
+	e->hash[0] = si_shader_trace_hash(shader);
+	e->hash[1] = 0;
+	for (unsigned i = 0; i < 3; i++)
+		e->count[i] = info->indirect ? 0 : info->grid[i];
+}
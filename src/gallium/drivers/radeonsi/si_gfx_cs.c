@@ -147,6 +147,8 @@ void si_flush_gfx_cs(struct si_context *ctx, unsigned flags,
 	if (fence)
 		ws->fence_reference(fence, ctx->last_gfx_fence);
 
+	si_draw_trace_end_ib(ctx);
+
 	ctx->num_gfx_cs_flushes++;
 
 	/* Check VM faults if needed. */
@@ -200,6 +202,8 @@ void si_begin_new_gfx_cs(struct si_context *ctx)
 	if (ctx->is_debug)
 		si_begin_gfx_cs_debug(ctx);
 
+	si_draw_trace_begin_ib(ctx);
+
 	/* Always invalidate caches at the beginning of IBs, because external
 	 * users (e.g. BO evictions and SDMA/UVD/VCE IBs) can modify our
 	 * buffers.
@@ -25,6 +25,7 @@
 
 #include "si_pipe.h"
 #include "si_public.h"
+#include "si_compute.h"
 #include "si_shader_internal.h"
 #include "sid.h"
 
@@ -70,6 +71,7 @@ static const struct debug_named_value debug_options[] = {
 	{ "tex", DBG(TEX), "Print texture info" },
 	{ "compute", DBG(COMPUTE), "Print compute info" },
 	{ "vm", DBG(VM), "Print virtual addresses when creating resources" },
+	{ "drawtrace", DBG(DRAW_TRACE), "Write the GPU time of every draw and dispatch to a Chrome trace (see AMD_DRAW_TRACE_FILE)" },
 
 	/* Driver options: */
 	{ "forcedma", DBG(FORCE_DMA), "Use asynchronous DMA for all operations when possible." },
@@ -78,6 +80,7 @@ static const struct debug_named_value debug_options[] = {
 	{ "check_vm", DBG(CHECK_VM), "Check VM faults and dump debug info." },
 	{ "reserve_vmid", DBG(RESERVE_VMID), "Force VMID reservation per context." },
 	{ "zerovram", DBG(ZERO_VRAM), "Clear VRAM allocations." },
+	{ "nobolistreuse", DBG(NO_BO_LIST_REUSE), "Create a new kernel buffer list for every submission." },
 
 	/* 3D engine options: */
 	{ "switch_on_eop", DBG(SWITCH_ON_EOP), "Program WD/IA to switch on end-of-packet." },
@@ -211,6 +214,8 @@ static void si_destroy_context(struct pipe_context *context)
 	if (sctx->query_result_shader)
 		sctx->b.delete_compute_state(&sctx->b, sctx->query_result_shader);
 
+	si_draw_trace_destroy_context(sctx);
+
 	if (sctx->gfx_cs)
 		sctx->ws->cs_destroy(sctx->gfx_cs);
 	if (sctx->dma_cs)
@@ -374,6 +379,7 @@ static struct pipe_context *si_create_context(struct pipe_screen *screen,
 	sctx->ws = sscreen->ws;
 	sctx->family = sscreen->info.family;
 	sctx->chip_class = sscreen->info.chip_class;
+	si_draw_trace_init_context(sctx);
 
 	if (sscreen->info.has_gpu_reset_counter_query) {
 		sctx->gpu_reset_counter =
@@ -625,6 +631,32 @@ static struct pipe_context *si_pipe_create_context(struct pipe_screen *screen,
 /*
  * pipe_screen
  */
+static void si_set_max_shader_compiler_threads(struct pipe_screen *screen,
+					       unsigned max_threads)
+{
+	struct si_screen *sscreen = (struct si_screen *)screen;
+
+	/* This function doesn't allow a greater number of threads than
+	 * the queue had at its creation. */
+	util_queue_adjust_num_threads(&sscreen->shader_compiler_queue,
+				      max_threads);
+	/* Don't change the number of threads on the low priority queue. */
+}
+
+static bool si_is_parallel_shader_compilation_finished(struct pipe_screen *screen,
+						       void *shader,
+						       unsigned shader_type)
+{
+	if (shader_type == PIPE_SHADER_COMPUTE) {
+		struct si_compute *cs = (struct si_compute*)shader;
+
+		return util_queue_fence_is_signalled(&cs->ready);
+	}
+	struct si_shader_selector *sel = (struct si_shader_selector *)shader;
+
+	return util_queue_fence_is_signalled(&sel->ready);
+}
+
 static void si_destroy_screen(struct pipe_screen* pscreen)
 {
 	struct si_screen *sscreen = (struct si_screen *)pscreen;
@@ -663,6 +695,7 @@ static void si_destroy_screen(struct pipe_screen* pscreen)
 	si_destroy_shader_cache(sscreen);
 
 	si_perfcounters_destroy(sscreen);
+	si_draw_trace_destroy_screen(sscreen);
 	si_gpu_load_kill_thread(sscreen);
 
 	mtx_destroy(&sscreen->gpu_load_mutex);
@@ -809,6 +842,10 @@ struct pipe_screen *radeonsi_screen_create(struct radeon_winsys *ws,
 	/* Set functions first. */
 	sscreen->b.context_create = si_pipe_create_context;
 	sscreen->b.destroy = si_destroy_screen;
+	sscreen->b.set_max_shader_compiler_threads =
+		si_set_max_shader_compiler_threads;
+	sscreen->b.is_parallel_shader_compilation_finished =
+		si_is_parallel_shader_compilation_finished;
 
 	si_init_screen_get_functions(sscreen);
 	si_init_screen_buffer_functions(sscreen);
@@ -873,9 +910,12 @@ struct pipe_screen *radeonsi_screen_create(struct radeon_winsys *ws,
 	num_comp_lo_threads = MIN2(num_comp_lo_threads,
 				   ARRAY_SIZE(sscreen->compiler_lowp));
 
+	/* Compiler jobs don't wait for other queues, so they can run on the
+	 * shared workers. */
 	if (!util_queue_init(&sscreen->shader_compiler_queue, "sh",
 			     64, num_comp_hi_threads,
-			     UTIL_QUEUE_INIT_RESIZE_IF_FULL)) {
+			     UTIL_QUEUE_INIT_RESIZE_IF_FULL |
+			     UTIL_QUEUE_INIT_SHARED)) {
 		si_destroy_shader_cache(sscreen);
 		FREE(sscreen);
 		return NULL;
@@ -885,7 +925,8 @@ struct pipe_screen *radeonsi_screen_create(struct radeon_winsys *ws,
 			     "shlo",
 			     64, num_comp_lo_threads,
 			     UTIL_QUEUE_INIT_RESIZE_IF_FULL |
-			     UTIL_QUEUE_INIT_USE_MINIMUM_PRIORITY)) {
+			     UTIL_QUEUE_INIT_USE_MINIMUM_PRIORITY |
+			     UTIL_QUEUE_INIT_SHARED)) {
 	       si_destroy_shader_cache(sscreen);
 	       FREE(sscreen);
 	       return NULL;
@@ -894,6 +935,8 @@ struct pipe_screen *radeonsi_screen_create(struct radeon_winsys *ws,
 	if (!debug_get_bool_option("RADEON_DISABLE_PERFCOUNTERS", false))
 		si_init_perfcounters(sscreen);
 
+	si_draw_trace_init_screen(sscreen);
+
 	/* Determine tessellation ring info. */
 	bool double_offchip_buffers = sscreen->info.chip_class >= CIK &&
 				      sscreen->info.family != CHIP_CARRIZO &&
@@ -987,6 +1030,16 @@ struct pipe_screen *radeonsi_screen_create(struct radeon_winsys *ws,
 					!(sscreen->debug_flags & DBG(NO_DPBB));
 	}
 
+	/* Bins that are larger than what the default tables select can be
+	 * a win for many render targets, which otherwise get very small
+	 * bins. The hardware supports 16 to 512 pixels.
+	 */
+	unsigned min_bin_size =
+		driQueryOptioni(config->options, "radeonsi_dpbb_min_bin_size");
+	if (min_bin_size)
+		sscreen->dpbb_min_bin_size =
+			MIN2(util_next_power_of_two(MAX2(min_bin_size, 16)), 512);
+
 	if (sscreen->debug_flags & DBG(DFSM)) {
 		sscreen->dfsm_allowed = sscreen->dpbb_allowed;
 	} else {
@@ -134,6 +134,7 @@ enum {
 	DBG_TEX,
 	DBG_COMPUTE,
 	DBG_VM,
+	DBG_DRAW_TRACE,
 
 	/* Driver options: */
 	DBG_FORCE_DMA,
@@ -142,6 +143,7 @@ enum {
 	DBG_CHECK_VM,
 	DBG_RESERVE_VMID,
 	DBG_ZERO_VRAM,
+	DBG_NO_BO_LIST_REUSE,
 
 	/* 3D engine options: */
 	DBG_SWITCH_ON_EOP,
@@ -171,6 +173,7 @@ enum {
 #define DBG(name)		(1ull << DBG_##name)
 
 struct si_compute;
+struct si_draw_trace_ib;
 struct hash_table;
 struct u_suballocator;
 
@@ -422,6 +425,7 @@ struct si_screen {
 	bool				has_ls_vgpr_init_bug;
 	bool				dpbb_allowed;
 	bool				dfsm_allowed;
+	unsigned			dpbb_min_bin_size; /* 0 or a power of two */
 	bool				llvm_has_working_vgpr_indexing;
 
 	/* Whether shaders are monolithic (1-part) or separate (3-part). */
@@ -461,6 +465,12 @@ struct si_screen {
 	/* Performance counters. */
 	struct si_perfcounters	*perfcounters;
 
+	/* AMD_DEBUG=drawtrace: all contexts write to the same trace. */
+	mtx_t				draw_trace_lock;
+	FILE				*draw_trace_file;
+	unsigned			draw_trace_num_contexts;
+	bool				draw_trace_has_events;
+
 	/* If pipe_screen wants to recompute and re-emit the framebuffer,
 	 * sampler, and image states of all contexts, it should atomically
 	 * increment this.
@@ -506,9 +516,18 @@ struct si_screen {
 	 *   variants of VS and TES are cached, so LS and ES aren't.
 	 * - GS and CS aren't cached, but it's certainly possible to cache
 	 *   those as well.
+	 *
+	 * shader_bo_cache maps uploaded shader code to the buffer holding it,
+	 * so that shaders with identical code share one buffer, e.g. the same
+	 * shaders created by different contexts. It holds a reference to each
+	 * buffer. Entries that nobody else references are pruned when the
+	 * table has grown to shader_bo_cache_prune_size. Both are guarded by
+	 * shader_cache_mutex too.
 	 */
 	mtx_t			shader_cache_mutex;
 	struct hash_table		*shader_cache;
+	struct hash_table		*shader_bo_cache;
+	unsigned			shader_bo_cache_prune_size;
 
 	/* Shader compiler queue for multithreaded compilation. */
 	struct util_queue		shader_compiler_queue;
@@ -916,6 +935,11 @@ struct si_context {
 	uint64_t		dmesg_timestamp;
 	unsigned		apitrace_call_number;
 
+	/* AMD_DEBUG=drawtrace */
+	struct si_draw_trace_ib	*draw_trace; /* for the current IB */
+	struct list_head	draw_trace_pending; /* flushed IBs */
+	unsigned		draw_trace_id;
+
 	/* Other state */
 	bool need_check_render_feedback;
 	bool			decompression_enabled;
@@ -1140,6 +1164,20 @@ bool si_replace_shader(unsigned num, struct ac_shader_binary *binary);
 /* si_dma.c */
 void si_init_dma_functions(struct si_context *sctx);
 
+/* si_draw_trace.c */
+void si_draw_trace_init_screen(struct si_screen *sscreen);
+void si_draw_trace_destroy_screen(struct si_screen *sscreen);
+void si_draw_trace_init_context(struct si_context *sctx);
+void si_draw_trace_destroy_context(struct si_context *sctx);
+void si_draw_trace_begin_ib(struct si_context *sctx);
+void si_draw_trace_end_ib(struct si_context *sctx);
+void si_draw_trace_emit_begin(struct si_context *sctx);
+void si_draw_trace_emit_draw_end(struct si_context *sctx,
+				 const struct pipe_draw_info *info);
+void si_draw_trace_emit_dispatch_end(struct si_context *sctx,
+				     struct si_shader *shader,
+				     const struct pipe_grid_info *info);
+
 /* si_dma_cs.c */
 void si_need_dma_space(struct si_context *ctx, unsigned num_dw,
 		       struct r600_resource *dst, struct r600_resource *src);
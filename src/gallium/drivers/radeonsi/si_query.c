@@ -82,6 +82,13 @@ static enum radeon_value_id winsys_id_from_type(unsigned type)
 	case SI_QUERY_NUM_BYTES_MOVED: return RADEON_NUM_BYTES_MOVED;
 	case SI_QUERY_NUM_EVICTIONS: return RADEON_NUM_EVICTIONS;
 	case SI_QUERY_NUM_VRAM_CPU_PAGE_FAULTS: return RADEON_NUM_VRAM_CPU_PAGE_FAULTS;
+	case SI_QUERY_NUM_FENCE_DEPS_SCANNED: return RADEON_NUM_FENCE_DEPS_SCANNED;
+	case SI_QUERY_NUM_FENCE_DEPS_ADDED: return RADEON_NUM_FENCE_DEPS_ADDED;
+	case SI_QUERY_BUFFER_CACHE_HITS: return RADEON_BUFFER_CACHE_HITS;
+	case SI_QUERY_BUFFER_CACHE_MISSES: return RADEON_BUFFER_CACHE_MISSES;
+	case SI_QUERY_BUFFER_CACHE_SIZE: return RADEON_BUFFER_CACHE_SIZE;
+	case SI_QUERY_VA_CACHE_HITS: return RADEON_VA_CACHE_HITS;
+	case SI_QUERY_HUGE_ALIGNED_MEMORY: return RADEON_HUGE_ALIGNED_MEMORY;
 	case SI_QUERY_VRAM_USAGE: return RADEON_VRAM_USAGE;
 	case SI_QUERY_VRAM_VIS_USAGE: return RADEON_VRAM_VIS_USAGE;
 	case SI_QUERY_GTT_USAGE: return RADEON_GTT_USAGE;
@@ -170,6 +177,8 @@ static bool si_query_sw_begin(struct si_context *sctx,
 	case SI_QUERY_VRAM_USAGE:
 	case SI_QUERY_VRAM_VIS_USAGE:
 	case SI_QUERY_GTT_USAGE:
+	case SI_QUERY_BUFFER_CACHE_SIZE:
+	case SI_QUERY_HUGE_ALIGNED_MEMORY:
 	case SI_QUERY_GPU_TEMPERATURE:
 	case SI_QUERY_CURRENT_GPU_SCLK:
 	case SI_QUERY_CURRENT_GPU_MCLK:
@@ -183,7 +192,12 @@ static bool si_query_sw_begin(struct si_context *sctx,
 	case SI_QUERY_NUM_SDMA_IBS:
 	case SI_QUERY_NUM_BYTES_MOVED:
 	case SI_QUERY_NUM_EVICTIONS:
-	case SI_QUERY_NUM_VRAM_CPU_PAGE_FAULTS: {
+	case SI_QUERY_NUM_VRAM_CPU_PAGE_FAULTS:
+	case SI_QUERY_NUM_FENCE_DEPS_SCANNED:
+	case SI_QUERY_NUM_FENCE_DEPS_ADDED:
+	case SI_QUERY_BUFFER_CACHE_HITS:
+	case SI_QUERY_BUFFER_CACHE_MISSES:
+	case SI_QUERY_VA_CACHE_HITS: {
 		enum radeon_value_id ws_id = winsys_id_from_type(query->b.type);
 		query->begin_result = sctx->ws->query_value(sctx->ws, ws_id);
 		break;
@@ -340,7 +354,14 @@ static bool si_query_sw_end(struct si_context *sctx,
 	case SI_QUERY_NUM_SDMA_IBS:
 	case SI_QUERY_NUM_BYTES_MOVED:
 	case SI_QUERY_NUM_EVICTIONS:
-	case SI_QUERY_NUM_VRAM_CPU_PAGE_FAULTS: {
+	case SI_QUERY_NUM_VRAM_CPU_PAGE_FAULTS:
+	case SI_QUERY_NUM_FENCE_DEPS_SCANNED:
+	case SI_QUERY_NUM_FENCE_DEPS_ADDED:
+	case SI_QUERY_BUFFER_CACHE_HITS:
+	case SI_QUERY_BUFFER_CACHE_MISSES:
+	case SI_QUERY_BUFFER_CACHE_SIZE:
+	case SI_QUERY_VA_CACHE_HITS:
+	case SI_QUERY_HUGE_ALIGNED_MEMORY: {
 		enum radeon_value_id ws_id = winsys_id_from_type(query->b.type);
 		query->end_result = sctx->ws->query_value(sctx->ws, ws_id);
 		break;
@@ -1905,6 +1926,13 @@ static struct pipe_driver_query_info si_driver_query_list[] = {
 	X("num-bytes-moved",		NUM_BYTES_MOVED,	BYTES, CUMULATIVE),
 	X("num-evictions",		NUM_EVICTIONS,		UINT64, CUMULATIVE),
 	X("VRAM-CPU-page-faults",	NUM_VRAM_CPU_PAGE_FAULTS, UINT64, CUMULATIVE),
+	X("num-fence-deps-scanned",	NUM_FENCE_DEPS_SCANNED,	UINT64, AVERAGE),
+	X("num-fence-deps-added",	NUM_FENCE_DEPS_ADDED,	UINT64, AVERAGE),
+	X("buffer-cache-hits",		BUFFER_CACHE_HITS,	UINT64, AVERAGE),
+	X("buffer-cache-misses",	BUFFER_CACHE_MISSES,	UINT64, AVERAGE),
+	X("buffer-cache-size",		BUFFER_CACHE_SIZE,	BYTES, AVERAGE),
+	X("VA-cache-hits",		VA_CACHE_HITS,		UINT64, AVERAGE),
+	X("huge-aligned-memory",	HUGE_ALIGNED_MEMORY,	BYTES, AVERAGE),
 	X("VRAM-usage",			VRAM_USAGE,		BYTES, AVERAGE),
 	X("VRAM-vis-usage",		VRAM_VIS_USAGE,		BYTES, AVERAGE),
 	X("GTT-usage",			GTT_USAGE,		BYTES, AVERAGE),
@@ -73,6 +73,13 @@ enum {
 	SI_QUERY_NUM_BYTES_MOVED,
 	SI_QUERY_NUM_EVICTIONS,
 	SI_QUERY_NUM_VRAM_CPU_PAGE_FAULTS,
+	SI_QUERY_NUM_FENCE_DEPS_SCANNED,
+	SI_QUERY_NUM_FENCE_DEPS_ADDED,
+	SI_QUERY_BUFFER_CACHE_HITS,
+	SI_QUERY_BUFFER_CACHE_MISSES,
+	SI_QUERY_BUFFER_CACHE_SIZE,
+	SI_QUERY_VA_CACHE_HITS,
+	SI_QUERY_HUGE_ALIGNED_MEMORY,
 	SI_QUERY_VRAM_USAGE,
 	SI_QUERY_VRAM_VIS_USAGE,
 	SI_QUERY_GTT_USAGE,
@@ -5343,6 +5343,7 @@ int si_shader_binary_upload(struct si_screen *sscreen, struct si_shader *shader)
 	const struct ac_shader_binary *mainb = &shader->binary;
 	unsigned bo_size = si_get_shader_binary_size(shader) +
 			   (!epilog ? mainb->rodata_size : 0);
+	uint32_t *code;
 	unsigned char *ptr;
 
 	assert(!prolog || !prolog->rodata_size);
@@ -5352,20 +5353,14 @@ int si_shader_binary_upload(struct si_screen *sscreen, struct si_shader *shader)
 	       !mainb->rodata_size);
 	assert(!epilog || !epilog->rodata_size);
 
-	r600_resource_reference(&shader->bo, NULL);
-	shader->bo = si_aligned_buffer_create(&sscreen->b,
-					      sscreen->cpdma_prefetch_writes_memory ?
-						0 : SI_RESOURCE_FLAG_READ_ONLY,
-                                              PIPE_USAGE_IMMUTABLE,
-                                              align(bo_size, SI_CPDMA_ALIGNMENT),
-                                              256);
-	if (!shader->bo)
+	/* Assemble the code in memory first, so that shaders with the same
+	 * code can share the buffer. The first dword is the size. */
+	code = MALLOC(4 + bo_size);
+	if (!code)
 		return -ENOMEM;
 
-	/* Upload. */
-	ptr = sscreen->ws->buffer_map(shader->bo->buf, NULL,
-					PIPE_TRANSFER_READ_WRITE |
-					PIPE_TRANSFER_UNSYNCHRONIZED);
+	code[0] = 4 + bo_size;
+	ptr = (unsigned char*)(code + 1);
 
 	/* Don't use util_memcpy_cpu_to_le32. LLVM binaries are
 	 * endian-independent. */
@@ -5398,7 +5393,12 @@ int si_shader_binary_upload(struct si_screen *sscreen, struct si_shader *shader)
 	for (unsigned i = 0; i < DEBUGGER_NUM_MARKERS; i++)
 		ptr32[i] = DEBUGGER_END_OF_CODE_MARKER;
 
-	sscreen->ws->buffer_unmap(shader->bo->buf);
+	/* Upload. */
+	r600_resource_reference(&shader->bo, NULL);
+	shader->bo = si_shader_cache_get_bo(sscreen, code);
+	if (!shader->bo)
+		return -ENOMEM;
+
 	return 0;
 }
 
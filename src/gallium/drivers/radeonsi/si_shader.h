@@ -640,6 +640,9 @@ struct si_shader {
 	 */
 	char				*shader_log;
 	size_t				shader_log_size;
+
+	/* Hash of the binary for AMD_DEBUG=drawtrace, set on first use. */
+	uint32_t			trace_hash;
 };
 
 struct si_shader_part {
@@ -4726,6 +4726,7 @@ void si_init_state_functions(struct si_context *sctx)
 	sctx->b.set_active_query_state = si_set_active_query_state;
 
 	sctx->b.draw_vbo = si_draw_vbo;
+	sctx->b.multi_draw = si_multi_draw;
 
 	si_init_config(sctx);
 }
@@ -500,6 +500,8 @@ bool si_shader_cache_load_shader(struct si_screen *sscreen, void *ir_binary,
 bool si_shader_cache_insert_shader(struct si_screen *sscreen, void *ir_binary,
 				   struct si_shader *shader,
 				   bool insert_into_disk_cache);
+struct r600_resource *si_shader_cache_get_bo(struct si_screen *sscreen,
+					     uint32_t *code);
 bool si_update_shaders(struct si_context *sctx);
 void si_init_shader_functions(struct si_context *sctx);
 bool si_init_shader_cache(struct si_screen *sscreen);
@@ -518,6 +520,10 @@ void *si_get_blit_vs(struct si_context *sctx, enum blitter_attrib_type type,
 void si_init_ia_multi_vgt_param_table(struct si_context *sctx);
 void si_emit_cache_flush(struct si_context *sctx);
 void si_draw_vbo(struct pipe_context *ctx, const struct pipe_draw_info *dinfo);
+void si_multi_draw(struct pipe_context *ctx,
+		   const struct pipe_draw_info *info,
+		   const struct pipe_draw_range *draws,
+		   unsigned num_draws);
 void si_draw_rectangle(struct blitter_context *blitter,
 		       void *vertex_elements_cso,
 		       blitter_get_vs_func get_vs,
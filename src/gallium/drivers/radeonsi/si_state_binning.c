@@ -372,6 +372,11 @@ void si_emit_dpbb_state(struct si_context *sctx)
 		return;
 	}
 
+	if (sscreen->dpbb_min_bin_size) {
+		bin_size.x = MAX2(bin_size.x, sscreen->dpbb_min_bin_size);
+		bin_size.y = MAX2(bin_size.y, sscreen->dpbb_min_bin_size);
+	}
+
 	/* Enable DFSM if it's preferred. */
 	unsigned punchout_mode = V_028060_FORCE_OFF;
 	bool disable_start_of_prim = true;
@@ -648,6 +648,10 @@ static void si_emit_draw_registers(struct si_context *sctx,
 	}
 }
 
+/* The most that si_emit_draw_registers and si_emit_draw_packets emit for a
+ * direct draw. */
+#define SI_MULTI_DRAW_DWORDS 64
+
 static void si_emit_draw_packets(struct si_context *sctx,
 				 const struct pipe_draw_info *info,
 				 struct pipe_resource *indexbuf,
@@ -1188,6 +1192,27 @@ static void si_emit_all_states(struct si_context *sctx, const struct pipe_draw_i
 	bool context_roll = false; /* set correctly for GFX9 only */
 
 	context_roll |= si_emit_rasterizer_prim_state(sctx);
+
+	/* Fast path for draws that only changed resource bindings since the
+	 * previous draw (e.g. a vertex buffer offset or a constant buffer).
+	 * Those only dirty the shader pointers, nothing rolls the context,
+	 * and the draw registers below are only emitted if they changed.
+	 */
+	if (!(sctx->dirty_atoms & ~SI_ATOM_BIT(shader_pointers)) &&
+	    !sctx->dirty_states &&
+	    !context_roll &&
+	    !sctx->tes_shader.cso &&
+	    !info->count_from_stream_output &&
+	    !si_prim_restart_index_changed(sctx, info)) {
+		if (sctx->dirty_atoms & ~skip_atom_mask)
+			sctx->atoms.s.shader_pointers.emit(sctx);
+		sctx->dirty_atoms &= skip_atom_mask;
+
+		si_emit_vs_state(sctx, info);
+		si_emit_draw_registers(sctx, info, 0);
+		return;
+	}
+
 	if (sctx->tes_shader.cso)
 		context_roll |= si_emit_derived_tess_state(sctx, info, &num_patches);
 	if (info->count_from_stream_output)
@@ -1232,6 +1257,18 @@ static void si_emit_all_states(struct si_context *sctx, const struct pipe_draw_i
 	si_emit_draw_registers(sctx, info, num_patches);
 }
 
+static void si_count_draw(struct si_context *sctx,
+			  const struct pipe_draw_info *info)
+{
+	sctx->num_draw_calls++;
+	if (sctx->framebuffer.state.nr_cbufs > 1)
+		sctx->num_mrt_draw_calls++;
+	if (info->primitive_restart)
+		sctx->num_prim_restart_calls++;
+	if (G_0286E8_WAVESIZE(sctx->spi_tmpring_size))
+		sctx->num_spill_draw_calls++;
+}
+
 void si_draw_vbo(struct pipe_context *ctx, const struct pipe_draw_info *info)
 {
 	struct si_context *sctx = (struct si_context *)ctx;
@@ -1452,6 +1489,8 @@ void si_draw_vbo(struct pipe_context *ctx, const struct pipe_draw_info *info)
 			sctx->atoms.s.render_cond.emit(sctx);
 		sctx->dirty_atoms = 0;
 
+		if (unlikely(sctx->draw_trace))
+			si_draw_trace_emit_begin(sctx);
 		si_emit_draw_packets(sctx, info, indexbuf, index_size, index_offset);
 		/* <-- CUs are busy here. */
 
@@ -1475,6 +1514,8 @@ void si_draw_vbo(struct pipe_context *ctx, const struct pipe_draw_info *info)
 			return;
 
 		si_emit_all_states(sctx, info, 0);
+		if (unlikely(sctx->draw_trace))
+			si_draw_trace_emit_begin(sctx);
 		si_emit_draw_packets(sctx, info, indexbuf, index_size, index_offset);
 
 		/* Prefetch the remaining shaders after the draw has been
@@ -1488,6 +1529,9 @@ void si_draw_vbo(struct pipe_context *ctx, const struct pipe_draw_info *info)
 		si_log_draw_state(sctx, sctx->log);
 	}
 
+	if (unlikely(sctx->draw_trace))
+		si_draw_trace_emit_draw_end(sctx, info);
+
 	/* Workaround for a VGT hang when streamout is enabled.
 	 * It must be done after drawing. */
 	if ((sctx->family == CHIP_HAWAII ||
@@ -1497,21 +1541,68 @@ void si_draw_vbo(struct pipe_context *ctx, const struct pipe_draw_info *info)
 		sctx->flags |= SI_CONTEXT_VGT_STREAMOUT_SYNC;
 	}
 
-	if (unlikely(sctx->decompression_enabled)) {
+	if (unlikely(sctx->decompression_enabled))
 		sctx->num_decompress_calls++;
-	} else {
-		sctx->num_draw_calls++;
-		if (sctx->framebuffer.state.nr_cbufs > 1)
-			sctx->num_mrt_draw_calls++;
-		if (info->primitive_restart)
-			sctx->num_prim_restart_calls++;
-		if (G_0286E8_WAVESIZE(sctx->spi_tmpring_size))
-			sctx->num_spill_draw_calls++;
-	}
+	else
+		si_count_draw(sctx, info);
+
 	if (index_size && indexbuf != info->index.resource)
 		pipe_resource_reference(&indexbuf, NULL);
 }
 
+/* Whether the next draw only needs its draw registers and packets emitted,
+ * because nothing has changed since the last one. */
+static bool si_can_emit_draw_only(struct si_context *sctx)
+{
+	return !sctx->dirty_atoms &&
+	       !sctx->dirty_states &&
+	       !sctx->flags &&
+	       !sctx->do_update_shaders &&
+	       !sctx->tes_shader.cso && /* num_patches depends on the draw */
+	       !sctx->num_vs_blit_sgprs &&
+	       !sctx->decompression_enabled &&
+	       !sctx->current_saved_cs &&
+	       !sctx->draw_trace &&
+	       sctx->ws->cs_check_space(sctx->gfx_cs, SI_MULTI_DRAW_DWORDS);
+}
+
+void si_multi_draw(struct pipe_context *ctx,
+		   const struct pipe_draw_info *info,
+		   const struct pipe_draw_range *draws,
+		   unsigned num_draws)
+{
+	struct si_context *sctx = (struct si_context *)ctx;
+	struct pipe_draw_info draw = *info;
+	/* 8-bit indices are translated for each draw on SI-CI. */
+	bool draw_only = info->instance_count &&
+			 !(sctx->chip_class <= CIK && info->index_size == 1);
+	bool validated = false;
+
+	for (unsigned i = 0; i < num_draws; i++) {
+		if (!draws[i].count)
+			continue;
+
+		draw.start = draws[i].start;
+		draw.count = draws[i].count;
+		draw.index_bias = draws[i].index_bias;
+		draw.drawid = info->drawid + i;
+
+		/* The first draw validates and emits all states. The rest
+		 * only emit their draw packets while the states stay clean.
+		 */
+		if (draw_only && validated && si_can_emit_draw_only(sctx)) {
+			si_emit_draw_registers(sctx, &draw, 0);
+			si_emit_draw_packets(sctx, &draw, draw.index.resource,
+					     draw.index_size, 0);
+			si_count_draw(sctx, &draw);
+			continue;
+		}
+
+		si_draw_vbo(ctx, &draw);
+		validated = true;
+	}
+}
+
 void si_draw_rectangle(struct blitter_context *blitter,
 		       void *vertex_elements_cso,
 		       blitter_get_vs_func get_vs,
@@ -316,6 +316,98 @@ static void si_destroy_shader_cache_entry(struct hash_entry *entry)
 	FREE(entry->data);
 }
 
+static void si_destroy_shader_bo_cache_entry(struct hash_entry *entry)
+{
+	struct r600_resource *bo = entry->data;
+
+	FREE((void*)entry->key);
+	r600_resource_reference(&bo, NULL);
+}
+
+/* Remove the buffers that are only referenced by the cache. Nobody can get
+ * a new reference to those except through the cache.
+ */
+static void si_prune_shader_bo_cache(struct si_screen *sscreen)
+{
+	struct hash_entry *entry;
+
+	hash_table_foreach(sscreen->shader_bo_cache, entry) {
+		struct r600_resource *bo = entry->data;
+
+		if (p_atomic_read(&bo->b.b.reference.count) == 1) {
+			si_destroy_shader_bo_cache_entry(entry);
+			_mesa_hash_table_remove(sscreen->shader_bo_cache, entry);
+		}
+	}
+
+	sscreen->shader_bo_cache_prune_size =
+		MAX2(64, sscreen->shader_bo_cache->entries * 2);
+}
+
+/**
+ * Return a referenced shader buffer containing the given code, which starts
+ * with its size in bytes including the size dword. The buffer is shared
+ * with all other shaders that have the same code.
+ *
+ * Takes ownership of "code".
+ */
+struct r600_resource *si_shader_cache_get_bo(struct si_screen *sscreen,
+					     uint32_t *code)
+{
+	struct r600_resource *bo = NULL;
+	struct hash_entry *entry;
+	unsigned size = code[0] - 4;
+
+	mtx_lock(&sscreen->shader_cache_mutex);
+	entry = _mesa_hash_table_search(sscreen->shader_bo_cache, code);
+	if (entry) {
+		r600_resource_reference(&bo, entry->data);
+		mtx_unlock(&sscreen->shader_cache_mutex);
+		FREE(code);
+		return bo;
+	}
+	mtx_unlock(&sscreen->shader_cache_mutex);
+
+	bo = si_aligned_buffer_create(&sscreen->b,
+				      sscreen->cpdma_prefetch_writes_memory ?
+					0 : SI_RESOURCE_FLAG_READ_ONLY,
+				      PIPE_USAGE_IMMUTABLE,
+				      align(size, SI_CPDMA_ALIGNMENT),
+				      256);
+	if (!bo) {
+		FREE(code);
+		return NULL;
+	}
+
+	void *ptr = sscreen->ws->buffer_map(bo->buf, NULL,
+					    PIPE_TRANSFER_READ_WRITE |
+					    PIPE_TRANSFER_UNSYNCHRONIZED);
+	memcpy(ptr, code + 1, size);
+	sscreen->ws->buffer_unmap(bo->buf);
+
+	mtx_lock(&sscreen->shader_cache_mutex);
+	entry = _mesa_hash_table_search(sscreen->shader_bo_cache, code);
+	if (entry) {
+		/* Another thread uploaded the same code meanwhile. */
+		r600_resource_reference(&bo, entry->data);
+		FREE(code);
+	} else {
+		struct r600_resource *ref = NULL;
+
+		if (sscreen->shader_bo_cache->entries >=
+		    sscreen->shader_bo_cache_prune_size)
+			si_prune_shader_bo_cache(sscreen);
+
+		r600_resource_reference(&ref, bo);
+		if (!_mesa_hash_table_insert(sscreen->shader_bo_cache, code, ref)) {
+			r600_resource_reference(&ref, NULL);
+			FREE(code);
+		}
+	}
+	mtx_unlock(&sscreen->shader_cache_mutex);
+	return bo;
+}
+
 bool si_init_shader_cache(struct si_screen *sscreen)
 {
 	(void) mtx_init(&sscreen->shader_cache_mutex, mtx_plain);
@@ -323,8 +415,14 @@ bool si_init_shader_cache(struct si_screen *sscreen)
 		_mesa_hash_table_create(NULL,
 					si_shader_cache_key_hash,
 					si_shader_cache_key_equals);
+	sscreen->shader_bo_cache =
+		_mesa_hash_table_create(NULL,
+					si_shader_cache_key_hash,
+					si_shader_cache_key_equals);
+	sscreen->shader_bo_cache_prune_size = 64;
 
-	return sscreen->shader_cache != NULL;
+	return sscreen->shader_cache != NULL &&
+	       sscreen->shader_bo_cache != NULL;
 }
 
 void si_destroy_shader_cache(struct si_screen *sscreen)
@@ -332,6 +430,9 @@ void si_destroy_shader_cache(struct si_screen *sscreen)
 	if (sscreen->shader_cache)
 		_mesa_hash_table_destroy(sscreen->shader_cache,
 					 si_destroy_shader_cache_entry);
+	if (sscreen->shader_bo_cache)
+		_mesa_hash_table_destroy(sscreen->shader_bo_cache,
+					 si_destroy_shader_bo_cache_entry);
 	mtx_destroy(&sscreen->shader_cache_mutex);
 }
 
@@ -1503,6 +1604,38 @@ static inline void si_shader_selector_key(struct pipe_context *ctx,
 		memset(&key->opt, 0, sizeof(key->opt));
 }
 
+/* Return the shader cache key of a monolithic variant, which is the IR
+ * of the main part with the variant key appended, or NULL if the variant
+ * can't be cached.
+ */
+static void *si_get_variant_ir_binary(struct si_shader *shader)
+{
+	struct si_shader_selector *sel = shader->selector;
+
+	/* The keys of these contain pointers to other selectors (merged
+	 * shaders on GFX9), and GS variants also need the copy shader.
+	 */
+	if (sel->type == PIPE_SHADER_TESS_CTRL ||
+	    sel->type == PIPE_SHADER_GEOMETRY ||
+	    (!sel->tokens && !sel->nir))
+		return NULL;
+
+	void *ir_binary = si_get_ir_binary(sel);
+	if (!ir_binary)
+		return NULL;
+
+	uint32_t size = *(uint32_t*)ir_binary;
+	char *result = REALLOC(ir_binary, size, size + sizeof(shader->key));
+	if (!result) {
+		FREE(ir_binary);
+		return NULL;
+	}
+
+	memcpy(result + size, &shader->key, sizeof(shader->key));
+	*(uint32_t*)result = size + sizeof(shader->key);
+	return result;
+}
+
 static void si_build_shader_variant(struct si_shader *shader,
 				    int thread_index,
 				    bool low_priority)
@@ -1511,6 +1644,7 @@ static void si_build_shader_variant(struct si_shader *shader,
 	struct si_screen *sscreen = sel->screen;
 	struct ac_llvm_compiler *compiler;
 	struct pipe_debug_callback *debug = &shader->compiler_ctx_state.debug;
+	void *ir_binary = NULL;
 	int r;
 
 	if (thread_index >= 0) {
@@ -1528,14 +1662,46 @@ static void si_build_shader_variant(struct si_shader *shader,
 		compiler = shader->compiler_ctx_state.compiler;
 	}
 
-	r = si_shader_create(sscreen, compiler, shader, debug);
+	/* Monolithic variants take long to compile, so they are cached like
+	 * main parts. This way, a variant that caused a hitch at its first
+	 * draw is only loaded in later runs.
+	 */
+	if (shader->is_monolithic)
+		ir_binary = si_get_variant_ir_binary(shader);
+
+	bool loaded = false;
+	if (ir_binary) {
+		mtx_lock(&sscreen->shader_cache_mutex);
+		loaded = si_shader_cache_load_shader(sscreen, ir_binary, shader);
+		mtx_unlock(&sscreen->shader_cache_mutex);
+	}
+
+	if (loaded) {
+		/* The cache owns ir_binary now. The loaded binary only needs
+		 * to be uploaded. */
+		ir_binary = NULL;
+		si_shader_dump(sscreen, shader, debug, sel->info.processor,
+			       stderr, true);
+		r = si_shader_binary_upload(sscreen, shader);
+	} else {
+		r = si_shader_create(sscreen, compiler, shader, debug);
+	}
+
 	if (unlikely(r)) {
 		PRINT_ERR("Failed to build shader variant (type=%u) %d\n",
 			 sel->type, r);
 		shader->compilation_failed = true;
+		FREE(ir_binary);
 		return;
 	}
 
+	if (ir_binary) {
+		mtx_lock(&sscreen->shader_cache_mutex);
+		if (!si_shader_cache_insert_shader(sscreen, ir_binary, shader, true))
+			FREE(ir_binary);
+		mtx_unlock(&sscreen->shader_cache_mutex);
+	}
+
 	if (shader->compiler_ctx_state.is_debug_context) {
 		FILE *f = open_memstream(&shader->shader_log,
 					 &shader->shader_log_size);
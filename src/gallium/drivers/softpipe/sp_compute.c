@@ -164,28 +164,27 @@ fill_grid_size(struct pipe_context *context,
    pipe_buffer_unmap(context, transfer);
 }
 
-void
-softpipe_launch_grid(struct pipe_context *context,
-                     const struct pipe_grid_info *info)
+/**
+ * Run the workgroups [first, last) of the grid, in linear order.
+ */
+static void
+run_workgroups(struct softpipe_context *softpipe,
+               const struct sp_compute_shader *cs,
+               const uint32_t grid_size[3],
+               unsigned first, unsigned last)
 {
-   struct softpipe_context *softpipe = softpipe_context(context);
-   struct sp_compute_shader *cs = softpipe->cs;
    int num_threads_in_group;
    struct tgsi_exec_machine **machines;
    int bwidth, bheight, bdepth;
    int w, h, d, i;
-   int g_w, g_h, g_d;
-   uint32_t grid_size[3] = {0};
+   unsigned g;
    void *local_mem = NULL;
 
-   softpipe_update_compute_samplers(softpipe);
    bwidth = cs->info.properties[TGSI_PROPERTY_CS_FIXED_BLOCK_WIDTH];
    bheight = cs->info.properties[TGSI_PROPERTY_CS_FIXED_BLOCK_HEIGHT];
    bdepth = cs->info.properties[TGSI_PROPERTY_CS_FIXED_BLOCK_DEPTH];
    num_threads_in_group = bwidth * bheight * bdepth;
 
-   fill_grid_size(context, info, grid_size);
-
    if (cs->shader.req_local_mem) {
       local_mem = CALLOC(1, cs->shader.req_local_mem);
    }
@@ -219,12 +218,12 @@ softpipe_launch_grid(struct pipe_context *context,
       }
    }
 
-   for (g_d = 0; g_d < grid_size[2]; g_d++) {
-      for (g_h = 0; g_h < grid_size[1]; g_h++) {
-         for (g_w = 0; g_w < grid_size[0]; g_w++) {
-            run_workgroup(cs, g_w, g_h, g_d, num_threads_in_group, machines);
-         }
-      }
+   for (g = first; g < last; g++) {
+      run_workgroup(cs,
+                    g % grid_size[0],
+                    (g / grid_size[0]) % grid_size[1],
+                    g / (grid_size[0] * grid_size[1]),
+                    num_threads_in_group, machines);
    }
 
    for (i = 0; i < num_threads_in_group; i++) {
@@ -235,3 +234,91 @@ softpipe_launch_grid(struct pipe_context *context,
    FREE(local_mem);
    FREE(machines);
 }
+
+struct sp_cs_chunk {
+   struct softpipe_context *softpipe;
+   const struct sp_compute_shader *cs;
+   const uint32_t *grid_size;
+   unsigned first, last;
+   struct util_queue_fence fence;
+};
+
+static void
+cs_chunk_job(void *data, int thread_index)
+{
+   struct sp_cs_chunk *chunk = (struct sp_cs_chunk *)data;
+
+   run_workgroups(chunk->softpipe, chunk->cs, chunk->grid_size,
+                  chunk->first, chunk->last);
+}
+
+/**
+ * Workgroups may only run concurrently if the shader neither samples
+ * textures, whose tile caches are per context, nor uses atomics, which the
+ * interpreter implements as plain read-modify-write sequences.
+ */
+static bool
+cs_is_thread_safe(const struct sp_compute_shader *cs)
+{
+   unsigned op;
+
+   if (cs->info.file_count[TGSI_FILE_SAMPLER] ||
+       cs->info.file_count[TGSI_FILE_SAMPLER_VIEW])
+      return false;
+
+   for (op = TGSI_OPCODE_ATOMUADD; op <= TGSI_OPCODE_ATOMIMAX; op++) {
+      if (cs->info.opcode_count[op])
+         return false;
+   }
+
+   return true;
+}
+
+void
+softpipe_launch_grid(struct pipe_context *context,
+                     const struct pipe_grid_info *info)
+{
+   struct softpipe_context *softpipe = softpipe_context(context);
+   struct sp_compute_shader *cs = softpipe->cs;
+   struct sp_cs_chunk chunks[SP_MAX_CS_THREADS];
+   uint32_t grid_size[3] = {0};
+   unsigned num_groups, num_chunks = 0, groups_per_chunk, i;
+
+   softpipe_update_compute_samplers(softpipe);
+
+   fill_grid_size(context, info, grid_size);
+
+   num_groups = grid_size[0] * grid_size[1] * grid_size[2];
+   if (!num_groups)
+      return;
+
+   /* Hand contiguous ranges of workgroups to the helper threads, the
+    * calling thread runs the first range itself.
+    */
+   if (util_queue_is_initialized(&softpipe->cs_queue) && cs_is_thread_safe(cs))
+      num_chunks = MIN2(softpipe->num_cs_threads, num_groups - 1);
+
+   groups_per_chunk = DIV_ROUND_UP(num_groups, num_chunks + 1);
+
+   for (i = 0; i < num_chunks; i++) {
+      struct sp_cs_chunk *chunk = &chunks[i];
+
+      chunk->softpipe = softpipe;
+      chunk->cs = cs;
+      chunk->grid_size = grid_size;
+      chunk->first = MIN2((i + 1) * groups_per_chunk, num_groups);
+      chunk->last = MIN2(chunk->first + groups_per_chunk, num_groups);
+      util_queue_fence_init(&chunk->fence);
+
+      if (chunk->first < chunk->last)
+         util_queue_add_job(&softpipe->cs_queue, chunk, &chunk->fence,
+                            cs_chunk_job, NULL);
+   }
+
+   run_workgroups(softpipe, cs, grid_size, 0, MIN2(groups_per_chunk, num_groups));
+
+   for (i = 0; i < num_chunks; i++) {
+      util_queue_fence_wait(&chunks[i].fence);
+      util_queue_fence_destroy(&chunks[i].fence);
+   }
+}
@@ -119,6 +119,9 @@ softpipe_destroy( struct pipe_context *pipe )
 
    tgsi_exec_machine_destroy(softpipe->fs_machine);
 
+   if (util_queue_is_initialized(&softpipe->cs_queue))
+      util_queue_destroy(&softpipe->cs_queue);
+
    for (i = 0; i < PIPE_SHADER_TYPES; i++) {
       FREE(softpipe->tgsi.sampler[i]);
       FREE(softpipe->tgsi.image[i]);
@@ -218,6 +221,13 @@ softpipe_create_context(struct pipe_screen *screen,
    softpipe->dump_gs = debug_get_bool_option( "SOFTPIPE_DUMP_GS", FALSE );
    softpipe->dump_cs = debug_get_bool_option( "SOFTPIPE_DUMP_CS", FALSE );
 
+   softpipe->num_cs_threads = MIN2(debug_get_num_option("SOFTPIPE_CS_THREADS", 0),
+                                   SP_MAX_CS_THREADS);
+   if (softpipe->num_cs_threads &&
+       !util_queue_init(&softpipe->cs_queue, "spcs", SP_MAX_CS_THREADS,
+                        softpipe->num_cs_threads, 0))
+      softpipe->num_cs_threads = 0;
+
    softpipe->pipe.screen = screen;
    softpipe->pipe.destroy = softpipe_destroy;
    softpipe->pipe.priv = priv;
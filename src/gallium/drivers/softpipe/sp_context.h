@@ -33,6 +33,7 @@
 
 #include "pipe/p_context.h"
 #include "util/u_blitter.h"
+#include "util/u_queue.h"
 
 #include "draw/draw_vertex.h"
 
@@ -57,6 +58,9 @@ struct sp_vertex_shader;
 struct sp_velems_state;
 struct sp_so_state;
 
+/** Max number of helper threads running compute workgroups */
+#define SP_MAX_CS_THREADS 16
+
 struct softpipe_context {
    struct pipe_context pipe;  /**< base class */
 
@@ -205,6 +209,10 @@ struct softpipe_context {
     */
    struct softpipe_tex_tile_cache *tex_cache[PIPE_SHADER_TYPES][PIPE_MAX_SHADER_SAMPLER_VIEWS];
 
+   /** Helper threads running compute workgroups, see SOFTPIPE_CS_THREADS */
+   struct util_queue cs_queue;
+   unsigned num_cs_threads;
+
    unsigned dump_fs : 1;
    unsigned dump_gs : 1;
    unsigned dump_cs : 1;
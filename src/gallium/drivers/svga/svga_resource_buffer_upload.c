@@ -729,6 +729,38 @@ svga_buffer_upload_flush(struct svga_context *svga, struct svga_buffer *sbuf)
 }
 
 
+/**
+ * Merge any ranges which are contiguous with or overlap range \p r into it.
+ */
+static void
+svga_buffer_merge_ranges(struct svga_buffer *sbuf, unsigned r)
+{
+   unsigned i = 0;
+
+   while (i < sbuf->map.num_ranges) {
+      if (i != r &&
+          sbuf->map.ranges[i].start <= sbuf->map.ranges[r].end &&
+          sbuf->map.ranges[r].start <= sbuf->map.ranges[i].end) {
+         sbuf->map.ranges[r].start = MIN2(sbuf->map.ranges[r].start,
+                                          sbuf->map.ranges[i].start);
+         sbuf->map.ranges[r].end = MAX2(sbuf->map.ranges[r].end,
+                                        sbuf->map.ranges[i].end);
+
+         /* Remove range i by moving the last one into its slot. */
+         --sbuf->map.num_ranges;
+         if (r == sbuf->map.num_ranges)
+            r = i;
+         sbuf->map.ranges[i] = sbuf->map.ranges[sbuf->map.num_ranges];
+
+         /* Range r grew, so ranges already skipped may touch it now. */
+         i = 0;
+         continue;
+      }
+      ++i;
+   }
+}
+
+
 /**
  * Note a dirty range.
  *
@@ -775,6 +807,14 @@ svga_buffer_add_range(struct svga_buffer *sbuf, unsigned start, unsigned end)
           */
          sbuf->map.ranges[i].start = MIN2(sbuf->map.ranges[i].start, start);
          sbuf->map.ranges[i].end   = MAX2(sbuf->map.ranges[i].end,   end);
+
+         /*
+          * The grown range may now touch other ones as well.  Fold those
+          * into it too, so that they go out as a single box, unless there
+          * is a pending DMA command whose box count must match the ranges.
+          */
+         if (!sbuf->dma.pending)
+            svga_buffer_merge_ranges(sbuf, i);
          return;
       }
       else {
@@ -124,6 +124,26 @@ KNOBS = [
         'category'  : 'perf',
     }],
 
+    ['NUM_API_RESERVED_THREADS', {
+        'type'      : 'uint32_t',
+        'default'   : '1',
+        'desc'      : ['Number of HW threads reserved for the API (application) thread.',
+                       'They are taken from the first cores used for SWR, the API thread',
+                       'is bound to the first of them and no worker is placed on them.',
+                       'Ignored if MAX_WORKER_THREADS is set.'],
+        'category'  : 'perf',
+    }],
+
+    ['NUM_FE_THREADS', {
+        'type'      : 'uint32_t',
+        'default'   : '0',
+        'desc'      : ['Number of worker threads that only do frontend work.',
+                       'These are the workers closest to the API thread, all other',
+                       'workers then only do backend work.',
+                       '0 means every worker does both frontend and backend work.'],
+        'category'  : 'perf_adv',
+    }],
+
     ['BUCKETS_START_FRAME', {
         'type'      : 'uint32_t',
         'default'   : '1200',
@@ -160,6 +180,16 @@ KNOBS = [
         'category'  : 'perf_adv',
     }],
 
+    ['MAX_HOT_TILE_MEMORY_MB', {
+        'type'      : 'uint32_t',
+        'default'   : '0',
+        'desc'      : ['Maximum amount of hot tile memory, in MB, kept around once',
+                       'tiles have been stored back to their surfaces.',
+                       'Resolved tiles beyond this are freed and reloaded when next used.',
+                       '0 means no limit.'],
+        'category'  : 'perf_adv',
+    }],
+
     ['MAX_PRIMS_PER_DRAW', {
         'type'      : 'uint32_t',
         'default'   : '49152',
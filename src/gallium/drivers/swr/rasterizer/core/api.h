@@ -189,6 +189,8 @@ struct SWR_THREADING_INFO
     uint32_t MAX_NUMA_NODES;
     uint32_t MAX_CORES_PER_NUMA_NODE;
     uint32_t MAX_THREADS_PER_CORE;
+    uint32_t NUM_FE_THREADS; // 0 - every worker does FE and BE work, else the first
+                             // NUM_FE_THREADS workers only do FE work and the rest only BE.
     bool     SINGLE_THREADED;
 };
 
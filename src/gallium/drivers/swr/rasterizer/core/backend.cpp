@@ -193,6 +193,8 @@ void ProcessStoreTileBE(DRAW_CONTEXT*               pDC,
                 pHotTile->state = (HOTTILE_STATE)pDesc->postStoreTileState;
             }
         }
+
+        pContext->pHotTileMgr->TrimHotTile(pHotTile, attachment);
     }
     RDTSC_END(BEStoreTiles, 1);
 }
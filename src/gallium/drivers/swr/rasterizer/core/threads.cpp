@@ -716,7 +716,7 @@ INLINE void CompleteDrawFE(SWR_CONTEXT* pContext, uint32_t workerId, DRAW_CONTEX
     InterlockedDecrement(&pContext->drawsOutstandingFE);
 }
 
-void WorkOnFifoFE(SWR_CONTEXT* pContext, uint32_t workerId, uint32_t& curDrawFE)
+bool WorkOnFifoFE(SWR_CONTEXT* pContext, uint32_t workerId, uint32_t& curDrawFE)
 {
     // Try to grab the next DC from the ring
     uint32_t drawEnqueued = GetEnqueuedDraw(pContext);
@@ -726,8 +726,15 @@ void WorkOnFifoFE(SWR_CONTEXT* pContext, uint32_t workerId, uint32_t& curDrawFE)
         DRAW_CONTEXT* pDC    = &pContext->dcRing[dcSlot];
         if (pDC->isCompute || pDC->doneFE)
         {
+            bool bShutdown = !pDC->isCompute && pDC->FeWork.type == SHUTDOWN;
+
             CompleteDrawContextInl(pContext, workerId, pDC);
             curDrawFE++;
+
+            if (bShutdown)
+            {
+                return true;
+            }
         }
         else
         {
@@ -746,7 +753,7 @@ void WorkOnFifoFE(SWR_CONTEXT* pContext, uint32_t workerId, uint32_t& curDrawFE)
         {
             if (CheckDependencyFE(pContext, pDC, lastRetiredFE))
             {
-                return;
+                return false;
             }
 
             uint32_t initial = InterlockedCompareExchange((volatile uint32_t*)&pDC->FeLock, 1, 0);
@@ -760,6 +767,8 @@ void WorkOnFifoFE(SWR_CONTEXT* pContext, uint32_t workerId, uint32_t& curDrawFE)
         }
         curDraw++;
     }
+
+    return false;
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -943,11 +952,15 @@ DWORD workerThreadMain(LPVOID pData)
 
         if (IsFEThread)
         {
-            WorkOnFifoFE(pContext, workerId, curDrawFE);
+            bool bShutdownFE = WorkOnFifoFE(pContext, workerId, curDrawFE);
 
             if (!IsBEThread)
             {
                 curDrawBE = curDrawFE;
+
+                // The shutdown BE work never reaches FE only threads, they stop once
+                // they have moved past the shutdown draw instead.
+                bShutdown |= bShutdownFE;
             }
         }
     }
@@ -990,6 +1003,64 @@ static void InitPerThreadStats(SWR_CONTEXT* pContext, uint32_t numThreads)
     }
 }
 
+//////////////////////////////////////////////////////////////////////////
+/// @brief Decides which workers do FE work and which do BE work.
+///        By default every worker does both.  With NUM_FE_THREADS the first
+///        workers, which are the ones placed next to the API reserved threads,
+///        only do FE work and the remaining ones only do BE work.
+/// @param pContext - pointer to context
+/// @param pPool - pointer to thread pool object.
+static void AssignWorkerRoles(SWR_CONTEXT* pContext, THREAD_POOL* pPool)
+{
+    uint32_t numFEThreads = pContext->threadInfo.NUM_FE_THREADS;
+
+    if (numFEThreads >= pPool->numThreads)
+    {
+        SWR_ASSERT(numFEThreads == 0,
+                   "Cannot use NUM_FE_THREADS value: %d, numThreads: %d, reverting to 0",
+                   numFEThreads,
+                   pPool->numThreads);
+        numFEThreads = 0;
+    }
+
+    if (numFEThreads)
+    {
+        // Macrotiles are distributed across NUMA nodes, every node needs a BE thread.
+        uint32_t numNumaNodes = pPool->numaMask + 1;
+        std::vector<uint32_t> numBEThreadsPerNode(numNumaNodes, 0);
+        for (uint32_t workerId = numFEThreads; workerId < pPool->numThreads; ++workerId)
+        {
+            uint32_t numaNode =
+                pPool->pThreadData[workerId].numaId - pContext->threadInfo.BASE_NUMA_NODE;
+            numBEThreadsPerNode[numaNode & pPool->numaMask]++;
+        }
+
+        for (uint32_t n = 0; n < numNumaNodes; ++n)
+        {
+            if (numBEThreadsPerNode[n] == 0)
+            {
+                SWR_ASSERT(false,
+                           "Cannot use NUM_FE_THREADS value: %d, no BE thread left on NUMA "
+                           "node %d, reverting to 0",
+                           numFEThreads,
+                           n);
+                numFEThreads = 0;
+                break;
+            }
+        }
+    }
+
+    for (uint32_t workerId = 0; workerId < pPool->numThreads; ++workerId)
+    {
+        pPool->pThreadData[workerId].isFEThread = !numFEThreads || workerId < numFEThreads;
+        pPool->pThreadData[workerId].isBEThread = !numFEThreads || workerId >= numFEThreads;
+    }
+
+    pContext->threadInfo.NUM_FE_THREADS = numFEThreads;
+    pContext->NumFEThreads = numFEThreads ? numFEThreads : pPool->numThreads;
+    pContext->NumBEThreads = pPool->numThreads - numFEThreads;
+}
+
 //////////////////////////////////////////////////////////////////////////
 /// @brief Creates thread pool info but doesn't launch threads.
 /// @param pContext - pointer to context
@@ -1344,6 +1415,8 @@ void CreateThreadPool(SWR_CONTEXT* pContext, THREAD_POOL* pPool)
         }
         SWR_ASSERT(workerId == pContext->NumWorkerThreads);
     }
+
+    AssignWorkerRoles(pContext, pPool);
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -1359,8 +1432,20 @@ void StartThreadPool(SWR_CONTEXT* pContext, THREAD_POOL* pPool)
 
     for (uint32_t workerId = 0; workerId < pContext->NumWorkerThreads; ++workerId)
     {
-        pPool->pThreads[workerId] =
-            new std::thread(workerThreadInit<true, true>, &pPool->pThreadData[workerId]);
+        THREAD_DATA* pThreadData = &pPool->pThreadData[workerId];
+
+        if (!pThreadData->isBEThread)
+        {
+            pPool->pThreads[workerId] = new std::thread(workerThreadInit<true, false>, pThreadData);
+        }
+        else if (!pThreadData->isFEThread)
+        {
+            pPool->pThreads[workerId] = new std::thread(workerThreadInit<false, true>, pThreadData);
+        }
+        else
+        {
+            pPool->pThreads[workerId] = new std::thread(workerThreadInit<true, true>, pThreadData);
+        }
     }
 }
 
@@ -48,6 +48,8 @@ struct THREAD_DATA
     uint32_t     workerId;
     SWR_CONTEXT* pContext;
     bool         forceBindProcGroup; // Only useful when MAX_WORKER_THREADS is set.
+    bool         isFEThread;         // Worker picks up FE work
+    bool         isBEThread;         // Worker picks up BE and compute work
 };
 
 struct THREAD_POOL
@@ -68,7 +70,7 @@ void StartThreadPool(SWR_CONTEXT* pContext, THREAD_POOL* pPool);
 void DestroyThreadPool(SWR_CONTEXT* pContext, THREAD_POOL* pPool);
 
 // Expose FE and BE worker functions to the API thread if single threaded
-void    WorkOnFifoFE(SWR_CONTEXT* pContext, uint32_t workerId, uint32_t& curDrawFE);
+bool    WorkOnFifoFE(SWR_CONTEXT* pContext, uint32_t workerId, uint32_t& curDrawFE);
 bool    WorkOnFifoBE(SWR_CONTEXT* pContext,
                      uint32_t     workerId,
                      uint32_t&    curDrawBE,
@@ -113,6 +113,7 @@ HOTTILE* HotTileMgr::GetHotTile(SWR_CONTEXT*                pContext,
             uint32_t numaNode = ((x ^ y) & pContext->threadPool.numaMask);
             hotTile.pBuffer =
                 (uint8_t*)AllocHotTileMem(size, 64, numaNode + pContext->threadInfo.BASE_NUMA_NODE);
+            InterlockedAdd64(&mHotTileMemory, size);
             hotTile.state                  = HOTTILE_INVALID;
             hotTile.numSamples             = numSamples;
             hotTile.renderTargetArrayIndex = renderTargetArrayIndex;
@@ -137,6 +138,8 @@ HOTTILE* HotTileMgr::GetHotTile(SWR_CONTEXT*                pContext,
             uint32_t numaNode = ((x ^ y) & pContext->threadPool.numaMask);
             hotTile.pBuffer =
                 (uint8_t*)AllocHotTileMem(size, 64, numaNode + pContext->threadInfo.BASE_NUMA_NODE);
+            InterlockedAdd64(&mHotTileMemory,
+                             (int64_t)(numSamples - hotTile.numSamples) * mHotTileSize[attachment]);
             hotTile.state      = HOTTILE_INVALID;
             hotTile.numSamples = numSamples;
         }
@@ -231,6 +234,7 @@ HOTTILE* HotTileMgr::GetHotTileNoLoad(SWR_CONTEXT*                pContext,
         {
             uint32_t size                  = numSamples * mHotTileSize[attachment];
             hotTile.pBuffer                = (uint8_t*)AlignedMalloc(size, 64);
+            InterlockedAdd64(&mHotTileMemory, size);
             hotTile.state                  = HOTTILE_INVALID;
             hotTile.numSamples             = numSamples;
             hotTile.renderTargetArrayIndex = 0;
@@ -244,6 +248,29 @@ HOTTILE* HotTileMgr::GetHotTileNoLoad(SWR_CONTEXT*                pContext,
     return &hotTile;
 }
 
+//////////////////////////////////////////////////////////////////////////
+/// @brief Frees the memory of a resolved hot tile if more hot tile memory
+///        than KNOB_MAX_HOT_TILE_MEMORY_MB is allocated.  The surface holds
+///        the tile contents, so the next GetHotTile simply reloads them.
+///        Must only be called by the worker that owns the macrotile.
+void HotTileMgr::TrimHotTile(HOTTILE* pHotTile, SWR_RENDERTARGET_ATTACHMENT attachment)
+{
+    if (KNOB_MAX_HOT_TILE_MEMORY_MB == 0 || pHotTile->state != HOTTILE_RESOLVED)
+    {
+        return;
+    }
+
+    if (mHotTileMemory <= (int64_t)KNOB_MAX_HOT_TILE_MEMORY_MB * 1024 * 1024)
+    {
+        return;
+    }
+
+    FreeHotTileMem(pHotTile->pBuffer);
+    InterlockedAdd64(&mHotTileMemory,
+                     -(int64_t)pHotTile->numSamples * mHotTileSize[attachment]);
+    pHotTile->pBuffer = NULL;
+}
+
 #if USE_8x2_TILE_BACKEND
 void HotTileMgr::ClearColorHotTile(
     const HOTTILE* pHotTile) // clear a macro tile from float4 clear data.
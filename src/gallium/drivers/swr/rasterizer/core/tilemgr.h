@@ -317,6 +317,8 @@ public:
                               bool                        create,
                               uint32_t                    numSamples = 1);
 
+    void TrimHotTile(HOTTILE* pHotTile, SWR_RENDERTARGET_ATTACHMENT attachment);
+
     static void ClearColorHotTile(const HOTTILE* pHotTile);
     static void ClearDepthHotTile(const HOTTILE* pHotTile);
     static void ClearStencilHotTile(const HOTTILE* pHotTile);
@@ -325,6 +327,9 @@ private:
     HotTileSet mHotTiles[KNOB_NUM_HOT_TILES_X][KNOB_NUM_HOT_TILES_Y];
     uint32_t   mHotTileSize[SWR_NUM_ATTACHMENTS];
 
+    // Bytes of hot tile memory currently allocated, across all worker threads.
+    OSALIGNLINE(volatile int64_t) mHotTileMemory{0};
+
     void* AllocHotTileMem(size_t size, uint32_t align, uint32_t numaNode)
     {
         void* p = nullptr;
@@ -497,12 +497,22 @@ swr_create_context(struct pipe_screen *p_screen, void *priv, unsigned flags)
 
    SWR_THREADING_INFO threadingInfo {0};
 
+   threadingInfo.BASE_NUMA_NODE            = KNOB_BASE_NUMA_NODE;
+   threadingInfo.BASE_CORE                 = KNOB_BASE_CORE;
+   threadingInfo.BASE_THREAD               = KNOB_BASE_THREAD;
    threadingInfo.MAX_WORKER_THREADS        = KNOB_MAX_WORKER_THREADS;
    threadingInfo.MAX_NUMA_NODES            = KNOB_MAX_NUMA_NODES;
    threadingInfo.MAX_CORES_PER_NUMA_NODE   = KNOB_MAX_CORES_PER_NUMA_NODE;
    threadingInfo.MAX_THREADS_PER_CORE      = KNOB_MAX_THREADS_PER_CORE;
+   threadingInfo.NUM_FE_THREADS            = KNOB_NUM_FE_THREADS;
    threadingInfo.SINGLE_THREADED           = KNOB_SINGLE_THREADED;
 
+   SWR_API_THREADING_INFO apiThreadingInfo {0};
+
+   apiThreadingInfo.numAPIReservedThreads  = KNOB_NUM_API_RESERVED_THREADS;
+   apiThreadingInfo.bindAPIThread0         = KNOB_NUM_API_RESERVED_THREADS > 0;
+   apiThreadingInfo.numAPIThreadsPerCore   = 1;
+
    // Use non-standard settings for KNL
    if (swr_screen(p_screen)->is_knl)
    {
@@ -517,6 +527,7 @@ swr_create_context(struct pipe_screen *p_screen, void *priv, unsigned flags)
    }
 
    createInfo.pThreadInfo = &threadingInfo;
+   createInfo.pApiThreadInfo = &apiThreadingInfo;
 
    ctx->swrContext = ctx->api.pfnSwrCreateContext(&createInfo);
 
@@ -125,12 +125,7 @@ swr_draw_vbo(struct pipe_context *pipe, const struct pipe_draw_info *info)
    if (search != velems->map.end()) {
       velems->fsFunc = search->second;
    } else {
-      HANDLE hJitMgr = swr_screen(ctx->pipe.screen)->hJitMgr;
-      velems->fsFunc = JitCompileFetch(hJitMgr, velems->fsState);
-
-      debug_printf("fetch shader %p\n", velems->fsFunc);
-      assert(velems->fsFunc && "Error: FetchShader = NULL");
-
+      velems->fsFunc = swr_compile_fetch(swr_screen(ctx->pipe.screen), key);
       velems->map.insert(std::make_pair(key, velems->fsFunc));
    }
 
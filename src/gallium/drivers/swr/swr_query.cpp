@@ -31,6 +31,33 @@
 #include "swr_state.h"
 #include "common/os.h"
 
+/* Driver specific queries, one per counter the core keeps in SWR_STATS and
+ * SWR_STATS_FE.  These are collected the same way as pipeline statistics, but
+ * can be sampled one by one by the HUD and AMD_performance_monitor.
+ */
+struct swr_driver_query {
+   const char *name;
+   size_t offset; /* of the uint64_t counter in struct swr_query_result */
+};
+
+#define SWR_DRIVER_QUERY(name, field) \
+   { name, offsetof(struct swr_query_result, field) }
+
+static const struct swr_driver_query swr_driver_queries[] = {
+   SWR_DRIVER_QUERY("depth-pass-count", core.DepthPassCount),
+   SWR_DRIVER_QUERY("ps-invocations", core.PsInvocations),
+   SWR_DRIVER_QUERY("cs-invocations", core.CsInvocations),
+   SWR_DRIVER_QUERY("ia-vertices", coreFE.IaVertices),
+   SWR_DRIVER_QUERY("ia-primitives", coreFE.IaPrimitives),
+   SWR_DRIVER_QUERY("vs-invocations", coreFE.VsInvocations),
+   SWR_DRIVER_QUERY("hs-invocations", coreFE.HsInvocations),
+   SWR_DRIVER_QUERY("ds-invocations", coreFE.DsInvocations),
+   SWR_DRIVER_QUERY("gs-invocations", coreFE.GsInvocations),
+   SWR_DRIVER_QUERY("gs-primitives", coreFE.GsPrimitives),
+   SWR_DRIVER_QUERY("clipper-invocations", coreFE.CInvocations),
+   SWR_DRIVER_QUERY("clipper-primitives", coreFE.CPrimitives),
+};
+
 static struct swr_query *
 swr_query(struct pipe_query *p)
 {
@@ -42,7 +69,9 @@ swr_create_query(struct pipe_context *pipe, unsigned type, unsigned index)
 {
    struct swr_query *pq;
 
-   assert(type < PIPE_QUERY_TYPES);
+   assert(type < PIPE_QUERY_TYPES ||
+          (type >= PIPE_QUERY_DRIVER_SPECIFIC &&
+           type < PIPE_QUERY_DRIVER_SPECIFIC + ARRAY_SIZE(swr_driver_queries)));
    assert(index < MAX_SO_STREAMS);
 
    pq = (struct swr_query *) AlignedMalloc(sizeof(struct swr_query), 64);
@@ -151,6 +180,13 @@ swr_get_query_result(struct pipe_context *pipe,
    }
       break;
    default:
+      if (pq->type >= PIPE_QUERY_DRIVER_SPECIFIC) {
+         const struct swr_driver_query *dq =
+            &swr_driver_queries[pq->type - PIPE_QUERY_DRIVER_SPECIFIC];
+         result->u64 = *(const uint64_t *)((const char *)&pq->result +
+                                           dq->offset);
+         break;
+      }
       assert(0 && "Unsupported query");
       break;
    }
@@ -270,3 +306,48 @@ swr_query_init(struct pipe_context *pipe)
 
    ctx->active_queries = 0;
 }
+
+
+static int
+swr_get_driver_query_info(struct pipe_screen *screen,
+                          unsigned index,
+                          struct pipe_driver_query_info *info)
+{
+   if (!info)
+      return ARRAY_SIZE(swr_driver_queries);
+
+   if (index >= ARRAY_SIZE(swr_driver_queries))
+      return 0;
+
+   memset(info, 0, sizeof(*info));
+   info->name = swr_driver_queries[index].name;
+   info->query_type = PIPE_QUERY_DRIVER_SPECIFIC + index;
+   info->type = PIPE_DRIVER_QUERY_TYPE_UINT64;
+   info->result_type = PIPE_DRIVER_QUERY_RESULT_TYPE_AVERAGE;
+   info->group_id = 0;
+   return 1;
+}
+
+static int
+swr_get_driver_query_group_info(struct pipe_screen *screen,
+                                unsigned index,
+                                struct pipe_driver_query_group_info *info)
+{
+   if (!info)
+      return 1;
+
+   if (index != 0)
+      return 0;
+
+   info->name = "SWR core";
+   info->max_active_queries = ARRAY_SIZE(swr_driver_queries);
+   info->num_queries = ARRAY_SIZE(swr_driver_queries);
+   return 1;
+}
+
+void
+swr_query_screen_init(struct pipe_screen *screen)
+{
+   screen->get_driver_query_info = swr_get_driver_query_info;
+   screen->get_driver_query_group_info = swr_get_driver_query_group_info;
+}
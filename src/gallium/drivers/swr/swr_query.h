@@ -44,5 +44,7 @@ OSALIGNLINE(struct) swr_query {
 
 extern void swr_query_init(struct pipe_context *pipe);
 
+extern void swr_query_screen_init(struct pipe_screen *screen);
+
 extern boolean swr_check_render_cond(struct pipe_context *pipe);
 #endif
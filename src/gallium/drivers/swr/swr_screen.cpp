@@ -26,6 +26,7 @@
 #include "swr_screen.h"
 #include "swr_resource.h"
 #include "swr_fence.h"
+#include "swr_query.h"
 #include "gen_knobs.h"
 
 #include "pipe/p_screen.h"
@@ -1076,6 +1077,7 @@ swr_destroy_screen_internal(struct swr_screen **screen)
    swr_fence_finish(p_screen, NULL, (*screen)->flush_fence, 0);
    swr_fence_reference(p_screen, &(*screen)->flush_fence, NULL);
 
+   delete (*screen)->fetch_cache;
    JitDestroyContext((*screen)->hJitMgr);
 
    if ((*screen)->pLibrary)
@@ -1175,8 +1177,10 @@ swr_create_screen_internal(struct sw_winsys *winsys)
 
    // Pass in "" for architecture for run-time determination
    screen->hJitMgr = JitCreateContext(KNOB_SIMD_WIDTH, "", "swr");
+   screen->fetch_cache = new swr_fetch_cache;
 
    swr_fence_init(&screen->base);
+   swr_query_screen_init(&screen->base);
 
    swr_validate_env_options(screen);
 
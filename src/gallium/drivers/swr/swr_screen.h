@@ -35,6 +35,7 @@
 #include "memory/TilingFunctions.h"
 
 struct sw_winsys;
+struct swr_fetch_cache;
 
 struct swr_screen {
    struct pipe_screen base;
@@ -51,6 +52,9 @@ struct swr_screen {
 
    HANDLE hJitMgr;
 
+   /* Fetch shaders shared by all contexts, see swr_compile_fetch() */
+   struct swr_fetch_cache *fetch_cache;
+
    /* Dynamic backend implementations */
    util_dl_library *pLibrary;
    PFNSwrGetInterface pfnSwrGetInterface;
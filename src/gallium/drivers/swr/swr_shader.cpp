@@ -190,6 +190,29 @@ swr_generate_fetch_key(struct swr_jit_fetch_key &key,
    key.fsState = velems->fsState;
 }
 
+PFN_FETCH_FUNC
+swr_compile_fetch(struct swr_screen *screen, swr_jit_fetch_key &key)
+{
+   struct swr_fetch_cache *cache = screen->fetch_cache;
+   std::lock_guard<std::mutex> lock(cache->mutex);
+
+   auto search = cache->map.find(key);
+   if (search != cache->map.end())
+      return search->second;
+
+   /* JitCompileFetch also looks up the on-disk JitCache by the module's
+    * CRC before running codegen.
+    */
+   PFN_FETCH_FUNC func = JitCompileFetch(screen->hJitMgr, key.fsState);
+
+   debug_printf("fetch shader %p\n", func);
+   assert(func && "Error: FetchShader = NULL");
+
+   if (func)
+      cache->map.insert(std::make_pair(key, func));
+   return func;
+}
+
 void
 swr_generate_gs_key(struct swr_jit_gs_key &key,
                     struct swr_context *ctx,
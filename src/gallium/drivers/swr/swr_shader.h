@@ -53,6 +53,9 @@ void swr_generate_vs_key(struct swr_jit_vs_key &key,
 void swr_generate_fetch_key(struct swr_jit_fetch_key &key,
                             struct swr_vertex_element_state *velems);
 
+PFN_FETCH_FUNC
+swr_compile_fetch(struct swr_screen *screen, swr_jit_fetch_key &key);
+
 void swr_generate_gs_key(struct swr_jit_gs_key &key,
                          struct swr_context *ctx,
                          swr_geometry_shader *swr_gs);
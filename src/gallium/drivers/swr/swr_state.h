@@ -36,6 +36,7 @@
 #include "swr_shader.h"
 #include <unordered_map>
 #include <memory>
+#include <mutex>
 
 template <typename T>
 struct ShaderVariant {
@@ -86,6 +87,15 @@ struct swr_vertex_element_state {
    std::unordered_map<swr_jit_fetch_key, PFN_FETCH_FUNC> map;
 };
 
+/* Fetch shaders of all vertex element states of a screen, so that states
+ * with the same layout only JIT once. The code lives as long as the
+ * screen's JitManager.
+ */
+struct swr_fetch_cache {
+   std::mutex mutex;
+   std::unordered_map<swr_jit_fetch_key, PFN_FETCH_FUNC> map;
+};
+
 struct swr_blend_state {
    struct pipe_blend_state pipe;
    SWR_BLEND_STATE blendState;
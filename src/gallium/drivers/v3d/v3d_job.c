@@ -379,6 +379,24 @@ v3d_job_submit(struct v3d_context *v3d, struct v3d_job *job)
         if (!job->needs_flush)
                 goto done;
 
+        /* Whatever the RCL stores is defined from now on, so later jobs
+         * have to load it.
+         */
+        for (int i = 0; i < VC5_MAX_DRAW_BUFFERS; i++) {
+                uint32_t bit = PIPE_CLEAR_COLOR0 << i;
+
+                if (job->cbufs[i] && (job->store & bit)) {
+                        struct v3d_resource *rsc =
+                                v3d_resource(job->cbufs[i]->texture);
+                        rsc->initialized_buffers |= bit;
+                }
+        }
+        if (job->zsbuf && (job->store & PIPE_CLEAR_DEPTHSTENCIL)) {
+                struct v3d_resource *rsc = v3d_resource(job->zsbuf->texture);
+                rsc->initialized_buffers |=
+                        job->store & PIPE_CLEAR_DEPTHSTENCIL;
+        }
+
         if (v3d->screen->devinfo.ver >= 41)
                 v3d41_emit_rcl(job);
         else
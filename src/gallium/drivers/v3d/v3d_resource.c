@@ -767,6 +767,9 @@ v3d_resource_from_handle(struct pipe_screen *pscreen,
                 goto fail;
         }
 
+        /* Someone else may have rendered to the imported buffer. */
+        rsc->initialized_buffers = ~0;
+
         return prsc;
 
 fail:
@@ -221,10 +221,22 @@ v3d_move_pixels_general_percpp(void *gpu, uint32_t gpu_stride,
                                                             uint32_t x, uint32_t y),
                                bool is_load)
 {
+        /* Every tiling format stores whole utiles contiguously, and a utile
+         * is in raster order, so a row of pixels within a utile is a single
+         * contiguous run of utile_w * cpp bytes.  Copy those runs at once
+         * and only look up the address once per utile row.
+         */
+        uint32_t utile_w = v3d_utile_width(cpp);
+
         for (uint32_t y = 0; y < box->height; y++) {
                 void *cpu_row = cpu + y * cpu_stride;
+                uint32_t x = 0;
+
+                while (x < box->width) {
+                        bool whole_row = (((box->x + x) & (utile_w - 1)) == 0 &&
+                                          x + utile_w <= box->width);
+                        uint32_t run = whole_row ? utile_w : 1;
 
-                for (int x = 0; x < box->width; x++) {
                         uint32_t pixel_offset = get_pixel_offset(cpp, image_h,
                                                                  box->x + x,
                                                                  box->y + y);
@@ -235,15 +247,29 @@ v3d_move_pixels_general_percpp(void *gpu, uint32_t gpu_stride,
                                         pixel_offset);
                         }
 
-                        if (is_load) {
-                                memcpy(cpu_row + x * cpp,
-                                       gpu + pixel_offset,
-                                       cpp);
+                        if (whole_row) {
+                                if (is_load) {
+                                        memcpy(cpu_row + x * cpp,
+                                               gpu + pixel_offset,
+                                               utile_w * cpp);
+                                } else {
+                                        memcpy(gpu + pixel_offset,
+                                               cpu_row + x * cpp,
+                                               utile_w * cpp);
+                                }
                         } else {
-                                memcpy(gpu + pixel_offset,
-                                       cpu_row + x * cpp,
-                                       cpp);
+                                if (is_load) {
+                                        memcpy(cpu_row + x * cpp,
+                                               gpu + pixel_offset,
+                                               cpp);
+                                } else {
+                                        memcpy(gpu + pixel_offset,
+                                               cpu_row + x * cpp,
+                                               cpp);
+                                }
                         }
+
+                        x += run;
                 }
         }
 }
@@ -602,25 +602,31 @@ v3d_draw_vbo(struct pipe_context *pctx, const struct pipe_draw_info *info)
                 struct v3d_resource *rsc = v3d_resource(job->zsbuf->texture);
                 v3d_job_add_bo(job, rsc->bo);
 
-                job->load |= PIPE_CLEAR_DEPTH & ~job->clear;
+                /* Undefined contents don't need to be loaded into the tile
+                 * buffer.  The stores mark the buffer as initialized when the
+                 * job is submitted.
+                 */
+                if (rsc->initialized_buffers & PIPE_CLEAR_DEPTH)
+                        job->load |= PIPE_CLEAR_DEPTH & ~job->clear;
                 if (v3d->zsa->base.depth.writemask)
                         job->store |= PIPE_CLEAR_DEPTH;
-                rsc->initialized_buffers = PIPE_CLEAR_DEPTH;
         }
 
         if (v3d->zsa && job->zsbuf && v3d->zsa->base.stencil[0].enabled) {
                 struct v3d_resource *rsc = v3d_resource(job->zsbuf->texture);
+                bool initialized =
+                        rsc->initialized_buffers & PIPE_CLEAR_STENCIL;
                 if (rsc->separate_stencil)
                         rsc = rsc->separate_stencil;
 
                 v3d_job_add_bo(job, rsc->bo);
 
-                job->load |= PIPE_CLEAR_STENCIL & ~job->clear;
+                if (initialized)
+                        job->load |= PIPE_CLEAR_STENCIL & ~job->clear;
                 if (v3d->zsa->base.stencil[0].writemask ||
                     v3d->zsa->base.stencil[1].writemask) {
                         job->store |= PIPE_CLEAR_STENCIL;
                 }
-                rsc->initialized_buffers |= PIPE_CLEAR_STENCIL;
         }
 
         for (int i = 0; i < VC5_MAX_DRAW_BUFFERS; i++) {
@@ -631,7 +637,8 @@ v3d_draw_vbo(struct pipe_context *pctx, const struct pipe_draw_info *info)
                         continue;
                 struct v3d_resource *rsc = v3d_resource(job->cbufs[i]->texture);
 
-                job->load |= bit & ~job->clear;
+                if (rsc->initialized_buffers & PIPE_CLEAR_COLOR)
+                        job->load |= bit & ~job->clear;
                 if (v3d->blend->base.rt[blend_rt].colormask)
                         job->store |= bit;
                 v3d_job_add_bo(job, rsc->bo);
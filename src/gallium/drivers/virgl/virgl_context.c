@@ -414,9 +414,14 @@ static void virgl_hw_set_vertex_buffers(struct pipe_context *ctx)
 {
    struct virgl_context *vctx = virgl_context(ctx);
 
+   /* The host keeps the bindings across draws and cbuf flushes (the
+    * resources get reattached by virgl_reemit_res()), so only send them
+    * again when they actually changed.
+    */
    if (vctx->vertex_array_dirty) {
       virgl_encoder_set_vertex_buffers(vctx, vctx->num_vertex_buffers, vctx->vertex_buffer);
       virgl_attach_res_vertex_buffers(vctx);
+      vctx->vertex_array_dirty = FALSE;
    }
 }
 
@@ -474,18 +479,15 @@ void virgl_transfer_inline_write(struct pipe_context *ctx,
                                 unsigned layer_stride)
 {
    struct virgl_context *vctx = virgl_context(ctx);
-   struct virgl_screen *vs = virgl_screen(ctx->screen);
    struct virgl_resource *grres = virgl_resource(res);
-   struct virgl_buffer *vbuf = virgl_buffer(res);
 
    grres->clean = FALSE;
 
-   if (virgl_res_needs_flush_wait(vctx, &vbuf->base, usage)) {
-      ctx->flush(ctx, NULL, 0);
-
-      vs->vws->resource_wait(vs->vws, vbuf->base.hw_res);
-   }
-
+   /* The data travels in the command stream, and the host executes the
+    * write in order with the commands already queued against the resource,
+    * so there is no need to flush and wait for them here.  Later mappings
+    * still see the resource referenced by the cbuf and synchronize then.
+    */
    virgl_encoder_inline_write(vctx, grres, level, usage,
                               box, data, stride, layer_stride);
 }
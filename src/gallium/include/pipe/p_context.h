@@ -49,6 +49,7 @@ struct pipe_debug_callback;
 struct pipe_depth_stencil_alpha_state;
 struct pipe_device_reset_callback;
 struct pipe_draw_info;
+struct pipe_draw_range;
 struct pipe_grid_info;
 struct pipe_fence_handle;
 struct pipe_framebuffer_state;
@@ -108,6 +109,20 @@ struct pipe_context {
    /*@{*/
    void (*draw_vbo)( struct pipe_context *pipe,
                      const struct pipe_draw_info *info );
+
+   /**
+    * Draw several vertex or index ranges with the same state, as if
+    * draw_vbo was called for each of them with the start, count and
+    * index_bias of \p info replaced, and drawid set to
+    * info->drawid + i.  Draws with a count of 0 are skipped.
+    *
+    * \p info never has user indices, an indirect buffer or
+    * count_from_stream_output.  Optional.
+    */
+   void (*multi_draw)( struct pipe_context *pipe,
+                       const struct pipe_draw_info *info,
+                       const struct pipe_draw_range *draws,
+                       unsigned num_draws );
    /*@}*/
 
    /**
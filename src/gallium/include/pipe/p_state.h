@@ -700,6 +700,17 @@ struct pipe_draw_indirect_info
 /**
  * Information to describe a draw_vbo call.
  */
+/**
+ * One draw of pipe_context::multi_draw.
+ */
+struct pipe_draw_range
+{
+   unsigned start;
+   unsigned count;
+   int index_bias; /**< for indexed draws */
+};
+
+
 struct pipe_draw_info
 {
    ubyte index_size;  /**< if 0, the draw is not indexed. */
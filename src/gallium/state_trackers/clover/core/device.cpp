@@ -26,6 +26,7 @@
 #include "pipe/p_screen.h"
 #include "pipe/p_state.h"
 #include "util/u_debug.h"
+#include "util/disk_cache.h"
 
 using namespace clover;
 
@@ -40,19 +41,39 @@ namespace {
       pipe->get_compute_param(pipe, ir_format, cap, &v.front());
       return v;
    }
+
+   struct disk_cache *
+   create_program_cache(const std::string &name) {
+      uint32_t timestamp;
+
+      if (!disk_cache_get_function_timestamp((void *)create_program_cache,
+                                             &timestamp))
+         return NULL;
+
+      // The LLVM version is part of the cache identity because binaries
+      // built by one release aren't guaranteed to match another.
+      const std::string id = std::to_string(timestamp) + "_llvm" +
+                             std::to_string(HAVE_LLVM);
+      return disk_cache_create(name.c_str(), id.c_str(), 0);
+   }
 }
 
 device::device(clover::platform &platform, pipe_loader_device *ldev) :
-   platform(platform), ldev(ldev) {
+   platform(platform), ldev(ldev), _program_cache(NULL) {
    pipe = pipe_loader_create_screen(ldev);
    if (!pipe || !pipe->get_param(pipe, PIPE_CAP_COMPUTE)) {
       if (pipe)
          pipe->destroy(pipe);
       throw error(CL_INVALID_DEVICE);
    }
+
+   if (ir_format() != PIPE_SHADER_IR_TGSI)
+      _program_cache = create_program_cache("clover_" + ir_target());
 }
 
 device::~device() {
+   if (_program_cache)
+      disk_cache_destroy(_program_cache);
    if (pipe)
       pipe->destroy(pipe);
    if (ldev)
@@ -267,6 +288,11 @@ device::endianness() const {
    return (enum pipe_endian)pipe->get_param(pipe, PIPE_CAP_ENDIANNESS);
 }
 
+struct disk_cache *
+device::program_cache() const {
+   return _program_cache;
+}
+
 std::string
 device::device_version() const {
    static const std::string device_version =
@@ -171,7 +171,15 @@ void
 hard_event::wait() const {
    pipe_screen *screen = queue()->device().pipe;
 
-   event::wait();
+   // Commands are submitted to the queue in order, so any dependency on
+   // the same queue is covered by our own fence.  Only wait for the others
+   // explicitly instead of walking the whole chain of earlier commands.
+   for (event &ev : deps) {
+      if (ev.queue() != queue())
+         ev.wait();
+   }
+
+   wait_signalled();
 
    if (status() == CL_QUEUED)
       queue()->flush();
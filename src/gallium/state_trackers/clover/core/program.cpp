@@ -20,12 +20,48 @@
 // OTHER DEALINGS IN THE SOFTWARE.
 //
 
+#include <sstream>
+
 #include "core/program.hpp"
 #include "llvm/invocation.hpp"
 #include "tgsi/invocation.hpp"
+#include "util/disk_cache.h"
 
 using namespace clover;
 
+namespace {
+   ///
+   /// Look up the module identified by \a id in the program cache of \a
+   /// dev, or build it with \a f and store the result for the next time.
+   ///
+   template<typename F>
+   module
+   cached_build(const device &dev, std::string id, F f) {
+      struct disk_cache *cache = dev.program_cache();
+      cache_key key;
+      size_t size;
+
+      if (!cache)
+         return f();
+
+      id += '\0' + dev.device_name();
+      disk_cache_compute_key(cache, id.data(), id.size(), key);
+
+      if (char *data = (char *)disk_cache_get(cache, key, &size)) {
+         std::istringstream is(std::string(data, size));
+         free(data);
+         return module::deserialize(is);
+      }
+
+      const module m = f();
+      std::ostringstream os;
+      m.serialize(os);
+      const std::string bin = os.str();
+      disk_cache_put(cache, key, bin.data(), bin.size(), NULL);
+      return m;
+   }
+}
+
 program::program(clover::context &ctx, const std::string &source) :
    has_source(true), context(ctx), _source(source), _kernel_ref_counter(0) {
 }
@@ -51,10 +87,16 @@ program::compile(const ref_vector<device> &devs, const std::string &opts,
          std::string log;
 
          try {
+            std::string id = "compile" + ('\0' + _source) + '\0' + opts;
+            for (auto &h : headers)
+               id += '\0' + h.first + '\0' + h.second;
+
             const module m = (dev.ir_format() == PIPE_SHADER_IR_TGSI ?
                               tgsi::compile_program(_source, log) :
-                              llvm::compile_program(_source, headers, dev,
-                                                    opts, log));
+                              cached_build(dev, id, [&]() {
+                                    return llvm::compile_program(
+                                       _source, headers, dev, opts, log);
+                                 }));
             _builds[&dev] = { m, opts, log };
          } catch (...) {
             _builds[&dev] = { module(), opts, log };
@@ -76,9 +118,16 @@ program::link(const ref_vector<device> &devs, const std::string &opts,
       std::string log = _builds[&dev].log;
 
       try {
+         std::ostringstream id;
+         id << "link" << '\0' << opts;
+         for (auto &m : ms)
+            m.serialize(id);
+
          const module m = (dev.ir_format() == PIPE_SHADER_IR_TGSI ?
                            tgsi::link_program(ms) :
-                           llvm::link_program(ms, dev, opts, log));
+                           cached_build(dev, id.str(), [&]() {
+                                 return llvm::link_program(ms, dev, opts, log);
+                              }));
          _builds[&dev] = { m, opts, log };
       } catch (...) {
          _builds[&dev] = { module(), opts, log };
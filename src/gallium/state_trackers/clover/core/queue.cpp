@@ -69,7 +69,11 @@ command_queue::flush() {
    pipe_fence_handle *fence = NULL;
 
    std::lock_guard<std::mutex> lock(queued_events_mutex);
-   if (!queued_events.empty()) {
+
+   // If the oldest event is still waiting for its dependencies nothing
+   // has been submitted since the last flush, don't create a new fence.
+   if (!queued_events.empty() &&
+       queued_events.front()().signalled()) {
       pipe->flush(pipe, &fence, 0);
 
       while (!queued_events.empty() &&
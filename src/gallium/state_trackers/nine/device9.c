@@ -289,7 +289,7 @@ NineDevice9_ctor( struct NineDevice9 *This,
     if (This->csmt_active)
         DBG("\033[1;32mCSMT is active\033[0m\n");
 
-    This->buffer_upload = nine_upload_create(This->pipe_secondary, 4 * 1024 * 1024, 4);
+    This->buffer_upload = nine_upload_create(This, This->pipe_secondary, 4 * 1024 * 1024, 4);
 
     /* Initialize a dummy VBO to be used when a vertex declaration does not
      * specify all the inputs needed by vertex shader, on win default behavior
@@ -479,6 +479,12 @@ NineDevice9_ctor( struct NineDevice9 *This,
     This->driver_caps.vs_integer = pScreen->get_shader_param(pScreen, PIPE_SHADER_VERTEX, PIPE_SHADER_CAP_INTEGERS);
     This->driver_caps.ps_integer = pScreen->get_shader_param(pScreen, PIPE_SHADER_FRAGMENT, PIPE_SHADER_CAP_INTEGERS);
     This->driver_caps.offset_units_unscaled = GET_PCAP(POLYGON_OFFSET_UNITS_UNSCALED);
+    /* ProcessVertices shaders use the swvp constant layout, plus a viewport
+     * buffer. Otherwise they run on the software pipe. */
+    This->driver_caps.process_vertices_hw =
+        GET_PCAP(MAX_STREAM_OUTPUT_BUFFERS) &&
+        pScreen->get_shader_param(pScreen, PIPE_SHADER_VERTEX, PIPE_SHADER_CAP_MAX_CONST_BUFFERS) >= 5 &&
+        pScreen->get_shader_param(pScreen, PIPE_SHADER_VERTEX, PIPE_SHADER_CAP_MAX_CONST_BUFFER_SIZE) >= 4096 * sizeof(float[4]);
 
     nine_ff_init(This); /* initialize fixed function code */
 
@@ -2940,8 +2946,10 @@ NineDevice9_ProcessVertices( struct NineDevice9 *This,
                              IDirect3DVertexDeclaration9 *pVertexDecl,
                              DWORD Flags )
 {
-    struct pipe_screen *screen_sw = This->screen_sw;
-    struct pipe_context *pipe_sw = This->pipe_sw;
+    /* Run on the gpu when it can take the swvp constants */
+    const boolean hw = This->driver_caps.process_vertices_hw;
+    struct pipe_screen *screen = hw ? This->screen : This->screen_sw;
+    struct pipe_context *pipe;
     struct NineVertexDeclaration9 *vdecl = NineVertexDeclaration9(pVertexDecl);
     struct NineVertexBuffer9 *dst = NineVertexBuffer9(pDestBuffer);
     struct NineVertexShader9 *vs;
@@ -2955,14 +2963,14 @@ NineDevice9_ProcessVertices( struct NineDevice9 *This,
     unsigned offsets[1] = {0};
     HRESULT hr;
     unsigned buffer_size;
-    void *map;
+    void *map = NULL;
 
     DBG("This=%p SrcStartIndex=%u DestIndex=%u VertexCount=%u "
         "pDestBuffer=%p pVertexDecl=%p Flags=%d\n",
         This, SrcStartIndex, DestIndex, VertexCount, pDestBuffer,
         pVertexDecl, Flags);
 
-    if (!screen_sw->get_param(screen_sw, PIPE_CAP_MAX_STREAM_OUTPUT_BUFFERS)) {
+    if (!screen->get_param(screen, PIPE_CAP_MAX_STREAM_OUTPUT_BUFFERS)) {
         DBG("ProcessVertices not supported\n");
         return D3DERR_INVALIDCALL;
     }
@@ -3000,7 +3008,13 @@ NineDevice9_ProcessVertices( struct NineDevice9 *This,
     user_assert(This->may_swvp,
                 D3DERR_INVALIDCALL);
 
-    nine_state_prepare_draw_sw(This, vdecl, SrcStartIndex, VertexCount, &so);
+    if (hw) {
+        pipe = nine_context_get_pipe(This);
+        nine_state_prepare_draw_so(This, vdecl, SrcStartIndex, &so);
+    } else {
+        pipe = This->pipe_sw;
+        nine_state_prepare_draw_sw(This, vdecl, SrcStartIndex, VertexCount, &so);
+    }
 
     buffer_size = VertexCount * so.stride[0] * 4;
     {
@@ -3012,19 +3026,22 @@ NineDevice9_ProcessVertices( struct NineDevice9 *This,
         templ.width0 = buffer_size;
         templ.flags = 0;
         templ.bind = PIPE_BIND_STREAM_OUTPUT;
-        templ.usage = PIPE_USAGE_STREAM;
+        /* Read back by the cpu right after the draw */
+        templ.usage = hw ? PIPE_USAGE_STAGING : PIPE_USAGE_STREAM;
         templ.height0 = templ.depth0 = templ.array_size = 1;
         templ.last_level = templ.nr_samples = templ.nr_storage_samples = 0;
 
-        resource = screen_sw->resource_create(screen_sw, &templ);
-        if (!resource)
-            return E_OUTOFMEMORY;
+        resource = screen->resource_create(screen, &templ);
+        if (!resource) {
+            hr = E_OUTOFMEMORY;
+            goto out;
+        }
     }
-    target = pipe_sw->create_stream_output_target(pipe_sw, resource,
-                                                  0, buffer_size);
+    target = pipe->create_stream_output_target(pipe, resource,
+                                               0, buffer_size);
     if (!target) {
-        pipe_resource_reference(&resource, NULL);
-        return D3DERR_DRIVERINTERNALERROR;
+        hr = D3DERR_DRIVERINTERNALERROR;
+        goto out;
     }
 
     draw.mode = PIPE_PRIM_POINTS;
@@ -3042,29 +3059,36 @@ NineDevice9_ProcessVertices( struct NineDevice9 *This,
     draw.max_index = VertexCount - 1;
 
 
-    pipe_sw->set_stream_output_targets(pipe_sw, 1, &target, offsets);
+    pipe->set_stream_output_targets(pipe, 1, &target, offsets);
 
-    pipe_sw->draw_vbo(pipe_sw, &draw);
+    pipe->draw_vbo(pipe, &draw);
 
-    pipe_sw->set_stream_output_targets(pipe_sw, 0, NULL, 0);
-    pipe_sw->stream_output_target_destroy(pipe_sw, target);
+    pipe->set_stream_output_targets(pipe, 0, NULL, 0);
+    pipe->stream_output_target_destroy(pipe, target);
 
     u_box_1d(0, VertexCount * so.stride[0] * 4, &box);
-    map = pipe_sw->transfer_map(pipe_sw, resource, 0, PIPE_TRANSFER_READ, &box,
-                                &transfer);
-    if (!map) {
-        hr = D3DERR_DRIVERINTERNALERROR;
-        goto out;
-    }
-
-    hr = NineVertexDeclaration9_ConvertStreamOutput(vdecl,
-                                                    dst, DestIndex, VertexCount,
-                                                    map, &so);
-    if (transfer)
-        pipe_sw->transfer_unmap(pipe_sw, transfer);
+    map = pipe->transfer_map(pipe, resource, 0, PIPE_TRANSFER_READ, &box,
+                             &transfer);
+    hr = map ? D3D_OK : D3DERR_DRIVERINTERNALERROR;
 
 out:
-    nine_state_after_draw_sw(This);
+    /* Locking the destination may queue work on the device pipe,
+     * which thus has to be back in its state before. */
+    if (hw)
+        nine_state_after_draw_so(This);
+    else
+        nine_state_after_draw_sw(This);
+
+    if (map) {
+        hr = NineVertexDeclaration9_ConvertStreamOutput(vdecl,
+                                                        dst, DestIndex, VertexCount,
+                                                        map, &so);
+        if (hw)
+            pipe = nine_context_get_pipe_acquire(This);
+        pipe->transfer_unmap(pipe, transfer);
+        if (hw)
+            nine_context_get_pipe_release(This);
+    }
     pipe_resource_reference(&resource, NULL);
     return hr;
 }
@@ -132,6 +132,7 @@ struct NineDevice9
         boolean vs_integer;
         boolean ps_integer;
         boolean offset_units_unscaled;
+        boolean process_vertices_hw;
     } driver_caps;
 
     struct {
@@ -37,6 +37,7 @@
 #include "util/slab.h"
 
 #include "nine_buffer_upload.h"
+#include "device9.h"
 
 #include "nine_debug.h"
 
@@ -49,6 +50,10 @@ struct nine_buffer_group {
     uint8_t *map;
     unsigned free_offset; /* Aligned offset to the upload buffer, pointing
                            * at the first unused byte. */
+    boolean retired; /* No sub-buffer left, waiting for the gpu to be done
+                      * with the content before the group is reused. */
+    struct pipe_fence_handle *fence; /* Set by the worker thread once the
+                                      * retired content is flushed. */
 };
 
 struct nine_subbuffer {
@@ -61,6 +66,7 @@ struct nine_subbuffer {
 };
 
 struct nine_buffer_upload {
+    struct NineDevice9 *device;
     struct pipe_context *pipe;
     struct slab_mempool buffer_pool;
 
@@ -107,6 +113,7 @@ nine_upload_create_buffer_group(struct nine_buffer_upload *upload,
     }
 
     group->free_offset = 0;
+    group->retired = FALSE;
 }
 
 static void
@@ -116,6 +123,9 @@ nine_upload_destroy_buffer_group(struct nine_buffer_upload *upload,
     DBG("%p %p\n", upload, group);
     assert(group->refcount == 0);
 
+    if (group->fence)
+        upload->pipe->screen->fence_reference(upload->pipe->screen,
+                                              &group->fence, NULL);
     if (group->transfer)
         pipe_transfer_unmap(upload->pipe, group->transfer);
     if (group->resource)
@@ -125,8 +135,8 @@ nine_upload_destroy_buffer_group(struct nine_buffer_upload *upload,
 }
 
 struct nine_buffer_upload *
-nine_upload_create(struct pipe_context *pipe, unsigned buffers_size,
-                   unsigned num_buffers)
+nine_upload_create(struct NineDevice9 *device, struct pipe_context *pipe,
+                   unsigned buffers_size, unsigned num_buffers)
 {
     struct nine_buffer_upload *upload;
     int i;
@@ -144,6 +154,7 @@ nine_upload_create(struct pipe_context *pipe, unsigned buffers_size,
 
     slab_create(&upload->buffer_pool, sizeof(struct nine_subbuffer), 4096);
 
+    upload->device = device;
     upload->pipe = pipe;
     upload->buffers_size = align(buffers_size, 4096);
     upload->num_buffers = num_buffers;
@@ -176,6 +187,45 @@ nine_upload_destroy(struct nine_buffer_upload *upload)
     FREE(upload);
 }
 
+/* The group keeps its resource and mapping once its last sub-buffer is
+ * released.  The fence is requested from here rather than at release time,
+ * as releases can happen on the worker thread.  Returns TRUE if the group
+ * is free again. */
+static boolean
+nine_upload_reclaim_buffer_group(struct nine_buffer_upload *upload,
+                                 struct nine_buffer_group *group)
+{
+    struct pipe_screen *screen = upload->pipe->screen;
+    struct pipe_fence_handle *fence = p_atomic_read(&group->fence);
+
+    if (!fence)
+        return FALSE;
+    if (!screen->fence_finish(screen, NULL, fence, 0))
+        return FALSE;
+
+    DBG("Reusing buffer group %p\n", group);
+    screen->fence_reference(screen, &group->fence, NULL);
+    group->free_offset = 0;
+    group->retired = FALSE;
+    return TRUE;
+}
+
+static void
+nine_upload_retire_buffer_groups(struct nine_buffer_upload *upload)
+{
+    int i;
+
+    for (i = 0; i < upload->num_buffers; i++) {
+        struct nine_buffer_group *group = &upload->buffers[i];
+
+        if (!group->resource || group->retired ||
+            group->refcount || !group->free_offset)
+            continue;
+        group->retired = TRUE;
+        nine_context_fence(upload->device, &group->fence);
+    }
+}
+
 struct nine_subbuffer *
 nine_upload_create_buffer(struct nine_buffer_upload *upload,
                           unsigned buffer_size)
@@ -190,10 +240,15 @@ nine_upload_create_buffer(struct nine_buffer_upload *upload,
     if (!buf)
         return NULL;
 
+    nine_upload_retire_buffer_groups(upload);
+
     for (i = 0; i < upload->num_buffers; i++) {
         group = &upload->buffers[i];
-        if (group->resource &&
-            group->free_offset + size <= upload->buffers_size)
+        if (!group->resource)
+            continue;
+        if (group->retired && !nine_upload_reclaim_buffer_group(upload, group))
+            continue;
+        if (group->free_offset + size <= upload->buffers_size)
             break;
     }
 
@@ -260,11 +315,7 @@ nine_upload_release_buffer(struct nine_buffer_upload *upload,
     if (buf->parent) {
         pipe_resource_reference(&buf->resource, NULL);
         buf->parent->refcount--;
-        if (buf->parent->refcount == 0) {
-            /* Allocate new buffer */
-            nine_upload_destroy_buffer_group(upload, buf->parent);
-            nine_upload_create_buffer_group(upload, buf->parent);
-        }
+        /* When the group gets empty, it is retired on the next allocation */
     } else {
         /* lonely buffer */
         if (buf->transfer)
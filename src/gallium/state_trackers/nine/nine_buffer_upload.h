@@ -31,12 +31,13 @@
 
 #include "pipe/p_defines.h"
 
+struct NineDevice9;
 struct nine_buffer_upload;
 struct nine_subbuffer;
 
 struct nine_buffer_upload *
-nine_upload_create(struct pipe_context *pipe, unsigned buffers_size,
-                   unsigned num_buffers);
+nine_upload_create(struct NineDevice9 *device, struct pipe_context *pipe,
+                   unsigned buffers_size, unsigned num_buffers);
 
 void
 nine_upload_destroy(struct nine_buffer_upload *upload);
@@ -47,6 +47,10 @@
  *
  * nine_queue_alloc returns NULL on insufficent space.
  *
+ * Until the cmdbuf is flushed, the producer may append to the last slice it
+ * allocated with nine_queue_get_last and nine_queue_grow_last, to pack
+ * consecutive commands of the same kind into one instruction.
+ *
  * Consumer:
  * Calls nine_queue_wait_flush to wait for a cmdbuf.
  * After waiting for a cmdbuf it calls nine_queue_get until NULL is returned.
@@ -204,6 +208,38 @@ nine_queue_alloc(struct nine_queue_pool* ctx, unsigned space)
     return cmdbuf->mem_pool + offset;
 }
 
+/* Returns a pointer to the slice of memory allocated last in the current
+ * cmdbuf, or NULL if nothing was allocated since the last flush.
+ * Does not block. */
+void *
+nine_queue_get_last(struct nine_queue_pool* ctx)
+{
+    struct nine_cmdbuf *cmdbuf = &ctx->pool[ctx->head];
+
+    if (!cmdbuf->num_instr)
+        return NULL;
+
+    return cmdbuf->mem_pool + cmdbuf->offset -
+           cmdbuf->instr_size[cmdbuf->num_instr - 1];
+}
+
+/* Grows the slice of memory allocated last by @space.
+ * Does not block.
+ * Returns FALSE if the current cmdbuf has insufficient space. */
+bool
+nine_queue_grow_last(struct nine_queue_pool* ctx, unsigned space)
+{
+    struct nine_cmdbuf *cmdbuf = &ctx->pool[ctx->head];
+
+    if (!cmdbuf->num_instr || cmdbuf->offset + space > NINE_QUEUE_SIZE)
+        return FALSE;
+
+    cmdbuf->offset += space;
+    cmdbuf->instr_size[cmdbuf->num_instr - 1] += space;
+
+    return TRUE;
+}
+
 /* Returns the current queue flush state.
  * TRUE nothing flushed
  * FALSE one ore more instructions queued flushed. */
@@ -3514,7 +3514,7 @@ nine_translate_shader(struct NineDevice9 *device, struct nine_shader_info *info,
     struct shader_translator *tx;
     HRESULT hr = D3D_OK;
     const unsigned processor = info->type;
-    struct pipe_screen *screen = info->process_vertices ? device->screen_sw : device->screen;
+    struct pipe_screen *screen = pipe->screen;
 
     user_assert(processor != ~0, D3DERR_INVALIDCALL);
 
@@ -1312,9 +1312,68 @@ nine_context_set_pixel_shader_constant_i_transformed(struct NineDevice9 *device,
                                                      unsigned pConstantData_size,
                                                      UINT Vector4iCount);
 
-CSMT_ITEM_NO_WAIT(nine_context_set_render_state,
-                  ARG_VAL(D3DRENDERSTATETYPE, State),
-                  ARG_VAL(DWORD, Value))
+static void
+nine_context_set_render_state_priv(struct NineDevice9 *device,
+                                   D3DRENDERSTATETYPE State,
+                                   DWORD Value);
+
+/* Games set render states by the thousands per frame. Consecutive calls are
+ * packed into a single instruction instead of one instruction each, which
+ * would otherwise fill a cmdbuf every NINE_CMD_BUF_INSTR calls. */
+struct s_nine_context_set_render_state_private {
+    struct csmt_instruction instr;
+    unsigned count;
+    struct {
+        D3DRENDERSTATETYPE State;
+        DWORD Value;
+    } rs[];
+};
+
+static int
+nine_context_set_render_state_rx(struct NineDevice9 *device,
+                                 struct csmt_instruction *instr)
+{
+    struct s_nine_context_set_render_state_private *args =
+        (struct s_nine_context_set_render_state_private *)instr;
+    unsigned i;
+
+    for (i = 0; i < args->count; i++)
+        nine_context_set_render_state_priv(device, args->rs[i].State,
+                                           args->rs[i].Value);
+    return 0;
+}
+
+void
+nine_context_set_render_state(struct NineDevice9 *device,
+                              D3DRENDERSTATETYPE State,
+                              DWORD Value)
+{
+    struct csmt_context *ctx = device->csmt_ctx;
+    struct s_nine_context_set_render_state_private *args;
+
+    if (!device->csmt_active) {
+        nine_context_set_render_state_priv(device, State, Value);
+        return;
+    }
+
+    args = nine_queue_get_last(ctx->pool);
+    if (!args || args->instr.func != &nine_context_set_render_state_rx ||
+        !nine_queue_grow_last(ctx->pool, sizeof(args->rs[0]))) {
+        args = nine_queue_alloc(ctx->pool, sizeof(*args) + sizeof(args->rs[0]));
+        assert(args);
+        args->instr.func = &nine_context_set_render_state_rx;
+        args->count = 0;
+    }
+
+    args->rs[args->count].State = State;
+    args->rs[args->count].Value = Value;
+    args->count++;
+}
+
+static void
+nine_context_set_render_state_priv(struct NineDevice9 *device,
+                                   D3DRENDERSTATETYPE State,
+                                   DWORD Value)
 {
     struct nine_context *context = &device->context;
 
@@ -2732,6 +2791,18 @@ CSMT_ITEM_NO_WAIT_WITH_COUNTER(nine_context_end_query,
     (void) context->pipe->end_query(context->pipe, query);
 }
 
+/* Flushes the work queued so far and publishes a fence for it in *fence,
+ * which must be NULL.  The caller owns the reference once it shows up. */
+CSMT_ITEM_NO_WAIT(nine_context_fence,
+                  ARG_VAL(struct pipe_fence_handle **, fence))
+{
+    struct nine_context *context = &device->context;
+    struct pipe_fence_handle *new_fence = NULL;
+
+    context->pipe->flush(context->pipe, &new_fence, PIPE_FLUSH_DEFERRED);
+    p_atomic_set(fence, new_fence);
+}
+
 boolean
 nine_context_get_query_result(struct NineDevice9 *device, struct pipe_query *query,
                               unsigned *counter, boolean flush, boolean wait,
@@ -3107,7 +3178,7 @@ nine_state_init_sw(struct NineDevice9 *device)
  * TODO: Share the code */
 
 static void
-update_vertex_elements_sw(struct NineDevice9 *device)
+update_vertex_elements_sw(struct NineDevice9 *device, struct cso_context *cso)
 {
     struct nine_state *state = &device->state;
     const struct NineVertexDeclaration9 *vdecl = device->state.vdecl;
@@ -3177,7 +3248,7 @@ update_vertex_elements_sw(struct NineDevice9 *device)
         }
     }
 
-    cso_set_vertex_elements(device->cso_sw, vs->num_inputs, ve);
+    cso_set_vertex_elements(cso, vs->num_inputs, ve);
 }
 
 static void
@@ -3239,10 +3310,9 @@ update_vertex_buffers_sw(struct NineDevice9 *device, int start_vertice, int num_
 }
 
 static void
-update_vs_constants_sw(struct NineDevice9 *device)
+update_vs_constants_sw(struct NineDevice9 *device, struct pipe_context *pipe_sw)
 {
     struct nine_state *state = &device->state;
-    struct pipe_context *pipe_sw = device->pipe_sw;
 
     DBG("updating\n");
 
@@ -3326,14 +3396,14 @@ update_vs_constants_sw(struct NineDevice9 *device)
         cb.user_buffer = viewport_data;
 
         {
-            u_upload_data(device->pipe_sw->const_uploader,
+            u_upload_data(pipe_sw->const_uploader,
                           0,
                           cb.buffer_size,
                           16,
                           cb.user_buffer,
                           &(cb.buffer_offset),
                           &(cb.buffer));
-            u_upload_unmap(device->pipe_sw->const_uploader);
+            u_upload_unmap(pipe_sw->const_uploader);
             cb.user_buffer = NULL;
         }
 
@@ -3357,12 +3427,73 @@ nine_state_prepare_draw_sw(struct NineDevice9 *device, struct NineVertexDeclarat
     DBG("Preparing draw\n");
     cso_set_vertex_shader_handle(device->cso_sw,
                                  NineVertexShader9_GetVariantProcessVertices(vs, vdecl_out, so));
-    update_vertex_elements_sw(device);
+    update_vertex_elements_sw(device, device->cso_sw);
     update_vertex_buffers_sw(device, start_vertice, num_vertices);
-    update_vs_constants_sw(device);
+    update_vs_constants_sw(device, device->pipe_sw);
     DBG("Preparation succeeded\n");
 }
 
+/* Same as nine_state_prepare_draw_sw, but on the device pipe.
+ * The context must be idle (see nine_context_get_pipe), and
+ * nine_state_after_draw_so restores the context state. */
+void
+nine_state_prepare_draw_so(struct NineDevice9 *device, struct NineVertexDeclaration9 *vdecl_out,
+                           int start_vertice, struct pipe_stream_output_info *so)
+{
+    struct nine_context *context = &device->context;
+    struct nine_state *state = &device->state;
+    struct pipe_context *pipe = context->pipe;
+    struct pipe_rasterizer_state rast;
+    unsigned i;
+
+    assert(state->vs && !(state->vdecl && state->vdecl->position_t));
+
+    DBG("Preparing draw\n");
+    pipe->bind_vs_state(pipe,
+                        NineVertexShader9_GetVariantProcessVertices(state->vs, vdecl_out, so));
+    update_vertex_elements_sw(device, context->cso);
+
+    /* The buffers are read by the gpu, no need to map them */
+    for (i = 0; i < 4; i++) {
+        if (state->stream[i]) {
+            struct pipe_vertex_buffer vtxbuf = state->vtxbuf[i];
+            unsigned offset;
+
+            vtxbuf.is_user_buffer = false;
+            vtxbuf.buffer.resource = NineVertexBuffer9_GetResource(state->stream[i], &offset);
+            vtxbuf.buffer_offset += offset + start_vertice * vtxbuf.stride;
+            pipe->set_vertex_buffers(pipe, i, 1, &vtxbuf);
+        } else
+            pipe->set_vertex_buffers(pipe, i, 1, NULL);
+    }
+
+    update_vs_constants_sw(device, pipe);
+
+    memset(&rast, 0, sizeof(rast));
+    rast.rasterizer_discard = true;
+    cso_set_rasterizer(context->cso, &rast);
+    DBG("Preparation succeeded\n");
+}
+
+void
+nine_state_after_draw_so(struct NineDevice9 *device)
+{
+    struct nine_context *context = &device->context;
+    struct pipe_context *pipe = context->pipe;
+    unsigned i;
+
+    pipe->bind_vs_state(pipe, context->cso_shader.vs);
+    for (i = 1; i <= 4; i++)
+        pipe->set_constant_buffer(pipe, PIPE_SHADER_VERTEX, i, NULL);
+
+    /* Let the next draw rebind what was overwritten */
+    context->changed.group |= NINE_STATE_VDECL;
+    context->changed.vtxbuf |= 0xf;
+    if (context->dummy_vbo_bound_at >= 0 && context->dummy_vbo_bound_at < 4)
+        context->vbo_bound_done = FALSE;
+    context->commit |= NINE_STATE_COMMIT_CONST_VS | NINE_STATE_COMMIT_RASTERIZER;
+}
+
 void
 nine_state_after_draw_sw(struct NineDevice9 *device)
 {
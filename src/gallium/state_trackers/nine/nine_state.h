@@ -588,6 +588,11 @@ nine_context_begin_query(struct NineDevice9 *device, unsigned *counter, struct p
 void
 nine_context_end_query(struct NineDevice9 *device, unsigned *counter, struct pipe_query *query);
 
+struct pipe_fence_handle;
+
+void
+nine_context_fence(struct NineDevice9 *device, struct pipe_fence_handle **fence);
+
 boolean
 nine_context_get_query_result(struct NineDevice9 *device, struct pipe_query *query,
                               unsigned *counter, boolean flush, boolean wait,
@@ -606,6 +611,11 @@ void nine_state_prepare_draw_sw(struct NineDevice9 *device,
                                 int num_vertices,
                                 struct pipe_stream_output_info *so);
 void nine_state_after_draw_sw(struct NineDevice9 *device);
+void nine_state_prepare_draw_so(struct NineDevice9 *device,
+                                struct NineVertexDeclaration9 *vdecl_out,
+                                int start_vertice,
+                                struct pipe_stream_output_info *so);
+void nine_state_after_draw_so(struct NineDevice9 *device);
 void nine_state_destroy_sw(struct NineDevice9 *device);
 
 /* If @alloc is FALSE, the return value may be a const identity matrix.
@@ -128,7 +128,10 @@ NineVertexShader9_dtor( struct NineVertexShader9 *This )
 
         while (var_so && var_so->vdecl) {
             if (var_so->cso) {
-                cso_delete_vertex_shader(This->base.device->cso_sw, var_so->cso );
+                if (This->base.device->driver_caps.process_vertices_hw)
+                    pipe->delete_vs_state(pipe, var_so->cso);
+                else
+                    cso_delete_vertex_shader(This->base.device->cso_sw, var_so->cso );
             }
             var_so = var_so->next;
         }
@@ -216,6 +219,7 @@ NineVertexShader9_GetVariantProcessVertices( struct NineVertexShader9 *This,
                                              struct NineVertexDeclaration9 *vdecl_out,
                                              struct pipe_stream_output_info *so )
 {
+    struct NineDevice9 *device = This->base.device;
     struct nine_shader_info info;
     HRESULT hr;
     void *cso;
@@ -235,7 +239,10 @@ NineVertexShader9_GetVariantProcessVertices( struct NineVertexShader9 *This,
     info.swvp_on = true;
     info.vdecl_out = vdecl_out;
     info.process_vertices = true;
-    hr = nine_translate_shader(This->base.device, &info, This->base.device->pipe_sw);
+    /* The device pipe is only used here once the context is idle */
+    hr = nine_translate_shader(device, &info,
+                               device->driver_caps.process_vertices_hw ?
+                               device->context.pipe : device->pipe_sw);
     if (FAILED(hr))
         return NULL;
     *so = info.so;
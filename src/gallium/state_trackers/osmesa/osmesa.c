@@ -38,9 +38,11 @@
  * With llvmpipe we could only render directly into the user's buffer when its
  * width and height is a multiple of the tile size (64 pixels).
  *
- * Because of these constraints we always render into ordinary resources then
- * copy the results to the user's buffer in the flush_front() function which
- * is called when the app calls glFlush/Finish.
+ * Because of these constraints we normally render into ordinary resources
+ * then copy the results to the user's buffer in the flush_front() function
+ * which is called when the app calls glFlush/Finish.  Only when the driver
+ * can wrap the user's buffer with its own stride and OSMESA_Y_UP is false
+ * do we render straight into it, see osmesa_create_user_color_resource().
  *
  * In general, the OSMesa interface is pretty ugly and not a good match
  * for Gallium.  But we're interested in doing the best we can to preserve
@@ -74,7 +76,7 @@
 
 
 extern struct pipe_screen *
-osmesa_create_screen(void);
+osmesa_create_screen(int num_threads, bool pin_threads);
 
 
 
@@ -88,6 +90,11 @@ struct osmesa_buffer
 
    void *map;
 
+   /** Row stride of map when the color buffer is rendered into it directly,
+    * zero otherwise.
+    */
+   unsigned direct_stride;
+
    struct osmesa_buffer *next;  /**< next in linked list */
 };
 
@@ -125,6 +132,14 @@ struct osmesa_context
 static struct osmesa_buffer *BufferList = NULL;
 
 
+/**
+ * Driver threading, from the attributes of the first context created.
+ * The screen and with it the rendering threads are shared by all contexts.
+ */
+static int ScreenNumThreads = -1;
+static bool ScreenPinThreads = false;
+
+
 /**
  * Called from the ST manager.
  */
@@ -160,7 +175,8 @@ get_st_manager(void)
    if (!stmgr) {
       stmgr = CALLOC_STRUCT(st_manager);
       if (stmgr) {
-         stmgr->screen = osmesa_create_screen();
+         stmgr->screen = osmesa_create_screen(ScreenNumThreads,
+                                              ScreenPinThreads);
          stmgr->get_param = osmesa_st_get_param;
          stmgr->get_egl_image = NULL;
       }         
@@ -342,6 +358,17 @@ osmesa_st_framebuffer_flush_front(struct st_context_iface *stctx,
       pp_run(osmesa->pp, res, res, zsbuf);
    }
 
+   if (osbuffer->direct_stride &&
+       res == osbuffer->textures[ST_ATTACHMENT_FRONT_LEFT]) {
+      /* Rendered in place, mapping just waits for the rendering to finish. */
+      u_box_2d(0, 0, 1, 1, &box);
+      map = pipe->transfer_map(pipe, res, 0, PIPE_TRANSFER_READ, &box,
+                               &transfer);
+      if (map)
+         pipe->transfer_unmap(pipe, transfer);
+      return TRUE;
+   }
+
    u_box_2d(0, 0, res->width0, res->height0, &box);
 
    map = pipe->transfer_map(pipe, res, 0, PIPE_TRANSFER_READ, &box,
@@ -377,6 +404,73 @@ osmesa_st_framebuffer_flush_front(struct st_context_iface *stctx,
 }
 
 
+/**
+ * Return the row stride of the user's buffer if the color buffer could be
+ * rendered into it directly, else zero.  Drivers render rows top-down.
+ */
+static unsigned
+osmesa_user_stride_for_direct(const OSMesaContext osmesa,
+                              const struct osmesa_buffer *osbuffer)
+{
+   unsigned bpp = util_format_get_blocksize(osbuffer->visual.color_format);
+
+   if (!osmesa || osmesa->y_up)
+      return 0;
+
+   if (osmesa->user_row_length)
+      return bpp * osmesa->user_row_length;
+   else
+      return bpp * osbuffer->width;
+}
+
+
+/**
+ * Try to wrap the user's buffer in the color resource, so rendering goes
+ * straight into it and flush_front() has nothing to copy.  The driver must
+ * accept the memory and use the same row stride as the user's buffer.
+ */
+static struct pipe_resource *
+osmesa_create_user_color_resource(struct st_context_iface *stctx,
+                                  struct osmesa_buffer *osbuffer,
+                                  const struct pipe_resource *templat)
+{
+   struct pipe_context *pipe = stctx->pipe;
+   struct pipe_screen *screen = pipe->screen;
+   unsigned stride = osmesa_user_stride_for_direct(stctx->st_manager_private,
+                                                   osbuffer);
+   struct pipe_resource *res;
+   struct pipe_transfer *transfer;
+   struct pipe_box box;
+
+   if (!stride ||
+       !screen->get_param(screen, PIPE_CAP_RESOURCE_FROM_USER_MEMORY))
+      return NULL;
+
+   res = screen->resource_from_user_memory(screen, templat, osbuffer->map);
+   if (!res)
+      return NULL;
+
+   u_box_2d(0, 0, 1, 1, &box);
+   if (!pipe->transfer_map(pipe, res, 0,
+                           PIPE_TRANSFER_READ | PIPE_TRANSFER_UNSYNCHRONIZED,
+                           &box, &transfer)) {
+      pipe_resource_reference(&res, NULL);
+      return NULL;
+   }
+   if (transfer->stride != stride)
+      stride = 0;
+   pipe->transfer_unmap(pipe, transfer);
+
+   if (!stride) {
+      pipe_resource_reference(&res, NULL);
+      return NULL;
+   }
+
+   osbuffer->direct_stride = stride;
+   return res;
+}
+
+
 /**
  * Called by the st manager to validate the framebuffer (allocate
  * its resources).
@@ -408,6 +502,7 @@ osmesa_st_framebuffer_validate(struct st_context_iface *stctx,
    for (i = 0; i < count; i++) {
       enum pipe_format format = PIPE_FORMAT_NONE;
       unsigned bind = 0;
+      struct pipe_resource *res = NULL;
 
       /*
        * At this time, we really only need to handle the front-left color
@@ -434,8 +529,14 @@ osmesa_st_framebuffer_validate(struct st_context_iface *stctx,
       templat.format = format;
       templat.bind = bind;
       pipe_resource_reference(&out[i], NULL);
-      out[i] = osbuffer->textures[statts[i]] =
-         screen->resource_create(screen, &templat);
+      if (statts[i] == ST_ATTACHMENT_FRONT_LEFT) {
+         osbuffer->direct_stride = 0;
+         res = osmesa_create_user_color_resource(stctx, osbuffer,
+                                                 &templat);
+      }
+      if (!res)
+         res = screen->resource_create(screen, &templat);
+      out[i] = osbuffer->textures[statts[i]] = res;
    }
 
    return TRUE;
@@ -510,6 +611,22 @@ osmesa_find_buffer(enum pipe_format color_format,
 }
 
 
+/**
+ * Make the state tracker validate the buffer again if its color buffer is
+ * rendered into the user's buffer directly, but that no longer matches
+ * the context's pixel store settings.
+ */
+static void
+osmesa_check_direct_buffer(OSMesaContext osmesa,
+                           struct osmesa_buffer *osbuffer)
+{
+   if (osbuffer && osbuffer->direct_stride &&
+       osbuffer->direct_stride != osmesa_user_stride_for_direct(osmesa,
+                                                                osbuffer))
+      p_atomic_inc(&osbuffer->stfb->stamp);
+}
+
+
 static void
 osmesa_destroy_buffer(struct osmesa_buffer *osbuffer)
 {
@@ -589,6 +706,8 @@ OSMesaCreateContextAttribs(const int *attribList, OSMesaContext sharelist)
    GLenum format = GL_RGBA;
    int depthBits = 0, stencilBits = 0, accumBits = 0;
    int profile = OSMESA_COMPAT_PROFILE, version_major = 1, version_minor = 0;
+   int num_threads = -1;
+   bool pin_threads = false;
    int i;
 
    if (sharelist) {
@@ -647,6 +766,14 @@ OSMesaCreateContextAttribs(const int *attribList, OSMesaContext sharelist)
          if (version_minor < 0)
             return NULL;
          break;
+      case OSMESA_NUM_THREADS:
+         num_threads = attribList[i+1];
+         if (num_threads < -1)
+            return NULL;
+         break;
+      case OSMESA_PIN_THREADS:
+         pin_threads = attribList[i+1] != 0;
+         break;
       case 0:
          /* end of list */
          break;
@@ -656,6 +783,10 @@ OSMesaCreateContextAttribs(const int *attribList, OSMesaContext sharelist)
       }
    }
 
+   /* only used when this is the first context and creates the screen */
+   ScreenNumThreads = num_threads;
+   ScreenPinThreads = pin_threads;
+
    osmesa = (OSMesaContext) CALLOC_STRUCT(osmesa_context);
    if (!osmesa)
       return NULL;
@@ -786,10 +917,16 @@ OSMesaMakeCurrent(OSMesaContext osmesa, void *buffer, GLenum type,
                                       osmesa->accum_format);
    }
 
+   /* A new buffer needs a new resource to render into directly */
+   if (osbuffer->direct_stride && osbuffer->map != buffer)
+      p_atomic_inc(&osbuffer->stfb->stamp);
+
    osbuffer->width = width;
    osbuffer->height = height;
    osbuffer->map = buffer;
 
+   osmesa_check_direct_buffer(osmesa, osbuffer);
+
    /* XXX unused for now */
    (void) osmesa_destroy_buffer;
 
@@ -852,6 +989,8 @@ OSMesaPixelStore(GLint pname, GLint value)
       fprintf(stderr, "Invalid pname in OSMesaPixelStore()\n");
       return;
    }
+
+   osmesa_check_direct_buffer(osmesa, osmesa->current_buffer);
 }
 
 
@@ -479,6 +479,12 @@ vlVaQuerySurfaceAttributes(VADriverContextP ctx, VAConfigID config_id,
    attribs[i].value.value.p = NULL; /* ignore */
    i++;
 
+   attribs[i].type = VASurfaceAttribUsageHint;
+   attribs[i].value.type = VAGenericValueTypeInteger;
+   attribs[i].flags = VA_SURFACE_ATTRIB_SETTABLE;
+   attribs[i].value.value.i = VL_VA_PROGRESSIVE_USAGE_HINTS;
+   i++;
+
    if (config->entrypoint != PIPE_VIDEO_ENTRYPOINT_UNKNOWN) {
       attribs[i].type = VASurfaceAttribMaxWidth;
       attribs[i].value.type = VAGenericValueTypeInteger;
@@ -635,6 +641,39 @@ vlVaHandleSurfaceAllocate(vlVaDriver *drv, vlVaSurface *surface,
    return VA_STATUS_SUCCESS;
 }
 
+/* Switch an interlaced surface to the progressive layout that the encoders
+ * and DRM PRIME consumers expect, weaving the existing fields into it. */
+VAStatus
+vlVaHandleSurfaceMakeProgressive(vlVaDriver *drv, vlVaSurface *surface)
+{
+   struct pipe_video_buffer *interlaced = surface->buffer;
+   struct u_rect src_rect, dst_rect;
+
+   if (!interlaced->interlaced)
+      return VA_STATUS_SUCCESS;
+
+   surface->templat.interlaced = false;
+   if (vlVaHandleSurfaceAllocate(drv, surface, &surface->templat) != VA_STATUS_SUCCESS) {
+      surface->templat.interlaced = true;
+      surface->buffer = interlaced;
+      return VA_STATUS_ERROR_ALLOCATION_FAILED;
+   }
+
+   src_rect.x0 = dst_rect.x0 = 0;
+   src_rect.y0 = dst_rect.y0 = 0;
+   src_rect.x1 = dst_rect.x1 = surface->templat.width;
+   src_rect.y1 = dst_rect.y1 = surface->templat.height;
+
+   vl_compositor_yuv_deint_full(&drv->cstate, &drv->compositor,
+                                interlaced, surface->buffer,
+                                &src_rect, &dst_rect,
+                                VL_COMPOSITOR_WEAVE);
+
+   interlaced->destroy(interlaced);
+
+   return VA_STATUS_SUCCESS;
+}
+
 VAStatus
 vlVaCreateSurfaces2(VADriverContextP ctx, unsigned int format,
                     unsigned int width, unsigned int height,
@@ -648,6 +687,7 @@ vlVaCreateSurfaces2(VADriverContextP ctx, unsigned int format,
    int i;
    int memory_type;
    int expected_fourcc;
+   unsigned usage_hint;
    VAStatus vaStatus;
    vlVaSurface *surf;
 
@@ -671,6 +711,7 @@ vlVaCreateSurfaces2(VADriverContextP ctx, unsigned int format,
    memory_attribute = NULL;
    memory_type = VA_SURFACE_ATTRIB_MEM_TYPE_VA;
    expected_fourcc = 0;
+   usage_hint = VA_SURFACE_ATTRIB_USAGE_HINT_GENERIC;
 
    for (i = 0; i < num_attribs && attrib_list; i++) {
       if ((attrib_list[i].type == VASurfaceAttribPixelFormat) &&
@@ -696,6 +737,13 @@ vlVaCreateSurfaces2(VADriverContextP ctx, unsigned int format,
          }
       }
 
+      if ((attrib_list[i].type == VASurfaceAttribUsageHint) &&
+          (attrib_list[i].flags & VA_SURFACE_ATTRIB_SETTABLE)) {
+         if (attrib_list[i].value.type != VAGenericValueTypeInteger)
+            return VA_STATUS_ERROR_INVALID_PARAMETER;
+         usage_hint = attrib_list[i].value.value.i;
+      }
+
       if ((attrib_list[i].type == VASurfaceAttribExternalBufferDescriptor) &&
           (attrib_list[i].flags == VA_SURFACE_ATTRIB_SETTABLE)) {
          if (attrib_list[i].value.type != VAGenericValueTypePointer)
@@ -749,6 +797,13 @@ vlVaCreateSurfaces2(VADriverContextP ctx, unsigned int format,
       templat.buffer_format = expected_format;
    }
 
+   /* Surfaces that end up in an encoder or get exported are consumed
+    * progressively, so decode into that layout right away instead of
+    * reallocating and weaving the surface on its first use there.
+    */
+   if (usage_hint & VL_VA_PROGRESSIVE_USAGE_HINTS)
+      templat.interlaced = 0;
+
    templat.chroma_format = ChromaToPipe(format);
 
    templat.width = width;
@@ -972,29 +1027,10 @@ vlVaExportSurfaceHandle(VADriverContextP ctx,
       return VA_STATUS_ERROR_INVALID_SURFACE;
    }
 
-   if (surf->buffer->interlaced) {
-      struct pipe_video_buffer *interlaced = surf->buffer;
-      struct u_rect src_rect, dst_rect;
-
-      surf->templat.interlaced = false;
-
-      ret = vlVaHandleSurfaceAllocate(drv, surf, &surf->templat);
-      if (ret != VA_STATUS_SUCCESS) {
-         mtx_unlock(&drv->mutex);
-         return VA_STATUS_ERROR_ALLOCATION_FAILED;
-      }
-
-      src_rect.x0 = dst_rect.x0 = 0;
-      src_rect.y0 = dst_rect.y0 = 0;
-      src_rect.x1 = dst_rect.x1 = surf->templat.width;
-      src_rect.y1 = dst_rect.y1 = surf->templat.height;
-
-      vl_compositor_yuv_deint_full(&drv->cstate, &drv->compositor,
-                                   interlaced, surf->buffer,
-                                   &src_rect, &dst_rect,
-                                   VL_COMPOSITOR_WEAVE);
-
-      interlaced->destroy(interlaced);
+   ret = vlVaHandleSurfaceMakeProgressive(drv, surf);
+   if (ret != VA_STATUS_SUCCESS) {
+      mtx_unlock(&drv->mutex);
+      return ret;
    }
 
    surfaces = surf->buffer->get_surfaces(surf->buffer);
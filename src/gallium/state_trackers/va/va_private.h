@@ -52,6 +52,14 @@
 #define VL_VA_MAX_IMAGE_FORMATS 11
 #define VL_VA_ENC_GOP_COEFF 16
 
+/* usage hints for which surfaces are allocated with a progressive layout */
+#ifdef VA_SURFACE_ATTRIB_USAGE_HINT_EXPORT
+#define VL_VA_PROGRESSIVE_USAGE_HINTS (VA_SURFACE_ATTRIB_USAGE_HINT_ENCODER | \
+                                       VA_SURFACE_ATTRIB_USAGE_HINT_EXPORT)
+#else
+#define VL_VA_PROGRESSIVE_USAGE_HINTS VA_SURFACE_ATTRIB_USAGE_HINT_ENCODER
+#endif
+
 #define UINT_TO_PTR(x) ((void*)(uintptr_t)(x))
 #define PTR_TO_UINT(x) ((unsigned)((intptr_t)(x)))
 
@@ -417,6 +425,7 @@ VAStatus vlVaQueryVideoProcPipelineCaps(VADriverContextP ctx, VAContextID contex
 // internal functions
 VAStatus vlVaHandleVAProcPipelineParameterBufferType(vlVaDriver *drv, vlVaContext *context, vlVaBuffer *buf);
 VAStatus vlVaHandleSurfaceAllocate(vlVaDriver *drv, vlVaSurface *surface, struct pipe_video_buffer *templat);
+VAStatus vlVaHandleSurfaceMakeProgressive(vlVaDriver *drv, vlVaSurface *surface);
 void vlVaGetReferenceFrame(vlVaDriver *drv, VASurfaceID surface_id, struct pipe_video_buffer **ref_frame);
 void vlVaHandlePictureParameterBufferMPEG12(vlVaDriver *drv, vlVaContext *context, vlVaBuffer *buf);
 void vlVaHandleIQMatrixBufferMPEG12(vlVaContext *context, vlVaBuffer *buf);
@@ -28,14 +28,19 @@
 
 
 struct pipe_screen *
-osmesa_create_screen(void);
+osmesa_create_screen(int num_threads, bool pin_threads);
 
 
+/**
+ * \param num_threads  number of rendering threads for llvmpipe, negative
+ *                     for the default
+ * \param pin_threads  pin llvmpipe's rendering threads to CPUs
+ */
 struct pipe_screen *
-osmesa_create_screen(void)
+osmesa_create_screen(int num_threads, bool pin_threads)
 {
    struct sw_winsys *winsys;
-   struct pipe_screen *screen;
+   struct pipe_screen *screen = NULL;
 
    /* We use a null software winsys since we always just render to ordinary
     * driver resources.
@@ -45,7 +50,13 @@ osmesa_create_screen(void)
       return NULL;
 
    /* Create llvmpipe or softpipe screen */
-   screen = sw_screen_create(winsys);
+#if defined(GALLIUM_LLVMPIPE)
+   if (strcmp(debug_get_option("GALLIUM_DRIVER", "llvmpipe"), "llvmpipe") == 0)
+      screen = llvmpipe_create_screen_with_threads(winsys, num_threads,
+                                                   pin_threads);
+#endif
+   if (!screen)
+      screen = sw_screen_create(winsys);
    if (!screen) {
       winsys->destroy(winsys);
       return NULL;
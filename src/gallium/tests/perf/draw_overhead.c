@@ -0,0 +1,516 @@
+/**************************************************************************
+ *
+ * Copyright 2018 Advanced Micro Devices, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+/*
+ * Measures the CPU cost of draws through cso_context and the driver, for
+ * a few common patterns of state changes between draws.
+ *
+ *    draw_overhead [-d device] [-i iterations] [-n] [-t] [case...]
+ *
+ * -d selects the pipe-loader device, -n replaces the driver with the noop
+ * driver (GALLIUM_NOOP), leaving only the cost of cso_context and the
+ * state objects, and -t asks for a threaded context (u_threaded_context)
+ * on drivers which support it. Without case names, all cases are run.
+ *
+ * "submit" is the time the calling thread spends in the draw loop,
+ * "total" also includes the final flush and waiting for its fence, so it
+ * covers the work deferred to the driver thread or the GPU.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cso_cache/cso_context.h"
+#include "pipe/p_context.h"
+#include "pipe/p_defines.h"
+#include "pipe/p_screen.h"
+#include "pipe/p_shader_tokens.h"
+#include "pipe/p_state.h"
+#include "pipe-loader/pipe_loader.h"
+#include "tgsi/tgsi_text.h"
+#include "util/os_time.h"
+#include "util/u_draw.h"
+#include "util/u_inlines.h"
+#include "util/u_memory.h"
+#include "util/u_sampler.h"
+#include "util/u_surface.h"
+
+#define BENCH_SIZE 64
+#define BENCH_NUM_TRIS 256
+#define BENCH_TRI_SIZE (3 * 4 * sizeof(float))
+#define BENCH_MULTI_DRAWS 16
+#define BENCH_WARMUP 100
+
+struct bench {
+   struct pipe_screen *screen;
+   struct pipe_context *pipe;
+   struct cso_context *cso;
+
+   struct pipe_resource *rt;
+   struct pipe_surface *surf;
+   struct pipe_resource *tex[2];
+   struct pipe_sampler_view *views[2];
+   struct pipe_resource *vbuf;
+   void *vs, *fs;
+
+   struct pipe_blend_state blend[2];
+   struct pipe_vertex_buffer vb;
+   struct pipe_draw_info info;
+   float consts[2][4];
+};
+
+struct bench_case {
+   const char *name;
+   /* Draw iteration i, returns the number of draws done. */
+   unsigned (*draw)(struct bench *b, unsigned i);
+};
+
+static unsigned
+bench_draw(struct bench *b, unsigned i)
+{
+   cso_draw_vbo(b->cso, &b->info);
+   return 1;
+}
+
+static unsigned
+bench_constant(struct bench *b, unsigned i)
+{
+   cso_set_constant_user_buffer(b->cso, PIPE_SHADER_VERTEX, 0,
+                                b->consts[i & 1], sizeof(b->consts[0]));
+   cso_draw_vbo(b->cso, &b->info);
+   return 1;
+}
+
+static unsigned
+bench_texture(struct bench *b, unsigned i)
+{
+   cso_set_sampler_views(b->cso, PIPE_SHADER_FRAGMENT, 1, &b->views[i & 1]);
+   cso_draw_vbo(b->cso, &b->info);
+   return 1;
+}
+
+static unsigned
+bench_blend(struct bench *b, unsigned i)
+{
+   cso_set_blend(b->cso, &b->blend[i & 1]);
+   cso_draw_vbo(b->cso, &b->info);
+   return 1;
+}
+
+static unsigned
+bench_vbo_offset(struct bench *b, unsigned i)
+{
+   b->vb.buffer_offset = (i % BENCH_NUM_TRIS) * BENCH_TRI_SIZE;
+   cso_set_vertex_buffers(b->cso, 0, 1, &b->vb);
+   cso_draw_vbo(b->cso, &b->info);
+   return 1;
+}
+
+static unsigned
+bench_vbo_update(struct bench *b, unsigned i)
+{
+   const unsigned tri = i % BENCH_NUM_TRIS;
+   const float z = (i & 1) ? 0.25f : 0.0f;
+
+   /* Rewrite the z of the first vertex of the triangle. */
+   b->pipe->buffer_subdata(b->pipe, b->vbuf, PIPE_TRANSFER_WRITE,
+                           tri * BENCH_TRI_SIZE + 2 * sizeof(float),
+                           sizeof(z), &z);
+   b->info.start = tri * 3;
+   cso_draw_vbo(b->cso, &b->info);
+   return 1;
+}
+
+static unsigned
+bench_multi_draw(struct bench *b, unsigned i)
+{
+   struct pipe_draw_range draws[BENCH_MULTI_DRAWS];
+
+   for (unsigned j = 0; j < BENCH_MULTI_DRAWS; j++) {
+      draws[j].start = ((i * BENCH_MULTI_DRAWS + j) % BENCH_NUM_TRIS) * 3;
+      draws[j].count = 3;
+      draws[j].index_bias = 0;
+   }
+   cso_multi_draw(b->cso, &b->info, draws, BENCH_MULTI_DRAWS);
+   return BENCH_MULTI_DRAWS;
+}
+
+static const struct bench_case cases[] = {
+   { "draw", bench_draw },
+   { "constant", bench_constant },
+   { "texture", bench_texture },
+   { "blend", bench_blend },
+   { "vbo-offset", bench_vbo_offset },
+   { "vbo-update", bench_vbo_update },
+   { "multi-draw", bench_multi_draw },
+};
+
+static void *
+bench_create_shader(struct bench *b, enum pipe_shader_type stage,
+                    const char *text)
+{
+   struct tgsi_token tokens[1024];
+   struct pipe_shader_state state;
+
+   if (!tgsi_text_translate(text, tokens, ARRAY_SIZE(tokens)))
+      return NULL;
+
+   pipe_shader_state_from_tgsi(&state, tokens);
+   if (stage == PIPE_SHADER_VERTEX)
+      return b->pipe->create_vs_state(b->pipe, &state);
+   return b->pipe->create_fs_state(b->pipe, &state);
+}
+
+static enum pipe_format
+bench_choose_format(struct pipe_screen *screen, unsigned bind)
+{
+   static const enum pipe_format formats[] = {
+      PIPE_FORMAT_B8G8R8A8_UNORM,
+      PIPE_FORMAT_R8G8B8A8_UNORM,
+   };
+
+   for (unsigned i = 0; i < ARRAY_SIZE(formats); i++) {
+      if (screen->is_format_supported(screen, formats[i], PIPE_TEXTURE_2D,
+                                      0, 0, bind))
+         return formats[i];
+   }
+   return PIPE_FORMAT_NONE;
+}
+
+static struct pipe_resource *
+bench_create_texture(struct bench *b, enum pipe_format format, unsigned bind)
+{
+   struct pipe_resource templ;
+
+   memset(&templ, 0, sizeof(templ));
+   templ.target = PIPE_TEXTURE_2D;
+   templ.format = format;
+   templ.width0 = BENCH_SIZE;
+   templ.height0 = BENCH_SIZE;
+   templ.depth0 = 1;
+   templ.array_size = 1;
+   templ.bind = bind;
+
+   return b->screen->resource_create(b->screen, &templ);
+}
+
+static bool
+bench_init(struct bench *b, unsigned context_flags)
+{
+   static const char *vs_text =
+      "VERT\n"
+      "DCL IN[0]\n"
+      "DCL OUT[0], POSITION\n"
+      "DCL OUT[1], GENERIC[0]\n"
+      "DCL CONST[0]\n"
+      "  0: ADD OUT[0], IN[0], CONST[0]\n"
+      "  1: MOV OUT[1], IN[0]\n"
+      "  2: END\n";
+   static const char *fs_text =
+      "FRAG\n"
+      "DCL IN[0], GENERIC[0], PERSPECTIVE\n"
+      "DCL OUT[0], COLOR\n"
+      "DCL SAMP[0]\n"
+      "DCL SVIEW[0], 2D, FLOAT\n"
+      "  0: TEX OUT[0], IN[0], SAMP[0], 2D\n"
+      "  1: END\n";
+   struct pipe_framebuffer_state fb;
+   struct pipe_surface surf_templ;
+   struct pipe_sampler_view view_templ;
+   struct pipe_rasterizer_state rast;
+   struct pipe_depth_stencil_alpha_state dsa;
+   struct pipe_sampler_state sampler;
+   const struct pipe_sampler_state *samplers[] = { &sampler };
+   struct pipe_vertex_element velem;
+   enum pipe_format rt_format, tex_format;
+   float *verts;
+
+   b->pipe = b->screen->context_create(b->screen, NULL, context_flags);
+   if (!b->pipe)
+      return false;
+   b->cso = cso_create_context(b->pipe, 0);
+
+   rt_format = bench_choose_format(b->screen, PIPE_BIND_RENDER_TARGET);
+   tex_format = bench_choose_format(b->screen, PIPE_BIND_SAMPLER_VIEW);
+   if (rt_format == PIPE_FORMAT_NONE || tex_format == PIPE_FORMAT_NONE)
+      return false;
+
+   b->rt = bench_create_texture(b, rt_format, PIPE_BIND_RENDER_TARGET);
+   if (!b->rt)
+      return false;
+   u_surface_default_template(&surf_templ, b->rt);
+   b->surf = b->pipe->create_surface(b->pipe, b->rt, &surf_templ);
+   if (!b->surf)
+      return false;
+
+   for (unsigned i = 0; i < 2; i++) {
+      b->tex[i] = bench_create_texture(b, tex_format, PIPE_BIND_SAMPLER_VIEW);
+      if (!b->tex[i])
+         return false;
+      u_sampler_view_default_template(&view_templ, b->tex[i], tex_format);
+      b->views[i] = b->pipe->create_sampler_view(b->pipe, b->tex[i],
+                                                 &view_templ);
+      if (!b->views[i])
+         return false;
+   }
+
+   /* Small triangles in the middle of the render target. */
+   verts = CALLOC(BENCH_NUM_TRIS * 3 * 4, sizeof(float));
+   if (!verts)
+      return false;
+   for (unsigned i = 0; i < BENCH_NUM_TRIS * 3; i++) {
+      verts[i * 4 + 0] = (i % 3 == 1) ? 0.1f : 0.0f;
+      verts[i * 4 + 1] = (i % 3 == 2) ? 0.1f : 0.0f;
+      verts[i * 4 + 3] = 1.0f;
+   }
+   b->vbuf = pipe_buffer_create(b->screen, PIPE_BIND_VERTEX_BUFFER,
+                                PIPE_USAGE_DEFAULT,
+                                BENCH_NUM_TRIS * BENCH_TRI_SIZE);
+   if (b->vbuf)
+      pipe_buffer_write(b->pipe, b->vbuf, 0, BENCH_NUM_TRIS * BENCH_TRI_SIZE,
+                        verts);
+   FREE(verts);
+   if (!b->vbuf)
+      return false;
+
+   b->vs = bench_create_shader(b, PIPE_SHADER_VERTEX, vs_text);
+   b->fs = bench_create_shader(b, PIPE_SHADER_FRAGMENT, fs_text);
+   if (!b->vs || !b->fs)
+      return false;
+
+   memset(&b->blend, 0, sizeof(b->blend));
+   b->blend[0].rt[0].colormask = PIPE_MASK_RGBA;
+   b->blend[1].rt[0].colormask = PIPE_MASK_RGBA;
+   b->blend[1].rt[0].blend_enable = 1;
+   b->blend[1].rt[0].rgb_func = PIPE_BLEND_ADD;
+   b->blend[1].rt[0].rgb_src_factor = PIPE_BLENDFACTOR_SRC_ALPHA;
+   b->blend[1].rt[0].rgb_dst_factor = PIPE_BLENDFACTOR_INV_SRC_ALPHA;
+   b->blend[1].rt[0].alpha_func = PIPE_BLEND_ADD;
+   b->blend[1].rt[0].alpha_src_factor = PIPE_BLENDFACTOR_ONE;
+   b->blend[1].rt[0].alpha_dst_factor = PIPE_BLENDFACTOR_ZERO;
+
+   memset(&rast, 0, sizeof(rast));
+   rast.half_pixel_center = 1;
+   rast.bottom_edge_rule = 1;
+   rast.depth_clip = 1;
+
+   memset(&dsa, 0, sizeof(dsa));
+
+   memset(&sampler, 0, sizeof(sampler));
+   sampler.wrap_s = PIPE_TEX_WRAP_CLAMP_TO_EDGE;
+   sampler.wrap_t = PIPE_TEX_WRAP_CLAMP_TO_EDGE;
+   sampler.wrap_r = PIPE_TEX_WRAP_CLAMP_TO_EDGE;
+   sampler.min_img_filter = PIPE_TEX_FILTER_NEAREST;
+   sampler.mag_img_filter = PIPE_TEX_FILTER_NEAREST;
+   sampler.min_mip_filter = PIPE_TEX_MIPFILTER_NONE;
+   sampler.normalized_coords = 1;
+
+   memset(&velem, 0, sizeof(velem));
+   velem.src_format = PIPE_FORMAT_R32G32B32A32_FLOAT;
+
+   memset(&fb, 0, sizeof(fb));
+   fb.width = BENCH_SIZE;
+   fb.height = BENCH_SIZE;
+   fb.nr_cbufs = 1;
+   fb.cbufs[0] = b->surf;
+
+   memset(&b->vb, 0, sizeof(b->vb));
+   b->vb.stride = 4 * sizeof(float);
+   b->vb.buffer.resource = b->vbuf;
+
+   b->consts[1][0] = 0.25f;
+
+   cso_set_framebuffer(b->cso, &fb);
+   cso_set_viewport_dims(b->cso, BENCH_SIZE, BENCH_SIZE, FALSE);
+   cso_set_rasterizer(b->cso, &rast);
+   cso_set_depth_stencil_alpha(b->cso, &dsa);
+   cso_set_samplers(b->cso, PIPE_SHADER_FRAGMENT, 1, samplers);
+   cso_set_vertex_elements(b->cso, 1, &velem);
+   cso_set_vertex_shader_handle(b->cso, b->vs);
+   cso_set_fragment_shader_handle(b->cso, b->fs);
+   return true;
+}
+
+/* Bind the default state before each case. */
+static void
+bench_reset(struct bench *b)
+{
+   b->vb.buffer_offset = 0;
+   cso_set_vertex_buffers(b->cso, 0, 1, &b->vb);
+   cso_set_blend(b->cso, &b->blend[0]);
+   cso_set_sampler_views(b->cso, PIPE_SHADER_FRAGMENT, 1, &b->views[0]);
+   cso_set_constant_user_buffer(b->cso, PIPE_SHADER_VERTEX, 0,
+                                b->consts[0], sizeof(b->consts[0]));
+
+   util_draw_init_info(&b->info);
+   b->info.mode = PIPE_PRIM_TRIANGLES;
+   b->info.count = 3;
+}
+
+static void
+bench_finish(struct bench *b)
+{
+   struct pipe_fence_handle *fence = NULL;
+
+   b->pipe->flush(b->pipe, &fence, 0);
+   if (fence) {
+      b->screen->fence_finish(b->screen, NULL, fence, PIPE_TIMEOUT_INFINITE);
+      b->screen->fence_reference(b->screen, &fence, NULL);
+   }
+}
+
+static void
+bench_run(struct bench *b, const struct bench_case *c, unsigned iterations)
+{
+   unsigned draws = 0;
+   int64_t start, submit, total;
+
+   bench_reset(b);
+   for (unsigned i = 0; i < BENCH_WARMUP; i++)
+      c->draw(b, i);
+   bench_finish(b);
+
+   start = os_time_get_nano();
+   for (unsigned i = 0; i < iterations; i++)
+      draws += c->draw(b, i);
+   submit = os_time_get_nano() - start;
+   bench_finish(b);
+   total = os_time_get_nano() - start;
+
+   printf("%-16s %10u %12.1f %12.1f\n", c->name, draws,
+          (double)submit / draws, (double)total / draws);
+}
+
+static void
+bench_destroy(struct bench *b)
+{
+   if (b->cso)
+      cso_destroy_context(b->cso);
+   if (b->pipe) {
+      if (b->vs)
+         b->pipe->delete_vs_state(b->pipe, b->vs);
+      if (b->fs)
+         b->pipe->delete_fs_state(b->pipe, b->fs);
+      for (unsigned i = 0; i < 2; i++)
+         pipe_sampler_view_reference(&b->views[i], NULL);
+      pipe_surface_reference(&b->surf, NULL);
+   }
+   for (unsigned i = 0; i < 2; i++)
+      pipe_resource_reference(&b->tex[i], NULL);
+   pipe_resource_reference(&b->rt, NULL);
+   pipe_resource_reference(&b->vbuf, NULL);
+   if (b->pipe)
+      b->pipe->destroy(b->pipe);
+}
+
+static void
+usage(void)
+{
+   fprintf(stderr, "usage: draw_overhead [-d device] [-i iterations] [-n] "
+           "[-t] [case...]\n"
+           "cases:");
+   for (unsigned i = 0; i < ARRAY_SIZE(cases); i++)
+      fprintf(stderr, " %s", cases[i].name);
+   fprintf(stderr, "\n");
+   exit(1);
+}
+
+int
+main(int argc, char **argv)
+{
+   struct pipe_loader_device **devs;
+   struct bench b = {0};
+   bool selected[ARRAY_SIZE(cases)] = {0};
+   bool any_selected = false;
+   unsigned iterations = 100000, device = 0, context_flags = 0;
+   int num_devs;
+
+   for (int i = 1; i < argc; i++) {
+      if (!strcmp(argv[i], "-d") && i + 1 < argc) {
+         device = atoi(argv[++i]);
+      } else if (!strcmp(argv[i], "-i") && i + 1 < argc) {
+         iterations = MAX2(atoi(argv[++i]), 1);
+      } else if (!strcmp(argv[i], "-n")) {
+         /* Read by the screen wrappers of the pipe-loader targets. */
+         setenv("GALLIUM_NOOP", "true", 1);
+      } else if (!strcmp(argv[i], "-t")) {
+         context_flags |= PIPE_CONTEXT_PREFER_THREADED;
+      } else if (argv[i][0] != '-') {
+         unsigned c;
+
+         for (c = 0; c < ARRAY_SIZE(cases); c++) {
+            if (!strcmp(argv[i], cases[c].name))
+               break;
+         }
+         if (c == ARRAY_SIZE(cases))
+            usage();
+         selected[c] = any_selected = true;
+      } else {
+         usage();
+      }
+   }
+
+   num_devs = pipe_loader_probe(NULL, 0);
+   if (num_devs <= 0) {
+      fprintf(stderr, "draw_overhead: no device found\n");
+      return 77; /* skipped */
+   }
+   devs = CALLOC(num_devs, sizeof(*devs));
+   pipe_loader_probe(devs, num_devs);
+   if (device >= (unsigned)num_devs) {
+      fprintf(stderr, "draw_overhead: device %u not found\n", device);
+      return 1;
+   }
+
+   b.screen = pipe_loader_create_screen(devs[device]);
+   if (!b.screen) {
+      fprintf(stderr, "draw_overhead: can't create the screen\n");
+      return 1;
+   }
+   printf("device: %s\n", b.screen->get_name(b.screen));
+
+   if (!bench_init(&b, context_flags)) {
+      fprintf(stderr, "draw_overhead: can't create the benchmark state\n");
+      bench_destroy(&b);
+      b.screen->destroy(b.screen);
+      return 1;
+   }
+
+   printf("%u iterations\n\n", iterations);
+   printf("%-16s %10s %12s %12s\n", "case", "draws", "submit ns", "total ns");
+   for (unsigned i = 0; i < ARRAY_SIZE(cases); i++) {
+      if (!any_selected || selected[i])
+         bench_run(&b, &cases[i], iterations);
+   }
+
+   bench_destroy(&b);
+   b.screen->destroy(b.screen);
+   pipe_loader_release(devs, num_devs);
+   FREE(devs);
+   return 0;
+}
@@ -0,0 +1,710 @@
+/**************************************************************************
+ *
+ * Copyright 2018 Advanced Micro Devices, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+#include <expat.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "driver_trace/tr_dump_binary.h"
+#include "util/hash_table.h"
+#include "util/ralloc.h"
+#include "util/u_dynarray.h"
+#include "util/u_math.h"
+
+#include "trace_parse.h"
+
+#define TRACE_PARSE_MAX_DEPTH 32
+
+/*
+ * Tree builder, fed by both parsers.
+ */
+
+struct trace_builder {
+   void *mem_ctx;
+   struct util_dynarray calls;
+
+   bool in_call;
+   struct trace_call call;
+   struct util_dynarray arg_names;
+   struct util_dynarray args;
+   const char *arg_name;
+   bool in_ret;
+
+   struct trace_value *stack[TRACE_PARSE_MAX_DEPTH];
+   unsigned depth;
+   const char *member_name;
+   bool error;
+};
+
+static void
+builder_init(struct trace_builder *b, void *mem_ctx)
+{
+   memset(b, 0, sizeof(*b));
+   b->mem_ctx = mem_ctx;
+   util_dynarray_init(&b->calls, NULL);
+   util_dynarray_init(&b->arg_names, NULL);
+   util_dynarray_init(&b->args, NULL);
+}
+
+static void
+builder_fini(struct trace_builder *b)
+{
+   util_dynarray_fini(&b->calls);
+   util_dynarray_fini(&b->arg_names);
+   util_dynarray_fini(&b->args);
+}
+
+static void
+builder_call_begin(struct trace_builder *b, unsigned no,
+                   const char *klass, const char *method)
+{
+   memset(&b->call, 0, sizeof(b->call));
+   b->call.no = no;
+   b->call.klass = klass;
+   b->call.method = method;
+   b->in_call = true;
+   b->depth = 0;
+   util_dynarray_clear(&b->arg_names);
+   util_dynarray_clear(&b->args);
+}
+
+static void
+builder_call_end(struct trace_builder *b)
+{
+   struct trace_call *call = &b->call;
+
+   if (!b->in_call)
+      return;
+
+   call->num_args = b->args.size / sizeof(struct trace_value *);
+   call->args = ralloc_array(b->mem_ctx, struct trace_value *,
+                             call->num_args);
+   call->arg_names = ralloc_array(b->mem_ctx, const char *, call->num_args);
+   if (call->num_args) {
+      memcpy(call->args, b->args.data, b->args.size);
+      memcpy(call->arg_names, b->arg_names.data, b->arg_names.size);
+   }
+
+   util_dynarray_append(&b->calls, struct trace_call, *call);
+   b->in_call = false;
+}
+
+static void
+builder_arg_begin(struct trace_builder *b, const char *name)
+{
+   b->arg_name = name;
+   b->in_ret = false;
+   b->depth = 0;
+}
+
+static void
+builder_ret_begin(struct trace_builder *b)
+{
+   b->arg_name = NULL;
+   b->in_ret = true;
+   b->depth = 0;
+}
+
+static void
+builder_add(struct trace_builder *b, struct trace_value *value)
+{
+   if (!b->in_call)
+      return;
+
+   if (b->depth) {
+      struct trace_value *parent = b->stack[b->depth - 1];
+      unsigned n = parent->num_elems++;
+
+      parent->elems = reralloc(b->mem_ctx, parent->elems,
+                               struct trace_value *, n + 1);
+      parent->elems[n] = value;
+
+      if (parent->type == TRACE_VALUE_STRUCT) {
+         parent->member_names = reralloc(b->mem_ctx, parent->member_names,
+                                         const char *, n + 1);
+         parent->member_names[n] = b->member_name ? b->member_name : "";
+         b->member_name = NULL;
+      }
+   } else if (b->in_ret) {
+      b->call.ret = value;
+   } else if (b->arg_name) {
+      util_dynarray_append(&b->args, struct trace_value *, value);
+      util_dynarray_append(&b->arg_names, const char *, b->arg_name);
+      b->arg_name = NULL;
+   }
+}
+
+static struct trace_value *
+builder_value(struct trace_builder *b, enum trace_value_type type)
+{
+   struct trace_value *value = rzalloc(b->mem_ctx, struct trace_value);
+
+   value->type = type;
+   builder_add(b, value);
+   return value;
+}
+
+static void
+builder_push(struct trace_builder *b, enum trace_value_type type,
+             const char *name)
+{
+   struct trace_value *value = builder_value(b, type);
+
+   value->u.str = name;
+   if (b->depth == TRACE_PARSE_MAX_DEPTH) {
+      b->error = true;
+      return;
+   }
+   b->stack[b->depth++] = value;
+}
+
+static void
+builder_pop(struct trace_builder *b)
+{
+   if (b->depth)
+      b->depth--;
+}
+
+/*
+ * XML
+ */
+
+struct xml_parser {
+   struct trace_builder *b;
+   char *text;
+   size_t text_size;
+   bool in_text;
+   unsigned time_depth;
+};
+
+static const char *
+xml_attr(const char **attrs, const char *name)
+{
+   for (unsigned i = 0; attrs[i]; i += 2) {
+      if (!strcmp(attrs[i], name))
+         return attrs[i + 1];
+   }
+   return "";
+}
+
+static void XMLCALL
+xml_start(void *data, const char *el, const char **attrs)
+{
+   struct xml_parser *p = data;
+   struct trace_builder *b = p->b;
+
+   if (p->time_depth) {
+      p->time_depth++;
+      return;
+   }
+
+   if (!strcmp(el, "call")) {
+      builder_call_begin(b, atoi(xml_attr(attrs, "no")),
+                         ralloc_strdup(b->mem_ctx, xml_attr(attrs, "class")),
+                         ralloc_strdup(b->mem_ctx, xml_attr(attrs, "method")));
+   } else if (!strcmp(el, "arg")) {
+      builder_arg_begin(b, ralloc_strdup(b->mem_ctx, xml_attr(attrs, "name")));
+   } else if (!strcmp(el, "ret")) {
+      builder_ret_begin(b);
+   } else if (!strcmp(el, "time")) {
+      p->time_depth = 1;
+   } else if (!strcmp(el, "array")) {
+      builder_push(b, TRACE_VALUE_ARRAY, NULL);
+   } else if (!strcmp(el, "struct")) {
+      builder_push(b, TRACE_VALUE_STRUCT,
+                   ralloc_strdup(b->mem_ctx, xml_attr(attrs, "name")));
+   } else if (!strcmp(el, "member")) {
+      b->member_name = ralloc_strdup(b->mem_ctx, xml_attr(attrs, "name"));
+   } else if (!strcmp(el, "null")) {
+      builder_value(b, TRACE_VALUE_NULL);
+   } else if (strcmp(el, "elem") && strcmp(el, "trace")) {
+      /* A scalar; its text is handled in xml_end. */
+      p->text_size = 0;
+      p->in_text = true;
+   }
+}
+
+static uint8_t
+xml_hex_digit(char c)
+{
+   return c <= '9' ? c - '0' : (c | 0x20) - 'a' + 10;
+}
+
+static void XMLCALL
+xml_end(void *data, const char *el)
+{
+   struct xml_parser *p = data;
+   struct trace_builder *b = p->b;
+   struct trace_value *value;
+   const char *text;
+
+   if (p->time_depth) {
+      p->time_depth--;
+      p->in_text = false;
+      return;
+   }
+
+   if (!strcmp(el, "call")) {
+      builder_call_end(b);
+      return;
+   }
+   if (!strcmp(el, "array") || !strcmp(el, "struct")) {
+      builder_pop(b);
+      return;
+   }
+   if (!p->in_text)
+      return;
+
+   p->in_text = false;
+   text = p->text_size ? p->text : "";
+   if (p->text)
+      p->text[p->text_size] = 0;
+
+   if (!strcmp(el, "bool")) {
+      value = builder_value(b, TRACE_VALUE_BOOL);
+      value->u.b = atoi(text) != 0;
+   } else if (!strcmp(el, "int")) {
+      value = builder_value(b, TRACE_VALUE_INT);
+      value->u.i = strtoll(text, NULL, 10);
+   } else if (!strcmp(el, "uint")) {
+      value = builder_value(b, TRACE_VALUE_UINT);
+      value->u.u = strtoull(text, NULL, 10);
+   } else if (!strcmp(el, "float")) {
+      value = builder_value(b, TRACE_VALUE_FLOAT);
+      value->u.f = strtod(text, NULL);
+   } else if (!strcmp(el, "ptr")) {
+      value = builder_value(b, TRACE_VALUE_PTR);
+      value->u.ptr = strtoull(text, NULL, 16);
+   } else if (!strcmp(el, "string") || !strcmp(el, "enum")) {
+      value = builder_value(b, el[0] == 's' ? TRACE_VALUE_STRING :
+                                              TRACE_VALUE_ENUM);
+      value->u.str = ralloc_strdup(b->mem_ctx, text);
+   } else if (!strcmp(el, "bytes")) {
+      size_t size = p->text_size / 2;
+      uint8_t *bytes = ralloc_size(b->mem_ctx, MAX2(size, 1));
+
+      for (size_t i = 0; i < size; i++) {
+         bytes[i] = xml_hex_digit(text[i * 2]) << 4 |
+                    xml_hex_digit(text[i * 2 + 1]);
+      }
+      value = builder_value(b, TRACE_VALUE_BYTES);
+      value->u.bytes.data = bytes;
+      value->u.bytes.size = size;
+   }
+}
+
+static void XMLCALL
+xml_text(void *data, const char *s, int len)
+{
+   struct xml_parser *p = data;
+
+   if (!p->in_text)
+      return;
+
+   p->text = realloc(p->text, p->text_size + len + 1);
+   memcpy(p->text + p->text_size, s, len);
+   p->text_size += len;
+}
+
+static bool
+trace_parse_xml(struct trace_builder *b, FILE *f)
+{
+   struct xml_parser p = {b};
+   XML_Parser parser = XML_ParserCreate(NULL);
+   char buf[64 * 1024];
+   bool ok = true;
+   size_t len;
+
+   if (!parser)
+      return false;
+
+   XML_SetUserData(parser, &p);
+   XML_SetElementHandler(parser, xml_start, xml_end);
+   XML_SetCharacterDataHandler(parser, xml_text);
+
+   do {
+      len = fread(buf, 1, sizeof(buf), f);
+      if (XML_Parse(parser, buf, len, len == 0) == XML_STATUS_ERROR) {
+         /* Traces of applications that didn't exit cleanly are truncated.
+          * Keep the calls before the error.
+          */
+         fprintf(stderr, "trace_replay: XML error at line %lu: %s\n",
+                 (unsigned long)XML_GetCurrentLineNumber(parser),
+                 XML_ErrorString(XML_GetErrorCode(parser)));
+         ok = b->calls.size != 0;
+         break;
+      }
+   } while (len);
+
+   XML_ParserFree(parser);
+   free(p.text);
+   return ok;
+}
+
+/*
+ * Binary
+ */
+
+struct bin_reader {
+   const uint8_t *p, *end;
+   bool eof;
+};
+
+static const void *
+bin_read(struct bin_reader *r, size_t size)
+{
+   const uint8_t *p = r->p;
+
+   if ((size_t)(r->end - r->p) < size) {
+      r->eof = true;
+      r->p = r->end;
+      return NULL;
+   }
+   r->p += size;
+   return p;
+}
+
+static uint32_t
+bin_u32(struct bin_reader *r)
+{
+   const void *p = bin_read(r, 4);
+   uint32_t v = 0;
+
+   if (p)
+      memcpy(&v, p, 4);
+   return util_le32_to_cpu(v);
+}
+
+static uint64_t
+bin_u64(struct bin_reader *r)
+{
+   const void *p = bin_read(r, 8);
+   uint64_t v = 0;
+
+   if (p)
+      memcpy(&v, p, 8);
+   return util_le64_to_cpu(v);
+}
+
+static uint32_t
+sha1_hash(const void *key)
+{
+   uint32_t hash;
+
+   memcpy(&hash, key, sizeof(hash));
+   return hash;
+}
+
+static bool
+sha1_equal(const void *a, const void *b)
+{
+   return memcmp(a, b, 20) == 0;
+}
+
+static const char *
+bin_str(const char **strings, unsigned num_strings, uint32_t id)
+{
+   return id < num_strings && strings[id] ? strings[id] : "";
+}
+
+static bool
+trace_parse_binary(struct trace_builder *b, const uint8_t *data, size_t size)
+{
+   struct bin_reader r = {data, data + size};
+   struct hash_table *blobs;
+   const char **strings = NULL;
+   unsigned num_strings = 0;
+
+   bin_read(&r, 8); /* magic */
+   if (bin_u32(&r) != TRACE_BINARY_VERSION) {
+      fprintf(stderr, "trace_replay: unsupported binary trace version\n");
+      return false;
+   }
+
+   blobs = _mesa_hash_table_create(b->mem_ctx, sha1_hash, sha1_equal);
+
+#define STR(id) bin_str(strings, num_strings, id)
+
+   while (!r.eof && r.p != r.end) {
+      enum trace_binary_token token = *r.p++;
+      struct trace_value *value;
+
+      switch (token) {
+      case TRACE_BIN_STRDEF: {
+         uint32_t id = bin_u32(&r);
+         uint32_t len = bin_u32(&r);
+         const char *str = bin_read(&r, len);
+
+         if (!str)
+            break;
+         if (id >= num_strings) {
+            strings = reralloc(b->mem_ctx, strings, const char *, id + 1);
+            memset(strings + num_strings, 0,
+                   (id + 1 - num_strings) * sizeof(*strings));
+            num_strings = id + 1;
+         }
+         strings[id] = ralloc_strndup(b->mem_ctx, str, len);
+         break;
+      }
+      case TRACE_BIN_CALL_BEGIN: {
+         uint32_t no = bin_u32(&r);
+         uint32_t klass = bin_u32(&r);
+         uint32_t method = bin_u32(&r);
+
+         builder_call_begin(b, no, STR(klass), STR(method));
+         break;
+      }
+      case TRACE_BIN_CALL_END:
+         bin_u64(&r);
+         builder_call_end(b);
+         break;
+      case TRACE_BIN_ARG_BEGIN:
+         builder_arg_begin(b, STR(bin_u32(&r)));
+         break;
+      case TRACE_BIN_RET_BEGIN:
+         builder_ret_begin(b);
+         break;
+      case TRACE_BIN_ARG_END:
+      case TRACE_BIN_RET_END:
+      case TRACE_BIN_ELEM_BEGIN:
+      case TRACE_BIN_ELEM_END:
+      case TRACE_BIN_MEMBER_END:
+         break;
+      case TRACE_BIN_BOOL: {
+         const uint8_t *v = bin_read(&r, 1);
+
+         value = builder_value(b, TRACE_VALUE_BOOL);
+         value->u.b = v && *v;
+         break;
+      }
+      case TRACE_BIN_INT:
+         value = builder_value(b, TRACE_VALUE_INT);
+         value->u.i = bin_u64(&r);
+         break;
+      case TRACE_BIN_UINT:
+         value = builder_value(b, TRACE_VALUE_UINT);
+         value->u.u = bin_u64(&r);
+         break;
+      case TRACE_BIN_FLOAT: {
+         uint64_t bits = bin_u64(&r);
+
+         value = builder_value(b, TRACE_VALUE_FLOAT);
+         memcpy(&value->u.f, &bits, sizeof(bits));
+         break;
+      }
+      case TRACE_BIN_BYTES: {
+         uint32_t len = bin_u32(&r);
+
+         value = builder_value(b, TRACE_VALUE_BYTES);
+         value->u.bytes.data = bin_read(&r, len);
+         value->u.bytes.size = value->u.bytes.data ? len : 0;
+         break;
+      }
+      case TRACE_BIN_BLOBDEF: {
+         const void *sha1 = bin_read(&r, 20);
+         uint32_t len = bin_u32(&r);
+         const void *blob = bin_read(&r, len);
+
+         if (sha1 && blob) {
+            /* The blob data is preceded by its size. */
+            _mesa_hash_table_insert(blobs, sha1, (void*)((uint8_t*)blob - 4));
+         }
+         break;
+      }
+      case TRACE_BIN_BYTES_REF: {
+         const void *sha1 = bin_read(&r, 20);
+         struct hash_entry *entry = sha1 ?
+            _mesa_hash_table_search(blobs, sha1) : NULL;
+
+         value = builder_value(b, TRACE_VALUE_BYTES);
+         if (entry) {
+            struct bin_reader blob = {entry->data, r.end};
+            uint32_t len = bin_u32(&blob);
+
+            value->u.bytes.data = blob.p;
+            value->u.bytes.size = len;
+         }
+         break;
+      }
+      case TRACE_BIN_STRING: {
+         uint32_t len = bin_u32(&r);
+         const char *str = bin_read(&r, len);
+
+         value = builder_value(b, TRACE_VALUE_STRING);
+         value->u.str = ralloc_strndup(b->mem_ctx, str ? str : "",
+                                       str ? len : 0);
+         break;
+      }
+      case TRACE_BIN_ENUM:
+         value = builder_value(b, TRACE_VALUE_ENUM);
+         value->u.str = STR(bin_u32(&r));
+         break;
+      case TRACE_BIN_ARRAY_BEGIN:
+         builder_push(b, TRACE_VALUE_ARRAY, NULL);
+         break;
+      case TRACE_BIN_STRUCT_BEGIN:
+         builder_push(b, TRACE_VALUE_STRUCT, STR(bin_u32(&r)));
+         break;
+      case TRACE_BIN_ARRAY_END:
+      case TRACE_BIN_STRUCT_END:
+         builder_pop(b);
+         break;
+      case TRACE_BIN_MEMBER_BEGIN:
+         b->member_name = STR(bin_u32(&r));
+         break;
+      case TRACE_BIN_NULL:
+         builder_value(b, TRACE_VALUE_NULL);
+         break;
+      case TRACE_BIN_PTR:
+         value = builder_value(b, TRACE_VALUE_PTR);
+         value->u.ptr = bin_u64(&r);
+         break;
+      default:
+         fprintf(stderr, "trace_replay: unknown token %u\n", token);
+         return b->calls.size != 0;
+      }
+   }
+
+#undef STR
+
+   return true;
+}
+
+/*
+ * Public interface
+ */
+
+struct trace_file *
+trace_file_load(const char *filename)
+{
+   struct trace_file *trace;
+   struct trace_builder b;
+   uint8_t magic[8];
+   bool ok;
+   FILE *f;
+
+   f = fopen(filename, "rb");
+   if (!f) {
+      fprintf(stderr, "trace_replay: can't open %s\n", filename);
+      return NULL;
+   }
+
+   trace = rzalloc(NULL, struct trace_file);
+   trace->mem_ctx = trace;
+   builder_init(&b, trace);
+
+   if (fread(magic, 1, 8, f) == 8 &&
+       !memcmp(magic, TRACE_BINARY_MAGIC, 8)) {
+      long size;
+      uint8_t *data;
+
+      fseek(f, 0, SEEK_END);
+      size = ftell(f);
+      fseek(f, 0, SEEK_SET);
+
+      /* The values point into the file data, so keep it. */
+      data = ralloc_size(trace, MAX2(size, 1));
+      ok = data && fread(data, 1, size, f) == (size_t)size &&
+           trace_parse_binary(&b, data, size);
+   } else {
+      fseek(f, 0, SEEK_SET);
+      ok = trace_parse_xml(&b, f);
+   }
+   fclose(f);
+
+   if (!ok || b.error) {
+      builder_fini(&b);
+      ralloc_free(trace);
+      return NULL;
+   }
+
+   trace->num_calls = b.calls.size / sizeof(struct trace_call);
+   trace->calls = ralloc_array(trace, struct trace_call, trace->num_calls);
+   memcpy(trace->calls, b.calls.data, b.calls.size);
+   builder_fini(&b);
+   return trace;
+}
+
+void
+trace_file_destroy(struct trace_file *trace)
+{
+   ralloc_free(trace);
+}
+
+const struct trace_value *
+trace_call_arg(const struct trace_call *call, const char *name)
+{
+   for (unsigned i = 0; i < call->num_args; i++) {
+      if (!strcmp(call->arg_names[i], name))
+         return call->args[i];
+   }
+   return NULL;
+}
+
+const struct trace_value *
+trace_value_member(const struct trace_value *value, const char *name)
+{
+   if (!value || value->type != TRACE_VALUE_STRUCT)
+      return NULL;
+
+   for (unsigned i = 0; i < value->num_elems; i++) {
+      if (!strcmp(value->member_names[i], name))
+         return value->elems[i];
+   }
+   return NULL;
+}
+
+uint64_t
+trace_value_uint(const struct trace_value *value)
+{
+   if (!value)
+      return 0;
+
+   switch (value->type) {
+   case TRACE_VALUE_BOOL:
+      return value->u.b;
+   case TRACE_VALUE_INT:
+   case TRACE_VALUE_UINT:
+   case TRACE_VALUE_PTR:
+      return value->u.u;
+   case TRACE_VALUE_FLOAT:
+      return value->u.f;
+   default:
+      return 0;
+   }
+}
+
+double
+trace_value_float(const struct trace_value *value)
+{
+   if (value && value->type == TRACE_VALUE_FLOAT)
+      return value->u.f;
+   if (value && value->type == TRACE_VALUE_INT)
+      return value->u.i;
+   return trace_value_uint(value);
+}
@@ -0,0 +1,117 @@
+/**************************************************************************
+ *
+ * Copyright 2018 Advanced Micro Devices, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+/**
+ * @file
+ * In-memory representation of a driver_trace capture.
+ *
+ * Both the XML and the binary (GALLIUM_TRACE_BINARY) formats are loaded
+ * into the same tree of values, which mirrors the trace_dump_* calls that
+ * produced it.
+ */
+
+#ifndef TRACE_PARSE_H
+#define TRACE_PARSE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+enum trace_value_type {
+   TRACE_VALUE_NULL,
+   TRACE_VALUE_BOOL,
+   TRACE_VALUE_INT,
+   TRACE_VALUE_UINT,
+   TRACE_VALUE_FLOAT,
+   TRACE_VALUE_BYTES,
+   TRACE_VALUE_STRING,
+   TRACE_VALUE_ENUM,
+   TRACE_VALUE_ARRAY,
+   TRACE_VALUE_STRUCT,
+   TRACE_VALUE_PTR,
+};
+
+struct trace_value {
+   enum trace_value_type type;
+
+   union {
+      bool b;
+      int64_t i;
+      uint64_t u;
+      double f;
+      uint64_t ptr;
+      const char *str; /* STRING, ENUM; struct name for STRUCT */
+      struct {
+         const void *data;
+         size_t size;
+      } bytes;
+   } u;
+
+   /* ARRAY and STRUCT */
+   unsigned num_elems;
+   struct trace_value **elems;
+   const char **member_names; /* STRUCT only */
+};
+
+struct trace_call {
+   unsigned no;
+   const char *klass;
+   const char *method;
+
+   unsigned num_args;
+   const char **arg_names;
+   struct trace_value **args;
+   struct trace_value *ret; /* NULL if the call returns nothing */
+};
+
+struct trace_file {
+   void *mem_ctx;
+   unsigned num_calls;
+   struct trace_call *calls;
+};
+
+struct trace_file *
+trace_file_load(const char *filename);
+
+void
+trace_file_destroy(struct trace_file *trace);
+
+/* These return NULL if there's no such argument or member. */
+const struct trace_value *
+trace_call_arg(const struct trace_call *call, const char *name);
+
+const struct trace_value *
+trace_value_member(const struct trace_value *value, const char *name);
+
+/* Scalar conversions that accept any numeric type. NULL yields 0. */
+uint64_t
+trace_value_uint(const struct trace_value *value);
+
+double
+trace_value_float(const struct trace_value *value);
+
+#endif /* TRACE_PARSE_H */
@@ -0,0 +1,2076 @@
+/**************************************************************************
+ *
+ * Copyright 2018 Advanced Micro Devices, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+/*
+ * Replays a driver_trace capture (GALLIUM_TRACE) against a pipe_screen
+ * obtained from the pipe-loader, as a benchmark of driver CPU overhead.
+ *
+ *    trace_replay [-l loops] [-d device] trace
+ *
+ * The whole trace is replayed the given number of times. Only the time
+ * spent inside the driver entrypoints is measured, and it's reported per
+ * call type, together with the calls that couldn't be replayed.
+ *
+ * The trace doesn't contain everything: user vertex buffers and user index
+ * buffers aren't captured, neither are texture uploads nor the resources
+ * of the window system. Draws that need user indices are skipped, user
+ * vertex and constant buffers are replaced by zeros and surfaces of unknown
+ * resources are left unbound. Shaders are recreated from their TGSI text,
+ * so shaders that were passed as NIR can't be replayed.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pipe/p_context.h"
+#include "pipe/p_defines.h"
+#include "pipe/p_screen.h"
+#include "pipe/p_shader_tokens.h"
+#include "pipe/p_state.h"
+#include "pipe-loader/pipe_loader.h"
+#include "tgsi/tgsi_text.h"
+#include "util/hash_table.h"
+#include "util/os_time.h"
+#include "util/u_box.h"
+#include "util/u_dynarray.h"
+#include "util/ralloc.h"
+#include "util/u_dump.h"
+#include "util/u_format.h"
+#include "util/u_inlines.h"
+#include "util/u_memory.h"
+
+#include "trace_parse.h"
+
+#define REPLAY_MAX_TOKENS (64 * 1024)
+
+enum replay_object_type {
+   REPLAY_CONTEXT,
+   REPLAY_RESOURCE,
+   REPLAY_SURFACE,
+   REPLAY_SAMPLER_VIEW,
+   REPLAY_SO_TARGET,
+   REPLAY_QUERY,
+   REPLAY_FENCE,
+   REPLAY_BLEND,
+   REPLAY_SAMPLER,
+   REPLAY_RASTERIZER,
+   REPLAY_DSA,
+   REPLAY_VELEMS,
+   REPLAY_VS,
+   REPLAY_TCS,
+   REPLAY_TES,
+   REPLAY_GS,
+   REPLAY_FS,
+   REPLAY_CS,
+};
+
+struct replay_object {
+   enum replay_object_type type;
+   void *obj;
+   struct pipe_context *pipe; /* the context that created it, if any */
+};
+
+struct replay_stat {
+   const char *name;
+   unsigned count;
+   unsigned skipped;
+   int64_t ns;
+};
+
+struct replay {
+   struct pipe_screen *screen;
+   void *mem_ctx;
+
+   /* Trace pointer -> struct replay_object */
+   struct hash_table_u64 *objects;
+   struct util_dynarray object_keys; /* uint64_t, may contain stale keys */
+
+   struct hash_table *formats;     /* name -> format + 1 */
+   struct hash_table *query_types; /* name -> type + 1 */
+   struct hash_table *stats;       /* method -> struct replay_stat */
+
+   struct tgsi_token *tokens;
+   void *zeros;
+   size_t zeros_size;
+
+   int64_t call_ns;
+};
+
+typedef bool (*replay_func)(struct replay *r, const struct trace_call *call);
+
+/* Time a driver entrypoint. */
+#define TIMED(r, expr) do { \
+      int64_t _start = os_time_get_nano(); \
+      expr; \
+      (r)->call_ns += os_time_get_nano() - _start; \
+   } while (0)
+
+#define ARG(name) trace_call_arg(call, name)
+#define ARG_UINT(name) trace_value_uint(ARG(name))
+#define ARG_FLOAT(name) trace_value_float(ARG(name))
+#define MEMBER(v, name) trace_value_member(v, name)
+#define MEMBER_UINT(v, name) trace_value_uint(MEMBER(v, name))
+#define MEMBER_FLOAT(v, name) trace_value_float(MEMBER(v, name))
+
+/*
+ * Objects
+ */
+
+static uint64_t
+replay_ptr(const struct trace_value *v)
+{
+   return v && v->type == TRACE_VALUE_PTR ? v->u.ptr : 0;
+}
+
+static struct replay_object *
+replay_find(struct replay *r, const struct trace_value *v)
+{
+   uint64_t key = replay_ptr(v);
+
+   return key ? _mesa_hash_table_u64_search(r->objects, key) : NULL;
+}
+
+static void *
+replay_lookup(struct replay *r, const struct trace_value *v,
+              enum replay_object_type type)
+{
+   struct replay_object *o = replay_find(r, v);
+
+   return o && o->type == type ? o->obj : NULL;
+}
+
+static void
+replay_release(struct replay *r, struct replay_object *o)
+{
+   struct pipe_context *pipe = o->pipe;
+
+   switch (o->type) {
+   case REPLAY_CONTEXT:
+      TIMED(r, ((struct pipe_context*)o->obj)->destroy(o->obj));
+      break;
+   case REPLAY_RESOURCE: {
+      struct pipe_resource *res = o->obj;
+      pipe_resource_reference(&res, NULL);
+      break;
+   }
+   case REPLAY_SURFACE: {
+      struct pipe_surface *surf = o->obj;
+      pipe_surface_reference(&surf, NULL);
+      break;
+   }
+   case REPLAY_SAMPLER_VIEW: {
+      struct pipe_sampler_view *view = o->obj;
+      pipe_sampler_view_reference(&view, NULL);
+      break;
+   }
+   case REPLAY_SO_TARGET: {
+      struct pipe_stream_output_target *target = o->obj;
+      pipe_so_target_reference(&target, NULL);
+      break;
+   }
+   case REPLAY_QUERY:
+      pipe->destroy_query(pipe, o->obj);
+      break;
+   case REPLAY_FENCE: {
+      struct pipe_fence_handle *fence = o->obj;
+      r->screen->fence_reference(r->screen, &fence, NULL);
+      break;
+   }
+   case REPLAY_BLEND:
+      pipe->delete_blend_state(pipe, o->obj);
+      break;
+   case REPLAY_SAMPLER:
+      pipe->delete_sampler_state(pipe, o->obj);
+      break;
+   case REPLAY_RASTERIZER:
+      pipe->delete_rasterizer_state(pipe, o->obj);
+      break;
+   case REPLAY_DSA:
+      pipe->delete_depth_stencil_alpha_state(pipe, o->obj);
+      break;
+   case REPLAY_VELEMS:
+      pipe->delete_vertex_elements_state(pipe, o->obj);
+      break;
+   case REPLAY_VS:
+      pipe->delete_vs_state(pipe, o->obj);
+      break;
+   case REPLAY_TCS:
+      pipe->delete_tcs_state(pipe, o->obj);
+      break;
+   case REPLAY_TES:
+      pipe->delete_tes_state(pipe, o->obj);
+      break;
+   case REPLAY_GS:
+      pipe->delete_gs_state(pipe, o->obj);
+      break;
+   case REPLAY_FS:
+      pipe->delete_fs_state(pipe, o->obj);
+      break;
+   case REPLAY_CS:
+      pipe->delete_compute_state(pipe, o->obj);
+      break;
+   }
+}
+
+static void
+replay_remove(struct replay *r, const struct trace_value *v)
+{
+   uint64_t key = replay_ptr(v);
+   struct replay_object *o = key ?
+      _mesa_hash_table_u64_search(r->objects, key) : NULL;
+
+   if (o) {
+      _mesa_hash_table_u64_remove(r->objects, key);
+      FREE(o);
+   }
+}
+
+static void
+replay_add(struct replay *r, const struct trace_value *v,
+           enum replay_object_type type, void *obj, struct pipe_context *pipe)
+{
+   uint64_t key = replay_ptr(v);
+   struct replay_object *o;
+
+   if (!obj)
+      return;
+
+   if (!key) {
+      /* The trace has no handle for it, so it can never be used again. */
+      struct replay_object tmp = {type, obj, pipe};
+      replay_release(r, &tmp);
+      return;
+   }
+
+   /* The driver may reuse addresses of objects the application no longer
+    * uses without the trace telling us, e.g. for resources and fences.
+    */
+   o = _mesa_hash_table_u64_search(r->objects, key);
+   if (o) {
+      replay_release(r, o);
+   } else {
+      o = CALLOC_STRUCT(replay_object);
+      _mesa_hash_table_u64_insert(r->objects, key, o);
+      util_dynarray_append(&r->object_keys, uint64_t, key);
+   }
+   o->type = type;
+   o->obj = obj;
+   o->pipe = pipe;
+}
+
+/* Release everything in reverse order of dependencies. */
+static void
+replay_release_all(struct replay *r)
+{
+   static const enum replay_object_type order[] = {
+      REPLAY_QUERY, REPLAY_FENCE, REPLAY_BLEND, REPLAY_SAMPLER,
+      REPLAY_RASTERIZER, REPLAY_DSA, REPLAY_VELEMS, REPLAY_VS, REPLAY_TCS,
+      REPLAY_TES, REPLAY_GS, REPLAY_FS, REPLAY_CS, REPLAY_SO_TARGET,
+      REPLAY_SAMPLER_VIEW, REPLAY_SURFACE, REPLAY_CONTEXT, REPLAY_RESOURCE,
+   };
+   int64_t call_ns = r->call_ns;
+
+   for (unsigned i = 0; i < ARRAY_SIZE(order); i++) {
+      util_dynarray_foreach(&r->object_keys, uint64_t, key) {
+         struct replay_object *o =
+            _mesa_hash_table_u64_search(r->objects, *key);
+
+         if (!o || o->type != order[i])
+            continue;
+
+         if (o->type == REPLAY_CONTEXT) {
+            struct pipe_context *pipe = o->obj;
+            struct pipe_framebuffer_state fb = {0};
+
+            /* Unbind everything before the states are deleted. */
+            pipe->bind_blend_state(pipe, NULL);
+            pipe->bind_rasterizer_state(pipe, NULL);
+            pipe->bind_depth_stencil_alpha_state(pipe, NULL);
+            pipe->bind_vertex_elements_state(pipe, NULL);
+            pipe->bind_vs_state(pipe, NULL);
+            pipe->bind_fs_state(pipe, NULL);
+            if (pipe->bind_gs_state)
+               pipe->bind_gs_state(pipe, NULL);
+            if (pipe->bind_tcs_state)
+               pipe->bind_tcs_state(pipe, NULL);
+            if (pipe->bind_tes_state)
+               pipe->bind_tes_state(pipe, NULL);
+            pipe->set_framebuffer_state(pipe, &fb);
+         }
+      }
+   }
+
+   for (unsigned i = 0; i < ARRAY_SIZE(order); i++) {
+      util_dynarray_foreach(&r->object_keys, uint64_t, key) {
+         struct replay_object *o =
+            _mesa_hash_table_u64_search(r->objects, *key);
+
+         if (!o || o->type != order[i])
+            continue;
+
+         replay_release(r, o);
+         _mesa_hash_table_u64_remove(r->objects, *key);
+         FREE(o);
+      }
+   }
+   util_dynarray_clear(&r->object_keys);
+
+   /* Teardown isn't part of the replayed calls. */
+   r->call_ns = call_ns;
+}
+
+static struct pipe_context *
+replay_context(struct replay *r, const struct trace_call *call)
+{
+   const struct trace_value *v = ARG("pipe");
+
+   if (!v)
+      v = ARG("context");
+   return replay_lookup(r, v, REPLAY_CONTEXT);
+}
+
+/*
+ * Value decoding
+ */
+
+static enum pipe_format
+replay_format(struct replay *r, const struct trace_value *v)
+{
+   struct hash_entry *entry;
+
+   if (!v || v->type != TRACE_VALUE_ENUM)
+      return trace_value_uint(v);
+
+   entry = _mesa_hash_table_search(r->formats, v->u.str);
+   return entry ? (uintptr_t)entry->data - 1 : PIPE_FORMAT_NONE;
+}
+
+static const void *
+replay_zeros(struct replay *r, size_t size)
+{
+   if (size > r->zeros_size) {
+      free(r->zeros);
+      r->zeros = calloc(1, size);
+      r->zeros_size = r->zeros ? size : 0;
+   }
+   return r->zeros;
+}
+
+static void
+decode_float_array(const struct trace_value *v, float *dst, unsigned n)
+{
+   for (unsigned i = 0; i < n; i++)
+      dst[i] = v && i < v->num_elems ? trace_value_float(v->elems[i]) : 0;
+}
+
+static void
+decode_box(const struct trace_value *v, struct pipe_box *box)
+{
+   u_box_3d(MEMBER_UINT(v, "x"), MEMBER_UINT(v, "y"), MEMBER_UINT(v, "z"),
+            MEMBER_UINT(v, "width"), MEMBER_UINT(v, "height"),
+            MEMBER_UINT(v, "depth"), box);
+}
+
+static void
+decode_scissor(const struct trace_value *v, struct pipe_scissor_state *s)
+{
+   s->minx = MEMBER_UINT(v, "minx");
+   s->miny = MEMBER_UINT(v, "miny");
+   s->maxx = MEMBER_UINT(v, "maxx");
+   s->maxy = MEMBER_UINT(v, "maxy");
+}
+
+static bool
+decode_shader(struct replay *r, const struct trace_value *tokens,
+              const struct trace_value *so, struct pipe_shader_state *state)
+{
+   const struct trace_value *outputs;
+
+   memset(state, 0, sizeof(*state));
+
+   if (!tokens || tokens->type != TRACE_VALUE_STRING ||
+       !tgsi_text_translate(tokens->u.str, r->tokens, REPLAY_MAX_TOKENS))
+      return false;
+
+   state->type = PIPE_SHADER_IR_TGSI;
+   state->tokens = r->tokens;
+
+   if (!so)
+      return true;
+
+   state->stream_output.num_outputs = MEMBER_UINT(so, "num_outputs");
+   for (unsigned i = 0; i < PIPE_MAX_SO_BUFFERS; i++) {
+      const struct trace_value *stride = MEMBER(so, "stride");
+
+      if (stride && i < stride->num_elems)
+         state->stream_output.stride[i] = trace_value_uint(stride->elems[i]);
+   }
+
+   outputs = MEMBER(so, "output");
+   for (unsigned i = 0; outputs && i < outputs->num_elems &&
+                        i < PIPE_MAX_SO_OUTPUTS; i++) {
+      const struct trace_value *o = outputs->elems[i];
+
+      state->stream_output.output[i].register_index =
+         MEMBER_UINT(o, "register_index");
+      state->stream_output.output[i].start_component =
+         MEMBER_UINT(o, "start_component");
+      state->stream_output.output[i].num_components =
+         MEMBER_UINT(o, "num_components");
+      state->stream_output.output[i].output_buffer =
+         MEMBER_UINT(o, "output_buffer");
+      state->stream_output.output[i].dst_offset =
+         MEMBER_UINT(o, "dst_offset");
+      state->stream_output.output[i].stream = MEMBER_UINT(o, "stream");
+   }
+   return true;
+}
+
+/*
+ * pipe_screen
+ */
+
+static bool
+replay_context_create(struct replay *r, const struct trace_call *call)
+{
+   struct pipe_context *pipe;
+
+   TIMED(r, pipe = r->screen->context_create(r->screen, NULL,
+                                             ARG_UINT("flags")));
+   replay_add(r, call->ret, REPLAY_CONTEXT, pipe, NULL);
+   return pipe != NULL;
+}
+
+static bool
+replay_resource_create(struct replay *r, const struct trace_call *call)
+{
+   const struct trace_value *v = ARG("templat");
+   struct pipe_resource templ = {0}, *res;
+
+   templ.target = MEMBER_UINT(v, "target");
+   templ.format = replay_format(r, MEMBER(v, "format"));
+   templ.width0 = MEMBER_UINT(v, "width");
+   templ.height0 = MEMBER_UINT(v, "height");
+   templ.depth0 = MEMBER_UINT(v, "depth");
+   templ.array_size = MEMBER_UINT(v, "array_size");
+   templ.last_level = MEMBER_UINT(v, "last_level");
+   templ.nr_samples = MEMBER_UINT(v, "nr_samples");
+   templ.nr_storage_samples = MEMBER_UINT(v, "nr_storage_samples");
+   templ.usage = MEMBER_UINT(v, "usage");
+   templ.bind = MEMBER_UINT(v, "bind");
+   templ.flags = MEMBER_UINT(v, "flags");
+
+   TIMED(r, res = r->screen->resource_create(r->screen, &templ));
+   replay_add(r, call->ret, REPLAY_RESOURCE, res, NULL);
+   return res != NULL;
+}
+
+static bool
+replay_fence_finish(struct replay *r, const struct trace_call *call)
+{
+   struct pipe_fence_handle *fence = replay_lookup(r, ARG("fence"),
+                                                   REPLAY_FENCE);
+   struct pipe_context *pipe = replay_lookup(r, ARG("ctx"), REPLAY_CONTEXT);
+
+   if (!fence)
+      return false;
+
+   TIMED(r, r->screen->fence_finish(r->screen, pipe, fence,
+                                    ARG_UINT("timeout")));
+   return true;
+}
+
+static bool
+replay_get_param(struct replay *r, const struct trace_call *call)
+{
+   TIMED(r, r->screen->get_param(r->screen, ARG_UINT("param")));
+   return true;
+}
+
+static bool
+replay_get_shader_param(struct replay *r, const struct trace_call *call)
+{
+   TIMED(r, r->screen->get_shader_param(r->screen, ARG_UINT("shader"),
+                                        ARG_UINT("param")));
+   return true;
+}
+
+static bool
+replay_is_format_supported(struct replay *r, const struct trace_call *call)
+{
+   TIMED(r, r->screen->is_format_supported(r->screen,
+                                           replay_format(r, ARG("format")),
+                                           ARG_UINT("target"),
+                                           ARG_UINT("sample_count"),
+                                           ARG_UINT("sample_count"),
+                                           ARG_UINT("tex_usage")));
+   return true;
+}
+
+/* Calls without effects on the state that don't need to be replayed. */
+static bool
+replay_ignore(struct replay *r, const struct trace_call *call)
+{
+   return true;
+}
+
+/*
+ * pipe_context: state objects
+ */
+
+static bool
+replay_create_blend_state(struct replay *r, const struct trace_call *call)
+{
+   struct pipe_context *pipe = replay_context(r, call);
+   const struct trace_value *v = ARG("state");
+   const struct trace_value *rt = MEMBER(v, "rt");
+   struct pipe_blend_state state = {0};
+   void *cso;
+
+   if (!pipe)
+      return false;
+
+   state.dither = MEMBER_UINT(v, "dither");
+   state.logicop_enable = MEMBER_UINT(v, "logicop_enable");
+   state.logicop_func = MEMBER_UINT(v, "logicop_func");
+   state.independent_blend_enable =
+      MEMBER_UINT(v, "independent_blend_enable");
+
+   for (unsigned i = 0; rt && i < rt->num_elems &&
+                        i < PIPE_MAX_COLOR_BUFS; i++) {
+      const struct trace_value *e = rt->elems[i];
+
+      state.rt[i].blend_enable = MEMBER_UINT(e, "blend_enable");
+      state.rt[i].rgb_func = MEMBER_UINT(e, "rgb_func");
+      state.rt[i].rgb_src_factor = MEMBER_UINT(e, "rgb_src_factor");
+      state.rt[i].rgb_dst_factor = MEMBER_UINT(e, "rgb_dst_factor");
+      state.rt[i].alpha_func = MEMBER_UINT(e, "alpha_func");
+      state.rt[i].alpha_src_factor = MEMBER_UINT(e, "alpha_src_factor");
+      state.rt[i].alpha_dst_factor = MEMBER_UINT(e, "alpha_dst_factor");
+      state.rt[i].colormask = MEMBER_UINT(e, "colormask");
+   }
+
+   TIMED(r, cso = pipe->create_blend_state(pipe, &state));
+   replay_add(r, call->ret, REPLAY_BLEND, cso, pipe);
+   return true;
+}
+
+static bool
+replay_create_sampler_state(struct replay *r, const struct trace_call *call)
+{
+   struct pipe_context *pipe = replay_context(r, call);
+   const struct trace_value *v = ARG("state");
+   struct pipe_sampler_state state = {0};
+   void *cso;
+
+   if (!pipe)
+      return false;
+
+   state.wrap_s = MEMBER_UINT(v, "wrap_s");
+   state.wrap_t = MEMBER_UINT(v, "wrap_t");
+   state.wrap_r = MEMBER_UINT(v, "wrap_r");
+   state.min_img_filter = MEMBER_UINT(v, "min_img_filter");
+   state.min_mip_filter = MEMBER_UINT(v, "min_mip_filter");
+   state.mag_img_filter = MEMBER_UINT(v, "mag_img_filter");
+   state.compare_mode = MEMBER_UINT(v, "compare_mode");
+   state.compare_func = MEMBER_UINT(v, "compare_func");
+   state.normalized_coords = MEMBER_UINT(v, "normalized_coords");
+   state.max_anisotropy = MEMBER_UINT(v, "max_anisotropy");
+   state.seamless_cube_map = MEMBER_UINT(v, "seamless_cube_map");
+   state.lod_bias = MEMBER_FLOAT(v, "lod_bias");
+   state.min_lod = MEMBER_FLOAT(v, "min_lod");
+   state.max_lod = MEMBER_FLOAT(v, "max_lod");
+   decode_float_array(MEMBER(v, "border_color.f"), state.border_color.f, 4);
+
+   TIMED(r, cso = pipe->create_sampler_state(pipe, &state));
+   replay_add(r, call->ret, REPLAY_SAMPLER, cso, pipe);
+   return true;
+}
+
+static bool
+replay_create_rasterizer_state(struct replay *r,
+                               const struct trace_call *call)
+{
+   struct pipe_context *pipe = replay_context(r, call);
+   const struct trace_value *v = ARG("state");
+   struct pipe_rasterizer_state state = {0};
+   void *cso;
+
+   if (!pipe)
+      return false;
+
+#define R(field) state.field = MEMBER_UINT(v, #field)
+#define RF(field) state.field = MEMBER_FLOAT(v, #field)
+   R(flatshade);
+   R(light_twoside);
+   R(clamp_vertex_color);
+   R(clamp_fragment_color);
+   R(front_ccw);
+   R(cull_face);
+   R(fill_front);
+   R(fill_back);
+   R(offset_point);
+   R(offset_line);
+   R(offset_tri);
+   R(scissor);
+   R(poly_smooth);
+   R(poly_stipple_enable);
+   R(point_smooth);
+   R(sprite_coord_mode);
+   R(point_quad_rasterization);
+   R(point_size_per_vertex);
+   R(multisample);
+   R(line_smooth);
+   R(line_stipple_enable);
+   R(line_last_pixel);
+   R(flatshade_first);
+   R(half_pixel_center);
+   R(bottom_edge_rule);
+   R(rasterizer_discard);
+   R(depth_clip);
+   R(clip_halfz);
+   R(clip_plane_enable);
+   R(line_stipple_factor);
+   R(line_stipple_pattern);
+   R(sprite_coord_enable);
+   RF(line_width);
+   RF(point_size);
+   RF(offset_units);
+   RF(offset_scale);
+   RF(offset_clamp);
+#undef R
+#undef RF
+
+   TIMED(r, cso = pipe->create_rasterizer_state(pipe, &state));
+   replay_add(r, call->ret, REPLAY_RASTERIZER, cso, pipe);
+   return true;
+}
+
+static bool
+replay_create_depth_stencil_alpha_state(struct replay *r,
+                                        const struct trace_call *call)
+{
+   struct pipe_context *pipe = replay_context(r, call);
+   const struct trace_value *v = ARG("state");
+   const struct trace_value *depth = MEMBER(v, "depth");
+   const struct trace_value *stencil = MEMBER(v, "stencil");
+   const struct trace_value *alpha = MEMBER(v, "alpha");
+   struct pipe_depth_stencil_alpha_state state = {0};
+   void *cso;
+
+   if (!pipe)
+      return false;
+
+   state.depth.enabled = MEMBER_UINT(depth, "enabled");
+   state.depth.writemask = MEMBER_UINT(depth, "writemask");
+   state.depth.func = MEMBER_UINT(depth, "func");
+
+   for (unsigned i = 0; stencil && i < stencil->num_elems && i < 2; i++) {
+      const struct trace_value *s = stencil->elems[i];
+
+      state.stencil[i].enabled = MEMBER_UINT(s, "enabled");
+      state.stencil[i].func = MEMBER_UINT(s, "func");
+      state.stencil[i].fail_op = MEMBER_UINT(s, "fail_op");
+      state.stencil[i].zpass_op = MEMBER_UINT(s, "zpass_op");
+      state.stencil[i].zfail_op = MEMBER_UINT(s, "zfail_op");
+      state.stencil[i].valuemask = MEMBER_UINT(s, "valuemask");
+      state.stencil[i].writemask = MEMBER_UINT(s, "writemask");
+   }
+
+   state.alpha.enabled = MEMBER_UINT(alpha, "enabled");
+   state.alpha.func = MEMBER_UINT(alpha, "func");
+   state.alpha.ref_value = MEMBER_FLOAT(alpha, "ref_value");
+
+   TIMED(r, cso = pipe->create_depth_stencil_alpha_state(pipe, &state));
+   replay_add(r, call->ret, REPLAY_DSA, cso, pipe);
+   return true;
+}
+
+static bool
+replay_create_vertex_elements_state(struct replay *r,
+                                    const struct trace_call *call)
+{
+   struct pipe_context *pipe = replay_context(r, call);
+   const struct trace_value *v = ARG("elements");
+   struct pipe_vertex_element elements[PIPE_MAX_ATTRIBS] = {{0}};
+   unsigned num = MIN2(ARG_UINT("num_elements"), PIPE_MAX_ATTRIBS);
+   void *cso;
+
+   if (!pipe || !v)
+      return false;
+
+   for (unsigned i = 0; i < num && i < v->num_elems; i++) {
+      const struct trace_value *e = v->elems[i];
+
+      elements[i].src_offset = MEMBER_UINT(e, "src_offset");
+      elements[i].vertex_buffer_index =
+         MEMBER_UINT(e, "vertex_buffer_index");
+      elements[i].src_format = replay_format(r, MEMBER(e, "src_format"));
+   }
+
+   TIMED(r, cso = pipe->create_vertex_elements_state(pipe, num, elements));
+   replay_add(r, call->ret, REPLAY_VELEMS, cso, pipe);
+   return true;
+}
+
+static bool
+replay_create_shader(struct replay *r, const struct trace_call *call,
+                     enum replay_object_type type)
+{
+   struct pipe_context *pipe = replay_context(r, call);
+   const struct trace_value *v = ARG("state");
+   struct pipe_shader_state state;
+   void *cso = NULL;
+
+   if (!pipe || !decode_shader(r, MEMBER(v, "tokens"),
+                               MEMBER(v, "stream_output"), &state))
+      return false;
+
+   switch (type) {
+   case REPLAY_VS:
+      TIMED(r, cso = pipe->create_vs_state(pipe, &state));
+      break;
+   case REPLAY_TCS:
+      TIMED(r, cso = pipe->create_tcs_state(pipe, &state));
+      break;
+   case REPLAY_TES:
+      TIMED(r, cso = pipe->create_tes_state(pipe, &state));
+      break;
+   case REPLAY_GS:
+      TIMED(r, cso = pipe->create_gs_state(pipe, &state));
+      break;
+   case REPLAY_FS:
+      TIMED(r, cso = pipe->create_fs_state(pipe, &state));
+      break;
+   default:
+      unreachable("not a shader");
+   }
+   replay_add(r, call->ret, type, cso, pipe);
+   return cso != NULL;
+}
+
+static bool
+replay_create_compute_state(struct replay *r, const struct trace_call *call)
+{
+   struct pipe_context *pipe = replay_context(r, call);
+   const struct trace_value *v = ARG("state");
+   struct pipe_shader_state shader;
+   struct pipe_compute_state state = {0};
+   void *cso;
+
+   if (!pipe || MEMBER_UINT(v, "ir_type") != PIPE_SHADER_IR_TGSI ||
+       !decode_shader(r, MEMBER(v, "prog"), NULL, &shader))
+      return false;
+
+   state.ir_type = PIPE_SHADER_IR_TGSI;
+   state.prog = shader.tokens;
+   state.req_local_mem = MEMBER_UINT(v, "req_local_mem");
+   state.req_private_mem = MEMBER_UINT(v, "req_private_mem");
+   state.req_input_mem = MEMBER_UINT(v, "req_input_mem");
+
+   TIMED(r, cso = pipe->create_compute_state(pipe, &state));
+   replay_add(r, call->ret, REPLAY_CS, cso, pipe);
+   return cso != NULL;
+}
+
+#define REPLAY_CREATE_SHADER(name, type) \
+   static bool \
+   replay_create_##name##_state(struct replay *r, \
+                                const struct trace_call *call) \
+   { \
+      return replay_create_shader(r, call, type); \
+   }
+
+REPLAY_CREATE_SHADER(vs, REPLAY_VS)
+REPLAY_CREATE_SHADER(tcs, REPLAY_TCS)
+REPLAY_CREATE_SHADER(tes, REPLAY_TES)
+REPLAY_CREATE_SHADER(gs, REPLAY_GS)
+REPLAY_CREATE_SHADER(fs, REPLAY_FS)
+
+/* Binding NULL is valid, but binding an object that couldn't be replayed
+ * is not: the driver would draw with the wrong state.
+ */
+#define REPLAY_BIND_DELETE(name, type) \
+   static bool \
+   replay_bind_##name(struct replay *r, const struct trace_call *call) \
+   { \
+      struct pipe_context *pipe = replay_context(r, call); \
+      const struct trace_value *v = ARG("state"); \
+      void *cso = replay_lookup(r, v, type); \
+      \
+      if (!pipe || (replay_ptr(v) && !cso)) \
+         return false; \
+      TIMED(r, pipe->bind_##name(pipe, cso)); \
+      return true; \
+   } \
+   \
+   static bool \
+   replay_delete_##name(struct replay *r, const struct trace_call *call) \
+   { \
+      struct pipe_context *pipe = replay_context(r, call); \
+      const struct trace_value *v = ARG("state"); \
+      void *cso = replay_lookup(r, v, type); \
+      \
+      if (!pipe || !cso) \
+         return false; \
+      TIMED(r, pipe->delete_##name(pipe, cso)); \
+      replay_remove(r, v); \
+      return true; \
+   }
+
+REPLAY_BIND_DELETE(blend_state, REPLAY_BLEND)
+REPLAY_BIND_DELETE(rasterizer_state, REPLAY_RASTERIZER)
+REPLAY_BIND_DELETE(depth_stencil_alpha_state, REPLAY_DSA)
+REPLAY_BIND_DELETE(vertex_elements_state, REPLAY_VELEMS)
+REPLAY_BIND_DELETE(vs_state, REPLAY_VS)
+REPLAY_BIND_DELETE(tcs_state, REPLAY_TCS)
+REPLAY_BIND_DELETE(tes_state, REPLAY_TES)
+REPLAY_BIND_DELETE(gs_state, REPLAY_GS)
+REPLAY_BIND_DELETE(fs_state, REPLAY_FS)
+REPLAY_BIND_DELETE(compute_state, REPLAY_CS)
+
+static bool
+replay_delete_sampler_state(struct replay *r, const struct trace_call *call)
+{
+   struct pipe_context *pipe = replay_context(r, call);
+   const struct trace_value *v = ARG("state");
+   void *cso = replay_lookup(r, v, REPLAY_SAMPLER);
+
+   if (!pipe || !cso)
+      return false;
+
+   TIMED(r, pipe->delete_sampler_state(pipe, cso));
+   replay_remove(r, v);
+   return true;
+}
+
+static bool
+replay_bind_sampler_states(struct replay *r, const struct trace_call *call)
+{
+   struct pipe_context *pipe = replay_context(r, call);
+   const struct trace_value *v = ARG("states");
+   void *states[PIPE_MAX_SAMPLERS] = {0};
+   unsigned num = MIN2(ARG_UINT("num_states"), PIPE_MAX_SAMPLERS);
+
+   if (!pipe)
+      return false;
+
+   for (unsigned i = 0; v && i < num && i < v->num_elems; i++)
+      states[i] = replay_lookup(r, v->elems[i], REPLAY_SAMPLER);
+
+   TIMED(r, pipe->bind_sampler_states(pipe, ARG_UINT("shader"),
+                                      ARG_UINT("start"), num, states));
+   return true;
+}
+
+/*
+ * pipe_context: parameters
+ */
+
+static bool
+replay_set_blend_color(struct replay *r, const struct trace_call *call)
+{
+   struct pipe_context *pipe = replay_context(r, call);
+   struct pipe_blend_color state;
+
+   if (!pipe)
+      return false;
+
+   decode_float_array(MEMBER(ARG("state"), "color"), state.color, 4);
+   TIMED(r, pipe->set_blend_color(pipe, &state));
+   return true;
+}
+
+static bool
+replay_set_stencil_ref(struct replay *r, const struct trace_call *call)
+{
+   struct pipe_context *pipe = replay_context(r, call);
+   const struct trace_value *v = MEMBER(ARG("state"), "ref_value");
+   struct pipe_stencil_ref state = {{0}};
+
+   if (!pipe)
+      return false;
+
+   for (unsigned i = 0; v && i < v->num_elems && i < 2; i++)
+      state.ref_value[i] = trace_value_uint(v->elems[i]);
+
+   TIMED(r, pipe->set_stencil_ref(pipe, &state));
+   return true;
+}
+
+static bool
+replay_set_clip_state(struct replay *r, const struct trace_call *call)
+{
+   struct pipe_context *pipe = replay_context(r, call);
+   const struct trace_value *v = MEMBER(ARG("state"), "ucp");
+   struct pipe_clip_state state = {{{0}}};
+
+   if (!pipe)
+      return false;
+
+   for (unsigned i = 0; v && i < v->num_elems && i < PIPE_MAX_CLIP_PLANES; i++)
+      decode_float_array(v->elems[i], state.ucp[i], 4);
+
+   TIMED(r, pipe->set_clip_state(pipe, &state));
+   return true;
+}
+
+static bool
+replay_set_sample_mask(struct replay *r, const struct trace_call *call)
+{
+   struct pipe_context *pipe = replay_context(r, call);
+
+   if (!pipe)
+      return false;
+
+   TIMED(r, pipe->set_sample_mask(pipe, ARG_UINT("sample_mask")));
+   return true;
+}
+
+static bool
+replay_set_polygon_stipple(struct replay *r, const struct trace_call *call)
+{
+   struct pipe_context *pipe = replay_context(r, call);
+   const struct trace_value *v = MEMBER(ARG("state"), "stipple");
+   struct pipe_poly_stipple state = {{0}};
+
+   if (!pipe)
+      return false;
+
+   for (unsigned i = 0; v && i < v->num_elems && i < 32; i++)
+      state.stipple[i] = trace_value_uint(v->elems[i]);
+
+   TIMED(r, pipe->set_polygon_stipple(pipe, &state));
+   return true;
+}
+
+static bool
+replay_set_tess_state(struct replay *r, const struct trace_call *call)
+{
+   struct pipe_context *pipe = replay_context(r, call);
+   float outer[4], inner[2];
+
+   if (!pipe || !pipe->set_tess_state)
+      return false;
+
+   decode_float_array(ARG("default_outer_level"), outer, 4);
+   decode_float_array(ARG("default_inner_level"), inner, 2);
+   TIMED(r, pipe->set_tess_state(pipe, outer, inner));
+   return true;
+}
+
+/* Only the first state of these is in the trace; use it for all. */
+static bool
+replay_set_scissor_states(struct replay *r, const struct trace_call *call)
+{
+   struct pipe_context *pipe = replay_context(r, call);
+   struct pipe_scissor_state states[PIPE_MAX_VIEWPORTS];
+   unsigned num = MIN2(ARG_UINT("num_scissors"), PIPE_MAX_VIEWPORTS);
+
+   if (!pipe)
+      return false;
+
+   for (unsigned i = 0; i < num; i++)
+      decode_scissor(ARG("states"), &states[i]);
+
+   TIMED(r, pipe->set_scissor_states(pipe, ARG_UINT("start_slot"), num,
+                                     states));
+   return true;
+}
+
+static bool
+replay_set_viewport_states(struct replay *r, const struct trace_call *call)
+{
+   struct pipe_context *pipe = replay_context(r, call);
+   const struct trace_value *v = ARG("states");
+   struct pipe_viewport_state states[PIPE_MAX_VIEWPORTS];
+   unsigned num = MIN2(ARG_UINT("num_viewports"), PIPE_MAX_VIEWPORTS);
+
+   if (!pipe)
+      return false;
+
+   for (unsigned i = 0; i < num; i++) {
+      decode_float_array(MEMBER(v, "scale"), states[i].scale, 3);
+      decode_float_array(MEMBER(v, "translate"), states[i].translate, 3);
+   }
+
+   TIMED(r, pipe->set_viewport_states(pipe, ARG_UINT("start_slot"), num,
+                                      states));
+   return true;
+}
+
+static bool
+replay_set_constant_buffer(struct replay *r, const struct trace_call *call)
+{
+   struct pipe_context *pipe = replay_context(r, call);
+   const struct trace_value *v = ARG("constant_buffer");
+   struct pipe_constant_buffer cb = {0};
+
+   if (!pipe)
+      return false;
+
+   if (v && v->type == TRACE_VALUE_STRUCT) {
+      cb.buffer = replay_lookup(r, MEMBER(v, "buffer"), REPLAY_RESOURCE);
+      cb.buffer_offset = MEMBER_UINT(v, "buffer_offset");
+      cb.buffer_size = MEMBER_UINT(v, "buffer_size");
+
+      /* User constant buffers aren't in the trace. */
+      if (!cb.buffer && cb.buffer_size)
+         cb.user_buffer = replay_zeros(r, cb.buffer_offset + cb.buffer_size);
+   }
+
+   TIMED(r, pipe->set_constant_buffer(pipe, ARG_UINT("shader"),
+                                      ARG_UINT("index"),
+                                      v && v->type == TRACE_VALUE_STRUCT ?
+                                      &cb : NULL));
+   return true;
+}
+
+static bool
+replay_set_framebuffer_state(struct replay *r, const struct trace_call *call)
+{
+   struct pipe_context *pipe = replay_context(r, call);
+   const struct trace_value *v = ARG("state");
+   const struct trace_value *cbufs = MEMBER(v, "cbufs");
+   struct pipe_framebuffer_state fb = {0};
+
+   if (!pipe)
+      return false;
+
+   fb.width = MEMBER_UINT(v, "width");
+   fb.height = MEMBER_UINT(v, "height");
+   fb.samples = MEMBER_UINT(v, "samples");
+   fb.layers = MEMBER_UINT(v, "layers");
+   fb.nr_cbufs = MIN2(MEMBER_UINT(v, "nr_cbufs"), PIPE_MAX_COLOR_BUFS);
+   for (unsigned i = 0; cbufs && i < fb.nr_cbufs && i < cbufs->num_elems; i++)
+      fb.cbufs[i] = replay_lookup(r, cbufs->elems[i], REPLAY_SURFACE);
+   fb.zsbuf = replay_lookup(r, MEMBER(v, "zsbuf"), REPLAY_SURFACE);
+
+   TIMED(r, pipe->set_framebuffer_state(pipe, &fb));
+   return true;
+}
+
+static bool
+replay_set_vertex_buffers(struct replay *r, const struct trace_call *call)
+{
+   struct pipe_context *pipe = replay_context(r, call);
+   const struct trace_value *v = ARG("buffers");
+   struct pipe_vertex_buffer vb[PIPE_MAX_ATTRIBS] = {{0}};
+   unsigned num = MIN2(ARG_UINT("num_buffers"), PIPE_MAX_ATTRIBS);
+
+   if (!pipe)
+      return false;
+
+   for (unsigned i = 0; v && i < num && i < v->num_elems; i++) {
+      const struct trace_value *e = v->elems[i];
+
+      vb[i].stride = MEMBER_UINT(e, "stride");
+      vb[i].buffer_offset = MEMBER_UINT(e, "buffer_offset");
+      /* User vertex buffers aren't in the trace; leave them unbound. */
+      if (!MEMBER_UINT(e, "is_user_buffer")) {
+         vb[i].buffer.resource =
+            replay_lookup(r, MEMBER(e, "buffer.resource"), REPLAY_RESOURCE);
+      }
+   }
+
+   TIMED(r, pipe->set_vertex_buffers(pipe, ARG_UINT("start_slot"), num,
+                                     v && v->type == TRACE_VALUE_ARRAY ?
+                                     vb : NULL));
+   return true;
+}
+
+static bool
+replay_create_sampler_view(struct replay *r, const struct trace_call *call)
+{
+   struct pipe_context *pipe = replay_context(r, call);
+   struct pipe_resource *res = replay_lookup(r, ARG("resource"),
+                                             REPLAY_RESOURCE);
+   const struct trace_value *v = ARG("templ");
+   const struct trace_value *u = MEMBER(v, "u");
+   struct pipe_sampler_view templ = {0}, *view;
+
+   if (!pipe || !res)
+      return false;
+
+   templ.format = replay_format(r, MEMBER(v, "format"));
+   if (res->target == PIPE_BUFFER) {
+      templ.u.buf.offset = MEMBER_UINT(MEMBER(u, "buf"), "offset");
+      templ.u.buf.size = MEMBER_UINT(MEMBER(u, "buf"), "size");
+   } else {
+      const struct trace_value *tex = MEMBER(u, "tex");
+
+      templ.u.tex.first_layer = MEMBER_UINT(tex, "first_layer");
+      templ.u.tex.last_layer = MEMBER_UINT(tex, "last_layer");
+      templ.u.tex.first_level = MEMBER_UINT(tex, "first_level");
+      templ.u.tex.last_level = MEMBER_UINT(tex, "last_level");
+   }
+   templ.target = res->target;
+   templ.swizzle_r = MEMBER_UINT(v, "swizzle_r");
+   templ.swizzle_g = MEMBER_UINT(v, "swizzle_g");
+   templ.swizzle_b = MEMBER_UINT(v, "swizzle_b");
+   templ.swizzle_a = MEMBER_UINT(v, "swizzle_a");
+
+   TIMED(r, view = pipe->create_sampler_view(pipe, res, &templ));
+   replay_add(r, call->ret, REPLAY_SAMPLER_VIEW, view, pipe);
+   return view != NULL;
+}
+
+static bool
+replay_sampler_view_destroy(struct replay *r, const struct trace_call *call)
+{
+   if (!replay_lookup(r, ARG("view"), REPLAY_SAMPLER_VIEW))
+      return false;
+
+   /* The views are reference counted; just drop ours. */
+   replay_release(r, replay_find(r, ARG("view")));
+   replay_remove(r, ARG("view"));
+   return true;
+}
+
+static bool
+replay_set_sampler_views(struct replay *r, const struct trace_call *call)
+{
+   struct pipe_context *pipe = replay_context(r, call);
+   const struct trace_value *v = ARG("views");
+   struct pipe_sampler_view *views[PIPE_MAX_SHADER_SAMPLER_VIEWS] = {0};
+   unsigned num = MIN2(ARG_UINT("num"), PIPE_MAX_SHADER_SAMPLER_VIEWS);
+
+   if (!pipe)
+      return false;
+
+   for (unsigned i = 0; v && i < num && i < v->num_elems; i++)
+      views[i] = replay_lookup(r, v->elems[i], REPLAY_SAMPLER_VIEW);
+
+   TIMED(r, pipe->set_sampler_views(pipe, ARG_UINT("shader"),
+                                    ARG_UINT("start"), num,
+                                    v && v->type == TRACE_VALUE_ARRAY ?
+                                    views : NULL));
+   return true;
+}
+
+static bool
+replay_create_surface(struct replay *r, const struct trace_call *call)
+{
+   struct pipe_context *pipe = replay_context(r, call);
+   struct pipe_resource *res = replay_lookup(r, ARG("resource"),
+                                             REPLAY_RESOURCE);
+   const struct trace_value *v = ARG("surf_tmpl");
+   const struct trace_value *u = MEMBER(v, "u");
+   struct pipe_surface templ = {0}, *surf;
+
+   if (!pipe || !res)
+      return false;
+
+   templ.format = replay_format(r, MEMBER(v, "format"));
+   templ.width = MEMBER_UINT(v, "width");
+   templ.height = MEMBER_UINT(v, "height");
+   if (res->target == PIPE_BUFFER) {
+      const struct trace_value *buf = MEMBER(u, "buf");
+
+      templ.u.buf.first_element = MEMBER_UINT(buf, "first_element");
+      templ.u.buf.last_element = MEMBER_UINT(buf, "last_element");
+   } else {
+      const struct trace_value *tex = MEMBER(u, "tex");
+
+      templ.u.tex.level = MEMBER_UINT(tex, "level");
+      templ.u.tex.first_layer = MEMBER_UINT(tex, "first_layer");
+      templ.u.tex.last_layer = MEMBER_UINT(tex, "last_layer");
+   }
+
+   TIMED(r, surf = pipe->create_surface(pipe, res, &templ));
+   replay_add(r, call->ret, REPLAY_SURFACE, surf, pipe);
+   return surf != NULL;
+}
+
+static bool
+replay_surface_destroy(struct replay *r, const struct trace_call *call)
+{
+   if (!replay_lookup(r, ARG("surface"), REPLAY_SURFACE))
+      return false;
+
+   replay_release(r, replay_find(r, ARG("surface")));
+   replay_remove(r, ARG("surface"));
+   return true;
+}
+
+static bool
+replay_create_stream_output_target(struct replay *r,
+                                   const struct trace_call *call)
+{
+   struct pipe_context *pipe = replay_context(r, call);
+   struct pipe_resource *res = replay_lookup(r, ARG("res"), REPLAY_RESOURCE);
+   struct pipe_stream_output_target *target;
+
+   if (!pipe || !res)
+      return false;
+
+   TIMED(r, target = pipe->create_stream_output_target(
+                        pipe, res, ARG_UINT("buffer_offset"),
+                        ARG_UINT("buffer_size")));
+   replay_add(r, call->ret, REPLAY_SO_TARGET, target, pipe);
+   return target != NULL;
+}
+
+static bool
+replay_stream_output_target_destroy(struct replay *r,
+                                    const struct trace_call *call)
+{
+   if (!replay_lookup(r, ARG("target"), REPLAY_SO_TARGET))
+      return false;
+
+   replay_release(r, replay_find(r, ARG("target")));
+   replay_remove(r, ARG("target"));
+   return true;
+}
+
+static bool
+replay_set_stream_output_targets(struct replay *r,
+                                 const struct trace_call *call)
+{
+   struct pipe_context *pipe = replay_context(r, call);
+   const struct trace_value *tgs = ARG("tgs");
+   const struct trace_value *offsets = ARG("offsets");
+   struct pipe_stream_output_target *targets[PIPE_MAX_SO_BUFFERS] = {0};
+   unsigned offs[PIPE_MAX_SO_BUFFERS] = {0};
+   unsigned num = MIN2(ARG_UINT("num_targets"), PIPE_MAX_SO_BUFFERS);
+
+   if (!pipe)
+      return false;
+
+   for (unsigned i = 0; i < num; i++) {
+      if (tgs && i < tgs->num_elems)
+         targets[i] = replay_lookup(r, tgs->elems[i], REPLAY_SO_TARGET);
+      if (offsets && i < offsets->num_elems)
+         offs[i] = trace_value_uint(offsets->elems[i]);
+   }
+
+   TIMED(r, pipe->set_stream_output_targets(pipe, num, targets, offs));
+   return true;
+}
+
+static bool
+replay_set_shader_buffers(struct replay *r, const struct trace_call *call)
+{
+   struct pipe_context *pipe = replay_context(r, call);
+   const struct trace_value *v = ARG("buffers");
+   struct pipe_shader_buffer buffers[PIPE_MAX_SHADER_BUFFERS] = {{0}};
+   unsigned num;
+
+   /* The number of buffers is only known from the array. */
+   if (!pipe || !v || v->type != TRACE_VALUE_ARRAY)
+      return false;
+
+   num = MIN2(v->num_elems, PIPE_MAX_SHADER_BUFFERS);
+   for (unsigned i = 0; i < num; i++) {
+      const struct trace_value *e = v->elems[i];
+
+      buffers[i].buffer = replay_lookup(r, MEMBER(e, "buffer"),
+                                        REPLAY_RESOURCE);
+      buffers[i].buffer_offset = MEMBER_UINT(e, "buffer_offset");
+      buffers[i].buffer_size = MEMBER_UINT(e, "buffer_size");
+   }
+
+   TIMED(r, pipe->set_shader_buffers(pipe, ARG_UINT("shader"),
+                                     ARG_UINT("start"), num, buffers));
+   return true;
+}
+
+static bool
+replay_set_shader_images(struct replay *r, const struct trace_call *call)
+{
+   struct pipe_context *pipe = replay_context(r, call);
+   const struct trace_value *v = ARG("images");
+   struct pipe_image_view images[PIPE_MAX_SHADER_IMAGES] = {{0}};
+   unsigned num;
+
+   if (!pipe || !v || v->type != TRACE_VALUE_ARRAY)
+      return false;
+
+   num = MIN2(v->num_elems, PIPE_MAX_SHADER_IMAGES);
+   for (unsigned i = 0; i < num; i++) {
+      const struct trace_value *e = v->elems[i];
+      const struct trace_value *u = MEMBER(e, "u");
+      struct pipe_resource *res =
+         replay_lookup(r, MEMBER(e, "resource"), REPLAY_RESOURCE);
+
+      if (!res)
+         continue;
+
+      images[i].resource = res;
+      images[i].format = MEMBER_UINT(e, "format");
+      images[i].access = MEMBER_UINT(e, "access");
+      if (res->target == PIPE_BUFFER) {
+         images[i].u.buf.offset = MEMBER_UINT(MEMBER(u, "buf"), "offset");
+         images[i].u.buf.size = MEMBER_UINT(MEMBER(u, "buf"), "size");
+      } else {
+         const struct trace_value *tex = MEMBER(u, "tex");
+
+         images[i].u.tex.first_layer = MEMBER_UINT(tex, "first_layer");
+         images[i].u.tex.last_layer = MEMBER_UINT(tex, "last_layer");
+         images[i].u.tex.level = MEMBER_UINT(tex, "level");
+      }
+   }
+
+   TIMED(r, pipe->set_shader_images(pipe, ARG_UINT("shader"),
+                                    ARG_UINT("start"), num, images));
+   return true;
+}
+
+/*
+ * pipe_context: queries
+ */
+
+static bool
+replay_create_query(struct replay *r, const struct trace_call *call)
+{
+   struct pipe_context *pipe = replay_context(r, call);
+   const struct trace_value *type = ARG("query_type");
+   struct hash_entry *entry;
+   struct pipe_query *query;
+
+   if (!pipe || !type || type->type != TRACE_VALUE_ENUM)
+      return false;
+
+   entry = _mesa_hash_table_search(r->query_types, type->u.str);
+   if (!entry)
+      return false;
+
+   TIMED(r, query = pipe->create_query(pipe, (uintptr_t)entry->data - 1,
+                                       ARG_UINT("index")));
+   replay_add(r, call->ret, REPLAY_QUERY, query, pipe);
+   return query != NULL;
+}
+
+static bool
+replay_destroy_query(struct replay *r, const struct trace_call *call)
+{
+   struct pipe_context *pipe = replay_context(r, call);
+   struct pipe_query *query = replay_lookup(r, ARG("query"), REPLAY_QUERY);
+
+   if (!pipe || !query)
+      return false;
+
+   TIMED(r, pipe->destroy_query(pipe, query));
+   replay_remove(r, ARG("query"));
+   return true;
+}
+
+static bool
+replay_begin_end_query(struct replay *r, const struct trace_call *call)
+{
+   struct pipe_context *pipe = replay_context(r, call);
+   struct pipe_query *query = replay_lookup(r, ARG("query"), REPLAY_QUERY);
+
+   if (!pipe || !query)
+      return false;
+
+   if (!strcmp(call->method, "begin_query"))
+      TIMED(r, pipe->begin_query(pipe, query));
+   else
+      TIMED(r, pipe->end_query(pipe, query));
+   return true;
+}
+
+static bool
+replay_get_query_result(struct replay *r, const struct trace_call *call)
+{
+   struct pipe_context *pipe = replay_context(r, call);
+   struct pipe_query *query = replay_lookup(r, ARG("query"), REPLAY_QUERY);
+   union pipe_query_result result;
+
+   if (!pipe || !query)
+      return false;
+
+   /* Whether the application waited isn't recorded. Don't wait, so that
+    * the replay doesn't stall on the GPU.
+    */
+   TIMED(r, pipe->get_query_result(pipe, query, false, &result));
+   return true;
+}
+
+static bool
+replay_set_active_query_state(struct replay *r, const struct trace_call *call)
+{
+   struct pipe_context *pipe = replay_context(r, call);
+
+   if (!pipe)
+      return false;
+
+   TIMED(r, pipe->set_active_query_state(pipe, ARG_UINT("enable")));
+   return true;
+}
+
+static bool
+replay_render_condition(struct replay *r, const struct trace_call *call)
+{
+   struct pipe_context *pipe = replay_context(r, call);
+   struct pipe_query *query = replay_lookup(r, ARG("query"), REPLAY_QUERY);
+
+   if (!pipe || (replay_ptr(ARG("query")) && !query))
+      return false;
+
+   TIMED(r, pipe->render_condition(pipe, query, ARG_UINT("condition"),
+                                   ARG_UINT("mode")));
+   return true;
+}
+
+/*
+ * pipe_context: drawing and other commands
+ */
+
+static bool
+replay_draw_vbo(struct replay *r, const struct trace_call *call)
+{
+   struct pipe_context *pipe = replay_context(r, call);
+   const struct trace_value *v = ARG("info");
+   struct pipe_draw_indirect_info indirect = {0};
+   struct pipe_draw_info info = {0};
+
+   if (!pipe)
+      return false;
+
+   info.index_size = MEMBER_UINT(v, "index_size");
+   info.mode = MEMBER_UINT(v, "mode");
+   info.start = MEMBER_UINT(v, "start");
+   info.count = MEMBER_UINT(v, "count");
+   info.start_instance = MEMBER_UINT(v, "start_instance");
+   info.instance_count = MEMBER_UINT(v, "instance_count");
+   info.vertices_per_patch = MEMBER_UINT(v, "vertices_per_patch");
+   info.index_bias = MEMBER_UINT(v, "index_bias");
+   info.min_index = MEMBER_UINT(v, "min_index");
+   info.max_index = MEMBER_UINT(v, "max_index");
+   info.primitive_restart = MEMBER_UINT(v, "primitive_restart");
+   info.restart_index = MEMBER_UINT(v, "restart_index");
+
+   if (info.index_size) {
+      /* User index buffers aren't in the trace. */
+      if (MEMBER_UINT(v, "has_user_indices"))
+         return false;
+
+      info.index.resource = replay_lookup(r, MEMBER(v, "index.resource"),
+                                          REPLAY_RESOURCE);
+      if (!info.index.resource)
+         return false;
+   }
+
+   if (replay_ptr(MEMBER(v, "count_from_stream_output"))) {
+      info.count_from_stream_output =
+         replay_lookup(r, MEMBER(v, "count_from_stream_output"),
+                       REPLAY_SO_TARGET);
+      if (!info.count_from_stream_output)
+         return false;
+   }
+
+   if (MEMBER(v, "indirect->buffer")) {
+      indirect.offset = MEMBER_UINT(v, "indirect->offset");
+      indirect.stride = MEMBER_UINT(v, "indirect->stride");
+      indirect.draw_count = MEMBER_UINT(v, "indirect->draw_count");
+      indirect.indirect_draw_count_offset =
+         MEMBER_UINT(v, "indirect->indirect_draw_count_offset");
+      indirect.buffer = replay_lookup(r, MEMBER(v, "indirect->buffer"),
+                                      REPLAY_RESOURCE);
+      indirect.indirect_draw_count =
+         replay_lookup(r, MEMBER(v, "indirect->indirect_draw_count"),
+                       REPLAY_RESOURCE);
+      if (!indirect.buffer)
+         return false;
+      info.indirect = &indirect;
+   }
+
+   TIMED(r, pipe->draw_vbo(pipe, &info));
+   return true;
+}
+
+static bool
+replay_launch_grid(struct replay *r, const struct trace_call *call)
+{
+   struct pipe_context *pipe = replay_context(r, call);
+   const struct trace_value *v = ARG("info");
+   const struct trace_value *block = MEMBER(v, "block");
+   const struct trace_value *grid = MEMBER(v, "grid");
+   struct pipe_grid_info info = {0};
+
+   /* Kernel inputs aren't in the trace. */
+   if (!pipe || replay_ptr(MEMBER(v, "input")))
+      return false;
+
+   info.pc = MEMBER_UINT(v, "pc");
+   for (unsigned i = 0; i < 3; i++) {
+      info.block[i] = block && i < block->num_elems ?
+                      trace_value_uint(block->elems[i]) : 1;
+      info.grid[i] = grid && i < grid->num_elems ?
+                     trace_value_uint(grid->elems[i]) : 1;
+   }
+
+   if (replay_ptr(MEMBER(v, "indirect"))) {
+      info.indirect = replay_lookup(r, MEMBER(v, "indirect"),
+                                    REPLAY_RESOURCE);
+      info.indirect_offset = MEMBER_UINT(v, "indirect_offset");
+      if (!info.indirect)
+         return false;
+   }
+
+   TIMED(r, pipe->launch_grid(pipe, &info));
+   return true;
+}
+
+static bool
+replay_clear(struct replay *r, const struct trace_call *call)
+{
+   struct pipe_context *pipe = replay_context(r, call);
+   const struct trace_value *color = ARG("color");
+   union pipe_color_union c;
+
+   if (!pipe)
+      return false;
+
+   decode_float_array(color, c.f, 4);
+   TIMED(r, pipe->clear(pipe, ARG_UINT("buffers"),
+                        color && color->type == TRACE_VALUE_ARRAY ? &c : NULL,
+                        ARG_FLOAT("depth"), ARG_UINT("stencil")));
+   return true;
+}
+
+static bool
+replay_clear_render_target(struct replay *r, const struct trace_call *call)
+{
+   struct pipe_context *pipe = replay_context(r, call);
+   struct pipe_surface *dst = replay_lookup(r, ARG("dst"), REPLAY_SURFACE);
+   union pipe_color_union c;
+
+   if (!pipe || !dst)
+      return false;
+
+   decode_float_array(ARG("color->f"), c.f, 4);
+   TIMED(r, pipe->clear_render_target(pipe, dst, &c,
+                                      ARG_UINT("dstx"), ARG_UINT("dsty"),
+                                      ARG_UINT("width"), ARG_UINT("height"),
+                                      ARG_UINT("render_condition_enabled")));
+   return true;
+}
+
+static bool
+replay_clear_depth_stencil(struct replay *r, const struct trace_call *call)
+{
+   struct pipe_context *pipe = replay_context(r, call);
+   struct pipe_surface *dst = replay_lookup(r, ARG("dst"), REPLAY_SURFACE);
+
+   if (!pipe || !dst)
+      return false;
+
+   TIMED(r, pipe->clear_depth_stencil(pipe, dst, ARG_UINT("clear_flags"),
+                                      ARG_FLOAT("depth"), ARG_UINT("stencil"),
+                                      ARG_UINT("dstx"), ARG_UINT("dsty"),
+                                      ARG_UINT("width"), ARG_UINT("height"),
+                                      ARG_UINT("render_condition_enabled")));
+   return true;
+}
+
+static bool
+replay_resource_copy_region(struct replay *r, const struct trace_call *call)
+{
+   struct pipe_context *pipe = replay_context(r, call);
+   struct pipe_resource *dst = replay_lookup(r, ARG("dst"), REPLAY_RESOURCE);
+   struct pipe_resource *src = replay_lookup(r, ARG("src"), REPLAY_RESOURCE);
+   struct pipe_box box;
+
+   if (!pipe || !dst || !src)
+      return false;
+
+   decode_box(ARG("src_box"), &box);
+   TIMED(r, pipe->resource_copy_region(pipe, dst, ARG_UINT("dst_level"),
+                                       ARG_UINT("dstx"), ARG_UINT("dsty"),
+                                       ARG_UINT("dstz"), src,
+                                       ARG_UINT("src_level"), &box));
+   return true;
+}
+
+static bool
+replay_blit(struct replay *r, const struct trace_call *call)
+{
+   struct pipe_context *pipe = replay_context(r, call);
+   const struct trace_value *v = ARG("_info");
+   const struct trace_value *dst = MEMBER(v, "dst");
+   const struct trace_value *src = MEMBER(v, "src");
+   const struct trace_value *mask = MEMBER(v, "mask");
+   struct pipe_blit_info info = {{0}};
+
+   if (!pipe)
+      return false;
+
+   info.dst.resource = replay_lookup(r, MEMBER(dst, "resource"),
+                                     REPLAY_RESOURCE);
+   info.dst.level = MEMBER_UINT(dst, "level");
+   info.dst.format = replay_format(r, MEMBER(dst, "format"));
+   decode_box(MEMBER(dst, "box"), &info.dst.box);
+   info.src.resource = replay_lookup(r, MEMBER(src, "resource"),
+                                     REPLAY_RESOURCE);
+   info.src.level = MEMBER_UINT(src, "level");
+   info.src.format = replay_format(r, MEMBER(src, "format"));
+   decode_box(MEMBER(src, "box"), &info.src.box);
+
+   if (mask && mask->type == TRACE_VALUE_STRING) {
+      static const unsigned bits[] = {
+         PIPE_MASK_R, PIPE_MASK_G, PIPE_MASK_B, PIPE_MASK_A,
+         PIPE_MASK_Z, PIPE_MASK_S,
+      };
+
+      for (unsigned i = 0; mask->u.str[i] && i < ARRAY_SIZE(bits); i++) {
+         if (mask->u.str[i] != '-')
+            info.mask |= bits[i];
+      }
+   }
+   info.filter = MEMBER_UINT(v, "filter");
+   info.scissor_enable = MEMBER_UINT(v, "scissor_enable");
+   decode_scissor(MEMBER(v, "scissor"), &info.scissor);
+
+   if (!info.dst.resource || !info.src.resource)
+      return false;
+
+   TIMED(r, pipe->blit(pipe, &info));
+   return true;
+}
+
+static bool
+replay_flush(struct replay *r, const struct trace_call *call)
+{
+   struct pipe_context *pipe = replay_context(r, call);
+   struct pipe_fence_handle *fence = NULL;
+
+   if (!pipe)
+      return false;
+
+   TIMED(r, pipe->flush(pipe, replay_ptr(call->ret) ? &fence : NULL,
+                        ARG_UINT("flags")));
+   replay_add(r, call->ret, REPLAY_FENCE, fence, pipe);
+   return true;
+}
+
+static bool
+replay_buffer_subdata(struct replay *r, const struct trace_call *call)
+{
+   struct pipe_context *pipe = replay_context(r, call);
+   struct pipe_resource *res = replay_lookup(r, ARG("resource"),
+                                             REPLAY_RESOURCE);
+   const struct trace_value *data = ARG("data");
+   unsigned size = ARG_UINT("size");
+   const void *ptr;
+
+   if (!pipe || !res)
+      return false;
+
+   if (data && data->type == TRACE_VALUE_BYTES &&
+       data->u.bytes.size >= size)
+      ptr = data->u.bytes.data;
+   else
+      ptr = replay_zeros(r, size);
+
+   TIMED(r, pipe->buffer_subdata(pipe, res,
+                                 (ARG_UINT("usage") | PIPE_TRANSFER_WRITE) &
+                                 ~(PIPE_TRANSFER_READ |
+                                   PIPE_TRANSFER_MAP_DIRECTLY |
+                                   PIPE_TRANSFER_PERSISTENT |
+                                   PIPE_TRANSFER_COHERENT |
+                                   PIPE_TRANSFER_FLUSH_EXPLICIT),
+                                 ARG_UINT("offset"), size, ptr));
+   return true;
+}
+
+static bool
+replay_texture_subdata(struct replay *r, const struct trace_call *call)
+{
+   struct pipe_context *pipe = replay_context(r, call);
+   struct pipe_resource *res = replay_lookup(r, ARG("resource"),
+                                             REPLAY_RESOURCE);
+   unsigned stride = ARG_UINT("stride");
+   unsigned layer_stride = ARG_UINT("layer_stride");
+   struct pipe_box box;
+   size_t size;
+
+   if (!pipe || !res)
+      return false;
+
+   decode_box(ARG("box"), &box);
+
+   /* Texture data isn't in the trace; upload zeros of the same size. */
+   size = (size_t)layer_stride * MAX2(box.depth, 1) +
+          (size_t)stride * util_format_get_nblocksy(res->format, box.height);
+
+   TIMED(r, pipe->texture_subdata(pipe, res, ARG_UINT("level"),
+                                  PIPE_TRANSFER_WRITE |
+                                  (ARG_UINT("usage") &
+                                   PIPE_TRANSFER_DISCARD_RANGE),
+                                  &box, replay_zeros(r, size),
+                                  stride, layer_stride));
+   return true;
+}
+
+static bool
+replay_resource_op(struct replay *r, const struct trace_call *call)
+{
+   struct pipe_context *pipe = replay_context(r, call);
+   const struct trace_value *v = ARG("resource");
+   struct pipe_resource *res;
+
+   if (!v)
+      v = ARG("res");
+   res = replay_lookup(r, v, REPLAY_RESOURCE);
+   if (!pipe || !res)
+      return false;
+
+   if (!strcmp(call->method, "flush_resource"))
+      TIMED(r, pipe->flush_resource(pipe, res));
+   else if (!strcmp(call->method, "invalidate_resource"))
+      TIMED(r, pipe->invalidate_resource(pipe, res));
+   else
+      TIMED(r, pipe->generate_mipmap(pipe, res,
+                                     replay_format(r, ARG("format")),
+                                     ARG_UINT("base_level"),
+                                     ARG_UINT("last_level"),
+                                     ARG_UINT("first_layer"),
+                                     ARG_UINT("last_layer")));
+   return true;
+}
+
+static bool
+replay_barrier(struct replay *r, const struct trace_call *call)
+{
+   struct pipe_context *pipe = replay_context(r, call);
+
+   if (!pipe)
+      return false;
+
+   if (!strcmp(call->method, "memory_barrier"))
+      TIMED(r, pipe->memory_barrier(pipe, ARG_UINT("flags")));
+   else
+      TIMED(r, pipe->texture_barrier(pipe, ARG_UINT("flags")));
+   return true;
+}
+
+static bool
+replay_context_destroy(struct replay *r, const struct trace_call *call)
+{
+   struct replay_object *o = replay_find(r, ARG("pipe"));
+   struct pipe_context *pipe;
+
+   if (!o || o->type != REPLAY_CONTEXT)
+      return false;
+
+   /* Forget the objects of the context; the application deleted them or
+    * they went away with the context.
+    */
+   pipe = o->obj;
+   util_dynarray_foreach(&r->object_keys, uint64_t, key) {
+      struct replay_object *obj =
+         _mesa_hash_table_u64_search(r->objects, *key);
+
+      if (obj && obj->pipe == pipe && obj->type >= REPLAY_QUERY) {
+         _mesa_hash_table_u64_remove(r->objects, *key);
+         FREE(obj);
+      }
+   }
+
+   replay_release(r, o);
+   replay_remove(r, ARG("pipe"));
+   return true;
+}
+
+static const struct {
+   const char *klass;
+   const char *method;
+   replay_func func;
+} replay_funcs[] = {
+#define SCREEN(name, func) {"pipe_screen", #name, func}
+#define CONTEXT(name, func) {"pipe_context", #name, func}
+   SCREEN(context_create, replay_context_create),
+   SCREEN(resource_create, replay_resource_create),
+   SCREEN(fence_finish, replay_fence_finish),
+   SCREEN(get_param, replay_get_param),
+   SCREEN(get_shader_param, replay_get_shader_param),
+   SCREEN(is_format_supported, replay_is_format_supported),
+   SCREEN(get_name, replay_ignore),
+   SCREEN(get_vendor, replay_ignore),
+   SCREEN(get_device_vendor, replay_ignore),
+   SCREEN(get_paramf, replay_ignore),
+   SCREEN(get_compute_param, replay_ignore),
+   SCREEN(get_disk_shader_cache, replay_ignore),
+   SCREEN(get_timestamp, replay_ignore),
+   SCREEN(fence_reference, replay_ignore),
+   SCREEN(get_driver_uuid, replay_ignore),
+   SCREEN(get_device_uuid, replay_ignore),
+   CONTEXT(destroy, replay_context_destroy),
+   CONTEXT(draw_vbo, replay_draw_vbo),
+   CONTEXT(launch_grid, replay_launch_grid),
+   CONTEXT(create_query, replay_create_query),
+   CONTEXT(destroy_query, replay_destroy_query),
+   CONTEXT(begin_query, replay_begin_end_query),
+   CONTEXT(end_query, replay_begin_end_query),
+   CONTEXT(get_query_result, replay_get_query_result),
+   CONTEXT(set_active_query_state, replay_set_active_query_state),
+   CONTEXT(render_condition, replay_render_condition),
+   CONTEXT(create_blend_state, replay_create_blend_state),
+   CONTEXT(bind_blend_state, replay_bind_blend_state),
+   CONTEXT(delete_blend_state, replay_delete_blend_state),
+   CONTEXT(create_sampler_state, replay_create_sampler_state),
+   CONTEXT(bind_sampler_states, replay_bind_sampler_states),
+   CONTEXT(delete_sampler_state, replay_delete_sampler_state),
+   CONTEXT(create_rasterizer_state, replay_create_rasterizer_state),
+   CONTEXT(bind_rasterizer_state, replay_bind_rasterizer_state),
+   CONTEXT(delete_rasterizer_state, replay_delete_rasterizer_state),
+   CONTEXT(create_depth_stencil_alpha_state,
+           replay_create_depth_stencil_alpha_state),
+   CONTEXT(bind_depth_stencil_alpha_state,
+           replay_bind_depth_stencil_alpha_state),
+   CONTEXT(delete_depth_stencil_alpha_state,
+           replay_delete_depth_stencil_alpha_state),
+   CONTEXT(create_vertex_elements_state,
+           replay_create_vertex_elements_state),
+   CONTEXT(bind_vertex_elements_state, replay_bind_vertex_elements_state),
+   CONTEXT(delete_vertex_elements_state,
+           replay_delete_vertex_elements_state),
+   CONTEXT(create_vs_state, replay_create_vs_state),
+   CONTEXT(bind_vs_state, replay_bind_vs_state),
+   CONTEXT(delete_vs_state, replay_delete_vs_state),
+   CONTEXT(create_tcs_state, replay_create_tcs_state),
+   CONTEXT(bind_tcs_state, replay_bind_tcs_state),
+   CONTEXT(delete_tcs_state, replay_delete_tcs_state),
+   CONTEXT(create_tes_state, replay_create_tes_state),
+   CONTEXT(bind_tes_state, replay_bind_tes_state),
+   CONTEXT(delete_tes_state, replay_delete_tes_state),
+   CONTEXT(create_gs_state, replay_create_gs_state),
+   CONTEXT(bind_gs_state, replay_bind_gs_state),
+   CONTEXT(delete_gs_state, replay_delete_gs_state),
+   CONTEXT(create_fs_state, replay_create_fs_state),
+   CONTEXT(bind_fs_state, replay_bind_fs_state),
+   CONTEXT(delete_fs_state, replay_delete_fs_state),
+   CONTEXT(create_compute_state, replay_create_compute_state),
+   CONTEXT(bind_compute_state, replay_bind_compute_state),
+   CONTEXT(delete_compute_state, replay_delete_compute_state),
+   CONTEXT(set_blend_color, replay_set_blend_color),
+   CONTEXT(set_stencil_ref, replay_set_stencil_ref),
+   CONTEXT(set_clip_state, replay_set_clip_state),
+   CONTEXT(set_sample_mask, replay_set_sample_mask),
+   CONTEXT(set_polygon_stipple, replay_set_polygon_stipple),
+   CONTEXT(set_tess_state, replay_set_tess_state),
+   CONTEXT(set_scissor_states, replay_set_scissor_states),
+   CONTEXT(set_viewport_states, replay_set_viewport_states),
+   CONTEXT(set_constant_buffer, replay_set_constant_buffer),
+   CONTEXT(set_framebuffer_state, replay_set_framebuffer_state),
+   CONTEXT(set_vertex_buffers, replay_set_vertex_buffers),
+   CONTEXT(create_sampler_view, replay_create_sampler_view),
+   CONTEXT(sampler_view_destroy, replay_sampler_view_destroy),
+   CONTEXT(set_sampler_views, replay_set_sampler_views),
+   CONTEXT(create_surface, replay_create_surface),
+   CONTEXT(surface_destroy, replay_surface_destroy),
+   CONTEXT(create_stream_output_target, replay_create_stream_output_target),
+   CONTEXT(stream_output_target_destroy,
+           replay_stream_output_target_destroy),
+   CONTEXT(set_stream_output_targets, replay_set_stream_output_targets),
+   CONTEXT(set_shader_buffers, replay_set_shader_buffers),
+   CONTEXT(set_shader_images, replay_set_shader_images),
+   CONTEXT(clear, replay_clear),
+   CONTEXT(clear_render_target, replay_clear_render_target),
+   CONTEXT(clear_depth_stencil, replay_clear_depth_stencil),
+   CONTEXT(resource_copy_region, replay_resource_copy_region),
+   CONTEXT(blit, replay_blit),
+   CONTEXT(flush, replay_flush),
+   CONTEXT(buffer_subdata, replay_buffer_subdata),
+   CONTEXT(texture_subdata, replay_texture_subdata),
+   CONTEXT(flush_resource, replay_resource_op),
+   CONTEXT(invalidate_resource, replay_resource_op),
+   CONTEXT(generate_mipmap, replay_resource_op),
+   CONTEXT(memory_barrier, replay_barrier),
+   CONTEXT(texture_barrier, replay_barrier),
+#undef SCREEN
+#undef CONTEXT
+};
+
+static replay_func
+replay_find_func(const struct trace_call *call)
+{
+   for (unsigned i = 0; i < ARRAY_SIZE(replay_funcs); i++) {
+      if (!strcmp(replay_funcs[i].klass, call->klass) &&
+          !strcmp(replay_funcs[i].method, call->method))
+         return replay_funcs[i].func;
+   }
+   return NULL;
+}
+
+static struct replay_stat *
+replay_stat(struct replay *r, const struct trace_call *call)
+{
+   struct hash_entry *entry = _mesa_hash_table_search(r->stats, call->method);
+   struct replay_stat *stat;
+
+   if (entry)
+      return entry->data;
+
+   stat = rzalloc(r->mem_ctx, struct replay_stat);
+   stat->name = call->method;
+   _mesa_hash_table_insert(r->stats, call->method, stat);
+   return stat;
+}
+
+static int
+replay_compare_stats(const void *a, const void *b)
+{
+   const struct replay_stat *sa = *(const struct replay_stat **)a;
+   const struct replay_stat *sb = *(const struct replay_stat **)b;
+
+   return sa->ns < sb->ns ? 1 : sa->ns > sb->ns ? -1 : 0;
+}
+
+static void
+replay_print_stats(struct replay *r, unsigned loops)
+{
+   struct replay_stat **stats;
+   struct hash_entry *entry;
+   unsigned num = 0;
+   int64_t total = 0;
+
+   stats = ralloc_array(r->mem_ctx, struct replay_stat *,
+                        r->stats->entries);
+   hash_table_foreach(r->stats, entry) {
+      stats[num++] = entry->data;
+      total += ((struct replay_stat*)entry->data)->ns;
+   }
+   qsort(stats, num, sizeof(*stats), replay_compare_stats);
+
+   printf("%-40s %10s %10s %12s %10s %6s\n", "call", "count", "skipped",
+          "total ms", "avg us", "%");
+   for (unsigned i = 0; i < num; i++) {
+      struct replay_stat *s = stats[i];
+      unsigned replayed = s->count - s->skipped;
+
+      printf("%-40s %10u %10u %12.3f %10.3f %6.2f\n", s->name,
+             s->count / loops, s->skipped / loops, s->ns / 1e6 / loops,
+             replayed ? s->ns / 1e3 / replayed : 0.0,
+             total ? s->ns * 100.0 / total : 0.0);
+   }
+   printf("%-40s %10s %10s %12.3f\n", "total", "", "", total / 1e6 / loops);
+}
+
+static void
+usage(void)
+{
+   fprintf(stderr, "usage: trace_replay [-l loops] [-d device] trace\n");
+   exit(1);
+}
+
+int
+main(int argc, char **argv)
+{
+   struct pipe_loader_device **devs;
+   struct trace_file *trace;
+   struct replay r = {0};
+   replay_func *funcs;
+   const char *filename = NULL;
+   unsigned loops = 1, device = 0;
+   int num_devs;
+
+   for (int i = 1; i < argc; i++) {
+      if (!strcmp(argv[i], "-l") && i + 1 < argc)
+         loops = MAX2(atoi(argv[++i]), 1);
+      else if (!strcmp(argv[i], "-d") && i + 1 < argc)
+         device = atoi(argv[++i]);
+      else if (argv[i][0] != '-' && !filename)
+         filename = argv[i];
+      else
+         usage();
+   }
+   if (!filename)
+      usage();
+
+   trace = trace_file_load(filename);
+   if (!trace)
+      return 1;
+
+   num_devs = pipe_loader_probe(NULL, 0);
+   devs = CALLOC(MAX2(num_devs, 1), sizeof(*devs));
+   pipe_loader_probe(devs, num_devs);
+   if (device >= (unsigned)num_devs) {
+      fprintf(stderr, "trace_replay: device %u not found\n", device);
+      return 1;
+   }
+
+   r.screen = pipe_loader_create_screen(devs[device]);
+   if (!r.screen) {
+      fprintf(stderr, "trace_replay: can't create the screen\n");
+      return 1;
+   }
+   printf("device: %s\n", r.screen->get_name(r.screen));
+
+   r.mem_ctx = ralloc_context(NULL);
+   r.objects = _mesa_hash_table_u64_create(r.mem_ctx);
+   util_dynarray_init(&r.object_keys, r.mem_ctx);
+   r.stats = _mesa_hash_table_create(r.mem_ctx, _mesa_key_hash_string,
+                                     _mesa_key_string_equal);
+   r.formats = _mesa_hash_table_create(r.mem_ctx, _mesa_key_hash_string,
+                                       _mesa_key_string_equal);
+   r.query_types = _mesa_hash_table_create(r.mem_ctx, _mesa_key_hash_string,
+                                           _mesa_key_string_equal);
+   r.tokens = ralloc_array(r.mem_ctx, struct tgsi_token, REPLAY_MAX_TOKENS);
+
+   for (unsigned i = 0; i < PIPE_FORMAT_COUNT; i++) {
+      _mesa_hash_table_insert(r.formats, util_format_name(i),
+                              (void*)(uintptr_t)(i + 1));
+   }
+   for (unsigned i = 0; i < PIPE_QUERY_TYPES; i++) {
+      _mesa_hash_table_insert(r.query_types, util_str_query_type(i, FALSE),
+                              (void*)(uintptr_t)(i + 1));
+   }
+
+   funcs = ralloc_array(r.mem_ctx, replay_func, trace->num_calls);
+   for (unsigned i = 0; i < trace->num_calls; i++)
+      funcs[i] = replay_find_func(&trace->calls[i]);
+
+   for (unsigned loop = 0; loop < loops; loop++) {
+      for (unsigned i = 0; i < trace->num_calls; i++) {
+         const struct trace_call *call = &trace->calls[i];
+         struct replay_stat *stat = replay_stat(&r, call);
+
+         r.call_ns = 0;
+         stat->count++;
+         if (!funcs[i] || !funcs[i](&r, call))
+            stat->skipped++;
+         stat->ns += r.call_ns;
+      }
+      replay_release_all(&r);
+   }
+
+   printf("%u calls, %u loops\n\n", trace->num_calls, loops);
+   replay_print_stats(&r, loops);
+
+   free(r.zeros);
+   ralloc_free(r.mem_ctx);
+   trace_file_destroy(trace);
+   r.screen->destroy(r.screen);
+   pipe_loader_release(devs, num_devs);
+   FREE(devs);
+   return 0;
+}
@@ -0,0 +1,140 @@
+/**************************************************************************
+ *
+ * Copyright 2018 VMware, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL VMWARE AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+
+/*
+ * Test case and micro-benchmark for the cso_cache lookups done on every
+ * state change: cso_find_state_template(), which walks the cso_hash, and
+ * cso_lookup_state(), which goes through the open-addressing table.
+ */
+
+
+#include <stdio.h>
+
+#include "util/u_memory.h"
+#include "util/os_time.h"
+#include "cso_cache/cso_cache.h"
+
+
+#define NUM_STATES 256
+#define NUM_LOOKUPS (1 << 22)
+
+
+static void
+init_state(struct pipe_rasterizer_state *state, unsigned i)
+{
+   memset(state, 0, sizeof *state);
+   state->cull_face = i & 3;
+   state->front_ccw = (i >> 2) & 1;
+   state->scissor = (i >> 3) & 1;
+   state->line_width = 1.0f + (float)(i >> 4);
+   state->point_size = 1.0f;
+}
+
+
+int
+main(int argc, char **argv)
+{
+   const unsigned key_size = sizeof(struct pipe_rasterizer_state);
+   struct cso_cache *cache;
+   struct pipe_rasterizer_state templ;
+   struct cso_rasterizer *states[NUM_STATES];
+   unsigned hash_keys[NUM_STATES];
+   unsigned order[4096];
+   unsigned seed = 1;
+   unsigned i, fails = 0;
+   int64_t start, hash_ns, table_ns;
+
+   cache = cso_cache_create();
+   if (!cache) {
+      printf("Failure! Couldn't create the cache.\n");
+      return 1;
+   }
+
+   for (i = 0; i < NUM_STATES; i++) {
+      states[i] = CALLOC_STRUCT(cso_rasterizer);
+      init_state(&states[i]->state, i);
+      hash_keys[i] = cso_construct_key(&states[i]->state, key_size);
+      cso_insert_state(cache, hash_keys[i], CSO_RASTERIZER, states[i]);
+   }
+
+   /* Switch between the states in an unpredictable order, like a state
+    * tracker going through its draws would.
+    */
+   for (i = 0; i < ARRAY_SIZE(order); i++) {
+      seed = seed * 1103515245 + 12345;
+      order[i] = (seed >> 16) % NUM_STATES;
+   }
+
+   for (i = 0; i < NUM_STATES; i++) {
+      struct cso_hash_iter iter;
+
+      init_state(&templ, i);
+      iter = cso_find_state_template(cache, hash_keys[i], CSO_RASTERIZER,
+                                     &templ, key_size);
+      if (cso_hash_iter_is_null(iter) ||
+          cso_hash_iter_data(iter) != states[i] ||
+          cso_lookup_state(cache, hash_keys[i], CSO_RASTERIZER,
+                           &templ, key_size) != states[i])
+         fails++;
+   }
+
+   start = os_time_get_nano();
+   for (i = 0; i < NUM_LOOKUPS; i++) {
+      const unsigned j = order[i % ARRAY_SIZE(order)];
+      struct cso_hash_iter iter =
+         cso_find_state_template(cache, hash_keys[j], CSO_RASTERIZER,
+                                 &states[j]->state, key_size);
+      fails += cso_hash_iter_data(iter) != states[j];
+   }
+   hash_ns = os_time_get_nano() - start;
+
+   start = os_time_get_nano();
+   for (i = 0; i < NUM_LOOKUPS; i++) {
+      const unsigned j = order[i % ARRAY_SIZE(order)];
+      fails += cso_lookup_state(cache, hash_keys[j], CSO_RASTERIZER,
+                                &states[j]->state, key_size) != states[j];
+   }
+   table_ns = os_time_get_nano() - start;
+
+   printf("%u states, %u lookups:\n", NUM_STATES, NUM_LOOKUPS);
+   printf("  cso_find_state_template: %6.1f ns/lookup\n",
+          (double)hash_ns / NUM_LOOKUPS);
+   printf("  cso_lookup_state:        %6.1f ns/lookup\n",
+          (double)table_ns / NUM_LOOKUPS);
+
+   /* Also frees the states */
+   cso_cache_delete(cache);
+
+   if (fails) {
+      printf("Failure! %u lookups returned the wrong state.\n", fails);
+      return 1;
+   }
+
+   printf("Success!\n");
+   return 0;
+}
@@ -31,6 +31,7 @@
 #include <float.h>
 
 #include "util/u_half.h"
+#include "util/u_math.h"
 #include "util/u_format.h"
 #include "util/u_format_tests.h"
 #include "util/u_format_s3tc.h"
@@ -699,6 +700,87 @@ test_one_func(const struct util_format_description *format_desc,
 }
 
 
+/*
+ * Check util_format_translate between 32bit 8unorm formats against going
+ * through the unpack_rgba_8unorm/pack_rgba_8unorm pair.
+ */
+static boolean
+test_format_translate_8unorm(void)
+{
+   enum pipe_format src_format, dst_format;
+   boolean success = TRUE;
+
+   for (src_format = 1; src_format < PIPE_FORMAT_COUNT; ++src_format) {
+      const struct util_format_description *src_desc;
+
+      src_desc = util_format_description(src_format);
+      if (!src_desc ||
+          src_desc->layout != UTIL_FORMAT_LAYOUT_PLAIN ||
+          src_desc->block.bits != 32 ||
+          !util_format_fits_8unorm(src_desc) ||
+          !src_desc->unpack_rgba_8unorm) {
+         continue;
+      }
+
+      for (dst_format = 1; dst_format < PIPE_FORMAT_COUNT; ++dst_format) {
+         const struct util_format_description *dst_desc;
+         uint32_t src[7], dst[7], expected[7];
+         uint8_t rgba[7][4];
+         unsigned i, j;
+
+         dst_desc = util_format_description(dst_format);
+         if (!dst_desc ||
+             dst_desc->layout != UTIL_FORMAT_LAYOUT_PLAIN ||
+             dst_desc->block.bits != 32 ||
+             dst_desc->colorspace != src_desc->colorspace ||
+             !util_format_fits_8unorm(dst_desc) ||
+             !dst_desc->pack_rgba_8unorm) {
+            continue;
+         }
+
+         for (i = 0; i < ARRAY_SIZE(src); ++i)
+            src[i] = 0x01234567u * (i + 1) ^ 0x89abcdefu;
+
+         src_desc->unpack_rgba_8unorm(&rgba[0][0], sizeof rgba,
+                                      (const uint8_t *)src, sizeof src,
+                                      ARRAY_SIZE(src), 1);
+         dst_desc->pack_rgba_8unorm((uint8_t *)expected, sizeof expected,
+                                    &rgba[0][0], sizeof rgba,
+                                    ARRAY_SIZE(src), 1);
+
+         if (!util_format_translate(dst_format, dst, sizeof dst, 0, 0,
+                                    src_format, src, sizeof src, 0, 0,
+                                    ARRAY_SIZE(src), 1)) {
+            continue;
+         }
+
+         for (i = 0; i < ARRAY_SIZE(src); ++i) {
+            for (j = 0; j < 4; ++j) {
+               const struct util_format_channel_description *chan =
+                  &dst_desc->channel[j];
+               uint32_t mask;
+
+               if (chan->type == UTIL_FORMAT_TYPE_VOID)
+                  continue;
+
+               mask = ((1u << chan->size) - 1) << chan->shift;
+               if ((dst[i] & mask) != (expected[i] & mask)) {
+                  printf("FAILED: util_format_translate %s -> %s, "
+                         "pixel %u: %08x, expected %08x\n",
+                         src_desc->short_name, dst_desc->short_name,
+                         i, dst[i], expected[i]);
+                  success = FALSE;
+                  break;
+               }
+            }
+         }
+      }
+   }
+
+   return success;
+}
+
+
 static boolean
 test_all(void)
 {
@@ -750,5 +832,9 @@ int main(int argc, char **argv)
 
    success = test_all();
 
+   printf("Testing util_format_translate ...\n");
+   if (!test_format_translate_8unorm())
+      success = FALSE;
+
    return success ? 0 : 1;
 }
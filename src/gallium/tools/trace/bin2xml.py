@@ -0,0 +1,214 @@
+#!/usr/bin/env python2
+##########################################################################
+#
+# Copyright 2018 Advanced Micro Devices, Inc.
+# All Rights Reserved.
+#
+# Permission is hereby granted, free of charge, to any person obtaining a
+# copy of this software and associated documentation files (the
+# "Software"), to deal in the Software without restriction, including
+# without limitation the rights to use, copy, modify, merge, publish,
+# distribute, sub license, and/or sell copies of the Software, and to
+# permit persons to whom the Software is furnished to do so, subject to
+# the following conditions:
+#
+# The above copyright notice and this permission notice (including the
+# next paragraph) shall be included in all copies or substantial portions
+# of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+# OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+# MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+# IN NO EVENT SHALL THE AUTHORS AND/OR ITS SUPPLIERS BE LIABLE FOR
+# ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+# TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+# SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+#
+##########################################################################
+
+"""Convert a binary trace (GALLIUM_TRACE_BINARY) to the XML format.
+
+The token encoding is described in
+src/gallium/auxiliary/driver_trace/tr_dump_binary.h.
+"""
+
+
+import binascii
+import optparse
+import struct
+import sys
+
+
+MAGIC = b'GALTRACE'
+VERSION = 1
+
+(STRDEF, CALL_BEGIN, CALL_END, ARG_BEGIN, ARG_END, RET_BEGIN, RET_END,
+ BOOL, INT, UINT, FLOAT, BYTES, BLOBDEF, BYTES_REF, STRING, ENUM,
+ ARRAY_BEGIN, ARRAY_END, ELEM_BEGIN, ELEM_END, STRUCT_BEGIN, STRUCT_END,
+ MEMBER_BEGIN, MEMBER_END, NULL, PTR) = range(1, 27)
+
+
+def escape(data):
+    out = []
+    for c in bytearray(data):
+        if c == ord('<'):
+            out.append('&lt;')
+        elif c == ord('>'):
+            out.append('&gt;')
+        elif c == ord('&'):
+            out.append('&amp;')
+        elif c == ord('\''):
+            out.append('&apos;')
+        elif c == ord('"'):
+            out.append('&quot;')
+        elif 0x20 <= c <= 0x7e:
+            out.append(chr(c))
+        else:
+            out.append('&#%u;' % c)
+    return ''.join(out)
+
+
+class Reader:
+
+    def __init__(self, fp):
+        self.fp = fp
+
+    def read(self, size):
+        data = self.fp.read(size)
+        if len(data) != size:
+            raise EOFError
+        return data
+
+    def u8(self):
+        return struct.unpack('<B', self.read(1))[0]
+
+    def u32(self):
+        return struct.unpack('<I', self.read(4))[0]
+
+    def i64(self):
+        return struct.unpack('<q', self.read(8))[0]
+
+    def u64(self):
+        return struct.unpack('<Q', self.read(8))[0]
+
+    def f64(self):
+        return struct.unpack('<d', self.read(8))[0]
+
+
+def convert(fp, out):
+    reader = Reader(fp)
+
+    if reader.read(8) != MAGIC:
+        raise ValueError('not a binary gallium trace')
+    version = reader.u32()
+    if version != VERSION:
+        raise ValueError('unsupported binary trace version %u' % version)
+
+    strings = {}
+    blobs = {}
+
+    out.write("<?xml version='1.0' encoding='UTF-8'?>\n")
+    out.write("<?xml-stylesheet type='text/xsl' href='trace.xsl'?>\n")
+    out.write("<trace version='0.1'>\n")
+
+    while True:
+        try:
+            token = reader.u8()
+        except EOFError:
+            break
+
+        try:
+            if token == STRDEF:
+                id = reader.u32()
+                strings[id] = reader.read(reader.u32())
+            elif token == CALL_BEGIN:
+                no = reader.u32()
+                klass = strings[reader.u32()]
+                method = strings[reader.u32()]
+                out.write("\t<call no='%u' class='%s' method='%s'>\n" %
+                          (no, escape(klass), escape(method)))
+            elif token == CALL_END:
+                out.write('\t\t<time><int>%i</int></time>\n' % reader.i64())
+                out.write('\t</call>\n')
+            elif token == ARG_BEGIN:
+                out.write("\t\t<arg name='%s'>" %
+                          escape(strings[reader.u32()]))
+            elif token == ARG_END:
+                out.write('</arg>\n')
+            elif token == RET_BEGIN:
+                out.write('\t\t<ret>')
+            elif token == RET_END:
+                out.write('</ret>\n')
+            elif token == BOOL:
+                out.write('<bool>%u</bool>' % reader.u8())
+            elif token == INT:
+                out.write('<int>%i</int>' % reader.i64())
+            elif token == UINT:
+                out.write('<uint>%u</uint>' % reader.u64())
+            elif token == FLOAT:
+                out.write('<float>%g</float>' % reader.f64())
+            elif token in (BYTES, BLOBDEF, BYTES_REF):
+                if token == BLOBDEF:
+                    sha1 = reader.read(20)
+                    blobs[sha1] = reader.read(reader.u32())
+                    continue
+                if token == BYTES:
+                    data = reader.read(reader.u32())
+                else:
+                    data = blobs[reader.read(20)]
+                out.write('<bytes>%s</bytes>' %
+                          binascii.hexlify(data).decode().upper())
+            elif token == STRING:
+                out.write('<string>%s</string>' %
+                          escape(reader.read(reader.u32())))
+            elif token == ENUM:
+                out.write('<enum>%s</enum>' % escape(strings[reader.u32()]))
+            elif token == ARRAY_BEGIN:
+                out.write('<array>')
+            elif token == ARRAY_END:
+                out.write('</array>')
+            elif token == ELEM_BEGIN:
+                out.write('<elem>')
+            elif token == ELEM_END:
+                out.write('</elem>')
+            elif token == STRUCT_BEGIN:
+                out.write("<struct name='%s'>" %
+                          strings[reader.u32()].decode())
+            elif token == STRUCT_END:
+                out.write('</struct>')
+            elif token == MEMBER_BEGIN:
+                out.write("<member name='%s'>" %
+                          strings[reader.u32()].decode())
+            elif token == MEMBER_END:
+                out.write('</member>')
+            elif token == NULL:
+                out.write('<null/>')
+            elif token == PTR:
+                out.write('<ptr>0x%08x</ptr>' % reader.u64())
+            else:
+                raise ValueError('unknown token %u' % token)
+        except EOFError:
+            # The application didn't exit cleanly.
+            sys.stderr.write('warning: truncated trace\n')
+            break
+
+    out.write('</trace>\n')
+
+
+def main():
+    optparser = optparse.OptionParser(
+        usage="\n\t%prog [options] TRACE [OUTPUT]")
+    (options, args) = optparser.parse_args(sys.argv[1:])
+    if len(args) not in (1, 2):
+        optparser.error('incorrect number of arguments')
+
+    fp = open(args[0], 'rb')
+    if len(args) == 2:
+        out = open(args[1], 'wt')
+    else:
+        out = sys.stdout
+    convert(fp, out)
+
+
+if __name__ == '__main__':
+    main()
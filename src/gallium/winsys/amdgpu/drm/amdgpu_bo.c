@@ -166,6 +166,68 @@ static void amdgpu_bo_remove_fences(struct amdgpu_winsys_bo *bo)
    bo->max_fences = 0;
 }
 
+/* Get a VA range, preferably one of a destroyed buffer with the same
+ * parameters. This keeps the libdrm VA allocator and its lock out of the
+ * path for the common case of buffers being recreated with the same size.
+ */
+static int amdgpu_va_range_get(struct amdgpu_winsys *ws, uint64_t size,
+                               uint32_t alignment, uint32_t flags,
+                               uint64_t *va, amdgpu_va_handle *handle)
+{
+   simple_mtx_lock(&ws->va_cache_lock);
+   for (int i = ws->num_va_cache_entries - 1; i >= 0; i--) {
+      struct amdgpu_va_cache_entry *entry = &ws->va_cache[i];
+
+      if (entry->size != size ||
+          entry->alignment != alignment ||
+          entry->flags != flags)
+         continue;
+
+      *va = entry->va;
+      *handle = entry->handle;
+      memmove(entry, entry + 1,
+              (ws->num_va_cache_entries - i - 1) * sizeof(*entry));
+      ws->num_va_cache_entries--;
+      ws->num_va_cache_hits++;
+      simple_mtx_unlock(&ws->va_cache_lock);
+      return 0;
+   }
+   simple_mtx_unlock(&ws->va_cache_lock);
+
+   return amdgpu_va_range_alloc(ws->dev, amdgpu_gpu_va_range_general,
+                                size, alignment, 0, va, handle, flags);
+}
+
+static void amdgpu_va_range_put(struct amdgpu_winsys *ws,
+                                struct amdgpu_winsys_bo *bo)
+{
+   struct amdgpu_va_cache_entry *entry;
+
+   simple_mtx_lock(&ws->va_cache_lock);
+   if (ws->num_va_cache_entries == AMDGPU_VA_CACHE_SIZE) {
+      /* Drop the oldest range. */
+      amdgpu_va_range_free(ws->va_cache[0].handle);
+      memmove(&ws->va_cache[0], &ws->va_cache[1],
+              (AMDGPU_VA_CACHE_SIZE - 1) * sizeof(ws->va_cache[0]));
+      ws->num_va_cache_entries--;
+   }
+
+   entry = &ws->va_cache[ws->num_va_cache_entries++];
+   entry->handle = bo->u.real.va_handle;
+   entry->va = bo->va;
+   entry->size = bo->u.real.va_size;
+   entry->alignment = bo->u.real.va_alignment;
+   entry->flags = bo->u.real.va_flags;
+   simple_mtx_unlock(&ws->va_cache_lock);
+}
+
+void amdgpu_va_cache_deinit(struct amdgpu_winsys *ws)
+{
+   for (unsigned i = 0; i < ws->num_va_cache_entries; i++)
+      amdgpu_va_range_free(ws->va_cache[i].handle);
+   ws->num_va_cache_entries = 0;
+}
+
 void amdgpu_bo_destroy(struct pb_buffer *_buf)
 {
    struct amdgpu_winsys_bo *bo = amdgpu_winsys_bo(_buf);
@@ -185,9 +247,15 @@ void amdgpu_bo_destroy(struct pb_buffer *_buf)
    simple_mtx_unlock(&ws->bo_export_table_lock);
 
    amdgpu_bo_va_op(bo->bo, 0, bo->base.size, bo->va, 0, AMDGPU_VA_OP_UNMAP);
-   amdgpu_va_range_free(bo->u.real.va_handle);
+   if (bo->u.real.va_size)
+      amdgpu_va_range_put(ws, bo);
+   else
+      amdgpu_va_range_free(bo->u.real.va_handle);
    amdgpu_bo_free(bo->bo);
 
+   if (bo->u.real.va_alignment >= AMDGPU_HUGE_FRAGMENT_SIZE)
+      ws->huge_aligned_memory -= bo->base.size;
+
    amdgpu_bo_remove_fences(bo);
 
    if (bo->initial_domain & RADEON_DOMAIN_VRAM)
@@ -397,6 +465,8 @@ static struct amdgpu_winsys_bo *amdgpu_create_bo(struct amdgpu_winsys *ws,
    struct amdgpu_winsys_bo *bo;
    amdgpu_va_handle va_handle;
    unsigned va_gap_size;
+   uint64_t va_size;
+   uint32_t va_flags;
    int r;
 
    /* VRAM or GTT must be specified, but not both at the same time. */
@@ -448,12 +518,17 @@ static struct amdgpu_winsys_bo *amdgpu_create_bo(struct amdgpu_winsys *ws,
    }
 
    va_gap_size = ws->check_vm ? MAX2(4 * alignment, 64 * 1024) : 0;
-   if (size > ws->info.pte_fragment_size)
-	   alignment = MAX2(alignment, ws->info.pte_fragment_size);
-   r = amdgpu_va_range_alloc(ws->dev, amdgpu_gpu_va_range_general,
-                             size + va_gap_size, alignment, 0, &va, &va_handle,
-                             (flags & RADEON_FLAG_32BIT ? AMDGPU_VA_RANGE_32_BIT : 0) |
-			     AMDGPU_VA_RANGE_HIGH);
+   va_size = size + va_gap_size;
+   if (size >= AMDGPU_HUGE_FRAGMENT_SIZE) {
+      /* Don't share a huge fragment with other buffers. */
+      alignment = MAX2(alignment, AMDGPU_HUGE_FRAGMENT_SIZE);
+      va_size = align64(va_size, AMDGPU_HUGE_FRAGMENT_SIZE);
+   } else if (size > ws->info.pte_fragment_size) {
+      alignment = MAX2(alignment, ws->info.pte_fragment_size);
+   }
+   va_flags = (flags & RADEON_FLAG_32BIT ? AMDGPU_VA_RANGE_32_BIT : 0) |
+              AMDGPU_VA_RANGE_HIGH;
+   r = amdgpu_va_range_get(ws, va_size, alignment, va_flags, &va, &va_handle);
    if (r)
       goto error_va_alloc;
 
@@ -477,6 +552,10 @@ static struct amdgpu_winsys_bo *amdgpu_create_bo(struct amdgpu_winsys *ws,
    bo->bo = buf_handle;
    bo->va = va;
    bo->u.real.va_handle = va_handle;
+   /* Recycling VA ranges would hide use-after-free VM faults. */
+   bo->u.real.va_size = ws->check_vm ? 0 : va_size;
+   bo->u.real.va_alignment = alignment;
+   bo->u.real.va_flags = va_flags;
    bo->initial_domain = initial_domain;
    bo->unique_id = __sync_fetch_and_add(&ws->next_bo_unique_id, 1);
    bo->is_local = !!(request.flags & AMDGPU_GEM_CREATE_VM_ALWAYS_VALID);
@@ -486,6 +565,9 @@ static struct amdgpu_winsys_bo *amdgpu_create_bo(struct amdgpu_winsys *ws,
    else if (initial_domain & RADEON_DOMAIN_GTT)
       ws->allocated_gtt += align64(size, ws->info.gart_page_size);
 
+   if (alignment >= AMDGPU_HUGE_FRAGMENT_SIZE)
+      ws->huge_aligned_memory += size;
+
    amdgpu_add_buffer_to_global_list(bo);
 
    return bo;
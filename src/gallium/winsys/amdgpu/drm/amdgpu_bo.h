@@ -62,6 +62,11 @@ struct amdgpu_winsys_bo {
          struct pb_cache_entry cache_entry;
 
          amdgpu_va_handle va_handle;
+         /* Parameters of the VA range, or va_size = 0 if it can't be
+          * recycled. */
+         uint64_t va_size;
+         uint32_t va_alignment;
+         uint32_t va_flags;
          int map_count;
          bool use_reusable_pool;
 
@@ -111,6 +116,8 @@ struct amdgpu_winsys_bo {
    unsigned num_fences;
    unsigned max_fences;
    struct pipe_fence_handle **fences;
+   /* If non-zero, all fences were added by the CS with this unique_id. */
+   uint32_t fences_cs_id;
 
    bool is_local;
 };
@@ -124,6 +131,7 @@ struct amdgpu_slab {
 bool amdgpu_bo_can_reclaim(struct pb_buffer *_buf);
 void amdgpu_bo_destroy(struct pb_buffer *_buf);
 void amdgpu_bo_init_functions(struct amdgpu_winsys *ws);
+void amdgpu_va_cache_deinit(struct amdgpu_winsys *ws);
 
 bool amdgpu_bo_can_reclaim_slab(void *priv, struct pb_slab_entry *entry);
 struct pb_slab *amdgpu_bo_slab_alloc(void *priv, unsigned heap,
@@ -28,6 +28,7 @@
 
 #include "amdgpu_cs.h"
 #include "util/os_time.h"
+#include "util/u_cpu_trace.h"
 #include <inttypes.h>
 #include <stdio.h>
 
@@ -931,6 +932,7 @@ amdgpu_cs_create(struct radeon_winsys_ctx *rwctx,
    cs->flush_cs = flush;
    cs->flush_data = flush_ctx;
    cs->ring_type = ring_type;
+   cs->unique_id = p_atomic_inc_return(&ctx->ws->next_cs_unique_id);
 
    struct amdgpu_cs_fence_info fence_info;
    fence_info.handle = cs->ctx->user_fence_bo;
@@ -1124,6 +1126,8 @@ static void amdgpu_add_bo_fence_dependencies(struct amdgpu_cs *acs,
    struct amdgpu_winsys_bo *bo = buffer->bo;
    unsigned new_num_fences = 0;
 
+   acs->ctx->ws->num_fence_deps_scanned += bo->num_fences;
+
    for (unsigned j = 0; j < bo->num_fences; ++j) {
       struct amdgpu_fence *bo_fence = (void *)bo->fences[j];
 
@@ -1139,6 +1143,7 @@ static void amdgpu_add_bo_fence_dependencies(struct amdgpu_cs *acs,
       unsigned idx = add_fence_dependency_entry(cs);
       amdgpu_fence_reference(&cs->fence_dependencies[idx],
                              (struct pipe_fence_handle*)bo_fence);
+      acs->ctx->ws->num_fence_deps_added++;
    }
 
    for (unsigned j = new_num_fences; j < bo->num_fences; ++j)
@@ -1155,6 +1160,9 @@ void amdgpu_add_fences(struct amdgpu_winsys_bo *bo,
                        unsigned num_fences,
                        struct pipe_fence_handle **fences)
 {
+   /* The fences may come from anywhere. */
+   bo->fences_cs_id = 0;
+
    if (bo->num_fences + num_fences > bo->max_fences) {
       unsigned new_max_fences = MAX2(bo->num_fences + num_fences, bo->max_fences * 2);
       struct pipe_fence_handle **new_fences =
@@ -1196,9 +1204,21 @@ static void amdgpu_add_fence_dependencies_bo_list(struct amdgpu_cs *acs,
       struct amdgpu_cs_buffer *buffer = &buffers[i];
       struct amdgpu_winsys_bo *bo = buffer->bo;
 
-      amdgpu_add_bo_fence_dependencies(acs, buffer);
       p_atomic_inc(&bo->num_active_ioctls);
+
+      /* If the only fence is from an earlier submission of this CS, there
+       * is nothing to wait for, and it's simply replaced by the new one.
+       * This is the common case for buffers used by a single context.
+       */
+      if (bo->num_fences == 1 && bo->fences_cs_id == acs->unique_id) {
+         amdgpu_fence_reference(&bo->fences[0], fence);
+         continue;
+      }
+
+      amdgpu_add_bo_fence_dependencies(acs, buffer);
       amdgpu_add_fences(bo, 1, &fence);
+      if (bo->num_fences == 1)
+         bo->fences_cs_id = acs->unique_id;
    }
 }
 
@@ -1281,6 +1301,63 @@ static bool amdgpu_add_sparse_backing_buffers(struct amdgpu_cs_context *cs)
    return true;
 }
 
+/* Returns a kernel buffer list with the given buffers, reusing the one of
+ * the previous submission when possible. In steady state, the same buffers
+ * are submitted every frame, and this saves creating and destroying a list
+ * per submission.
+ */
+static int amdgpu_get_bo_list(struct amdgpu_cs *acs, unsigned num,
+                              amdgpu_bo_handle *handles, uint32_t *ids,
+                              uint8_t *flags, amdgpu_bo_list_handle *bo_list)
+{
+   struct amdgpu_winsys *ws = acs->ctx->ws;
+   int r;
+
+   if (acs->bo_list && num == acs->num_bo_list_buffers &&
+       !memcmp(ids, acs->bo_list_ids, num * sizeof(ids[0])) &&
+       !memcmp(flags, acs->bo_list_flags, num * sizeof(flags[0]))) {
+      *bo_list = acs->bo_list;
+      return 0;
+   }
+
+   if (num > acs->max_bo_list_buffers) {
+      uint32_t *new_ids = REALLOC(acs->bo_list_ids,
+                                  acs->max_bo_list_buffers * sizeof(*new_ids),
+                                  num * sizeof(*new_ids));
+      if (new_ids)
+         acs->bo_list_ids = new_ids;
+
+      uint8_t *new_flags = REALLOC(acs->bo_list_flags,
+                                   acs->max_bo_list_buffers * sizeof(*new_flags),
+                                   num * sizeof(*new_flags));
+      if (new_flags)
+         acs->bo_list_flags = new_flags;
+
+      /* Fall back to a list for this submission only. */
+      if (!new_ids || !new_flags)
+         return amdgpu_bo_list_create(ws->dev, num, handles, flags, bo_list);
+
+      acs->max_bo_list_buffers = num;
+   }
+
+   if (acs->bo_list)
+      r = amdgpu_bo_list_update(acs->bo_list, num, handles, flags);
+   else
+      r = amdgpu_bo_list_create(ws->dev, num, handles, flags, &acs->bo_list);
+
+   if (r) {
+      /* Don't trust the contents of the list anymore. */
+      acs->num_bo_list_buffers = 0;
+      return r;
+   }
+
+   memcpy(acs->bo_list_ids, ids, num * sizeof(ids[0]));
+   memcpy(acs->bo_list_flags, flags, num * sizeof(flags[0]));
+   acs->num_bo_list_buffers = num;
+   *bo_list = acs->bo_list;
+   return 0;
+}
+
 void amdgpu_cs_submit_ib(void *job, int thread_index)
 {
    struct amdgpu_cs *acs = (struct amdgpu_cs*)job;
@@ -1291,6 +1368,8 @@ void amdgpu_cs_submit_ib(void *job, int thread_index)
    uint64_t seq_no = 0;
    bool has_user_fence = amdgpu_cs_has_user_fence(cs);
 
+   MESA_TRACE_FUNC();
+
    /* Create the buffer list.
     * Use a buffer list containing all allocated buffers if requested.
     */
@@ -1324,6 +1403,7 @@ void amdgpu_cs_submit_ib(void *job, int thread_index)
       }
 
       amdgpu_bo_handle *handles = alloca(sizeof(*handles) * cs->num_real_buffers);
+      uint32_t *ids = alloca(sizeof(*ids) * cs->num_real_buffers);
       uint8_t *flags = alloca(sizeof(*flags) * cs->num_real_buffers);
 
       num_handles = 0;
@@ -1336,13 +1416,19 @@ void amdgpu_cs_submit_ib(void *job, int thread_index)
          assert(buffer->u.real.priority_usage != 0);
 
          handles[num_handles] = buffer->bo->bo;
+         ids[num_handles] = buffer->bo->unique_id;
          flags[num_handles] = (util_last_bit(buffer->u.real.priority_usage) - 1) / 2;
 	 ++num_handles;
       }
 
       if (num_handles) {
-         r = amdgpu_bo_list_create(ws->dev, num_handles,
-                                   handles, flags, &bo_list);
+         if (ws->reuse_bo_list) {
+            r = amdgpu_get_bo_list(acs, num_handles, handles, ids, flags,
+                                   &bo_list);
+         } else {
+            r = amdgpu_bo_list_create(ws->dev, num_handles,
+                                      handles, flags, &bo_list);
+         }
          if (r) {
             fprintf(stderr, "amdgpu: buffer list creation failed (%d)\n", r);
             goto cleanup;
@@ -1474,7 +1560,7 @@ void amdgpu_cs_submit_ib(void *job, int thread_index)
    }
 
    /* Cleanup. */
-   if (bo_list)
+   if (bo_list && bo_list != acs->bo_list)
       amdgpu_bo_list_destroy(bo_list);
 
 cleanup:
@@ -1618,6 +1704,12 @@ static int amdgpu_cs_flush(struct radeon_cmdbuf *rcs,
    else if (cs->ring_type == RING_DMA)
       ws->num_sdma_IBs++;
 
+   /* The end of a frame is a good time to drop the cached buffers that
+    * recent frames didn't need.
+    */
+   if (cs->ring_type == RING_GFX && (flags & PIPE_FLUSH_END_OF_FRAME))
+      pb_cache_trim(&ws->bo_cache);
+
    return error_code;
 }
 
@@ -1633,6 +1725,10 @@ static void amdgpu_cs_destroy(struct radeon_cmdbuf *rcs)
    amdgpu_destroy_cs_context(&cs->csc1);
    amdgpu_destroy_cs_context(&cs->csc2);
    amdgpu_fence_reference(&cs->next_fence, NULL);
+   if (cs->bo_list)
+      amdgpu_bo_list_destroy(cs->bo_list);
+   FREE(cs->bo_list_ids);
+   FREE(cs->bo_list_flags);
    FREE(cs);
 }
 
@@ -132,6 +132,18 @@ struct amdgpu_cs {
 
    struct util_queue_fence flush_completed;
    struct pipe_fence_handle *next_fence;
+   uint32_t unique_id; /* for amdgpu_winsys_bo::fences_cs_id, never 0 */
+
+   /* The kernel buffer list of the last submission and the buffers and
+    * priorities in it. It is reused by the next submission if that has the
+    * same buffers, and updated in place otherwise. Only the submission
+    * thread uses these.
+    */
+   amdgpu_bo_list_handle bo_list;
+   uint32_t *bo_list_ids;
+   uint8_t *bo_list_flags;
+   unsigned num_bo_list_buffers;
+   unsigned max_bo_list_buffers;
 };
 
 struct amdgpu_fence {
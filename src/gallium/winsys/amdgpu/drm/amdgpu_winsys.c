@@ -64,6 +64,7 @@ static bool do_winsys_init(struct amdgpu_winsys *ws, int fd)
    ws->debug_all_bos = debug_get_option_all_bos();
    ws->reserve_vmid = strstr(debug_get_option("R600_DEBUG", ""), "reserve_vmid") != NULL;
    ws->zero_all_vram_allocs = strstr(debug_get_option("R600_DEBUG", ""), "zerovram") != NULL;
+   ws->reuse_bo_list = strstr(debug_get_option("R600_DEBUG", ""), "nobolistreuse") == NULL;
 
    return true;
 
@@ -92,9 +93,11 @@ static void amdgpu_winsys_destroy(struct radeon_winsys *rws)
    simple_mtx_destroy(&ws->bo_fence_lock);
    pb_slabs_deinit(&ws->bo_slabs);
    pb_cache_deinit(&ws->bo_cache);
+   amdgpu_va_cache_deinit(ws);
    util_hash_table_destroy(ws->bo_export_table);
    simple_mtx_destroy(&ws->global_bo_list_lock);
    simple_mtx_destroy(&ws->bo_export_table_lock);
+   simple_mtx_destroy(&ws->va_cache_lock);
    do_winsys_deinit(ws);
    FREE(rws);
 }
@@ -143,6 +146,20 @@ static uint64_t amdgpu_query_value(struct radeon_winsys *rws,
       return ws->gfx_bo_list_counter;
    case RADEON_GFX_IB_SIZE_COUNTER:
       return ws->gfx_ib_size_counter;
+   case RADEON_NUM_FENCE_DEPS_SCANNED:
+      return ws->num_fence_deps_scanned;
+   case RADEON_NUM_FENCE_DEPS_ADDED:
+      return ws->num_fence_deps_added;
+   case RADEON_BUFFER_CACHE_HITS:
+      return ws->bo_cache.num_hits;
+   case RADEON_BUFFER_CACHE_MISSES:
+      return ws->bo_cache.num_misses;
+   case RADEON_BUFFER_CACHE_SIZE:
+      return ws->bo_cache.cache_size;
+   case RADEON_VA_CACHE_HITS:
+      return ws->num_va_cache_hits;
+   case RADEON_HUGE_ALIGNED_MEMORY:
+      return ws->huge_aligned_memory;
    case RADEON_NUM_BYTES_MOVED:
       amdgpu_query_info(ws->dev, AMDGPU_INFO_NUM_BYTES_MOVED, 8, &retval);
       return retval;
@@ -321,6 +338,7 @@ amdgpu_winsys_create(int fd, const struct pipe_screen_config *config,
    (void) simple_mtx_init(&ws->global_bo_list_lock, mtx_plain);
    (void) simple_mtx_init(&ws->bo_fence_lock, mtx_plain);
    (void) simple_mtx_init(&ws->bo_export_table_lock, mtx_plain);
+   (void) simple_mtx_init(&ws->va_cache_lock, mtx_plain);
 
    if (!util_queue_init(&ws->cs_queue, "cs", 8, 1,
                         UTIL_QUEUE_INIT_RESIZE_IF_FULL)) {
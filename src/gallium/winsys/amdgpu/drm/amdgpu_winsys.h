@@ -42,6 +42,21 @@ struct amdgpu_cs;
 #define AMDGPU_SLAB_MAX_SIZE_LOG2   16 /* 64 KB */
 #define AMDGPU_SLAB_BO_SIZE_LOG2    17 /* 128 KB */
 
+/* Buffers at least this big get VA ranges aligned to it, so that the kernel
+ * can map them with 2MB PTE fragments. */
+#define AMDGPU_HUGE_FRAGMENT_SIZE   (2 * 1024 * 1024)
+
+/* Number of VA ranges of destroyed buffers kept for reuse. */
+#define AMDGPU_VA_CACHE_SIZE        32
+
+struct amdgpu_va_cache_entry {
+   amdgpu_va_handle handle;
+   uint64_t va;
+   uint64_t size;
+   uint32_t alignment;
+   uint32_t flags; /* AMDGPU_VA_RANGE_* */
+};
+
 struct amdgpu_winsys {
    struct radeon_winsys base;
    struct pipe_reference reference;
@@ -57,6 +72,7 @@ struct amdgpu_winsys {
    uint32_t surf_index_color;
    uint32_t surf_index_fmask;
    uint32_t next_bo_unique_id;
+   uint32_t next_cs_unique_id;
    uint64_t allocated_vram;
    uint64_t allocated_gtt;
    uint64_t mapped_vram;
@@ -67,6 +83,9 @@ struct amdgpu_winsys {
    uint64_t num_mapped_buffers;
    uint64_t gfx_bo_list_counter;
    uint64_t gfx_ib_size_counter;
+   uint64_t num_fence_deps_scanned; /* BO fences checked at flush time */
+   uint64_t num_fence_deps_added; /* of those, fences the CS had to wait for */
+   uint64_t huge_aligned_memory; /* bytes in buffers on huge-fragment VA */
 
    struct radeon_info info;
 
@@ -80,6 +99,7 @@ struct amdgpu_winsys {
    bool debug_all_bos;
    bool reserve_vmid;
    bool zero_all_vram_allocs;
+   bool reuse_bo_list;
 
    /* List of all allocated buffers */
    simple_mtx_t global_bo_list_lock;
@@ -90,6 +110,12 @@ struct amdgpu_winsys {
     * and re-imported buffers. */
    struct util_hash_table *bo_export_table;
    simple_mtx_t bo_export_table_lock;
+
+   /* VA ranges of destroyed buffers, oldest first. */
+   simple_mtx_t va_cache_lock;
+   struct amdgpu_va_cache_entry va_cache[AMDGPU_VA_CACHE_SIZE];
+   unsigned num_va_cache_entries;
+   uint64_t num_va_cache_hits;
 };
 
 static inline struct amdgpu_winsys *
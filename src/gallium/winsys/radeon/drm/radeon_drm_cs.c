@@ -697,6 +697,12 @@ static int radeon_drm_cs_flush(struct radeon_cmdbuf *rcs,
         cs->ws->num_gfx_IBs++;
     else if (cs->ring_type == RING_DMA)
         cs->ws->num_sdma_IBs++;
+
+    /* The end of a frame is a good time to drop the cached buffers that
+     * recent frames didn't need.
+     */
+    if (cs->ring_type == RING_GFX && (flags & PIPE_FLUSH_END_OF_FRAME))
+        pb_cache_trim(&cs->ws->bo_cache);
     return 0;
 }
 
@@ -675,6 +675,12 @@ static uint64_t radeon_query_value(struct radeon_winsys *rws,
         return ws->num_gfx_IBs;
     case RADEON_NUM_SDMA_IBS:
         return ws->num_sdma_IBs;
+    case RADEON_BUFFER_CACHE_HITS:
+        return ws->bo_cache.num_hits;
+    case RADEON_BUFFER_CACHE_MISSES:
+        return ws->bo_cache.num_misses;
+    case RADEON_BUFFER_CACHE_SIZE:
+        return ws->bo_cache.cache_size;
     case RADEON_NUM_BYTES_MOVED:
         radeon_get_drm_value(ws->fd, RADEON_INFO_NUM_BYTES_MOVED,
                              "num-bytes-moved", (uint32_t*)&retval);
@@ -684,6 +690,10 @@ static uint64_t radeon_query_value(struct radeon_winsys *rws,
     case RADEON_VRAM_VIS_USAGE:
     case RADEON_GFX_BO_LIST_COUNTER:
     case RADEON_GFX_IB_SIZE_COUNTER:
+    case RADEON_NUM_FENCE_DEPS_SCANNED:
+    case RADEON_NUM_FENCE_DEPS_ADDED:
+    case RADEON_VA_CACHE_HITS:
+    case RADEON_HUGE_ALIGNED_MEMORY:
         return 0; /* unimplemented */
     case RADEON_VRAM_USAGE:
         radeon_get_drm_value(ws->fd, RADEON_INFO_VRAM_USAGE,
@@ -229,6 +229,11 @@ kms_sw_displaytarget_destroy(struct sw_winsys *ws,
       DEBUG_PRINT("KMS-DEBUG: leaked map buffer %u\n", kms_sw_dt->handle);
    }
 
+   if (kms_sw_dt->mapped != MAP_FAILED)
+      munmap(kms_sw_dt->mapped, kms_sw_dt->size);
+   if (kms_sw_dt->ro_mapped != MAP_FAILED)
+      munmap(kms_sw_dt->ro_mapped, kms_sw_dt->size);
+
    memset(&destroy_req, 0, sizeof destroy_req);
    destroy_req.handle = kms_sw_dt->handle;
    drmIoctl(kms_sw->fd, DRM_IOCTL_MODE_DESTROY_DUMB, &destroy_req);
@@ -256,15 +261,19 @@ kms_sw_displaytarget_map(struct sw_winsys *ws,
    struct drm_mode_map_dumb map_req;
    int prot, ret;
 
-   memset(&map_req, 0, sizeof map_req);
-   map_req.handle = kms_sw_dt->handle;
-   ret = drmIoctl(kms_sw->fd, DRM_IOCTL_MODE_MAP_DUMB, &map_req);
-   if (ret)
-      return NULL;
-
-   prot = (flags == PIPE_TRANSFER_READ) ? PROT_READ : (PROT_READ | PROT_WRITE);
+   /* The mappings stay alive across unmap so that rendering into the dumb
+    * buffer every frame doesn't pay for the ioctl, the mmap and faulting
+    * in all the pages again.  They are only torn down in destroy.
+    */
    void **ptr = (flags == PIPE_TRANSFER_READ) ? &kms_sw_dt->ro_mapped : &kms_sw_dt->mapped;
    if (*ptr == MAP_FAILED) {
+      memset(&map_req, 0, sizeof map_req);
+      map_req.handle = kms_sw_dt->handle;
+      ret = drmIoctl(kms_sw->fd, DRM_IOCTL_MODE_MAP_DUMB, &map_req);
+      if (ret)
+         return NULL;
+
+      prot = (flags == PIPE_TRANSFER_READ) ? PROT_READ : (PROT_READ | PROT_WRITE);
       void *tmp = mmap(0, kms_sw_dt->size, prot, MAP_SHARED,
                        kms_sw->fd, map_req.offset);
       if (tmp == MAP_FAILED)
@@ -369,17 +378,11 @@ kms_sw_displaytarget_unmap(struct sw_winsys *ws,
       return;
    }
 
-   DEBUG_PRINT("KMS-DEBUG: unmapped buffer %u (was %p)\n", kms_sw_dt->handle, kms_sw_dt->mapped);
-   DEBUG_PRINT("KMS-DEBUG: unmapped buffer %u (was %p)\n", kms_sw_dt->handle, kms_sw_dt->ro_mapped);
-
-   if (kms_sw_dt->mapped != MAP_FAILED) {
-      munmap(kms_sw_dt->mapped, kms_sw_dt->size);
-      kms_sw_dt->mapped = MAP_FAILED;
-   }
-   if (kms_sw_dt->ro_mapped != MAP_FAILED) {
-      munmap(kms_sw_dt->ro_mapped, kms_sw_dt->size);
-      kms_sw_dt->ro_mapped = MAP_FAILED;
-   }
+   /* Keep the mappings around for the next map, see
+    * kms_sw_displaytarget_map().
+    */
+   DEBUG_PRINT("KMS-DEBUG: unmapped buffer %u (still at %p / %p)\n",
+               kms_sw_dt->handle, kms_sw_dt->mapped, kms_sw_dt->ro_mapped);
 }
 
 static struct sw_displaytarget *
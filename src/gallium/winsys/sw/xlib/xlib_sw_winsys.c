@@ -77,6 +77,7 @@ struct xlib_displaytarget
 
    XShmSegmentInfo shminfo;
    Bool shm;  /** Using shared memory images? */
+   Bool shm_pending;  /** XShmPutImage not known to be completed yet? */
 };
 
 
@@ -229,12 +230,54 @@ xlib_is_displaytarget_format_supported(struct sw_winsys *ws,
 }
 
 
+static Bool
+match_shm_completion(Display *display, XEvent *event, XPointer arg)
+{
+   struct xlib_displaytarget *xlib_dt = (struct xlib_displaytarget *) arg;
+   XShmCompletionEvent *completion = (XShmCompletionEvent *) event;
+
+   return event->type == XShmGetEventBase(display) + ShmCompletion &&
+          completion->shmseg == xlib_dt->shminfo.shmseg;
+}
+
+
+/**
+ * The X server reads the shared memory segment asynchronously, so before
+ * rendering into it again wait until the last XShmPutImage of it is done.
+ */
+static void
+wait_shm_completion(struct xlib_displaytarget *xlib_dt)
+{
+   XEvent event;
+
+   if (!xlib_dt->shm_pending)
+      return;
+
+   if (!XCheckIfEvent(xlib_dt->display, &event, match_shm_completion,
+                      (XPointer) xlib_dt)) {
+      /* The completion event is generated before the reply to the
+       * XSync, so once that returns it is either in our queue or it has
+       * already been taken by the application's own event loop.
+       */
+      XSync(xlib_dt->display, False);
+      XCheckIfEvent(xlib_dt->display, &event, match_shm_completion,
+                    (XPointer) xlib_dt);
+   }
+
+   xlib_dt->shm_pending = False;
+}
+
+
 static void *
 xlib_displaytarget_map(struct sw_winsys *ws,
                        struct sw_displaytarget *dt,
                        unsigned flags)
 {
    struct xlib_displaytarget *xlib_dt = xlib_displaytarget(dt);
+
+   if (flags & PIPE_TRANSFER_WRITE)
+      wait_shm_completion(xlib_dt);
+
    xlib_dt->mapped = xlib_dt->data;
    return xlib_dt->mapped;
 }
@@ -257,6 +300,7 @@ xlib_displaytarget_destroy(struct sw_winsys *ws,
 
    if (xlib_dt->data) {
       if (xlib_dt->shminfo.shmid >= 0) {
+         wait_shm_completion(xlib_dt);
          shmdt(xlib_dt->shminfo.shmaddr);
          shmctl(xlib_dt->shminfo.shmid, IPC_RMID, 0);
          
@@ -345,7 +389,8 @@ xlib_sw_display(struct xlib_drawable *xlib_drawable,
 
       /* _debug_printf("XSHM\n"); */
       XShmPutImage(xlib_dt->display, xlib_drawable->drawable, xlib_dt->gc,
-                   ximage, 0, 0, 0, 0, xlib_dt->width, xlib_dt->height, False);
+                   ximage, 0, 0, 0, 0, xlib_dt->width, xlib_dt->height, True);
+      xlib_dt->shm_pending = True;
    }
    else {
       /* display image in Window */
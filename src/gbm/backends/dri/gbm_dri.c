@@ -50,6 +50,7 @@
 #include "loader.h"
 #include "util/debug.h"
 #include "util/macros.h"
+#include "util/os_time.h"
 
 /* For importing wl_buffer */
 #if HAVE_WAYLAND_PLATFORM
@@ -723,6 +724,9 @@ gbm_dri_bo_get_fd(struct gbm_bo *_bo)
    if (!dri->image->queryImage(bo->image, __DRI_IMAGE_ATTRIB_FD, &fd))
       return -1;
 
+   /* Someone else may hold on to the storage after we're done with it. */
+   bo->reusable = false;
+
    return fd;
 }
 
@@ -896,11 +900,16 @@ gbm_dri_bo_get_modifier(struct gbm_bo *_bo)
    return ret;
 }
 
+/* Compositors tend to tear down and recreate surfaces of the same size on
+ * output reconfiguration, so keep a few destroyed BOs around for a short
+ * while instead of going back to the kernel for new ones.
+ */
+#define GBM_DRI_BO_CACHE_MAX 8
+#define GBM_DRI_BO_CACHE_TIMEOUT_NS 1000000000ll
+
 static void
-gbm_dri_bo_destroy(struct gbm_bo *_bo)
+gbm_dri_bo_free(struct gbm_dri_device *dri, struct gbm_dri_bo *bo)
 {
-   struct gbm_dri_device *dri = gbm_dri_device(_bo->gbm);
-   struct gbm_dri_bo *bo = gbm_dri_bo(_bo);
    struct drm_mode_destroy_dumb arg;
 
    if (bo->image != NULL) {
@@ -915,6 +924,82 @@ gbm_dri_bo_destroy(struct gbm_bo *_bo)
    free(bo);
 }
 
+/* Called with dri->mutex held */
+static void
+gbm_dri_bo_cache_trim(struct gbm_dri_device *dri, int64_t now)
+{
+   list_for_each_entry_safe_rev(struct gbm_dri_bo, bo, &dri->bo_cache,
+                                cache_link) {
+      if (dri->bo_cache_count <= GBM_DRI_BO_CACHE_MAX &&
+          now - bo->free_time < GBM_DRI_BO_CACHE_TIMEOUT_NS)
+         break;
+
+      list_del(&bo->cache_link);
+      dri->bo_cache_count--;
+      gbm_dri_bo_free(dri, bo);
+   }
+}
+
+static struct gbm_dri_bo *
+gbm_dri_bo_cache_get(struct gbm_dri_device *dri,
+                     uint32_t width, uint32_t height,
+                     uint32_t format, uint32_t usage,
+                     const uint64_t *modifiers,
+                     const unsigned int count)
+{
+   struct gbm_dri_bo *found = NULL;
+
+   mtx_lock(&dri->mutex);
+
+   gbm_dri_bo_cache_trim(dri, os_time_get_nano());
+
+   list_for_each_entry(struct gbm_dri_bo, bo, &dri->bo_cache, cache_link) {
+      if (bo->base.width != width || bo->base.height != height ||
+          bo->base.format != format || bo->usage != usage)
+         continue;
+
+      if (modifiers) {
+         uint64_t modifier = gbm_dri_bo_get_modifier(&bo->base);
+         unsigned i;
+
+         for (i = 0; i < count; i++) {
+            if (modifiers[i] == modifier)
+               break;
+         }
+         if (i == count)
+            continue;
+      }
+
+      list_del(&bo->cache_link);
+      dri->bo_cache_count--;
+      found = bo;
+      break;
+   }
+
+   mtx_unlock(&dri->mutex);
+
+   return found;
+}
+
+static void
+gbm_dri_bo_destroy(struct gbm_bo *_bo)
+{
+   struct gbm_dri_device *dri = gbm_dri_device(_bo->gbm);
+   struct gbm_dri_bo *bo = gbm_dri_bo(_bo);
+
+   if (!bo->reusable) {
+      gbm_dri_bo_free(dri, bo);
+      return;
+   }
+
+   mtx_lock(&dri->mutex);
+   bo->free_time = os_time_get_nano();
+   list_add(&bo->cache_link, &dri->bo_cache);
+   dri->bo_cache_count++;
+   gbm_dri_bo_cache_trim(dri, bo->free_time);
+   mtx_unlock(&dri->mutex);
+}
+
 static struct gbm_bo *
 gbm_dri_bo_import(struct gbm_device *gbm,
                   uint32_t type, void *buffer, uint32_t usage)
@@ -1160,6 +1245,14 @@ gbm_dri_bo_create(struct gbm_device *gbm,
    if (usage & GBM_BO_USE_WRITE || dri->image == NULL)
       return create_dumb(gbm, width, height, format, usage);
 
+   bo = gbm_dri_bo_cache_get(dri, width, height, format, usage,
+                             modifiers, count);
+   if (bo) {
+      bo->base.user_data = NULL;
+      bo->base.destroy_user_data = NULL;
+      return &bo->base;
+   }
+
    bo = calloc(1, sizeof *bo);
    if (bo == NULL)
       return NULL;
@@ -1229,6 +1322,9 @@ gbm_dri_bo_create(struct gbm_device *gbm,
    dri->image->queryImage(bo->image, __DRI_IMAGE_ATTRIB_STRIDE,
                           (int *) &bo->base.stride);
 
+   bo->reusable = true;
+   bo->usage = usage;
+
    return &bo->base;
 
 failed:
@@ -1377,6 +1473,10 @@ dri_destroy(struct gbm_device *gbm)
    struct gbm_dri_device *dri = gbm_dri_device(gbm);
    unsigned i;
 
+   list_for_each_entry_safe(struct gbm_dri_bo, bo, &dri->bo_cache,
+                            cache_link)
+      gbm_dri_bo_free(dri, bo);
+
    if (dri->context)
       dri->core->destroyContext(dri->context);
 
@@ -1427,6 +1527,7 @@ dri_device_create(int fd)
    dri->num_visuals = ARRAY_SIZE(gbm_dri_visuals_table);
 
    mtx_init(&dri->mutex, mtx_plain);
+   list_inithead(&dri->bo_cache);
 
    force_sw = env_var_as_boolean("GBM_ALWAYS_SOFTWARE", false);
    if (!force_sw) {
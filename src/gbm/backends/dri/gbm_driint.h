@@ -33,6 +33,7 @@
 #include <sys/mman.h>
 #include "gbmint.h"
 #include "c11/threads.h"
+#include "util/list.h"
 
 #include <GL/gl.h> /* dri_interface needs GL types */
 #include "GL/internal/dri_interface.h"
@@ -111,6 +112,12 @@ struct gbm_dri_device {
 
    const struct gbm_dri_visual *visual_table;
    int num_visuals;
+
+   /* Recently destroyed BOs kept around for reuse, most recent first.
+    * Protected by mutex.
+    */
+   struct list_head bo_cache;
+   unsigned bo_cache_count;
 };
 
 struct gbm_dri_bo {
@@ -121,6 +128,15 @@ struct gbm_dri_bo {
    /* Used for cursors and the swrast front BO */
    uint32_t handle, size;
    void *map;
+
+   /* BO cache state.  Only unshared BOs allocated by gbm_dri_bo_create are
+    * reused; usage is the GBM usage they were created with, or 0 if they
+    * were created from a list of modifiers.
+    */
+   bool reusable;
+   uint32_t usage;
+   int64_t free_time;
+   struct list_head cache_link;
 };
 
 struct gbm_dri_surface {
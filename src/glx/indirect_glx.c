@@ -383,6 +383,22 @@ indirect_create_context(struct glx_screen *psc,
     */
 
    bufSize = (XMaxRequestSize(psc->dpy) * 4) - sz_xGLXRenderReq;
+
+   /*
+    ** Optionally batch more commands per GLXRender request.  With the
+    ** BIG-REQUESTS extension the buffer can grow past the core request
+    ** size limit, which also makes the GLXRenderLarge chunks bigger.
+    */
+   if (getenv("LIBGL_INDIRECT_BUFFER_SIZE")) {
+      const long requested = strtol(getenv("LIBGL_INDIRECT_BUFFER_SIZE"),
+                                    NULL, 0);
+      const long maxBufSize = (XExtendedMaxRequestSize(psc->dpy) * 4)
+         - sz_xGLXRenderReq;
+
+      if (maxBufSize > bufSize && requested > bufSize)
+         bufSize = (requested < maxBufSize) ? requested : maxBufSize;
+   }
+
    gc->buf = malloc(bufSize);
    if (!gc->buf) {
       free(gc->client_state_private);
@@ -419,6 +419,91 @@ emit_element_old(GLubyte * dst,
 }
 
 
+/**
+ * Calculate the size of a single vertex for the "old" DrawArrays protocol.
+ */
+static size_t
+calculate_single_vertex_size_old(const struct array_state_vector *arrays)
+{
+   size_t single_vertex_size = 0;
+   unsigned i;
+
+
+   for (i = 0; i < arrays->num_arrays; i++) {
+      if (arrays->arrays[i].enabled) {
+         single_vertex_size += __GLX_PAD(arrays->arrays[i].element_size);
+      }
+   }
+
+   return single_vertex_size;
+}
+
+
+/**
+ * Emit \c count consecutive elements starting at \c first using "old"
+ * DrawArrays protocol.  Unlike \c emit_element_old, the data is copied one
+ * array at a time, or with a single copy if the enabled arrays are already
+ * interleaved the way the protocol lays them out.
+ */
+static GLubyte *
+emit_elements_old(GLubyte * dst,
+                  const struct array_state_vector * arrays,
+                  unsigned first, unsigned count, size_t single_vertex_size)
+{
+   const GLubyte *base = NULL;
+   GLboolean packed = GL_TRUE;
+   size_t offset = 0;
+   unsigned i, j;
+
+
+   for (i = 0; i < arrays->num_arrays; i++) {
+      const struct array_state *a = &arrays->arrays[i];
+
+      if (!a->enabled)
+         continue;
+
+      if (base == NULL)
+         base = a->data;
+
+      if (a->true_stride != single_vertex_size
+          || a->element_size != __GLX_PAD(a->element_size)
+          || (const GLubyte *) a->data != base + offset) {
+         packed = GL_FALSE;
+      }
+
+      offset += __GLX_PAD(a->element_size);
+   }
+
+   if (packed) {
+      (void) memcpy(dst, base + (size_t) first * single_vertex_size,
+                    (size_t) count * single_vertex_size);
+      return dst + (size_t) count * single_vertex_size;
+   }
+
+   offset = 0;
+   for (i = 0; i < arrays->num_arrays; i++) {
+      const struct array_state *a = &arrays->arrays[i];
+      const GLubyte *src;
+      GLubyte *d;
+
+      if (!a->enabled)
+         continue;
+
+      src = (const GLubyte *) a->data + (size_t) first * a->true_stride;
+      d = dst + offset;
+      for (j = 0; j < count; j++) {
+         (void) memcpy(d, src, a->element_size);
+         src += a->true_stride;
+         d += single_vertex_size;
+      }
+
+      offset += __GLX_PAD(a->element_size);
+   }
+
+   return dst + (size_t) count * single_vertex_size;
+}
+
+
 struct array_state *
 get_array_entry(const struct array_state_vector *arrays,
                 GLenum key, unsigned index)
@@ -595,7 +680,6 @@ emit_DrawArrays_header_old(struct glx_context * gc,
    size_t command_size;
    size_t single_vertex_size;
    const unsigned header_size = 16;
-   unsigned i;
    GLubyte *pc;
 
 
@@ -604,12 +688,7 @@ emit_DrawArrays_header_old(struct glx_context * gc,
     * it will be known whether a Render or RenderLarge command is needed.
     */
 
-   single_vertex_size = 0;
-   for (i = 0; i < arrays->num_arrays; i++) {
-      if (arrays->arrays[i].enabled) {
-         single_vertex_size += __GLX_PAD(arrays->arrays[i].element_size);
-      }
-   }
+   single_vertex_size = calculate_single_vertex_size_old(arrays);
 
    command_size = arrays->array_info_cache_size + header_size
       + (single_vertex_size * count);
@@ -702,13 +781,14 @@ emit_DrawArrays_old(GLenum mode, GLint first, GLsizei count)
 
    GLubyte *pc;
    size_t elements_per_request;
+   size_t single_vertex_size;
    unsigned total_requests = 0;
-   unsigned i;
    size_t total_sent = 0;
 
 
    pc = emit_DrawArrays_header_old(gc, arrays, &elements_per_request,
                                    &total_requests, mode, count);
+   single_vertex_size = calculate_single_vertex_size_old(arrays);
 
 
    /* Write the arrays.
@@ -717,9 +797,7 @@ emit_DrawArrays_old(GLenum mode, GLint first, GLsizei count)
    if (total_requests == 0) {
       assert(elements_per_request >= count);
 
-      for (i = 0; i < count; i++) {
-         pc = emit_element_old(pc, arrays, i + first);
-      }
+      pc = emit_elements_old(pc, arrays, first, count, single_vertex_size);
 
       assert(pc <= gc->bufEnd);
 
@@ -737,10 +815,8 @@ emit_DrawArrays_old(GLenum mode, GLint first, GLsizei count)
             elements_per_request = count;
          }
 
-         pc = gc->pc;
-         for (i = 0; i < elements_per_request; i++) {
-            pc = emit_element_old(pc, arrays, i + first);
-         }
+         pc = emit_elements_old(gc->pc, arrays, first, elements_per_request,
+                                single_vertex_size);
 
          first += elements_per_request;
 
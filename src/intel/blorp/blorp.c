@@ -240,6 +240,44 @@ blorp_compile_vs(struct blorp_context *blorp, void *mem_ctx,
    return program;
 }
 
+const unsigned *
+blorp_compile_cs(struct blorp_context *blorp, void *mem_ctx,
+                 struct nir_shader *nir,
+                 struct brw_cs_prog_data *cs_prog_data)
+{
+   const struct brw_compiler *compiler = blorp->compiler;
+
+   nir->options =
+      compiler->glsl_compiler_options[MESA_SHADER_COMPUTE].NirOptions;
+
+   memset(cs_prog_data, 0, sizeof(*cs_prog_data));
+
+   /* BLORP compute shaders take no uniforms.  The backend still appends the
+    * subgroup ID param, so give it something to reallocate that lives as
+    * long as the compile.
+    */
+   assert(exec_list_is_empty(&nir->uniforms));
+   cs_prog_data->base.nr_params = 0;
+   cs_prog_data->base.param = ralloc_array(mem_ctx, uint32_t, 0);
+
+   /* The buffers are bound at the same indices as the 3D path's surfaces */
+   cs_prog_data->base.binding_table.ssbo_start = 0;
+
+   nir = brw_preprocess_nir(compiler, nir);
+   nir_shader_gather_info(nir, nir_shader_get_entrypoint(nir));
+
+   struct brw_cs_prog_key cs_key;
+   memset(&cs_key, 0, sizeof(cs_key));
+   for (int i = 0; i < MAX_SAMPLERS; i++)
+      cs_key.tex.swizzles[i] = SWIZZLE_XYZW;
+
+   const unsigned *program =
+      brw_compile_cs(compiler, blorp->driver_ctx, mem_ctx, &cs_key,
+                     cs_prog_data, nir, -1, NULL);
+
+   return program;
+}
+
 struct blorp_sf_key {
    enum blorp_shader_type shader_type; /* Must be BLORP_SHADER_TYPE_GEN4_SF */
 
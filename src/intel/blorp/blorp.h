@@ -77,6 +77,14 @@ enum blorp_batch_flags {
     * color buffer.
     */
    BLORP_BATCH_NO_UPDATE_CLEAR_COLOR = (1 << 2),
+
+   /* This flag indicates that blorp may use a compute shader dispatched
+    * with GPGPU_WALKER instead of a 3D draw for the operations that support
+    * it.  Such operations set blorp_params::cs_prog_data and the driver's
+    * exec hook must select the GPGPU pipeline for them.  Only honored on
+    * gen9+.
+    */
+   BLORP_BATCH_USE_COMPUTE           = (1 << 3),
 };
 
 struct blorp_batch {
@@ -158,6 +166,23 @@ blorp_buffer_copy(struct blorp_batch *batch,
                   struct blorp_address dst,
                   uint64_t size);
 
+/**
+ * Fills size bytes at dst with the given dword.  The destination and size
+ * must be dword-aligned and the batch must have BLORP_BATCH_USE_COMPUTE.
+ */
+void
+blorp_buffer_fill(struct blorp_batch *batch,
+                  struct blorp_address dst,
+                  uint64_t size, uint32_t value);
+
+/**
+ * Returns true if blorp_buffer_fill() can be used with the given batch.
+ * blorp_buffer_copy() also uses the compute path in that case, as long as
+ * the copy is dword-aligned.
+ */
+bool
+blorp_buffer_use_compute(const struct blorp_batch *batch);
+
 void
 blorp_fast_clear(struct blorp_batch *batch,
                  const struct blorp_surf *surf, enum isl_format format,
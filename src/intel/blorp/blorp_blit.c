@@ -2728,6 +2728,170 @@ do_buffer_copy(struct blorp_batch *batch,
               0, 0, 0, 0, width, height);
 }
 
+/* Each invocation of the buffer compute shaders moves one vec4 */
+#define BLORP_BUFFER_CS_GROUP_SIZE 64
+#define BLORP_BUFFER_CS_GROUP_BYTES (BLORP_BUFFER_CS_GROUP_SIZE * 16)
+
+/* Raw buffer surfaces are limited to 2^30 bytes */
+#define BLORP_BUFFER_CS_MAX_SIZE (1u << 30)
+
+struct blorp_buffer_cs_key
+{
+   enum blorp_shader_type shader_type; /* BLORP_SHADER_TYPE_BUFFER_*_CS */
+};
+
+static nir_ssa_def *
+blorp_nir_load_buffer(nir_builder *b, unsigned bt_index, nir_ssa_def *offset)
+{
+   nir_intrinsic_instr *load =
+      nir_intrinsic_instr_create(b->shader, nir_intrinsic_load_ssbo);
+   load->num_components = 4;
+   load->src[0] = nir_src_for_ssa(nir_imm_int(b, bt_index));
+   load->src[1] = nir_src_for_ssa(offset);
+   nir_ssa_dest_init(&load->instr, &load->dest, 4, 32, NULL);
+   nir_builder_instr_insert(b, &load->instr);
+
+   return &load->dest.ssa;
+}
+
+static void
+blorp_nir_store_buffer(nir_builder *b, unsigned bt_index, nir_ssa_def *offset,
+                       nir_ssa_def *value)
+{
+   nir_intrinsic_instr *store =
+      nir_intrinsic_instr_create(b->shader, nir_intrinsic_store_ssbo);
+   store->num_components = value->num_components;
+   store->src[0] = nir_src_for_ssa(value);
+   store->src[1] = nir_src_for_ssa(nir_imm_int(b, bt_index));
+   store->src[2] = nir_src_for_ssa(offset);
+   nir_intrinsic_set_write_mask(store, (1 << value->num_components) - 1);
+   nir_builder_instr_insert(b, &store->instr);
+}
+
+/**
+ * Builds a compute shader which copies (or, for fills, replicates the first
+ * vec4 of) the source buffer to the destination buffer, 16 bytes per
+ * invocation.  The shader doesn't know the size of the copy: the dispatch is
+ * rounded up to whole thread groups and the bounds checking of the raw
+ * buffer surfaces drops the accesses past the end.
+ */
+static nir_shader *
+blorp_build_buffer_cs(void *mem_ctx, bool fill)
+{
+   nir_builder b;
+   nir_builder_init_simple_shader(&b, mem_ctx, MESA_SHADER_COMPUTE, NULL);
+   b.shader->info.cs.local_size[0] = BLORP_BUFFER_CS_GROUP_SIZE;
+   b.shader->info.cs.local_size[1] = 1;
+   b.shader->info.cs.local_size[2] = 1;
+   b.shader->info.num_ssbos = BLORP_NUM_BT_ENTRIES;
+
+   nir_ssa_def *group = nir_channel(&b, nir_load_work_group_id(&b), 0);
+   nir_ssa_def *index =
+      nir_iadd(&b, nir_imul(&b, group,
+                            nir_imm_int(&b, BLORP_BUFFER_CS_GROUP_SIZE)),
+                   nir_load_local_invocation_index(&b));
+   nir_ssa_def *offset = nir_ishl(&b, index, nir_imm_int(&b, 4));
+
+   nir_ssa_def *data =
+      blorp_nir_load_buffer(&b, BLORP_TEXTURE_BT_INDEX,
+                            fill ? nir_imm_int(&b, 0) : offset);
+   blorp_nir_store_buffer(&b, BLORP_RENDERBUFFER_BT_INDEX, offset, data);
+
+   return b.shader;
+}
+
+static bool
+blorp_get_buffer_cs_kernel(struct blorp_context *blorp,
+                           struct blorp_params *params,
+                           enum blorp_shader_type shader_type)
+{
+   const struct blorp_buffer_cs_key blorp_key = {
+      .shader_type = shader_type,
+   };
+
+   if (blorp->lookup_shader(blorp, &blorp_key, sizeof(blorp_key),
+                            &params->cs_prog_kernel, &params->cs_prog_data))
+      return true;
+
+   void *mem_ctx = ralloc_context(NULL);
+
+   const bool fill = shader_type == BLORP_SHADER_TYPE_BUFFER_FILL_CS;
+   nir_shader *nir = blorp_build_buffer_cs(mem_ctx, fill);
+   nir->info.name =
+      ralloc_strdup(nir, fill ? "BLORP-buffer-fill" : "BLORP-buffer-copy");
+
+   struct brw_cs_prog_data prog_data;
+   const unsigned *program =
+      blorp_compile_cs(blorp, mem_ctx, nir, &prog_data);
+
+   bool result =
+      blorp->upload_shader(blorp, &blorp_key, sizeof(blorp_key),
+                           program, prog_data.base.program_size,
+                           &prog_data.base, sizeof(prog_data),
+                           &params->cs_prog_kernel, &params->cs_prog_data);
+
+   ralloc_free(mem_ctx);
+   return result;
+}
+
+bool
+blorp_buffer_use_compute(const struct blorp_batch *batch)
+{
+   return (batch->flags & BLORP_BATCH_USE_COMPUTE) &&
+          batch->blorp->isl_dev->info->gen >= 9;
+}
+
+/**
+ * Dispatches a buffer compute shader over size bytes of dst.  A NULL
+ * src.buffer makes the exec code bind the fill value from
+ * wm_inputs.clear_color instead.
+ */
+static void
+do_buffer_cs(struct blorp_batch *batch, enum blorp_shader_type shader_type,
+             struct blorp_address src, struct blorp_address dst,
+             uint32_t size, const uint32_t fill_value[4])
+{
+   struct blorp_params params;
+   blorp_params_init(&params);
+
+   if (!blorp_get_buffer_cs_kernel(batch->blorp, &params, shader_type))
+      return;
+
+   params.cs_buffers[BLORP_RENDERBUFFER_BT_INDEX] = dst;
+   params.cs_buffer_sizes[BLORP_RENDERBUFFER_BT_INDEX] = size;
+   if (fill_value) {
+      memcpy(params.wm_inputs.clear_color, fill_value,
+             sizeof(params.wm_inputs.clear_color));
+      params.cs_buffer_sizes[BLORP_TEXTURE_BT_INDEX] = 16;
+   } else {
+      params.cs_buffers[BLORP_TEXTURE_BT_INDEX] = src;
+      params.cs_buffer_sizes[BLORP_TEXTURE_BT_INDEX] = size;
+   }
+   params.cs_groups = DIV_ROUND_UP(size, BLORP_BUFFER_CS_GROUP_BYTES);
+
+   batch->blorp->exec(batch, &params);
+}
+
+void
+blorp_buffer_fill(struct blorp_batch *batch,
+                  struct blorp_address dst,
+                  uint64_t size, uint32_t value)
+{
+   const uint32_t fill_value[4] = { value, value, value, value };
+   const struct blorp_address null_addr = { NULL, };
+
+   assert(blorp_buffer_use_compute(batch));
+   assert(dst.offset % 4 == 0 && size % 4 == 0);
+
+   while (size > 0) {
+      uint32_t fill_size = MIN2(size, BLORP_BUFFER_CS_MAX_SIZE);
+      do_buffer_cs(batch, BLORP_SHADER_TYPE_BUFFER_FILL_CS,
+                   null_addr, dst, fill_size, fill_value);
+      size -= fill_size;
+      dst.offset += fill_size;
+   }
+}
+
 void
 blorp_buffer_copy(struct blorp_batch *batch,
                   struct blorp_address src,
@@ -2737,6 +2901,22 @@ blorp_buffer_copy(struct blorp_batch *batch,
    const struct gen_device_info *devinfo = batch->blorp->isl_dev->info;
    uint64_t copy_size = size;
 
+   /* The compute path works in dwords; anything else goes through the 3D
+    * pipeline.
+    */
+   if (blorp_buffer_use_compute(batch) &&
+       src.offset % 4 == 0 && dst.offset % 4 == 0 && size % 4 == 0) {
+      while (copy_size > 0) {
+         uint32_t chunk_size = MIN2(copy_size, BLORP_BUFFER_CS_MAX_SIZE);
+         do_buffer_cs(batch, BLORP_SHADER_TYPE_BUFFER_COPY_CS,
+                      src, dst, chunk_size, NULL);
+         copy_size -= chunk_size;
+         src.offset += chunk_size;
+         dst.offset += chunk_size;
+      }
+      return;
+   }
+
    /* This is maximum possible width/height our HW can handle */
    uint64_t max_surface_dim = 1 << (devinfo->gen >= 7 ? 14 : 13);
 
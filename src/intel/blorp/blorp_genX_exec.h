@@ -1731,6 +1731,155 @@ blorp_update_clear_color(struct blorp_batch *batch,
    }
 }
 
+#if GEN_GEN >= 9
+static void
+blorp_emit_buffer_surface_state(struct blorp_batch *batch,
+                                struct blorp_address addr, uint32_t size,
+                                void *state, uint32_t state_offset)
+{
+   const struct isl_device *isl_dev = batch->blorp->isl_dev;
+
+   isl_buffer_fill_state(isl_dev, state,
+                         .address = 0,
+                         .size = size,
+                         .mocs = addr.mocs,
+                         .format = ISL_FORMAT_RAW,
+                         .stride = 1);
+
+   blorp_surface_reloc(batch, state_offset + isl_dev->ss.addr_offset,
+                       addr, 0);
+
+   blorp_flush_range(batch, state, GENX(RENDER_SURFACE_STATE_length) * 4);
+}
+
+/**
+ * Dispatches params->cs_prog_data with GPGPU_WALKER.  The driver has already
+ * selected the GPGPU pipeline.
+ */
+static void
+blorp_exec_compute(struct blorp_batch *batch,
+                   const struct blorp_params *params)
+{
+   const struct isl_device *isl_dev = batch->blorp->isl_dev;
+   const struct gen_device_info *devinfo = isl_dev->info;
+   const struct brw_cs_prog_data *cs_prog_data = params->cs_prog_data;
+
+   /* BLORP compute shaders take no uniforms so the only possible push
+    * constant is the subgroup ID, which is always the last per-thread dword.
+    */
+   assert(cs_prog_data->base.total_scratch == 0);
+   assert(cs_prog_data->push.cross_thread.dwords == 0);
+   assert(cs_prog_data->push.per_thread.dwords <= 1);
+
+   unsigned subslices = 0;
+   for (unsigned s = 0; s < devinfo->num_slices; s++)
+      subslices += devinfo->num_subslices[s];
+   subslices = MAX2(subslices, 1);
+
+   /* From the Sky Lake PRM Vol 2a, MEDIA_VFE_STATE:
+    *
+    *    "A stalling PIPE_CONTROL is required before MEDIA_VFE_STATE unless
+    *    the only bits that are changed are scoreboard related: Scoreboard
+    *    Enable, Scoreboard Type, Scoreboard Mask, Scoreboard * Delta. For
+    *    these scoreboard related states, a MEDIA_STATE_FLUSH is
+    *    sufficient."
+    */
+   blorp_emit(batch, GENX(PIPE_CONTROL), pc) {
+      pc.CommandStreamerStallEnable = true;
+      pc.StallAtPixelScoreboard = true;
+   }
+
+   blorp_emit(batch, GENX(MEDIA_VFE_STATE), vfe) {
+      vfe.MaximumNumberofThreads = devinfo->max_cs_threads * subslices - 1;
+      vfe.NumberofURBEntries = 2;
+#if GEN_GEN < 11
+      vfe.ResetGatewayTimer = true;
+#endif
+      vfe.URBEntryAllocationSize = 2;
+      vfe.CURBEAllocationSize =
+         ALIGN(cs_prog_data->push.per_thread.regs * cs_prog_data->threads, 2);
+   }
+
+   if (cs_prog_data->push.total.size > 0) {
+      const uint32_t thread_dwords = cs_prog_data->push.per_thread.size / 4;
+      uint32_t curbe_offset;
+      uint32_t *curbe_map =
+         blorp_alloc_dynamic_state(batch, cs_prog_data->push.total.size, 64,
+                                   &curbe_offset);
+      memset(curbe_map, 0, cs_prog_data->push.total.size);
+      for (unsigned t = 0; t < cs_prog_data->threads; t++) {
+         if (cs_prog_data->push.per_thread.dwords > 0)
+            curbe_map[t * thread_dwords] = t;
+      }
+      blorp_flush_range(batch, curbe_map, cs_prog_data->push.total.size);
+
+      blorp_emit(batch, GENX(MEDIA_CURBE_LOAD), curbe) {
+         curbe.CURBETotalDataLength = cs_prog_data->push.total.size;
+         curbe.CURBEDataStartAddress = curbe_offset;
+      }
+   }
+
+   uint32_t bind_offset, surface_offsets[BLORP_NUM_BT_ENTRIES];
+   void *surface_maps[BLORP_NUM_BT_ENTRIES];
+   blorp_alloc_binding_table(batch, BLORP_NUM_BT_ENTRIES,
+                             isl_dev->ss.size, isl_dev->ss.align,
+                             &bind_offset, surface_offsets, surface_maps);
+
+   for (unsigned i = 0; i < BLORP_NUM_BT_ENTRIES; i++) {
+      struct blorp_address addr = params->cs_buffers[i];
+      if (i == BLORP_TEXTURE_BT_INDEX && addr.buffer == NULL) {
+         uint32_t *data = blorp_alloc_vertex_buffer(batch, 16, &addr);
+         memcpy(data, params->wm_inputs.clear_color, 16);
+         blorp_flush_range(batch, data, 16);
+      }
+      blorp_emit_buffer_surface_state(batch, addr, params->cs_buffer_sizes[i],
+                                      surface_maps[i], surface_offsets[i]);
+   }
+
+   uint32_t idd_offset;
+   uint32_t *idd_map =
+      blorp_alloc_dynamic_state(batch,
+                                GENX(INTERFACE_DESCRIPTOR_DATA_length) * 4,
+                                64, &idd_offset);
+   struct GENX(INTERFACE_DESCRIPTOR_DATA) idd = {
+      .KernelStartPointer = params->cs_prog_kernel,
+      .BindingTablePointer = bind_offset,
+      .BindingTableEntryCount = BLORP_NUM_BT_ENTRIES,
+      .ConstantURBEntryReadLength = cs_prog_data->push.per_thread.regs,
+      .CrossThreadConstantDataReadLength = 0,
+      .NumberofThreadsinGPGPUThreadGroup = cs_prog_data->threads,
+   };
+   GENX(INTERFACE_DESCRIPTOR_DATA_pack)(NULL, idd_map, &idd);
+   blorp_flush_range(batch, idd_map,
+                     GENX(INTERFACE_DESCRIPTOR_DATA_length) * 4);
+
+   blorp_emit(batch, GENX(MEDIA_INTERFACE_DESCRIPTOR_LOAD), mid) {
+      mid.InterfaceDescriptorTotalLength =
+         GENX(INTERFACE_DESCRIPTOR_DATA_length) * 4;
+      mid.InterfaceDescriptorDataStartAddress = idd_offset;
+   }
+
+   const uint32_t group_size = cs_prog_data->local_size[0] *
+      cs_prog_data->local_size[1] * cs_prog_data->local_size[2];
+   const uint32_t remainder = group_size & (cs_prog_data->simd_size - 1);
+   const uint32_t right_mask = remainder > 0 ?
+      ~0u >> (32 - remainder) : ~0u >> (32 - cs_prog_data->simd_size);
+
+   blorp_emit(batch, GENX(GPGPU_WALKER), ggw) {
+      ggw.PredicateEnable = batch->flags & BLORP_BATCH_PREDICATE_ENABLE;
+      ggw.SIMDSize = cs_prog_data->simd_size / 16;
+      ggw.ThreadWidthCounterMaximum = cs_prog_data->threads - 1;
+      ggw.ThreadGroupIDXDimension = params->cs_groups;
+      ggw.ThreadGroupIDYDimension = 1;
+      ggw.ThreadGroupIDZDimension = 1;
+      ggw.RightExecutionMask = right_mask;
+      ggw.BottomExecutionMask = 0xffffffff;
+   }
+
+   blorp_emit(batch, GENX(MEDIA_STATE_FLUSH), msf);
+}
+#endif
+
 /**
  * \brief Execute a blit or render pass operation.
  *
@@ -1755,6 +1904,13 @@ blorp_exec(struct blorp_batch *batch, const struct blorp_params *params)
    }
 #endif
 
+#if GEN_GEN >= 9
+   if (params->cs_prog_data) {
+      blorp_exec_compute(batch, params);
+      return;
+   }
+#endif
+
    blorp_emit_vertex_buffers(batch, params);
    blorp_emit_vertex_elements(batch, params);
 
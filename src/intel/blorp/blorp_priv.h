@@ -210,6 +210,18 @@ struct blorp_params
    uint32_t wm_prog_kernel;
    struct brw_wm_prog_data *wm_prog_data;
 
+   /* Compute path.  When cs_prog_data is set, blorp dispatches cs_groups
+    * thread groups of the compute shader instead of drawing a rectangle.
+    * cs_buffers[] are bound as raw buffers at the matching binding table
+    * index.  If the BLORP_TEXTURE_BT_INDEX buffer is NULL, the exec code
+    * uploads wm_inputs.clear_color and binds that instead.
+    */
+   uint32_t cs_prog_kernel;
+   struct brw_cs_prog_data *cs_prog_data;
+   struct blorp_address cs_buffers[BLORP_NUM_BT_ENTRIES];
+   uint32_t cs_buffer_sizes[BLORP_NUM_BT_ENTRIES];
+   uint32_t cs_groups;
+
    bool use_pre_baked_binding_table;
    uint32_t pre_baked_binding_table_offset;
 };
@@ -222,6 +234,8 @@ enum blorp_shader_type {
    BLORP_SHADER_TYPE_MCS_PARTIAL_RESOLVE,
    BLORP_SHADER_TYPE_LAYER_OFFSET_VS,
    BLORP_SHADER_TYPE_GEN4_SF,
+   BLORP_SHADER_TYPE_BUFFER_COPY_CS,
+   BLORP_SHADER_TYPE_BUFFER_FILL_CS,
 };
 
 struct brw_blorp_blit_prog_key
@@ -359,6 +373,11 @@ blorp_compile_vs(struct blorp_context *blorp, void *mem_ctx,
                  struct nir_shader *nir,
                  struct brw_vs_prog_data *vs_prog_data);
 
+const unsigned *
+blorp_compile_cs(struct blorp_context *blorp, void *mem_ctx,
+                 struct nir_shader *nir,
+                 struct brw_cs_prog_data *cs_prog_data);
+
 bool
 blorp_ensure_sf_program(struct blorp_context *blorp,
                         struct blorp_params *params);
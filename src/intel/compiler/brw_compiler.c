@@ -60,7 +60,8 @@
    .lower_unpack_unorm_2x16 = true,                                           \
    .lower_unpack_unorm_4x8 = true,                                            \
    .vs_inputs_dual_locations = true,                                          \
-   .max_unroll_iterations = 32
+   .max_unroll_iterations = 32,                                               \
+   .max_partial_unroll_factor = 4
 
 static const struct nir_shader_compiler_options scalar_nir_options = {
    COMMON_OPTIONS,
@@ -591,6 +591,15 @@ brw_nir_optimize(nir_shader *nir, const struct brw_compiler *compiler,
    return nir;
 }
 
+static bool
+should_vectorize_mem_cb(nir_intrinsic_op op, unsigned align,
+                        unsigned bit_size, unsigned num_components,
+                        UNUSED void *data)
+{
+   /* Untyped surface messages take up to four dwords */
+   return bit_size == 32 && align >= 4 && num_components <= 4;
+}
+
 static unsigned
 lower_bit_size_callback(const nir_alu_instr *alu, UNUSED void *data)
 {
@@ -713,6 +722,19 @@ brw_nir_link_shaders(const struct brw_compiler *compiler,
    nir_validate_shader(*producer);
    nir_validate_shader(*consumer);
 
+   const bool p_is_scalar = compiler->scalar_stage[(*producer)->info.stage];
+   const bool c_is_scalar = compiler->scalar_stage[(*consumer)->info.stage];
+
+   if (p_is_scalar && c_is_scalar) {
+      NIR_PASS_V(*producer, nir_lower_io_to_scalar_early, nir_var_shader_out);
+      NIR_PASS_V(*consumer, nir_lower_io_to_scalar_early, nir_var_shader_in);
+      *producer = brw_nir_optimize(*producer, compiler, p_is_scalar);
+      *consumer = brw_nir_optimize(*consumer, compiler, c_is_scalar);
+   }
+
+   if (nir_link_opt_varyings(*producer, *consumer))
+      *consumer = brw_nir_optimize(*consumer, compiler, c_is_scalar);
+
    NIR_PASS_V(*producer, nir_remove_dead_variables, nir_var_shader_out);
    NIR_PASS_V(*consumer, nir_remove_dead_variables, nir_var_shader_in);
 
@@ -729,12 +751,7 @@ brw_nir_link_shaders(const struct brw_compiler *compiler,
       NIR_PASS_V(*consumer, nir_lower_indirect_derefs,
                  brw_nir_no_indirect_mask(compiler, (*consumer)->info.stage));
 
-      const bool p_is_scalar =
-         compiler->scalar_stage[(*producer)->info.stage];
       *producer = brw_nir_optimize(*producer, compiler, p_is_scalar);
-
-      const bool c_is_scalar =
-         compiler->scalar_stage[(*consumer)->info.stage];
       *consumer = brw_nir_optimize(*consumer, compiler, c_is_scalar);
    }
 }
@@ -764,6 +781,9 @@ brw_postprocess_nir(nir_shader *nir, const struct brw_compiler *compiler,
 
    nir = brw_nir_optimize(nir, compiler, is_scalar);
 
+   if (is_scalar)
+      OPT(nir_opt_load_store_vectorize, should_vectorize_mem_cb, NULL);
+
    if (devinfo->gen >= 6) {
       /* Try and fuse multiply-adds */
       OPT(brw_nir_opt_peephole_ffma);
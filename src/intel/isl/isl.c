@@ -24,8 +24,11 @@
 #include <assert.h>
 #include <stdarg.h>
 #include <stdio.h>
+#include <string.h>
 
 #include "genxml/genX_bits.h"
+#include "util/hash_table.h"
+#include "util/u_atomic.h"
 
 #include "isl.h"
 #include "isl_gen4.h"
@@ -48,11 +51,14 @@ __isl_finishme(const char *file, int line, const char *fmt, ...)
    fprintf(stderr, "%s:%d: FINISHME: %s\n", file, line, buf);
 }
 
+static uint32_t isl_next_device_id;
+
 void
 isl_device_init(struct isl_device *dev,
                 const struct gen_device_info *info,
                 bool has_bit6_swizzling)
 {
+   dev->id = p_atomic_inc_return(&isl_next_device_id);
    dev->info = info;
    dev->use_separate_stencil = ISL_DEV_GEN(dev) >= 6;
    dev->has_bit6_swizzling = has_bit6_swizzling;
@@ -1404,10 +1410,10 @@ isl_calc_row_pitch(const struct isl_device *dev,
    return true;
 }
 
-bool
-isl_surf_init_s(const struct isl_device *dev,
-                struct isl_surf *surf,
-                const struct isl_surf_init_info *restrict info)
+static bool
+isl_surf_init_uncached(const struct isl_device *dev,
+                       struct isl_surf *surf,
+                       const struct isl_surf_init_info *restrict info)
 {
    const struct isl_format_layout *fmtl = isl_format_get_layout(info->format);
 
@@ -1548,6 +1554,84 @@ isl_surf_init_s(const struct isl_device *dev,
    return true;
 }
 
+/**
+ * Applications often create many images of the same shape, e.g. pools of
+ * render targets. The layout only depends on the device and the
+ * isl_surf_init_info, so the most recent ones are remembered per thread.
+ */
+#define ISL_SURF_CACHE_SIZE 16
+
+struct isl_surf_cache_entry {
+   uint32_t dev_id; /**< 0 if the entry is empty */
+   struct isl_surf_init_info info;
+   struct isl_surf surf;
+};
+
+static __thread struct isl_surf_cache_entry isl_surf_cache[ISL_SURF_CACHE_SIZE];
+
+bool
+isl_surf_init_s(const struct isl_device *dev,
+                struct isl_surf *surf,
+                const struct isl_surf_init_info *restrict info)
+{
+   struct isl_surf_cache_entry *entry;
+   struct isl_surf_init_info key;
+   uint32_t hash;
+
+   /* isl_surf_init() passes a compound literal whose padding is undefined,
+    * so copy the fields into a zeroed key before hashing and comparing.
+    */
+   memset(&key, 0, sizeof(key));
+   key.dim = info->dim;
+   key.format = info->format;
+   key.width = info->width;
+   key.height = info->height;
+   key.depth = info->depth;
+   key.levels = info->levels;
+   key.array_len = info->array_len;
+   key.samples = info->samples;
+   key.min_alignment = info->min_alignment;
+   key.row_pitch = info->row_pitch;
+   key.usage = info->usage;
+   key.tiling_flags = info->tiling_flags;
+
+   hash = _mesa_fnv32_1a_accumulate(_mesa_fnv32_1a_offset_bias, dev->id);
+   hash = _mesa_fnv32_1a_accumulate(hash, key);
+   entry = &isl_surf_cache[hash % ISL_SURF_CACHE_SIZE];
+
+   if (dev->id && entry->dev_id == dev->id &&
+       memcmp(&entry->info, &key, sizeof(key)) == 0) {
+      *surf = entry->surf;
+      return true;
+   }
+
+   if (!isl_surf_init_uncached(dev, surf, &key))
+      return false;
+
+   if (dev->id) {
+      entry->dev_id = dev->id;
+      entry->info = key;
+      entry->surf = *surf;
+   }
+
+   return true;
+}
+
+bool
+isl_surf_init_batch(const struct isl_device *dev, uint32_t count,
+                    struct isl_surf *surfs,
+                    const struct isl_surf_init_info *infos)
+{
+   bool ok = true;
+
+   for (uint32_t i = 0; i < count; i++) {
+      /* Identical descriptions in the batch hit the cache. */
+      ok &= isl_surf_init_s(dev, &surfs[i], &infos[i]);
+   }
+
+   return ok;
+}
+
 void
 isl_surf_get_tile_info(const struct isl_surf *surf,
                        struct isl_tile_info *tile_info)
@@ -951,6 +951,12 @@ enum isl_msaa_layout {
 
 
 struct isl_device {
+   /**
+    * Unique to each isl_device_init() call. Identifies the device in the
+    * cache of isl_surf_init().
+    */
+   uint32_t id;
+
    const struct gen_device_info *info;
    bool use_separate_stencil;
    bool has_bit6_swizzling;
@@ -1787,6 +1793,16 @@ isl_surf_init_s(const struct isl_device *dev,
                 struct isl_surf *surf,
                 const struct isl_surf_init_info *restrict info);
 
+/**
+ * Initialize \a count surfaces, \a surfs[i] from \a infos[i].
+ *
+ * \return false if any of the surfaces couldn't be initialized.
+ */
+bool
+isl_surf_init_batch(const struct isl_device *dev, uint32_t count,
+                    struct isl_surf *surfs,
+                    const struct isl_surf_init_info *infos);
+
 void
 isl_surf_get_tile_info(const struct isl_surf *surf,
                        struct isl_tile_info *tile_info);
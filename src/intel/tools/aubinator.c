@@ -72,6 +72,7 @@ memfd_create(const char *name, unsigned int flags)
 static int option_full_decode = true;
 static int option_print_offsets = true;
 static int max_vbo_lines = -1;
+static int option_jobs = 1;
 static enum { COLOR_AUTO, COLOR_ALWAYS, COLOR_NEVER } option_color;
 
 /* state */
@@ -108,6 +109,54 @@ off_t mem_fd_len = 0;
 
 FILE *outfile;
 
+/* Parallel decoding
+ *
+ * With --jobs=N, N processes each go through the whole file, tracking
+ * memory writes, but only decode every Nth batch.  The output is split in
+ * segments, segment i being the output of batch i and everything printed
+ * before it since the previous batch.  Each job writes the segments it
+ * owns to a temporary file and records where each of them ends in an index
+ * file, which the parent uses to put the segments back in order.
+ */
+static int job_index = 0;
+static unsigned batch_count = 0;
+static FILE *job_outfile, *job_indexfile, *null_outfile;
+
+static bool
+job_owns_segment(void)
+{
+   return batch_count % option_jobs == job_index;
+}
+
+static void
+job_end_segment(void)
+{
+   if (job_owns_segment()) {
+      uint64_t end;
+
+      fflush(job_outfile);
+      end = ftello(job_outfile);
+      fwrite(&end, sizeof(end), 1, job_indexfile);
+   }
+}
+
+/**
+ * Called once a batch has been dealt with, whether it was decoded or not.
+ */
+static void
+end_batch(void)
+{
+   if (option_jobs > 1)
+      job_end_segment();
+
+   batch_count++;
+
+   if (option_jobs > 1) {
+      outfile = job_owns_segment() ? job_outfile : null_outfile;
+      batch_ctx.fp = outfile;
+   }
+}
+
 struct brw_instruction;
 
 static void
@@ -430,10 +479,13 @@ handle_trace_block(uint32_t *p)
       }
 
       (void)engine; /* TODO */
-      batch_ctx.get_bo = get_ggtt_batch_bo;
-      gen_print_batch(&batch_ctx, bo.map, bo.size, 0);
+      if (job_owns_segment()) {
+         batch_ctx.get_bo = get_ggtt_batch_bo;
+         gen_print_batch(&batch_ctx, bo.map, bo.size, 0);
+      }
 
       clear_bo_maps();
+      end_batch();
       break;
    }
 }
@@ -586,6 +638,11 @@ handle_memtrace_reg_write(uint32_t *p)
       return;
    }
 
+   if (!job_owns_segment()) {
+      end_batch();
+      return;
+   }
+
    const uint32_t pphwsp_size = 4096;
    uint32_t pphwsp_addr = context_descriptor & 0xfffff000;
    struct gen_batch_decode_bo pphwsp_bo = get_ggtt_batch_bo(NULL, pphwsp_addr);
@@ -614,6 +671,7 @@ handle_memtrace_reg_write(uint32_t *p)
    gen_print_batch(&batch_ctx, commands, ring_buffer_tail - ring_buffer_head,
                    0);
    clear_bo_maps();
+   end_batch();
 }
 
 static void
@@ -818,6 +876,106 @@ setup_pager(void)
    close(fds[1]);
 }
 
+static void
+decode_aub_file(void)
+{
+   struct aub_file *file;
+
+   mem_fd = memfd_create("phys memory", 0);
+
+   list_inithead(&maps);
+
+   file = aub_file_open(input_file);
+
+   while (aub_file_more_stuff(file) &&
+          aub_file_decode_batch(file) == AUB_ITEM_DECODE_OK);
+}
+
+/**
+ * Decode the file with option_jobs processes and write the merged output
+ * to stdout.
+ */
+static void
+decode_aub_file_in_jobs(void)
+{
+   FILE *outfiles[option_jobs], *indexfiles[option_jobs];
+   uint64_t offsets[option_jobs];
+   pid_t pids[option_jobs];
+   bool failed = false;
+   char buf[65536];
+
+   fflush(stdout);
+
+   for (int i = 0; i < option_jobs; i++) {
+      outfiles[i] = tmpfile();
+      indexfiles[i] = tmpfile();
+      if (!outfiles[i] || !indexfiles[i]) {
+         fprintf(stderr, "failed to create temporary file: %s\n",
+                 strerror(errno));
+         exit(EXIT_FAILURE);
+      }
+
+      pids[i] = fork();
+      if (pids[i] == -1) {
+         fprintf(stderr, "fork failed: %s\n", strerror(errno));
+         exit(EXIT_FAILURE);
+      }
+
+      if (pids[i] == 0) {
+         job_index = i;
+         job_outfile = outfiles[i];
+         job_indexfile = indexfiles[i];
+         null_outfile = fopen("/dev/null", "w");
+         outfile = job_owns_segment() ? job_outfile : null_outfile;
+
+         decode_aub_file();
+
+         /* The output after the last batch. */
+         job_end_segment();
+         fflush(job_outfile);
+         fflush(job_indexfile);
+         _exit(EXIT_SUCCESS);
+      }
+   }
+
+   for (int i = 0; i < option_jobs; i++) {
+      int status;
+
+      if (waitpid(pids[i], &status, 0) == -1 ||
+          !WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS)
+         failed = true;
+
+      rewind(outfiles[i]);
+      rewind(indexfiles[i]);
+      offsets[i] = 0;
+   }
+
+   if (failed)
+      fprintf(stderr, "some decoding jobs failed, output is incomplete\n");
+
+   for (unsigned segment = 0; ; segment++) {
+      const int i = segment % option_jobs;
+      uint64_t end, size;
+
+      if (fread(&end, sizeof(end), 1, indexfiles[i]) != 1)
+         break;
+
+      for (size = end - offsets[i]; size > 0; ) {
+         size_t n = fread(buf, 1, MIN2(size, sizeof(buf)), outfiles[i]);
+         if (n == 0)
+            break;
+         fwrite(buf, 1, n, stdout);
+         size -= n;
+      }
+      offsets[i] = end;
+   }
+
+   for (int i = 0; i < option_jobs; i++) {
+      fclose(outfiles[i]);
+      fclose(indexfiles[i]);
+   }
+}
+
 static void
 print_help(const char *progname, FILE *file)
 {
@@ -830,6 +988,7 @@ print_help(const char *progname, FILE *file)
            "      --color[=WHEN]     colorize the output; WHEN can be 'auto' (default\n"
            "                         if omitted), 'always', or 'never'\n"
            "      --max-vbo-lines=N  limit the number of decoded VBO lines\n"
+           "      --jobs=N           decode batches with N processes in parallel\n"
            "      --no-pager         don't launch pager\n"
            "      --no-offsets       don't print instruction offsets\n"
            "      --xml=DIR          load hardware xml description from directory DIR\n",
@@ -838,7 +997,6 @@ print_help(const char *progname, FILE *file)
 
 int main(int argc, char *argv[])
 {
-   struct aub_file *file;
    int c, i;
    bool help = false, pager = true;
    const struct option aubinator_opts[] = {
@@ -850,6 +1008,7 @@ int main(int argc, char *argv[])
       { "color",         required_argument, NULL,                          'c' },
       { "xml",           required_argument, NULL,                          'x' },
       { "max-vbo-lines", required_argument, NULL,                          'v' },
+      { "jobs",          required_argument, NULL,                          'j' },
       { NULL,            0,                 NULL,                          0 }
    };
 
@@ -887,6 +1046,13 @@ int main(int argc, char *argv[])
       case 'v':
          max_vbo_lines = atoi(optarg);
          break;
+      case 'j':
+         option_jobs = atoi(optarg);
+         if (option_jobs < 1) {
+            fprintf(stderr, "invalid value for --jobs: %s\n", optarg);
+            exit(EXIT_FAILURE);
+         }
+         break;
       default:
          break;
       }
@@ -907,14 +1073,10 @@ int main(int argc, char *argv[])
    if (isatty(1) && pager)
       setup_pager();
 
-   mem_fd = memfd_create("phys memory", 0);
-
-   list_inithead(&maps);
-
-   file = aub_file_open(input_file);
-
-   while (aub_file_more_stuff(file) &&
-          aub_file_decode_batch(file) == AUB_ITEM_DECODE_OK);
+   if (option_jobs > 1)
+      decode_aub_file_in_jobs();
+   else
+      decode_aub_file();
 
    fflush(stdout);
    /* close the stdout which is opened to write the output */
@@ -848,6 +848,113 @@ anv_state_pool_free(struct anv_state_pool *pool, struct anv_state state)
    anv_state_pool_free_no_vg(pool, state);
 }
 
+struct anv_state_cache_block {
+   struct anv_state block;
+
+   /* The next free block */
+   struct anv_state_cache_block *next;
+};
+
+VkResult
+anv_state_cache_init(struct anv_state_cache *cache,
+                     struct anv_state_pool *state_pool,
+                     uint32_t block_size)
+{
+   assert(util_is_power_of_two_or_zero(block_size));
+   assert(block_size >= sizeof(struct anv_state_cache_block));
+
+   cache->state_pool = state_pool;
+   cache->block_size = block_size;
+   cache->blocks_in_use = 0;
+   cache->free_list = NULL;
+
+   if (!u_vector_init(&cache->chunks, sizeof(struct anv_state),
+                      8 * sizeof(struct anv_state)))
+      return vk_error(VK_ERROR_OUT_OF_HOST_MEMORY);
+
+   return VK_SUCCESS;
+}
+
+static void
+anv_state_cache_release_chunks(struct anv_state_cache *cache)
+{
+   struct anv_state *chunk;
+
+   assert(cache->blocks_in_use == 0);
+
+   while ((chunk = u_vector_remove(&cache->chunks)))
+      anv_state_pool_free_no_vg(cache->state_pool, *chunk);
+
+   cache->free_list = NULL;
+}
+
+void
+anv_state_cache_finish(struct anv_state_cache *cache)
+{
+   anv_state_cache_release_chunks(cache);
+   u_vector_finish(&cache->chunks);
+}
+
+/* Gives all chunks back to the state pool if none of the blocks is in use. */
+void
+anv_state_cache_trim(struct anv_state_cache *cache)
+{
+   if (cache->blocks_in_use == 0)
+      anv_state_cache_release_chunks(cache);
+}
+
+static void
+anv_state_cache_push(struct anv_state_cache *cache, struct anv_state block)
+{
+   struct anv_state_cache_block *cb = block.map;
+
+   VG_NOACCESS_WRITE(&cb->block, block);
+   VG_NOACCESS_WRITE(&cb->next, cache->free_list);
+   cache->free_list = cb;
+}
+
+struct anv_state
+anv_state_cache_alloc(struct anv_state_cache *cache)
+{
+   if (cache->free_list == NULL) {
+      struct anv_state *chunk = u_vector_add(&cache->chunks);
+      if (chunk == NULL)
+         return ANV_STATE_NULL;
+
+      *chunk = anv_state_pool_alloc_no_vg(cache->state_pool,
+                                          cache->block_size *
+                                          ANV_STATE_CACHE_CHUNK_BLOCKS,
+                                          PAGE_SIZE);
+
+      /* Push in reverse so that blocks are handed out in address order */
+      for (int i = ANV_STATE_CACHE_CHUNK_BLOCKS - 1; i >= 0; i--) {
+         struct anv_state block = {
+            .offset = chunk->offset + i * cache->block_size,
+            .alloc_size = cache->block_size,
+            .map = chunk->map + i * cache->block_size,
+         };
+         anv_state_cache_push(cache, block);
+      }
+   }
+
+   struct anv_state_cache_block *cb = cache->free_list;
+   struct anv_state block = VG_NOACCESS_READ(&cb->block);
+   cache->free_list = VG_NOACCESS_READ(&cb->next);
+   cache->blocks_in_use++;
+
+   return block;
+}
+
+void
+anv_state_cache_free(struct anv_state_cache *cache, struct anv_state state)
+{
+   assert(state.alloc_size == cache->block_size);
+   assert(cache->blocks_in_use > 0);
+
+   anv_state_cache_push(cache, state);
+   cache->blocks_in_use--;
+}
+
 struct anv_state_stream_block {
    struct anv_state block;
 
@@ -871,6 +978,7 @@ anv_state_stream_init(struct anv_state_stream *stream,
                       uint32_t block_size)
 {
    stream->state_pool = state_pool;
+   stream->cache = NULL;
    stream->block_size = block_size;
 
    stream->block = ANV_STATE_NULL;
@@ -885,6 +993,17 @@ anv_state_stream_init(struct anv_state_stream *stream,
    VG(VALGRIND_CREATE_MEMPOOL(stream, 0, false));
 }
 
+/* Like anv_state_stream_init(), but blocks of the default size come from,
+ * and go back to, the given cache instead of the state pool.
+ */
+void
+anv_state_stream_init_cached(struct anv_state_stream *stream,
+                             struct anv_state_cache *cache)
+{
+   anv_state_stream_init(stream, cache->state_pool, cache->block_size);
+   stream->cache = cache;
+}
+
 void
 anv_state_stream_finish(struct anv_state_stream *stream)
 {
@@ -893,7 +1012,10 @@ anv_state_stream_finish(struct anv_state_stream *stream)
       struct anv_state_stream_block sb = VG_NOACCESS_READ(next);
       VG(VALGRIND_MEMPOOL_FREE(stream, sb._vg_ptr));
       VG(VALGRIND_MAKE_MEM_UNDEFINED(next, stream->block_size));
-      anv_state_pool_free_no_vg(stream->state_pool, sb.block);
+      if (stream->cache && sb.block.alloc_size == stream->cache->block_size)
+         anv_state_cache_free(stream->cache, sb.block);
+      else
+         anv_state_pool_free_no_vg(stream->state_pool, sb.block);
       next = sb.next;
    }
 
@@ -915,8 +1037,12 @@ anv_state_stream_alloc(struct anv_state_stream *stream,
       if (block_size < size)
          block_size = round_to_power_of_two(size);
 
-      stream->block = anv_state_pool_alloc_no_vg(stream->state_pool,
-                                                 block_size, PAGE_SIZE);
+      if (stream->cache && block_size == stream->block_size) {
+         stream->block = anv_state_cache_alloc(stream->cache);
+      } else {
+         stream->block = anv_state_pool_alloc_no_vg(stream->state_pool,
+                                                    block_size, PAGE_SIZE);
+      }
 
       struct anv_state_stream_block *sb = stream->block.map;
       VG_NOACCESS_WRITE(&sb->block, stream->block);
@@ -745,6 +745,7 @@ anv_cmd_buffer_init_batch_bo_chain(struct anv_cmd_buffer *cmd_buffer)
 
    cmd_buffer->batch.alloc = &cmd_buffer->pool->alloc;
    cmd_buffer->batch.user_data = cmd_buffer;
+   cmd_buffer->batch_end = NULL;
 
    if (cmd_buffer->device->can_chain_batches) {
       cmd_buffer->batch.extend_cb = anv_cmd_buffer_chain_batch;
@@ -826,6 +827,7 @@ anv_cmd_buffer_reset_batch_bo_chain(struct anv_cmd_buffer *cmd_buffer)
    anv_batch_bo_start(anv_cmd_buffer_current_batch_bo(cmd_buffer),
                       &cmd_buffer->batch,
                       GEN8_MI_BATCH_BUFFER_START_length * 4);
+   cmd_buffer->batch_end = NULL;
 
    while (u_vector_length(&cmd_buffer->bt_block_states) > 1) {
       struct anv_state *bt_block = u_vector_remove(&cmd_buffer->bt_block_states);
@@ -861,7 +863,23 @@ anv_cmd_buffer_end_batch_buffer(struct anv_cmd_buffer *cmd_buffer)
       cmd_buffer->batch.end += GEN8_MI_BATCH_BUFFER_START_length * 4;
       assert(cmd_buffer->batch.end == batch_bo->bo.map + batch_bo->bo.size);
 
-      anv_batch_emit(&cmd_buffer->batch, GEN8_MI_BATCH_BUFFER_END, bbe);
+      /* With softpin, the address of every batch is known up-front, so a
+       * primary can jump straight into the next primary of the same
+       * submission without any relocation.  Leave room for that
+       * MI_BATCH_BUFFER_START and remember where it is; the final
+       * MI_BATCH_BUFFER_END is written there at submit time by
+       * anv_cmd_buffer_record_end_submit().  Command buffers that may be
+       * pending more than once can't have their tail patched.
+       */
+      if (cmd_buffer->device->instance->physicalDevice.use_softpin &&
+          !(cmd_buffer->usage_flags &
+            VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT)) {
+         cmd_buffer->batch_end = cmd_buffer->batch.next;
+         emit_batch_buffer_start(cmd_buffer, &batch_bo->bo, 0);
+      } else {
+         cmd_buffer->batch_end = NULL;
+         anv_batch_emit(&cmd_buffer->batch, GEN8_MI_BATCH_BUFFER_END, bbe);
+      }
 
       /* Round batch up to an even number of dwords. */
       if ((cmd_buffer->batch.next - cmd_buffer->batch.start) & 4)
@@ -1349,11 +1367,40 @@ relocate_cmd_buffer(struct anv_cmd_buffer *cmd_buffer,
    return true;
 }
 
+static void
+anv_cmd_buffer_record_chain_submit(struct anv_cmd_buffer *cmd_buffer_from,
+                                   struct anv_cmd_buffer *cmd_buffer_to)
+{
+   struct anv_batch_bo *first_bbo =
+      list_first_entry(&cmd_buffer_to->batch_bos, struct anv_batch_bo, link);
+
+   assert(cmd_buffer_from->batch_end != NULL);
+   assert(first_bbo->bo.flags & EXEC_OBJECT_PINNED);
+
+   /* The target is pinned, so we can write its address directly */
+   anv_pack_struct(cmd_buffer_from->batch_end, GEN8_MI_BATCH_BUFFER_START,
+                   __anv_cmd_header(GEN8_MI_BATCH_BUFFER_START),
+                   .SecondLevelBatchBuffer    = Firstlevelbatch,
+                   .AddressSpaceIndicator     = ASI_PPGTT,
+                   .BatchBufferStartAddress   = {
+                      NULL, first_bbo->bo.offset
+                   });
+}
+
+static void
+anv_cmd_buffer_record_end_submit(struct anv_cmd_buffer *cmd_buffer)
+{
+   if (cmd_buffer->batch_end == NULL)
+      return;
+
+   anv_pack_struct(cmd_buffer->batch_end, GEN8_MI_BATCH_BUFFER_END,
+                   __anv_cmd_header(GEN8_MI_BATCH_BUFFER_END));
+}
+
 static VkResult
-setup_execbuf_for_cmd_buffer(struct anv_execbuf *execbuf,
+setup_execbuf_add_cmd_buffer(struct anv_execbuf *execbuf,
                              struct anv_cmd_buffer *cmd_buffer)
 {
-   struct anv_batch *batch = &cmd_buffer->batch;
    struct anv_state_pool *ss_pool =
       &cmd_buffer->device->surface_state_pool;
 
@@ -1385,6 +1432,38 @@ setup_execbuf_for_cmd_buffer(struct anv_execbuf *execbuf,
     */
    cmd_buffer->last_ss_pool_center = ss_pool->block_pool.center_bo_offset;
 
+   return VK_SUCCESS;
+}
+
+/**
+ * Set up an execbuf running all of the given primaries back to back.
+ *
+ * More than one command buffer is only allowed with softpin: each primary
+ * ends in a MI_BATCH_BUFFER_START to the next one and the kernel sees a
+ * single batch.
+ */
+static VkResult
+setup_execbuf_for_cmd_buffers(struct anv_execbuf *execbuf,
+                              struct anv_cmd_buffer **cmd_buffers,
+                              uint32_t num_cmd_buffers)
+{
+   struct anv_cmd_buffer *cmd_buffer = cmd_buffers[0];
+   struct anv_batch *batch = &cmd_buffer->batch;
+   VkResult result;
+
+   assert(num_cmd_buffers == 1 ||
+          cmd_buffer->device->instance->physicalDevice.use_softpin);
+
+   for (uint32_t i = 0; i < num_cmd_buffers; i++) {
+      result = setup_execbuf_add_cmd_buffer(execbuf, cmd_buffers[i]);
+      if (result != VK_SUCCESS)
+         return result;
+   }
+
+   for (uint32_t i = 0; i + 1 < num_cmd_buffers; i++)
+      anv_cmd_buffer_record_chain_submit(cmd_buffers[i], cmd_buffers[i + 1]);
+   anv_cmd_buffer_record_end_submit(cmd_buffers[num_cmd_buffers - 1]);
+
    struct anv_batch_bo *first_batch_bo =
       list_first_entry(&cmd_buffer->batch_bos, struct anv_batch_bo, link);
 
@@ -1418,6 +1497,8 @@ setup_execbuf_for_cmd_buffer(struct anv_execbuf *execbuf,
     * reorder the list above as some of the indices may have changed.
     */
    if (execbuf->has_relocs) {
+      assert(num_cmd_buffers == 1);
+      struct anv_batch_bo **bbo;
       u_vector_foreach(bbo, &cmd_buffer->seen_bbos)
          anv_cmd_buffer_process_relocs(cmd_buffer, &(*bbo)->relocs);
 
@@ -1426,9 +1507,12 @@ setup_execbuf_for_cmd_buffer(struct anv_execbuf *execbuf,
 
    if (!cmd_buffer->device->info.has_llc) {
       __builtin_ia32_mfence();
-      u_vector_foreach(bbo, &cmd_buffer->seen_bbos) {
-         for (uint32_t i = 0; i < (*bbo)->length; i += CACHELINE_SIZE)
-            __builtin_ia32_clflush((*bbo)->bo.map + i);
+      for (uint32_t i = 0; i < num_cmd_buffers; i++) {
+         struct anv_batch_bo **bbo;
+         u_vector_foreach(bbo, &cmd_buffers[i]->seen_bbos) {
+            for (uint32_t j = 0; j < (*bbo)->length; j += CACHELINE_SIZE)
+               __builtin_ia32_clflush((*bbo)->bo.map + j);
+         }
       }
    }
 
@@ -1512,7 +1596,8 @@ setup_empty_execbuf(struct anv_execbuf *execbuf, struct anv_device *device)
 
 VkResult
 anv_cmd_buffer_execbuf(struct anv_device *device,
-                       struct anv_cmd_buffer *cmd_buffer,
+                       struct anv_cmd_buffer **cmd_buffers,
+                       uint32_t num_cmd_buffers,
                        const VkSemaphore *in_semaphores,
                        uint32_t num_in_semaphores,
                        const VkSemaphore *out_semaphores,
@@ -1650,8 +1735,9 @@ anv_cmd_buffer_execbuf(struct anv_device *device,
       }
    }
 
-   if (cmd_buffer)
-      result = setup_execbuf_for_cmd_buffer(&execbuf, cmd_buffer);
+   if (num_cmd_buffers > 0)
+      result = setup_execbuf_for_cmd_buffers(&execbuf, cmd_buffers,
+                                             num_cmd_buffers);
    else
       result = setup_empty_execbuf(&execbuf, device);
 
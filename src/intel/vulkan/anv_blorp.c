@@ -33,8 +33,12 @@ lookup_blorp_shader(struct blorp_context *blorp,
    /* The default cache must be a real cache */
    assert(device->default_pipeline_cache.cache);
 
+   /* This also looks in the on-disk cache so that BLORP kernels survive
+    * across processes.
+    */
    struct anv_shader_bin *bin =
-      anv_pipeline_cache_search(&device->default_pipeline_cache, key, key_size);
+      anv_device_search_for_kernel(device, &device->default_pipeline_cache,
+                                   key, key_size);
    if (!bin)
       return false;
 
@@ -68,10 +72,10 @@ upload_blorp_shader(struct blorp_context *blorp,
    };
 
    struct anv_shader_bin *bin =
-      anv_pipeline_cache_upload_kernel(&device->default_pipeline_cache,
-                                       key, key_size, kernel, kernel_size,
-                                       NULL, 0,
-                                       prog_data, prog_data_size, &bind_map);
+      anv_device_upload_kernel(device, &device->default_pipeline_cache,
+                               key, key_size, kernel, kernel_size,
+                               NULL, 0,
+                               prog_data, prog_data_size, &bind_map);
 
    if (!bin)
       return false;
@@ -650,6 +654,15 @@ gcd_pow2_u64(uint64_t a, uint64_t b)
 /* This is maximum possible width/height our HW can handle */
 #define MAX_SURFACE_DIM (1ull << 14)
 
+/* Buffer-to-buffer operations don't touch any image so they can go through
+ * BLORP's compute path when the device allows it.
+ */
+static enum blorp_batch_flags
+anv_blorp_buffer_batch_flags(struct anv_cmd_buffer *cmd_buffer)
+{
+   return cmd_buffer->device->blorp_use_compute ? BLORP_BATCH_USE_COMPUTE : 0;
+}
+
 void anv_CmdCopyBuffer(
     VkCommandBuffer                             commandBuffer,
     VkBuffer                                    srcBuffer,
@@ -662,7 +675,8 @@ void anv_CmdCopyBuffer(
    ANV_FROM_HANDLE(anv_buffer, dst_buffer, dstBuffer);
 
    struct blorp_batch batch;
-   blorp_batch_init(&cmd_buffer->device->blorp, &batch, cmd_buffer, 0);
+   blorp_batch_init(&cmd_buffer->device->blorp, &batch, cmd_buffer,
+                    anv_blorp_buffer_batch_flags(cmd_buffer));
 
    for (unsigned r = 0; r < regionCount; r++) {
       struct blorp_address src = {
@@ -693,7 +707,8 @@ void anv_CmdUpdateBuffer(
    ANV_FROM_HANDLE(anv_buffer, dst_buffer, dstBuffer);
 
    struct blorp_batch batch;
-   blorp_batch_init(&cmd_buffer->device->blorp, &batch, cmd_buffer, 0);
+   blorp_batch_init(&cmd_buffer->device->blorp, &batch, cmd_buffer,
+                    anv_blorp_buffer_batch_flags(cmd_buffer));
 
    /* We can't quite grab a full block because the state stream needs a
     * little data at the top to build its linked list.
@@ -752,7 +767,8 @@ void anv_CmdFillBuffer(
    struct isl_surf isl_surf;
 
    struct blorp_batch batch;
-   blorp_batch_init(&cmd_buffer->device->blorp, &batch, cmd_buffer, 0);
+   blorp_batch_init(&cmd_buffer->device->blorp, &batch, cmd_buffer,
+                    anv_blorp_buffer_batch_flags(cmd_buffer));
 
    fillSize = anv_buffer_get_range(dst_buffer, dstOffset, fillSize);
 
@@ -766,6 +782,20 @@ void anv_CmdFillBuffer(
     */
    fillSize &= ~3ull;
 
+   if (blorp_buffer_use_compute(&batch)) {
+      struct blorp_address dst = {
+         .buffer = dst_buffer->address.bo,
+         .offset = dst_buffer->address.offset + dstOffset,
+         .mocs = cmd_buffer->device->default_mocs,
+      };
+
+      if (fillSize > 0)
+         blorp_buffer_fill(&batch, dst, fillSize, data);
+
+      blorp_batch_finish(&batch);
+      return;
+   }
+
    /* First, we compute the biggest format that can be used with the
     * given offsets and size.
     */
@@ -219,10 +219,10 @@ static VkResult anv_create_cmd_buffer(
    if (result != VK_SUCCESS)
       goto fail;
 
-   anv_state_stream_init(&cmd_buffer->surface_state_stream,
-                         &device->surface_state_pool, 4096);
-   anv_state_stream_init(&cmd_buffer->dynamic_state_stream,
-                         &device->dynamic_state_pool, 16384);
+   anv_state_stream_init_cached(&cmd_buffer->surface_state_stream,
+                                &pool->surface_state_cache);
+   anv_state_stream_init_cached(&cmd_buffer->dynamic_state_stream,
+                                &pool->dynamic_state_cache);
 
    anv_cmd_state_init(cmd_buffer);
 
@@ -312,12 +312,12 @@ anv_cmd_buffer_reset(struct anv_cmd_buffer *cmd_buffer)
    anv_cmd_state_reset(cmd_buffer);
 
    anv_state_stream_finish(&cmd_buffer->surface_state_stream);
-   anv_state_stream_init(&cmd_buffer->surface_state_stream,
-                         &cmd_buffer->device->surface_state_pool, 4096);
+   anv_state_stream_init_cached(&cmd_buffer->surface_state_stream,
+                                &cmd_buffer->pool->surface_state_cache);
 
    anv_state_stream_finish(&cmd_buffer->dynamic_state_stream);
-   anv_state_stream_init(&cmd_buffer->dynamic_state_stream,
-                         &cmd_buffer->device->dynamic_state_pool, 16384);
+   anv_state_stream_init_cached(&cmd_buffer->dynamic_state_stream,
+                                &cmd_buffer->pool->dynamic_state_cache);
    return VK_SUCCESS;
 }
 
@@ -563,6 +563,16 @@ anv_cmd_buffer_bind_descriptor_set(struct anv_cmd_buffer *cmd_buffer,
       assert(bind_point == VK_PIPELINE_BIND_POINT_GRAPHICS);
       pipe_state = &cmd_buffer->state.gfx.base;
    }
+
+   /* Descriptor sets can't be updated while they are bound, so rebinding
+    * the same set with the same layout and dynamic offsets doesn't change
+    * any binding table. Push descriptor sets are rewritten in place, so
+    * they always have to be flushed again.
+    */
+   bool changed = pipe_state->descriptors[set_index] != set ||
+                  pipe_state->layout != layout ||
+                  (pipe_state->push_descriptors[set_index] &&
+                   set == &pipe_state->push_descriptors[set_index]->set);
    pipe_state->descriptors[set_index] = set;
 
    if (dynamic_offsets) {
@@ -575,14 +585,22 @@ anv_cmd_buffer_bind_descriptor_set(struct anv_cmd_buffer *cmd_buffer,
          assert(dynamic_offset_start + set_layout->dynamic_offset_count <=
                 ARRAY_SIZE(pipe_state->dynamic_offsets));
 
-         typed_memcpy(&pipe_state->dynamic_offsets[dynamic_offset_start],
-                      *dynamic_offsets, set_layout->dynamic_offset_count);
+         if (memcmp(&pipe_state->dynamic_offsets[dynamic_offset_start],
+                    *dynamic_offsets,
+                    set_layout->dynamic_offset_count * sizeof(uint32_t))) {
+            typed_memcpy(&pipe_state->dynamic_offsets[dynamic_offset_start],
+                         *dynamic_offsets, set_layout->dynamic_offset_count);
+            changed = true;
+         }
 
          *dynamic_offsets += set_layout->dynamic_offset_count;
          *dynamic_offset_count -= set_layout->dynamic_offset_count;
       }
    }
 
+   if (!changed)
+      return;
+
    if (bind_point == VK_PIPELINE_BIND_POINT_COMPUTE) {
       cmd_buffer->state.descriptors_dirty |= VK_SHADER_STAGE_COMPUTE_BIT;
    } else {
@@ -847,6 +865,7 @@ VkResult anv_CreateCommandPool(
 {
    ANV_FROM_HANDLE(anv_device, device, _device);
    struct anv_cmd_pool *pool;
+   VkResult result;
 
    pool = vk_alloc2(&device->alloc, pAllocator, sizeof(*pool), 8,
                      VK_SYSTEM_ALLOCATION_SCOPE_OBJECT);
@@ -860,9 +879,29 @@ VkResult anv_CreateCommandPool(
 
    list_inithead(&pool->cmd_buffers);
 
+   /* Command buffers of a pool are externally synchronized, so they can
+    * share state caches that need no locking.
+    */
+   result = anv_state_cache_init(&pool->surface_state_cache,
+                                 &device->surface_state_pool, 4096);
+   if (result != VK_SUCCESS)
+      goto fail_pool;
+
+   result = anv_state_cache_init(&pool->dynamic_state_cache,
+                                 &device->dynamic_state_pool, 16384);
+   if (result != VK_SUCCESS)
+      goto fail_surface_state_cache;
+
    *pCmdPool = anv_cmd_pool_to_handle(pool);
 
    return VK_SUCCESS;
+
+ fail_surface_state_cache:
+   anv_state_cache_finish(&pool->surface_state_cache);
+ fail_pool:
+   vk_free2(&device->alloc, pAllocator, pool);
+
+   return result;
 }
 
 void anv_DestroyCommandPool(
@@ -881,6 +920,9 @@ void anv_DestroyCommandPool(
       anv_cmd_buffer_destroy(cmd_buffer);
    }
 
+   anv_state_cache_finish(&pool->surface_state_cache);
+   anv_state_cache_finish(&pool->dynamic_state_cache);
+
    vk_free2(&device->alloc, pAllocator, pool);
 }
 
@@ -896,6 +938,11 @@ VkResult anv_ResetCommandPool(
       anv_cmd_buffer_reset(cmd_buffer);
    }
 
+   if (flags & VK_COMMAND_POOL_RESET_RELEASE_RESOURCES_BIT) {
+      anv_state_cache_trim(&pool->surface_state_cache);
+      anv_state_cache_trim(&pool->dynamic_state_cache);
+   }
+
    return VK_SUCCESS;
 }
 
@@ -904,7 +951,13 @@ void anv_TrimCommandPool(
     VkCommandPool                               commandPool,
     VkCommandPoolTrimFlags                      flags)
 {
-   /* Nothing for us to do here.  Our pools stay pretty tidy. */
+   ANV_FROM_HANDLE(anv_cmd_pool, pool, commandPool);
+
+   /* The state caches can only give their memory back once none of the
+    * command buffers holds on to any of it.
+    */
+   anv_state_cache_trim(&pool->surface_state_cache);
+   anv_state_cache_trim(&pool->dynamic_state_cache);
 }
 
 /**
@@ -1709,6 +1709,19 @@ VkResult anv_CreateDevice(
     */
    device->can_chain_batches = device->info.gen >= 8;
 
+   /* With softpin, the primaries of consecutive submits that don't wait on
+    * anything in between can be chained and handed to the kernel as a
+    * single execbuf.
+    */
+   device->chain_submits = physical_device->use_softpin &&
+      env_var_as_boolean("ANV_CHAIN_SUBMITS", true);
+
+   /* On gen9+, BLORP can do buffer copies and fills with a compute shader
+    * which avoids re-emitting the whole 3D pipeline for them.
+    */
+   device->blorp_use_compute = device->info.gen >= 9 &&
+      env_var_as_boolean("ANV_BLORP_COMPUTE", true);
+
    device->robust_buffer_access = pCreateInfo->pEnabledFeatures &&
       pCreateInfo->pEnabledFeatures->robustBufferAccess;
    device->enabled_extensions = enabled_extensions;
@@ -1830,6 +1843,10 @@ VkResult anv_CreateDevice(
 
    anv_pipeline_cache_init(&device->default_pipeline_cache, device, true);
 
+   /* If this fails, the pipeline stages are compiled serially. */
+   util_queue_init(&device->compile_queue, "anv_compile", 16, 8,
+                   UTIL_QUEUE_INIT_RESIZE_IF_FULL | UTIL_QUEUE_INIT_SHARED);
+
    anv_device_init_blorp(device);
 
    anv_device_init_border_colors(device);
@@ -1883,6 +1900,9 @@ void anv_DestroyDevice(
 
    anv_device_finish_blorp(device);
 
+   if (util_queue_is_initialized(&device->compile_queue))
+      util_queue_destroy(&device->compile_queue);
+
    anv_pipeline_cache_finish(&device->default_pipeline_cache);
 
    anv_queue_finish(&device->queue);
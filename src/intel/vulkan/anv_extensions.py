@@ -125,6 +125,7 @@ EXTENSIONS = [
     Extension('VK_EXT_shader_stencil_export',             1, 'device->info.gen >= 9'),
     Extension('VK_EXT_vertex_attribute_divisor',          3, True),
     Extension('VK_EXT_post_depth_coverage',               1, 'device->info.gen >= 9'),
+    Extension('VK_GOOGLE_display_timing',                 1, 'ANV_HAS_SURFACE'),
 ]
 
 class VkVersion:
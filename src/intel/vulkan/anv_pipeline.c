@@ -93,11 +93,42 @@ static const uint64_t stage_to_debug[] = {
    [MESA_SHADER_COMPUTE] = DEBUG_CS,
 };
 
+static void
+anv_pipeline_hash_nir(struct anv_pipeline *pipeline,
+                      struct anv_shader_module *module,
+                      const char *entrypoint,
+                      gl_shader_stage stage,
+                      const VkSpecializationInfo *spec_info,
+                      unsigned char *sha1_out)
+{
+   struct mesa_sha1 ctx;
+
+   _mesa_sha1_init(&ctx);
+   _mesa_sha1_update(&ctx, module->sha1, sizeof(module->sha1));
+   _mesa_sha1_update(&ctx, entrypoint, strlen(entrypoint));
+   _mesa_sha1_update(&ctx, &stage, sizeof(stage));
+   if (spec_info) {
+      _mesa_sha1_update(&ctx, spec_info->pMapEntries,
+                        spec_info->mapEntryCount * sizeof(*spec_info->pMapEntries));
+      _mesa_sha1_update(&ctx, spec_info->pData, spec_info->dataSize);
+   }
+   if (stage == MESA_SHADER_FRAGMENT) {
+      _mesa_sha1_update(&ctx, &pipeline->sample_shading_enable,
+                        sizeof(pipeline->sample_shading_enable));
+   }
+   _mesa_sha1_final(&ctx, sha1_out);
+}
+
 /* Eventually, this will become part of anv_CreateShader.  Unfortunately,
  * we can't do that yet because we don't have the ability to copy nir.
+ *
+ * The result doesn't depend on the pipeline layout or the rest of the
+ * pipeline, so it's kept in the pipeline cache and shared by all the
+ * pipelines that use the same module, entrypoint and specialization.
  */
 static nir_shader *
 anv_shader_compile_to_nir(struct anv_pipeline *pipeline,
+                          struct anv_pipeline_cache *cache,
                           void *mem_ctx,
                           struct anv_shader_module *module,
                           const char *entrypoint_name,
@@ -111,6 +142,18 @@ anv_shader_compile_to_nir(struct anv_pipeline *pipeline,
    const nir_shader_compiler_options *nir_options =
       compiler->glsl_compiler_options[stage].NirOptions;
 
+   unsigned char sha1[20];
+   anv_pipeline_hash_nir(pipeline, module, entrypoint_name, stage, spec_info,
+                         sha1);
+
+   nir_shader *cached_nir =
+      anv_device_search_for_nir(pipeline->device, cache, nir_options,
+                                sha1, mem_ctx);
+   if (cached_nir) {
+      assert(cached_nir->info.stage == stage);
+      return cached_nir;
+   }
+
    uint32_t *spirv = (uint32_t *) module->data;
    assert(spirv[0] == SPIR_V_MAGIC_NUMBER);
    assert(module->size % 4 == 0);
@@ -224,6 +267,8 @@ anv_shader_compile_to_nir(struct anv_pipeline *pipeline,
    if (stage == MESA_SHADER_FRAGMENT)
       NIR_PASS_V(nir, anv_nir_lower_input_attachments);
 
+   anv_device_upload_nir(pipeline->device, cache, nir, sha1);
+
    return nir;
 }
 
@@ -425,6 +470,7 @@ anv_pipeline_hash_shader(struct anv_pipeline *pipeline,
 
 static nir_shader *
 anv_pipeline_compile(struct anv_pipeline *pipeline,
+                     struct anv_pipeline_cache *cache,
                      void *mem_ctx,
                      struct anv_pipeline_layout *layout,
                      struct anv_shader_module *module,
@@ -437,7 +483,7 @@ anv_pipeline_compile(struct anv_pipeline *pipeline,
    const struct brw_compiler *compiler =
       pipeline->device->instance->physicalDevice.compiler;
 
-   nir_shader *nir = anv_shader_compile_to_nir(pipeline, mem_ctx,
+   nir_shader *nir = anv_shader_compile_to_nir(pipeline, cache, mem_ctx,
                                                module, entrypoint, stage,
                                                spec_info);
    if (nir == NULL)
@@ -548,7 +594,7 @@ anv_pipeline_compile_vs(struct anv_pipeline *pipeline,
 
       void *mem_ctx = ralloc_context(NULL);
 
-      nir_shader *nir = anv_pipeline_compile(pipeline, mem_ctx, layout,
+      nir_shader *nir = anv_pipeline_compile(pipeline, cache, mem_ctx, layout,
                                              module, entrypoint,
                                              MESA_SHADER_VERTEX, spec_info,
                                              &prog_data.base.base, &map);
@@ -693,12 +739,12 @@ anv_pipeline_compile_tcs_tes(struct anv_pipeline *pipeline,
       void *mem_ctx = ralloc_context(NULL);
 
       nir_shader *tcs_nir =
-         anv_pipeline_compile(pipeline, mem_ctx, layout,
+         anv_pipeline_compile(pipeline, cache, mem_ctx, layout,
                               tcs_module, tcs_entrypoint,
                               MESA_SHADER_TESS_CTRL, tcs_spec_info,
                               &tcs_prog_data.base.base, &tcs_map);
       nir_shader *tes_nir =
-         anv_pipeline_compile(pipeline, mem_ctx, layout,
+         anv_pipeline_compile(pipeline, cache, mem_ctx, layout,
                               tes_module, tes_entrypoint,
                               MESA_SHADER_TESS_EVAL, tes_spec_info,
                               &tes_prog_data.base.base, &tes_map);
@@ -823,7 +869,7 @@ anv_pipeline_compile_gs(struct anv_pipeline *pipeline,
 
       void *mem_ctx = ralloc_context(NULL);
 
-      nir_shader *nir = anv_pipeline_compile(pipeline, mem_ctx, layout,
+      nir_shader *nir = anv_pipeline_compile(pipeline, cache, mem_ctx, layout,
                                              module, entrypoint,
                                              MESA_SHADER_GEOMETRY, spec_info,
                                              &prog_data.base.base, &map);
@@ -911,7 +957,7 @@ anv_pipeline_compile_fs(struct anv_pipeline *pipeline,
 
       void *mem_ctx = ralloc_context(NULL);
 
-      nir_shader *nir = anv_pipeline_compile(pipeline, mem_ctx, layout,
+      nir_shader *nir = anv_pipeline_compile(pipeline, cache, mem_ctx, layout,
                                              module, entrypoint,
                                              MESA_SHADER_FRAGMENT, spec_info,
                                              &prog_data.base, &map);
@@ -1072,7 +1118,7 @@ anv_pipeline_compile_cs(struct anv_pipeline *pipeline,
 
       void *mem_ctx = ralloc_context(NULL);
 
-      nir_shader *nir = anv_pipeline_compile(pipeline, mem_ctx, layout,
+      nir_shader *nir = anv_pipeline_compile(pipeline, cache, mem_ctx, layout,
                                              module, entrypoint,
                                              MESA_SHADER_COMPUTE, spec_info,
                                              &prog_data.base, &map);
@@ -1329,6 +1375,56 @@ anv_pipeline_setup_l3_config(struct anv_pipeline *pipeline, bool needs_slm)
       gen_get_l3_config_urb_size(devinfo, pipeline->urb.l3_config);
 }
 
+struct anv_pipeline_stage_job {
+   struct util_queue_fence fence;
+
+   struct anv_pipeline *pipeline;
+   struct anv_pipeline_cache *cache;
+   const VkGraphicsPipelineCreateInfo *info;
+   const VkPipelineShaderStageCreateInfo **stages;
+   struct anv_shader_module **modules;
+   gl_shader_stage stage;
+
+   VkResult result;
+};
+
+static void
+anv_pipeline_compile_stage_job(void *data, int thread_index)
+{
+   struct anv_pipeline_stage_job *job = data;
+   const VkPipelineShaderStageCreateInfo **stages = job->stages;
+   struct anv_shader_module **modules = job->modules;
+
+   switch (job->stage) {
+   case MESA_SHADER_VERTEX:
+      job->result =
+         anv_pipeline_compile_vs(job->pipeline, job->cache, job->info,
+                                 modules[MESA_SHADER_VERTEX],
+                                 stages[MESA_SHADER_VERTEX]->pName,
+                                 stages[MESA_SHADER_VERTEX]->pSpecializationInfo);
+      break;
+   case MESA_SHADER_TESS_EVAL:
+      job->result =
+         anv_pipeline_compile_tcs_tes(job->pipeline, job->cache, job->info,
+                                      modules[MESA_SHADER_TESS_CTRL],
+                                      stages[MESA_SHADER_TESS_CTRL]->pName,
+                                      stages[MESA_SHADER_TESS_CTRL]->pSpecializationInfo,
+                                      modules[MESA_SHADER_TESS_EVAL],
+                                      stages[MESA_SHADER_TESS_EVAL]->pName,
+                                      stages[MESA_SHADER_TESS_EVAL]->pSpecializationInfo);
+      break;
+   case MESA_SHADER_GEOMETRY:
+      job->result =
+         anv_pipeline_compile_gs(job->pipeline, job->cache, job->info,
+                                 modules[MESA_SHADER_GEOMETRY],
+                                 stages[MESA_SHADER_GEOMETRY]->pName,
+                                 stages[MESA_SHADER_GEOMETRY]->pSpecializationInfo);
+      break;
+   default:
+      unreachable("not a pre-rasterization stage");
+   }
+}
+
 VkResult
 anv_pipeline_init(struct anv_pipeline *pipeline,
                   struct anv_device *device,
@@ -1390,36 +1486,59 @@ anv_pipeline_init(struct anv_pipeline *pipeline,
 
    assert(pipeline->active_stages & VK_SHADER_STAGE_VERTEX_BIT);
 
-   if (modules[MESA_SHADER_VERTEX]) {
-      result = anv_pipeline_compile_vs(pipeline, cache, pCreateInfo,
-                                       modules[MESA_SHADER_VERTEX],
-                                       pStages[MESA_SHADER_VERTEX]->pName,
-                                       pStages[MESA_SHADER_VERTEX]->pSpecializationInfo);
-      if (result != VK_SUCCESS)
-         goto compile_fail;
+   /* The vertex, tessellation and geometry stages don't depend on each
+    * other, so they're compiled in parallel.  The fragment shader key needs
+    * the VUE map of the last of them, so it's compiled afterwards.
+    */
+   static const gl_shader_stage job_stages[] = {
+      MESA_SHADER_VERTEX,
+      MESA_SHADER_TESS_EVAL,
+      MESA_SHADER_GEOMETRY,
+   };
+   struct anv_pipeline_stage_job jobs[ARRAY_SIZE(job_stages)];
+   unsigned num_jobs = 0;
+
+   for (unsigned i = 0; i < ARRAY_SIZE(job_stages); i++) {
+      if (!modules[job_stages[i]])
+         continue;
+
+      jobs[num_jobs++] = (struct anv_pipeline_stage_job) {
+         .pipeline = pipeline,
+         .cache = cache,
+         .info = pCreateInfo,
+         .stages = pStages,
+         .modules = modules,
+         .stage = job_stages[i],
+         .result = VK_SUCCESS,
+      };
    }
 
-   if (modules[MESA_SHADER_TESS_EVAL]) {
-      result = anv_pipeline_compile_tcs_tes(pipeline, cache, pCreateInfo,
-                                            modules[MESA_SHADER_TESS_CTRL],
-                                            pStages[MESA_SHADER_TESS_CTRL]->pName,
-                                            pStages[MESA_SHADER_TESS_CTRL]->pSpecializationInfo,
-                                            modules[MESA_SHADER_TESS_EVAL],
-                                            pStages[MESA_SHADER_TESS_EVAL]->pName,
-                                            pStages[MESA_SHADER_TESS_EVAL]->pSpecializationInfo);
-      if (result != VK_SUCCESS)
-         goto compile_fail;
+   /* The first stage is compiled on this thread. */
+   const bool parallel = num_jobs > 1 &&
+                         util_queue_is_initialized(&device->compile_queue);
+   if (parallel) {
+      for (unsigned i = 1; i < num_jobs; i++) {
+         util_queue_fence_init(&jobs[i].fence);
+         util_queue_add_job(&device->compile_queue, &jobs[i], &jobs[i].fence,
+                            anv_pipeline_compile_stage_job, NULL);
+      }
    }
 
-   if (modules[MESA_SHADER_GEOMETRY]) {
-      result = anv_pipeline_compile_gs(pipeline, cache, pCreateInfo,
-                                       modules[MESA_SHADER_GEOMETRY],
-                                       pStages[MESA_SHADER_GEOMETRY]->pName,
-                                       pStages[MESA_SHADER_GEOMETRY]->pSpecializationInfo);
-      if (result != VK_SUCCESS)
-         goto compile_fail;
+   for (unsigned i = 0; i < num_jobs; i++) {
+      if (i > 0 && parallel) {
+         util_queue_fence_wait(&jobs[i].fence);
+         util_queue_fence_destroy(&jobs[i].fence);
+      } else {
+         anv_pipeline_compile_stage_job(&jobs[i], 0);
+      }
+
+      if (result == VK_SUCCESS)
+         result = jobs[i].result;
    }
 
+   if (result != VK_SUCCESS)
+      goto compile_fail;
+
    if (modules[MESA_SHADER_FRAGMENT]) {
       result = anv_pipeline_compile_fs(pipeline, cache, pCreateInfo,
                                        modules[MESA_SHADER_FRAGMENT],
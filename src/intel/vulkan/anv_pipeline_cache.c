@@ -22,6 +22,7 @@
  */
 
 #include "compiler/blob.h"
+#include "nir/nir_serialize.h"
 #include "util/hash_table.h"
 #include "util/debug.h"
 #include "util/disk_cache.h"
@@ -141,47 +142,70 @@ anv_shader_bin_write_to_blob(const struct anv_shader_bin *shader,
    return ok;
 }
 
-static struct anv_shader_bin *
-anv_shader_bin_create_from_blob(struct anv_device *device,
-                                struct blob_reader *blob)
+/* A serialized shader binary. All the pointers point into the blob. */
+struct anv_shader_bin_blob_data {
+   uint32_t key_size;
+   const void *key_data;
+   uint32_t kernel_size;
+   const void *kernel_data;
+   uint32_t constant_data_size;
+   const void *constant_data;
+   uint32_t prog_data_size;
+   const struct brw_stage_prog_data *prog_data;
+   const void *prog_data_param;
+   struct anv_pipeline_bind_map bind_map;
+};
+
+static bool
+anv_shader_bin_read_from_blob(struct blob_reader *blob,
+                              struct anv_shader_bin_blob_data *data)
 {
-   uint32_t key_size = blob_read_uint32(blob);
-   const void *key_data = blob_read_bytes(blob, key_size);
+   data->key_size = blob_read_uint32(blob);
+   data->key_data = blob_read_bytes(blob, data->key_size);
 
-   uint32_t kernel_size = blob_read_uint32(blob);
-   const void *kernel_data = blob_read_bytes(blob, kernel_size);
+   data->kernel_size = blob_read_uint32(blob);
+   data->kernel_data = blob_read_bytes(blob, data->kernel_size);
 
-   uint32_t constant_data_size = blob_read_uint32(blob);
-   const void *constant_data = blob_read_bytes(blob, constant_data_size);
+   data->constant_data_size = blob_read_uint32(blob);
+   data->constant_data = blob_read_bytes(blob, data->constant_data_size);
 
-   uint32_t prog_data_size = blob_read_uint32(blob);
-   const struct brw_stage_prog_data *prog_data =
-      blob_read_bytes(blob, prog_data_size);
+   data->prog_data_size = blob_read_uint32(blob);
+   data->prog_data = blob_read_bytes(blob, data->prog_data_size);
    if (blob->overrun)
-      return NULL;
-   const void *prog_data_param =
-      blob_read_bytes(blob, prog_data->nr_params * sizeof(*prog_data->param));
+      return false;
+   data->prog_data_param =
+      blob_read_bytes(blob, data->prog_data->nr_params *
+                            sizeof(*data->prog_data->param));
+
+   struct anv_pipeline_bind_map *bind_map = &data->bind_map;
+   bind_map->surface_count = blob_read_uint32(blob);
+   bind_map->sampler_count = blob_read_uint32(blob);
+   bind_map->image_count = blob_read_uint32(blob);
+   bind_map->surface_to_descriptor = (void *)
+      blob_read_bytes(blob, bind_map->surface_count *
+                            sizeof(*bind_map->surface_to_descriptor));
+   bind_map->sampler_to_descriptor = (void *)
+      blob_read_bytes(blob, bind_map->sampler_count *
+                            sizeof(*bind_map->sampler_to_descriptor));
+
+   return !blob->overrun;
+}
 
-   struct anv_pipeline_bind_map bind_map;
-   bind_map.surface_count = blob_read_uint32(blob);
-   bind_map.sampler_count = blob_read_uint32(blob);
-   bind_map.image_count = blob_read_uint32(blob);
-   bind_map.surface_to_descriptor = (void *)
-      blob_read_bytes(blob, bind_map.surface_count *
-                            sizeof(*bind_map.surface_to_descriptor));
-   bind_map.sampler_to_descriptor = (void *)
-      blob_read_bytes(blob, bind_map.sampler_count *
-                            sizeof(*bind_map.sampler_to_descriptor));
+static struct anv_shader_bin *
+anv_shader_bin_create_from_blob(struct anv_device *device,
+                                struct blob_reader *blob)
+{
+   struct anv_shader_bin_blob_data data;
 
-   if (blob->overrun)
+   if (!anv_shader_bin_read_from_blob(blob, &data))
       return NULL;
 
    return anv_shader_bin_create(device,
-                                key_data, key_size,
-                                kernel_data, kernel_size,
-                                constant_data, constant_data_size,
-                                prog_data, prog_data_size, prog_data_param,
-                                &bind_map);
+                                data.key_data, data.key_size,
+                                data.kernel_data, data.kernel_size,
+                                data.constant_data, data.constant_data_size,
+                                data.prog_data, data.prog_data_size,
+                                data.prog_data_param, &data.bind_map);
 }
 
 /* Remaining work:
@@ -211,6 +235,18 @@ shader_bin_key_compare_func(const void *void_a, const void *void_b)
    return memcmp(a->data, b->data, a->size) == 0;
 }
 
+static uint32_t
+sha1_hash_func(const void *sha1)
+{
+   return _mesa_hash_data(sha1, 20);
+}
+
+static bool
+sha1_compare_func(const void *sha1_a, const void *sha1_b)
+{
+   return memcmp(sha1_a, sha1_b, 20) == 0;
+}
+
 void
 anv_pipeline_cache_init(struct anv_pipeline_cache *cache,
                         struct anv_device *device,
@@ -218,12 +254,17 @@ anv_pipeline_cache_init(struct anv_pipeline_cache *cache,
 {
    cache->device = device;
    pthread_mutex_init(&cache->mutex, NULL);
+   cache->data = NULL;
+   cache->pending = NULL;
 
    if (cache_enabled) {
       cache->cache = _mesa_hash_table_create(NULL, shader_bin_key_hash_func,
                                              shader_bin_key_compare_func);
+      cache->nir_cache = _mesa_hash_table_create(NULL, sha1_hash_func,
+                                                 sha1_compare_func);
    } else {
       cache->cache = NULL;
+      cache->nir_cache = NULL;
    }
 }
 
@@ -243,6 +284,37 @@ anv_pipeline_cache_finish(struct anv_pipeline_cache *cache)
 
       _mesa_hash_table_destroy(cache->cache, NULL);
    }
+
+   if (cache->pending)
+      _mesa_hash_table_destroy(cache->pending, NULL);
+   vk_free(&cache->device->alloc, cache->data);
+
+   /* The serialized shaders are allocated out of the table. */
+   if (cache->nir_cache)
+      ralloc_free(cache->nir_cache);
+}
+
+/* Turns an entry of the loaded data into a shader binary, which uploads its
+ * kernel.
+ */
+static struct anv_shader_bin *
+anv_pipeline_cache_create_pending_locked(struct anv_pipeline_cache *cache,
+                                         struct hash_entry *entry)
+{
+   const char *start = entry->key, *end = entry->data;
+   struct blob_reader blob;
+
+   blob_reader_init(&blob, start, end - start);
+   _mesa_hash_table_remove(cache->pending, entry);
+
+   struct anv_shader_bin *bin =
+      anv_shader_bin_create_from_blob(cache->device, &blob);
+   if (!bin)
+      return NULL;
+
+   _mesa_hash_table_insert(cache->cache, bin->key, bin);
+
+   return bin;
 }
 
 static struct anv_shader_bin *
@@ -257,8 +329,14 @@ anv_pipeline_cache_search_locked(struct anv_pipeline_cache *cache,
    struct hash_entry *entry = _mesa_hash_table_search(cache->cache, key);
    if (entry)
       return entry->data;
-   else
-      return NULL;
+
+   if (cache->pending) {
+      entry = _mesa_hash_table_search(cache->pending, key);
+      if (entry)
+         return anv_pipeline_cache_create_pending_locked(cache, entry);
+   }
+
+   return NULL;
 }
 
 struct anv_shader_bin *
@@ -296,6 +374,12 @@ anv_pipeline_cache_add_shader_bin(struct anv_pipeline_cache *cache,
       /* Take a reference for the cache */
       anv_shader_bin_ref(bin);
       _mesa_hash_table_insert(cache->cache, bin->key, bin);
+
+      if (cache->pending) {
+         entry = _mesa_hash_table_search(cache->pending, bin->key);
+         if (entry)
+            _mesa_hash_table_remove(cache->pending, entry);
+      }
    }
 
    pthread_mutex_unlock(&cache->mutex);
@@ -396,6 +480,8 @@ anv_pipeline_cache_load(struct anv_pipeline_cache *cache,
    if (blob.overrun)
       return;
 
+   assert(!cache->data);
+
    if (header.header_size < sizeof(header))
       return;
    if (header.header_version != VK_PIPELINE_CACHE_HEADER_VERSION_ONE)
@@ -407,12 +493,40 @@ anv_pipeline_cache_load(struct anv_pipeline_cache *cache,
    if (memcmp(header.uuid, pdevice->pipeline_cache_uuid, VK_UUID_SIZE) != 0)
       return;
 
+   /* Keep a single copy of the data and only index the entries in it. The
+    * shader binaries, and the upload of their kernels, are created when the
+    * entries are looked up.
+    */
+   cache->data = vk_alloc(&device->alloc, size, 8,
+                          VK_SYSTEM_ALLOCATION_SCOPE_CACHE);
+   cache->pending = _mesa_hash_table_create(NULL, shader_bin_key_hash_func,
+                                            shader_bin_key_compare_func);
+   if (!cache->data || !cache->pending) {
+      vk_free(&device->alloc, cache->data);
+      cache->data = NULL;
+      if (cache->pending)
+         _mesa_hash_table_destroy(cache->pending, NULL);
+      cache->pending = NULL;
+      return;
+   }
+
+   memcpy(cache->data, data, size);
+   blob_reader_init(&blob, cache->data, size);
+   blob_skip_bytes(&blob, sizeof(header));
+   blob_read_uint32(&blob);
+
    for (uint32_t i = 0; i < count; i++) {
-      struct anv_shader_bin *bin =
-         anv_shader_bin_create_from_blob(device, &blob);
-      if (!bin)
+      struct anv_shader_bin_blob_data bin_data;
+
+      if (!anv_shader_bin_read_from_blob(&blob, &bin_data))
          break;
-      _mesa_hash_table_insert(cache->cache, bin->key, bin);
+
+      /* The entry starts with the size of its key, followed by the key. */
+      const struct anv_shader_bin_key *key =
+         (const void *)((const char *)bin_data.key_data - sizeof(key->size));
+
+      if (!_mesa_hash_table_search(cache->pending, key))
+         _mesa_hash_table_insert(cache->pending, key, (void *)blob.current);
    }
 }
 
@@ -499,6 +613,8 @@ VkResult anv_GetPipelineCacheData(
 
    VkResult result = VK_SUCCESS;
    if (cache->cache) {
+      pthread_mutex_lock(&cache->mutex);
+
       struct hash_entry *entry;
       hash_table_foreach(cache->cache, entry) {
          struct anv_shader_bin *shader = entry->data;
@@ -513,6 +629,30 @@ VkResult anv_GetPipelineCacheData(
 
          count++;
       }
+
+      if (cache->pending && result == VK_SUCCESS) {
+         hash_table_foreach(cache->pending, entry) {
+            const struct anv_shader_bin_key *key = entry->key;
+            const char *end = entry->data;
+
+            /* Entries are copied as they were loaded. Writing the key size
+             * as a uint32 first keeps everything after it aligned the same
+             * way.
+             */
+            size_t save_size = blob.size;
+            if (!blob_write_uint32(&blob, key->size) ||
+                !blob_write_bytes(&blob, key->data,
+                                  end - (const char *)key->data)) {
+               blob.size = save_size;
+               result = VK_INCOMPLETE;
+               break;
+            }
+
+            count++;
+         }
+      }
+
+      pthread_mutex_unlock(&cache->mutex);
    }
 
    blob_overwrite_uint32(&blob, count_offset, count);
@@ -540,12 +680,21 @@ VkResult anv_MergePipelineCaches(
       if (!src->cache)
          continue;
 
+      /* The loaded data of src isn't shared, so create what is left of it. */
       struct hash_entry *entry;
+      if (src->pending) {
+         pthread_mutex_lock(&src->mutex);
+         hash_table_foreach(src->pending, entry)
+            anv_pipeline_cache_create_pending_locked(src, entry);
+         pthread_mutex_unlock(&src->mutex);
+      }
+
       hash_table_foreach(src->cache, entry) {
          struct anv_shader_bin *bin = entry->data;
          assert(bin);
 
-         if (_mesa_hash_table_search(dst->cache, bin->key))
+         if (_mesa_hash_table_search(dst->cache, bin->key) ||
+             (dst->pending && _mesa_hash_table_search(dst->pending, bin->key)))
             continue;
 
          anv_shader_bin_ref(bin);
@@ -644,3 +793,95 @@ anv_device_upload_kernel(struct anv_device *device,
 
    return bin;
 }
+
+struct serialized_nir {
+   unsigned char sha1_key[20];
+   size_t size;
+   char data[0];
+};
+
+struct nir_shader *
+anv_device_search_for_nir(struct anv_device *device,
+                          struct anv_pipeline_cache *cache,
+                          const nir_shader_compiler_options *nir_options,
+                          const unsigned char sha1_key[20],
+                          void *mem_ctx)
+{
+   if (cache && cache->nir_cache) {
+      const struct serialized_nir *snir = NULL;
+
+      pthread_mutex_lock(&cache->mutex);
+      struct hash_entry *entry =
+         _mesa_hash_table_search(cache->nir_cache, sha1_key);
+      if (entry)
+         snir = entry->data;
+      pthread_mutex_unlock(&cache->mutex);
+
+      /* Entries are never removed while the cache is alive, so it's safe to
+       * read it without the lock.
+       */
+      if (snir) {
+         struct blob_reader blob;
+         blob_reader_init(&blob, snir->data, snir->size);
+
+         nir_shader *nir = nir_deserialize(mem_ctx, nir_options, &blob);
+         if (blob.overrun) {
+            ralloc_free(nir);
+         } else {
+            return nir;
+         }
+      }
+   }
+
+   return NULL;
+}
+
+void
+anv_device_upload_nir(struct anv_device *device,
+                      struct anv_pipeline_cache *cache,
+                      const struct nir_shader *nir,
+                      const unsigned char sha1_key[20])
+{
+   if (cache && cache->nir_cache) {
+      pthread_mutex_lock(&cache->mutex);
+      struct hash_entry *entry =
+         _mesa_hash_table_search(cache->nir_cache, sha1_key);
+      pthread_mutex_unlock(&cache->mutex);
+      if (entry)
+         return;
+
+      struct blob blob;
+      blob_init(&blob);
+
+      nir_serialize(&blob, nir);
+      if (blob.out_of_memory) {
+         blob_finish(&blob);
+         return;
+      }
+
+      pthread_mutex_lock(&cache->mutex);
+      /* Because ralloc isn't thread-safe, we have to do all this inside the
+       * lock.  We could unlock for the big memcpy but it's probably not worth
+       * the hassle.
+       */
+      entry = _mesa_hash_table_search(cache->nir_cache, sha1_key);
+      if (entry) {
+         blob_finish(&blob);
+         pthread_mutex_unlock(&cache->mutex);
+         return;
+      }
+
+      struct serialized_nir *snir =
+         ralloc_size(cache->nir_cache, sizeof(*snir) + blob.size);
+      if (snir) {
+         memcpy(snir->sha1_key, sha1_key, 20);
+         snir->size = blob.size;
+         memcpy(snir->data, blob.data, blob.size);
+
+         _mesa_hash_table_insert(cache->nir_cache, snir->sha1_key, snir);
+      }
+
+      blob_finish(&blob);
+      pthread_mutex_unlock(&cache->mutex);
+   }
+}
@@ -53,6 +53,7 @@
 #include "util/list.h"
 #include "util/set.h"
 #include "util/u_atomic.h"
+#include "util/u_queue.h"
 #include "util/u_vector.h"
 #include "util/vma.h"
 #include "vk_alloc.h"
@@ -700,11 +701,39 @@ struct anv_state_pool {
    struct anv_fixed_size_state_pool buckets[ANV_STATE_BUCKETS];
 };
 
+/* Number of blocks an anv_state_cache takes from its state pool at once */
+#define ANV_STATE_CACHE_CHUNK_BLOCKS 8
+
+struct anv_state_cache_block;
+
+/* A single-threaded cache of equally sized blocks from a state pool.  It
+ * gets its blocks from the state pool in chunks and keeps the blocks that
+ * are returned to it, so that hot allocation paths only rarely have to go
+ * to the shared pool.  Chunks only go back to the state pool once none of
+ * their blocks is in use.
+ */
+struct anv_state_cache {
+   struct anv_state_pool *state_pool;
+
+   uint32_t block_size;
+
+   /* Number of blocks that have been handed out and not returned yet */
+   uint32_t blocks_in_use;
+
+   struct anv_state_cache_block *free_list;
+
+   /* Chunks allocated from the state pool */
+   struct u_vector chunks;
+};
+
 struct anv_state_stream_block;
 
 struct anv_state_stream {
    struct anv_state_pool *state_pool;
 
+   /* Optional cache to take blocks of block_size from */
+   struct anv_state_cache *cache;
+
    /* The size of blocks to allocate from the state pool */
    uint32_t block_size;
 
@@ -742,9 +771,19 @@ struct anv_state anv_state_pool_alloc(struct anv_state_pool *pool,
                                       uint32_t state_size, uint32_t alignment);
 struct anv_state anv_state_pool_alloc_back(struct anv_state_pool *pool);
 void anv_state_pool_free(struct anv_state_pool *pool, struct anv_state state);
+VkResult anv_state_cache_init(struct anv_state_cache *cache,
+                              struct anv_state_pool *state_pool,
+                              uint32_t block_size);
+void anv_state_cache_finish(struct anv_state_cache *cache);
+void anv_state_cache_trim(struct anv_state_cache *cache);
+struct anv_state anv_state_cache_alloc(struct anv_state_cache *cache);
+void anv_state_cache_free(struct anv_state_cache *cache,
+                          struct anv_state state);
 void anv_state_stream_init(struct anv_state_stream *stream,
                            struct anv_state_pool *state_pool,
                            uint32_t block_size);
+void anv_state_stream_init_cached(struct anv_state_stream *stream,
+                                  struct anv_state_cache *cache);
 void anv_state_stream_finish(struct anv_state_stream *stream);
 struct anv_state anv_state_stream_alloc(struct anv_state_stream *stream,
                                         uint32_t size, uint32_t alignment);
@@ -928,6 +967,19 @@ struct anv_pipeline_cache {
    pthread_mutex_t                              mutex;
 
    struct hash_table *                          cache;
+
+   /* Copy of the data the cache was loaded from, and the entries in it that
+    * haven't been turned into an anv_shader_bin yet. Those are keyed by the
+    * anv_shader_bin_key in data and point to the end of the entry.
+    */
+   void *                                       data;
+   struct hash_table *                          pending;
+
+   /* Serialized NIR from spirv_to_nir, keyed by the SHA-1 of the module,
+    * entrypoint, stage and specialization. It only lives in memory and isn't
+    * part of vkGetPipelineCacheData.
+    */
+   struct hash_table *                          nir_cache;
 };
 
 struct anv_pipeline_bind_map;
@@ -966,6 +1018,22 @@ anv_device_upload_kernel(struct anv_device *device,
                          uint32_t prog_data_size,
                          const struct anv_pipeline_bind_map *bind_map);
 
+struct nir_shader;
+struct nir_shader_compiler_options;
+
+struct nir_shader *
+anv_device_search_for_nir(struct anv_device *device,
+                          struct anv_pipeline_cache *cache,
+                          const struct nir_shader_compiler_options *nir_options,
+                          const unsigned char sha1_key[20],
+                          void *mem_ctx);
+
+void
+anv_device_upload_nir(struct anv_device *device,
+                      struct anv_pipeline_cache *cache,
+                      const struct nir_shader *nir,
+                      const unsigned char sha1_key[20]);
+
 struct anv_device {
     VK_LOADER_DATA                              _loader_data;
 
@@ -979,6 +1047,8 @@ struct anv_device {
     int                                         context_id;
     int                                         fd;
     bool                                        can_chain_batches;
+    bool                                        chain_submits;
+    bool                                        blorp_use_compute;
     bool                                        robust_buffer_access;
     struct anv_device_extension_table           enabled_extensions;
     struct anv_dispatch_table                   dispatch;
@@ -1005,6 +1075,9 @@ struct anv_device {
     struct anv_pipeline_cache                   default_pipeline_cache;
     struct blorp_context                        blorp;
 
+    /* Runs the independent stages of a graphics pipeline in parallel. */
+    struct util_queue                           compile_queue;
+
     struct anv_state                            border_colors;
 
     struct anv_queue                            queue;
@@ -1739,6 +1812,8 @@ anv_pipe_flush_bits_for_access_flags(VkAccessFlags flags)
       case VK_ACCESS_TRANSFER_WRITE_BIT:
          pipe_bits |= ANV_PIPE_RENDER_TARGET_CACHE_FLUSH_BIT;
          pipe_bits |= ANV_PIPE_DEPTH_CACHE_FLUSH_BIT;
+         /* Buffer copies and fills may be done with a compute shader */
+         pipe_bits |= ANV_PIPE_DATA_CACHE_FLUSH_BIT;
          break;
       case VK_ACCESS_MEMORY_WRITE_BIT:
          pipe_bits |= ANV_PIPE_FLUSH_BITS;
@@ -2036,6 +2111,9 @@ struct anv_cmd_state {
 struct anv_cmd_pool {
    VkAllocationCallbacks                        alloc;
    struct list_head                             cmd_buffers;
+
+   struct anv_state_cache                       surface_state_cache;
+   struct anv_state_cache                       dynamic_state_cache;
 };
 
 #define ANV_CMD_BUFFER_BATCH_SIZE 8192
@@ -2065,6 +2143,13 @@ struct anv_cmd_buffer {
    struct list_head                             batch_bos;
    enum anv_cmd_buffer_exec_mode                exec_mode;
 
+   /* Location of the MI_BATCH_BUFFER_START ending a primary that can be
+    * chained to the next primary of a submission, or NULL.
+    *
+    * Set by anv_cmd_buffer_end_batch_buffer().
+    */
+   uint32_t *                                   batch_end;
+
    /* A vector of anv_batch_bo pointers for every batch or surface buffer
     * referenced by this command buffer
     *
@@ -2104,7 +2189,8 @@ void anv_cmd_buffer_add_secondary(struct anv_cmd_buffer *primary,
                                   struct anv_cmd_buffer *secondary);
 void anv_cmd_buffer_prepare_execbuf(struct anv_cmd_buffer *cmd_buffer);
 VkResult anv_cmd_buffer_execbuf(struct anv_device *device,
-                                struct anv_cmd_buffer *cmd_buffer,
+                                struct anv_cmd_buffer **cmd_buffers,
+                                uint32_t num_cmd_buffers,
                                 const VkSemaphore *in_semaphores,
                                 uint32_t num_in_semaphores,
                                 const VkSemaphore *out_semaphores,
@@ -31,6 +31,7 @@
 
 #include "anv_private.h"
 #include "vk_util.h"
+#include "util/u_cpu_trace.h"
 
 #include "genxml/gen7_pack.h"
 
@@ -114,6 +115,101 @@ anv_device_submit_simple_batch(struct anv_device *device,
    return result;
 }
 
+/* Return how many of the submits, starting with the first one, can be
+ * handed to the kernel as a single execbuf, or 0 if the first one can't be
+ * chained.  A run stops at the first submit waiting on a semaphore, since
+ * its command buffers must not start before the wait is satisfied.
+ */
+static uint32_t
+anv_queue_chainable_submits(struct anv_device *device,
+                            const VkSubmitInfo *submits,
+                            uint32_t submit_count)
+{
+   if (!device->chain_submits)
+      return 0;
+
+   uint32_t count;
+   for (count = 0; count < submit_count; count++) {
+      if (count > 0 && submits[count].waitSemaphoreCount > 0)
+         break;
+
+      /* Command buffers with SIMULTANEOUS_USE can't have their tail
+       * patched, see anv_cmd_buffer_end_batch_buffer().
+       */
+      bool chainable = true;
+      for (uint32_t j = 0; j < submits[count].commandBufferCount; j++) {
+         ANV_FROM_HANDLE(anv_cmd_buffer, cmd_buffer,
+                         submits[count].pCommandBuffers[j]);
+         if (cmd_buffer->batch_end == NULL) {
+            chainable = false;
+            break;
+         }
+      }
+
+      if (!chainable)
+         break;
+   }
+
+   return count;
+}
+
+static VkResult
+anv_queue_submit_chained(struct anv_device *device,
+                         const VkSubmitInfo *submits,
+                         uint32_t submit_count,
+                         VkFence fence)
+{
+   uint32_t num_cmd_buffers = 0, num_out_semaphores = 0;
+   for (uint32_t i = 0; i < submit_count; i++) {
+      num_cmd_buffers += submits[i].commandBufferCount;
+      num_out_semaphores += submits[i].signalSemaphoreCount;
+   }
+
+   const size_t size = num_cmd_buffers * sizeof(struct anv_cmd_buffer *) +
+                       num_out_semaphores * sizeof(VkSemaphore);
+   void *data = NULL;
+   if (size > 0) {
+      data = vk_alloc(&device->alloc, size, 8,
+                      VK_SYSTEM_ALLOCATION_SCOPE_COMMAND);
+      if (data == NULL)
+         return vk_error(VK_ERROR_OUT_OF_HOST_MEMORY);
+   }
+
+   struct anv_cmd_buffer **cmd_buffers = data;
+   VkSemaphore *out_semaphores = (VkSemaphore *)(cmd_buffers + num_cmd_buffers);
+
+   /* Signaling the semaphores of the earlier submits when the whole chain
+    * completes is later than required but still correct, since none of the
+    * following submits waits on anything.
+    */
+   uint32_t c = 0, s = 0;
+   for (uint32_t i = 0; i < submit_count; i++) {
+      for (uint32_t j = 0; j < submits[i].commandBufferCount; j++) {
+         ANV_FROM_HANDLE(anv_cmd_buffer, cmd_buffer,
+                         submits[i].pCommandBuffers[j]);
+         assert(cmd_buffer->level == VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+         assert(!anv_batch_has_error(&cmd_buffer->batch));
+         cmd_buffers[c++] = cmd_buffer;
+      }
+
+      for (uint32_t j = 0; j < submits[i].signalSemaphoreCount; j++)
+         out_semaphores[s++] = submits[i].pSignalSemaphores[j];
+   }
+
+   /* If we don't have any command buffers, anv_cmd_buffer_execbuf submits a
+    * dummy batch to give GEM something to wait on.
+    */
+   VkResult result =
+      anv_cmd_buffer_execbuf(device, cmd_buffers, num_cmd_buffers,
+                             submits[0].pWaitSemaphores,
+                             submits[0].waitSemaphoreCount,
+                             out_semaphores, num_out_semaphores, fence);
+
+   vk_free(&device->alloc, data);
+
+   return result;
+}
+
 VkResult anv_QueueSubmit(
     VkQueue                                     _queue,
     uint32_t                                    submitCount,
@@ -123,6 +219,8 @@ VkResult anv_QueueSubmit(
    ANV_FROM_HANDLE(anv_queue, queue, _queue);
    struct anv_device *device = queue->device;
 
+   MESA_TRACE_FUNC();
+
    /* Query for device status prior to submitting.  Technically, we don't need
     * to do this.  However, if we have a client that's submitting piles of
     * garbage, we would rather break as early as possible to keep the GPU
@@ -167,11 +265,27 @@ VkResult anv_QueueSubmit(
        * come up with something more efficient but this shouldn't be a
        * common case.
        */
-      result = anv_cmd_buffer_execbuf(device, NULL, NULL, 0, NULL, 0, fence);
+      result = anv_cmd_buffer_execbuf(device, NULL, 0, NULL, 0, NULL, 0,
+                                      fence);
       goto out;
    }
 
    for (uint32_t i = 0; i < submitCount; i++) {
+      uint32_t chained = anv_queue_chainable_submits(device, &pSubmits[i],
+                                                     submitCount - i);
+      if (chained > 0) {
+         VkFence chain_fence =
+            (i + chained == submitCount) ? fence : VK_NULL_HANDLE;
+
+         result = anv_queue_submit_chained(device, &pSubmits[i], chained,
+                                           chain_fence);
+         if (result != VK_SUCCESS)
+            goto out;
+
+         i += chained - 1;
+         continue;
+      }
+
       /* Fence for this submit.  NULL for all but the last one */
       VkFence submit_fence = (i == submitCount - 1) ? fence : VK_NULL_HANDLE;
 
@@ -181,7 +295,7 @@ VkResult anv_QueueSubmit(
           * come up with something more efficient but this shouldn't be a
           * common case.
           */
-         result = anv_cmd_buffer_execbuf(device, NULL,
+         result = anv_cmd_buffer_execbuf(device, NULL, 0,
                                          pSubmits[i].pWaitSemaphores,
                                          pSubmits[i].waitSemaphoreCount,
                                          pSubmits[i].pSignalSemaphores,
@@ -218,7 +332,7 @@ VkResult anv_QueueSubmit(
             num_out_semaphores = pSubmits[i].signalSemaphoreCount;
          }
 
-         result = anv_cmd_buffer_execbuf(device, cmd_buffer,
+         result = anv_cmd_buffer_execbuf(device, &cmd_buffer, 1,
                                          in_semaphores, num_in_semaphores,
                                          out_semaphores, num_out_semaphores,
                                          execbuf_fence);
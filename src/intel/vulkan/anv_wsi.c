@@ -294,3 +294,23 @@ VkResult anv_GetDeviceGroupSurfacePresentModesKHR(
 
    return VK_SUCCESS;
 }
+
+VkResult anv_GetRefreshCycleDurationGOOGLE(
+    VkDevice                                    device,
+    VkSwapchainKHR                              swapchain,
+    VkRefreshCycleDurationGOOGLE*               pDisplayTimingProperties)
+{
+   return wsi_common_get_refresh_cycle_duration(swapchain,
+                                                pDisplayTimingProperties);
+}
+
+VkResult anv_GetPastPresentationTimingGOOGLE(
+    VkDevice                                    device,
+    VkSwapchainKHR                              swapchain,
+    uint32_t*                                   pPresentationTimingCount,
+    VkPastPresentationTimingGOOGLE*             pPresentationTimings)
+{
+   return wsi_common_get_past_presentation_timing(swapchain,
+                                                  pPresentationTimingCount,
+                                                  pPresentationTimings);
+}
@@ -244,6 +244,20 @@ genX(blorp_exec)(struct blorp_batch *batch,
 
    genX(cmd_buffer_apply_pipe_flushes)(cmd_buffer);
 
+   if (params->cs_prog_data) {
+      genX(flush_pipeline_select_gpgpu)(cmd_buffer);
+
+      blorp_exec(batch, params);
+
+      /* BLORP wrote its own MEDIA_VFE_STATE, interface descriptor and CURBE
+       * so the next dispatch has to re-emit all of the compute state.
+       */
+      cmd_buffer->state.compute.pipeline_dirty = true;
+      cmd_buffer->state.descriptors_dirty |= VK_SHADER_STAGE_COMPUTE_BIT;
+      cmd_buffer->state.push_constants_dirty |= VK_SHADER_STAGE_COMPUTE_BIT;
+      return;
+   }
+
    genX(flush_pipeline_select_3d)(cmd_buffer);
 
    genX(cmd_buffer_emit_gen7_depth_flush)(cmd_buffer);
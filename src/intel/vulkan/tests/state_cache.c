@@ -0,0 +1,168 @@
+/*
+ * Copyright © 2018 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <pthread.h>
+
+#include "anv_private.h"
+
+#define NUM_THREADS 8
+#define BLOCK_SIZE 4096
+#define BLOCKS_PER_THREAD (4 * ANV_STATE_CACHE_CHUNK_BLOCKS)
+#define NUM_RUNS 64
+
+struct job {
+   pthread_t thread;
+   struct anv_state_pool *pool;
+   int32_t offsets[BLOCKS_PER_THREAD];
+} jobs[NUM_THREADS];
+
+pthread_barrier_t barrier;
+
+static void *alloc_blocks(void *_job)
+{
+   struct job *job = _job;
+   struct anv_state_cache cache;
+
+   anv_state_cache_init(&cache, job->pool, BLOCK_SIZE);
+
+   pthread_barrier_wait(&barrier);
+
+   for (unsigned i = 0; i < BLOCKS_PER_THREAD; i++) {
+      struct anv_state block = anv_state_cache_alloc(&cache);
+      assert(block.alloc_size == BLOCK_SIZE);
+      assert(block.map == job->pool->block_pool.map + block.offset);
+      job->offsets[i] = block.offset;
+   }
+   assert(u_vector_length(&cache.chunks) ==
+          BLOCKS_PER_THREAD / ANV_STATE_CACHE_CHUNK_BLOCKS);
+
+   /* Returned blocks are handed out again, most recently returned first,
+    * without touching the pool.
+    */
+   for (int i = BLOCKS_PER_THREAD - 1; i >= 0; i--) {
+      struct anv_state block = {
+         .offset = job->offsets[i],
+         .alloc_size = BLOCK_SIZE,
+         .map = job->pool->block_pool.map + job->offsets[i],
+      };
+      anv_state_cache_free(&cache, block);
+   }
+   for (unsigned i = 0; i < BLOCKS_PER_THREAD; i++) {
+      struct anv_state block = anv_state_cache_alloc(&cache);
+      assert(block.offset == job->offsets[i]);
+   }
+   assert(u_vector_length(&cache.chunks) ==
+          BLOCKS_PER_THREAD / ANV_STATE_CACHE_CHUNK_BLOCKS);
+
+   /* Nothing can be trimmed while blocks are in use */
+   anv_state_cache_trim(&cache);
+   assert(u_vector_length(&cache.chunks) ==
+          BLOCKS_PER_THREAD / ANV_STATE_CACHE_CHUNK_BLOCKS);
+
+   for (unsigned i = 0; i < BLOCKS_PER_THREAD; i++) {
+      struct anv_state block = {
+         .offset = job->offsets[i],
+         .alloc_size = BLOCK_SIZE,
+         .map = job->pool->block_pool.map + job->offsets[i],
+      };
+      anv_state_cache_free(&cache, block);
+   }
+   assert(cache.blocks_in_use == 0);
+
+   /* Keep the chunks until every thread is done so that the offsets
+    * recorded by different threads can be checked for overlap.
+    */
+   pthread_barrier_wait(&barrier);
+
+   anv_state_cache_finish(&cache);
+
+   return NULL;
+}
+
+static int compare_offsets(const void *a, const void *b)
+{
+   return *(const int32_t *)a - *(const int32_t *)b;
+}
+
+static void run_test()
+{
+   struct anv_instance instance;
+   struct anv_device device = {
+      .instance = &instance,
+   };
+   struct anv_state_pool state_pool;
+   struct anv_state_cache cache;
+   struct anv_state_stream stream;
+
+   pthread_mutex_init(&device.mutex, NULL);
+   anv_state_pool_init(&state_pool, &device, 4096, BLOCK_SIZE, 0);
+
+   pthread_barrier_init(&barrier, NULL, NUM_THREADS);
+
+   for (unsigned i = 0; i < NUM_THREADS; i++) {
+      jobs[i].pool = &state_pool;
+      pthread_create(&jobs[i].thread, NULL, alloc_blocks, &jobs[i]);
+   }
+
+   for (unsigned i = 0; i < NUM_THREADS; i++)
+      pthread_join(jobs[i].thread, NULL);
+
+   /* The blocks of different caches must not overlap */
+   static int32_t all_offsets[NUM_THREADS * BLOCKS_PER_THREAD];
+   for (unsigned i = 0; i < NUM_THREADS; i++) {
+      memcpy(all_offsets + i * BLOCKS_PER_THREAD, jobs[i].offsets,
+             sizeof(jobs[i].offsets));
+   }
+   qsort(all_offsets, ARRAY_SIZE(all_offsets), sizeof(all_offsets[0]),
+         compare_offsets);
+   for (unsigned i = 1; i < ARRAY_SIZE(all_offsets); i++)
+      assert(all_offsets[i] >= all_offsets[i - 1] + BLOCK_SIZE);
+
+   /* A stream on top of a cache gives all of its blocks back */
+   anv_state_cache_init(&cache, &state_pool, BLOCK_SIZE);
+   for (unsigned r = 0; r < 2; r++) {
+      anv_state_stream_init_cached(&stream, &cache);
+      for (unsigned i = 0; i < 3 * BLOCK_SIZE / 64; i++) {
+         struct anv_state state = anv_state_stream_alloc(&stream, 64, 64);
+         assert(state.alloc_size == 64);
+      }
+      assert(cache.blocks_in_use >= 3);
+      assert(u_vector_length(&cache.chunks) == 1);
+      anv_state_stream_finish(&stream);
+      assert(cache.blocks_in_use == 0);
+   }
+
+   anv_state_cache_trim(&cache);
+   assert(u_vector_length(&cache.chunks) == 0);
+   anv_state_cache_finish(&cache);
+
+   pthread_barrier_destroy(&barrier);
+   anv_state_pool_finish(&state_pool);
+   pthread_mutex_destroy(&device.mutex);
+}
+
+int main(int argc, char **argv)
+{
+   for (unsigned i = 0; i < NUM_RUNS; i++)
+      run_test();
+}
@@ -25,6 +25,7 @@
 #include <stdlib.h>
 #include <unistd.h>
 #include <string.h>
+#include <limits.h>
 
 #include <X11/xshmfence.h>
 #include <xcb/xcb.h>
@@ -860,6 +861,90 @@ dri3_flush_present_events(struct loader_dri3_drawable *draw)
    }
 }
 
+static void
+dri3_linear_damage_add(struct loader_dri3_buffer *buffer, const int box[4])
+{
+   int *damage = buffer->linear_damage;
+
+   if (damage[0] >= damage[2] || damage[1] >= damage[3]) {
+      memcpy(damage, box, sizeof(buffer->linear_damage));
+      return;
+   }
+
+   damage[0] = MIN2(damage[0], box[0]);
+   damage[1] = MIN2(damage[1], box[1]);
+   damage[2] = MAX2(damage[2], box[2]);
+   damage[3] = MAX2(damage[3], box[3]);
+}
+
+/** dri3_update_linear_buffer
+ *
+ * For PRIME, bring the linear buffer of the back buffer up to date before
+ * presenting it.  Each back buffer has its own linear buffer, which already
+ * holds the contents from the last time that back buffer was shown.  So
+ * rather than copying the whole frame, we only copy what was damaged since
+ * then: the swap damage of every frame presented in the meantime.
+ *
+ * The rects are x, y, width, height quadruples with y counted from the
+ * bottom, as in EGL_KHR_swap_buffers_with_damage.  No rects means the whole
+ * drawable changed.
+ */
+static void
+dri3_update_linear_buffer(struct loader_dri3_drawable *draw,
+                          struct loader_dri3_buffer *back,
+                          const int *rects, int n_rects)
+{
+   int box[4] = { 0, 0, back->width, back->height };
+
+   if (n_rects > 0) {
+      box[0] = box[1] = INT_MAX;
+      box[2] = box[3] = INT_MIN;
+
+      for (int i = 0; i < n_rects; i++) {
+         const int *rect = &rects[i * 4];
+         int y1 = (int) back->height - rect[1] - rect[3];
+
+         box[0] = MIN2(box[0], rect[0]);
+         box[1] = MIN2(box[1], y1);
+         box[2] = MAX2(box[2], rect[0] + rect[2]);
+         box[3] = MAX2(box[3], y1 + rect[3]);
+      }
+
+      box[0] = MAX2(box[0], 0);
+      box[1] = MAX2(box[1], 0);
+      box[2] = MIN2(box[2], (int) back->width);
+      box[3] = MIN2(box[3], (int) back->height);
+   }
+
+   for (int i = 0; i < LOADER_DRI3_NUM_BUFFERS; i++) {
+      struct loader_dri3_buffer *buffer = draw->buffers[i];
+
+      if (buffer && buffer != back)
+         dri3_linear_damage_add(buffer, box);
+   }
+
+   if (back->linear_valid) {
+      dri3_linear_damage_add(back, box);
+      memcpy(box, back->linear_damage, sizeof(box));
+   } else {
+      box[0] = box[1] = 0;
+      box[2] = back->width;
+      box[3] = back->height;
+   }
+
+   if (box[0] < box[2] && box[1] < box[3]) {
+      (void) loader_dri3_blit_image(draw,
+                                    back->linear_buffer,
+                                    back->image,
+                                    box[0], box[1],
+                                    box[2] - box[0], box[3] - box[1],
+                                    box[0], box[1], __BLIT_FLAG_FLUSH);
+   }
+
+   back->linear_valid = true;
+   memset(back->linear_damage, 0, sizeof(back->linear_damage));
+}
+
 /** loader_dri3_swap_buffers_msc
  *
  * Make the current back buffer visible using the present extension
@@ -868,6 +953,7 @@ int64_t
 loader_dri3_swap_buffers_msc(struct loader_dri3_drawable *draw,
                              int64_t target_msc, int64_t divisor,
                              int64_t remainder, unsigned flush_flags,
+                             const int *rects, int n_rects,
                              bool force_copy)
 {
    struct loader_dri3_buffer *back;
@@ -881,11 +967,7 @@ loader_dri3_swap_buffers_msc(struct loader_dri3_drawable *draw,
    mtx_lock(&draw->mtx);
    if (draw->is_different_gpu && back) {
       /* Update the linear buffer before presenting the pixmap */
-      (void) loader_dri3_blit_image(draw,
-                                    back->linear_buffer,
-                                    back->image,
-                                    0, 0, back->width, back->height,
-                                    0, 0, __BLIT_FLAG_FLUSH);
+      dri3_update_linear_buffer(draw, back, rects, n_rects);
    }
 
    /* If we need to preload the new back buffer, remember the source.
@@ -995,6 +1077,8 @@ loader_dri3_swap_buffers_msc(struct loader_dri3_drawable *draw,
                         0, 0, 0, 0, draw->width, draw->height);
          dri3_fence_trigger(draw->conn, new_back);
          new_back->last_swap = src->last_swap;
+         /* The pixmap no longer matches the image. */
+         new_back->linear_valid = false;
       }
 
       xcb_flush(draw->conn);
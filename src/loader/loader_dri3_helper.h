@@ -72,6 +72,13 @@ struct loader_dri3_buffer {
    uint32_t     flags;
    uint32_t     width, height;
    uint64_t     last_swap;
+
+   /* For PRIME, the bounding box (x1, y1, x2, y2) of what changed in image
+    * since linear_buffer was last brought up to date.  Only meaningful once
+    * linear_valid is set; until then the whole buffer has to be copied.
+    */
+   bool         linear_valid;
+   int          linear_damage[4];
 };
 
 
@@ -202,6 +209,7 @@ int64_t
 loader_dri3_swap_buffers_msc(struct loader_dri3_drawable *draw,
                              int64_t target_msc, int64_t divisor,
                              int64_t remainder, unsigned flush_flags,
+                             const int *rects, int n_rects,
                              bool force_copy);
 
 int
@@ -79,11 +79,13 @@ class PrintCode(gl_XML.gl_print_base):
     def printRealFooter(self):
         pass
 
-    def print_sync_call(self, func):
+    def print_sync_call(self, func, unmarshal = False):
         call = 'CALL_{0}(ctx->CurrentServerDispatch, ({1}))'.format(
             func.name, func.get_called_parameter_string())
         if func.return_type == 'void':
             out('{0};'.format(call))
+            if func.marshal_call_after and not unmarshal:
+                out(func.marshal_call_after)
         else:
             out('return {0};'.format(call))
 
@@ -206,7 +208,7 @@ class PrintCode(gl_XML.gl_print_base):
                     else:
                         out('variable_data += {0};'.format(p.size_string(False)))
 
-            self.print_sync_call(func)
+            self.print_sync_call(func, unmarshal=True)
         out('}')
 
     def validate_count_or_fallback(self, func):
@@ -257,6 +259,8 @@ class PrintCode(gl_XML.gl_print_base):
             out('if (cmd_size <= MARSHAL_MAX_CMD_SIZE) {')
             with indent():
                 self.print_async_dispatch(func)
+                if func.marshal_call_after:
+                    out(func.marshal_call_after)
                 out('return;')
             out('}')
 
@@ -287,7 +291,7 @@ class PrintCode(gl_XML.gl_print_base):
             out('switch (cmd_base->cmd_id) {')
             for func in api.functionIterateAll():
                 flavor = func.marshal_flavor()
-                if flavor in ('skip', 'sync'):
+                if flavor in ('skip', 'sync', 'custom_sync'):
                     continue
                 out('case DISPATCH_CMD_{0}:'.format(func.name))
                 with indent():
@@ -332,7 +336,7 @@ class PrintCode(gl_XML.gl_print_base):
         async_funcs = []
         for func in api.functionIterateAll():
             flavor = func.marshal_flavor()
-            if flavor in ('skip', 'custom'):
+            if flavor in ('skip', 'custom', 'custom_sync'):
                 continue
             elif flavor == 'async':
                 self.print_async_body(func)
@@ -48,8 +48,12 @@ brw_blorp_lookup_shader(struct blorp_context *blorp,
                         uint32_t *kernel_out, void *prog_data_out)
 {
    struct brw_context *brw = blorp->driver_ctx;
-   return brw_search_cache(&brw->cache, BRW_CACHE_BLORP_PROG, key, key_size,
-                           kernel_out, prog_data_out, true);
+   if (brw_search_cache(&brw->cache, BRW_CACHE_BLORP_PROG, key, key_size,
+                        kernel_out, prog_data_out, true))
+      return true;
+
+   return brw_disk_cache_upload_blorp(brw, key, key_size,
+                                      kernel_out, prog_data_out);
 }
 
 static bool
@@ -64,6 +68,8 @@ brw_blorp_upload_shader(struct blorp_context *blorp,
    brw_upload_cache(&brw->cache, BRW_CACHE_BLORP_PROG, key, key_size,
                     kernel, kernel_size, prog_data, prog_data_size,
                     kernel_out, prog_data_out);
+   brw_disk_cache_write_blorp(brw, key, key_size, kernel, kernel_size,
+                              prog_data, prog_data_size);
    return true;
 }
 
@@ -62,6 +62,7 @@
 #include "util/hash_table.h"
 #include "util/list.h"
 #include "util/u_dynarray.h"
+#include "util/u_queue.h"
 #include "util/vma.h"
 #include "brw_bufmgr.h"
 #include "brw_context.h"
@@ -158,6 +159,32 @@ struct brw_bufmgr {
    bool bo_reuse:1;
 
    uint64_t initial_kflags;
+
+   /** All cached BOs, in the order they were freed (oldest first). */
+   struct list_head cache_lru;
+
+   /** Total size of the BOs in the cache. */
+   uint64_t cache_bytes;
+
+   /**
+    * Once the cache grows past cache_high_bytes, the oldest BOs are freed
+    * until it's back down to cache_low_bytes.  Zero means no limit.
+    */
+   uint64_t cache_high_bytes;
+   uint64_t cache_low_bytes;
+
+   /** Seconds a BO may sit in the cache before it is freed. */
+   unsigned cache_max_age;
+
+   /** Allocations of a cacheable size, and how many the cache satisfied. */
+   uint64_t cache_requests;
+   uint64_t cache_hits;
+
+   /** Thread making execbuffer calls on behalf of all contexts */
+   struct util_queue submit_queue;
+
+   /** Number of batches on submit_queue that haven't been submitted yet */
+   unsigned submits_queued;
 };
 
 static int bo_set_tiling_internal(struct brw_bo *bo, uint32_t tiling_mode,
@@ -263,6 +290,20 @@ bucket_for_size(struct brw_bufmgr *bufmgr, uint64_t size)
           &bufmgr->cache_bucket[index] : NULL;
 }
 
+/**
+ * Returns the zone \p memzone allocations actually come from.
+ *
+ * A 32-bit PPGTT has nothing above 4GB, so everything lives in the low zone.
+ */
+static enum brw_memory_zone
+vma_memzone(const struct brw_bufmgr *bufmgr, enum brw_memory_zone memzone)
+{
+   if (!(bufmgr->initial_kflags & EXEC_OBJECT_SUPPORTS_48B_ADDRESS))
+      return BRW_MEMZONE_LOW_4G;
+
+   return memzone;
+}
+
 static enum brw_memory_zone
 memzone_for_address(uint64_t address)
 {
@@ -402,6 +443,8 @@ vma_alloc(struct brw_bufmgr *bufmgr,
    /* Without softpin support, we let the kernel assign addresses. */
    assert(brw_using_softpin(bufmgr));
 
+   memzone = vma_memzone(bufmgr, memzone);
+
    struct bo_cache_bucket *bucket = get_bucket_allocator(bufmgr, size);
    uint64_t addr;
 
@@ -444,12 +487,25 @@ vma_free(struct brw_bufmgr *bufmgr,
    }
 }
 
+/**
+ * Makes sure every batch using the buffer has reached the kernel, so that
+ * the kernel's view of whether it is busy is up to date.
+ */
+static void
+bo_wait_for_submit(struct brw_bo *bo)
+{
+   if (p_atomic_read(&bo->submits_queued))
+      brw_bufmgr_wait_for_submits(bo->bufmgr);
+}
+
 int
 brw_bo_busy(struct brw_bo *bo)
 {
    struct brw_bufmgr *bufmgr = bo->bufmgr;
    struct drm_i915_gem_busy busy = { .handle = bo->gem_handle };
 
+   bo_wait_for_submit(bo);
+
    int ret = drmIoctl(bufmgr->fd, DRM_IOCTL_I915_GEM_BUSY, &busy);
    if (ret == 0) {
       bo->idle = !busy.busy;
@@ -472,6 +528,23 @@ brw_bo_madvise(struct brw_bo *bo, int state)
    return madv.retained;
 }
 
+static void
+bo_cache_add(struct brw_bufmgr *bufmgr, struct bo_cache_bucket *bucket,
+             struct brw_bo *bo)
+{
+   list_addtail(&bo->head, &bucket->head);
+   list_addtail(&bo->lru, &bufmgr->cache_lru);
+   bufmgr->cache_bytes += bo->size;
+}
+
+static void
+bo_cache_remove(struct brw_bufmgr *bufmgr, struct brw_bo *bo)
+{
+   list_del(&bo->head);
+   list_del(&bo->lru);
+   bufmgr->cache_bytes -= bo->size;
+}
+
 /* drop the oldest entries that have been purged by the kernel */
 static void
 brw_bo_cache_purge_bucket(struct brw_bufmgr *bufmgr,
@@ -481,7 +554,7 @@ brw_bo_cache_purge_bucket(struct brw_bufmgr *bufmgr,
       if (brw_bo_madvise(bo, I915_MADV_DONTNEED))
          break;
 
-      list_del(&bo->head);
+      bo_cache_remove(bufmgr, bo);
       bo_free(bo);
    }
 }
@@ -529,6 +602,10 @@ bo_alloc_internal(struct brw_bufmgr *bufmgr,
    assert(bo_size);
 
    mtx_lock(&bufmgr->lock);
+
+   if (bucket != NULL)
+      bufmgr->cache_requests++;
+
    /* Get a buffer out of the cache if available */
 retry:
    alloc_from_cache = false;
@@ -541,7 +618,7 @@ retry:
           * because we are going to mmap it.
           */
          bo = LIST_ENTRY(struct brw_bo, bucket->head.prev, head);
-         list_del(&bo->head);
+         bo_cache_remove(bufmgr, bo);
          alloc_from_cache = true;
       } else {
          /* For non-render-target BOs (where we're probably
@@ -554,7 +631,7 @@ retry:
          bo = LIST_ENTRY(struct brw_bo, bucket->head.next, head);
          if (!brw_bo_busy(bo)) {
             alloc_from_cache = true;
-            list_del(&bo->head);
+            bo_cache_remove(bufmgr, bo);
          }
       }
 
@@ -582,11 +659,14 @@ retry:
    }
 
    if (alloc_from_cache) {
+      bufmgr->cache_hits++;
+
       /* If the cache BO isn't in the right memory zone, free the old
        * memory and assign it a new address.
        */
       if ((bo->kflags & EXEC_OBJECT_PINNED) &&
-          memzone != memzone_for_address(bo->gtt_offset)) {
+          vma_memzone(bufmgr, memzone) !=
+          memzone_for_address(bo->gtt_offset)) {
          vma_free(bufmgr, bo->gtt_offset, bo->size);
          bo->gtt_offset = 0ull;
       }
@@ -852,28 +932,52 @@ bo_free(struct brw_bo *bo)
    free(bo);
 }
 
-/** Frees all cached buffers significantly older than @time. */
 static void
-cleanup_bo_cache(struct brw_bufmgr *bufmgr, time_t time)
+print_cache_stats(struct brw_bufmgr *bufmgr)
 {
-   int i;
+   fprintf(stderr, "BO cache: %"PRIu64" of %"PRIu64" allocations hit "
+           "(%.1f%%), %"PRIu64" KB retained\n",
+           bufmgr->cache_hits, bufmgr->cache_requests,
+           bufmgr->cache_requests ?
+           100.0 * bufmgr->cache_hits / bufmgr->cache_requests : 0.0,
+           bufmgr->cache_bytes / 1024);
+}
 
-   if (bufmgr->time == time)
+/** Frees the oldest cached buffers until the cache is below its budget. */
+static void
+trim_bo_cache(struct brw_bufmgr *bufmgr)
+{
+   if (bufmgr->cache_high_bytes == 0 ||
+       bufmgr->cache_bytes <= bufmgr->cache_high_bytes)
       return;
 
-   for (i = 0; i < bufmgr->num_buckets; i++) {
-      struct bo_cache_bucket *bucket = &bufmgr->cache_bucket[i];
+   list_for_each_entry_safe(struct brw_bo, bo, &bufmgr->cache_lru, lru) {
+      if (bufmgr->cache_bytes <= bufmgr->cache_low_bytes)
+         break;
 
-      list_for_each_entry_safe(struct brw_bo, bo, &bucket->head, head) {
-         if (time - bo->free_time <= 1)
-            break;
+      bo_cache_remove(bufmgr, bo);
+      bo_free(bo);
+   }
+}
 
-         list_del(&bo->head);
+/** Frees all cached buffers significantly older than @time. */
+static void
+cleanup_bo_cache(struct brw_bufmgr *bufmgr, time_t time)
+{
+   if (bufmgr->time == time)
+      return;
 
-         bo_free(bo);
-      }
+   list_for_each_entry_safe(struct brw_bo, bo, &bufmgr->cache_lru, lru) {
+      if (time - bo->free_time <= bufmgr->cache_max_age)
+         break;
+
+      bo_cache_remove(bufmgr, bo);
+      bo_free(bo);
    }
 
+   if (unlikely(INTEL_DEBUG & DEBUG_BO_CACHE))
+      print_cache_stats(bufmgr);
+
    bufmgr->time = time;
 }
 
@@ -893,7 +997,8 @@ bo_unreference_final(struct brw_bo *bo, time_t time)
 
       bo->name = NULL;
 
-      list_addtail(&bo->head, &bucket->head);
+      bo_cache_add(bufmgr, bucket, bo);
+      trim_bo_cache(bufmgr);
    } else {
       bo_free(bo);
    }
@@ -1216,6 +1321,8 @@ brw_bo_subdata(struct brw_bo *bo, uint64_t offset,
 {
    struct brw_bufmgr *bufmgr = bo->bufmgr;
 
+   bo_wait_for_submit(bo);
+
    struct drm_i915_gem_pwrite pwrite = {
       .handle = bo->gem_handle,
       .offset = offset,
@@ -1276,6 +1383,8 @@ brw_bo_wait(struct brw_bo *bo, int64_t timeout_ns)
 {
    struct brw_bufmgr *bufmgr = bo->bufmgr;
 
+   bo_wait_for_submit(bo);
+
    /* If we know it's idle, don't bother with the kernel round trip */
    if (bo->idle && !bo->external)
       return 0;
@@ -1296,14 +1405,23 @@ brw_bo_wait(struct brw_bo *bo, int64_t timeout_ns)
 void
 brw_bufmgr_destroy(struct brw_bufmgr *bufmgr)
 {
+   /* The submission thread drops BO references, which takes the lock. */
+   if (util_queue_is_initialized(&bufmgr->submit_queue)) {
+      util_queue_finish(&bufmgr->submit_queue);
+      util_queue_destroy(&bufmgr->submit_queue);
+   }
+
    mtx_destroy(&bufmgr->lock);
 
+   if (unlikely(INTEL_DEBUG & DEBUG_BO_CACHE))
+      print_cache_stats(bufmgr);
+
    /* Free any cached buffer objects we were going to reuse */
    for (int i = 0; i < bufmgr->num_buckets; i++) {
       struct bo_cache_bucket *bucket = &bufmgr->cache_bucket[i];
 
       list_for_each_entry_safe(struct brw_bo, bo, &bucket->head, head) {
-         list_del(&bo->head);
+         bo_cache_remove(bufmgr, bo);
 
          bo_free(bo);
       }
@@ -1320,7 +1438,8 @@ brw_bufmgr_destroy(struct brw_bufmgr *bufmgr)
 
    if (brw_using_softpin(bufmgr)) {
       for (int z = 0; z < BRW_MEMZONE_COUNT; z++) {
-         util_vma_heap_finish(&bufmgr->vma_allocator[z]);
+         if (vma_memzone(bufmgr, z) == z)
+            util_vma_heap_finish(&bufmgr->vma_allocator[z]);
       }
    }
 
@@ -1471,6 +1590,9 @@ brw_bo_make_external(struct brw_bo *bo)
 {
    struct brw_bufmgr *bufmgr = bo->bufmgr;
 
+   /* Whoever we share it with expects our rendering to be in the kernel. */
+   bo_wait_for_submit(bo);
+
    if (!bo->external) {
       mtx_lock(&bufmgr->lock);
       if (!bo->external) {
@@ -1544,6 +1666,129 @@ brw_bufmgr_enable_reuse(struct brw_bufmgr *bufmgr)
    bufmgr->bo_reuse = true;
 }
 
+/**
+ * Bounds the buffer object cache.
+ *
+ * When the cache holds more than \p high_bytes, the least recently freed
+ * buffers are released until it is down to \p low_bytes, or to three
+ * quarters of \p high_bytes if that is zero.  A \p high_bytes of zero
+ * leaves the size unbounded.  Independently of the size, buffers
+ * are released once they have been cached for more than \p max_age seconds.
+ */
+void
+brw_bufmgr_set_cache_limits(struct brw_bufmgr *bufmgr,
+                            uint64_t high_bytes, uint64_t low_bytes,
+                            unsigned max_age)
+{
+   mtx_lock(&bufmgr->lock);
+   bufmgr->cache_high_bytes = high_bytes;
+   bufmgr->cache_low_bytes =
+      low_bytes ? MIN2(low_bytes, high_bytes) : high_bytes / 4 * 3;
+   bufmgr->cache_max_age = max_age;
+   trim_bo_cache(bufmgr);
+   mtx_unlock(&bufmgr->lock);
+}
+
+struct submit_job {
+   struct util_queue_fence fence;
+   struct brw_bufmgr *bufmgr;
+   struct drm_i915_gem_execbuffer2 execbuf;
+   struct brw_bo **exec_bos;
+};
+
+static void
+submit_job_execute(void *data, int thread_index)
+{
+   struct submit_job *job = data;
+   struct brw_bufmgr *bufmgr = job->bufmgr;
+
+   if (drmIoctl(bufmgr->fd, DRM_IOCTL_I915_GEM_EXECBUFFER2,
+                &job->execbuf) != 0) {
+      fprintf(stderr, "i965: Failed to submit batchbuffer: %s\n",
+              strerror(errno));
+      exit(1);
+   }
+
+   for (unsigned i = 0; i < job->execbuf.buffer_count; i++) {
+      p_atomic_dec(&job->exec_bos[i]->submits_queued);
+      brw_bo_unreference(job->exec_bos[i]);
+   }
+
+   p_atomic_dec(&bufmgr->submits_queued);
+}
+
+static void
+submit_job_cleanup(void *data, int thread_index)
+{
+   struct submit_job *job = data;
+
+   util_queue_fence_destroy(&job->fence);
+   free((void *) (uintptr_t) job->execbuf.buffers_ptr);
+   free(job->exec_bos);
+   free(job);
+}
+
+/**
+ * Starts the thread that brw_bufmgr_submit_async hands batches to.
+ *
+ * There is a single thread for all contexts, so that batches reach the
+ * kernel in the order they were flushed.
+ */
+bool
+brw_bufmgr_init_submit_thread(struct brw_bufmgr *bufmgr)
+{
+   bool ok = true;
+
+   mtx_lock(&bufmgr->lock);
+   if (!util_queue_is_initialized(&bufmgr->submit_queue)) {
+      ok = util_queue_init(&bufmgr->submit_queue, "i965sub", 8, 1,
+                           UTIL_QUEUE_INIT_RESIZE_IF_FULL);
+   }
+   mtx_unlock(&bufmgr->lock);
+
+   return ok;
+}
+
+/**
+ * Queues \p execbuf for submission on the submission thread.
+ *
+ * On success, the validation list behind execbuf->buffers_ptr and the
+ * \p exec_bos array, along with the references it holds, belong to the
+ * submission thread.  Only batches without relocations, fences or
+ * externally shared buffers may be queued.
+ */
+bool
+brw_bufmgr_submit_async(struct brw_bufmgr *bufmgr,
+                        const struct drm_i915_gem_execbuffer2 *execbuf,
+                        struct brw_bo **exec_bos)
+{
+   struct submit_job *job = malloc(sizeof(*job));
+   if (!job)
+      return false;
+
+   job->bufmgr = bufmgr;
+   job->execbuf = *execbuf;
+   job->exec_bos = exec_bos;
+   util_queue_fence_init(&job->fence);
+
+   for (unsigned i = 0; i < execbuf->buffer_count; i++)
+      p_atomic_inc(&exec_bos[i]->submits_queued);
+   p_atomic_inc(&bufmgr->submits_queued);
+
+   util_queue_add_job(&bufmgr->submit_queue, job, &job->fence,
+                      submit_job_execute, submit_job_cleanup);
+
+   return true;
+}
+
+/** Waits until every queued batch has been handed to the kernel. */
+void
+brw_bufmgr_wait_for_submits(struct brw_bufmgr *bufmgr)
+{
+   if (p_atomic_read(&bufmgr->submits_queued))
+      util_queue_finish(&bufmgr->submit_queue);
+}
+
 static void
 add_bucket(struct brw_bufmgr *bufmgr, int size)
 {
@@ -1628,6 +1873,9 @@ brw_destroy_hw_context(struct brw_bufmgr *bufmgr, uint32_t ctx_id)
 {
    struct drm_i915_gem_context_destroy d = { .ctx_id = ctx_id };
 
+   /* Queued batches for this context have to reach it before it's gone. */
+   brw_bufmgr_wait_for_submits(bufmgr);
+
    if (ctx_id != 0 &&
        drmIoctl(bufmgr->fd, DRM_IOCTL_I915_GEM_CONTEXT_DESTROY, &d) != 0) {
       fprintf(stderr, "DRM_IOCTL_I915_GEM_CONTEXT_DESTROY failed: %s\n",
@@ -1719,12 +1967,18 @@ brw_bufmgr_init(struct gen_device_info *devinfo, int fd)
 
    const uint64_t _4GB = 4ull << 30;
 
+   /* Allocate VMA in userspace if we have softpin and full PPGTT.  Every
+    * buffer then has a fixed address, so batches never need relocations.
+    */
+   const bool has_softpin =
+      devinfo->gen >= 8 && gtt_size > 0 &&
+      gem_param(fd, I915_PARAM_HAS_EXEC_SOFTPIN) > 0 &&
+      gem_param(fd, I915_PARAM_HAS_ALIASING_PPGTT) > 1;
+
    if (devinfo->gen >= 8 && gtt_size > _4GB) {
       bufmgr->initial_kflags |= EXEC_OBJECT_SUPPORTS_48B_ADDRESS;
 
-      /* Allocate VMA in userspace if we have softpin and full PPGTT. */
-      if (gem_param(fd, I915_PARAM_HAS_EXEC_SOFTPIN) > 0 &&
-          gem_param(fd, I915_PARAM_HAS_ALIASING_PPGTT) > 1) {
+      if (has_softpin) {
          bufmgr->initial_kflags |= EXEC_OBJECT_PINNED;
 
          util_vma_heap_init(&bufmgr->vma_allocator[BRW_MEMZONE_LOW_4G],
@@ -1742,9 +1996,17 @@ brw_bufmgr_init(struct gen_device_info *devinfo, int fd)
          free(bufmgr);
          return NULL;
       }
+   } else if (has_softpin) {
+      /* A 32-bit full PPGTT: everything shares the low 4GB zone. */
+      bufmgr->initial_kflags |= EXEC_OBJECT_PINNED;
+
+      util_vma_heap_init(&bufmgr->vma_allocator[BRW_MEMZONE_LOW_4G],
+                         4096, MIN2(gtt_size, _4GB) - 4096);
    }
 
    init_cache_buckets(bufmgr);
+   list_inithead(&bufmgr->cache_lru);
+   bufmgr->cache_max_age = 1;
 
    bufmgr->name_table =
       _mesa_hash_table_create(NULL, key_hash_uint, key_uint_equal);
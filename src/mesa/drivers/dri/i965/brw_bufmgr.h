@@ -179,6 +179,9 @@ struct brw_bo {
    /** BO cache list */
    struct list_head head;
 
+   /** Link in the bufmgr's list of all cached BOs, oldest first */
+   struct list_head lru;
+
    /**
     * Boolean of whether this buffer can be re-used
     */
@@ -189,6 +192,12 @@ struct brw_bo {
     */
    bool external;
 
+   /**
+    * Number of batches referencing this buffer that are queued on the
+    * submission thread but haven't been handed to the kernel yet.
+    */
+   unsigned submits_queued;
+
    /**
     * Boolean of whether this buffer is cache coherent
     */
@@ -348,6 +357,16 @@ struct brw_bo *brw_bo_gem_create_from_name(struct brw_bufmgr *bufmgr,
                                            const char *name,
                                            unsigned int handle);
 void brw_bufmgr_enable_reuse(struct brw_bufmgr *bufmgr);
+void brw_bufmgr_set_cache_limits(struct brw_bufmgr *bufmgr,
+                                 uint64_t high_bytes, uint64_t low_bytes,
+                                 unsigned max_age);
+
+struct drm_i915_gem_execbuffer2;
+bool brw_bufmgr_init_submit_thread(struct brw_bufmgr *bufmgr);
+bool brw_bufmgr_submit_async(struct brw_bufmgr *bufmgr,
+                             const struct drm_i915_gem_execbuffer2 *execbuf,
+                             struct brw_bo **exec_bos);
+void brw_bufmgr_wait_for_submits(struct brw_bufmgr *bufmgr);
 
 int brw_bo_wait(struct brw_bo *bo, int64_t timeout_ns);
 
@@ -801,6 +801,21 @@ brw_process_driconf_options(struct brw_context *brw)
       break;
    }
 
+   const uint64_t MB = 1024 * 1024;
+   brw_bufmgr_set_cache_limits(brw->bufmgr,
+      driQueryOptioni(options, "bo_cache_high_watermark") * MB,
+      driQueryOptioni(options, "bo_cache_low_watermark") * MB,
+      driQueryOptioni(options, "bo_cache_max_age"));
+
+   /* Only softpinned batches can be submitted without waiting for the
+    * kernel to tell us where the buffers ended up.
+    */
+   if (driQueryOptionb(options, "submit_thread") &&
+       brw_using_softpin(brw->bufmgr)) {
+      brw->batch.use_submit_thread =
+         brw_bufmgr_init_submit_thread(brw->bufmgr);
+   }
+
    if (INTEL_DEBUG & DEBUG_NO_HIZ) {
        brw->has_hiz = false;
        /* On gen6, you can only do separate stencil with HIZ. */
@@ -828,6 +843,11 @@ brw_process_driconf_options(struct brw_context *brw)
 
    brw->precompile = driQueryOptionb(&brw->optionCache, "shader_precompile");
 
+   /* Shader time indices can only be assigned on the context's thread. */
+   brw->precompile_async = brw->precompile &&
+      driQueryOptionb(&brw->optionCache, "shader_precompile_async") &&
+      !(INTEL_DEBUG & DEBUG_SHADER_TIME);
+
    if (driQueryOptionb(&brw->optionCache, "precise_trig"))
       brw->screen->compiler->precise_trig = true;
 
@@ -854,6 +874,9 @@ brw_process_driconf_options(struct brw_context *brw)
 
    ctx->Const.GLSLZeroInit = driQueryOptionb(options, "glsl_zero_init");
 
+   ctx->Const.GLSLOptimizeConservatively =
+      driQueryOptionb(options, "glsl_optimize_conservatively");
+
    brw->dual_color_blend_by_location =
       driQueryOptionb(options, "dual_color_blend_by_location");
 
@@ -971,6 +994,11 @@ brwCreateContext(gl_api api,
 
    brw_process_driconf_options(brw);
 
+   if (brw->precompile_async &&
+       !util_queue_init(&brw->compile_queue, "i965comp", 32, 1,
+                        UTIL_QUEUE_INIT_RESIZE_IF_FULL))
+      brw->precompile_async = false;
+
    if (INTEL_DEBUG & DEBUG_PERF)
       brw->perf_debug = true;
 
@@ -1106,6 +1134,14 @@ intelDestroyContext(__DRIcontext * driContextPriv)
       (struct brw_context *) driContextPriv->driverPrivate;
    struct gl_context *ctx = &brw->ctx;
 
+   /* Queued compiles log through this context, so let them finish.  Their
+    * results stay valid for other contexts in the share group.
+    */
+   if (util_queue_is_initialized(&brw->compile_queue)) {
+      util_queue_finish(&brw->compile_queue);
+      util_queue_destroy(&brw->compile_queue);
+   }
+
    _mesa_meta_free(&brw->ctx);
 
    if (INTEL_DEBUG & DEBUG_SHADER_TIME) {
@@ -40,6 +40,7 @@
 #include "brw_structs.h"
 #include "brw_pipe_control.h"
 #include "compiler/brw_compiler.h"
+#include "util/u_queue.h"
 
 #include "isl/isl.h"
 #include "blorp/blorp.h"
@@ -331,6 +332,9 @@ struct brw_program {
    GLuint id;
 
    bool compiled_once;
+
+   /** Pending link time compile, see brw_async_compile */
+   struct brw_async_compile *async_compile;
 };
 
 
@@ -473,6 +477,9 @@ struct brw_reloc_list {
    int reloc_array_size;
 };
 
+/** Number of retired batch/state buffers kept for reuse with softpin. */
+#define BRW_BATCH_RING_SIZE 4
+
 struct brw_growing_bo {
    struct brw_bo *bo;
    uint32_t *map;
@@ -480,6 +487,14 @@ struct brw_growing_bo {
    uint32_t *partial_bo_map;
    unsigned partial_bytes;
    enum brw_memory_zone memzone;
+
+   /**
+    * Previously submitted buffers, oldest at ring_next.  With softpin these
+    * keep their pages and their VMA, so once the GPU is done with one we can
+    * start the next batch in it without going through the bufmgr cache.
+    */
+   struct brw_bo *ring[BRW_BATCH_RING_SIZE];
+   unsigned ring_next;
 };
 
 struct intel_batchbuffer {
@@ -499,6 +514,8 @@ struct intel_batchbuffer {
 
    bool use_shadow_copy;
    bool use_batch_first;
+   /** Hand batches to the bufmgr's submission thread when possible */
+   bool use_submit_thread;
    bool needs_sol_reset;
    bool state_base_address_emitted;
    bool no_wrap;
@@ -825,6 +842,7 @@ struct brw_context
    bool always_flush_cache;
    bool disable_throttling;
    bool precompile;
+   bool precompile_async;
    bool dual_color_blend_by_location;
 
    driOptionCache optionCache;
@@ -869,6 +887,9 @@ struct brw_context
 
    struct brw_cache cache;
 
+   /** Worker thread for link time compiles, see brw_async_compile */
+   struct util_queue compile_queue;
+
    /* Whether a meta-operation is in progress. */
    bool meta_in_progress;
 
@@ -1218,6 +1239,9 @@ struct brw_context
       /* The i915 perf stream we open to setup + enable the OA counters */
       int oa_stream_fd;
 
+      /* Background thread draining oa_stream_fd while it is open */
+      struct brw_oa_reader *oa_reader;
+
       /* An i915 perf stream fd gives exclusive access to the OA unit that will
        * report counter snapshots for a specific counter set/profile in a
        * specific layout/format so we can only start OA queries that are
@@ -373,6 +373,106 @@ brw_disk_cache_write_compute_program(struct brw_context *brw)
    }
 }
 
+static void
+gen_blorp_sha1(struct disk_cache *cache, const void *key, uint32_t key_size,
+               unsigned char *out_sha1)
+{
+   /* Tag the key so that it can't collide with the GLSL program entries */
+   struct blob blob;
+   blob_init(&blob);
+   blob_write_string(&blob, "blorp");
+   blob_write_bytes(&blob, key, key_size);
+   disk_cache_compute_key(cache, blob.data, blob.size, out_sha1);
+   blob_finish(&blob);
+}
+
+/**
+ * Looks up a BLORP program in the disk cache and, if found, uploads it to
+ * the program cache.
+ *
+ * The screen's disk cache is already specific to the device and the driver
+ * build, so the BLORP key is all that's needed to identify the program.
+ */
+bool
+brw_disk_cache_upload_blorp(struct brw_context *brw,
+                            const void *key, uint32_t key_size,
+                            uint32_t *kernel_out, void *prog_data_out)
+{
+   struct disk_cache *cache = brw->ctx.Cache;
+   if (cache == NULL || (INTEL_DEBUG & DEBUG_BLORP))
+      return false;
+
+   unsigned char sha1[20];
+   gen_blorp_sha1(cache, key, key_size, sha1);
+
+   size_t buffer_size;
+   uint8_t *buffer = disk_cache_get(cache, sha1, &buffer_size);
+   if (buffer == NULL)
+      return false;
+
+   struct blob_reader binary;
+   blob_reader_init(&binary, buffer, buffer_size);
+
+   const uint32_t prog_data_size = blob_read_uint32(&binary);
+   const void *prog_data = blob_read_bytes(&binary, prog_data_size);
+   const uint32_t program_size = blob_read_uint32(&binary);
+   const void *program = blob_read_bytes(&binary, program_size);
+
+   if (binary.overrun || binary.current != binary.end) {
+      disk_cache_remove(cache, sha1);
+      free(buffer);
+      return false;
+   }
+
+   /* The blob data is not necessarily aligned for the prog_data struct */
+   void *prog_data_tmp = malloc(prog_data_size);
+   if (prog_data_tmp == NULL) {
+      free(buffer);
+      return false;
+   }
+   memcpy(prog_data_tmp, prog_data, prog_data_size);
+
+   brw_upload_cache(&brw->cache, BRW_CACHE_BLORP_PROG, key, key_size,
+                    program, program_size, prog_data_tmp, prog_data_size,
+                    kernel_out, prog_data_out);
+
+   free(prog_data_tmp);
+   free(buffer);
+
+   return true;
+}
+
+/**
+ * Stores a freshly compiled BLORP program in the disk cache.  BLORP programs
+ * have no push constants so, like the program cache, we can keep the
+ * prog_data as raw bytes.
+ */
+void
+brw_disk_cache_write_blorp(struct brw_context *brw,
+                           const void *key, uint32_t key_size,
+                           const void *program, uint32_t program_size,
+                           const void *prog_data, uint32_t prog_data_size)
+{
+   struct disk_cache *cache = brw->ctx.Cache;
+   if (cache == NULL || (INTEL_DEBUG & DEBUG_BLORP))
+      return;
+
+   struct blob binary;
+   blob_init(&binary);
+   blob_write_uint32(&binary, prog_data_size);
+   blob_write_bytes(&binary, prog_data, prog_data_size);
+   blob_write_uint32(&binary, program_size);
+   blob_write_bytes(&binary, program, program_size);
+
+   if (!binary.out_of_memory) {
+      unsigned char sha1[20];
+      gen_blorp_sha1(cache, key, key_size, sha1);
+      disk_cache_put(cache, sha1, binary.data, binary.size, NULL);
+   }
+
+   blob_finish(&binary);
+}
+
 void
 brw_disk_cache_init(struct intel_screen *screen)
 {
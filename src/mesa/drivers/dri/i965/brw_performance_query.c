@@ -54,6 +54,7 @@
 #include <fcntl.h>
 #include <sys/mman.h>
 #include <sys/ioctl.h>
+#include <poll.h>
 
 #include <xf86drm.h>
 #include <i915_drm.h>
@@ -67,6 +68,7 @@
 #include "util/ralloc.h"
 #include "util/hash_table.h"
 #include "util/list.h"
+#include "c11/threads.h"
 
 #include "brw_context.h"
 #include "brw_defines.h"
@@ -207,6 +209,36 @@ struct brw_oa_sample_buf {
    uint32_t last_timestamp;
 };
 
+#define OA_READER_RING_SIZE 64
+
+struct brw_oa_reader_chunk {
+   int len;
+   uint8_t buf[I915_PERF_OA_SAMPLE_SIZE * 10];
+};
+
+/**
+ * While an i915 perf stream is open, a thread drains it in the background
+ * into a ring of chunks so that the kernel's OA buffer doesn't overflow
+ * during long queries and the application thread mostly finds the reports
+ * already read when it needs them.  The application thread moves the
+ * chunks over to brw->perfquery.sample_buffers in read_oa_samples_until().
+ *
+ * All reads of the stream, from either thread, happen with the mutex held
+ * so that the reports stay in order.
+ */
+struct brw_oa_reader {
+   thrd_t thread;
+   mtx_t mutex;
+   int fd;
+   int wake_pipe[2];
+
+   /* chunks[head % OA_READER_RING_SIZE] up to (but excluding)
+    * chunks[tail % OA_READER_RING_SIZE] hold unconsumed reports.
+    */
+   unsigned head, tail;
+   struct brw_oa_reader_chunk chunks[OA_READER_RING_SIZE];
+};
+
 /** Downcasting convenience macro. */
 static inline struct brw_perf_query_object *
 brw_perf_query(struct gl_perf_query_object *o)
@@ -669,20 +701,43 @@ enum OaReadStatus {
    OA_READ_STATUS_FINISHED,
 };
 
-static enum OaReadStatus
-read_oa_samples_until(struct brw_context *brw,
-                      uint32_t start_timestamp,
-                      uint32_t end_timestamp)
+/**
+ * Append a buffer holding \p len bytes of i915 perf records to the list of
+ * sample buffers and update \p last_timestamp with its last report.
+ */
+static void
+append_sample_buf(struct brw_context *brw, struct brw_oa_sample_buf *buf,
+                  int len, uint32_t *last_timestamp)
 {
-   struct exec_node *tail_node =
-      exec_list_get_tail(&brw->perfquery.sample_buffers);
-   struct brw_oa_sample_buf *tail_buf =
-      exec_node_data(struct brw_oa_sample_buf, tail_node, link);
-   uint32_t last_timestamp = tail_buf->last_timestamp;
+   uint32_t offset;
+
+   buf->len = len;
+   exec_list_push_tail(&brw->perfquery.sample_buffers, &buf->link);
+
+   /* Go through the reports and update the last timestamp. */
+   offset = 0;
+   while (offset < buf->len) {
+      const struct drm_i915_perf_record_header *header =
+         (const struct drm_i915_perf_record_header *) &buf->buf[offset];
+      uint32_t *report = (uint32_t *) (header + 1);
+
+      if (header->type == DRM_I915_PERF_RECORD_SAMPLE)
+         *last_timestamp = report[1];
+
+      offset += header->size;
+   }
 
+   buf->last_timestamp = *last_timestamp;
+}
+
+static enum OaReadStatus
+read_oa_stream_until(struct brw_context *brw,
+                     uint32_t start_timestamp,
+                     uint32_t end_timestamp,
+                     uint32_t last_timestamp)
+{
    while (1) {
       struct brw_oa_sample_buf *buf = get_free_sample_buf(brw);
-      uint32_t offset;
       int len;
 
       while ((len = read(brw->perfquery.oa_stream_fd, buf->buf,
@@ -707,27 +762,50 @@ read_oa_samples_until(struct brw_context *brw,
          return OA_READ_STATUS_ERROR;
       }
 
-      buf->len = len;
-      exec_list_push_tail(&brw->perfquery.sample_buffers, &buf->link);
+      append_sample_buf(brw, buf, len, &last_timestamp);
+   }
 
-      /* Go through the reports and update the last timestamp. */
-      offset = 0;
-      while (offset < buf->len) {
-         const struct drm_i915_perf_record_header *header =
-            (const struct drm_i915_perf_record_header *) &buf->buf[offset];
-         uint32_t *report = (uint32_t *) (header + 1);
+   unreachable("not reached");
+   return OA_READ_STATUS_ERROR;
+}
 
-         if (header->type == DRM_I915_PERF_RECORD_SAMPLE)
-            last_timestamp = report[1];
+static enum OaReadStatus
+read_oa_samples_until(struct brw_context *brw,
+                      uint32_t start_timestamp,
+                      uint32_t end_timestamp)
+{
+   struct brw_oa_reader *reader = brw->perfquery.oa_reader;
+   struct exec_node *tail_node =
+      exec_list_get_tail(&brw->perfquery.sample_buffers);
+   struct brw_oa_sample_buf *tail_buf =
+      exec_node_data(struct brw_oa_sample_buf, tail_node, link);
+   uint32_t last_timestamp = tail_buf->last_timestamp;
+   enum OaReadStatus status;
 
-         offset += header->size;
-      }
+   if (!reader)
+      return read_oa_stream_until(brw, start_timestamp, end_timestamp,
+                                  last_timestamp);
+
+   /* Take what the reader thread already got, then read the rest
+    * ourselves while it can't read in between.
+    */
+   mtx_lock(&reader->mutex);
 
-      buf->last_timestamp = last_timestamp;
+   for (; reader->head != reader->tail; reader->head++) {
+      const struct brw_oa_reader_chunk *chunk =
+         &reader->chunks[reader->head % OA_READER_RING_SIZE];
+      struct brw_oa_sample_buf *buf = get_free_sample_buf(brw);
+
+      memcpy(buf->buf, chunk->buf, chunk->len);
+      append_sample_buf(brw, buf, chunk->len, &last_timestamp);
    }
 
-   unreachable("not reached");
-   return OA_READ_STATUS_ERROR;
+   status = read_oa_stream_until(brw, start_timestamp, end_timestamp,
+                                 last_timestamp);
+
+   mtx_unlock(&reader->mutex);
+
+   return status;
 }
 
 /**
@@ -948,6 +1026,114 @@ error:
 
 /******************************************************************************/
 
+static int
+oa_reader_thread(void *data)
+{
+   struct brw_oa_reader *reader = data;
+   struct pollfd fds[2] = {
+      { .fd = reader->fd, .events = POLLIN },
+      { .fd = reader->wake_pipe[0], .events = POLLIN },
+   };
+
+   while (1) {
+      bool stalled = false;
+
+      if (poll(fds, 2, -1) < 0) {
+         if (errno == EINTR)
+            continue;
+         break;
+      }
+
+      /* Woken up to exit. */
+      if (fds[1].revents)
+         break;
+
+      if (fds[0].revents & (POLLERR | POLLHUP | POLLNVAL))
+         break;
+
+      if (!(fds[0].revents & POLLIN))
+         continue;
+
+      mtx_lock(&reader->mutex);
+      while (1) {
+         struct brw_oa_reader_chunk *chunk =
+            &reader->chunks[reader->tail % OA_READER_RING_SIZE];
+         int len;
+
+         /* With the ring full, leave the reports in the kernel until the
+          * application thread catches up.
+          */
+         if (reader->tail - reader->head == OA_READER_RING_SIZE) {
+            stalled = true;
+            break;
+         }
+
+         while ((len = read(reader->fd, chunk->buf,
+                            sizeof(chunk->buf))) < 0 && errno == EINTR)
+            ;
+
+         if (len <= 0) {
+            /* Leave errors for the application thread to report. */
+            stalled = len < 0 && errno != EAGAIN;
+            break;
+         }
+
+         chunk->len = len;
+         reader->tail++;
+      }
+      mtx_unlock(&reader->mutex);
+
+      /* Don't spin on a stream we can't make progress on. */
+      if (stalled)
+         poll(&fds[1], 1, 5);
+   }
+
+   return 0;
+}
+
+static struct brw_oa_reader *
+oa_reader_create(struct brw_context *brw, int fd)
+{
+   struct brw_oa_reader *reader = calloc(1, sizeof(*reader));
+
+   if (!reader)
+      return NULL;
+
+   reader->fd = fd;
+   if (pipe2(reader->wake_pipe, O_CLOEXEC) < 0) {
+      free(reader);
+      return NULL;
+   }
+
+   mtx_init(&reader->mutex, mtx_plain);
+
+   if (thrd_create(&reader->thread, oa_reader_thread, reader) != thrd_success) {
+      DBG("WARNING: Failed to start i915 perf reader thread\n");
+      mtx_destroy(&reader->mutex);
+      close(reader->wake_pipe[0]);
+      close(reader->wake_pipe[1]);
+      free(reader);
+      return NULL;
+   }
+
+   return reader;
+}
+
+static void
+oa_reader_destroy(struct brw_oa_reader *reader)
+{
+   const char c = 0;
+
+   while (write(reader->wake_pipe[1], &c, 1) < 0 && errno == EINTR)
+      ;
+   thrd_join(reader->thread, NULL);
+
+   mtx_destroy(&reader->mutex);
+   close(reader->wake_pipe[0]);
+   close(reader->wake_pipe[1]);
+   free(reader);
+}
+
 static bool
 open_i915_perf_oa_stream(struct brw_context *brw,
                          int metrics_set_id,
@@ -982,6 +1168,7 @@ open_i915_perf_oa_stream(struct brw_context *brw,
    }
 
    brw->perfquery.oa_stream_fd = fd;
+   brw->perfquery.oa_reader = oa_reader_create(brw, fd);
 
    brw->perfquery.current_oa_metrics_set_id = metrics_set_id;
    brw->perfquery.current_oa_format = report_format;
@@ -993,6 +1180,10 @@ static void
 close_perf(struct brw_context *brw,
            const struct brw_perf_query_info *query)
 {
+   if (brw->perfquery.oa_reader) {
+      oa_reader_destroy(brw->perfquery.oa_reader);
+      brw->perfquery.oa_reader = NULL;
+   }
    if (brw->perfquery.oa_stream_fd != -1) {
       close(brw->perfquery.oa_stream_fd);
       brw->perfquery.oa_stream_fd = -1;
@@ -2297,6 +2488,7 @@ brw_init_perf_query_info(struct gl_context *ctx)
    exec_list_push_head(&brw->perfquery.sample_buffers, &buf->link);
 
    brw->perfquery.oa_stream_fd = -1;
+   brw->perfquery.oa_reader = NULL;
 
    brw->perfquery.next_query_start_report_id = 1000;
 
@@ -209,6 +209,8 @@ static void brwDeleteProgram( struct gl_context *ctx,
          brw->programs[i] = (struct gl_program *) &deleted_program;
    }
 
+   brw_discard_async_compile(brw_program(prog));
+
    _mesa_delete_program( ctx, prog );
 }
 
@@ -223,6 +225,9 @@ brwProgramStringNotify(struct gl_context *ctx,
    struct brw_context *brw = brw_context(ctx);
    const struct brw_compiler *compiler = brw->screen->compiler;
 
+   /* A queued compile may still be reading the NIR we are about to replace */
+   brw_discard_async_compile(brw_program(prog));
+
    switch (target) {
    case GL_FRAGMENT_PROGRAM_ARB: {
       struct brw_program *newFP = brw_program(prog);
@@ -738,6 +743,114 @@ brw_dump_arb_asm(const char *stage, struct gl_program *prog)
    _mesa_print_program(prog);
 }
 
+struct brw_async_compile *
+brw_create_async_compile(struct brw_context *brw, struct gl_program *prog)
+{
+   struct brw_async_compile *job = calloc(1, sizeof(*job));
+   if (!job)
+      return NULL;
+
+   util_queue_fence_init(&job->fence);
+   job->queue = &brw->compile_queue;
+   job->brw = brw;
+   job->prog = prog;
+   job->mem_ctx = ralloc_context(NULL);
+
+   return job;
+}
+
+static void
+brw_execute_async_compile(void *data, int thread_index)
+{
+   struct brw_async_compile *job = data;
+   const struct brw_compiler *compiler = job->brw->screen->compiler;
+
+   switch (job->prog->info.stage) {
+   case MESA_SHADER_VERTEX:
+      job->program = brw_compile_vs(compiler, job->brw, job->mem_ctx,
+                                    &job->key.vs, &job->prog_data.vs,
+                                    job->prog->nir, -1, &job->error_str);
+      break;
+   case MESA_SHADER_FRAGMENT:
+      job->program = brw_compile_fs(compiler, job->brw, job->mem_ctx,
+                                    &job->key.wm, &job->prog_data.wm,
+                                    job->prog->nir, job->prog, -1, -1, -1,
+                                    true, false, &job->vue_map,
+                                    &job->error_str);
+      break;
+   default:
+      unreachable("unsupported stage for asynchronous compiles");
+   }
+}
+
+/**
+ * Queue a job created by brw_create_async_compile() and make it the pending
+ * compile of its program.
+ */
+void
+brw_queue_async_compile(struct brw_context *brw,
+                        struct brw_async_compile *job)
+{
+   struct brw_program *bp = brw_program(job->prog);
+
+   brw_discard_async_compile(bp);
+   bp->async_compile = job;
+
+   util_queue_add_job(&brw->compile_queue, job, &job->fence,
+                      brw_execute_async_compile, NULL);
+}
+
+/**
+ * Return the pending compile of a program if it was made for the given key,
+ * waiting for it to finish if necessary.  The caller owns the returned job.
+ *
+ * Returns NULL if there is no such compile or if it failed, in which case
+ * the caller compiles the program itself and reports any errors.
+ */
+struct brw_async_compile *
+brw_take_async_compile(struct brw_program *bp,
+                       const void *key, size_t key_size)
+{
+   struct brw_async_compile *job = bp->async_compile;
+
+   if (!job || memcmp(&job->key, key, key_size) != 0)
+      return NULL;
+
+   util_queue_fence_wait(&job->fence);
+   bp->async_compile = NULL;
+
+   if (job->program == NULL) {
+      brw_free_async_compile(job);
+      return NULL;
+   }
+
+   return job;
+}
+
+void
+brw_free_async_compile(struct brw_async_compile *job)
+{
+   util_queue_fence_destroy(&job->fence);
+   ralloc_free(job->mem_ctx);
+   free(job);
+}
+
+void
+brw_discard_async_compile(struct brw_program *bp)
+{
+   struct brw_async_compile *job = bp->async_compile;
+
+   if (!job)
+      return;
+
+   /* A finished job may have outlived the context that queued it. */
+   if (!util_queue_fence_is_signalled(&job->fence))
+      util_queue_drop_job(job->queue, &job->fence);
+
+   bp->async_compile = NULL;
+   brw_free_async_compile(job);
+}
+
 void
 brw_setup_tex_for_precompile(const struct gen_device_info *devinfo,
                              struct brw_sampler_prog_key_data *tex,
@@ -26,12 +26,14 @@
 
 #include "compiler/brw_compiler.h"
 #include "nir.h"
+#include "util/u_queue.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 struct brw_context;
+struct brw_program;
 struct blob;
 struct blob_reader;
 
@@ -99,6 +101,44 @@ brw_stage_prog_data_free(const void *prog_data);
 void
 brw_dump_arb_asm(const char *stage, struct gl_program *prog);
 
+/**
+ * A link time compile of a program with its default key, running on
+ * brw_context::compile_queue.
+ *
+ * Everything that needs the context (binding tables, uniform layout) is set
+ * up before the job is queued, the worker only runs the backend compiler.
+ * The first draw using the default key picks the result up with
+ * brw_take_async_compile() and uploads it to its own program cache.
+ */
+struct brw_async_compile {
+   struct util_queue_fence fence;
+   struct util_queue *queue;
+
+   /** Only used as log_data for the compiler */
+   struct brw_context *brw;
+   struct gl_program *prog;
+
+   void *mem_ctx;
+   union brw_any_prog_key key;
+   union brw_any_prog_data prog_data;
+
+   /** Fragment shader inputs, only used before gen6 */
+   struct brw_vue_map vue_map;
+
+   const unsigned *program;
+   char *error_str;
+};
+
+struct brw_async_compile *
+brw_create_async_compile(struct brw_context *brw, struct gl_program *prog);
+void brw_queue_async_compile(struct brw_context *brw,
+                             struct brw_async_compile *job);
+struct brw_async_compile *
+brw_take_async_compile(struct brw_program *bp,
+                       const void *key, size_t key_size);
+void brw_free_async_compile(struct brw_async_compile *job);
+void brw_discard_async_compile(struct brw_program *bp);
+
 bool brw_vs_precompile(struct gl_context *ctx, struct gl_program *prog);
 bool brw_tcs_precompile(struct gl_context *ctx,
                         struct gl_shader_program *shader_prog,
@@ -126,6 +126,14 @@ bool brw_disk_cache_upload_program(struct brw_context *brw,
                                    gl_shader_stage stage);
 void brw_disk_cache_write_compute_program(struct brw_context *brw);
 void brw_disk_cache_write_render_programs(struct brw_context *brw);
+bool brw_disk_cache_upload_blorp(struct brw_context *brw,
+                                 const void *key, uint32_t key_size,
+                                 uint32_t *kernel_out, void *prog_data_out);
+void brw_disk_cache_write_blorp(struct brw_context *brw,
+                                const void *key, uint32_t key_size,
+                                const void *program, uint32_t program_size,
+                                const void *prog_data,
+                                uint32_t prog_data_size);
 
 /***********************************************************************
  * brw_state_upload.c
@@ -70,7 +70,8 @@ brw_select_clip_planes(struct gl_context *ctx)
 }
 
 static GLbitfield64
-brw_vs_outputs_written(struct brw_context *brw, struct brw_vs_prog_key *key,
+brw_vs_outputs_written(struct brw_context *brw,
+                       const struct brw_vs_prog_key *key,
                        GLbitfield64 user_varyings)
 {
    const struct gen_device_info *devinfo = &brw->screen->devinfo;
@@ -152,48 +153,83 @@ brw_vs_debug_recompile(struct brw_context *brw, struct gl_program *prog,
    }
 }
 
-static bool
-brw_codegen_vs_prog(struct brw_context *brw,
-                    struct brw_program *vp,
-                    struct brw_vs_prog_key *key)
+/**
+ * Fill out the parts of the prog_data that have to be known before the
+ * program is compiled.  The param arrays are allocated out of mem_ctx.
+ */
+static void
+brw_vs_setup_prog_data(struct brw_context *brw,
+                       struct brw_program *vp,
+                       const struct brw_vs_prog_key *key,
+                       struct brw_vs_prog_data *prog_data,
+                       void *mem_ctx)
 {
    const struct brw_compiler *compiler = brw->screen->compiler;
    const struct gen_device_info *devinfo = &brw->screen->devinfo;
-   const GLuint *program;
-   struct brw_vs_prog_data prog_data;
-   struct brw_stage_prog_data *stage_prog_data = &prog_data.base.base;
-   void *mem_ctx;
-   bool start_busy = false;
-   double start_time = 0;
 
-   memset(&prog_data, 0, sizeof(prog_data));
+   memset(prog_data, 0, sizeof(*prog_data));
 
    /* Use ALT floating point mode for ARB programs so that 0^0 == 1. */
    if (vp->program.is_arb_asm)
-      stage_prog_data->use_alt_mode = true;
-
-   mem_ctx = ralloc_context(NULL);
+      prog_data->base.base.use_alt_mode = true;
 
    brw_assign_common_binding_table_offsets(devinfo, &vp->program,
-                                           &prog_data.base.base, 0);
+                                           &prog_data->base.base, 0);
 
    if (!vp->program.is_arb_asm) {
       brw_nir_setup_glsl_uniforms(mem_ctx, vp->program.nir, &vp->program,
-                                  &prog_data.base.base,
+                                  &prog_data->base.base,
                                   compiler->scalar_stage[MESA_SHADER_VERTEX]);
       brw_nir_analyze_ubo_ranges(compiler, vp->program.nir, key,
-                                 prog_data.base.base.ubo_ranges);
+                                 prog_data->base.base.ubo_ranges);
    } else {
       brw_nir_setup_arb_uniforms(mem_ctx, vp->program.nir, &vp->program,
-                                 &prog_data.base.base);
+                                 &prog_data->base.base);
    }
 
    uint64_t outputs_written =
       brw_vs_outputs_written(brw, key, vp->program.nir->info.outputs_written);
 
    brw_compute_vue_map(devinfo,
-                       &prog_data.base.vue_map, outputs_written,
+                       &prog_data->base.vue_map, outputs_written,
                        vp->program.nir->info.separate_shader);
+}
+
+static void
+brw_vs_upload_program(struct brw_context *brw,
+                      const struct brw_vs_prog_key *key,
+                      const unsigned *program,
+                      struct brw_vs_prog_data *prog_data)
+{
+   /* Scratch space is used for register spilling */
+   brw_alloc_stage_scratch(brw, &brw->vs.base,
+                           prog_data->base.base.total_scratch);
+
+   /* The param and pull_param arrays will be freed by the shader cache. */
+   ralloc_steal(NULL, prog_data->base.base.param);
+   ralloc_steal(NULL, prog_data->base.base.pull_param);
+   brw_upload_cache(&brw->cache, BRW_CACHE_VS_PROG,
+                    key, sizeof(struct brw_vs_prog_key),
+                    program, prog_data->base.base.program_size,
+                    prog_data, sizeof(*prog_data),
+                    &brw->vs.base.prog_offset, &brw->vs.base.prog_data);
+}
+
+static bool
+brw_codegen_vs_prog(struct brw_context *brw,
+                    struct brw_program *vp,
+                    struct brw_vs_prog_key *key)
+{
+   const struct brw_compiler *compiler = brw->screen->compiler;
+   const GLuint *program;
+   struct brw_vs_prog_data prog_data;
+   void *mem_ctx;
+   bool start_busy = false;
+   double start_time = 0;
+
+   mem_ctx = ralloc_context(NULL);
+
+   brw_vs_setup_prog_data(brw, vp, key, &prog_data, mem_ctx);
 
    if (0) {
       _mesa_fprint_program_opt(stderr, &vp->program, PROG_PRINT_DEBUG, true);
@@ -245,18 +281,7 @@ brw_codegen_vs_prog(struct brw_context *brw,
       vp->compiled_once = true;
    }
 
-   /* Scratch space is used for register spilling */
-   brw_alloc_stage_scratch(brw, &brw->vs.base,
-                           prog_data.base.base.total_scratch);
-
-   /* The param and pull_param arrays will be freed by the shader cache. */
-   ralloc_steal(NULL, prog_data.base.base.param);
-   ralloc_steal(NULL, prog_data.base.base.pull_param);
-   brw_upload_cache(&brw->cache, BRW_CACHE_VS_PROG,
-                    key, sizeof(struct brw_vs_prog_key),
-                    program, prog_data.base.base.program_size,
-                    &prog_data, sizeof(prog_data),
-                    &brw->vs.base.prog_offset, &brw->vs.base.prog_data);
+   brw_vs_upload_program(brw, key, program, &prog_data);
    ralloc_free(mem_ctx);
 
    return true;
@@ -352,6 +377,14 @@ brw_upload_vs_prog(struct brw_context *brw)
    vp = (struct brw_program *) brw->programs[MESA_SHADER_VERTEX];
    vp->id = key.program_string_id;
 
+   struct brw_async_compile *job =
+      brw_take_async_compile(vp, &key, sizeof(key));
+   if (job) {
+      brw_vs_upload_program(brw, &key, job->program, &job->prog_data.vs);
+      brw_free_async_compile(job);
+      return;
+   }
+
    MAYBE_UNUSED bool success = brw_codegen_vs_prog(brw, vp, &key);
    assert(success);
 }
@@ -386,6 +419,17 @@ brw_vs_precompile(struct gl_context *ctx, struct gl_program *prog)
 
    brw_vs_populate_default_key(&brw->screen->devinfo, &key, prog);
 
+   if (brw->precompile_async) {
+      struct brw_async_compile *job = brw_create_async_compile(brw, prog);
+      if (job) {
+         memcpy(&job->key.vs, &key, sizeof(key));
+         brw_vs_setup_prog_data(brw, bvp, &key, &job->prog_data.vs,
+                                job->mem_ctx);
+         brw_queue_async_compile(brw, job);
+         return true;
+      }
+   }
+
    success = brw_codegen_vs_prog(brw, bvp, &key);
 
    brw->vs.base.prog_offset = old_prog_offset;
@@ -124,39 +124,72 @@ brw_wm_debug_recompile(struct brw_context *brw, struct gl_program *prog,
    }
 }
 
-static bool
-brw_codegen_wm_prog(struct brw_context *brw,
-                    struct brw_program *fp,
-                    struct brw_wm_prog_key *key,
-                    struct brw_vue_map *vue_map)
+/**
+ * Fill out the parts of the prog_data that have to be known before the
+ * program is compiled.  The param arrays are allocated out of mem_ctx.
+ */
+static void
+brw_wm_setup_prog_data(struct brw_context *brw,
+                       struct brw_program *fp,
+                       const struct brw_wm_prog_key *key,
+                       struct brw_wm_prog_data *prog_data,
+                       void *mem_ctx)
 {
    const struct gen_device_info *devinfo = &brw->screen->devinfo;
-   void *mem_ctx = ralloc_context(NULL);
-   struct brw_wm_prog_data prog_data;
-   const GLuint *program;
-   bool start_busy = false;
-   double start_time = 0;
 
-   memset(&prog_data, 0, sizeof(prog_data));
+   memset(prog_data, 0, sizeof(*prog_data));
 
    /* Use ALT floating point mode for ARB programs so that 0^0 == 1. */
    if (fp->program.is_arb_asm)
-      prog_data.base.use_alt_mode = true;
+      prog_data->base.use_alt_mode = true;
 
-   assign_fs_binding_table_offsets(devinfo, &fp->program, key, &prog_data);
+   assign_fs_binding_table_offsets(devinfo, &fp->program, key, prog_data);
 
    if (!fp->program.is_arb_asm) {
       brw_nir_setup_glsl_uniforms(mem_ctx, fp->program.nir, &fp->program,
-                                  &prog_data.base, true);
+                                  &prog_data->base, true);
       brw_nir_analyze_ubo_ranges(brw->screen->compiler, fp->program.nir,
-                                 NULL, prog_data.base.ubo_ranges);
+                                 NULL, prog_data->base.ubo_ranges);
    } else {
       brw_nir_setup_arb_uniforms(mem_ctx, fp->program.nir, &fp->program,
-                                 &prog_data.base);
-
-      if (unlikely(INTEL_DEBUG & DEBUG_WM))
-         brw_dump_arb_asm("fragment", &fp->program);
+                                 &prog_data->base);
    }
+}
+
+static void
+brw_wm_upload_program(struct brw_context *brw,
+                      const struct brw_wm_prog_key *key,
+                      const unsigned *program,
+                      struct brw_wm_prog_data *prog_data)
+{
+   brw_alloc_stage_scratch(brw, &brw->wm.base, prog_data->base.total_scratch);
+
+   /* The param and pull_param arrays will be freed by the shader cache. */
+   ralloc_steal(NULL, prog_data->base.param);
+   ralloc_steal(NULL, prog_data->base.pull_param);
+   brw_upload_cache(&brw->cache, BRW_CACHE_FS_PROG,
+                    key, sizeof(struct brw_wm_prog_key),
+                    program, prog_data->base.program_size,
+                    prog_data, sizeof(*prog_data),
+                    &brw->wm.base.prog_offset, &brw->wm.base.prog_data);
+}
+
+static bool
+brw_codegen_wm_prog(struct brw_context *brw,
+                    struct brw_program *fp,
+                    struct brw_wm_prog_key *key,
+                    struct brw_vue_map *vue_map)
+{
+   void *mem_ctx = ralloc_context(NULL);
+   struct brw_wm_prog_data prog_data;
+   const GLuint *program;
+   bool start_busy = false;
+   double start_time = 0;
+
+   brw_wm_setup_prog_data(brw, fp, key, &prog_data, mem_ctx);
+
+   if (unlikely((INTEL_DEBUG & DEBUG_WM) && fp->program.is_arb_asm))
+      brw_dump_arb_asm("fragment", &fp->program);
 
    if (unlikely(brw->perf_debug)) {
       start_busy = (brw->batch.last_bo &&
@@ -204,19 +237,10 @@ brw_codegen_wm_prog(struct brw_context *brw,
       }
    }
 
-   brw_alloc_stage_scratch(brw, &brw->wm.base, prog_data.base.total_scratch);
-
    if (unlikely((INTEL_DEBUG & DEBUG_WM) && fp->program.is_arb_asm))
       fprintf(stderr, "\n");
 
-   /* The param and pull_param arrays will be freed by the shader cache. */
-   ralloc_steal(NULL, prog_data.base.param);
-   ralloc_steal(NULL, prog_data.base.pull_param);
-   brw_upload_cache(&brw->cache, BRW_CACHE_FS_PROG,
-                    key, sizeof(struct brw_wm_prog_key),
-                    program, prog_data.base.program_size,
-                    &prog_data, sizeof(prog_data),
-                    &brw->wm.base.prog_offset, &brw->wm.base.prog_data);
+   brw_wm_upload_program(brw, key, program, &prog_data);
 
    ralloc_free(mem_ctx);
 
@@ -601,6 +625,14 @@ brw_upload_wm_prog(struct brw_context *brw)
    fp = (struct brw_program *) brw->programs[MESA_SHADER_FRAGMENT];
    fp->id = key.program_string_id;
 
+   struct brw_async_compile *job =
+      brw_take_async_compile(fp, &key, sizeof(key));
+   if (job) {
+      brw_wm_upload_program(brw, &key, job->program, &job->prog_data.wm);
+      brw_free_async_compile(job);
+      return;
+   }
+
    MAYBE_UNUSED bool success = brw_codegen_wm_prog(brw, fp, &key,
                                                    &brw->vue_map_geom_out);
    assert(success);
@@ -670,6 +702,19 @@ brw_fs_precompile(struct gl_context *ctx, struct gl_program *prog)
                           false);
    }
 
+   if (brw->precompile_async) {
+      struct brw_async_compile *job = brw_create_async_compile(brw, prog);
+      if (job) {
+         memcpy(&job->key.wm, &key, sizeof(key));
+         if (devinfo->gen < 6)
+            job->vue_map = vue_map;
+         brw_wm_setup_prog_data(brw, bfp, &key, &job->prog_data.wm,
+                                job->mem_ctx);
+         brw_queue_async_compile(brw, job);
+         return true;
+      }
+   }
+
    bool success = brw_codegen_wm_prog(brw, bfp, &key, &vue_map);
 
    brw->wm.base.prog_offset = old_prog_offset;
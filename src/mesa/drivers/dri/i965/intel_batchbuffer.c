@@ -223,6 +223,31 @@ add_exec_bo(struct intel_batchbuffer *batch, struct brw_bo *bo)
    return batch->exec_count++;
 }
 
+/**
+ * Retire the current buffer into the ring, and take back the oldest one if
+ * the GPU is done with it.  Returns NULL if there is nothing to reuse.
+ */
+static struct brw_bo *
+recycle_growing_buffer(struct brw_growing_bo *grow)
+{
+   struct brw_bo *bo = grow->ring[grow->ring_next];
+
+   grow->ring[grow->ring_next] = grow->bo;
+   grow->ring_next = (grow->ring_next + 1) % BRW_BATCH_RING_SIZE;
+
+   if (bo == NULL)
+      return NULL;
+
+   /* Throttling and glFinish may still be holding on to an old batch to
+    * wait on it; leave those alone rather than have them wait on new work.
+    */
+   if (p_atomic_read(&bo->refcount) == 1 && !brw_bo_busy(bo))
+      return bo;
+
+   brw_bo_unreference(bo);
+   return NULL;
+}
+
 static void
 recreate_growing_buffer(struct brw_context *brw,
                         struct brw_growing_bo *grow,
@@ -232,13 +257,27 @@ recreate_growing_buffer(struct brw_context *brw,
    struct intel_screen *screen = brw->screen;
    struct intel_batchbuffer *batch = &brw->batch;
    struct brw_bufmgr *bufmgr = screen->bufmgr;
+   struct brw_bo *bo = NULL;
 
-   /* We can't grow buffers when using softpin, so just overallocate them. */
-   if (brw_using_softpin(bufmgr))
+   if (brw_using_softpin(bufmgr)) {
+      /* We can't grow buffers when using softpin, so just overallocate them.
+       *
+       * They also keep their address for as long as they live, so reusing
+       * a previous buffer saves the trip through the bufmgr cache and the
+       * kernel never has to bind it again.
+       */
       size *= 2;
+      bo = recycle_growing_buffer(grow);
+   } else {
+      brw_bo_unreference(grow->bo);
+   }
+
+   if (bo == NULL) {
+      bo = brw_bo_alloc(bufmgr, name, size, memzone);
+      bo->kflags |= can_do_exec_capture(screen) ? EXEC_OBJECT_CAPTURE : 0;
+   }
 
-   grow->bo = brw_bo_alloc(bufmgr, name, size, memzone);
-   grow->bo->kflags |= can_do_exec_capture(screen) ? EXEC_OBJECT_CAPTURE : 0;
+   grow->bo = bo;
    grow->partial_bo = NULL;
    grow->partial_bo_map = NULL;
    grow->partial_bytes = 0;
@@ -260,6 +299,8 @@ intel_batchbuffer_reset(struct brw_context *brw)
       batch->last_bo = NULL;
    }
    batch->last_bo = batch->batch.bo;
+   if (batch->last_bo)
+      brw_bo_reference(batch->last_bo);
 
    recreate_growing_buffer(brw, &batch->batch, "batchbuffer", BATCH_SZ,
                            BRW_MEMZONE_OTHER);
@@ -332,6 +373,10 @@ intel_batchbuffer_free(struct intel_batchbuffer *batch)
    brw_bo_unreference(batch->last_bo);
    brw_bo_unreference(batch->batch.bo);
    brw_bo_unreference(batch->state.bo);
+   for (int i = 0; i < BRW_BATCH_RING_SIZE; i++) {
+      brw_bo_unreference(batch->batch.ring[i]);
+      brw_bo_unreference(batch->state.ring[i]);
+   }
    if (batch->state_batch_sizes) {
       _mesa_hash_table_destroy(batch->state_batch_sizes, NULL);
       gen_batch_decode_ctx_finish(&batch->decoder);
@@ -545,8 +590,6 @@ brw_new_batch(struct brw_context *brw)
    brw->batch.exec_count = 0;
    brw->batch.aperture_space = 0;
 
-   brw_bo_unreference(brw->batch.state.bo);
-
    /* Create a new batchbuffer and reset the associated state: */
    intel_batchbuffer_reset_and_clear_render_cache(brw);
 
@@ -735,6 +778,75 @@ execbuffer(int fd,
    return ret;
 }
 
+/**
+ * Queues the batch on the submission thread instead of calling execbuffer
+ * directly.  Returns false if this batch has to be submitted synchronously.
+ */
+static bool
+submit_batch_async(struct brw_context *brw, int used,
+                   int in_fence_fd, int *out_fence_fd, int flags)
+{
+   struct intel_batchbuffer *batch = &brw->batch;
+
+   /* Fences are returned to the caller right away, and the batch decoder
+    * wants the BO list after submission.
+    */
+   if (!batch->use_submit_thread || in_fence_fd != -1 || out_fence_fd ||
+       (INTEL_DEBUG & DEBUG_BATCH))
+      return false;
+
+   /* Anyone we share buffers with expects our rendering to be in the kernel
+    * by the time we return, e.g. the X server after a SwapBuffers.
+    */
+   for (int i = 0; i < batch->exec_count; i++) {
+      if (batch->exec_bos[i]->external)
+         return false;
+   }
+
+   struct drm_i915_gem_exec_object2 *validation_list =
+      malloc(batch->exec_array_size * sizeof(batch->validation_list[0]));
+   struct brw_bo **exec_bos =
+      malloc(batch->exec_array_size * sizeof(batch->exec_bos[0]));
+   if (!validation_list || !exec_bos) {
+      free(validation_list);
+      free(exec_bos);
+      return false;
+   }
+
+   struct drm_i915_gem_execbuffer2 execbuf = {
+      .buffers_ptr = (uintptr_t) batch->validation_list,
+      .buffer_count = batch->exec_count,
+      .batch_start_offset = 0,
+      .batch_len = used,
+      .flags = flags,
+      .rsvd1 = brw->hw_ctx, /* rsvd1 is actually the context ID */
+   };
+
+   /* Softpinned buffers never move, so there's nothing to read back from
+    * the validation list afterwards.
+    */
+   for (int i = 0; i < batch->exec_count; i++) {
+      struct brw_bo *bo = batch->exec_bos[i];
+
+      assert(bo->kflags & EXEC_OBJECT_PINNED);
+      bo->idle = false;
+      bo->index = -1;
+   }
+
+   if (!brw_bufmgr_submit_async(brw->bufmgr, &execbuf, batch->exec_bos)) {
+      free(validation_list);
+      free(exec_bos);
+      return false;
+   }
+
+   /* The submission thread owns the lists and the BO references now. */
+   batch->validation_list = validation_list;
+   batch->exec_bos = exec_bos;
+   batch->exec_count = 0;
+
+   return true;
+}
+
 static int
 submit_batch(struct brw_context *brw, int in_fence_fd, int *out_fence_fd)
 {
@@ -768,6 +880,13 @@ submit_batch(struct brw_context *brw, int in_fence_fd, int *out_fence_fd)
        */
       int flags = I915_EXEC_NO_RELOC | I915_EXEC_RENDER;
 
+      /* Every buffer has a fixed address with softpin, so the kernel should
+       * never have to look at a relocation.
+       */
+      assert(!brw_using_softpin(brw->bufmgr) ||
+             (batch->batch_relocs.reloc_count == 0 &&
+              batch->state_relocs.reloc_count == 0));
+
       if (batch->needs_sol_reset)
          flags |= I915_EXEC_GEN7_SOL_RESET;
 
@@ -805,9 +924,15 @@ submit_batch(struct brw_context *brw, int in_fence_fd, int *out_fence_fd)
          batch->exec_bos[index] = tmp_bo;
       }
 
-      ret = execbuffer(dri_screen->fd, batch, brw->hw_ctx,
-                       4 * USED_BATCH(*batch),
-                       in_fence_fd, out_fence_fd, flags);
+      if (!submit_batch_async(brw, 4 * USED_BATCH(*batch),
+                              in_fence_fd, out_fence_fd, flags)) {
+         /* Anything still queued has to reach the kernel before this. */
+         brw_bufmgr_wait_for_submits(brw->bufmgr);
+
+         ret = execbuffer(dri_screen->fd, batch, brw->hw_ctx,
+                          4 * USED_BATCH(*batch),
+                          in_fence_fd, out_fence_fd, flags);
+      }
 
       throttle(brw);
    }
@@ -61,6 +61,31 @@ DRI_CONF_BEGIN
 	    DRI_CONF_ENUM(1, "Enable reuse of all sizes of buffer objects")
 	 DRI_CONF_DESC_END
       DRI_CONF_OPT_END
+
+      DRI_CONF_OPT_BEGIN_V(bo_cache_high_watermark, int, 0, "0:65536")
+	 DRI_CONF_DESC(en, "Trim the buffer object cache once it holds more "
+                       "than this many megabytes (0 = unlimited)")
+      DRI_CONF_OPT_END
+
+      DRI_CONF_OPT_BEGIN_V(bo_cache_low_watermark, int, 0, "0:65536")
+	 DRI_CONF_DESC(en, "Size in megabytes to trim the buffer object cache "
+                       "back down to (0 = 3/4 of the high watermark)")
+      DRI_CONF_OPT_END
+
+      DRI_CONF_OPT_BEGIN_V(bo_cache_max_age, int, 1, "0:3600")
+	 DRI_CONF_DESC(en, "Seconds an unused buffer object is kept in the "
+                       "cache")
+      DRI_CONF_OPT_END
+
+      DRI_CONF_OPT_BEGIN_B(submit_thread, "false")
+	 DRI_CONF_DESC(en, "Submit batchbuffers to the kernel from a separate "
+                       "thread")
+      DRI_CONF_OPT_END
+
+      DRI_CONF_OPT_BEGIN_B(glsl_optimize_conservatively, "false")
+	 DRI_CONF_DESC(en, "Run the GLSL IR optimization loop only once and "
+                       "leave the rest of the optimization to NIR")
+      DRI_CONF_OPT_END
       DRI_CONF_MESA_NO_ERROR("false")
    DRI_CONF_SECTION_END
 
@@ -92,6 +117,11 @@ DRI_CONF_BEGIN
       DRI_CONF_OPT_BEGIN_B(shader_precompile, "true")
 	 DRI_CONF_DESC(en, "Perform code generation at shader link time.")
       DRI_CONF_OPT_END
+
+      DRI_CONF_OPT_BEGIN_B(shader_precompile_async, "false")
+	 DRI_CONF_DESC(en, "Perform link time code generation on a background "
+                       "thread.")
+      DRI_CONF_OPT_END
    DRI_CONF_SECTION_END
 
    DRI_CONF_SECTION_MISCELLANEOUS
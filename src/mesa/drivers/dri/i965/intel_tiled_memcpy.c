@@ -34,9 +34,22 @@
 #include "util/macros.h"
 
 #include "brw_context.h"
+#include "x86/common_x86_asm.h"
+
+/* intel_tiled_memcpy_avx2.c includes this file to build a second copy of
+ * the tiling functions with AVX2 enabled.  The public entry points of that
+ * copy get an _avx2 suffix and are only called after checking the CPU.
+ */
+#ifdef INLINE_AVX2
+#define linear_to_tiled linear_to_tiled_avx2
+#define tiled_to_linear tiled_to_linear_avx2
+#endif
+
 #include "intel_tiled_memcpy.h"
 
-#if defined(__SSSE3__)
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSSE3__)
 #include <tmmintrin.h>
 #elif defined(__SSE2__)
 #include <emmintrin.h>
@@ -98,8 +111,9 @@ rgba8_copy(void *dst, const void *src, size_t bytes)
 }
 
 #ifdef __SSSE3__
-static const uint8_t rgba8_permutation[16] =
-   { 2,1,0,3, 6,5,4,7, 10,9,8,11, 14,13,12,15 };
+static const uint8_t rgba8_permutation[32] =
+   { 2,1,0,3, 6,5,4,7, 10,9,8,11, 14,13,12,15,
+     2,1,0,3, 6,5,4,7, 10,9,8,11, 14,13,12,15 };
 
 static inline void
 rgba8_copy_16_aligned_dst(void *dst, const void *src)
@@ -117,6 +131,19 @@ rgba8_copy_16_aligned_src(void *dst, const void *src)
                                      *(__m128i *)rgba8_permutation));
 }
 
+#ifdef __AVX2__
+/* The tiled side is only guaranteed to be 16-byte aligned, so the 32-byte
+ * variants use unaligned loads and stores on both sides.
+ */
+static inline void
+rgba8_copy_32(void *dst, const void *src)
+{
+   const __m256i perm = _mm256_loadu_si256((__m256i *)rgba8_permutation);
+
+   _mm256_storeu_si256(dst, _mm256_shuffle_epi8(_mm256_loadu_si256(src), perm));
+}
+#endif
+
 #elif defined(__SSE2__)
 static inline void
 rgba8_copy_16_aligned_dst(void *dst, const void *src)
@@ -161,6 +188,21 @@ rgba8_copy_aligned_dst(void *dst, const void *src, size_t bytes)
 {
    assert(bytes == 0 || !(((uintptr_t)dst) & 0xf));
 
+#if defined(__AVX2__)
+   if (bytes == 64) {
+      rgba8_copy_32(dst +  0, src +  0);
+      rgba8_copy_32(dst + 32, src + 32);
+      return dst;
+   }
+
+   while (bytes >= 32) {
+      rgba8_copy_32(dst, src);
+      src += 32;
+      dst += 32;
+      bytes -= 32;
+   }
+#endif
+
 #if defined(__SSSE3__) || defined(__SSE2__)
    if (bytes == 64) {
       rgba8_copy_16_aligned_dst(dst +  0, src +  0);
@@ -191,6 +233,21 @@ rgba8_copy_aligned_src(void *dst, const void *src, size_t bytes)
 {
    assert(bytes == 0 || !(((uintptr_t)src) & 0xf));
 
+#if defined(__AVX2__)
+   if (bytes == 64) {
+      rgba8_copy_32(dst +  0, src +  0);
+      rgba8_copy_32(dst + 32, src + 32);
+      return dst;
+   }
+
+   while (bytes >= 32) {
+      rgba8_copy_32(dst, src);
+      src += 32;
+      dst += 32;
+      bytes -= 32;
+   }
+#endif
+
 #if defined(__SSSE3__) || defined(__SSE2__)
    if (bytes == 64) {
       rgba8_copy_16_aligned_src(dst +  0, src +  0);
@@ -763,6 +820,22 @@ linear_to_tiled(uint32_t xt1, uint32_t xt2,
    uint32_t tw, th, span;
    uint32_t swizzle_bit = has_swizzling ? 1<<6 : 0;
 
+#if defined(USE_AVX2) && !defined(INLINE_AVX2)
+   if (cpu_has_avx2) {
+      linear_to_tiled_avx2(xt1, xt2, yt1, yt2, dst, src, dst_pitch, src_pitch,
+                           has_swizzling, tiling, mem_copy);
+      return;
+   }
+#endif
+
+#ifdef INLINE_AVX2
+   /* mem_copy comes from intel_get_memcpy() in the other build of this
+    * file, so its rgba8_copy is a different function from ours.
+    */
+   if (mem_copy != memcpy)
+      mem_copy = rgba8_copy;
+#endif
+
    if (tiling == ISL_TILING_X) {
       tw = xtile_width;
       th = xtile_height;
@@ -854,6 +927,22 @@ tiled_to_linear(uint32_t xt1, uint32_t xt2,
    uint32_t tw, th, span;
    uint32_t swizzle_bit = has_swizzling ? 1<<6 : 0;
 
+#if defined(USE_AVX2) && !defined(INLINE_AVX2)
+   if (cpu_has_avx2) {
+      tiled_to_linear_avx2(xt1, xt2, yt1, yt2, dst, src, dst_pitch, src_pitch,
+                           has_swizzling, tiling, mem_copy);
+      return;
+   }
+#endif
+
+#ifdef INLINE_AVX2
+   /* mem_copy comes from intel_get_memcpy() in the other build of this
+    * file, so its rgba8_copy is a different function from ours.
+    */
+   if (mem_copy != memcpy)
+      mem_copy = rgba8_copy;
+#endif
+
    if (tiling == ISL_TILING_X) {
       tw = xtile_width;
       th = xtile_height;
@@ -918,7 +1007,7 @@ tiled_to_linear(uint32_t xt1, uint32_t xt2,
    }
 }
 
-
+#ifndef INLINE_AVX2
 /**
  * Determine which copy function to use for the given format combination
  *
@@ -980,3 +1069,4 @@ bool intel_get_memcpy(mesa_format tiledFormat, GLenum format,
 
    return true;
 }
+#endif /* INLINE_AVX2 */
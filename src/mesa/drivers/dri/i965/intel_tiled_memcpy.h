@@ -55,6 +55,26 @@ tiled_to_linear(uint32_t xt1, uint32_t xt2,
                 enum isl_tiling tiling,
                 mem_copy_fn mem_copy);
 
+#ifdef USE_AVX2
+void
+linear_to_tiled_avx2(uint32_t xt1, uint32_t xt2,
+                     uint32_t yt1, uint32_t yt2,
+                     char *dst, const char *src,
+                     uint32_t dst_pitch, int32_t src_pitch,
+                     bool has_swizzling,
+                     enum isl_tiling tiling,
+                     mem_copy_fn mem_copy);
+
+void
+tiled_to_linear_avx2(uint32_t xt1, uint32_t xt2,
+                     uint32_t yt1, uint32_t yt2,
+                     char *dst, const char *src,
+                     int32_t dst_pitch, uint32_t src_pitch,
+                     bool has_swizzling,
+                     enum isl_tiling tiling,
+                     mem_copy_fn mem_copy);
+#endif
+
 bool intel_get_memcpy(mesa_format tiledFormat, GLenum format,
                       GLenum type, mem_copy_fn *mem_copy, uint32_t *cpp);
 
@@ -737,6 +737,10 @@ OSMesaCreateContextAttribs(const int *attribList, OSMesaContext sharelist)
          if (version_minor < 0)
             return NULL;
          break;
+      case OSMESA_NUM_THREADS:
+      case OSMESA_PIN_THREADS:
+         /* swrast always renders in the calling thread */
+         break;
       case 0:
          /* end of list */
          break;
@@ -492,6 +492,19 @@ struct dd_function_table {
     */
    GLboolean (*LinkShader)(struct gl_context *ctx,
                            struct gl_shader_program *shader);
+
+   /**
+    * GL_ARB_parallel_shader_compile: limit the number of threads the
+    * driver uses to compile shaders in the background.
+    */
+   void (*SetMaxShaderCompilerThreads)(struct gl_context *ctx, unsigned count);
+
+   /**
+    * GL_ARB_parallel_shader_compile: return whether the driver has finished
+    * compiling the shaders of a linked program in the background.
+    */
+   bool (*GetShaderProgramCompletionStatus)(struct gl_context *ctx,
+                                            struct gl_shader_program *shader);
    /*@}*/
 
 
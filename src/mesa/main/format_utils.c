@@ -792,6 +792,72 @@ swizzle_convert_try_memcpy(void *dst,
    return true;
 }
 
+/**
+ * Special case of swizzle-and-convert for widening 1-3 channel ubyte sources
+ * to 4-channel ubyte destinations, e.g. LUMINANCE -> RGBA or RGB -> RGBA.
+ * Each destination pixel is assembled as a single 32-bit word rather than a
+ * byte at a time through the generic loop below.  4-channel sources are
+ * left to the generic loop, which the compiler already handles well.
+ *
+ * The arguments are exactly the same as for _mesa_swizzle_and_convert
+ *
+ * \return  true if it performed the swizzle-and-convert operation, false
+ *          otherwise
+ */
+static bool
+swizzle_convert_try_ubyte4(void *dst,
+                           enum mesa_array_format_datatype dst_type,
+                           int num_dst_channels,
+                           const void *src,
+                           enum mesa_array_format_datatype src_type,
+                           int num_src_channels,
+                           const uint8_t swizzle[4], bool normalized, int count)
+{
+   const uint8_t *s = src;
+   uint32_t *d = dst;
+   /* For a source channel, the destination bytes it ends up in */
+   uint32_t rep[4] = { 0, 0, 0, 0 };
+   /* Constant bytes, i.e. MESA_FORMAT_SWIZZLE_ONE */
+   uint32_t fill = 0;
+   int i, j;
+
+   if (src_type != MESA_ARRAY_FORMAT_TYPE_UBYTE ||
+       dst_type != MESA_ARRAY_FORMAT_TYPE_UBYTE ||
+       num_dst_channels != 4 ||
+       !_mesa_little_endian() ||
+       (uintptr_t) dst % 4 != 0)
+      return false;
+
+   for (j = 0; j < 4; ++j) {
+      if (swizzle[j] <= MESA_FORMAT_SWIZZLE_W) {
+         if (swizzle[j] >= num_src_channels)
+            return false;
+         rep[swizzle[j]] |= 1u << (j * 8);
+      } else if (swizzle[j] == MESA_FORMAT_SWIZZLE_ONE) {
+         fill |= (normalized ? 0xffu : 1u) << (j * 8);
+      }
+   }
+
+   switch (num_src_channels) {
+   case 1:
+      for (i = 0; i < count; ++i)
+         d[i] = fill | s[i] * rep[0];
+      break;
+   case 2:
+      for (i = 0; i < count; ++i, s += 2)
+         d[i] = fill | s[0] * rep[0] | s[1] * rep[1];
+      break;
+   case 3:
+      for (i = 0; i < count; ++i, s += 3)
+         d[i] = fill | s[0] * rep[0] | s[1] * rep[1] | s[2] * rep[2];
+      break;
+   default:
+      return false;
+   }
+
+   return true;
+}
+
 /**
  * Represents a single instance of the standard swizzle-and-convert loop
  *
@@ -1511,6 +1577,11 @@ _mesa_swizzle_and_convert(void *void_dst, enum mesa_array_format_datatype dst_ty
                                   swizzle, normalized, count))
       return;
 
+   if (swizzle_convert_try_ubyte4(void_dst, dst_type, num_dst_channels,
+                                  void_src, src_type, num_src_channels,
+                                  swizzle, normalized, count))
+      return;
+
    switch (dst_type) {
    case MESA_ARRAY_FORMAT_TYPE_FLOAT:
       convert_float(void_dst, num_dst_channels, void_src, src_type,
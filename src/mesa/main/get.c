@@ -514,6 +514,7 @@ EXTRA_EXT(OES_primitive_bounding_box);
 EXTRA_EXT(ARB_compute_variable_group_size);
 EXTRA_EXT(KHR_robustness);
 EXTRA_EXT(ARB_sparse_buffer);
+EXTRA_EXT(ARB_parallel_shader_compile);
 EXTRA_EXT(NV_conservative_raster);
 EXTRA_EXT(NV_conservative_raster_dilate);
 EXTRA_EXT(NV_conservative_raster_pre_snap_triangles);
@@ -1467,7 +1468,7 @@ find_value(const char *func, GLenum pname, void **p, union value *v)
          api = API_OPENGL_LAST + 1;
    }
    mask = ARRAY_SIZE(table(api)) - 1;
-   hash = (pname * prime_factor);
+   hash = ((uint32_t) pname * hash_factor) >> hash_shift;
    while (1) {
       int idx = table(api)[hash & mask];
 
@@ -1484,7 +1485,7 @@ find_value(const char *func, GLenum pname, void **p, union value *v)
       if (likely(d->pname == pname))
          break;
 
-      hash += prime_step;
+      hash++;
    }
 
    if (unlikely(d->extra && !check_extra(ctx, func, d)))
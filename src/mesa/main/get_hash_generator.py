@@ -41,16 +41,25 @@ GLAPI = "%s/../../mapi/glapi/gen" % cur_dir
 sys.path.append(GLAPI)
 import gl_XML
 
-prime_factor = 89
-prime_step = 281
-hash_table_size = 1024
+# The tables are indexed with a multiplicative (Fibonacci) hash: the top
+# hash_table_bits bits of the 32-bit product enum * hash_factor, followed by
+# linear probing on collision.  The factor was picked by a search over random
+# odd multipliers for the fewest probes on the current parameter lists: most
+# lookups hit on the first probe and none needs more than four.  Any odd
+# factor is correct, so new parameters only make a few lookups slower.
+hash_factor = 874513325
+hash_table_bits = 11
+hash_table_size = 1 << hash_table_bits
+
+def hash_index(enum_val):
+   return ((enum_val * hash_factor) & 0xffffffff) >> (32 - hash_table_bits)
 
 gl_apis=set(["GL", "GL_CORE", "GLES", "GLES2", "GLES3", "GLES31", "GLES32"])
 
 def print_header():
    print("typedef const unsigned short table_t[%d];\n" % (hash_table_size))
-   print("static const int prime_factor = %d, prime_step = %d;\n" % \
-          (prime_factor, prime_step))
+   print("static const uint32_t hash_factor = %du, hash_shift = %d;\n" % \
+          (hash_factor, 32 - hash_table_bits))
 
 def print_params(params):
    print("static const struct value_desc values[] = {")
@@ -132,7 +141,7 @@ def add_to_hash_table(table, hash_val, value):
       if index not in table:
          table[index] = value
          break
-      hash_val += prime_step
+      hash_val += 1
 
 def die(msg):
    sys.stderr.write("%s: %s\n" % (program, msg))
@@ -166,7 +175,7 @@ def generate_hash_tables(enum_list, enabled_apis, param_descriptors):
       for param in param_block["params"]:
          enum_name = param[0]
          enum_val = enum_list[enum_name].value
-         hash_val = enum_val * prime_factor
+         hash_val = hash_index(enum_val)
 
          for api in valid_apis:
             add_to_hash_table(tables[api], hash_val, len(params))
@@ -34,8 +34,13 @@
 
 #include "main/mtypes.h"
 #include "main/glthread.h"
+#include "main/debug_output.h"
+#include "main/macros.h"
 #include "main/marshal.h"
 #include "main/marshal_generated.h"
+#include "util/hash_table.h"
+#include "util/u_cpu_trace.h"
+#include "util/ralloc.h"
 #include "util/u_atomic.h"
 #include "util/u_thread.h"
 
@@ -91,6 +96,17 @@ _mesa_glthread_init(struct gl_context *ctx)
       util_queue_fence_init(&glthread->batches[i].fence);
    }
 
+   glthread->batch_size = MARSHAL_MAX_CMD_SIZE;
+   glthread->direct_interval = GLTHREAD_DIRECT_FRAMES;
+
+   /* If these fail, locations are just never cached. */
+   glthread->uniform_locations =
+      _mesa_hash_table_create(NULL, _mesa_hash_pointer,
+                              _mesa_key_pointer_equal);
+   glthread->attrib_locations =
+      _mesa_hash_table_create(NULL, _mesa_hash_pointer,
+                              _mesa_key_pointer_equal);
+
    glthread->stats.queue = &glthread->queue;
    ctx->CurrentClientDispatch = ctx->MarshalExec;
    ctx->GLThread = glthread;
@@ -118,6 +134,15 @@ _mesa_glthread_destroy(struct gl_context *ctx)
    for (unsigned i = 0; i < MARSHAL_MAX_BATCHES; i++)
       util_queue_fence_destroy(&glthread->batches[i].fence);
 
+   for (unsigned i = 0; i < GLTHREAD_MAX_STAGED_MAPS; i++)
+      free(glthread->staged_maps[i].data);
+
+   /* The per-program tables are allocated out of these. */
+   if (glthread->uniform_locations)
+      _mesa_hash_table_destroy(glthread->uniform_locations, NULL);
+   if (glthread->attrib_locations)
+      _mesa_hash_table_destroy(glthread->attrib_locations, NULL);
+
    free(glthread);
    ctx->GLThread = NULL;
 
@@ -150,6 +175,8 @@ _mesa_glthread_flush_batch(struct gl_context *ctx)
    if (!next->used)
       return;
 
+   MESA_TRACE_FUNC();
+
    /* Debug: execute the batch immediately from this thread.
     *
     * Note that glthread_unmarshal_batch() changes the dispatch table so we'll
@@ -162,6 +189,7 @@ _mesa_glthread_flush_batch(struct gl_context *ctx)
    }
 
    p_atomic_add(&glthread->stats.num_offloaded_items, next->used);
+   glthread->frame_bytes += next->used;
 
    util_queue_add_job(&glthread->queue, next, &next->fence,
                       glthread_unmarshal_batch, NULL);
@@ -201,6 +229,7 @@ _mesa_glthread_finish(struct gl_context *ctx)
 
    if (next->used) {
       p_atomic_add(&glthread->stats.num_direct_items, next->used);
+      glthread->frame_bytes += next->used;
 
       /* Since glthread_unmarshal_batch changes the dispatch to direct,
        * restore it after it's done.
@@ -215,6 +244,150 @@ _mesa_glthread_finish(struct gl_context *ctx)
       synced = true;
    }
 
-   if (synced)
+   if (synced) {
       p_atomic_inc(&glthread->stats.num_syncs);
+      glthread->frame_syncs++;
+   }
+}
+
+static void
+free_program_locations(struct hash_entry *entry)
+{
+   ralloc_free(entry->data);
+}
+
+/** Forgets all cached uniform and attribute locations. */
+void
+_mesa_glthread_clear_locations(struct gl_context *ctx)
+{
+   struct glthread_state *glthread = ctx->GLThread;
+
+   if (glthread->uniform_locations)
+      _mesa_hash_table_clear(glthread->uniform_locations,
+                             free_program_locations);
+   if (glthread->attrib_locations)
+      _mesa_hash_table_clear(glthread->attrib_locations,
+                             free_program_locations);
+}
+
+/**
+ * Forgets the cached locations of a program, because it was linked (which
+ * reassigns them) or deleted (after which the name may be reused).
+ */
+void
+_mesa_glthread_ProgramChanged(struct gl_context *ctx, GLuint program)
+{
+   struct glthread_state *glthread = ctx->GLThread;
+   const void *key = (const void *) (uintptr_t) program;
+   struct hash_entry *entry;
+
+   if (!glthread || !program)
+      return;
+
+   if (glthread->uniform_locations &&
+       (entry = _mesa_hash_table_search(glthread->uniform_locations, key))) {
+      ralloc_free(entry->data);
+      _mesa_hash_table_remove(glthread->uniform_locations, entry);
+   }
+   if (glthread->attrib_locations &&
+       (entry = _mesa_hash_table_search(glthread->attrib_locations, key))) {
+      ralloc_free(entry->data);
+      _mesa_hash_table_remove(glthread->attrib_locations, entry);
+   }
+}
+
+/**
+ * Switches back to the marshalling dispatch table after
+ * glthread_use_direct_dispatch.
+ */
+static void
+glthread_use_marshal_dispatch(struct gl_context *ctx)
+{
+   struct glthread_state *glthread = ctx->GLThread;
+
+   /* The binding tracking wasn't updated while we were direct. */
+   glthread->vertex_array_is_vbo = ctx->Array.ArrayBufferObj->Name != 0;
+   glthread->element_array_is_vbo =
+      ctx->Array.VAO->IndexBufferObj->Name != 0;
+   glthread->array_buffer = ctx->Array.ArrayBufferObj->Name;
+   glthread->copy_write_buffer = ctx->CopyWriteBuffer->Name;
+   glthread->pixel_unpack_buffer = ctx->Unpack.BufferObj->Name;
+
+   /* Programs may have been relinked or deleted without us noticing. */
+   _mesa_glthread_clear_locations(ctx);
+
+   ctx->CurrentClientDispatch = ctx->MarshalExec;
+   _glapi_set_dispatch(ctx->CurrentClientDispatch);
+}
+
+/** Returns false if our dispatch table wasn't the one installed. */
+static bool
+glthread_use_direct_dispatch(struct gl_context *ctx)
+{
+   /* Staged mappings have to be unmapped through glthread. */
+   if (ctx->GLThread->num_staged_maps)
+      return false;
+
+   _mesa_glthread_finish(ctx);
+   _mesa_glthread_restore_dispatch(ctx);
+
+   return ctx->CurrentClientDispatch != ctx->MarshalExec;
+}
+
+/**
+ * Called by the main thread at the end of every frame.
+ *
+ * Applications that keep calling into functions that need a sync with the
+ * worker (glGet*, glMapBuffer, ...) end up slower with glthread than
+ * without, so count syncs per frame and go direct while they're frequent.
+ * This also picks the batch size from the amount of commands per frame.
+ */
+void
+_mesa_glthread_end_frame(struct gl_context *ctx)
+{
+   struct glthread_state *glthread = ctx->GLThread;
+   if (!glthread)
+      return;
+
+   if (glthread->direct) {
+      if (--glthread->direct_frames_left > 0)
+         return;
+
+      /* Don't come back if something else took over the dispatch, or if
+       * glthread has been disabled for synchronous debug output meanwhile.
+       */
+      if (_glapi_get_dispatch() != ctx->CurrentServerDispatch ||
+          _mesa_get_debug_state_int(ctx, GL_DEBUG_OUTPUT_SYNCHRONOUS)) {
+         glthread->direct_frames_left = glthread->direct_interval;
+         return;
+      }
+
+      glthread->direct = false;
+      glthread->slow_frames = 0;
+      glthread->frame_syncs = 0;
+      glthread->frame_bytes = 0;
+      glthread_use_marshal_dispatch(ctx);
+      return;
+   }
+
+   if (ctx->CurrentClientDispatch != ctx->MarshalExec)
+      return;
+
+   if (glthread->frame_syncs > GLTHREAD_MAX_SYNCS_PER_FRAME) {
+      if (++glthread->slow_frames >= GLTHREAD_SLOW_FRAMES &&
+          glthread_use_direct_dispatch(ctx)) {
+         glthread->direct = true;
+         glthread->direct_frames_left = glthread->direct_interval;
+         glthread->direct_interval = MIN2(glthread->direct_interval * 2,
+                                          GLTHREAD_MAX_DIRECT_FRAMES);
+      }
+   } else {
+      glthread->slow_frames = 0;
+   }
+
+   glthread->batch_size =
+      CLAMP(ALIGN(glthread->frame_bytes / MARSHAL_BATCHES_PER_FRAME, 8),
+            MARSHAL_MIN_BATCH_SIZE, MARSHAL_MAX_CMD_SIZE);
+   glthread->frame_syncs = 0;
+   glthread->frame_bytes = 0;
 }
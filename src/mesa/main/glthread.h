@@ -43,12 +43,60 @@
  */
 #define MARSHAL_MAX_BATCHES 8
 
+/* The smallest batch we flush once it fills up.
+ *
+ * Apps that marshal little per frame get smaller batches, down to this
+ * size, so that the worker can start on a frame before it's all recorded.
+ */
+#define MARSHAL_MIN_BATCH_SIZE 1024
+
+/* The number of batches we aim to split a frame's worth of commands into. */
+#define MARSHAL_BATCHES_PER_FRAME 8
+
+/* When the main thread has to wait for the worker more than this many times
+ * per frame, for GLTHREAD_SLOW_FRAMES frames in a row, glthread is costing
+ * more than it saves and we go back to calling the driver directly.
+ */
+#define GLTHREAD_MAX_SYNCS_PER_FRAME 32
+#define GLTHREAD_SLOW_FRAMES 8
+
+/* After going direct, we try glthread again after this many frames.  Each
+ * time it turns out to be slow again, the wait doubles, up to the maximum.
+ */
+#define GLTHREAD_DIRECT_FRAMES 64
+#define GLTHREAD_MAX_DIRECT_FRAMES 4096
+
+/* Uploads that don't fit in a batch are copied to the heap and queued
+ * anyway, up to this size.  Larger uploads are executed synchronously.
+ */
+#define MARSHAL_MAX_UPLOAD_SIZE (16 * 1024 * 1024)
+
+/* The number of unsynchronized mappings that can be staged at once. */
+#define GLTHREAD_MAX_STAGED_MAPS 4
+
 #include <inttypes.h>
 #include <stdbool.h>
 #include "util/u_queue.h"
+#include "main/glheader.h"
 
 enum marshal_dispatch_cmd_id;
 struct gl_context;
+struct hash_table;
+
+/**
+ * A write-only, unsynchronized buffer mapping that is backed by memory on
+ * the main thread and uploaded with a queued glBufferSubData.
+ */
+struct glthread_staged_map
+{
+   /** The buffer target, or 0 if the slot is free. */
+   GLenum target;
+   GLuint buffer;
+   GLintptr offset;
+   GLsizeiptr length;
+   GLbitfield access;
+   void *data;
+};
 
 /** A single batch of commands queued up for execution. */
 struct glthread_batch
@@ -83,6 +131,26 @@ struct glthread_state
    /** Index of the batch being filled and about to be submitted. */
    unsigned next;
 
+   /** A batch is flushed once it would grow past this many bytes. */
+   size_t batch_size;
+
+   /** Bytes of commands marshalled in the current frame. */
+   size_t frame_bytes;
+
+   /** Times the main thread waited for the worker in the current frame. */
+   unsigned frame_syncs;
+
+   /** Consecutive frames with more than GLTHREAD_MAX_SYNCS_PER_FRAME syncs. */
+   unsigned slow_frames;
+
+   /**
+    * Whether we switched to direct dispatch because of too many syncs, and
+    * how many frames remain until we try glthread again.
+    */
+   bool direct;
+   unsigned direct_frames_left;
+   unsigned direct_interval;
+
    /**
     * Tracks on the main thread side whether the current vertex array binding
     * is in a VBO.
@@ -94,6 +162,26 @@ struct glthread_state
     * buffer) binding is in a VBO.
     */
    bool element_array_is_vbo;
+
+   /**
+    * Uniform and attribute locations that were looked up on the main thread,
+    * per program name.  They are dropped when the program is linked or
+    * deleted.
+    */
+   struct hash_table *uniform_locations;
+   struct hash_table *attrib_locations;
+
+   /**
+    * Tracks on the main thread side which buffers are bound to the targets
+    * that mappings can be staged for.
+    */
+   GLuint array_buffer;
+   GLuint copy_write_buffer;
+   GLuint pixel_unpack_buffer;
+
+   /** Unsynchronized mappings that haven't been unmapped yet. */
+   struct glthread_staged_map staged_maps[GLTHREAD_MAX_STAGED_MAPS];
+   unsigned num_staged_maps;
 };
 
 void _mesa_glthread_init(struct gl_context *ctx);
@@ -102,5 +190,8 @@ void _mesa_glthread_destroy(struct gl_context *ctx);
 void _mesa_glthread_restore_dispatch(struct gl_context *ctx);
 void _mesa_glthread_flush_batch(struct gl_context *ctx);
 void _mesa_glthread_finish(struct gl_context *ctx);
+void _mesa_glthread_end_frame(struct gl_context *ctx);
+void _mesa_glthread_clear_locations(struct gl_context *ctx);
+void _mesa_glthread_ProgramChanged(struct gl_context *ctx, GLuint program);
 
 #endif /* _GLTHREAD_H*/
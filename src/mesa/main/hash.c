@@ -38,6 +38,25 @@
 #include "glheader.h"
 #include "hash.h"
 #include "util/hash_table.h"
+#include "util/u_atomic.h"
+
+
+/**
+ * Allocate a zeroed dense array with room for keys < size.
+ */
+static struct _mesa_HashDenseArray *
+hash_dense_create(GLuint size)
+{
+   struct _mesa_HashDenseArray *dense =
+      calloc(1, sizeof(*dense) + size * sizeof(void *));
+
+   if (dense) {
+      dense->Size = size;
+      dense->Data = (void **) (dense + 1);
+   }
+
+   return dense;
+}
 
 
 /**
@@ -59,6 +78,14 @@ _mesa_NewHashTable(void)
          return NULL;
       }
 
+      table->Dense = hash_dense_create(HASH_DENSE_INITIAL_SIZE);
+      if (table->Dense == NULL) {
+         _mesa_hash_table_destroy(table->ht, NULL);
+         free(table);
+         _mesa_error_no_memory(__func__);
+         return NULL;
+      }
+
       _mesa_hash_table_set_deleted_key(table->ht, uint_key(DELETED_KEY_VALUE));
       /*
        * Needs to be recursive, since the callback in _mesa_HashWalk()
@@ -86,14 +113,22 @@ _mesa_NewHashTable(void)
 void
 _mesa_DeleteHashTable(struct _mesa_HashTable *table)
 {
+   struct _mesa_HashDenseArray *dense, *prev;
+
    assert(table);
 
-   if (_mesa_hash_table_next_entry(table->ht, NULL) != NULL) {
+   if (_mesa_hash_table_next_entry(table->ht, NULL) != NULL ||
+       table->DenseEntries) {
       _mesa_problem(NULL, "In _mesa_DeleteHashTable, found non-freed data");
    }
 
    _mesa_hash_table_destroy(table->ht, NULL);
 
+   for (dense = table->Dense; dense; dense = prev) {
+      prev = dense->Prev;
+      free(dense);
+   }
+
    mtx_destroy(&table->Mutex);
    free(table);
 }
@@ -112,8 +147,8 @@ _mesa_HashLookup_unlocked(struct _mesa_HashTable *table, GLuint key)
    assert(table);
    assert(key);
 
-   if (key == DELETED_KEY_VALUE)
-      return table->deleted_key_data;
+   if (key < table->Dense->Size)
+      return table->Dense->Data[key];
 
    entry = _mesa_hash_table_search_pre_hashed(table->ht,
                                               uint_hash(key),
@@ -136,7 +171,15 @@ _mesa_HashLookup_unlocked(struct _mesa_HashTable *table, GLuint key)
 void *
 _mesa_HashLookup(struct _mesa_HashTable *table, GLuint key)
 {
+   const struct _mesa_HashDenseArray *dense = p_atomic_read(&table->Dense);
    void *res;
+
+   /* Small keys are looked up without locking.  If the dense array grows
+    * to include the key meanwhile, the locked path below sees the new one.
+    */
+   if (key < dense->Size)
+      return p_atomic_read(&dense->Data[key]);
+
    _mesa_HashLockMutex(table);
    res = _mesa_HashLookup_unlocked(table, key);
    _mesa_HashUnlockMutex(table);
@@ -162,6 +205,64 @@ _mesa_HashLookupLocked(struct _mesa_HashTable *table, GLuint key)
 }
 
 
+/**
+ * Replace the dense array by one that holds keys < size, moving the entries
+ * for those keys out of the hash table.
+ *
+ * Readers which loaded the old array keep using it, so it is freed only with
+ * the table.  The arrays at least double in size each time, which bounds the
+ * memory kept that way to the size of the current one.
+ */
+static void
+hash_dense_grow(struct _mesa_HashTable *table, GLuint size)
+{
+   struct _mesa_HashDenseArray *old = table->Dense;
+   struct _mesa_HashDenseArray *dense = hash_dense_create(size);
+   struct hash_entry *entry;
+
+   /* Out of memory isn't fatal, the keys just stay in the hash table */
+   if (!dense)
+      return;
+
+   memcpy(dense->Data, old->Data, old->Size * sizeof(void *));
+   dense->Prev = old;
+
+   hash_table_foreach(table->ht, entry) {
+      GLuint key = (uintptr_t) entry->key;
+
+      if (key < size) {
+         dense->Data[key] = entry->data;
+         table->DenseEntries++;
+         _mesa_hash_table_remove(table->ht, entry);
+      }
+   }
+
+   p_atomic_set(&table->Dense, dense);
+}
+
+
+/**
+ * Grow the dense array to include key when it would end up at least a
+ * quarter full, which is the case for names coming from glGen*().
+ */
+static void
+hash_dense_maybe_grow(struct _mesa_HashTable *table, GLuint key)
+{
+   GLuint size = table->Dense->Size;
+   GLuint num_entries = table->DenseEntries +
+                        _mesa_hash_table_num_entries(table->ht) + 1;
+
+   if (key >= HASH_DENSE_MAX_SIZE)
+      return;
+
+   while (size <= key)
+      size *= 2;
+
+   if (size <= 4 * num_entries)
+      hash_dense_grow(table, size);
+}
+
+
 static inline void
 _mesa_HashInsert_unlocked(struct _mesa_HashTable *table, GLuint key, void *data)
 {
@@ -174,8 +275,18 @@ _mesa_HashInsert_unlocked(struct _mesa_HashTable *table, GLuint key, void *data)
    if (key > table->MaxKey)
       table->MaxKey = key;
 
-   if (key == DELETED_KEY_VALUE) {
-      table->deleted_key_data = data;
+   if (key >= table->Dense->Size)
+      hash_dense_maybe_grow(table, key);
+
+   if (key < table->Dense->Size) {
+      void **slot = &table->Dense->Data[key];
+
+      if (!*slot && data)
+         table->DenseEntries++;
+      else if (*slot && !data)
+         table->DenseEntries--;
+
+      p_atomic_set(slot, data);
    } else {
       entry = _mesa_hash_table_search_pre_hashed(table->ht, hash, uint_key(key));
       if (entry) {
@@ -244,8 +355,18 @@ _mesa_HashRemove_unlocked(struct _mesa_HashTable *table, GLuint key)
     */
    assert(!table->InDeleteAll);
 
-   if (key == DELETED_KEY_VALUE) {
-      table->deleted_key_data = NULL;
+   if (key < table->Dense->Size) {
+      struct _mesa_HashDenseArray *dense;
+
+      if (table->Dense->Data[key])
+         table->DenseEntries--;
+
+      /* Also clear the entry in the replaced arrays, so that a stale reader
+       * doesn't get an object that's about to be freed.
+       */
+      for (dense = table->Dense; dense && key < dense->Size;
+           dense = dense->Prev)
+         p_atomic_set(&dense->Data[key], NULL);
    } else {
       entry = _mesa_hash_table_search_pre_hashed(table->ht,
                                                  uint_hash(key),
@@ -283,19 +404,28 @@ _mesa_HashDeleteAll(struct _mesa_HashTable *table,
                     void (*callback)(GLuint key, void *data, void *userData),
                     void *userData)
 {
+   struct _mesa_HashDenseArray *dense;
    struct hash_entry *entry;
+   GLuint key;
 
    assert(callback);
    _mesa_HashLockMutex(table);
    table->InDeleteAll = GL_TRUE;
+   for (key = 1; key < table->Dense->Size; key++) {
+      void *data = table->Dense->Data[key];
+
+      if (data) {
+         callback(key, data, userData);
+         for (dense = table->Dense; dense && key < dense->Size;
+              dense = dense->Prev)
+            p_atomic_set(&dense->Data[key], NULL);
+      }
+   }
+   table->DenseEntries = 0;
    hash_table_foreach(table->ht, entry) {
       callback((uintptr_t)entry->key, entry->data, userData);
       _mesa_hash_table_remove(table->ht, entry);
    }
-   if (table->deleted_key_data) {
-      callback(DELETED_KEY_VALUE, table->deleted_key_data, userData);
-      table->deleted_key_data = NULL;
-   }
    table->InDeleteAll = GL_FALSE;
    _mesa_HashUnlockMutex(table);
 }
@@ -316,12 +446,17 @@ hash_walk_unlocked(const struct _mesa_HashTable *table,
    assert(table);
    assert(callback);
 
+   /* The callback may insert or remove entries, so reload the array */
+   for (GLuint key = 1; key < table->Dense->Size; key++) {
+      void *data = table->Dense->Data[key];
+      if (data)
+         callback(key, data, userData);
+   }
+
    struct hash_entry *entry;
    hash_table_foreach(table->ht, entry) {
       callback((uintptr_t)entry->key, entry->data, userData);
    }
-   if (table->deleted_key_data)
-      callback(DELETED_KEY_VALUE, table->deleted_key_data, userData);
 }
 
 
@@ -360,8 +495,6 @@ debug_print_entry(GLuint key, void *data, void *userData)
 void
 _mesa_HashPrint(const struct _mesa_HashTable *table)
 {
-   if (table->deleted_key_data)
-      debug_print_entry(DELETED_KEY_VALUE, table->deleted_key_data, NULL);
    _mesa_HashWalk(table, debug_print_entry, NULL);
 }
 
@@ -418,12 +551,5 @@ _mesa_HashFindFreeKeyBlock(struct _mesa_HashTable *table, GLuint numKeys)
 GLuint
 _mesa_HashNumEntries(const struct _mesa_HashTable *table)
 {
-   GLuint count = 0;
-
-   if (table->deleted_key_data)
-      count++;
-
-   count += _mesa_hash_table_num_entries(table->ht);
-
-   return count;
+   return table->DenseEntries + _mesa_hash_table_num_entries(table->ht);
 }
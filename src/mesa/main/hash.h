@@ -37,7 +37,7 @@
 #include "c11/threads.h"
 
 /**
- * Magic GLuint object name that gets stored outside of the struct hash_table.
+ * Magic GLuint object name that never gets stored in the struct hash_table.
  *
  * The hash table needs a particular pointer to be the marker for a key that
  * was deleted from the table, along with NULL for the "never allocated in the
@@ -45,10 +45,16 @@
  * and we use a 1:1 mapping from GLuints to key pointers, so we need to be
  * able to track a GLuint that happens to match the deleted key outside of
  * struct hash_table.  We tell the hash table to use "1" as the deleted key
- * value, so that we test the deleted-key-in-the-table path as best we can.
+ * value, which always lives in the dense array (see _mesa_HashDenseArray).
  */
 #define DELETED_KEY_VALUE 1
 
+/** Size of the dense array of a new table, must be > DELETED_KEY_VALUE */
+#define HASH_DENSE_INITIAL_SIZE 64
+
+/** Maximum size of the dense array, larger keys always go in the hash */
+#define HASH_DENSE_MAX_SIZE (1 << 20)
+
 /** @{
  * Mapping from our use of GLuint as both the key and the hash value to the
  * hash_table.h API
@@ -93,16 +99,31 @@ uint_key(GLuint id)
 }
 /** @} */
 
+/**
+ * Array storage for small keys, indexed directly by the key.
+ *
+ * The names handed out by glGen*() are small and mostly contiguous, so they
+ * are kept here rather than in the hash table, and looked up without taking
+ * the mutex.  The array is only ever replaced by a bigger copy under the
+ * mutex, and replaced copies are kept around until the table is destroyed,
+ * so a reader still holding an old pointer never touches freed memory.
+ */
+struct _mesa_HashDenseArray {
+   GLuint Size;                          /**< keys < Size are stored here */
+   void **Data;                          /**< Size entries, NULL if unused */
+   struct _mesa_HashDenseArray *Prev;    /**< the smaller copy replaced */
+};
+
 /**
  * The hash table data structure.
  */
 struct _mesa_HashTable {
-   struct hash_table *ht;
+   struct hash_table *ht;                /**< keys >= Dense->Size */
+   struct _mesa_HashDenseArray *Dense;   /**< keys < Dense->Size */
+   GLuint DenseEntries;                  /**< non-NULL entries in Dense */
    GLuint MaxKey;                        /**< highest key inserted so far */
    mtx_t Mutex;                          /**< mutual exclusion lock */
    GLboolean InDeleteAll;                /**< Debug check */
-   /** Value that would be in the table for DELETED_KEY_VALUE. */
-   void *deleted_key_data;
 };
 
 extern struct _mesa_HashTable *_mesa_NewHashTable(void);
@@ -29,9 +29,12 @@
 
 #include "main/enums.h"
 #include "main/macros.h"
+#include "main/mtypes.h"
 #include "marshal.h"
 #include "dispatch.h"
 #include "marshal_generated.h"
+#include "util/hash_table.h"
+#include "util/ralloc.h"
 
 struct marshal_cmd_Flush
 {
@@ -247,6 +250,61 @@ track_vbo_binding(struct gl_context *ctx, GLenum target, GLuint buffer)
 }
 
 
+/**
+ * Returns where the buffer bound to \p target is tracked, if mappings of it
+ * can be staged.  The targets are ones that only glBindBuffer changes.
+ */
+static GLuint *
+staged_map_binding(struct glthread_state *glthread, GLenum target)
+{
+   switch (target) {
+   case GL_ARRAY_BUFFER:
+      return &glthread->array_buffer;
+   case GL_COPY_WRITE_BUFFER:
+      return &glthread->copy_write_buffer;
+   case GL_PIXEL_UNPACK_BUFFER:
+      return &glthread->pixel_unpack_buffer;
+   default:
+      return NULL;
+   }
+}
+
+static void
+track_staged_map_binding(struct gl_context *ctx, GLenum target,
+                         GLuint buffer)
+{
+   GLuint *binding = staged_map_binding(ctx->GLThread, target);
+
+   if (binding)
+      *binding = buffer;
+}
+
+static struct glthread_staged_map *
+find_staged_map(struct glthread_state *glthread, GLenum target)
+{
+   const GLuint *binding = staged_map_binding(glthread, target);
+
+   if (!glthread->num_staged_maps || !binding || !*binding)
+      return NULL;
+
+   for (unsigned i = 0; i < GLTHREAD_MAX_STAGED_MAPS; i++) {
+      if (glthread->staged_maps[i].target == target &&
+          glthread->staged_maps[i].buffer == *binding)
+         return &glthread->staged_maps[i];
+   }
+   return NULL;
+}
+
+static void
+release_staged_map(struct glthread_state *glthread,
+                   struct glthread_staged_map *map)
+{
+   map->target = 0;
+   map->data = NULL;
+   glthread->num_staged_maps--;
+}
+
+
 struct marshal_cmd_BindBuffer
 {
    struct marshal_cmd_base cmd_base;
@@ -275,6 +333,7 @@ _mesa_marshal_BindBuffer(GLenum target, GLuint buffer)
    debug_print_marshal("BindBuffer");
 
    track_vbo_binding(ctx, target, buffer);
+   track_staged_map_binding(ctx, target, buffer);
 
    if (cmd_size <= MARSHAL_MAX_CMD_SIZE) {
       cmd = _mesa_glthread_allocate_command(ctx, DISPATCH_CMD_BindBuffer,
@@ -321,10 +380,17 @@ _mesa_marshal_BufferData(GLenum target, GLsizeiptr size, const GLvoid * data,
                          GLenum usage)
 {
    GET_CURRENT_CONTEXT(ctx);
+   struct glthread_staged_map *map = find_staged_map(ctx->GLThread, target);
    size_t cmd_size =
       sizeof(struct marshal_cmd_BufferData) + (data ? size : 0);
    debug_print_marshal("BufferData");
 
+   /* Respecifying the data store unmaps the buffer. */
+   if (map) {
+      free(map->data);
+      release_staged_map(ctx->GLThread, map);
+   }
+
    if (unlikely(size < 0)) {
       _mesa_glthread_finish(ctx);
       _mesa_error(ctx, GL_INVALID_VALUE, "BufferData(size < 0)");
@@ -360,7 +426,11 @@ struct marshal_cmd_BufferSubData
    GLenum target;
    GLintptr offset;
    GLsizeiptr size;
-   /* Next size bytes are GLubyte data[size] */
+   /* If set, the data didn't fit in the batch and is stored here instead.
+    * It is freed after the call.  Otherwise, the next size bytes are
+    * GLubyte data[size].
+    */
+   void *heap_data;
 };
 
 void
@@ -370,10 +440,30 @@ _mesa_unmarshal_BufferSubData(struct gl_context *ctx,
    const GLenum target = cmd->target;
    const GLintptr offset = cmd->offset;
    const GLsizeiptr size = cmd->size;
-   const void *data = (const void *) (cmd + 1);
+   const void *data = cmd->heap_data ? cmd->heap_data :
+                                       (const void *) (cmd + 1);
 
    CALL_BufferSubData(ctx->CurrentServerDispatch,
                       (target, offset, size, data));
+   free(cmd->heap_data);
+}
+
+/**
+ * Queues a glBufferSubData whose data is in a heap allocation, which is
+ * handed over to the worker thread.
+ */
+static void
+marshal_buffer_sub_data_heap(struct gl_context *ctx, GLenum target,
+                             GLintptr offset, GLsizeiptr size, void *data)
+{
+   struct marshal_cmd_BufferSubData *cmd =
+      _mesa_glthread_allocate_command(ctx, DISPATCH_CMD_BufferSubData,
+                                      sizeof(*cmd));
+   cmd->target = target;
+   cmd->offset = offset;
+   cmd->size = size;
+   cmd->heap_data = data;
+   _mesa_post_marshal_hook(ctx);
 }
 
 void GLAPIENTRY
@@ -398,16 +488,278 @@ _mesa_marshal_BufferSubData(GLenum target, GLintptr offset, GLsizeiptr size,
       cmd->target = target;
       cmd->offset = offset;
       cmd->size = size;
+      cmd->heap_data = NULL;
       char *variable_data = (char *) (cmd + 1);
       memcpy(variable_data, data, size);
       _mesa_post_marshal_hook(ctx);
+      return;
+   }
+
+   /* Copying a large upload is still much cheaper than waiting for the
+    * worker thread to go idle.
+    */
+   if (target != GL_EXTERNAL_VIRTUAL_MEMORY_BUFFER_AMD &&
+       size <= MARSHAL_MAX_UPLOAD_SIZE && data) {
+      void *copy = malloc(size);
+
+      if (copy) {
+         memcpy(copy, data, size);
+         marshal_buffer_sub_data_heap(ctx, target, offset, size, copy);
+         return;
+      }
+   }
+
+   _mesa_glthread_finish(ctx);
+   CALL_BufferSubData(ctx->CurrentServerDispatch,
+                      (target, offset, size, data));
+}
+
+/* MapBufferRange, FlushMappedBufferRange, UnmapBuffer: unsynchronized
+ * write-only mappings are staged
+ *
+ * The application doesn't care when the data lands in the buffer with
+ * GL_MAP_UNSYNCHRONIZED_BIT, as long as it's before the next command that
+ * uses it, so instead of waiting for the worker thread to
+ * map the buffer, hand out memory on the main thread and upload it with
+ * glBufferSubData when it is flushed or unmapped.  Everything else waits for
+ * the worker thread and maps the buffer for real.
+ */
+void * GLAPIENTRY
+_mesa_marshal_MapBufferRange(GLenum target, GLintptr offset,
+                             GLsizeiptr length, GLbitfield access)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   struct glthread_state *glthread = ctx->GLThread;
+   const GLuint *binding = staged_map_binding(glthread, target);
+   const GLbitfield staged_access = GL_MAP_WRITE_BIT |
+                                    GL_MAP_UNSYNCHRONIZED_BIT;
+   const GLbitfield optional_access = GL_MAP_INVALIDATE_RANGE_BIT |
+                                      GL_MAP_INVALIDATE_BUFFER_BIT |
+                                      GL_MAP_FLUSH_EXPLICIT_BIT;
+
+   debug_print_marshal("MapBufferRange");
+
+   /* Without invalidation or explicit flushes, the bytes of the range that
+    * the application doesn't write must be preserved, which staging can't
+    * do.
+    */
+   if ((access & ~optional_access) == staged_access &&
+       (access & optional_access) &&
+       binding && *binding && offset >= 0 && length > 0 &&
+       length <= MARSHAL_MAX_UPLOAD_SIZE &&
+       glthread->num_staged_maps < GLTHREAD_MAX_STAGED_MAPS &&
+       !find_staged_map(glthread, target)) {
+      void *data = malloc(length);
+
+      if (data) {
+         struct glthread_staged_map *map = glthread->staged_maps;
+
+         while (map->target)
+            map++;
+
+         map->target = target;
+         map->buffer = *binding;
+         map->offset = offset;
+         map->length = length;
+         map->access = access;
+         map->data = data;
+         glthread->num_staged_maps++;
+         return data;
+      }
+   }
+
+   _mesa_glthread_finish(ctx);
+   debug_print_sync("MapBufferRange");
+   return CALL_MapBufferRange(ctx->CurrentServerDispatch,
+                              (target, offset, length, access));
+}
+
+void GLAPIENTRY
+_mesa_marshal_FlushMappedBufferRange(GLenum target, GLintptr offset,
+                                     GLsizeiptr length)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   struct glthread_staged_map *map = find_staged_map(ctx->GLThread, target);
+
+   debug_print_marshal("FlushMappedBufferRange");
+
+   if (map && (map->access & GL_MAP_FLUSH_EXPLICIT_BIT) &&
+       offset >= 0 && length >= 0 && offset + length <= map->length) {
+      if (length) {
+         _mesa_marshal_BufferSubData(target, map->offset + offset, length,
+                                     (const char *) map->data + offset);
+      }
+      return;
+   }
+
+   _mesa_glthread_finish(ctx);
+   debug_print_sync("FlushMappedBufferRange");
+   CALL_FlushMappedBufferRange(ctx->CurrentServerDispatch,
+                               (target, offset, length));
+}
+
+GLboolean GLAPIENTRY
+_mesa_marshal_UnmapBuffer(GLenum target)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   struct glthread_state *glthread = ctx->GLThread;
+   struct glthread_staged_map *map = find_staged_map(glthread, target);
+
+   debug_print_marshal("UnmapBuffer");
+
+   if (map) {
+      /* With explicit flushes, everything was uploaded already. */
+      if (map->access & GL_MAP_FLUSH_EXPLICIT_BIT)
+         free(map->data);
+      else
+         marshal_buffer_sub_data_heap(ctx, target, map->offset, map->length,
+                                      map->data);
+      release_staged_map(glthread, map);
+      return GL_TRUE;
+   }
+
+   _mesa_glthread_finish(ctx);
+   debug_print_sync("UnmapBuffer");
+   return CALL_UnmapBuffer(ctx->CurrentServerDispatch, (target));
+}
+
+/**
+ * Called after glDeleteBuffers is queued.  Deleting a buffer unbinds and
+ * unmaps it.
+ */
+void
+_mesa_glthread_DeleteBuffers(struct gl_context *ctx, GLsizei n,
+                             const GLuint *buffers)
+{
+   struct glthread_state *glthread = ctx->GLThread;
+
+   if (!glthread || n < 0 || !buffers)
+      return;
+
+   for (GLsizei i = 0; i < n; i++) {
+      const GLuint buffer = buffers[i];
+
+      if (!buffer)
+         continue;
+
+      if (glthread->array_buffer == buffer)
+         glthread->array_buffer = 0;
+      if (glthread->copy_write_buffer == buffer)
+         glthread->copy_write_buffer = 0;
+      if (glthread->pixel_unpack_buffer == buffer)
+         glthread->pixel_unpack_buffer = 0;
+
+      for (unsigned j = 0; j < GLTHREAD_MAX_STAGED_MAPS; j++) {
+         struct glthread_staged_map *map = &glthread->staged_maps[j];
+
+         if (map->target && map->buffer == buffer) {
+            free(map->data);
+            release_staged_map(glthread, map);
+         }
+      }
+   }
+}
+
+/* GetUniformLocation, GetAttribLocation: cached on the main thread
+ *
+ * Applications tend to look up the same locations over and over, and each
+ * lookup would wait for the worker thread.  Results are remembered per
+ * program until it's linked or deleted (see _mesa_glthread_ProgramChanged),
+ * which the main thread always sees.  With shared contexts, another thread
+ * can relink the program behind our back, so nothing is cached then.
+ */
+static struct hash_entry *
+lookup_location(struct gl_context *ctx, struct hash_table *cache,
+                GLuint program, const GLchar *name)
+{
+   if (!cache || !program || !name)
+      return NULL;
+
+   if (ctx->Shared->RefCount > 1) {
+      _mesa_glthread_clear_locations(ctx);
+      return NULL;
+   }
+
+   struct hash_entry *entry =
+      _mesa_hash_table_search(cache, (const void *) (uintptr_t) program);
+   if (!entry)
+      return NULL;
+
+   return _mesa_hash_table_search(entry->data, name);
+}
+
+static void
+cache_location(struct gl_context *ctx, struct hash_table *cache,
+               GLuint program, const GLchar *name, GLint location)
+{
+   /* Not finding something may be an error, which has to be raised again
+    * next time.
+    */
+   if (!cache || !program || !name || location < 0 ||
+       ctx->Shared->RefCount > 1)
+      return;
+
+   const void *key = (const void *) (uintptr_t) program;
+   struct hash_table *locations;
+   struct hash_entry *entry = _mesa_hash_table_search(cache, key);
+
+   if (entry) {
+      locations = entry->data;
    } else {
-      _mesa_glthread_finish(ctx);
-      CALL_BufferSubData(ctx->CurrentServerDispatch,
-                         (target, offset, size, data));
+      locations = _mesa_hash_table_create(cache, _mesa_key_hash_string,
+                                          _mesa_key_string_equal);
+      if (!locations)
+         return;
+      _mesa_hash_table_insert(cache, key, locations);
+   }
+
+   char *name_copy = ralloc_strdup(locations, name);
+   if (name_copy) {
+      _mesa_hash_table_insert(locations, name_copy,
+                              (void *) (intptr_t) location);
    }
 }
 
+GLint GLAPIENTRY
+_mesa_marshal_GetUniformLocation(GLuint program, const GLchar *name)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   struct hash_table *cache = ctx->GLThread->uniform_locations;
+   struct hash_entry *entry = lookup_location(ctx, cache, program, name);
+
+   debug_print_marshal("GetUniformLocation");
+
+   if (entry)
+      return (GLint) (intptr_t) entry->data;
+
+   _mesa_glthread_finish(ctx);
+   debug_print_sync("GetUniformLocation");
+   GLint location = CALL_GetUniformLocation(ctx->CurrentServerDispatch,
+                                            (program, name));
+   cache_location(ctx, cache, program, name, location);
+   return location;
+}
+
+GLint GLAPIENTRY
+_mesa_marshal_GetAttribLocation(GLuint program, const GLchar *name)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   struct hash_table *cache = ctx->GLThread->attrib_locations;
+   struct hash_entry *entry = lookup_location(ctx, cache, program, name);
+
+   debug_print_marshal("GetAttribLocation");
+
+   if (entry)
+      return (GLint) (intptr_t) entry->data;
+
+   _mesa_glthread_finish(ctx);
+   debug_print_sync("GetAttribLocation");
+   GLint location = CALL_GetAttribLocation(ctx->CurrentServerDispatch,
+                                           (program, name));
+   cache_location(ctx, cache, program, name, location);
+   return location;
+}
+
 /* NamedBufferData: marshalled asynchronously */
 struct marshal_cmd_NamedBufferData
 {
@@ -57,7 +57,7 @@ _mesa_glthread_allocate_command(struct gl_context *ctx,
    struct marshal_cmd_base *cmd_base;
    const size_t aligned_size = ALIGN(size, 8);
 
-   if (unlikely(next->used + size > MARSHAL_MAX_CMD_SIZE)) {
+   if (unlikely(next->used + size > glthread->batch_size)) {
       _mesa_glthread_flush_batch(ctx);
       next = &glthread->batches[glthread->next];
    }
@@ -281,4 +281,25 @@ void GLAPIENTRY
 _mesa_marshal_ClearBufferfi(GLenum buffer, GLint drawbuffer,
                             const GLfloat depth, const GLint stencil);
 
+void * GLAPIENTRY
+_mesa_marshal_MapBufferRange(GLenum target, GLintptr offset,
+                             GLsizeiptr length, GLbitfield access);
+
+void GLAPIENTRY
+_mesa_marshal_FlushMappedBufferRange(GLenum target, GLintptr offset,
+                                     GLsizeiptr length);
+
+GLboolean GLAPIENTRY
+_mesa_marshal_UnmapBuffer(GLenum target);
+
+void
+_mesa_glthread_DeleteBuffers(struct gl_context *ctx, GLsizei n,
+                             const GLuint *buffers);
+
+GLint GLAPIENTRY
+_mesa_marshal_GetUniformLocation(GLuint program, const GLchar *name);
+
+GLint GLAPIENTRY
+_mesa_marshal_GetAttribLocation(GLuint program, const GLchar *name);
+
 #endif /* MARSHAL_H */
@@ -41,6 +41,12 @@
 #include "util/half_float.h"
 #include "util/format_rgb9e5.h"
 #include "util/format_r11g11b10f.h"
+#include "util/u_queue.h"
+#include "c11/threads.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 
 /**
@@ -163,6 +169,48 @@ bytes_per_pixel(GLenum datatype, GLuint comps)
 /*@}*/
 
 
+#ifdef __SSE2__
+/**
+ * Average 2x2 blocks of RGBA8 pixels, four destination pixels at a time.
+ * Rounds like the C path of do_row.
+ *
+ * \return the number of destination pixels written.
+ */
+static GLuint
+do_row_rgba8_sse2(const GLubyte *rowA, const GLubyte *rowB,
+                  GLuint dstWidth, GLubyte *dst)
+{
+   const __m128i zero = _mm_setzero_si128();
+   GLuint i;
+
+   for (i = 0; i + 4 <= dstWidth; i += 4) {
+      __m128i half[2];
+
+      for (unsigned h = 0; h < 2; h++) {
+         const __m128i a = _mm_loadu_si128((const __m128i *)
+                                           (rowA + (2 * i + 4 * h) * 4));
+         const __m128i b = _mm_loadu_si128((const __m128i *)
+                                           (rowB + (2 * i + 4 * h) * 4));
+         /* Vertical sums of pixels 0, 1 and 2, 3 as 16-bit channels. */
+         __m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(a, zero),
+                                    _mm_unpacklo_epi8(b, zero));
+         __m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(a, zero),
+                                    _mm_unpackhi_epi8(b, zero));
+         /* Horizontal sums of the pixel pairs. */
+         lo = _mm_add_epi16(lo, _mm_srli_si128(lo, 8));
+         hi = _mm_add_epi16(hi, _mm_srli_si128(hi, 8));
+         half[h] = _mm_srli_epi16(_mm_unpacklo_epi64(lo, hi), 2);
+      }
+
+      _mm_storeu_si128((__m128i *) (dst + i * 4),
+                       _mm_packus_epi16(half[0], half[1]));
+   }
+
+   return i;
+}
+#endif
+
+
 /**
  * Average together two rows of a source image to produce a single new
  * row in the dest image.  It's legal for the two source rows to point
@@ -187,11 +235,15 @@ do_row(GLenum datatype, GLuint comps, GLint srcWidth,
    */
 
    if (datatype == GL_UNSIGNED_BYTE && comps == 4) {
-      GLuint i, j, k;
+      GLuint i = 0, j, k;
       const GLubyte(*rowA)[4] = (const GLubyte(*)[4]) srcRowA;
       const GLubyte(*rowB)[4] = (const GLubyte(*)[4]) srcRowB;
       GLubyte(*dst)[4] = (GLubyte(*)[4]) dstRow;
-      for (i = j = 0, k = k0; i < (GLuint) dstWidth;
+#ifdef __SSE2__
+      if (colStride == 2)
+         i = do_row_rgba8_sse2(srcRowA, srcRowB, dstWidth, dstRow);
+#endif
+      for (j = i * colStride, k = j + k0; i < (GLuint) dstWidth;
            i++, j += colStride, k += colStride) {
          dst[i][0] = (rowA[j][0] + rowA[k][0] + rowB[j][0] + rowB[k][0]) / 4;
          dst[i][1] = (rowA[j][1] + rowA[k][1] + rowB[j][1] + rowB[k][1]) / 4;
@@ -1467,6 +1519,108 @@ make_1d_mipmap(GLenum datatype, GLuint comps, GLint border,
 }
 
 
+/**
+ * Destination images with at least this many pixels are downsampled in
+ * bands of rows on the shared worker pool.
+ */
+#define MIPMAP_PARALLEL_MIN_PIXELS (256 * 256)
+#define MIPMAP_MAX_BANDS 8
+
+/**
+ * A band of destination rows of make_2d_mipmap.
+ */
+struct mipmap_band {
+   GLenum datatype;
+   GLuint comps;
+   GLint srcWidth, dstWidth;
+   const GLubyte *srcA, *srcB;
+   GLint srcRowStride;   /**< from one destination row to the next */
+   GLubyte *dst;
+   GLint dstRowStride;
+   GLint numRows;
+   struct util_queue_fence fence;
+};
+
+static struct util_queue mipmap_queue;
+static once_flag mipmap_queue_once = ONCE_FLAG_INIT;
+
+static void
+init_mipmap_queue(void)
+{
+   /* Failure only means that all rows are generated on the calling thread. */
+   util_queue_init(&mipmap_queue, "mipmap", MIPMAP_MAX_BANDS,
+                   MIPMAP_MAX_BANDS, UTIL_QUEUE_INIT_SHARED);
+}
+
+static void
+make_2d_mipmap_band(void *data, int thread_index)
+{
+   struct mipmap_band *band = (struct mipmap_band *) data;
+   const GLubyte *srcA = band->srcA, *srcB = band->srcB;
+   GLubyte *dst = band->dst;
+
+   for (GLint row = 0; row < band->numRows; row++) {
+      do_row(band->datatype, band->comps, band->srcWidth, srcA, srcB,
+             band->dstWidth, dst);
+      srcA += band->srcRowStride;
+      srcB += band->srcRowStride;
+      dst += band->dstRowStride;
+   }
+}
+
+/**
+ * Downsample the rows of a 2D image, splitting large images into bands of
+ * rows which run in parallel. The result doesn't depend on the split.
+ */
+static void
+make_2d_mipmap_rows(GLenum datatype, GLuint comps,
+                    GLint srcWidth, const GLubyte *srcA, const GLubyte *srcB,
+                    GLint srcRowStride,
+                    GLint dstWidth, GLint dstHeight,
+                    GLubyte *dst, GLint dstRowStride)
+{
+   struct mipmap_band bands[MIPMAP_MAX_BANDS];
+   unsigned num_bands = 1;
+
+   if ((int64_t) dstWidth * dstHeight >= MIPMAP_PARALLEL_MIN_PIXELS) {
+      call_once(&mipmap_queue_once, init_mipmap_queue);
+      if (util_queue_is_initialized(&mipmap_queue))
+         num_bands = MIN2(MIPMAP_MAX_BANDS, dstHeight);
+   }
+
+   const GLint rows_per_band = DIV_ROUND_UP(dstHeight, num_bands);
+
+   for (unsigned i = 0; i < num_bands; i++) {
+      const GLint first = i * rows_per_band;
+
+      bands[i].datatype = datatype;
+      bands[i].comps = comps;
+      bands[i].srcWidth = srcWidth;
+      bands[i].dstWidth = dstWidth;
+      bands[i].srcA = srcA + (int64_t) first * srcRowStride;
+      bands[i].srcB = srcB + (int64_t) first * srcRowStride;
+      bands[i].srcRowStride = srcRowStride;
+      bands[i].dst = dst + (int64_t) first * dstRowStride;
+      bands[i].dstRowStride = dstRowStride;
+      bands[i].numRows = CLAMP(dstHeight - first, 0, rows_per_band);
+   }
+
+   /* The calling thread generates the first band itself. */
+   for (unsigned i = 1; i < num_bands; i++) {
+      util_queue_fence_init(&bands[i].fence);
+      util_queue_add_job(&mipmap_queue, &bands[i], &bands[i].fence,
+                         make_2d_mipmap_band, NULL);
+   }
+
+   make_2d_mipmap_band(&bands[0], 0);
+
+   for (unsigned i = 1; i < num_bands; i++) {
+      util_queue_fence_wait(&bands[i].fence);
+      util_queue_fence_destroy(&bands[i].fence);
+   }
+}
+
+
 static void
 make_2d_mipmap(GLenum datatype, GLuint comps, GLint border,
                GLint srcWidth, GLint srcHeight,
@@ -1497,13 +1651,9 @@ make_2d_mipmap(GLenum datatype, GLuint comps, GLint border,
 
    dst = dstPtr + border * ((dstWidth + 1) * bpt);
 
-   for (row = 0; row < dstHeightNB; row++) {
-      do_row(datatype, comps, srcWidthNB, srcA, srcB,
-             dstWidthNB, dst);
-      srcA += srcRowStep * srcRowStride;
-      srcB += srcRowStep * srcRowStride;
-      dst += dstRowStride;
-   }
+   make_2d_mipmap_rows(datatype, comps, srcWidthNB, srcA, srcB,
+                       srcRowStep * srcRowStride,
+                       dstWidthNB, dstHeightNB, dst, dstRowStride);
 
    /* This is ugly but probably won't be used much */
    if (border > 0) {
@@ -692,6 +692,14 @@ get_programiv(struct gl_context *ctx, GLuint program, GLenum pname,
    case GL_LINK_STATUS:
       *params = shProg->data->LinkStatus ? GL_TRUE : GL_FALSE;
       return;
+   case GL_COMPLETION_STATUS_ARB:
+      if (!ctx->Extensions.ARB_parallel_shader_compile)
+         break;
+      if (ctx->Driver.GetShaderProgramCompletionStatus)
+         *params = ctx->Driver.GetShaderProgramCompletionStatus(ctx, shProg);
+      else
+         *params = GL_TRUE;
+      return;
    case GL_VALIDATE_STATUS:
       *params = shProg->data->Validated;
       return;
@@ -940,6 +948,19 @@ get_programiv(struct gl_context *ctx, GLuint program, GLenum pname,
 }
 
 
+/**
+ * glCompileShader() defers the compile of shaders found in the shader cache
+ * to link time, so they have no info log yet. Compile such a shader now if
+ * the application asks for its log, so that warnings are still reported.
+ */
+static void
+ensure_shader_info_log(struct gl_context *ctx, struct gl_shader *sh)
+{
+   if (sh->CompileStatus == COMPILE_SKIPPED)
+      _mesa_glsl_compile_shader(ctx, sh, false, false, true);
+}
+
+
 /**
  * glGetShaderiv() - get GLSL shader state
  */
@@ -963,7 +984,18 @@ get_shaderiv(struct gl_context *ctx, GLuint name, GLenum pname, GLint *params)
    case GL_COMPILE_STATUS:
       *params = shader->CompileStatus ? GL_TRUE : GL_FALSE;
       break;
+   case GL_COMPLETION_STATUS_ARB:
+      /* Compilation happens synchronously, only linked programs may still
+       * be compiled by the driver in the background.
+       */
+      if (!ctx->Extensions.ARB_parallel_shader_compile) {
+         _mesa_error(ctx, GL_INVALID_ENUM, "glGetShaderiv(pname)");
+         return;
+      }
+      *params = GL_TRUE;
+      break;
    case GL_INFO_LOG_LENGTH:
+      ensure_shader_info_log(ctx, shader);
       *params = (shader->InfoLog && shader->InfoLog[0] != '\0') ?
          strlen(shader->InfoLog) + 1 : 0;
       break;
@@ -1029,6 +1061,7 @@ get_shader_info_log(struct gl_context *ctx, GLuint shader, GLsizei bufSize,
       return;
    }
 
+   ensure_shader_info_log(ctx, sh);
    _mesa_copy_string(infoLog, bufSize, length, sh->InfoLog);
 }
 
@@ -2863,7 +2896,7 @@ _mesa_UniformSubroutinesuiv(GLenum shadertype, GLsizei count,
       }
 
       if (!flushed) {
-         _mesa_flush_vertices_for_uniforms(ctx, uni);
+         _mesa_flush_vertices_for_uniforms(ctx, NULL, uni);
          flushed = true;
       }
 
@@ -92,3 +92,129 @@ _mesa_uint_array_min_max(const unsigned *ui_indices, unsigned *min_index,
    *min_index = min_ui;
    *max_index = max_ui;
 }
+
+void
+_mesa_ushort_array_min_max(const uint16_t *us_indices, unsigned *min_index,
+                           unsigned *max_index, const unsigned count)
+{
+   unsigned max_us = 0;
+   unsigned min_us = ~0U;
+   unsigned i = 0;
+   unsigned aligned_count = count;
+
+   /* handle the first few values without SSE until the pointer is aligned */
+   while (((uintptr_t)us_indices & 15) && aligned_count) {
+      if (*us_indices > max_us)
+         max_us = *us_indices;
+      if (*us_indices < min_us)
+         min_us = *us_indices;
+
+      aligned_count--;
+      us_indices++;
+   }
+
+   if (aligned_count >= 16) {
+      unsigned vec_count;
+      unsigned vec_min, vec_max;
+      __m128i max_us8 = _mm_setzero_si128();
+      __m128i min_us8 = _mm_set1_epi16(-1);
+      __m128i us_indices8;
+      __m128i *us_indices_ptr;
+
+      vec_count = aligned_count & ~0x7;
+      us_indices_ptr = (__m128i *)us_indices;
+      for (i = 0; i < vec_count / 8; i++) {
+         us_indices8 = _mm_load_si128(&us_indices_ptr[i]);
+         max_us8 = _mm_max_epu16(us_indices8, max_us8);
+         min_us8 = _mm_min_epu16(us_indices8, min_us8);
+      }
+
+      /* PHMINPOSUW reduces the 8 lanes at once; the maximum is the
+       * complement of the minimum of the complemented lanes.
+       */
+      min_us8 = _mm_minpos_epu16(min_us8);
+      max_us8 = _mm_minpos_epu16(_mm_xor_si128(max_us8, _mm_set1_epi16(-1)));
+
+      vec_min = _mm_extract_epi16(min_us8, 0);
+      vec_max = 0xffff - _mm_extract_epi16(max_us8, 0);
+      if (vec_max > max_us)
+         max_us = vec_max;
+      if (vec_min < min_us)
+         min_us = vec_min;
+      i = vec_count;
+   }
+
+   for (; i < aligned_count; i++) {
+      if (us_indices[i] > max_us)
+         max_us = us_indices[i];
+      if (us_indices[i] < min_us)
+         min_us = us_indices[i];
+   }
+
+   *min_index = min_us;
+   *max_index = max_us;
+}
+
+void
+_mesa_ubyte_array_min_max(const uint8_t *ub_indices, unsigned *min_index,
+                          unsigned *max_index, const unsigned count)
+{
+   unsigned max_ub = 0;
+   unsigned min_ub = ~0U;
+   unsigned i = 0;
+   unsigned aligned_count = count;
+
+   /* handle the first few values without SSE until the pointer is aligned */
+   while (((uintptr_t)ub_indices & 15) && aligned_count) {
+      if (*ub_indices > max_ub)
+         max_ub = *ub_indices;
+      if (*ub_indices < min_ub)
+         min_ub = *ub_indices;
+
+      aligned_count--;
+      ub_indices++;
+   }
+
+   if (aligned_count >= 32) {
+      unsigned vec_count;
+      unsigned vec_min, vec_max;
+      __m128i max_ub16 = _mm_setzero_si128();
+      __m128i min_ub16 = _mm_set1_epi8(-1);
+      __m128i ub_indices16;
+      __m128i *ub_indices_ptr;
+
+      vec_count = aligned_count & ~0xf;
+      ub_indices_ptr = (__m128i *)ub_indices;
+      for (i = 0; i < vec_count / 16; i++) {
+         ub_indices16 = _mm_load_si128(&ub_indices_ptr[i]);
+         max_ub16 = _mm_max_epu8(ub_indices16, max_ub16);
+         min_ub16 = _mm_min_epu8(ub_indices16, min_ub16);
+      }
+
+      /* Widen to 16-bit lanes and reduce with PHMINPOSUW as above. */
+      min_ub16 = _mm_min_epu8(min_ub16, _mm_srli_epi16(min_ub16, 8));
+      min_ub16 = _mm_minpos_epu16(_mm_and_si128(min_ub16,
+                                                _mm_set1_epi16(0xff)));
+      max_ub16 = _mm_max_epu8(max_ub16, _mm_srli_epi16(max_ub16, 8));
+      max_ub16 = _mm_minpos_epu16(_mm_andnot_si128(max_ub16,
+                                                   _mm_set1_epi16(0xff)));
+
+      vec_min = _mm_extract_epi16(min_ub16, 0);
+      vec_max = 0xff - _mm_extract_epi16(max_ub16, 0);
+      if (vec_max > max_ub)
+         max_ub = vec_max;
+      if (vec_min < min_ub)
+         min_ub = vec_min;
+      i = vec_count;
+   }
+
+   for (; i < aligned_count; i++) {
+      if (ub_indices[i] > max_ub)
+         max_ub = ub_indices[i];
+      if (ub_indices[i] < min_ub)
+         min_ub = ub_indices[i];
+   }
+
+   *min_index = min_ub;
+   *max_index = max_ub;
+}
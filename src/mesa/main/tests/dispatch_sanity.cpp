@@ -1118,6 +1118,9 @@ const struct function common_desktop_functions_possible[] = {
    { "glBufferPageCommitmentARB", 43, -1 },
    { "glNamedBufferPageCommitmentARB", 43, -1 },
 
+   /* GL_ARB_parallel_shader_compile */
+   { "glMaxShaderCompilerThreadsARB", 11, -1 },
+
    /* GL_ARB_bindless_texture */
    { "glGetTextureHandleARB", 40, -1 },
    { "glGetTextureSamplerHandleARB", 40, -1 },
@@ -30,6 +30,9 @@
  */
 
 
+#include "c11/threads.h"
+#include "util/u_queue.h"
+
 #include "glheader.h"
 #include "imports.h"
 #include "context.h"
@@ -43,6 +46,10 @@
 #include "texcompress_etc.h"
 #include "texcompress_bptc.h"
 
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
 
 /**
  * Get the GL base format of a specified GL compressed texture format
@@ -912,3 +919,108 @@ _mesa_decompress_image(mesa_format format, GLuint width, GLuint height,
       }
    }
 }
+
+
+/** Maximum number of bands an image is split into */
+#define TEXCOMPRESS_MAX_JOBS 8
+
+/** Images smaller than this are always processed on the calling thread */
+#define TEXCOMPRESS_MIN_PIXELS (256 * 256)
+
+/** Minimum number of block rows handed to a single job */
+#define TEXCOMPRESS_MIN_BLOCK_ROWS 8
+
+struct texcompress_job {
+   struct util_queue_fence fence;
+   texcompress_rows_func func;
+   void *data;
+   unsigned y, height;
+};
+
+static struct util_queue texcompress_queue;
+static once_flag texcompress_queue_once_flag = ONCE_FLAG_INIT;
+
+static void
+texcompress_queue_init(void)
+{
+   unsigned num_threads = 0;
+
+#if defined(_SC_NPROCESSORS_ONLN)
+   long num_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+   if (num_cpus > 1)
+      num_threads = MIN2(num_cpus - 1, TEXCOMPRESS_MAX_JOBS - 1);
+#endif
+
+   /* The calling thread always processes a band itself, so a single CPU
+    * doesn't need the queue at all.
+    */
+   if (num_threads > 0)
+      util_queue_init(&texcompress_queue, "texc", TEXCOMPRESS_MAX_JOBS,
+                      num_threads, 0);
+}
+
+static void
+texcompress_job_execute(void *data, int thread_index)
+{
+   struct texcompress_job *job = data;
+
+   job->func(job->data, job->y, job->height);
+}
+
+/**
+ * Run func over all rows of a width x height image, splitting the image
+ * into bands of whole block rows which are processed in parallel on a
+ * queue shared by all contexts.
+ *
+ * func must only touch the blocks in the rows it's handed, which holds for
+ * all of the block encoders and decoders since blocks are independent.
+ * Small images and single CPU systems are processed on the calling thread.
+ */
+void
+_mesa_texcompress_rows(unsigned width, unsigned height,
+                       unsigned block_height,
+                       texcompress_rows_func func, void *data)
+{
+   struct texcompress_job jobs[TEXCOMPRESS_MAX_JOBS];
+   unsigned block_rows = DIV_ROUND_UP(height, block_height);
+   unsigned num_jobs, rows_per_job, i;
+
+   if (width * height < TEXCOMPRESS_MIN_PIXELS ||
+       block_rows < 2 * TEXCOMPRESS_MIN_BLOCK_ROWS) {
+      func(data, 0, height);
+      return;
+   }
+
+   call_once(&texcompress_queue_once_flag, texcompress_queue_init);
+   if (!util_queue_is_initialized(&texcompress_queue)) {
+      func(data, 0, height);
+      return;
+   }
+
+   num_jobs = MIN3(texcompress_queue.num_threads + 1,
+                   block_rows / TEXCOMPRESS_MIN_BLOCK_ROWS,
+                   TEXCOMPRESS_MAX_JOBS);
+   rows_per_job = DIV_ROUND_UP(block_rows, num_jobs) * block_height;
+
+   for (i = 0; i < num_jobs; i++) {
+      jobs[i].func = func;
+      jobs[i].data = data;
+      jobs[i].y = i * rows_per_job;
+      jobs[i].height = MIN2(rows_per_job, height - MIN2(jobs[i].y, height));
+   }
+
+   /* The last band is processed here while the queue does the others */
+   for (i = 0; i < num_jobs - 1; i++) {
+      util_queue_fence_init(&jobs[i].fence);
+      util_queue_add_job(&texcompress_queue, &jobs[i], &jobs[i].fence,
+                         texcompress_job_execute, NULL);
+   }
+
+   if (jobs[num_jobs - 1].height)
+      func(data, jobs[num_jobs - 1].y, jobs[num_jobs - 1].height);
+
+   for (i = 0; i < num_jobs - 1; i++) {
+      util_queue_fence_wait(&jobs[i].fence);
+      util_queue_fence_destroy(&jobs[i].fence);
+   }
+}
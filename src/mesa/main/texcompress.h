@@ -58,6 +58,19 @@ extern compressed_fetch_func
 _mesa_get_compressed_fetch_func(mesa_format format);
 
 
+/**
+ * A function to process the rows [y, y + height) of an image.  y is always
+ * a multiple of the block height passed to _mesa_texcompress_rows().
+ */
+typedef void (*texcompress_rows_func)(void *data,
+                                      unsigned y, unsigned height);
+
+extern void
+_mesa_texcompress_rows(unsigned width, unsigned height,
+                       unsigned block_height,
+                       texcompress_rows_func func, void *data);
+
+
 extern void
 _mesa_decompress_image(mesa_format format, GLuint width, GLuint height,
                        const GLubyte *src, GLint srcRowStride,
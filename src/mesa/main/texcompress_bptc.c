@@ -122,6 +122,34 @@ _mesa_get_bptc_fetch_func(mesa_format format)
    }
 }
 
+struct bptc_compress_job {
+   int width;
+   const void *src;
+   int src_rowstride;
+   uint8_t *dst;
+   int dst_rowstride;
+   bool is_float;
+   bool is_signed;
+};
+
+static void
+bptc_compress_rows(void *data, unsigned y, unsigned height)
+{
+   const struct bptc_compress_job *job = data;
+   const uint8_t *src = (const uint8_t *) job->src + y * job->src_rowstride;
+   uint8_t *dst = job->dst + (y / 4) * job->dst_rowstride;
+
+   if (job->is_float)
+      compress_rgb_float(job->width, height,
+                         (const float *) src, job->src_rowstride,
+                         dst, job->dst_rowstride,
+                         job->is_signed);
+   else
+      compress_rgba_unorm(job->width, height,
+                          src, job->src_rowstride,
+                          dst, job->dst_rowstride);
+}
+
 GLboolean
 _mesa_texstore_bptc_rgba_unorm(TEXSTORE_PARAMS)
 {
@@ -158,9 +186,15 @@ _mesa_texstore_bptc_rgba_unorm(TEXSTORE_PARAMS)
                                          srcFormat, srcType);
    }
 
-   compress_rgba_unorm(srcWidth, srcHeight,
-                       pixels, rowstride,
-                       dstSlices[0], dstRowStride);
+   struct bptc_compress_job job = {
+      .width = srcWidth,
+      .src = pixels,
+      .src_rowstride = rowstride,
+      .dst = dstSlices[0],
+      .dst_rowstride = dstRowStride,
+   };
+
+   _mesa_texcompress_rows(srcWidth, srcHeight, 4, bptc_compress_rows, &job);
 
    free((void *) tempImage);
 
@@ -203,10 +237,17 @@ texstore_bptc_rgb_float(TEXSTORE_PARAMS,
                                          srcFormat, srcType);
    }
 
-   compress_rgb_float(srcWidth, srcHeight,
-                      pixels, rowstride,
-                      dstSlices[0], dstRowStride,
-                      is_signed);
+   struct bptc_compress_job job = {
+      .width = srcWidth,
+      .src = pixels,
+      .src_rowstride = rowstride,
+      .dst = dstSlices[0],
+      .dst_rowstride = dstRowStride,
+      .is_float = true,
+      .is_signed = is_signed,
+   };
+
+   _mesa_texcompress_rows(srcWidth, srcHeight, 4, bptc_compress_rows, &job);
 
    free((void *) tempImage);
 
@@ -115,6 +115,23 @@ _mesa_texstore_etc1_rgb8(UNUSED_TEXSTORE_PARAMS)
 }
 
 
+/**
+ * The arguments of a decode, for splitting it into bands with
+ * _mesa_texcompress_rows()
+ */
+struct etc_unpack_job {
+   uint8_t *dst_row;
+   unsigned dst_stride;
+   const uint8_t *src_row;
+   unsigned src_stride;
+   unsigned src_width;
+   mesa_format format;
+   bool bgra;
+};
+
+static void
+etc_unpack_rows(void *data, unsigned y, unsigned height);
+
 /**
  * Decode texture data in format `MESA_FORMAT_ETC1_RGB8` to
  * `MESA_FORMAT_ABGR8888`.
@@ -142,9 +159,16 @@ _mesa_etc1_unpack_rgba8888(uint8_t *dst_row,
                            unsigned src_width,
                            unsigned src_height)
 {
-   etc1_unpack_rgba8888(dst_row, dst_stride,
-                        src_row, src_stride,
-                        src_width, src_height);
+   struct etc_unpack_job job = {
+      .dst_row = dst_row,
+      .dst_stride = dst_stride,
+      .src_row = src_row,
+      .src_stride = src_stride,
+      .src_width = src_width,
+      .format = MESA_FORMAT_ETC1_RGB8,
+   };
+
+   _mesa_texcompress_rows(src_width, src_height, 4, etc_unpack_rows, &job);
 }
 
 static uint8_t
@@ -1189,6 +1213,59 @@ _mesa_texstore_etc2_srgb8_punchthrough_alpha1(UNUSED_TEXSTORE_PARAMS)
 }
 
 
+static void
+etc_unpack_rows(void *data, unsigned y, unsigned height)
+{
+   const struct etc_unpack_job *job = data;
+   uint8_t *dst_row = job->dst_row + y * job->dst_stride;
+   const uint8_t *src_row = job->src_row + (y / 4) * job->src_stride;
+
+   if (job->format == MESA_FORMAT_ETC1_RGB8)
+      etc1_unpack_rgba8888(dst_row, job->dst_stride,
+                           src_row, job->src_stride,
+                           job->src_width, height);
+   else if (job->format == MESA_FORMAT_ETC2_RGB8)
+      etc2_unpack_rgb8(dst_row, job->dst_stride,
+                       src_row, job->src_stride,
+                       job->src_width, height);
+   else if (job->format == MESA_FORMAT_ETC2_SRGB8)
+      etc2_unpack_srgb8(dst_row, job->dst_stride,
+                        src_row, job->src_stride,
+			job->src_width, height, job->bgra);
+   else if (job->format == MESA_FORMAT_ETC2_RGBA8_EAC)
+      etc2_unpack_rgba8(dst_row, job->dst_stride,
+                        src_row, job->src_stride,
+                        job->src_width, height);
+   else if (job->format == MESA_FORMAT_ETC2_SRGB8_ALPHA8_EAC)
+      etc2_unpack_srgb8_alpha8(dst_row, job->dst_stride,
+                               src_row, job->src_stride,
+			       job->src_width, height, job->bgra);
+   else if (job->format == MESA_FORMAT_ETC2_R11_EAC)
+      etc2_unpack_r11(dst_row, job->dst_stride,
+                      src_row, job->src_stride,
+                      job->src_width, height);
+   else if (job->format == MESA_FORMAT_ETC2_RG11_EAC)
+      etc2_unpack_rg11(dst_row, job->dst_stride,
+                       src_row, job->src_stride,
+                       job->src_width, height);
+   else if (job->format == MESA_FORMAT_ETC2_SIGNED_R11_EAC)
+      etc2_unpack_signed_r11(dst_row, job->dst_stride,
+                             src_row, job->src_stride,
+                             job->src_width, height);
+   else if (job->format == MESA_FORMAT_ETC2_SIGNED_RG11_EAC)
+      etc2_unpack_signed_rg11(dst_row, job->dst_stride,
+                              src_row, job->src_stride,
+                              job->src_width, height);
+   else if (job->format == MESA_FORMAT_ETC2_RGB8_PUNCHTHROUGH_ALPHA1)
+      etc2_unpack_rgb8_punchthrough_alpha1(dst_row, job->dst_stride,
+                                           src_row, job->src_stride,
+                                           job->src_width, height);
+   else if (job->format == MESA_FORMAT_ETC2_SRGB8_PUNCHTHROUGH_ALPHA1)
+      etc2_unpack_srgb8_punchthrough_alpha1(dst_row, job->dst_stride,
+                                            src_row, job->src_stride,
+					    job->src_width, height, job->bgra);
+}
+
 /**
  * Decode texture data in any one of following formats:
  * `MESA_FORMAT_ETC2_RGB8`
@@ -1220,46 +1297,17 @@ _mesa_unpack_etc2_format(uint8_t *dst_row,
 			 mesa_format format,
 			 bool bgra)
 {
-   if (format == MESA_FORMAT_ETC2_RGB8)
-      etc2_unpack_rgb8(dst_row, dst_stride,
-                       src_row, src_stride,
-                       src_width, src_height);
-   else if (format == MESA_FORMAT_ETC2_SRGB8)
-      etc2_unpack_srgb8(dst_row, dst_stride,
-                        src_row, src_stride,
-			src_width, src_height, bgra);
-   else if (format == MESA_FORMAT_ETC2_RGBA8_EAC)
-      etc2_unpack_rgba8(dst_row, dst_stride,
-                        src_row, src_stride,
-                        src_width, src_height);
-   else if (format == MESA_FORMAT_ETC2_SRGB8_ALPHA8_EAC)
-      etc2_unpack_srgb8_alpha8(dst_row, dst_stride,
-                               src_row, src_stride,
-			       src_width, src_height, bgra);
-   else if (format == MESA_FORMAT_ETC2_R11_EAC)
-      etc2_unpack_r11(dst_row, dst_stride,
-                      src_row, src_stride,
-                      src_width, src_height);
-   else if (format == MESA_FORMAT_ETC2_RG11_EAC)
-      etc2_unpack_rg11(dst_row, dst_stride,
-                       src_row, src_stride,
-                       src_width, src_height);
-   else if (format == MESA_FORMAT_ETC2_SIGNED_R11_EAC)
-      etc2_unpack_signed_r11(dst_row, dst_stride,
-                             src_row, src_stride,
-                             src_width, src_height);
-   else if (format == MESA_FORMAT_ETC2_SIGNED_RG11_EAC)
-      etc2_unpack_signed_rg11(dst_row, dst_stride,
-                              src_row, src_stride,
-                              src_width, src_height);
-   else if (format == MESA_FORMAT_ETC2_RGB8_PUNCHTHROUGH_ALPHA1)
-      etc2_unpack_rgb8_punchthrough_alpha1(dst_row, dst_stride,
-                                           src_row, src_stride,
-                                           src_width, src_height);
-   else if (format == MESA_FORMAT_ETC2_SRGB8_PUNCHTHROUGH_ALPHA1)
-      etc2_unpack_srgb8_punchthrough_alpha1(dst_row, dst_stride,
-                                            src_row, src_stride,
-					    src_width, src_height, bgra);
+   struct etc_unpack_job job = {
+      .dst_row = dst_row,
+      .dst_stride = dst_stride,
+      .src_row = src_row,
+      .src_stride = src_stride,
+      .src_width = src_width,
+      .format = format,
+      .bgra = bgra,
+   };
+
+   _mesa_texcompress_rows(src_width, src_height, 4, etc_unpack_rows, &job);
 }
 
 
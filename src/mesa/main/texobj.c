@@ -38,6 +38,7 @@
 #include "imports.h"
 #include "macros.h"
 #include "shaderimage.h"
+#include "state.h"
 #include "teximage.h"
 #include "texobj.h"
 #include "texstate.h"
@@ -1630,6 +1631,37 @@ _mesa_tex_target_to_index(const struct gl_context *ctx, GLenum target)
 }
 
 
+/**
+ * Check whether the current programs or fixed-function texturing can sample
+ * from the given texture unit.  If not, changing a binding on that unit
+ * doesn't affect the derived texture state: anything that starts using the
+ * unit later (a new program, a sampler uniform, glEnable of a texture
+ * target) revalidates the texture state by itself.
+ */
+static bool
+texture_unit_in_use(const struct gl_context *ctx, unsigned unit)
+{
+   const struct gl_program *prog;
+   int i;
+
+   for (i = 0; i < MESA_SHADER_STAGES; i++) {
+      prog = ctx->_Shader->CurrentProgram[i];
+      if (prog && prog->TexturesUsed[unit])
+         return true;
+   }
+
+   prog = ctx->FragmentProgram.Current;
+   if (prog && prog->TexturesUsed[unit])
+      return true;
+
+   if (_mesa_ati_fragment_shader_enabled(ctx))
+      return true;
+
+   return unit < ARRAY_SIZE(ctx->Texture.FixedFuncUnit) &&
+          ctx->Texture.FixedFuncUnit[unit].Enabled;
+}
+
+
 /**
  * Do actual texture binding.  All error checking should have been done prior
  * to calling this function.  Note that the texture target (1D, 2D, etc) is
@@ -1670,8 +1702,11 @@ bind_texture_object(struct gl_context *ctx, unsigned unit,
       }
    }
 
-   /* flush before changing binding */
-   FLUSH_VERTICES(ctx, _NEW_TEXTURE_OBJECT);
+   /* flush before changing binding, and only revalidate the texture state
+    * if something can sample from this unit.
+    */
+   FLUSH_VERTICES(ctx, texture_unit_in_use(ctx, unit) ?
+                       _NEW_TEXTURE_OBJECT : 0);
 
    /* If the refcount on the previously bound texture is decremented to
     * zero, it'll be deleted here.
@@ -1011,8 +1011,17 @@ validate_uniform(GLint location, GLsizei count, const GLvoid *values,
    return uni;
 }
 
+/**
+ * Flag the constants of the stages affected by a change of \p uni.
+ *
+ * If \p shProg is given, stages where it isn't the current program are
+ * skipped: their constants are uploaded anyway when the program is bound,
+ * and flagging them would re-upload the constants of whatever program is
+ * current instead.
+ */
 void
 _mesa_flush_vertices_for_uniforms(struct gl_context *ctx,
+                                  const struct gl_shader_program *shProg,
                                   const struct gl_uniform_storage *uni)
 {
    /* Opaque uniforms have no storage unless they are bindless */
@@ -1023,12 +1032,25 @@ _mesa_flush_vertices_for_uniforms(struct gl_context *ctx,
 
    uint64_t new_driver_state = 0;
    unsigned mask = uni->active_shader_mask;
+   bool affected = false;
 
    while (mask) {
       unsigned index = u_bit_scan(&mask);
 
       assert(index < MESA_SHADER_STAGES);
+
+      if (shProg && (!shProg->_LinkedShaders[index] ||
+                     shProg->_LinkedShaders[index]->Program !=
+                     ctx->_Shader->CurrentProgram[index]))
+         continue;
+
       new_driver_state |= ctx->DriverFlags.NewShaderConstants[index];
+      affected = true;
+   }
+
+   if (!affected) {
+      FLUSH_VERTICES(ctx, 0);
+      return;
    }
 
    FLUSH_VERTICES(ctx, new_driver_state ? 0 : _NEW_PROGRAM_CONSTANTS);
@@ -1129,7 +1151,7 @@ _mesa_uniform(GLint location, GLsizei count, const GLvoid *values,
     * handling code further down, so just skip them here.
     */
    if (!uni->type->is_sampler()) {
-       _mesa_flush_vertices_for_uniforms(ctx, uni);
+       _mesa_flush_vertices_for_uniforms(ctx, shProg, uni);
    }
 
    /* Store the data in the "actual type" backing storage for the uniform.
@@ -1385,7 +1407,7 @@ _mesa_uniform_matrix(GLint location, GLsizei count,
       count = MIN2(count, (int) (uni->array_elements - offset));
    }
 
-   _mesa_flush_vertices_for_uniforms(ctx, uni);
+   _mesa_flush_vertices_for_uniforms(ctx, shProg, uni);
 
    /* Store the data in the "actual type" backing storage for the uniform.
     */
@@ -1519,7 +1541,7 @@ _mesa_uniform_handle(GLint location, GLsizei count, const GLvoid *values,
       count = MIN2(count, (int) (uni->array_elements - offset));
    }
 
-   _mesa_flush_vertices_for_uniforms(ctx, uni);
+   _mesa_flush_vertices_for_uniforms(ctx, shProg, uni);
 
    /* Store the data in the "actual type" backing storage for the uniform.
     */
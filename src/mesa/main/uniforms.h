@@ -501,6 +501,7 @@ _mesa_sampler_uniforms_pipeline_are_valid(struct gl_pipeline_object *);
 
 extern void
 _mesa_flush_vertices_for_uniforms(struct gl_context *ctx,
+                                  const struct gl_shader_program *shProg,
                                   const struct gl_uniform_storage *uni);
 
 struct gl_builtin_uniform_element {
@@ -36,6 +36,7 @@
 #include "st_atom.h"
 #include "st_program.h"
 #include "st_manager.h"
+#include "util/u_cpu_trace.h"
 
 typedef void (*update_func_t)(struct st_context *st);
 
@@ -173,6 +174,8 @@ void st_validate_state( struct st_context *st, enum st_pipeline pipeline )
    uint64_t dirty, pipeline_mask;
    uint32_t dirty_lo, dirty_hi;
 
+   MESA_TRACE_FUNC();
+
    /* Get Mesa driver state.
     *
     * Inactive states are shader states not used by shaders at the moment.
@@ -39,6 +39,7 @@
 
 #include "cso_cache/cso_context.h"
 #include "draw/draw_context.h"
+#include "tgsi/tgsi_from_mesa.h"
 
 #include "st_context.h"
 #include "st_debug.h"
@@ -266,6 +267,69 @@ st_new_ati_fs(struct gl_context *ctx, struct ati_fragment_shader *curProg)
    return prog;
 }
 
+/**
+ * Called via ctx->Driver.SetMaxShaderCompilerThreads()
+ */
+static void
+st_max_shader_compiler_threads(struct gl_context *ctx, unsigned count)
+{
+   struct pipe_screen *screen = st_context(ctx)->pipe->screen;
+
+   if (screen->set_max_shader_compiler_threads)
+      screen->set_max_shader_compiler_threads(screen, count);
+}
+
+/**
+ * Called via ctx->Driver.GetShaderProgramCompletionStatus()
+ *
+ * Only the most recent variant of each stage is checked, which is the one
+ * precompiled at link time.
+ */
+static bool
+st_get_shader_program_completion_status(struct gl_context *ctx,
+                                        struct gl_shader_program *shprog)
+{
+   struct pipe_screen *screen = st_context(ctx)->pipe->screen;
+
+   if (!screen->is_parallel_shader_compilation_finished)
+      return true;
+
+   for (unsigned i = 0; i < MESA_SHADER_STAGES; i++) {
+      struct gl_linked_shader *linked = shprog->_LinkedShaders[i];
+      void *sh = NULL;
+
+      if (!linked || !linked->Program)
+         continue;
+
+      switch (i) {
+      case MESA_SHADER_VERTEX:
+         if (st_vertex_program(linked->Program)->variants)
+            sh = st_vertex_program(linked->Program)->variants->driver_shader;
+         break;
+      case MESA_SHADER_FRAGMENT:
+         if (st_fragment_program(linked->Program)->variants)
+            sh = st_fragment_program(linked->Program)->variants->driver_shader;
+         break;
+      case MESA_SHADER_TESS_CTRL:
+      case MESA_SHADER_TESS_EVAL:
+      case MESA_SHADER_GEOMETRY:
+         if (st_common_program(linked->Program)->variants)
+            sh = st_common_program(linked->Program)->variants->driver_shader;
+         break;
+      case MESA_SHADER_COMPUTE:
+         if (st_compute_program(linked->Program)->variants)
+            sh = st_compute_program(linked->Program)->variants->driver_shader;
+         break;
+      }
+
+      if (sh &&
+          !screen->is_parallel_shader_compilation_finished(screen, sh,
+                                                           pipe_shader_type_from_mesa(i)))
+         return false;
+   }
+   return true;
+}
+
 /**
  * Plug in the program and shader-related device driver functions.
  */
@@ -278,4 +342,7 @@ st_init_program_functions(struct dd_function_table *functions)
    functions->NewATIfs = st_new_ati_fs;
    
    functions->LinkShader = st_link_shader;
+   functions->SetMaxShaderCompilerThreads = st_max_shader_compiler_threads;
+   functions->GetShaderProgramCompletionStatus =
+      st_get_shader_program_completion_status;
 }
@@ -91,6 +91,77 @@ needs_integer_signed_unsigned_conversion(const struct gl_context *ctx,
    return FALSE;
 }
 
+/**
+ * Resolve a region of a multisampled renderbuffer into a temporary
+ * single-sampled texture that the PBO download shader can fetch from.
+ * The result is flipped upright if invert_y is set.
+ */
+static struct pipe_resource *
+resolve_for_pbo_readpixels(struct st_context *st, struct st_renderbuffer *strb,
+                           bool invert_y,
+                           GLint x, GLint y, GLsizei width, GLsizei height,
+                           enum pipe_format src_format)
+{
+   struct pipe_context *pipe = st->pipe;
+   struct pipe_screen *screen = pipe->screen;
+   struct pipe_resource templ;
+   struct pipe_resource *resolved;
+   struct pipe_blit_info blit;
+
+   if (util_format_is_depth_or_stencil(src_format))
+      return NULL;
+
+   if (!screen->get_param(screen, PIPE_CAP_NPOT_TEXTURES) &&
+       (!util_is_power_of_two_or_zero(width) ||
+        !util_is_power_of_two_or_zero(height)))
+      return NULL;
+
+   if (!screen->is_format_supported(screen, src_format, PIPE_TEXTURE_2D, 0, 0,
+                                    PIPE_BIND_SAMPLER_VIEW |
+                                    PIPE_BIND_RENDER_TARGET))
+      return NULL;
+
+   memset(&templ, 0, sizeof(templ));
+   templ.target = PIPE_TEXTURE_2D;
+   templ.format = src_format;
+   templ.bind = PIPE_BIND_SAMPLER_VIEW | PIPE_BIND_RENDER_TARGET;
+   templ.usage = PIPE_USAGE_DEFAULT;
+
+   st_gl_texture_dims_to_pipe_dims(GL_TEXTURE_2D, width, height, 1,
+                                   &templ.width0, &templ.height0,
+                                   &templ.depth0, &templ.array_size);
+
+   resolved = screen->resource_create(screen, &templ);
+   if (!resolved)
+      return NULL;
+
+   memset(&blit, 0, sizeof(blit));
+   blit.src.resource = strb->texture;
+   blit.src.level = strb->surface->u.tex.level;
+   blit.src.format = src_format;
+   blit.dst.resource = resolved;
+   blit.dst.level = 0;
+   blit.dst.format = src_format;
+   blit.src.box.x = x;
+   blit.src.box.y = y;
+   blit.src.box.z = strb->surface->u.tex.first_layer;
+   blit.src.box.width = blit.dst.box.width = width;
+   blit.src.box.height = blit.dst.box.height = height;
+   blit.src.box.depth = blit.dst.box.depth = 1;
+   blit.mask = PIPE_MASK_RGBA;
+   blit.filter = PIPE_TEX_FILTER_NEAREST;
+   blit.scissor_enable = FALSE;
+
+   if (invert_y) {
+      blit.src.box.y = strb->Base.Height - blit.src.box.y;
+      blit.src.box.height = -blit.src.box.height;
+   }
+
+   pipe->blit(pipe, &blit);
+
+   return resolved;
+}
+
 static bool
 try_pbo_readpixels(struct st_context *st, struct st_renderbuffer *strb,
                    bool invert_y,
@@ -98,19 +169,14 @@ try_pbo_readpixels(struct st_context *st, struct st_renderbuffer *strb,
                    enum pipe_format src_format, enum pipe_format dst_format,
                    const struct gl_pixelstore_attrib *pack, void *pixels)
 {
-   struct pipe_context *pipe = st->pipe;
-   struct pipe_screen *screen = pipe->screen;
-   struct cso_context *cso = st->cso_context;
-   struct pipe_surface *surface = strb->surface;
+   struct pipe_screen *screen = st->pipe->screen;
    struct pipe_resource *texture = strb->texture;
+   struct pipe_resource *resolved = NULL;
+   unsigned level = strb->surface->u.tex.level;
+   unsigned layer = strb->surface->u.tex.first_layer;
    const struct util_format_description *desc;
    struct st_pbo_addresses addr;
-   struct pipe_framebuffer_state fb;
-   enum pipe_texture_target view_target;
-   bool success = false;
-
-   if (texture->nr_samples > 1)
-      return false;
+   bool success;
 
    if (!screen->is_format_supported(screen, dst_format, PIPE_BUFFER, 0, 0,
                                     PIPE_BIND_SHADER_IMAGE))
@@ -125,128 +191,28 @@ try_pbo_readpixels(struct st_context *st, struct st_renderbuffer *strb,
    addr.width = width;
    addr.height = height;
    addr.depth = 1;
-   if (!st_pbo_addresses_pixelstore(st, GL_TEXTURE_2D, false, pack, pixels, &addr))
-      return false;
-
-   cso_save_state(cso, (CSO_BIT_FRAGMENT_SAMPLER_VIEWS |
-                        CSO_BIT_FRAGMENT_SAMPLERS |
-                        CSO_BIT_FRAGMENT_IMAGE0 |
-                        CSO_BIT_BLEND |
-                        CSO_BIT_VERTEX_ELEMENTS |
-                        CSO_BIT_AUX_VERTEX_BUFFER_SLOT |
-                        CSO_BIT_FRAMEBUFFER |
-                        CSO_BIT_VIEWPORT |
-                        CSO_BIT_RASTERIZER |
-                        CSO_BIT_DEPTH_STENCIL_ALPHA |
-                        CSO_BIT_STREAM_OUTPUTS |
-                        CSO_BIT_PAUSE_QUERIES |
-                        CSO_BIT_SAMPLE_MASK |
-                        CSO_BIT_MIN_SAMPLES |
-                        CSO_BIT_RENDER_CONDITION |
-                        CSO_BITS_ALL_SHADERS));
-   cso_save_constant_buffer_slot0(cso, PIPE_SHADER_FRAGMENT);
-
-   cso_set_sample_mask(cso, ~0);
-   cso_set_min_samples(cso, 1);
-   cso_set_render_condition(cso, NULL, FALSE, 0);
-
-   /* Set up the sampler_view */
-   {
-      struct pipe_sampler_view templ;
-      struct pipe_sampler_view *sampler_view;
-      struct pipe_sampler_state sampler = {0};
-      const struct pipe_sampler_state *samplers[1] = {&sampler};
-
-      u_sampler_view_default_template(&templ, texture, src_format);
-
-      switch (texture->target) {
-      case PIPE_TEXTURE_CUBE:
-      case PIPE_TEXTURE_CUBE_ARRAY:
-         view_target = PIPE_TEXTURE_2D_ARRAY;
-         break;
-      default:
-         view_target = texture->target;
-         break;
-      }
 
-      templ.target = view_target;
-      templ.u.tex.first_level = surface->u.tex.level;
-      templ.u.tex.last_level = templ.u.tex.first_level;
-
-      if (view_target != PIPE_TEXTURE_3D) {
-         templ.u.tex.first_layer = surface->u.tex.first_layer;
-         templ.u.tex.last_layer = templ.u.tex.first_layer;
-      } else {
-         addr.constants.layer_offset = surface->u.tex.first_layer;
-      }
-
-      sampler_view = pipe->create_sampler_view(pipe, texture, &templ);
-      if (sampler_view == NULL)
-         goto fail;
-
-      cso_set_sampler_views(cso, PIPE_SHADER_FRAGMENT, 1, &sampler_view);
-
-      pipe_sampler_view_reference(&sampler_view, NULL);
-
-      cso_set_samplers(cso, PIPE_SHADER_FRAGMENT, 1, samplers);
+   /* The download shader fetches single samples, so resolve first. */
+   if (texture->nr_samples > 1) {
+      resolved = resolve_for_pbo_readpixels(st, strb, invert_y,
+                                            x, y, width, height, src_format);
+      if (!resolved)
+         return false;
+
+      texture = resolved;
+      level = 0;
+      layer = 0;
+      invert_y = false;
+      addr.xoffset = 0;
+      addr.yoffset = 0;
    }
 
-   /* Set up destination image */
-   {
-      struct pipe_image_view image;
+   success = st_pbo_addresses_pixelstore(st, GL_TEXTURE_2D, false, pack,
+                                         pixels, &addr) &&
+             st_pbo_download(st, texture, level, layer, src_format, dst_format,
+                             invert_y, &addr);
 
-      memset(&image, 0, sizeof(image));
-      image.resource = addr.buffer;
-      image.format = dst_format;
-      image.access = PIPE_IMAGE_ACCESS_WRITE;
-      image.u.buf.offset = addr.first_element * addr.bytes_per_pixel;
-      image.u.buf.size = (addr.last_element - addr.first_element + 1) *
-                         addr.bytes_per_pixel;
-
-      cso_set_shader_images(cso, PIPE_SHADER_FRAGMENT, 0, 1, &image);
-   }
-
-   /* Set up no-attachment framebuffer */
-   memset(&fb, 0, sizeof(fb));
-   fb.width = surface->width;
-   fb.height = surface->height;
-   fb.samples = 1;
-   fb.layers = 1;
-   cso_set_framebuffer(cso, &fb);
-
-   /* Any blend state would do. Set this just to prevent drivers having
-    * blend == NULL.
-    */
-   cso_set_blend(cso, &st->pbo.upload_blend);
-
-   cso_set_viewport_dims(cso, fb.width, fb.height, invert_y);
-
-   if (invert_y)
-      st_pbo_addresses_invert_y(&addr, fb.height);
-
-   {
-      struct pipe_depth_stencil_alpha_state dsa;
-      memset(&dsa, 0, sizeof(dsa));
-      cso_set_depth_stencil_alpha(cso, &dsa);
-   }
-
-   /* Set up the fragment shader */
-   {
-      void *fs = st_pbo_get_download_fs(st, view_target, src_format, dst_format);
-      if (!fs)
-         goto fail;
-
-      cso_set_fragment_shader_handle(cso, fs);
-   }
-
-   success = st_pbo_draw(st, &addr, fb.width, fb.height);
-
-   /* Buffer written via shader images needs explicit synchronization. */
-   pipe->memory_barrier(pipe, PIPE_BARRIER_ALL);
-
-fail:
-   cso_restore_state(cso);
-   cso_restore_constant_buffer_slot0(cso, PIPE_SHADER_FRAGMENT);
+   pipe_resource_reference(&resolved, NULL);
 
    return success;
 }
@@ -411,13 +377,17 @@ st_ReadPixels(struct gl_context *ctx, GLint x, GLint y,
    struct pipe_transfer *tex_xfer;
    ubyte *map = NULL;
    int dst_x, dst_y;
+   bool try_pbo = st->pbo.download_enabled &&
+                  _mesa_is_bufferobj(pack->BufferObj);
 
    /* Validate state (to be sure we have up-to-date framebuffer surfaces)
     * and flush the bitmap cache prior to reading. */
    st_validate_state(st, ST_PIPELINE_UPDATE_FRAMEBUFFER);
    st_flush_bitmap_cache(st);
 
-   if (!st->prefer_blit_based_texture_transfer) {
+   /* Reading into a PBO on the GPU avoids stalling on the framebuffer even
+    * when the driver doesn't prefer blits for ordinary transfers. */
+   if (!st->prefer_blit_based_texture_transfer && !try_pbo) {
       goto fallback;
    }
 
@@ -467,7 +437,7 @@ st_ReadPixels(struct gl_context *ctx, GLint x, GLint y,
       goto fallback;
    }
 
-   if (st->pbo.download_enabled && _mesa_is_bufferobj(pack->BufferObj)) {
+   if (try_pbo) {
       if (try_pbo_readpixels(st, strb,
                              st_fb_orientation(ctx->ReadBuffer) == Y_0_TOP,
                              x, y, width, height,
@@ -476,6 +446,10 @@ st_ReadPixels(struct gl_context *ctx, GLint x, GLint y,
          return;
    }
 
+   if (!st->prefer_blit_based_texture_transfer) {
+      goto fallback;
+   }
+
    if (needs_integer_signed_unsigned_conversion(ctx, format, type)) {
       goto fallback;
    }
@@ -1847,6 +1847,60 @@ st_CompressedTexImage(struct gl_context *ctx, GLuint dims,
 
 
 
+static bool
+try_pbo_download(struct st_context *st,
+                 struct gl_texture_image *texImage,
+                 enum pipe_format src_format, enum pipe_format dst_format,
+                 GLint xoffset, GLint yoffset, GLint zoffset,
+                 GLint width, GLint height, GLint depth,
+                 const struct gl_pixelstore_attrib *pack, void *pixels)
+{
+   struct st_texture_image *stImage = st_texture_image(texImage);
+   struct pipe_resource *texture = stImage->pt;
+   struct pipe_screen *screen = st->pipe->screen;
+   const struct util_format_description *desc;
+   struct st_pbo_addresses addr;
+   GLenum gl_target = texImage->TexObject->Target;
+   unsigned dims;
+
+   if (texture->nr_samples > 1)
+      return false;
+
+   if (!screen->is_format_supported(screen, dst_format, PIPE_BUFFER, 0, 0,
+                                    PIPE_BIND_SHADER_IMAGE))
+      return false;
+
+   desc = util_format_description(dst_format);
+   dims = _mesa_get_texture_dimensions(gl_target);
+
+   /* From now on, we need the gallium representation of dimensions. */
+   if (gl_target == GL_TEXTURE_1D_ARRAY) {
+      depth = height;
+      height = 1;
+      zoffset = yoffset;
+      yoffset = 0;
+   }
+
+   /* Compute PBO addresses */
+   addr.bytes_per_pixel = desc->block.bits / 8;
+   addr.xoffset = xoffset;
+   addr.yoffset = yoffset;
+   addr.width = width;
+   addr.height = height;
+   addr.depth = depth;
+
+   if (!st_pbo_addresses_pixelstore(st, gl_target, dims == 3, pack, pixels,
+                                    &addr))
+      return false;
+
+   return st_pbo_download(st, texture,
+                          texImage->TexObject->MinLevel + texImage->Level,
+                          texImage->Face + texImage->TexObject->MinLayer +
+                          zoffset,
+                          src_format, dst_format, false, &addr);
+}
+
+
 /**
  * Called via ctx->Driver.GetTexSubImage()
  *
@@ -1886,6 +1940,8 @@ st_GetTexSubImage(struct gl_context * ctx,
    struct pipe_transfer *tex_xfer;
    ubyte *map = NULL;
    boolean done = FALSE;
+   bool try_pbo = st->pbo.download_enabled &&
+                  _mesa_is_bufferobj(ctx->Pack.BufferObj);
 
    assert(!_mesa_is_format_etc2(texImage->TexFormat) &&
           !_mesa_is_format_astc_2d(texImage->TexFormat) &&
@@ -1893,7 +1949,9 @@ st_GetTexSubImage(struct gl_context * ctx,
 
    st_flush_bitmap_cache(st);
 
-   if (!st->prefer_blit_based_texture_transfer &&
+   /* Downloads into a PBO are done on the GPU whenever possible, so that
+    * they don't stall on the texture. */
+   if (!st->prefer_blit_based_texture_transfer && !try_pbo &&
        !_mesa_is_format_compressed(texImage->TexFormat)) {
       /* Try to avoid the fallback if we're doing texture decompression here */
       goto fallback;
@@ -1917,13 +1975,6 @@ st_GetTexSubImage(struct gl_context * ctx,
       goto fallback;
    }
 
-   /* See if the texture format already matches the format and type,
-    * in which case the memcpy-based fast path will be used. */
-   if (_mesa_format_matches_format_and_type(texImage->TexFormat, format,
-                                            type, ctx->Pack.SwapBytes, NULL)) {
-      goto fallback;
-   }
-
    /* Convert the source format to what is expected by GetTexImage
     * and see if it's supported.
     *
@@ -1962,6 +2013,26 @@ st_GetTexSubImage(struct gl_context * ctx,
    dst_format = st_choose_matching_format(st, bind, format, type,
 					  ctx->Pack.SwapBytes);
 
+   if (try_pbo && dst_format != PIPE_FORMAT_NONE &&
+       try_pbo_download(st, texImage, src_format, dst_format,
+                        xoffset, yoffset, zoffset, width, height, depth,
+                        &ctx->Pack, pixels)) {
+      done = TRUE;
+      goto fallback;
+   }
+
+   if (!st->prefer_blit_based_texture_transfer &&
+       !_mesa_is_format_compressed(texImage->TexFormat)) {
+      goto fallback;
+   }
+
+   /* See if the texture format already matches the format and type,
+    * in which case the memcpy-based fast path will be used. */
+   if (_mesa_format_matches_format_and_type(texImage->TexFormat, format,
+                                            type, ctx->Pack.SwapBytes, NULL)) {
+      goto fallback;
+   }
+
    if (dst_format == PIPE_FORMAT_NONE) {
       GLenum dst_glformat;
 
@@ -79,6 +79,7 @@
 #include "st_vdpau.h"
 #include "st_texture.h"
 #include "pipe/p_context.h"
+#include "util/u_gen_mipmap.h"
 #include "util/u_inlines.h"
 #include "util/u_upload_mgr.h"
 #include "util/u_vbuf.h"
@@ -264,6 +265,8 @@ st_destroy_context_priv(struct st_context *st, bool destroy_pipe)
    st_destroy_drawtex(st);
    st_destroy_perfmon(st);
    st_destroy_pbo_helpers(st);
+   if (st->gen_mipmap_cs)
+      util_destroy_gen_mipmap_compute(st->gen_mipmap_cs);
    st_destroy_bound_texture_handles(st);
    st_destroy_bound_image_handles(st);
 
@@ -386,6 +389,7 @@ st_create_context_priv(struct gl_context *ctx, struct pipe_context *pipe,
    st_init_atoms(st);
    st_init_clear(st);
    st_init_pbo_helpers(st);
+   st->gen_mipmap_cs = util_create_gen_mipmap_compute(pipe, st->cso_context);
 
    /* Choose texture target for glDrawPixels, glBitmap, renderbuffers */
    if (pipe->screen->get_param(pipe->screen, PIPE_CAP_NPOT_TEXTURES))
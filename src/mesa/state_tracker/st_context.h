@@ -50,6 +50,7 @@ struct st_context;
 struct st_fragment_program;
 struct st_perf_monitor_group;
 struct u_upload_mgr;
+struct util_gen_mipmap_compute;
 
 
 /** For drawing quads for glClear, glDraw/CopyPixels, glBitmap, etc. */
@@ -198,6 +199,9 @@ struct st_context
    bool gfx_shaders_may_be_dirty;
    bool compute_shader_may_be_dirty;
 
+   /** Incremented for every sampler view validation, see st_sampler_view */
+   unsigned sampler_view_stamp;
+
    GLboolean vertdata_edgeflags;
    GLboolean edgeflag_culls_prims;
 
@@ -272,6 +276,9 @@ struct st_context
       bool use_gs;
    } pbo;
 
+   /** for glGenerateMipmap with compute shaders, NULL if unsupported */
+   struct util_gen_mipmap_compute *gen_mipmap_cs;
+
    /** for drawing with st_util_vertex */
    struct pipe_vertex_element util_velems[3];
 
@@ -124,6 +124,66 @@ prepare_draw(struct st_context *st, struct gl_context *ctx)
    }
 }
 
+/* The number of ranges passed to one cso_multi_draw call. */
+#define ST_MAX_MULTI_DRAWS 256
+
+static inline bool
+prims_can_be_combined(const struct _mesa_prim *first,
+                      const struct _mesa_prim *prim, unsigned num_draws)
+{
+   return prim->mode == first->mode &&
+          prim->num_instances == first->num_instances &&
+          prim->base_instance == first->base_instance &&
+          prim->draw_id == first->draw_id + num_draws;
+}
+
+/**
+ * Draw runs of prims that only differ in their ranges, as glMultiDraw*
+ * generates them, with one multi_draw call per run.
+ */
+static void
+draw_multi(struct st_context *st, struct pipe_draw_info *info,
+           const struct _mesa_prim *prims, GLuint nr_prims, unsigned start)
+{
+   struct pipe_draw_range draws[ST_MAX_MULTI_DRAWS];
+   unsigned i = 0;
+
+   while (i < nr_prims) {
+      const struct _mesa_prim *first = &prims[i];
+      unsigned num_draws = 0;
+
+      info->mode = translate_prim(st->ctx, first->mode);
+      info->start_instance = first->base_instance;
+      info->instance_count = first->num_instances;
+      info->drawid = first->draw_id;
+      info->index_bias = 0;
+      if (!info->index_size) {
+         info->min_index = ~0u;
+         info->max_index = 0;
+      }
+
+      do {
+         const struct _mesa_prim *prim = &prims[i + num_draws];
+         struct pipe_draw_range *draw = &draws[num_draws++];
+
+         draw->start = start + prim->start;
+         draw->count = prim->count;
+         draw->index_bias = prim->basevertex;
+
+         if (!info->index_size && draw->count) {
+            info->min_index = MIN2(info->min_index, draw->start);
+            info->max_index = MAX2(info->max_index,
+                                   draw->start + draw->count - 1);
+         }
+      } while (i + num_draws < nr_prims && num_draws < ST_MAX_MULTI_DRAWS &&
+               prims_can_be_combined(first, &prims[i + num_draws],
+                                     num_draws));
+
+      cso_multi_draw(st->cso_context, info, draws, num_draws);
+      i += num_draws;
+   }
+}
+
 /**
  * This function gets plugged into the VBO module and is called when
  * we have something to render.
@@ -205,6 +265,12 @@ st_draw_vbo(struct gl_context *ctx,
 
    assert(!indirect);
 
+   if (nr_prims > 1 && !info.has_user_indices && !tfb_vertcount &&
+       !(ST_DEBUG & DEBUG_DRAW)) {
+      draw_multi(st, &info, prims, nr_prims, start);
+      return;
+   }
+
    /* do actual drawing */
    for (i = 0; i < nr_prims; i++) {
       info.count = prims[i].count;
@@ -1399,6 +1399,10 @@ void st_init_extensions(struct pipe_screen *screen,
       extensions->ARB_texture_stencil8 &&
       extensions->ARB_texture_multisample;
 
+   extensions->ARB_parallel_shader_compile =
+      screen->set_max_shader_compiler_threads &&
+      screen->is_parallel_shader_compilation_finished;
+
    if (screen->get_param(screen, PIPE_CAP_CONSERVATIVE_RASTER_POST_SNAP_TRIANGLES) &&
        screen->get_param(screen, PIPE_CAP_CONSERVATIVE_RASTER_POST_SNAP_POINTS_LINES) &&
        screen->get_param(screen, PIPE_CAP_CONSERVATIVE_RASTER_POST_DEPTH_COVERAGE)) {
@@ -133,8 +133,17 @@ st_generate_mipmap(struct gl_context *ctx, GLenum target,
        !st->pipe->generate_mipmap(st->pipe, pt, format, baseLevel,
                                   lastLevel, first_layer, last_layer)) {
 
-      if (!util_gen_mipmap(st->pipe, pt, format, baseLevel, lastLevel,
-                           first_layer, last_layer, PIPE_TEX_FILTER_LINEAR)) {
+      if (st->gen_mipmap_cs &&
+          util_gen_mipmap_compute(st->gen_mipmap_cs, pt, format, baseLevel,
+                                  lastLevel, first_layer, last_layer,
+                                  PIPE_TEX_FILTER_LINEAR)) {
+         /* the compute path clobbered these */
+         st->dirty |= ST_NEW_CS_STATE | ST_NEW_CS_SAMPLER_VIEWS |
+                      ST_NEW_CS_IMAGES;
+      }
+      else if (!util_gen_mipmap(st->pipe, pt, format, baseLevel, lastLevel,
+                                first_layer, last_layer,
+                                PIPE_TEX_FILTER_LINEAR)) {
          _mesa_generate_mipmap(ctx, target, texObj);
       }
    }
@@ -651,6 +651,9 @@ st_context_flush(struct st_context_iface *stctxi, unsigned flags,
    FLUSH_CURRENT(st->ctx, 0);
    st_flush(st, fence, pipe_flags);
 
+   if (flags & ST_FLUSH_END_OF_FRAME)
+      _mesa_glthread_end_frame(st->ctx);
+
    if ((flags & ST_FLUSH_WAIT) && fence && *fence) {
       st->pipe->screen->fence_finish(st->pipe->screen, NULL, *fence,
                                      PIPE_TIMEOUT_INFINITE);
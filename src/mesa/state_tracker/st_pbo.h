@@ -78,6 +78,12 @@ bool
 st_pbo_draw(struct st_context *st, const struct st_pbo_addresses *addr,
             unsigned surface_width, unsigned surface_height);
 
+bool
+st_pbo_download(struct st_context *st, struct pipe_resource *texture,
+                unsigned level, unsigned layer,
+                enum pipe_format src_format, enum pipe_format dst_format,
+                bool invert_y, struct st_pbo_addresses *addr);
+
 void *
 st_pbo_create_vs(struct st_context *st);
 
@@ -42,10 +42,22 @@
 #include "st_cb_texture.h"
 
 
+static inline bool
+st_sampler_view_matches(const struct st_sampler_view *sv,
+                        const struct st_context *st,
+                        bool glsl130_or_later, bool srgb_skip_decode)
+{
+   return sv->view && sv->view->context == st->pipe &&
+          sv->glsl130_or_later == glsl130_or_later &&
+          sv->srgb_skip_decode == srgb_skip_decode;
+}
+
+
 /**
  * Set the given view as the current context's view for the texture.
  *
- * Overwrites any pre-existing view of the context.
+ * Overwrites any pre-existing view of the context with the same
+ * \p glsl130_or_later and \p srgb_skip_decode.
  *
  * Takes ownership of the view (i.e., stores the view without incrementing the
  * reference count).
@@ -72,8 +84,9 @@ st_texture_set_sampler_view(struct st_context *st,
 
       /* Is the array entry used ? */
       if (sv->view) {
-         /* check if the context matches */
-         if (sv->view->context == st->pipe) {
+         /* check if the context and the variant match */
+         if (st_sampler_view_matches(sv, st, glsl130_or_later,
+                                     srgb_skip_decode)) {
             pipe_sampler_view_release(st->pipe, &sv->view);
             goto found;
          }
@@ -149,7 +162,9 @@ found:
 
    sv->glsl130_or_later = glsl130_or_later;
    sv->srgb_skip_decode = srgb_skip_decode;
+   sv->stamp = ++st->sampler_view_stamp;
    sv->view = view;
+   stObj->sampler_view_hint = sv - views->views;
 
 out:
    simple_mtx_unlock(&stObj->validate_mutex);
@@ -168,14 +183,54 @@ st_texture_get_current_sampler_view(const struct st_context *st,
                                     const struct st_texture_object *stObj)
 {
    const struct st_sampler_views *views = p_atomic_read(&stObj->sampler_views);
+   const struct st_sampler_view *current = NULL;
 
    for (unsigned i = 0; i < views->count; ++i) {
       const struct st_sampler_view *sv = &views->views[i];
-      if (sv->view && sv->view->context == st->pipe)
-         return sv;
+      if (sv->view && sv->view->context == st->pipe &&
+          (!current || (int)(sv->stamp - current->stamp) > 0))
+         current = sv;
    }
 
-   return NULL;
+   return current;
+}
+
+
+/**
+ * Look up the view of the given context and variant, trying the entry that
+ * was used last first.
+ *
+ * Like st_texture_get_current_sampler_view, this requires no locking. The
+ * stamp and the hint are only ever written for the calling context's own
+ * views, or are harmless heuristics.
+ */
+static struct st_sampler_view *
+st_texture_find_sampler_view(struct st_context *st,
+                             struct st_texture_object *stObj,
+                             bool glsl130_or_later, bool srgb_skip_decode)
+{
+   struct st_sampler_views *views = p_atomic_read(&stObj->sampler_views);
+   unsigned hint = stObj->sampler_view_hint;
+   struct st_sampler_view *sv = NULL;
+
+   if (hint < views->count &&
+       st_sampler_view_matches(&views->views[hint], st, glsl130_or_later,
+                               srgb_skip_decode)) {
+      sv = &views->views[hint];
+   } else {
+      for (unsigned i = 0; i < views->count; ++i) {
+         if (st_sampler_view_matches(&views->views[i], st, glsl130_or_later,
+                                     srgb_skip_decode)) {
+            sv = &views->views[i];
+            stObj->sampler_view_hint = i;
+            break;
+         }
+      }
+   }
+
+   if (sv)
+      sv->stamp = ++st->sampler_view_stamp;
+   return sv;
 }
 
 
@@ -194,10 +249,8 @@ st_texture_release_sampler_view(struct st_context *st,
    for (i = 0; i < views->count; ++i) {
       struct pipe_sampler_view **sv = &views->views[i].view;
 
-      if (*sv && (*sv)->context == st->pipe) {
+      if (*sv && (*sv)->context == st->pipe)
          pipe_sampler_view_reference(sv, NULL);
-         break;
-      }
    }
    simple_mtx_unlock(&stObj->validate_mutex);
 }
@@ -528,11 +581,10 @@ st_get_texture_sampler_view_from_stobj(struct st_context *st,
    if (!ignore_srgb_decode && samp->sRGBDecode == GL_SKIP_DECODE_EXT)
       srgb_skip_decode = true;
 
-   sv = st_texture_get_current_sampler_view(st, stObj);
+   sv = st_texture_find_sampler_view(st, stObj, glsl130_or_later,
+                                     srgb_skip_decode);
 
-   if (sv &&
-       sv->glsl130_or_later == glsl130_or_later &&
-       sv->srgb_skip_decode == srgb_skip_decode) {
+   if (sv) {
       /* Debug check: make sure that the sampler view's parameters are
        * what they're supposed to be.
        */
@@ -574,7 +626,7 @@ st_get_buffer_sampler_view_from_stobj(struct st_context *st,
    if (!stBuf || !stBuf->buffer)
       return NULL;
 
-   sv = st_texture_get_current_sampler_view(st, stObj);
+   sv = st_texture_find_sampler_view(st, stObj, false, false);
 
    struct pipe_resource *buf = stBuf->buffer;
 
@@ -50,7 +50,11 @@ struct st_texture_image_transfer {
 
 
 /**
- * Container for one context's validated sampler view.
+ * Container for one validated sampler view of a context.
+ *
+ * A context keeps one view per combination of glsl130_or_later and
+ * srgb_skip_decode, so that alternating between them (e.g. sampling the same
+ * texture with and without sRGB decode) doesn't recreate the view each time.
  */
 struct st_sampler_view {
    struct pipe_sampler_view *view;
@@ -59,6 +63,8 @@ struct st_sampler_view {
    bool glsl130_or_later;
    /** Derived from the sampler's sRGBDecode state during validation */
    bool srgb_skip_decode;
+   /** st_context::sampler_view_stamp of the last validation */
+   unsigned stamp;
 };
 
 
@@ -120,7 +126,7 @@ struct st_texture_object
    /* Protect modifications of the sampler_views array */
    simple_mtx_t validate_mutex;
 
-   /* Container of sampler views (one per context) attached to this texture
+   /* Container of sampler views (one per context and variant) attached to this texture
     * object. Created lazily on first binding in context.
     *
     * Purely read-only accesses to the current context's own sampler view
@@ -146,6 +152,11 @@ struct st_texture_object
     */
    struct st_sampler_views *sampler_views_old;
 
+   /* Index of the most recently looked up entry of sampler_views. Only a
+    * hint which saves the search in the common case, it may be stale.
+    */
+   unsigned sampler_view_hint;
+
    /* True if this texture comes from the window system. Such a texture
     * cannot be reallocated and the format can only be changed with a sampler
     * view or a surface.
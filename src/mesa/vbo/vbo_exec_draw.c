@@ -179,8 +179,16 @@ vbo_exec_bind_arrays(struct gl_context *ctx)
 
    GLintptr buffer_offset;
    if (_mesa_is_bufferobj(exec->vtx.bufferobj)) {
-      assert(exec->vtx.bufferobj->Mappings[MAP_INTERNAL].Pointer);
-      buffer_offset = exec->vtx.bufferobj->Mappings[MAP_INTERNAL].Offset;
+      const struct gl_buffer_mapping *mapping =
+         &exec->vtx.bufferobj->Mappings[MAP_INTERNAL];
+
+      /* With a persistent mapping, buffer_map points past the vertices of
+       * the previous flushes.
+       */
+      assert(mapping->Pointer);
+      buffer_offset = mapping->Offset +
+                      ((GLbyte *)exec->vtx.buffer_map -
+                       (GLbyte *)mapping->Pointer);
    } else {
       /* Ptr into ordinary app memory */
       buffer_offset = (GLbyte *)exec->vtx.buffer_map - (GLbyte *)NULL;
@@ -237,6 +245,49 @@ vbo_exec_bind_arrays(struct gl_context *ctx)
 }
 
 
+/**
+ * Whether the VBO can stay mapped while drawing from it, avoiding a
+ * map/unmap pair per flush.
+ */
+static inline bool
+vbo_exec_use_persistent_mapping(const struct gl_context *ctx)
+{
+   return ctx->Extensions.ARB_buffer_storage &&
+          ctx->Const.AllowMappedBuffersDuringExecution;
+}
+
+
+/**
+ * Flush the vertices written since the last flush to the VBO and start the
+ * next batch after them, without unmapping.
+ */
+static void
+vbo_exec_vtx_flush_mapped(struct vbo_exec_context *exec)
+{
+   struct gl_context *ctx = exec->ctx;
+
+   if (ctx->Driver.FlushMappedBufferRange) {
+      GLintptr offset = exec->vtx.buffer_used -
+                        exec->vtx.bufferobj->Mappings[MAP_INTERNAL].Offset;
+      GLsizeiptr length = (exec->vtx.buffer_ptr - exec->vtx.buffer_map) *
+                          sizeof(float);
+
+      if (length)
+         ctx->Driver.FlushMappedBufferRange(ctx, offset, length,
+                                            exec->vtx.bufferobj,
+                                            MAP_INTERNAL);
+   }
+
+   exec->vtx.buffer_used += (exec->vtx.buffer_ptr -
+                             exec->vtx.buffer_map) * sizeof(float);
+
+   assert(exec->vtx.buffer_used <= VBO_VERT_BUFFER_SIZE);
+   assert(exec->vtx.buffer_ptr != NULL);
+
+   exec->vtx.buffer_map = exec->vtx.buffer_ptr;
+}
+
+
 /**
  * Unmap the VBO.  This is called before drawing.
  */
@@ -246,23 +297,7 @@ vbo_exec_vtx_unmap(struct vbo_exec_context *exec)
    if (_mesa_is_bufferobj(exec->vtx.bufferobj)) {
       struct gl_context *ctx = exec->ctx;
 
-      if (ctx->Driver.FlushMappedBufferRange) {
-         GLintptr offset = exec->vtx.buffer_used -
-                           exec->vtx.bufferobj->Mappings[MAP_INTERNAL].Offset;
-         GLsizeiptr length = (exec->vtx.buffer_ptr - exec->vtx.buffer_map) *
-                             sizeof(float);
-
-         if (length)
-            ctx->Driver.FlushMappedBufferRange(ctx, offset, length,
-                                               exec->vtx.bufferobj,
-                                               MAP_INTERNAL);
-      }
-
-      exec->vtx.buffer_used += (exec->vtx.buffer_ptr -
-                                exec->vtx.buffer_map) * sizeof(float);
-
-      assert(exec->vtx.buffer_used <= VBO_VERT_BUFFER_SIZE);
-      assert(exec->vtx.buffer_ptr != NULL);
+      vbo_exec_vtx_flush_mapped(exec);
 
       ctx->Driver.UnmapBuffer(ctx, exec->vtx.bufferobj, MAP_INTERNAL);
       exec->vtx.buffer_map = NULL;
@@ -279,11 +314,14 @@ void
 vbo_exec_vtx_map(struct vbo_exec_context *exec)
 {
    struct gl_context *ctx = exec->ctx;
+   const GLbitfield persistent = vbo_exec_use_persistent_mapping(ctx) ?
+      GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT : 0;
    const GLenum accessRange = GL_MAP_WRITE_BIT |  /* for MapBufferRange */
                               GL_MAP_INVALIDATE_RANGE_BIT |
                               GL_MAP_UNSYNCHRONIZED_BIT |
                               GL_MAP_FLUSH_EXPLICIT_BIT |
-                              MESA_MAP_NOWAIT_BIT;
+                              MESA_MAP_NOWAIT_BIT |
+                              persistent;
    const GLenum usage = GL_STREAM_DRAW_ARB;
 
    if (!_mesa_is_bufferobj(exec->vtx.bufferobj))
@@ -319,7 +357,8 @@ vbo_exec_vtx_map(struct vbo_exec_context *exec)
                                  NULL, usage,
                                  GL_MAP_WRITE_BIT |
                                  GL_DYNAMIC_STORAGE_BIT |
-                                 GL_CLIENT_STORAGE_BIT,
+                                 GL_CLIENT_STORAGE_BIT |
+                                 persistent,
                                  exec->vtx.bufferobj)) {
          /* buffer allocation worked, now map the buffer */
          exec->vtx.buffer_map =
@@ -374,6 +413,9 @@ vbo_exec_vtx_flush(struct vbo_exec_context *exec, GLboolean keepUnmapped)
 
       if (exec->vtx.copied.nr != exec->vtx.vert_count) {
          struct gl_context *ctx = exec->ctx;
+         const bool persistent =
+            _mesa_is_bufferobj(exec->vtx.bufferobj) &&
+            vbo_exec_use_persistent_mapping(ctx);
 
          /* Before the update_state() as this may raise _NEW_VARYING_VP_INPUTS
           * from _mesa_set_varying_vp_inputs().
@@ -383,7 +425,13 @@ vbo_exec_vtx_flush(struct vbo_exec_context *exec, GLboolean keepUnmapped)
          if (ctx->NewState)
             _mesa_update_state(ctx);
 
-         vbo_exec_vtx_unmap(exec);
+         /* A persistent mapping stays valid while the GPU reads from it, so
+          * only flush the new vertices and keep appending after them.
+          */
+         if (persistent)
+            vbo_exec_vtx_flush_mapped(exec);
+         else
+            vbo_exec_vtx_unmap(exec);
 
          assert(ctx->NewState == 0);
 
@@ -395,8 +443,15 @@ vbo_exec_vtx_flush(struct vbo_exec_context *exec, GLboolean keepUnmapped)
                           NULL, GL_TRUE, 0, exec->vtx.vert_count - 1,
                           NULL, 0, NULL);
 
-         /* Get new storage -- unless asked not to. */
-         if (!keepUnmapped)
+         /* Get new storage -- unless asked not to, or unless the persistent
+          * mapping still has room.
+          */
+         if (persistent &&
+             (keepUnmapped ||
+              exec->vtx.buffer_used + 1024 >= VBO_VERT_BUFFER_SIZE))
+            vbo_exec_vtx_unmap(exec);
+
+         if (!exec->vtx.buffer_map && !keepUnmapped)
             vbo_exec_vtx_map(exec);
       }
    }
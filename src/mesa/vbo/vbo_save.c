@@ -70,6 +70,8 @@ void vbo_save_destroy( struct gl_context *ctx )
       free(save->vertex_store);
       save->vertex_store = NULL;
    }
+
+   _mesa_reference_buffer_object(ctx, &save->index_bo, NULL);
 }
 
 
@@ -75,6 +75,14 @@ struct vbo_save_vertex_list {
    GLuint prim_count;
 
    struct vbo_save_primitive_store *prim_store;
+
+   /* All of prims as a single indexed GL_TRIANGLES draw, if they are all
+    * triangles, strips or fans.  merged.ib.obj is NULL otherwise.
+    */
+   struct {
+      struct _mesa_prim prim;
+      struct _mesa_index_buffer ib;
+   } merged;
 };
 
 
@@ -135,6 +143,7 @@ _vbo_save_get_vertex_count(const struct vbo_save_vertex_list *node)
  * internally even though this probably isn't allowed for client VBOs?
  */
 #define VBO_SAVE_BUFFER_SIZE (256*1024) /* dwords */
+#define VBO_SAVE_INDEX_SIZE  (64*1024)  /* dwords */
 #define VBO_SAVE_PRIM_SIZE   128
 #define VBO_SAVE_PRIM_MODE_MASK         0x3f
 #define VBO_SAVE_PRIM_WEAK              0x40
@@ -179,6 +188,9 @@ struct vbo_save_context {
    struct vbo_save_vertex_store *vertex_store;
    struct vbo_save_primitive_store *prim_store;
 
+   struct gl_buffer_object *index_bo;  /**< for vertex_list::merged */
+   GLuint index_used;                  /**< bytes used in index_bo */
+
    fi_type *buffer_map;            /**< Mapping of vertex_store's buffer */
    fi_type *buffer_ptr;		   /**< cursor, points into buffer_map */
    fi_type vertex[VBO_ATTRIB_MAX*4];	   /* current values */
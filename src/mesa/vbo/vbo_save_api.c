@@ -412,6 +412,154 @@ convert_line_loop_to_strip(struct vbo_save_context *save,
 }
 
 
+/**
+ * Number of independent triangles a triangle, strip or fan primitive
+ * consists of, or -1 if the primitive is of some other type.
+ */
+static int
+prim_triangle_count(const struct _mesa_prim *prim)
+{
+   switch (prim->mode) {
+   case GL_TRIANGLES:
+      return prim->count / 3;
+   case GL_TRIANGLE_STRIP:
+   case GL_TRIANGLE_FAN:
+      return prim->count >= 3 ? prim->count - 2 : 0;
+   default:
+      return -1;
+   }
+}
+
+
+/**
+ * Turn the primitives of the node into one indexed GL_TRIANGLES draw, so
+ * that replaying a list made of many short strips and fans costs a single
+ * draw call.
+ *
+ * The triangles are emitted in the original order and winding, with the
+ * last vertex of each kept last, so the result only matches the original
+ * primitives with GL_LAST_VERTEX_CONVENTION.  The playback code checks
+ * that.  Quads and polygons are left alone as they would get their inner
+ * edges outlined with glPolygonMode(GL_LINE), and lines since converting
+ * strips to lists restarts the line stipple.
+ */
+static void
+merge_into_indexed_triangles(struct gl_context *ctx,
+                             struct vbo_save_vertex_list *node)
+{
+   struct vbo_save_context *save = &vbo_context(ctx)->save;
+   GLuint num_indices = 0, index_size, size, i, j, n = 0;
+   GLuint *indices;
+
+   node->merged.ib.obj = NULL;
+
+   if (node->prim_count < 2)
+      return;
+
+   for (i = 0; i < node->prim_count; i++) {
+      int triangles = prim_triangle_count(&node->prims[i]);
+
+      if (triangles < 0 || node->prims[i].basevertex != 0 ||
+          node->prims[i].num_instances != 1)
+         return;
+
+      num_indices += 3 * triangles;
+   }
+
+   if (num_indices == 0)
+      return;
+
+   indices = malloc(num_indices * sizeof(GLuint));
+   if (!indices)
+      return;
+
+   for (i = 0; i < node->prim_count; i++) {
+      const struct _mesa_prim *prim = &node->prims[i];
+      const GLuint start = prim->start;
+      const GLuint triangles = prim_triangle_count(prim);
+
+      for (j = 0; j < triangles; j++) {
+         switch (prim->mode) {
+         case GL_TRIANGLES:
+            indices[n++] = start + 3 * j;
+            indices[n++] = start + 3 * j + 1;
+            indices[n++] = start + 3 * j + 2;
+            break;
+         case GL_TRIANGLE_STRIP:
+            /* Every other triangle has its first two vertices swapped */
+            indices[n++] = start + j + (j & 1);
+            indices[n++] = start + j + 1 - (j & 1);
+            indices[n++] = start + j + 2;
+            break;
+         case GL_TRIANGLE_FAN:
+            indices[n++] = start;
+            indices[n++] = start + j + 1;
+            indices[n++] = start + j + 2;
+            break;
+         }
+      }
+   }
+   assert(n == num_indices);
+
+   /* Pack to 16 bits in place if possible */
+   if (_vbo_save_get_max_index(node) <= 0xffff) {
+      GLushort *indices16 = (GLushort *) indices;
+
+      for (i = 0; i < num_indices; i++)
+         indices16[i] = indices[i];
+      index_size = sizeof(GLushort);
+   } else {
+      index_size = sizeof(GLuint);
+   }
+   size = num_indices * index_size;
+
+   /* Indices of several lists are packed into one buffer object, each list
+    * holding a reference to it.
+    */
+   if (!save->index_bo ||
+       save->index_used + size > save->index_bo->Size) {
+      struct gl_buffer_object *bo = ctx->Driver.NewBufferObject(ctx,
+                                                                VBO_BUF_ID);
+      _mesa_reference_buffer_object(ctx, &save->index_bo, NULL);
+
+      if (bo && ctx->Driver.BufferData(ctx, GL_ELEMENT_ARRAY_BUFFER_ARB,
+                                       MAX2(size, VBO_SAVE_INDEX_SIZE *
+                                                  sizeof(GLuint)),
+                                       NULL, GL_STATIC_DRAW_ARB,
+                                       GL_MAP_WRITE_BIT |
+                                       GL_DYNAMIC_STORAGE_BIT, bo)) {
+         save->index_bo = bo;
+         save->index_used = 0;
+      } else {
+         /* Not fatal, the list is just drawn one primitive at a time */
+         _mesa_reference_buffer_object(ctx, &bo, NULL);
+         free(indices);
+         return;
+      }
+   }
+
+   ctx->Driver.BufferSubData(ctx, save->index_used, size, indices,
+                             save->index_bo);
+   free(indices);
+
+   _mesa_reference_buffer_object(ctx, &node->merged.ib.obj, save->index_bo);
+   node->merged.ib.count = num_indices;
+   node->merged.ib.index_size = index_size;
+   node->merged.ib.ptr = (const void *) (uintptr_t) save->index_used;
+
+   /* Keep the offsets of all lists aligned */
+   save->index_used += ALIGN(size, sizeof(GLuint));
+
+   memset(&node->merged.prim, 0, sizeof(node->merged.prim));
+   node->merged.prim.mode = GL_TRIANGLES;
+   node->merged.prim.indexed = 1;
+   node->merged.prim.begin = 1;
+   node->merged.prim.end = 1;
+   node->merged.prim.count = num_indices;
+   node->merged.prim.num_instances = 1;
+}
+
+
 /* Compare the present vao if it has the same setup. */
 static bool
 compare_vao(gl_vertex_processing_mode mode,
@@ -654,6 +802,8 @@ compile_vertex_list(struct gl_context *ctx)
       node->prims[i].start += start_offset;
    }
 
+   merge_into_indexed_triangles(ctx, node);
+
    /* Deal with GL_COMPILE_AND_EXECUTE:
     */
    if (ctx->ExecuteFlag) {
@@ -1827,6 +1977,8 @@ vbo_destroy_vertex_list(struct gl_context *ctx, void *data)
    if (--node->prim_store->refcount == 0)
       free(node->prim_store);
 
+   _mesa_reference_buffer_object(ctx, &node->merged.ib.obj, NULL);
+
    free(node->current_data);
    node->current_data = NULL;
 }
@@ -218,8 +218,19 @@ vbo_save_playback_vertex_list(struct gl_context *ctx, void *data)
       if (node->vertex_count > 0) {
          GLuint min_index = _vbo_save_get_min_index(node);
          GLuint max_index = _vbo_save_get_max_index(node);
-         ctx->Driver.Draw(ctx, node->prims, node->prim_count, NULL, GL_TRUE,
-                          min_index, max_index, NULL, 0, NULL);
+
+         /* The merged draw keeps the last vertex of each triangle last and
+          * may use any index value.
+          */
+         if (node->merged.ib.obj &&
+             ctx->Light.ProvokingVertex == GL_LAST_VERTEX_CONVENTION_EXT &&
+             !ctx->Array._PrimitiveRestart) {
+            ctx->Driver.Draw(ctx, &node->merged.prim, 1, &node->merged.ib,
+                             GL_TRUE, min_index, max_index, NULL, 0, NULL);
+         } else {
+            ctx->Driver.Draw(ctx, node->prims, node->prim_count, NULL,
+                             GL_TRUE, min_index, max_index, NULL, 0, NULL);
+         }
       }
    }
 
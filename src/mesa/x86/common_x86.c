@@ -52,6 +52,15 @@
 #elif !defined(bit_SSE4_1) && !defined(bit_SSE41)
 #define bit_SSE4_1 0x00080000
 #endif
+#ifndef bit_OSXSAVE
+#define bit_OSXSAVE 0x08000000
+#endif
+#ifndef bit_AVX
+#define bit_AVX 0x10000000
+#endif
+#ifndef bit_AVX2
+#define bit_AVX2 0x00000020
+#endif
 #endif
 
 #include "main/errors.h"
@@ -204,6 +213,23 @@ void _mesa_check_os_sse_support( void )
 
 #endif /* USE_SSE_ASM */
 
+#if defined(USE_X86_64_ASM)
+/**
+ * Return the XCR0 register, which tells which register states the OS saves
+ * on context switches.  Only valid if CPUID reports OSXSAVE.
+ */
+static uint64_t
+_mesa_x86_xgetbv(void)
+{
+   uint32_t eax, edx;
+
+   /* xgetbv, spelled out for assemblers that don't know it */
+   __asm__ __volatile__(".byte 0x0f, 0x01, 0xd0"
+                        : "=a" (eax), "=d" (edx) : "c" (0));
+   return ((uint64_t)edx << 32) | eax;
+}
+#endif
+
 
 /**
  * Initialize the _mesa_x86_cpu_features bitfield.
@@ -352,6 +378,15 @@ _mesa_get_x86_features(void)
 
       if (ecx & bit_SSE4_1)
          _mesa_x86_cpu_features |= X86_FEATURE_SSE4_1;
+
+      /* AVX2 is only usable if the OS also saves the YMM registers. */
+      if ((ecx & bit_OSXSAVE) && (ecx & bit_AVX) &&
+          (_mesa_x86_xgetbv() & 0x6) == 0x6 &&
+          __get_cpuid_max(0, NULL) >= 7) {
+         __cpuid_count(7, 0, eax, ebx, ecx, edx);
+         if (ebx & bit_AVX2)
+            _mesa_x86_cpu_features |= X86_FEATURE_AVX2;
+      }
    }
 #endif /* USE_X86_64_ASM */
 
@@ -39,10 +39,15 @@
 #include <dirent.h>
 #include "zlib.h"
 
+#ifdef HAVE_ZSTD
+#include "zstd.h"
+#endif
+
 #include "util/crc32.h"
 #include "util/debug.h"
 #include "util/rand_xor.h"
 #include "util/u_atomic.h"
+#include "util/u_cpu_trace.h"
 #include "util/u_queue.h"
 #include "util/mesa-sha1.h"
 #include "util/ralloc.h"
@@ -50,6 +55,7 @@
 #include "main/errors.h"
 
 #include "disk_cache.h"
+#include "disk_cache_db.h"
 
 /* Number of bits to mask off from a cache key to get an index. */
 #define CACHE_INDEX_KEY_BITS 16
@@ -74,6 +80,22 @@
  */
 #define CACHE_VERSION 1
 
+/* Entries written by zstd builds start with the zstd frame magic number,
+ * while zlib streams can never start with these bytes. This lets either
+ * kind of build read entries compressed with zlib.
+ */
+#define ZSTD_FRAME_MAGIC 0xFD2FB528
+
+/* Entries stored without compression start with "MRAW", which neither
+ * codec can produce either.
+ */
+#define RAW_DATA_MAGIC 0x5741524D
+
+/* zstd level 1 decompresses several times faster than zlib, and with the
+ * entry sizes typical for shaders it compresses about as well.
+ */
+#define ZSTD_COMPRESSION_LEVEL 1
+
 struct disk_cache {
    /* The path to the cache directory. */
    char *path;
@@ -98,6 +120,16 @@ struct disk_cache {
    /* Maximum size of all cached objects (in bytes). */
    uint64_t max_size;
 
+   /* Single-file storage, used instead of one file per entry when
+    * MESA_GLSL_CACHE_SINGLE_FILE is set.
+    */
+   struct disk_cache_db *db;
+
+   /* Store entries uncompressed, so that disk_cache_get_mapped() can return
+    * them straight from the single-file mapping.
+    */
+   bool store_uncompressed;
+
    /* Driver cache keys. */
    uint8_t *driver_keys_blob;
    size_t driver_keys_blob_size;
@@ -122,6 +154,19 @@ struct disk_cache_put_job {
    struct cache_item_metadata cache_item_metadata;
 };
 
+struct disk_cache_get_batch_job {
+   struct util_queue_fence *fence;
+
+   struct disk_cache *cache;
+
+   unsigned num_keys;
+
+   /* Caller-owned arrays, filled in by the job. */
+   const cache_key *keys;
+   void **data;
+   size_t *sizes;
+};
+
 /* Create a directory named 'path' if it does not already exist.
  *
  * Returns: 0 if path already exists as a directory or if created.
@@ -370,15 +415,24 @@ disk_cache_create(const char *gpu_name, const char *timestamp,
 
    cache->max_size = max_size;
 
+   /* Fall back to the per-file layout if the database can't be opened. */
+   if (env_var_as_boolean("MESA_GLSL_CACHE_SINGLE_FILE", false))
+      cache->db = disk_cache_db_open(cache, cache->path, max_size);
+
+   cache->store_uncompressed =
+      env_var_as_boolean("MESA_GLSL_CACHE_UNCOMPRESSED", false);
+
    /* 1 thread was chosen because we don't really care about getting things
     * to disk quickly just that it's not blocking other tasks.
     *
     * The queue will resize automatically when it's full, so adding new jobs
-    * doesn't stall.
+    * doesn't stall, and it runs on the shared workers rather than starting
+    * a thread per cache.
     */
    util_queue_init(&cache->cache_queue, "disk$", 32, 1,
                    UTIL_QUEUE_INIT_RESIZE_IF_FULL |
-                   UTIL_QUEUE_INIT_USE_MINIMUM_PRIORITY);
+                   UTIL_QUEUE_INIT_USE_MINIMUM_PRIORITY |
+                   UTIL_QUEUE_INIT_SHARED);
 
    cache->path_init_failed = false;
 
@@ -436,6 +490,7 @@ disk_cache_destroy(struct disk_cache *cache)
 {
    if (cache && !cache->path_init_failed) {
       util_queue_destroy(&cache->cache_queue);
+      disk_cache_db_close(cache->db);
       munmap(cache->index_mmap, cache->index_mmap_size);
    }
 
@@ -671,6 +726,11 @@ disk_cache_remove(struct disk_cache *cache, const cache_key key)
 {
    struct stat sb;
 
+   if (cache->db) {
+      disk_cache_db_remove(cache->db, key);
+      return;
+   }
+
    char *filename = get_cache_file(cache, key);
    if (filename == NULL) {
       return;
@@ -718,73 +778,45 @@ write_all(int fd, const void *buf, size_t count)
    return done;
 }
 
-/* From the zlib docs:
- *    "If the memory is available, buffers sizes on the order of 128K or 256K
- *    bytes should be used."
+/**
+ * Returns the worst-case compressed size for \in_data_size bytes.
  */
-#define BUFSIZE 256 * 1024
+static size_t
+compress_bound(size_t in_data_size)
+{
+#ifdef HAVE_ZSTD
+   return ZSTD_compressBound(in_data_size);
+#else
+   return compressBound(in_data_size);
+#endif
+}
 
 /**
- * Compresses cache entry in memory and writes it to disk. Returns the size
- * of the data written to disk.
+ * Compresses cache entry data in memory. Returns the compressed size, or 0
+ * on failure.
  */
 static size_t
-deflate_and_write_to_disk(const void *in_data, size_t in_data_size, int dest,
-                          const char *filename)
+compress_cache_data(const void *in_data, size_t in_data_size,
+                    uint8_t *out_data, size_t out_data_size)
 {
-   unsigned char out[BUFSIZE];
+#ifdef HAVE_ZSTD
+   size_t compressed_size = ZSTD_compress(out_data, out_data_size,
+                                          in_data, in_data_size,
+                                          ZSTD_COMPRESSION_LEVEL);
+   if (ZSTD_isError(compressed_size))
+      return 0;
 
-   /* allocate deflate state */
-   z_stream strm;
-   strm.zalloc = Z_NULL;
-   strm.zfree = Z_NULL;
-   strm.opaque = Z_NULL;
-   strm.next_in = (uint8_t *) in_data;
-   strm.avail_in = in_data_size;
+   return compressed_size;
+#else
+   uLongf compressed_size = out_data_size;
 
-   int ret = deflateInit(&strm, Z_BEST_COMPRESSION);
+   int ret = compress2(out_data, &compressed_size, in_data, in_data_size,
+                       Z_BEST_COMPRESSION);
    if (ret != Z_OK)
-       return 0;
-
-   /* compress until end of in_data */
-   size_t compressed_size = 0;
-   int flush;
-   do {
-      int remaining = in_data_size - BUFSIZE;
-      flush = remaining > 0 ? Z_NO_FLUSH : Z_FINISH;
-      in_data_size -= BUFSIZE;
-
-      /* Run deflate() on input until the output buffer is not full (which
-       * means there is no more data to deflate).
-       */
-      do {
-         strm.avail_out = BUFSIZE;
-         strm.next_out = out;
-
-         ret = deflate(&strm, flush);    /* no bad return value */
-         assert(ret != Z_STREAM_ERROR);  /* state not clobbered */
-
-         size_t have = BUFSIZE - strm.avail_out;
-         compressed_size += have;
-
-         ssize_t written = write_all(dest, out, have);
-         if (written == -1) {
-            (void)deflateEnd(&strm);
-            return 0;
-         }
-      } while (strm.avail_out == 0);
-
-      /* all input should be used */
-      assert(strm.avail_in == 0);
-
-   } while (flush != Z_FINISH);
-
-   /* stream should be complete */
-   assert(ret == Z_STREAM_END);
+      return 0;
 
-   /* clean up and return */
-   (void)deflateEnd(&strm);
    return compressed_size;
+#endif
 }
 
 static struct disk_cache_put_job *
@@ -848,6 +880,85 @@ struct cache_entry_file_data {
    uint32_t uncompressed_size;
 };
 
+/**
+ * Serializes a cache entry into a single malloc'ed buffer, in the layout
+ * shared by the per-file and single-file storage. Returns NULL on failure.
+ */
+static uint8_t *
+create_cache_entry(struct disk_cache_put_job *dc_job, size_t *entry_size)
+{
+   struct disk_cache *cache = dc_job->cache;
+   struct cache_item_metadata *md = &dc_job->cache_item_metadata;
+
+   size_t md_size = sizeof(uint32_t);
+   if (md->type == CACHE_ITEM_TYPE_GLSL)
+      md_size += sizeof(uint32_t) + md->num_keys * sizeof(cache_key);
+
+   size_t header_size = cache->driver_keys_blob_size + md_size +
+                        sizeof(struct cache_entry_file_data);
+   size_t max_compressed_size = cache->store_uncompressed ?
+      sizeof(uint32_t) + dc_job->size : compress_bound(dc_job->size);
+
+   uint8_t *entry = malloc(header_size + max_compressed_size);
+   if (entry == NULL)
+      return NULL;
+
+   /* Write the driver_keys_blob, this can be used find information about the
+    * mesa version that produced the entry or deal with hash collisions,
+    * should that ever become a real problem.
+    */
+   uint8_t *out = entry;
+   DRV_KEY_CPY(out, cache->driver_keys_blob, cache->driver_keys_blob_size)
+
+   /* Write the cache item metadata. This data can be used to deal with
+    * hash collisions, as well as providing useful information to 3rd party
+    * tools reading the cache files.
+    */
+   DRV_KEY_CPY(out, &md->type, sizeof(uint32_t))
+   if (md->type == CACHE_ITEM_TYPE_GLSL) {
+      DRV_KEY_CPY(out, &md->num_keys, sizeof(uint32_t))
+      DRV_KEY_CPY(out, md->keys[0], md->num_keys * sizeof(cache_key))
+   }
+
+   /* Create CRC of the data. We will read this when restoring the cache and
+    * use it to check for corruption.
+    */
+   struct cache_entry_file_data cf_data;
+   cf_data.crc32 = util_hash_crc32(dc_job->data, dc_job->size);
+   cf_data.uncompressed_size = dc_job->size;
+   DRV_KEY_CPY(out, &cf_data, sizeof(cf_data))
+
+   size_t compressed_size;
+   if (cache->store_uncompressed) {
+      uint32_t magic = CPU_TO_LE32(RAW_DATA_MAGIC);
+      memcpy(out, &magic, sizeof(magic));
+      memcpy(out + sizeof(magic), dc_job->data, dc_job->size);
+      compressed_size = max_compressed_size;
+   } else {
+      compressed_size = compress_cache_data(dc_job->data, dc_job->size,
+                                            out, max_compressed_size);
+   }
+   if (compressed_size == 0) {
+      free(entry);
+      return NULL;
+   }
+
+   *entry_size = header_size + compressed_size;
+   return entry;
+}
+
+static void
+cache_put_db(struct disk_cache_put_job *dc_job)
+{
+   size_t entry_size;
+   uint8_t *entry = create_cache_entry(dc_job, &entry_size);
+
+   if (entry) {
+      disk_cache_db_put(dc_job->cache->db, dc_job->key, entry, entry_size);
+      free(entry);
+   }
+}
+
 static void
 cache_put(void *job, int thread_index)
 {
@@ -858,6 +969,11 @@ cache_put(void *job, int thread_index)
    char *filename = NULL, *filename_tmp = NULL;
    struct disk_cache_put_job *dc_job = (struct disk_cache_put_job *) job;
 
+   if (dc_job->cache->db) {
+      cache_put_db(dc_job);
+      return;
+   }
+
    filename = get_cache_file(dc_job->cache, dc_job->key);
    if (filename == NULL)
       goto done;
@@ -916,55 +1032,9 @@ cache_put(void *job, int thread_index)
     * by some other process.
     */
 
-   /* Write the driver_keys_blob, this can be used find information about the
-    * mesa version that produced the entry or deal with hash collisions,
-    * should that ever become a real problem.
-    */
-   ret = write_all(fd, dc_job->cache->driver_keys_blob,
-                   dc_job->cache->driver_keys_blob_size);
-   if (ret == -1) {
-      unlink(filename_tmp);
-      goto done;
-   }
-
-   /* Write the cache item metadata. This data can be used to deal with
-    * hash collisions, as well as providing useful information to 3rd party
-    * tools reading the cache files.
-    */
-   ret = write_all(fd, &dc_job->cache_item_metadata.type,
-                   sizeof(uint32_t));
-   if (ret == -1) {
-      unlink(filename_tmp);
-      goto done;
-   }
-
-   if (dc_job->cache_item_metadata.type == CACHE_ITEM_TYPE_GLSL) {
-      ret = write_all(fd, &dc_job->cache_item_metadata.num_keys,
-                      sizeof(uint32_t));
-      if (ret == -1) {
-         unlink(filename_tmp);
-         goto done;
-      }
-
-      ret = write_all(fd, dc_job->cache_item_metadata.keys[0],
-                      dc_job->cache_item_metadata.num_keys *
-                      sizeof(cache_key));
-      if (ret == -1) {
-         unlink(filename_tmp);
-         goto done;
-      }
-   }
-
-   /* Create CRC of the data. We will read this when restoring the cache and
-    * use it to check for corruption.
-    */
-   struct cache_entry_file_data cf_data;
-   cf_data.crc32 = util_hash_crc32(dc_job->data, dc_job->size);
-   cf_data.uncompressed_size = dc_job->size;
-
-   size_t cf_data_size = sizeof(cf_data);
-   ret = write_all(fd, &cf_data, cf_data_size);
-   if (ret == -1) {
+   size_t entry_size;
+   uint8_t *entry = create_cache_entry(dc_job, &entry_size);
+   if (entry == NULL) {
       unlink(filename_tmp);
       goto done;
    }
@@ -973,9 +1043,9 @@ cache_put(void *job, int thread_index)
     * rename them atomically to the destination filename, and also
     * perform an atomic increment of the total cache size.
     */
-   size_t file_size = deflate_and_write_to_disk(dc_job->data, dc_job->size,
-                                                fd, filename_tmp);
-   if (file_size == 0) {
+   ret = write_all(fd, entry, entry_size);
+   free(entry);
+   if (ret == -1) {
       unlink(filename_tmp);
       goto done;
    }
@@ -1068,6 +1138,213 @@ inflate_cache_data(uint8_t *in_data, size_t in_data_size,
    return true;
 }
 
+/**
+ * Decompresses cache entry data written by either codec, returns true if
+ * successful.
+ */
+static bool
+decompress_cache_data(uint8_t *in_data, size_t in_data_size,
+                      uint8_t *out_data, size_t out_data_size)
+{
+   uint32_t magic = 0;
+
+   if (in_data_size >= sizeof(magic))
+      memcpy(&magic, in_data, sizeof(magic));
+
+   if (CPU_TO_LE32(magic) == RAW_DATA_MAGIC) {
+      if (in_data_size - sizeof(magic) != out_data_size)
+         return false;
+      memcpy(out_data, in_data + sizeof(magic), out_data_size);
+      return true;
+   }
+
+   if (CPU_TO_LE32(magic) == ZSTD_FRAME_MAGIC) {
+#ifdef HAVE_ZSTD
+      size_t ret = ZSTD_decompress(out_data, out_data_size,
+                                   in_data, in_data_size);
+      return !ZSTD_isError(ret) && ret == out_data_size;
+#else
+      return false;
+#endif
+   }
+
+   return inflate_cache_data(in_data, in_data_size, out_data, out_data_size);
+}
+
+/**
+ * Validates the header of a serialized cache entry. Returns a pointer to the
+ * (compressed) data following it and its size, or NULL if the entry is not
+ * usable.
+ */
+static const uint8_t *
+parse_cache_entry_header(struct disk_cache *cache, const uint8_t *entry,
+                         size_t entry_size, size_t *data_size,
+                         struct cache_entry_file_data *cf_data)
+{
+   const uint8_t *in = entry;
+   const uint8_t *end = entry + entry_size;
+
+   size_t ck_size = cache->driver_keys_blob_size;
+   if (entry_size < ck_size)
+      return NULL;
+
+   /* Check for extremely unlikely hash collisions */
+   if (memcmp(cache->driver_keys_blob, in, ck_size) != 0) {
+      assert(!"Mesa cache keys mismatch!");
+      return NULL;
+   }
+   in += ck_size;
+
+   uint32_t md_type;
+   if (end - in < sizeof(md_type))
+      return NULL;
+   memcpy(&md_type, in, sizeof(md_type));
+   in += sizeof(md_type);
+
+   if (md_type == CACHE_ITEM_TYPE_GLSL) {
+      uint32_t num_keys;
+      if (end - in < sizeof(num_keys))
+         return NULL;
+      memcpy(&num_keys, in, sizeof(num_keys));
+      in += sizeof(num_keys);
+
+      /* The cache item metadata is currently just used for distributing
+       * precompiled shaders, they are not used by Mesa so just skip them for
+       * now.
+       * TODO: pass the metadata back to the caller and do some basic
+       * validation.
+       */
+      if (end - in < num_keys * sizeof(cache_key))
+         return NULL;
+      in += num_keys * sizeof(cache_key);
+   }
+
+   /* Load the CRC that was created when the file was written. */
+   if (end - in < sizeof(*cf_data))
+      return NULL;
+   memcpy(cf_data, in, sizeof(*cf_data));
+   in += sizeof(*cf_data);
+
+   *data_size = end - in;
+   return in;
+}
+
+/**
+ * Validates a serialized cache entry and decompresses its data. Returns the
+ * malloc'ed data, or NULL if the entry is not usable.
+ */
+static void *
+parse_cache_entry(struct disk_cache *cache, const uint8_t *entry,
+                  size_t entry_size, size_t *size)
+{
+   struct cache_entry_file_data cf_data;
+   const uint8_t *in;
+   size_t in_size;
+
+   in = parse_cache_entry_header(cache, entry, entry_size, &in_size,
+                                 &cf_data);
+   if (!in)
+      return NULL;
+
+   /* Uncompress the cache data */
+   uint8_t *uncompressed_data = malloc(cf_data.uncompressed_size);
+   if (!uncompressed_data)
+      return NULL;
+
+   if (!decompress_cache_data((uint8_t *) in, in_size, uncompressed_data,
+                              cf_data.uncompressed_size))
+      goto fail;
+
+   /* Check the data for corruption */
+   if (cf_data.crc32 != util_hash_crc32(uncompressed_data,
+                                        cf_data.uncompressed_size))
+      goto fail;
+
+   if (size)
+      *size = cf_data.uncompressed_size;
+
+   return uncompressed_data;
+
+ fail:
+   free(uncompressed_data);
+   return NULL;
+}
+
+/**
+ * Returns the data of an entry stored with RAW_DATA_MAGIC in place, or NULL
+ * if it is compressed or corrupt.
+ */
+static const uint8_t *
+get_raw_cache_entry_data(struct disk_cache *cache, const uint8_t *entry,
+                         size_t entry_size, size_t *size)
+{
+   struct cache_entry_file_data cf_data;
+   const uint8_t *in;
+   size_t in_size;
+   uint32_t magic;
+
+   in = parse_cache_entry_header(cache, entry, entry_size, &in_size,
+                                 &cf_data);
+   if (!in || in_size < sizeof(magic))
+      return NULL;
+
+   memcpy(&magic, in, sizeof(magic));
+   if (CPU_TO_LE32(magic) != RAW_DATA_MAGIC ||
+       in_size - sizeof(magic) != cf_data.uncompressed_size)
+      return NULL;
+   in += sizeof(magic);
+
+   if (cf_data.crc32 != util_hash_crc32(in, cf_data.uncompressed_size))
+      return NULL;
+
+   *size = cf_data.uncompressed_size;
+   return in;
+}
+
+bool
+disk_cache_get_mapped(struct disk_cache *cache, const cache_key key,
+                      struct disk_cache_mapped_entry *entry)
+{
+   memset(entry, 0, sizeof(*entry));
+
+   if (cache->db && !cache->blob_get_cb && !cache->path_init_failed) {
+      struct disk_cache_db_map *map = NULL;
+      const uint8_t *record;
+      size_t record_size;
+
+      MESA_TRACE_FUNC();
+
+      record = disk_cache_db_get_mapped(cache->db, key, &record_size, &map);
+      if (!record)
+         return false;
+
+      entry->data = get_raw_cache_entry_data(cache, record, record_size,
+                                             &entry->size);
+      if (entry->data) {
+         entry->map = map;
+         return true;
+      }
+
+      /* Compressed, decompress straight out of the mapping. */
+      entry->copy = parse_cache_entry(cache, record, record_size,
+                                      &entry->size);
+      disk_cache_db_map_release(map);
+   } else {
+      entry->copy = disk_cache_get(cache, key, &entry->size);
+   }
+
+   entry->data = entry->copy;
+   return entry->data != NULL;
+}
+
+void
+disk_cache_release_mapped(struct disk_cache_mapped_entry *entry)
+{
+   free(entry->copy);
+   disk_cache_db_map_release(entry->map);
+   memset(entry, 0, sizeof(*entry));
+}
+
 void *
 disk_cache_get(struct disk_cache *cache, const cache_key key, size_t *size)
 {
@@ -1076,11 +1353,12 @@ disk_cache_get(struct disk_cache *cache, const cache_key key, size_t *size)
    char *filename = NULL;
    uint8_t *data = NULL;
    uint8_t *uncompressed_data = NULL;
-   uint8_t *file_header = NULL;
 
    if (size)
       *size = 0;
 
+   MESA_TRACE_FUNC();
+
    if (cache->blob_get_cb) {
       /* This is what Android EGL defines as the maxValueSize in egl_cache_t
        * class implementation.
@@ -1103,6 +1381,21 @@ disk_cache_get(struct disk_cache *cache, const cache_key key, size_t *size)
       return blob;
    }
 
+   if (cache->path_init_failed)
+      return NULL;
+
+   if (cache->db) {
+      size_t entry_size;
+      data = disk_cache_db_get(cache->db, key, &entry_size);
+      if (data == NULL)
+         return NULL;
+
+      uncompressed_data = parse_cache_entry(cache, data, entry_size, size);
+      free(data);
+
+      return uncompressed_data;
+   }
+
    filename = get_cache_file(cache, key);
    if (filename == NULL)
       goto fail;
@@ -1118,97 +1411,71 @@ disk_cache_get(struct disk_cache *cache, const cache_key key, size_t *size)
    if (data == NULL)
       goto fail;
 
-   size_t ck_size = cache->driver_keys_blob_size;
-   file_header = malloc(ck_size);
-   if (!file_header)
-      goto fail;
-
-   if (sb.st_size < ck_size)
-      goto fail;
-
-   ret = read_all(fd, file_header, ck_size);
-   if (ret == -1)
-      goto fail;
-
-   /* Check for extremely unlikely hash collisions */
-   if (memcmp(cache->driver_keys_blob, file_header, ck_size) != 0) {
-      assert(!"Mesa cache keys mismatch!");
-      goto fail;
-   }
-
-   size_t cache_item_md_size = sizeof(uint32_t);
-   uint32_t md_type;
-   ret = read_all(fd, &md_type, cache_item_md_size);
-   if (ret == -1)
-      goto fail;
-
-   if (md_type == CACHE_ITEM_TYPE_GLSL) {
-      uint32_t num_keys;
-      cache_item_md_size += sizeof(uint32_t);
-      ret = read_all(fd, &num_keys, sizeof(uint32_t));
-      if (ret == -1)
-         goto fail;
-
-      /* The cache item metadata is currently just used for distributing
-       * precompiled shaders, they are not used by Mesa so just skip them for
-       * now.
-       * TODO: pass the metadata back to the caller and do some basic
-       * validation.
-       */
-      cache_item_md_size += num_keys * sizeof(cache_key);
-      ret = lseek(fd, num_keys * sizeof(cache_key), SEEK_CUR);
-      if (ret == -1)
-         goto fail;
-   }
-
-   /* Load the CRC that was created when the file was written. */
-   struct cache_entry_file_data cf_data;
-   size_t cf_data_size = sizeof(cf_data);
-   ret = read_all(fd, &cf_data, cf_data_size);
-   if (ret == -1)
-      goto fail;
-
-   /* Load the actual cache data. */
-   size_t cache_data_size =
-      sb.st_size - cf_data_size - ck_size - cache_item_md_size;
-   ret = read_all(fd, data, cache_data_size);
+   /* Read the whole entry at once rather than piece by piece. */
+   ret = read_all(fd, data, sb.st_size);
    if (ret == -1)
       goto fail;
 
-   /* Uncompress the cache data */
-   uncompressed_data = malloc(cf_data.uncompressed_size);
-   if (!inflate_cache_data(data, cache_data_size, uncompressed_data,
-                           cf_data.uncompressed_size))
-      goto fail;
-
-   /* Check the data for corruption */
-   if (cf_data.crc32 != util_hash_crc32(uncompressed_data,
-                                        cf_data.uncompressed_size))
-      goto fail;
-
-   free(data);
-   free(filename);
-   free(file_header);
-   close(fd);
-
-   if (size)
-      *size = cf_data.uncompressed_size;
-
-   return uncompressed_data;
+   uncompressed_data = parse_cache_entry(cache, data, sb.st_size, size);
 
  fail:
    if (data)
       free(data);
-   if (uncompressed_data)
-      free(uncompressed_data);
    if (filename)
       free(filename);
-   if (file_header)
-      free(file_header);
    if (fd != -1)
       close(fd);
 
-   return NULL;
+   return uncompressed_data;
+}
+
+static void
+cache_get_batch(void *job, int thread_index)
+{
+   struct disk_cache_get_batch_job *batch =
+      (struct disk_cache_get_batch_job *) job;
+
+   for (unsigned i = 0; i < batch->num_keys; i++) {
+      batch->data[i] = disk_cache_get(batch->cache, batch->keys[i],
+                                      batch->sizes ? &batch->sizes[i] : NULL);
+   }
+}
+
+static void
+destroy_get_batch_job(void *job, int thread_index)
+{
+   free(job);
+}
+
+void
+disk_cache_get_batch(struct disk_cache *cache, unsigned num_keys,
+                     const cache_key *keys, void **data, size_t *sizes,
+                     struct util_queue_fence *fence)
+{
+   struct disk_cache_get_batch_job *batch =
+      (struct disk_cache_get_batch_job *) malloc(sizeof(*batch));
+
+   if (batch) {
+      batch->fence = fence;
+      batch->cache = cache;
+      batch->num_keys = num_keys;
+      batch->keys = keys;
+      batch->data = data;
+      batch->sizes = sizes;
+   }
+
+   /* Without a worker thread, (or a callback-backed cache where lookups are
+    * cheap), just do the lookups right away and leave the fence signalled.
+    */
+   if (!batch || cache->blob_get_cb || cache->path_init_failed) {
+      for (unsigned i = 0; i < num_keys; i++)
+         data[i] = disk_cache_get(cache, keys[i], sizes ? &sizes[i] : NULL);
+      free(batch);
+      return;
+   }
+
+   util_queue_add_job(&cache->cache_queue, batch, fence,
+                      cache_get_batch, destroy_get_batch_job);
 }
 
 void
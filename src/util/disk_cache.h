@@ -30,6 +30,7 @@
 #include <assert.h>
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <sys/stat.h>
 
 #ifdef __cplusplus
@@ -71,7 +72,21 @@ struct cache_item_metadata {
    uint32_t num_keys;
 };
 
+/**
+ * An item returned by disk_cache_get_mapped().
+ */
+struct disk_cache_mapped_entry {
+   const void *data;
+   size_t size;
+
+   /* Private, what disk_cache_release_mapped() has to drop. */
+   void *copy;
+   struct disk_cache_db_map *map;
+};
+
 struct disk_cache;
+struct disk_cache_db_map;
+struct util_queue_fence;
 
 static inline char *
 disk_cache_format_hex_id(char *buf, const uint8_t *hex_id, unsigned size)
@@ -181,6 +196,39 @@ disk_cache_put(struct disk_cache *cache, const cache_key key,
 void *
 disk_cache_get(struct disk_cache *cache, const cache_key key, size_t *size);
 
+/**
+ * Retrieve an item like disk_cache_get(), but without copying it if possible.
+ *
+ * Items that the single-file cache stores uncompressed (see
+ * MESA_GLSL_CACHE_UNCOMPRESSED) are returned as a pointer into the mapping
+ * of the cache file. Anything else is returned as a private copy. Either
+ * way, \entry->data is read-only and stays valid until
+ * disk_cache_release_mapped() is called on \entry.
+ *
+ * \return false if the item is not found.
+ */
+bool
+disk_cache_get_mapped(struct disk_cache *cache, const cache_key key,
+                      struct disk_cache_mapped_entry *entry);
+
+void
+disk_cache_release_mapped(struct disk_cache_mapped_entry *entry);
+
+/**
+ * Retrieve several items at once, without blocking the caller.
+ *
+ * The lookups are performed on the cache's worker thread. Once \fence
+ * (which the caller must have initialized with util_queue_fence_init()) is
+ * signalled, \data[i] holds the result of disk_cache_get() for \keys[i]
+ * and, if \sizes is non-NULL, \sizes[i] its size. The caller owns the
+ * returned objects and must free() them. All arrays must stay valid until
+ * the fence is signalled.
+ */
+void
+disk_cache_get_batch(struct disk_cache *cache, unsigned num_keys,
+                     const cache_key *keys, void **data, size_t *sizes,
+                     struct util_queue_fence *fence);
+
 /**
  * Store the name \key within the cache, (without any associated data).
  *
@@ -251,6 +299,31 @@ disk_cache_get(struct disk_cache *cache, const cache_key key, size_t *size)
    return NULL;
 }
 
+static inline bool
+disk_cache_get_mapped(struct disk_cache *cache, const cache_key key,
+                      struct disk_cache_mapped_entry *entry)
+{
+   return false;
+}
+
+static inline void
+disk_cache_release_mapped(struct disk_cache_mapped_entry *entry)
+{
+   return;
+}
+
+static inline void
+disk_cache_get_batch(struct disk_cache *cache, unsigned num_keys,
+                     const cache_key *keys, void **data, size_t *sizes,
+                     struct util_queue_fence *fence)
+{
+   for (unsigned i = 0; i < num_keys; i++) {
+      data[i] = NULL;
+      if (sizes)
+         sizes[i] = 0;
+   }
+}
+
 static inline void
 disk_cache_put_key(struct disk_cache *cache, const cache_key key)
 {
@@ -0,0 +1,803 @@
+/*
+ * Copyright © 2018 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifdef ENABLE_SHADER_CACHE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "c11/threads.h"
+#include "util/hash_table.h"
+#include "util/ralloc.h"
+#include "util/u_atomic.h"
+
+#include "disk_cache_db.h"
+
+#define DB_FILE_NAME "mesa_cache.db"
+#define IDX_FILE_NAME "mesa_cache.idx"
+
+/* Files carrying a different version are discarded and recreated. */
+#define DB_VERSION 1
+
+/* Number of index entries read with a single pread(). */
+#define IDX_READ_BATCH 128
+
+static const char db_magic[8] = "MESACDB";
+static const char idx_magic[8] = "MESACIX";
+
+struct db_file_header {
+   char magic[8];
+   uint32_t version;
+   uint32_t reserved;
+};
+
+/* Written in front of every record of the data file.  Readers compare it
+ * against the index entry before trusting a record, which protects against
+ * an index that was swapped out by another process's compaction.
+ */
+struct db_record_header {
+   cache_key key;
+   uint32_t size;
+};
+
+struct db_index_entry {
+   cache_key key;
+   /* Size of the record payload, 0 marks a removed key. */
+   uint32_t size;
+   /* Offset of the db_record_header within the data file. */
+   uint64_t offset;
+};
+
+/* Read-only mapping of the data file.  Records are never modified after
+ * they are written and compaction renames new files into place, so the
+ * bytes of a mapping stay valid for as long as a reference to it is held,
+ * even after the database itself moved on to a newer mapping.
+ */
+struct disk_cache_db_map {
+   int refcount;
+   uint8_t *ptr;
+   size_t size;
+};
+
+/* In-memory copy of the live index entries. */
+struct db_entry {
+   cache_key key;
+   uint32_t size;
+   uint64_t offset;
+};
+
+struct disk_cache_db {
+   mtx_t mutex;
+
+   char *db_path;
+   char *idx_path;
+
+   int db_fd;
+   int idx_fd;
+
+   /* Inodes of the open files, a mismatch with the paths means another
+    * process compacted the database and renamed new files into place.
+    */
+   ino_t db_ino;
+   ino_t idx_ino;
+
+   /* Headers have been checked since the files were last (re)opened. */
+   bool validated;
+
+   /* Current mapping of the data file, or NULL. */
+   struct disk_cache_db_map *map;
+
+   /* Number of bytes of the index file already loaded into entries. */
+   uint64_t idx_loaded;
+
+   void *entries_ctx;
+   struct hash_table *entries;
+
+   uint64_t max_size;
+};
+
+static uint32_t
+key_hash(const void *key)
+{
+   /* Keys are SHA-1 hashes, so any four bytes are as good as a real hash. */
+   uint32_t hash;
+   memcpy(&hash, key, sizeof(hash));
+   return hash;
+}
+
+static bool
+key_equals(const void *a, const void *b)
+{
+   return memcmp(a, b, CACHE_KEY_SIZE) == 0;
+}
+
+static bool
+pread_all(int fd, void *buf, size_t count, uint64_t offset)
+{
+   uint8_t *in = buf;
+   size_t done;
+   ssize_t ret;
+
+   for (done = 0; done < count; done += ret) {
+      ret = pread(fd, in + done, count - done, offset + done);
+      if (ret == -1 || ret == 0)
+         return false;
+   }
+   return true;
+}
+
+static bool
+pwrite_all(int fd, const void *buf, size_t count, uint64_t offset)
+{
+   const uint8_t *out = buf;
+   size_t done;
+   ssize_t ret;
+
+   for (done = 0; done < count; done += ret) {
+      ret = pwrite(fd, out + done, count - done, offset + done);
+      if (ret == -1)
+         return false;
+   }
+   return true;
+}
+
+static bool
+header_is_valid(int fd, const char *magic)
+{
+   struct db_file_header header;
+
+   if (!pread_all(fd, &header, sizeof(header), 0))
+      return false;
+
+   return memcmp(header.magic, magic, sizeof(header.magic)) == 0 &&
+          header.version == DB_VERSION;
+}
+
+static bool
+write_header(int fd, const char *magic)
+{
+   struct db_file_header header;
+
+   memset(&header, 0, sizeof(header));
+   memcpy(header.magic, magic, sizeof(header.magic));
+   header.version = DB_VERSION;
+
+   return pwrite_all(fd, &header, sizeof(header), 0);
+}
+
+static void
+reset_entries(struct disk_cache_db *db)
+{
+   ralloc_free(db->entries_ctx);
+   db->entries_ctx = ralloc_context(db);
+   db->entries = _mesa_hash_table_create(db->entries_ctx, key_hash,
+                                         key_equals);
+   db->idx_loaded = 0;
+}
+
+void
+disk_cache_db_map_release(struct disk_cache_db_map *map)
+{
+   if (map && p_atomic_dec_zero(&map->refcount)) {
+      munmap(map->ptr, map->size);
+      free(map);
+   }
+}
+
+static void
+close_files(struct disk_cache_db *db)
+{
+   disk_cache_db_map_release(db->map);
+   db->map = NULL;
+
+   if (db->db_fd != -1)
+      close(db->db_fd);
+   if (db->idx_fd != -1)
+      close(db->idx_fd);
+   db->db_fd = -1;
+   db->idx_fd = -1;
+}
+
+static bool
+open_files(struct disk_cache_db *db)
+{
+   struct stat sb;
+
+   close_files(db);
+   reset_entries(db);
+   db->validated = false;
+
+   db->db_fd = open(db->db_path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+   if (db->db_fd == -1 || fstat(db->db_fd, &sb) == -1)
+      goto fail;
+   db->db_ino = sb.st_ino;
+
+   db->idx_fd = open(db->idx_path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+   if (db->idx_fd == -1 || fstat(db->idx_fd, &sb) == -1)
+      goto fail;
+   db->idx_ino = sb.st_ino;
+
+   return true;
+
+ fail:
+   close_files(db);
+   return false;
+}
+
+/* Returns false if another process renamed new files into place. */
+static bool
+files_are_current(struct disk_cache_db *db)
+{
+   struct stat sb;
+
+   if (db->db_fd == -1)
+      return false;
+
+   if (stat(db->db_path, &sb) == -1 || sb.st_ino != db->db_ino)
+      return false;
+
+   if (stat(db->idx_path, &sb) == -1 || sb.st_ino != db->idx_ino)
+      return false;
+
+   return true;
+}
+
+static void
+insert_entry(struct disk_cache_db *db, const struct db_index_entry *idx)
+{
+   struct hash_entry *he = _mesa_hash_table_search(db->entries, idx->key);
+
+   if (idx->size == 0) {
+      if (he)
+         _mesa_hash_table_remove(db->entries, he);
+      return;
+   }
+
+   struct db_entry *entry;
+   if (he) {
+      entry = he->data;
+   } else {
+      entry = ralloc(db->entries_ctx, struct db_entry);
+      if (!entry)
+         return;
+      memcpy(entry->key, idx->key, CACHE_KEY_SIZE);
+      _mesa_hash_table_insert(db->entries, entry->key, entry);
+   }
+
+   entry->size = idx->size;
+   entry->offset = idx->offset;
+}
+
+/* Pull in any index entries appended since the last call. */
+static void
+load_index(struct disk_cache_db *db)
+{
+   struct db_index_entry batch[IDX_READ_BATCH];
+   struct stat sb;
+
+   if (fstat(db->idx_fd, &sb) == -1)
+      return;
+
+   if (db->idx_loaded == 0) {
+      if (sb.st_size < sizeof(struct db_file_header) ||
+          !header_is_valid(db->idx_fd, idx_magic))
+         return;
+      db->idx_loaded = sizeof(struct db_file_header);
+   }
+
+   while (db->idx_loaded + sizeof(batch[0]) <= sb.st_size) {
+      uint64_t count = (sb.st_size - db->idx_loaded) / sizeof(batch[0]);
+      if (count > IDX_READ_BATCH)
+         count = IDX_READ_BATCH;
+
+      if (!pread_all(db->idx_fd, batch, count * sizeof(batch[0]),
+                     db->idx_loaded))
+         return;
+
+      for (unsigned i = 0; i < count; i++)
+         insert_entry(db, &batch[i]);
+
+      db->idx_loaded += count * sizeof(batch[0]);
+   }
+}
+
+static bool
+append_index_entry(struct disk_cache_db *db, const struct db_index_entry *idx)
+{
+   struct stat sb;
+
+   if (fstat(db->idx_fd, &sb) == -1)
+      return false;
+
+   /* Overwrite any partial entry left behind by a writer that died half-way
+    * through, so that later entries stay aligned.
+    */
+   uint64_t offset = sizeof(struct db_file_header) +
+      (sb.st_size - sizeof(struct db_file_header)) / sizeof(*idx) *
+      sizeof(*idx);
+
+   return pwrite_all(db->idx_fd, idx, sizeof(*idx), offset);
+}
+
+static int
+compare_entry_offsets(const void *a, const void *b)
+{
+   const struct db_entry *ea = *(const struct db_entry **) a;
+   const struct db_entry *eb = *(const struct db_entry **) b;
+
+   return ea->offset < eb->offset ? -1 : ea->offset > eb->offset;
+}
+
+/* Write new database files holding the most recently added records that fit
+ * in \budget bytes, and rename them over the current ones.
+ *
+ * Must be called with the database locked. On success the lock is held on
+ * the newly created files; on failure the old files stay locked.
+ */
+static bool
+rewrite_files(struct disk_cache_db *db, uint64_t budget)
+{
+   struct db_entry **live = NULL;
+   uint8_t *buf = NULL;
+   char *db_tmp = NULL, *idx_tmp = NULL;
+   int db_fd = -1, idx_fd = -1;
+   unsigned num_live = 0, first_kept;
+   bool ret = false;
+
+   db_tmp = ralloc_asprintf(NULL, "%s.tmp", db->db_path);
+   idx_tmp = ralloc_asprintf(db_tmp, "%s.tmp", db->idx_path);
+   if (!db_tmp || !idx_tmp)
+      goto done;
+
+   db_fd = open(db_tmp, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+   if (db_fd == -1)
+      goto done;
+
+   /* Only the holder of the lock on the current data file gets here, but
+    * don't wait on a temporary file if something went badly wrong.
+    */
+   if (flock(db_fd, LOCK_EX | LOCK_NB) == -1)
+      goto done;
+
+   idx_fd = open(idx_tmp, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+   if (idx_fd == -1)
+      goto done;
+
+   if (!write_header(db_fd, db_magic) || !write_header(idx_fd, idx_magic))
+      goto done;
+
+   live = malloc(_mesa_hash_table_num_entries(db->entries) * sizeof(*live));
+   if (!live && _mesa_hash_table_num_entries(db->entries))
+      goto done;
+
+   struct hash_entry *he;
+   hash_table_foreach(db->entries, he)
+      live[num_live++] = he->data;
+
+   qsort(live, num_live, sizeof(*live), compare_entry_offsets);
+
+   /* Walk backwards from the newest record to find the oldest one kept. */
+   uint64_t kept_size = 0;
+   for (first_kept = num_live; first_kept > 0; first_kept--) {
+      uint64_t record_size = sizeof(struct db_record_header) +
+         live[first_kept - 1]->size;
+      if (kept_size + record_size > budget)
+         break;
+      kept_size += record_size;
+   }
+
+   uint64_t db_offset = sizeof(struct db_file_header);
+   uint64_t idx_offset = sizeof(struct db_file_header);
+   for (unsigned i = first_kept; i < num_live; i++) {
+      size_t record_size = sizeof(struct db_record_header) + live[i]->size;
+      uint8_t *tmp = realloc(buf, record_size);
+      if (!tmp)
+         goto done;
+      buf = tmp;
+
+      if (!pread_all(db->db_fd, buf, record_size, live[i]->offset) ||
+          !pwrite_all(db_fd, buf, record_size, db_offset))
+         goto done;
+
+      struct db_index_entry idx;
+      memcpy(idx.key, live[i]->key, CACHE_KEY_SIZE);
+      idx.size = live[i]->size;
+      idx.offset = db_offset;
+      if (!pwrite_all(idx_fd, &idx, sizeof(idx), idx_offset))
+         goto done;
+
+      db_offset += record_size;
+      idx_offset += sizeof(idx);
+   }
+
+   /* Readers verify record headers, so a window where only the data file
+    * has been replaced just shows up as cache misses.
+    */
+   if (rename(db_tmp, db->db_path) == -1)
+      goto done;
+   if (rename(idx_tmp, db->idx_path) == -1) {
+      unlink(db->idx_path);
+      goto done;
+   }
+
+   /* Switch over to the new files, keeping the lock held on the new data
+    * file. Closing the old one releases waiters, which will notice the
+    * rename and reopen.
+    */
+   close_files(db);
+   reset_entries(db);
+   db->db_fd = db_fd;
+   db->idx_fd = idx_fd;
+   db_fd = idx_fd = -1;
+
+   struct stat sb;
+   if (fstat(db->db_fd, &sb) == 0)
+      db->db_ino = sb.st_ino;
+   if (fstat(db->idx_fd, &sb) == 0)
+      db->idx_ino = sb.st_ino;
+   db->validated = true;
+
+   load_index(db);
+   ret = true;
+
+ done:
+   if (db_fd != -1) {
+      unlink(db_tmp);
+      close(db_fd);
+   }
+   if (idx_fd != -1) {
+      unlink(idx_tmp);
+      close(idx_fd);
+   }
+   free(buf);
+   free(live);
+   ralloc_free(db_tmp);
+
+   return ret;
+}
+
+/* Check the headers of freshly opened files, recreating them if they are
+ * empty or were left behind by an incompatible version.
+ *
+ * Must be called with the database locked.
+ */
+static bool
+validate_files(struct disk_cache_db *db)
+{
+   struct stat sb;
+
+   if (fstat(db->db_fd, &sb) == -1)
+      return false;
+
+   if (sb.st_size == 0) {
+      if (!write_header(db->db_fd, db_magic) ||
+          !write_header(db->idx_fd, idx_magic))
+         return false;
+   } else if (!header_is_valid(db->db_fd, db_magic) ||
+              !header_is_valid(db->idx_fd, idx_magic)) {
+      reset_entries(db);
+      if (!rewrite_files(db, 0))
+         return false;
+   }
+
+   db->validated = true;
+   return true;
+}
+
+/* Take the cross-process writer lock on the current data file. */
+static bool
+lock_files(struct disk_cache_db *db)
+{
+   for (unsigned tries = 0; tries < 8; tries++) {
+      if (db->db_fd == -1 && !open_files(db))
+         return false;
+
+      if (flock(db->db_fd, LOCK_EX) == -1)
+         return false;
+
+      if (!files_are_current(db)) {
+         flock(db->db_fd, LOCK_UN);
+         if (!open_files(db))
+            return false;
+         continue;
+      }
+
+      if (!db->validated && !validate_files(db)) {
+         flock(db->db_fd, LOCK_UN);
+         return false;
+      }
+
+      return true;
+   }
+
+   return false;
+}
+
+static void
+unlock_files(struct disk_cache_db *db)
+{
+   flock(db->db_fd, LOCK_UN);
+}
+
+/* Make sure the mapping covers [0, end) of the data file. */
+static bool
+map_covers(struct disk_cache_db *db, uint64_t end)
+{
+   struct disk_cache_db_map *map;
+   struct stat sb;
+
+   if (db->map && end <= db->map->size)
+      return true;
+
+   if (fstat(db->db_fd, &sb) == -1 || sb.st_size < end)
+      return false;
+
+   map = malloc(sizeof(*map));
+   if (!map)
+      return false;
+
+   map->ptr = mmap(NULL, sb.st_size, PROT_READ, MAP_SHARED, db->db_fd, 0);
+   if (map->ptr == MAP_FAILED) {
+      free(map);
+      return false;
+   }
+   map->size = sb.st_size;
+   map->refcount = 1;
+
+   /* Borrowed records keep the old mapping alive. */
+   disk_cache_db_map_release(db->map);
+   db->map = map;
+
+   return true;
+}
+
+struct disk_cache_db *
+disk_cache_db_open(void *mem_ctx, const char *path, uint64_t max_size)
+{
+   struct disk_cache_db *db = rzalloc(mem_ctx, struct disk_cache_db);
+   if (!db)
+      return NULL;
+
+   mtx_init(&db->mutex, mtx_plain);
+   db->db_fd = -1;
+   db->idx_fd = -1;
+   db->max_size = max_size;
+
+   db->db_path = ralloc_asprintf(db, "%s/%s", path, DB_FILE_NAME);
+   db->idx_path = ralloc_asprintf(db, "%s/%s", path, IDX_FILE_NAME);
+   if (!db->db_path || !db->idx_path)
+      goto fail;
+
+   if (!open_files(db))
+      goto fail;
+
+   /* Make sure the headers are in place before anyone reads. */
+   if (!lock_files(db))
+      goto fail;
+
+   load_index(db);
+   unlock_files(db);
+
+   return db;
+
+ fail:
+   close_files(db);
+   mtx_destroy(&db->mutex);
+   ralloc_free(db);
+   return NULL;
+}
+
+void
+disk_cache_db_close(struct disk_cache_db *db)
+{
+   if (!db)
+      return;
+
+   close_files(db);
+   mtx_destroy(&db->mutex);
+   ralloc_free(db);
+}
+
+bool
+disk_cache_db_put(struct disk_cache_db *db, const cache_key key,
+                  const void *data, size_t size)
+{
+   struct db_record_header header;
+   struct db_index_entry idx;
+   struct stat sb;
+   bool ret = false;
+
+   uint64_t record_size = sizeof(header) + size;
+   if (size == 0 || size > UINT32_MAX ||
+       sizeof(struct db_file_header) + record_size > db->max_size)
+      return false;
+
+   mtx_lock(&db->mutex);
+
+   if (!lock_files(db))
+      goto out;
+
+   load_index(db);
+
+   if (_mesa_hash_table_search(db->entries, key)) {
+      ret = true;
+      goto unlock;
+   }
+
+   if (fstat(db->db_fd, &sb) == -1)
+      goto unlock;
+
+   /* Once full, keep the newest half of the records.  This gives FIFO
+    * eviction, and leaves enough room that we don't compact on every put.
+    */
+   if (sb.st_size + record_size > db->max_size) {
+      uint64_t budget = db->max_size / 2;
+      budget = budget > record_size ? budget - record_size : 0;
+      if (!rewrite_files(db, budget))
+         goto unlock;
+      if (fstat(db->db_fd, &sb) == -1)
+         goto unlock;
+   }
+
+   memcpy(header.key, key, CACHE_KEY_SIZE);
+   header.size = size;
+
+   /* Data goes first so that the index never points at missing bytes. */
+   if (!pwrite_all(db->db_fd, &header, sizeof(header), sb.st_size) ||
+       !pwrite_all(db->db_fd, data, size, sb.st_size + sizeof(header)))
+      goto unlock;
+
+   memcpy(idx.key, key, CACHE_KEY_SIZE);
+   idx.size = size;
+   idx.offset = sb.st_size;
+   if (!append_index_entry(db, &idx))
+      goto unlock;
+
+   load_index(db);
+   ret = true;
+
+ unlock:
+   unlock_files(db);
+ out:
+   mtx_unlock(&db->mutex);
+
+   return ret;
+}
+
+/* Find the payload of the record for \key in the current mapping.  Must be
+ * called with the mutex held.
+ */
+static const uint8_t *
+lookup_record(struct disk_cache_db *db, const cache_key key, size_t *size)
+{
+   struct hash_entry *he;
+
+   he = _mesa_hash_table_search(db->entries, key);
+   if (!he) {
+      /* Someone may have added it since we last looked. */
+      if (!files_are_current(db) && !open_files(db))
+         return NULL;
+
+      load_index(db);
+      he = _mesa_hash_table_search(db->entries, key);
+      if (!he)
+         return NULL;
+   }
+
+   struct db_entry *entry = he->data;
+   uint64_t end = entry->offset + sizeof(struct db_record_header) +
+                  entry->size;
+   if (!map_covers(db, end))
+      return NULL;
+
+   struct db_record_header header;
+   memcpy(&header, db->map->ptr + entry->offset, sizeof(header));
+   if (memcmp(header.key, key, CACHE_KEY_SIZE) != 0 ||
+       header.size != entry->size)
+      return NULL;
+
+   *size = entry->size;
+   return db->map->ptr + entry->offset + sizeof(header);
+}
+
+void *
+disk_cache_db_get(struct disk_cache_db *db, const cache_key key,
+                  size_t *size)
+{
+   const uint8_t *record;
+   size_t record_size;
+   void *data = NULL;
+
+   mtx_lock(&db->mutex);
+
+   record = lookup_record(db, key, &record_size);
+   if (record) {
+      data = malloc(record_size);
+      if (data) {
+         memcpy(data, record, record_size);
+         if (size)
+            *size = record_size;
+      }
+   }
+
+   mtx_unlock(&db->mutex);
+
+   return data;
+}
+
+const void *
+disk_cache_db_get_mapped(struct disk_cache_db *db, const cache_key key,
+                         size_t *size, struct disk_cache_db_map **map)
+{
+   const uint8_t *record;
+   size_t record_size;
+
+   mtx_lock(&db->mutex);
+
+   record = lookup_record(db, key, &record_size);
+   if (record) {
+      p_atomic_inc(&db->map->refcount);
+      *map = db->map;
+      if (size)
+         *size = record_size;
+   }
+
+   mtx_unlock(&db->mutex);
+
+   return record;
+}
+
+void
+disk_cache_db_remove(struct disk_cache_db *db, const cache_key key)
+{
+   struct db_index_entry idx;
+
+   mtx_lock(&db->mutex);
+
+   if (!lock_files(db))
+      goto out;
+
+   load_index(db);
+
+   if (_mesa_hash_table_search(db->entries, key)) {
+      memcpy(idx.key, key, CACHE_KEY_SIZE);
+      idx.size = 0;
+      idx.offset = 0;
+      if (append_index_entry(db, &idx))
+         load_index(db);
+   }
+
+   unlock_files(db);
+ out:
+   mtx_unlock(&db->mutex);
+}
+
+#endif /* ENABLE_SHADER_CACHE */
@@ -0,0 +1,105 @@
+/*
+ * Copyright © 2018 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef DISK_CACHE_DB_H
+#define DISK_CACHE_DB_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "util/disk_cache.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Single-file storage backend for the shader cache.
+ *
+ * Instead of one file per entry, all entries are appended to a single data
+ * file which is read through a memory mapping, with a separate append-only
+ * index file mapping each cache_key to its record. Both files live in the
+ * regular cache directory and may be shared between processes; writers
+ * serialize through an flock on the data file.
+ *
+ * The backend stores opaque, already-serialized cache entries.  Compression,
+ * checksums and the driver keys header are handled by disk_cache.c exactly
+ * as for the per-file layout.
+ */
+struct disk_cache_db;
+struct disk_cache_db_map;
+
+/**
+ * Open (creating if needed) the database files inside \path.
+ *
+ * \max_size bounds the size of the data file.  Once a new record would push
+ * the file past it, the oldest records are dropped by compacting the files.
+ *
+ * \return NULL on any error.
+ */
+struct disk_cache_db *
+disk_cache_db_open(void *mem_ctx, const char *path, uint64_t max_size);
+
+void
+disk_cache_db_close(struct disk_cache_db *db);
+
+/**
+ * Append the \size bytes of \data as the record for \key.
+ *
+ * Nothing is written if a record for \key already exists.
+ */
+bool
+disk_cache_db_put(struct disk_cache_db *db, const cache_key key,
+                  const void *data, size_t size);
+
+/**
+ * Return a malloc'ed copy of the record stored for \key, or NULL.
+ */
+void *
+disk_cache_db_get(struct disk_cache_db *db, const cache_key key,
+                  size_t *size);
+
+/**
+ * Return a pointer to the record stored for \key inside the mapping of the
+ * data file, or NULL.  Nothing is copied; the pointer stays valid until the
+ * reference returned in \map is dropped with disk_cache_db_map_release(),
+ * even if the database is compacted or closed in the meantime.
+ */
+const void *
+disk_cache_db_get_mapped(struct disk_cache_db *db, const cache_key key,
+                         size_t *size, struct disk_cache_db_map **map);
+
+void
+disk_cache_db_map_release(struct disk_cache_db_map *map);
+
+/**
+ * Drop the record for \key.  The space is reclaimed on the next compaction.
+ */
+void
+disk_cache_db_remove(struct disk_cache_db *db, const cache_key key);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DISK_CACHE_DB_H */
@@ -157,6 +157,15 @@ do {                       \
 #define PACKED
 #endif
 
+/* Used to make an enum only as large as its values need, typically to
+ * squeeze it into a byte of a frequently allocated structure.
+ */
+#ifdef HAVE_FUNC_ATTRIBUTE_PACKED
+#define ENUM_PACKED __attribute__((__packed__))
+#else
+#define ENUM_PACKED
+#endif
+
 /* Attribute pure is used for functions that have no effects other than their
  * return value.  As a result, calls to it can be dead code eliminated.
  */
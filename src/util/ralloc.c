@@ -66,6 +66,11 @@ struct
    unsigned canary;
 #endif
 
+   /* Set if the block was handed out by an arena.  Its memory then belongs
+    * to the arena and is only released with it.
+    */
+   bool in_arena;
+
    struct ralloc_header *parent;
 
    /* The first child (head of a linked list) */
@@ -130,6 +135,7 @@ ralloc_size(const void *ctx, size_t size)
     * the multiplication overflow checking?), so clear things
     * manually
     */
+   info->in_arena = false;
    info->parent = NULL;
    info->child = NULL;
    info->prev = NULL;
@@ -165,6 +171,7 @@ resize(void *ptr, size_t size)
    ralloc_header *child, *old, *info;
 
    old = get_header(ptr);
+   assert(!old->in_arena);
    info = realloc(old, size + sizeof(ralloc_header));
 
    if (info == NULL)
@@ -273,7 +280,8 @@ unsafe_free(ralloc_header *info)
    if (info->destructor != NULL)
       info->destructor(PTR_FROM_HEADER(info));
 
-   free(info);
+   if (!info->in_arena)
+      free(info);
 }
 
 void
@@ -893,3 +901,81 @@ linear_strcat(void *parent, char **dest, const char *str)
 {
    return linear_cat(parent, dest, str, strlen(str));
 }
+
+/*
+ * Arena allocation
+ *
+ * Arena blocks carry a regular ralloc header, placed inside a linear buffer
+ * instead of getting their own malloc.
+ */
+
+#define HEADER_ALIGNMENT offsetof(struct { char c; ralloc_header h; }, h)
+
+void *
+ralloc_arena_create(void)
+{
+   void *root = ralloc_context(NULL);
+   void *arena;
+
+   if (unlikely(!root))
+      return NULL;
+
+   arena = linear_alloc_parent(root, 0);
+   if (unlikely(!arena)) {
+      ralloc_free(root);
+      return NULL;
+   }
+   return arena;
+}
+
+void
+ralloc_arena_destroy(void *arena)
+{
+   if (unlikely(!arena))
+      return;
+
+   ralloc_free(ralloc_parent_of_linear_parent(arena));
+}
+
+void *
+ralloc_arena_size(void *arena, const void *ctx, size_t size)
+{
+   const uintptr_t align = HEADER_ALIGNMENT;
+   const size_t padding =
+      align > SUBALLOC_ALIGNMENT ? align - SUBALLOC_ALIGNMENT : 0;
+   ralloc_header *info;
+   void *block;
+
+   assert(size <= UINT32_MAX - sizeof(ralloc_header) - padding);
+
+   block = linear_alloc_child(arena, sizeof(ralloc_header) + size + padding);
+   if (unlikely(block == NULL))
+      return NULL;
+
+   info = (ralloc_header *) (((uintptr_t) block + align - 1) & ~(align - 1));
+   info->in_arena = true;
+   info->parent = NULL;
+   info->child = NULL;
+   info->prev = NULL;
+   info->next = NULL;
+   info->destructor = NULL;
+
+   add_child(ctx != NULL ? get_header(ctx) : NULL, info);
+
+#ifdef DEBUG
+   info->canary = CANARY;
+#endif
+
+   return PTR_FROM_HEADER(info);
+}
+
+void *
+rzalloc_arena_size(void *arena, const void *ctx, size_t size)
+{
+   void *ptr = ralloc_arena_size(arena, ctx, size);
+
+   if (likely(ptr))
+      memset(ptr, 0, size);
+
+   return ptr;
+}
@@ -535,6 +535,44 @@ bool linear_vasprintf_rewrite_tail(void *parent, char **str, size_t *start,
                                    const char *fmt, va_list args);
 bool linear_strcat(void *parent, char **dest, const char *str);
 
+/**
+ * \name Arena allocation
+ *
+ * An arena hands out ordinary ralloc blocks whose memory is carved out of
+ * large linear buffers.  They can be used as a context, stolen and freed
+ * like any other ralloc block, which runs their destructor and frees their
+ * children, but their own memory is only returned when the whole arena is
+ * destroyed.  This saves a malloc/free pair per block for large numbers of
+ * small, mostly long-lived objects.
+ *
+ * The arena must outlive every block allocated from it.
+ * @{
+ */
+
+/**
+ * Create an arena.  It isn't part of any ralloc context and has to be
+ * destroyed with ralloc_arena_destroy.
+ */
+void *ralloc_arena_create(void);
+
+/**
+ * Destroy the arena and release the memory of all blocks allocated from it.
+ */
+void ralloc_arena_destroy(void *arena);
+
+/**
+ * Same as ralloc_size, but allocate the block from \p arena.
+ *
+ * The block can't be resized with reralloc.
+ */
+void *ralloc_arena_size(void *arena, const void *ctx, size_t size);
+
+/**
+ * Same as ralloc_arena_size, but also clears memory.
+ */
+void *rzalloc_arena_size(void *arena, const void *ctx, size_t size);
+/** @} */
+
 #ifdef __cplusplus
 } /* end of extern "C" */
 #endif
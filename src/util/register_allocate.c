@@ -477,8 +477,15 @@ pq_test(struct ra_graph *g, unsigned int n)
    return g->nodes[n].q_total < g->regs->classes[n_class]->p;
 }
 
+/**
+ * Removes node n from the graph by decrementing the q totals of its
+ * neighbors.  Any uncolored neighbor that becomes trivially colorable as a
+ * result is appended to the worklist.  Since q totals only ever decrease
+ * during simplification, each node is added to the worklist at most once.
+ */
 static void
-decrement_q(struct ra_graph *g, unsigned int n)
+decrement_q(struct ra_graph *g, unsigned int n,
+            unsigned int *worklist, unsigned int *worklist_count)
 {
    unsigned int i;
    int n_class = g->nodes[n].class;
@@ -488,17 +495,37 @@ decrement_q(struct ra_graph *g, unsigned int n)
       unsigned int n2_class = g->nodes[n2].class;
 
       if (!g->nodes[n2].in_stack) {
+         bool was_colorable = pq_test(g, n2);
+
          assert(g->nodes[n2].q_total >= g->regs->classes[n2_class]->q[n_class]);
          g->nodes[n2].q_total -= g->regs->classes[n2_class]->q[n_class];
+
+         if (!was_colorable && g->nodes[n2].reg == NO_REG && pq_test(g, n2))
+            worklist[(*worklist_count)++] = n2;
       }
    }
 }
 
+static void
+ra_push_node(struct ra_graph *g, unsigned int n,
+             unsigned int *worklist, unsigned int *worklist_count)
+{
+   decrement_q(g, n, worklist, worklist_count);
+   g->stack[g->stack_count] = n;
+   g->stack_count++;
+   g->nodes[n].in_stack = true;
+}
+
 /**
  * Simplifies the interference graph by pushing all
  * trivially-colorable nodes into a stack of nodes to be colored,
  * removing them from the graph, and rinsing and repeating.
  *
+ * Rather than rescanning every node after each round, the nodes that are
+ * trivially colorable are kept in a worklist which decrement_q() refills
+ * as neighbors get removed from the graph, so that a full scan is only
+ * needed when the worklist runs dry.
+ *
  * If we encounter a case where we can't push any nodes on the stack, then
  * we optimistically choose a node and push it on the stack. We heuristically
  * push the node with the lowest total q value, since it has the fewest
@@ -507,47 +534,54 @@ decrement_q(struct ra_graph *g, unsigned int n)
 static void
 ra_simplify(struct ra_graph *g)
 {
-   bool progress = true;
    unsigned int stack_optimistic_start = UINT_MAX;
+   unsigned int *worklist;
+   unsigned int worklist_start = 0, worklist_count = 0;
+   unsigned int remaining = 0;
    int i;
 
-   while (progress) {
+   worklist = malloc(MAX2(g->count, 1) * sizeof(*worklist));
+
+   for (i = g->count - 1; i >= 0; i--) {
+      if (g->nodes[i].in_stack || g->nodes[i].reg != NO_REG)
+         continue;
+
+      remaining++;
+      if (pq_test(g, i))
+         worklist[worklist_count++] = i;
+   }
+
+   while (remaining) {
+      if (worklist_start < worklist_count) {
+         ra_push_node(g, worklist[worklist_start++], worklist,
+                      &worklist_count);
+         remaining--;
+         continue;
+      }
+
       unsigned int best_optimistic_node = ~0;
       unsigned int lowest_q_total = ~0;
 
-      progress = false;
-
       for (i = g->count - 1; i >= 0; i--) {
-	 if (g->nodes[i].in_stack || g->nodes[i].reg != NO_REG)
-	    continue;
-
-	 if (pq_test(g, i)) {
-	    decrement_q(g, i);
-	    g->stack[g->stack_count] = i;
-	    g->stack_count++;
-	    g->nodes[i].in_stack = true;
-	    progress = true;
-	 } else {
-	    unsigned int new_q_total = g->nodes[i].q_total;
-	    if (new_q_total < lowest_q_total) {
-	       best_optimistic_node = i;
-	       lowest_q_total = new_q_total;
-	    }
-	 }
+         if (g->nodes[i].in_stack || g->nodes[i].reg != NO_REG)
+            continue;
+
+         if (g->nodes[i].q_total < lowest_q_total) {
+            best_optimistic_node = i;
+            lowest_q_total = g->nodes[i].q_total;
+         }
       }
+      assert(best_optimistic_node != ~0U);
 
-      if (!progress && best_optimistic_node != ~0U) {
-         if (stack_optimistic_start == UINT_MAX)
-            stack_optimistic_start = g->stack_count;
+      if (stack_optimistic_start == UINT_MAX)
+         stack_optimistic_start = g->stack_count;
 
-	 decrement_q(g, best_optimistic_node);
-	 g->stack[g->stack_count] = best_optimistic_node;
-	 g->stack_count++;
-	 g->nodes[best_optimistic_node].in_stack = true;
-	 progress = true;
-      }
+      ra_push_node(g, best_optimistic_node, worklist, &worklist_count);
+      remaining--;
    }
 
+   free(worklist);
+
    g->stack_optimistic_start = stack_optimistic_start;
 }
 
@@ -101,6 +101,22 @@ SHA1Transform(uint32_t state[5], const uint8_t buffer[SHA1_BLOCK_LENGTH])
 }
 
 
+static void SHA1TransformBlocksInit(uint32_t [5], const uint8_t *, size_t);
+
+/*
+ * Resolved on first use.  Racing threads all store the same pointer.
+ */
+static SHA1TransformBlocksFunc SHA1TransformBlocks = SHA1TransformBlocksInit;
+
+static void
+SHA1TransformBlocksInit(uint32_t state[5], const uint8_t *data,
+    size_t num_blocks)
+{
+	SHA1TransformBlocks = SHA1SelectTransformBlocks();
+	SHA1TransformBlocks(state, data, num_blocks);
+}
+
+
 /*
  * SHA1Init - Initialize new context
  */
@@ -130,9 +146,12 @@ SHA1Update(SHA1_CTX *context, const uint8_t *data, size_t len)
 	context->count += (len << 3);
 	if ((j + len) > 63) {
 		(void)memcpy(&context->buffer[j], data, (i = 64-j));
-		SHA1Transform(context->state, context->buffer);
-		for ( ; i + 63 < len; i += 64)
-			SHA1Transform(context->state, (uint8_t *)&data[i]);
+		SHA1TransformBlocks(context->state, context->buffer, 1);
+		if (len - i >= 64) {
+			SHA1TransformBlocks(context->state, &data[i],
+			    (len - i) / 64);
+			i += (len - i) & ~(size_t)63;
+		}
 		j = 0;
 	} else {
 		i = 0;
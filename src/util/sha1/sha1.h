@@ -32,6 +32,12 @@ void SHA1Transform(uint32_t [5], const uint8_t [SHA1_BLOCK_LENGTH]);
 void SHA1Update(SHA1_CTX *, const uint8_t *, size_t);
 void SHA1Final(uint8_t [SHA1_DIGEST_LENGTH], SHA1_CTX *);
 
+/* Hashes num_blocks consecutive 512-bit blocks, possibly using the CPU's
+ * SHA instructions (sha1_accel.c).
+ */
+typedef void (*SHA1TransformBlocksFunc)(uint32_t [5], const uint8_t *, size_t);
+SHA1TransformBlocksFunc SHA1SelectTransformBlocks(void);
+
 #define HTONDIGEST(x) do {                                              \
         x[0] = htonl(x[0]);                                             \
         x[1] = htonl(x[1]);                                             \
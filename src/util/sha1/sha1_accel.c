@@ -0,0 +1,230 @@
+/* Copyright © 2018 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * SHA-1 block functions using the SHA extensions of x86 (SHA-NI) and the
+ * ARMv8 cryptography extension.  They are compiled with the needed target
+ * attributes regardless of the compiler flags and only picked at runtime
+ * when the CPU supports them, see SHA1SelectTransformBlocks().
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "sha1.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && \
+    (__GNUC__ >= 5 || defined(__clang__))
+#define SHA1_HAVE_X86_SHA 1
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+#if defined(__GNUC__) && defined(__aarch64__) && defined(__linux__) && \
+    (__GNUC__ >= 6 || defined(__clang__))
+#define SHA1_HAVE_ARM_SHA 1
+#include <sys/auxv.h>
+#ifndef __clang__
+#pragma GCC push_options
+#pragma GCC target("+crypto")
+#endif
+#include <arm_neon.h>
+#ifndef __clang__
+#pragma GCC pop_options
+#endif
+
+#ifndef HWCAP_SHA1
+#define HWCAP_SHA1 (1 << 5)
+#endif
+#endif
+
+static void
+sha1_transform_blocks_c(uint32_t state[5], const uint8_t *data,
+                        size_t num_blocks)
+{
+   for (size_t i = 0; i < num_blocks; i++)
+      SHA1Transform(state, data + i * SHA1_BLOCK_LENGTH);
+}
+
+#ifdef SHA1_HAVE_X86_SHA
+
+/* Four rounds starting at round 4 * i.  The message schedule for group k
+ * (the words 4k..4k+3, kept in msg[k % 4]) is started with sha1msg1 three
+ * groups ahead, continued with a xor two groups ahead and finished with
+ * sha1msg2 one group ahead.
+ */
+#define X86_ROUNDS4(i) do {                                                  \
+   if ((i) == 0)                                                             \
+      e[0] = _mm_add_epi32(e[0], msg[0]);                                    \
+   else                                                                      \
+      e[(i) & 1] = _mm_sha1nexte_epu32(e[(i) & 1], msg[(i) & 3]);           \
+   e[((i) + 1) & 1] = abcd;                                                  \
+   if ((i) >= 3 && (i) <= 18)                                                \
+      msg[((i) + 1) & 3] = _mm_sha1msg2_epu32(msg[((i) + 1) & 3],            \
+                                              msg[(i) & 3]);                 \
+   abcd = _mm_sha1rnds4_epu32(abcd, e[(i) & 1], (i) / 5);                    \
+   if ((i) >= 1 && (i) <= 16)                                                \
+      msg[((i) + 3) & 3] = _mm_sha1msg1_epu32(msg[((i) + 3) & 3],            \
+                                              msg[(i) & 3]);                 \
+   if ((i) >= 2 && (i) <= 17)                                                \
+      msg[((i) + 2) & 3] = _mm_xor_si128(msg[((i) + 2) & 3], msg[(i) & 3]);  \
+} while (0)
+
+__attribute__((target("sha,sse4.1")))
+static void
+sha1_transform_blocks_x86(uint32_t state[5], const uint8_t *data,
+                          size_t num_blocks)
+{
+   const __m128i bswap = _mm_set_epi64x(0x0001020304050607ull,
+                                        0x08090a0b0c0d0e0full);
+   __m128i abcd, e[2], msg[4];
+
+   abcd = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *) state), 0x1b);
+   e[0] = _mm_set_epi32(state[4], 0, 0, 0);
+
+   for (size_t b = 0; b < num_blocks; b++, data += SHA1_BLOCK_LENGTH) {
+      const __m128i abcd_save = abcd;
+      const __m128i e_save = e[0];
+
+      for (unsigned i = 0; i < 4; i++) {
+         msg[i] = _mm_loadu_si128((const __m128i *) (data + i * 16));
+         msg[i] = _mm_shuffle_epi8(msg[i], bswap);
+      }
+
+      X86_ROUNDS4(0);  X86_ROUNDS4(1);  X86_ROUNDS4(2);  X86_ROUNDS4(3);
+      X86_ROUNDS4(4);  X86_ROUNDS4(5);  X86_ROUNDS4(6);  X86_ROUNDS4(7);
+      X86_ROUNDS4(8);  X86_ROUNDS4(9);  X86_ROUNDS4(10); X86_ROUNDS4(11);
+      X86_ROUNDS4(12); X86_ROUNDS4(13); X86_ROUNDS4(14); X86_ROUNDS4(15);
+      X86_ROUNDS4(16); X86_ROUNDS4(17); X86_ROUNDS4(18); X86_ROUNDS4(19);
+
+      e[0] = _mm_sha1nexte_epu32(e[0], e_save);
+      abcd = _mm_add_epi32(abcd, abcd_save);
+   }
+
+   _mm_storeu_si128((__m128i *) state, _mm_shuffle_epi32(abcd, 0x1b));
+   state[4] = _mm_extract_epi32(e[0], 3);
+}
+
+static bool
+has_x86_sha(void)
+{
+   unsigned eax, ebx, ecx, edx;
+
+   if (__get_cpuid_max(0, NULL) < 7)
+      return false;
+
+   __cpuid(1, eax, ebx, ecx, edx);
+   if (!(ecx & bit_SSE4_1))
+      return false;
+
+   __cpuid_count(7, 0, eax, ebx, ecx, edx);
+   return ebx & (1 << 29);
+}
+
+#endif /* SHA1_HAVE_X86_SHA */
+
+#ifdef SHA1_HAVE_ARM_SHA
+
+/* Four rounds starting at round 4 * i, see X86_ROUNDS4.  The words of group
+ * i + 2 are started with sha1su0 in the round before they are finished with
+ * sha1su1 and get their round constant added.
+ */
+#define ARM_ROUNDS4(i, op) do {                                              \
+   e[((i) + 1) & 1] = vsha1h_u32(vgetq_lane_u32(abcd, 0));                   \
+   abcd = op(abcd, e[(i) & 1], tmp[(i) & 1]);                                \
+   if ((i) + 2 >= 4 && (i) + 2 <= 19)                                        \
+      msg[((i) + 2) & 3] = vsha1su1q_u32(msg[((i) + 2) & 3],                 \
+                                         msg[((i) + 1) & 3]);                \
+   if ((i) + 2 <= 19)                                                        \
+      tmp[(i) & 1] = vaddq_u32(msg[((i) + 2) & 3],                           \
+                               vdupq_n_u32(k[((i) + 2) / 5]));               \
+   if ((i) + 3 >= 4 && (i) + 3 <= 19)                                        \
+      msg[((i) + 3) & 3] = vsha1su0q_u32(msg[((i) + 3) & 3],                 \
+                                         msg[(i) & 3],                       \
+                                         msg[((i) + 1) & 3]);                \
+} while (0)
+
+__attribute__((target("+crypto")))
+static void
+sha1_transform_blocks_arm(uint32_t state[5], const uint8_t *data,
+                          size_t num_blocks)
+{
+   static const uint32_t k[4] = {
+      0x5a827999, 0x6ed9eba1, 0x8f1bbcdc, 0xca62c1d6
+   };
+   uint32x4_t abcd, msg[4], tmp[2];
+   uint32_t e[2];
+
+   abcd = vld1q_u32(state);
+   e[0] = state[4];
+
+   for (size_t b = 0; b < num_blocks; b++, data += SHA1_BLOCK_LENGTH) {
+      const uint32x4_t abcd_save = abcd;
+      const uint32_t e_save = e[0];
+
+      for (unsigned i = 0; i < 4; i++) {
+         msg[i] = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(data + i * 16)));
+      }
+
+      tmp[0] = vaddq_u32(msg[0], vdupq_n_u32(k[0]));
+      tmp[1] = vaddq_u32(msg[1], vdupq_n_u32(k[0]));
+
+      ARM_ROUNDS4(0, vsha1cq_u32);  ARM_ROUNDS4(1, vsha1cq_u32);
+      ARM_ROUNDS4(2, vsha1cq_u32);  ARM_ROUNDS4(3, vsha1cq_u32);
+      ARM_ROUNDS4(4, vsha1cq_u32);  ARM_ROUNDS4(5, vsha1pq_u32);
+      ARM_ROUNDS4(6, vsha1pq_u32);  ARM_ROUNDS4(7, vsha1pq_u32);
+      ARM_ROUNDS4(8, vsha1pq_u32);  ARM_ROUNDS4(9, vsha1pq_u32);
+      ARM_ROUNDS4(10, vsha1mq_u32); ARM_ROUNDS4(11, vsha1mq_u32);
+      ARM_ROUNDS4(12, vsha1mq_u32); ARM_ROUNDS4(13, vsha1mq_u32);
+      ARM_ROUNDS4(14, vsha1mq_u32); ARM_ROUNDS4(15, vsha1pq_u32);
+      ARM_ROUNDS4(16, vsha1pq_u32); ARM_ROUNDS4(17, vsha1pq_u32);
+      ARM_ROUNDS4(18, vsha1pq_u32); ARM_ROUNDS4(19, vsha1pq_u32);
+
+      e[0] += e_save;
+      abcd = vaddq_u32(abcd, abcd_save);
+   }
+
+   vst1q_u32(state, abcd);
+   state[4] = e[0];
+}
+
+static bool
+has_arm_sha(void)
+{
+   return getauxval(AT_HWCAP) & HWCAP_SHA1;
+}
+
+#endif /* SHA1_HAVE_ARM_SHA */
+
+SHA1TransformBlocksFunc
+SHA1SelectTransformBlocks(void)
+{
+#ifdef SHA1_HAVE_X86_SHA
+   if (has_x86_sha())
+      return sha1_transform_blocks_x86;
+#endif
+#ifdef SHA1_HAVE_ARM_SHA
+   if (has_arm_sha())
+      return sha1_transform_blocks_arm;
+#endif
+   return sha1_transform_blocks_c;
+}
@@ -95,6 +95,26 @@ slab_free_orphaned(struct slab_element_header *elt)
       free(page);
 }
 
+/* Take the whole migrated list of the pool.
+ *
+ * Other threads only push onto the list, so the head can't be removed and
+ * re-added behind our back.
+ */
+static struct slab_element_header *
+slab_take_migrated(struct slab_child_pool *pool)
+{
+   struct slab_element_header *head = p_atomic_read(&pool->migrated);
+   struct slab_element_header *old;
+
+   while (head) {
+      old = p_atomic_cmpxchg(&pool->migrated, head, NULL);
+      if (old == head)
+         break;
+      head = old;
+   }
+   return head;
+}
+
 /**
  * Create a parent pool for the allocation of same-sized objects.
  *
@@ -106,16 +126,16 @@ slab_create_parent(struct slab_parent_pool *parent,
                    unsigned item_size,
                    unsigned num_items)
 {
-   mtx_init(&parent->mutex, mtx_plain);
    parent->element_size = ALIGN_POT(sizeof(struct slab_element_header) + item_size,
                                     sizeof(intptr_t));
    parent->num_elements = num_items;
+   parent->num_migrating = 0;
 }
 
 void
 slab_destroy_parent(struct slab_parent_pool *parent)
 {
-   mtx_destroy(&parent->mutex);
+   assert(!p_atomic_read(&parent->num_migrating));
 }
 
 /**
@@ -128,6 +148,7 @@ void slab_create_child(struct slab_child_pool *pool,
    pool->pages = NULL;
    pool->free = NULL;
    pool->migrated = NULL;
+   memset(&pool->stats, 0, sizeof(pool->stats));
 }
 
 /**
@@ -138,11 +159,11 @@ void slab_create_child(struct slab_child_pool *pool,
  */
 void slab_destroy_child(struct slab_child_pool *pool)
 {
+   struct slab_element_header *migrated;
+
    if (!pool->parent)
       return; /* the slab probably wasn't even created */
 
-   mtx_lock(&pool->parent->mutex);
-
    while (pool->pages) {
       struct slab_page_header *page = pool->pages;
       pool->pages = page->u.next;
@@ -154,13 +175,25 @@ void slab_destroy_child(struct slab_child_pool *pool)
       }
    }
 
-   while (pool->migrated) {
-      struct slab_element_header *elt = pool->migrated;
-      pool->migrated = elt->next;
-      slab_free_orphaned(elt);
+   /* Wait for the slab_free calls that read the old owner before it was
+    * changed above. Everybody else sees the orphaned page and leaves the
+    * migrated list alone.
+    *
+    * The compare-and-swap is a read-modify-write on purpose: it is ordered
+    * after the owner stores, so a slab_free whose increment isn't seen here
+    * is guaranteed to see the new owner.
+    */
+   if (p_atomic_cmpxchg(&pool->parent->num_migrating, 0, 0)) {
+      while (p_atomic_read(&pool->parent->num_migrating))
+         thrd_yield();
    }
 
-   mtx_unlock(&pool->parent->mutex);
+   migrated = slab_take_migrated(pool);
+   while (migrated) {
+      struct slab_element_header *elt = migrated;
+      migrated = elt->next;
+      slab_free_orphaned(elt);
+   }
 
    while (pool->free) {
       struct slab_element_header *elt = pool->free;
@@ -193,6 +226,7 @@ slab_add_new_page(struct slab_child_pool *pool)
 
    page->u.next = pool->pages;
    pool->pages = page;
+   pool->stats.pages++;
 
    return true;
 }
@@ -211,10 +245,9 @@ slab_alloc(struct slab_child_pool *pool)
       /* First, collect elements that belong to us but were freed from a
        * different child pool.
        */
-      mtx_lock(&pool->parent->mutex);
-      pool->free = pool->migrated;
-      pool->migrated = NULL;
-      mtx_unlock(&pool->parent->mutex);
+      pool->free = slab_take_migrated(pool);
+      if (pool->free)
+         pool->stats.migrated_collects++;
 
       /* Now allocate a new page. */
       if (!pool->free && !slab_add_new_page(pool))
@@ -242,6 +275,7 @@ slab_alloc(struct slab_child_pool *pool)
 void slab_free(struct slab_child_pool *pool, void *ptr)
 {
    struct slab_element_header *elt = ((struct slab_element_header*)ptr - 1);
+   struct slab_parent_pool *parent = pool->parent;
    intptr_t owner_int;
 
    CHECK_MAGIC(elt, SLAB_MAGIC_ALLOCATED);
@@ -257,20 +291,31 @@ void slab_free(struct slab_child_pool *pool, void *ptr)
    }
 
    /* The slow case: migration or an orphaned page. */
-   mtx_lock(&pool->parent->mutex);
+   pool->stats.remote_frees++;
+   p_atomic_inc(&parent->num_migrating);
 
    /* Note: we _must_ re-read elt->owner here because the owning child pool
-    * may have been destroyed by another thread in the meantime.
+    * may have been destroyed by another thread in the meantime. While
+    * num_migrating is raised, an owner that is still set can't go away.
     */
    owner_int = p_atomic_read(&elt->owner);
 
    if (!(owner_int & 1)) {
       struct slab_child_pool *owner = (struct slab_child_pool *)owner_int;
-      elt->next = owner->migrated;
-      owner->migrated = elt;
-      mtx_unlock(&pool->parent->mutex);
+      struct slab_element_header *head = p_atomic_read(&owner->migrated);
+      struct slab_element_header *old;
+
+      for (;;) {
+         elt->next = head;
+         old = p_atomic_cmpxchg(&owner->migrated, head, elt);
+         if (old == head)
+            break;
+         head = old;
+         pool->stats.remote_free_retries++;
+      }
+      p_atomic_dec(&parent->num_migrating);
    } else {
-      mtx_unlock(&pool->parent->mutex);
+      p_atomic_dec(&parent->num_migrating);
 
       slab_free_orphaned(elt);
    }
@@ -32,8 +32,10 @@
  *
  * Allocations obtained from one child pool should usually be freed in the
  * same child pool. Freeing an allocation in a different child pool associated
- * to the same parent is allowed (and requires no locking by the caller), but
- * it is discouraged because it implies a performance penalty.
+ * to the same parent is allowed (and requires no locking by the caller). Such
+ * elements are pushed onto a lock-free list of their owner and are picked up
+ * again once the owner runs out of free elements, so this costs a couple of
+ * atomic operations but never takes a lock.
  *
  * For convenience and to ease the transition, there is also a set of wrapper
  * functions around a single parent-child pair.
@@ -44,13 +46,39 @@
 
 #include "c11/threads.h"
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 struct slab_element_header;
 struct slab_page_header;
 
 struct slab_parent_pool {
-   mtx_t mutex;
    unsigned element_size;
    unsigned num_elements;
+
+   /* Number of slab_free calls currently pushing an element onto the
+    * migrated list of another child pool. slab_destroy_child waits for this
+    * to drop to zero before it releases the migrated list.
+    */
+   unsigned num_migrating;
+};
+
+/* Contention statistics of a child pool. They are only updated on the slow
+ * paths, by the thread that uses the child pool.
+ */
+struct slab_child_stats {
+   /* Frees of elements that are owned by a different child pool. */
+   unsigned remote_frees;
+
+   /* Failed compare-and-swaps while pushing onto a migrated list. */
+   unsigned remote_free_retries;
+
+   /* Times slab_alloc found migrated elements to take back. */
+   unsigned migrated_collects;
+
+   /* Number of pages allocated. */
+   unsigned pages;
 };
 
 struct slab_child_pool {
@@ -64,9 +92,12 @@ struct slab_child_pool {
    /* Elements that are owned by this pool but were freed with a different
     * pool as the argument to slab_free.
     *
-    * This list is protected by the parent mutex.
+    * Other threads only ever push onto this list with a compare-and-swap;
+    * the owner takes the whole list at once with an atomic exchange.
     */
    struct slab_element_header *migrated;
+
+   struct slab_child_stats stats;
 };
 
 void slab_create_parent(struct slab_parent_pool *parent,
@@ -91,4 +122,8 @@ void slab_destroy(struct slab_mempool *pool);
 void *slab_alloc_st(struct slab_mempool *pool);
 void slab_free_st(struct slab_mempool *pool, void *ptr);
 
+#ifdef __cplusplus
+}
+#endif
+
 #endif
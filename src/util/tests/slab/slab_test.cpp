@@ -0,0 +1,188 @@
+/*
+ * Copyright © 2018 Advanced Micro Devices, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+#include "c11/threads.h"
+#include "util/slab.h"
+#include "util/u_atomic.h"
+
+#define NUM_ELEMENTS 32
+#define NUM_BATCHES 256
+#define BATCH_SIZE 64
+
+struct transfer {
+   unsigned id;
+   char data[60];
+};
+
+TEST(slab, single_pool)
+{
+   struct slab_mempool pool;
+   struct transfer *elts[3 * NUM_ELEMENTS];
+
+   slab_create(&pool, sizeof(struct transfer), NUM_ELEMENTS);
+
+   for (unsigned i = 0; i < 3 * NUM_ELEMENTS; i++) {
+      elts[i] = (struct transfer *)slab_alloc_st(&pool);
+      ASSERT_TRUE(elts[i]);
+      elts[i]->id = i;
+   }
+   EXPECT_EQ(pool.child.stats.pages, 3u);
+
+   for (unsigned i = 0; i < 3 * NUM_ELEMENTS; i++) {
+      EXPECT_EQ(elts[i]->id, i);
+      slab_free_st(&pool, elts[i]);
+   }
+
+   /* Everything was freed locally, so this must reuse the pages. */
+   for (unsigned i = 0; i < 3 * NUM_ELEMENTS; i++)
+      elts[i] = (struct transfer *)slab_alloc_st(&pool);
+   for (unsigned i = 0; i < 3 * NUM_ELEMENTS; i++)
+      slab_free_st(&pool, elts[i]);
+
+   EXPECT_EQ(pool.child.stats.pages, 3u);
+   EXPECT_EQ(pool.child.stats.remote_frees, 0u);
+   EXPECT_EQ(pool.child.stats.migrated_collects, 0u);
+
+   slab_destroy(&pool);
+}
+
+/* A producer allocating in one child pool and a consumer freeing in another,
+ * the way a threaded context hands transfers to the driver thread.
+ */
+struct handoff {
+   struct slab_parent_pool parent;
+   struct slab_child_pool producer;
+   struct slab_child_pool consumer;
+   struct transfer *batches[NUM_BATCHES][BATCH_SIZE];
+   unsigned num_ready;
+   unsigned num_done;
+   bool keep_producer;
+};
+
+static int
+consumer_thread(void *data)
+{
+   struct handoff *h = (struct handoff *)data;
+
+   slab_create_child(&h->consumer, &h->parent);
+
+   for (unsigned b = 0; b < NUM_BATCHES; b++) {
+      while (p_atomic_read(&h->num_ready) <= b)
+         thrd_yield();
+
+      for (unsigned i = 0; i < BATCH_SIZE; i++) {
+         struct transfer *t = h->batches[b][i];
+
+         if (t->id != b * BATCH_SIZE + i)
+            return 1;
+         slab_free(&h->consumer, t);
+      }
+      p_atomic_inc(&h->num_done);
+   }
+
+   slab_destroy_child(&h->consumer);
+   return 0;
+}
+
+static bool
+produce_batch(struct handoff *h, unsigned b)
+{
+   /* Keep at most two batches in flight. */
+   while (b >= p_atomic_read(&h->num_done) + 2)
+      thrd_yield();
+
+   for (unsigned i = 0; i < BATCH_SIZE; i++) {
+      struct transfer *t = (struct transfer *)slab_alloc(&h->producer);
+
+      if (!t)
+         return false;
+      t->id = b * BATCH_SIZE + i;
+      h->batches[b][i] = t;
+   }
+   p_atomic_inc(&h->num_ready);
+   return true;
+}
+
+static void
+run_handoff(struct handoff *h)
+{
+   thrd_t thread;
+   int result;
+
+   slab_create_parent(&h->parent, sizeof(struct transfer), NUM_ELEMENTS);
+   slab_create_child(&h->producer, &h->parent);
+   h->num_ready = 0;
+   h->num_done = 0;
+
+   ASSERT_EQ(thrd_create(&thread, consumer_thread, h), thrd_success);
+
+   for (unsigned b = 0; b < NUM_BATCHES; b++) {
+      ASSERT_TRUE(produce_batch(h, b));
+
+      /* Destroying the producer halfway orphans its pages while the
+       * consumer is still freeing into them.
+       */
+      if (!h->keep_producer && b == NUM_BATCHES / 2) {
+         slab_destroy_child(&h->producer);
+         slab_create_child(&h->producer, &h->parent);
+      }
+   }
+
+   ASSERT_EQ(thrd_join(thread, &result), thrd_success);
+   EXPECT_EQ(result, 0);
+
+   EXPECT_EQ(h->consumer.stats.remote_frees,
+             (unsigned)(NUM_BATCHES * BATCH_SIZE));
+}
+
+TEST(slab, cross_thread_free)
+{
+   struct handoff *h = (struct handoff *)calloc(1, sizeof(*h));
+
+   h->keep_producer = true;
+   run_handoff(h);
+
+   /* Elements freed by the consumer are recycled instead of piling up in
+    * new pages.
+    */
+   EXPECT_GT(h->producer.stats.migrated_collects, 0u);
+   EXPECT_LT(h->producer.stats.pages,
+             (unsigned)(NUM_BATCHES * BATCH_SIZE / NUM_ELEMENTS));
+
+   slab_destroy_child(&h->producer);
+   slab_destroy_parent(&h->parent);
+   free(h);
+}
+
+TEST(slab, destroy_while_freeing)
+{
+   struct handoff *h = (struct handoff *)calloc(1, sizeof(*h));
+
+   h->keep_producer = false;
+   run_handoff(h);
+
+   slab_destroy_child(&h->producer);
+   slab_destroy_parent(&h->parent);
+   free(h);
+}
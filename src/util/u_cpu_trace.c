@@ -0,0 +1,205 @@
+/*
+ * Copyright © 2018 Advanced Micro Devices, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "u_cpu_trace.h"
+
+#if defined(MESA_CPU_TRACE) && defined(__GNUC__)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "c11/threads.h"
+#include "util/macros.h"
+
+#if defined(HAVE_PTHREAD) && defined(__GLIBC__)
+#include <pthread.h>
+#endif
+
+/* Events per thread. Must be a power of two. */
+#define UTIL_CPU_TRACE_RING_SIZE (1 << 15)
+
+struct util_cpu_trace_event {
+   const char *name;
+   uint64_t begin;
+   uint64_t end;
+};
+
+struct util_cpu_trace_ring {
+   struct util_cpu_trace_ring *next;
+   unsigned tid;
+   char thread_name[32];
+   uint32_t head; /* the number of events recorded so far */
+   struct util_cpu_trace_event events[UTIL_CPU_TRACE_RING_SIZE];
+};
+
+int util_cpu_trace_state;
+
+static once_flag init_once = ONCE_FLAG_INIT;
+static mtx_t rings_lock = _MTX_INITIALIZER_NP;
+static struct util_cpu_trace_ring *rings;
+static unsigned num_rings;
+static const char *trace_file;
+
+/* A timestamp and os_time_get_nano taken at the same time, which are used
+ * to convert timestamps to nanoseconds.
+ */
+static uint64_t base_ticks;
+static int64_t base_ns;
+
+static __thread struct util_cpu_trace_ring *thread_ring;
+
+static void
+util_cpu_trace_do_init(void)
+{
+   trace_file = getenv("MESA_CPU_TRACE");
+   if (!trace_file || !*trace_file) {
+      util_cpu_trace_state = -1;
+      return;
+   }
+
+   base_ns = os_time_get_nano();
+   base_ticks = util_cpu_trace_timestamp();
+   atexit(util_cpu_trace_flush);
+   util_cpu_trace_state = 1;
+}
+
+void
+util_cpu_trace_init(void)
+{
+   call_once(&init_once, util_cpu_trace_do_init);
+}
+
+static struct util_cpu_trace_ring *
+util_cpu_trace_create_ring(void)
+{
+   struct util_cpu_trace_ring *ring = calloc(1, sizeof(*ring));
+
+   if (!ring)
+      return NULL;
+
+#if defined(HAVE_PTHREAD) && defined(__GLIBC__)
+   pthread_getname_np(pthread_self(), ring->thread_name,
+                      sizeof(ring->thread_name));
+#endif
+
+   mtx_lock(&rings_lock);
+   ring->tid = ++num_rings;
+   ring->next = rings;
+   rings = ring;
+   mtx_unlock(&rings_lock);
+
+   thread_ring = ring;
+   return ring;
+}
+
+void
+util_cpu_trace_end(struct util_cpu_trace_scope *scope)
+{
+   struct util_cpu_trace_ring *ring = thread_ring;
+   struct util_cpu_trace_event *e;
+
+   if (!scope->name)
+      return;
+
+   if (unlikely(!ring)) {
+      ring = util_cpu_trace_create_ring();
+      if (!ring)
+         return;
+   }
+
+   e = &ring->events[ring->head & (UTIL_CPU_TRACE_RING_SIZE - 1)];
+   e->name = scope->name;
+   e->begin = scope->begin;
+   e->end = util_cpu_trace_timestamp();
+
+   /* Publish the event to util_cpu_trace_flush. */
+   __atomic_store_n(&ring->head, ring->head + 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * Write all events that are still in the rings to the trace file, replacing
+ * its previous contents. Events that are being overwritten while this runs
+ * may come out garbled.
+ */
+void
+util_cpu_trace_flush(void)
+{
+   struct util_cpu_trace_ring *ring;
+   double ns_per_tick = 1;
+   bool first = true;
+   FILE *f;
+
+   if (util_cpu_trace_state <= 0)
+      return;
+
+#if defined(__x86_64__) || defined(__i386__)
+   uint64_t ticks = util_cpu_trace_timestamp();
+   int64_t ns = os_time_get_nano();
+
+   if (ticks > base_ticks)
+      ns_per_tick = (double)(ns - base_ns) / (ticks - base_ticks);
+#endif
+
+   mtx_lock(&rings_lock);
+   f = fopen(trace_file, "w");
+   if (!f) {
+      fprintf(stderr, "mesa: can't open the CPU trace %s\n", trace_file);
+      mtx_unlock(&rings_lock);
+      return;
+   }
+
+   fprintf(f, "[\n");
+   for (ring = rings; ring; ring = ring->next) {
+      uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+      uint32_t i = head > UTIL_CPU_TRACE_RING_SIZE ?
+                   head - UTIL_CPU_TRACE_RING_SIZE : 0;
+
+      if (ring->thread_name[0]) {
+         fprintf(f, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%i,"
+                 "\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+                 first ? "" : ",\n", (int)getpid(), ring->tid,
+                 ring->thread_name);
+         first = false;
+      }
+
+      for (; i != head; i++) {
+         struct util_cpu_trace_event *e =
+            &ring->events[i & (UTIL_CPU_TRACE_RING_SIZE - 1)];
+         int64_t begin = e->begin - base_ticks;
+         int64_t duration = e->end - e->begin;
+
+         fprintf(f, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":%i,\"tid\":%u,"
+                 "\"ts\":%.3f,\"dur\":%.3f}",
+                 first ? "" : ",\n", e->name, (int)getpid(), ring->tid,
+                 begin * ns_per_tick / 1000.0,
+                 MAX2(duration, 0) * ns_per_tick / 1000.0);
+         first = false;
+      }
+   }
+   fprintf(f, "\n]\n");
+   fclose(f);
+   mtx_unlock(&rings_lock);
+}
+
+#endif
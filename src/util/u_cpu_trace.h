@@ -0,0 +1,120 @@
+/*
+ * Copyright © 2018 Advanced Micro Devices, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/* CPU-side trace events in the Chrome trace format.
+ *
+ * MESA_TRACE_SCOPE(name) records the time from the macro to the end of the
+ * enclosing block as one event. The events go into a ring buffer of the
+ * calling thread, so recording only takes two timestamps and no locks. When
+ * a ring is full, the oldest events are overwritten.
+ *
+ * The macros expand to nothing unless Mesa is built with MESA_CPU_TRACE
+ * (-Dcpu-trace=true or --enable-cpu-trace). Even then, nothing is recorded
+ * unless the MESA_CPU_TRACE environment variable is set to a file name. The
+ * file is written at exit and whenever util_cpu_trace_flush is called, and
+ * can be loaded by chrome://tracing and Perfetto.
+ */
+
+#ifndef U_CPU_TRACE_H
+#define U_CPU_TRACE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "util/os_time.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(MESA_CPU_TRACE) && defined(__GNUC__)
+
+struct util_cpu_trace_scope {
+   const char *name; /* NULL if tracing is disabled */
+   uint64_t begin;
+};
+
+/* 0 = not initialized yet, 1 = enabled, -1 = disabled */
+extern int util_cpu_trace_state;
+
+void
+util_cpu_trace_init(void);
+
+void
+util_cpu_trace_end(struct util_cpu_trace_scope *scope);
+
+void
+util_cpu_trace_flush(void);
+
+static inline uint64_t
+util_cpu_trace_timestamp(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+   return __builtin_ia32_rdtsc();
+#else
+   return os_time_get_nano();
+#endif
+}
+
+static inline struct util_cpu_trace_scope
+util_cpu_trace_begin(const char *name)
+{
+   struct util_cpu_trace_scope scope = {NULL, 0};
+
+   if (__builtin_expect(util_cpu_trace_state == 0, 0))
+      util_cpu_trace_init();
+
+   if (util_cpu_trace_state > 0) {
+      scope.name = name;
+      scope.begin = util_cpu_trace_timestamp();
+   }
+   return scope;
+}
+
+#define _MESA_TRACE_CONCAT2(a, b) a ## b
+#define _MESA_TRACE_CONCAT(a, b) _MESA_TRACE_CONCAT2(a, b)
+
+#define MESA_TRACE_SCOPE(name) \
+   struct util_cpu_trace_scope _MESA_TRACE_CONCAT(_mesa_trace_, __LINE__) \
+      __attribute__((cleanup(util_cpu_trace_end), unused)) = \
+      util_cpu_trace_begin(name)
+
+#else
+
+static inline void
+util_cpu_trace_flush(void)
+{
+}
+
+#define MESA_TRACE_SCOPE(name) do {} while (0)
+
+#endif
+
+#define MESA_TRACE_FUNC() MESA_TRACE_SCOPE(__func__)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* U_CPU_TRACE_H */
@@ -28,12 +28,21 @@
 
 #include <time.h>
 
+#include "util/bitscan.h"
+#include "util/debug.h"
 #include "util/os_time.h"
 #include "util/u_string.h"
 #include "util/u_thread.h"
 #include "u_process.h"
 
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
 static void util_queue_killall_and_wait(struct util_queue *queue);
+static void util_sched_shutdown(void);
 
 /****************************************************************************
  * Wait for all queues to assert idle when exit() is called.
@@ -57,6 +66,8 @@ atexit_handler(void)
       util_queue_killall_and_wait(iter);
    }
    mtx_unlock(&exit_mutex);
+
+   util_sched_shutdown();
 }
 
 static void
@@ -91,6 +102,232 @@ remove_from_atexit_list(struct util_queue *queue)
    mtx_unlock(&exit_mutex);
 }
 
+/****************************************************************************
+ * Process-wide scheduler for UTIL_QUEUE_INIT_SHARED queues
+ *
+ * A fixed pool of workers, one per CPU, runs the jobs of all shared queues.
+ * A queue is linked into a run list while it has queued jobs and fewer
+ * running jobs than its thread limit, so jobs of one queue still start in
+ * order and thread_index stays below the queue's num_threads. Workers take
+ * the queue at the head of the list and requeue it at the tail after
+ * starting one job, so busy queues share the workers round-robin. Queues
+ * created with UTIL_QUEUE_INIT_USE_MINIMUM_PRIORITY only get a worker when
+ * no other shared queue has work.
+ *
+ * Lock order: sched.lock, then queue->lock.
+ */
+
+#define UTIL_SCHED_MAX_THREADS 32
+
+static struct {
+   mtx_t lock;
+   cnd_t has_work_cond;
+   struct list_head run_list[2]; /* normal, minimum priority */
+   thrd_t threads[UTIL_SCHED_MAX_THREADS];
+   unsigned num_threads;
+   unsigned num_queues;
+   bool kill_threads;
+} sched = {
+   .lock = _MTX_INITIALIZER_NP,
+};
+
+static once_flag sched_once_flag = ONCE_FLAG_INIT;
+
+static void
+util_sched_global_init(void)
+{
+   cnd_init(&sched.has_work_cond);
+   LIST_INITHEAD(&sched.run_list[0]);
+   LIST_INITHEAD(&sched.run_list[1]);
+}
+
+static unsigned
+util_sched_get_num_cpus(void)
+{
+#if defined(_WIN32)
+   SYSTEM_INFO system_info;
+   GetSystemInfo(&system_info);
+   return system_info.dwNumberOfProcessors;
+#elif defined(_SC_NPROCESSORS_ONLN)
+   long n = sysconf(_SC_NPROCESSORS_ONLN);
+   return n > 0 ? n : 1;
+#else
+   return 1;
+#endif
+}
+
+static bool
+util_sched_queue_is_runnable(struct util_queue *queue)
+{
+   return !queue->kill_threads &&
+          queue->num_queued > 0 &&
+          queue->num_running < queue->num_active_threads;
+}
+
+/* Link the queue into its run list if it can start a job.
+ * Both sched.lock and queue->lock must be held.
+ */
+static void
+util_sched_update_locked(struct util_queue *queue)
+{
+   if (LIST_IS_EMPTY(&queue->sched_head) &&
+       util_sched_queue_is_runnable(queue)) {
+      unsigned prio =
+         queue->flags & UTIL_QUEUE_INIT_USE_MINIMUM_PRIORITY ? 1 : 0;
+
+      LIST_ADDTAIL(&queue->sched_head, &sched.run_list[prio]);
+      cnd_signal(&sched.has_work_cond);
+   }
+}
+
+static void
+util_sched_update(struct util_queue *queue)
+{
+   mtx_lock(&sched.lock);
+   mtx_lock(&queue->lock);
+   util_sched_update_locked(queue);
+   mtx_unlock(&queue->lock);
+   mtx_unlock(&sched.lock);
+}
+
+static int
+util_sched_thread_func(void *input)
+{
+   int sched_index = (int)(intptr_t)input;
+   char name[16];
+
+   util_snprintf(name, sizeof(name), "mesa:sched%i", sched_index);
+   u_thread_setname(name);
+
+   mtx_lock(&sched.lock);
+   while (!sched.kill_threads) {
+      struct util_queue *queue = NULL;
+      struct util_queue_job job;
+      int thread_index;
+
+      for (unsigned i = 0; i < ARRAY_SIZE(sched.run_list); i++) {
+         if (!LIST_IS_EMPTY(&sched.run_list[i])) {
+            queue = LIST_ENTRY(struct util_queue, sched.run_list[i].next,
+                               sched_head);
+            break;
+         }
+      }
+
+      if (!queue) {
+         cnd_wait(&sched.has_work_cond, &sched.lock);
+         continue;
+      }
+
+      LIST_DELINIT(&queue->sched_head);
+
+      mtx_lock(&queue->lock);
+      assert(util_sched_queue_is_runnable(queue));
+
+      job = queue->jobs[queue->read_idx];
+      memset(&queue->jobs[queue->read_idx], 0, sizeof(struct util_queue_job));
+      queue->read_idx = (queue->read_idx + 1) % queue->max_jobs;
+      queue->num_queued--;
+      cnd_signal(&queue->has_space_cond);
+
+      thread_index = ffs(~queue->busy_slots) - 1;
+      assert(thread_index >= 0 && thread_index < (int)queue->num_threads);
+      queue->busy_slots |= 1u << thread_index;
+      queue->num_running++;
+
+      /* Let another worker start the next job of this queue. */
+      util_sched_update_locked(queue);
+      mtx_unlock(&queue->lock);
+      mtx_unlock(&sched.lock);
+
+      if (job.job) {
+         job.execute(job.job, thread_index);
+         util_queue_fence_signal(job.fence);
+         if (job.cleanup)
+            job.cleanup(job.job, thread_index);
+      }
+
+      mtx_lock(&sched.lock);
+      mtx_lock(&queue->lock);
+      queue->busy_slots &= ~(1u << thread_index);
+      queue->num_running--;
+      if (!queue->num_running)
+         cnd_broadcast(&queue->has_queued_cond);
+      util_sched_update_locked(queue);
+      mtx_unlock(&queue->lock);
+   }
+   mtx_unlock(&sched.lock);
+   return 0;
+}
+
+/* Start the workers with the first shared queue. */
+static bool
+util_sched_add_queue(void)
+{
+   bool ok = true;
+
+   call_once(&sched_once_flag, util_sched_global_init);
+
+   mtx_lock(&sched.lock);
+   if (!sched.num_threads) {
+      unsigned num_threads = MIN2(util_sched_get_num_cpus(),
+                                  UTIL_SCHED_MAX_THREADS);
+
+      sched.kill_threads = false;
+      for (unsigned i = 0; i < num_threads; i++) {
+         sched.threads[i] = u_thread_create(util_sched_thread_func,
+                                            (void*)(intptr_t)i);
+         if (!sched.threads[i])
+            break;
+         sched.num_threads++;
+      }
+      ok = sched.num_threads > 0;
+   }
+   if (ok)
+      sched.num_queues++;
+   mtx_unlock(&sched.lock);
+   return ok;
+}
+
+static void
+util_sched_shutdown_locked(void)
+{
+   unsigned num_threads = sched.num_threads;
+
+   if (!num_threads)
+      return;
+
+   sched.kill_threads = true;
+   cnd_broadcast(&sched.has_work_cond);
+   mtx_unlock(&sched.lock);
+
+   for (unsigned i = 0; i < num_threads; i++)
+      thrd_join(sched.threads[i], NULL);
+
+   mtx_lock(&sched.lock);
+   sched.num_threads = 0;
+}
+
+static void
+util_sched_shutdown(void)
+{
+   mtx_lock(&sched.lock);
+   util_sched_shutdown_locked();
+   mtx_unlock(&sched.lock);
+}
+
+/* Stop the workers with the last shared queue, so that no thread is left
+ * running when the driver is unloaded.
+ */
+static void
+util_sched_remove_queue(void)
+{
+   mtx_lock(&sched.lock);
+   assert(sched.num_queues);
+   if (!--sched.num_queues)
+      util_sched_shutdown_locked();
+   mtx_unlock(&sched.lock);
+}
+
 /****************************************************************************
  * util_queue_fence
  */
@@ -222,6 +459,227 @@ util_queue_fence_destroy(struct util_queue_fence *fence)
 }
 #endif
 
+/****************************************************************************
+ * Lock-free job ring
+ *
+ * A bounded multi-producer, multi-consumer ring. Each slot carries a
+ * sequence number telling for which position it can be filled or read, so
+ * producers and threads only race on enqueue_pos and dequeue_pos with
+ * compare-and-swap and never share a lock.
+ *
+ * Threads with nothing to do and producers facing a full ring park on an
+ * event futex. The low bits of an event count the parked threads and the
+ * high bits change on every signal. A single atomic updates both, so a
+ * signal can't miss a thread that is about to sleep.
+ */
+
+#ifdef UTIL_QUEUE_FENCE_FUTEX
+#define UTIL_QUEUE_LOCKLESS
+
+#define LF_EVENT_WAITERS_MASK    0xffffu
+#define LF_EVENT_SIGNAL          (1u << 16)
+
+/* Register as a waiter. Check the condition again before calling
+ * lf_event_wait with the returned value or lf_event_cancel_wait.
+ */
+static inline uint32_t
+lf_event_prepare_wait(uint32_t *event)
+{
+   return p_atomic_inc_return(event);
+}
+
+static inline void
+lf_event_cancel_wait(uint32_t *event)
+{
+   p_atomic_dec(event);
+}
+
+static void
+lf_event_wait(uint32_t *event, uint32_t value)
+{
+   futex_wait(event, value, NULL);
+   p_atomic_dec(event);
+}
+
+static void
+lf_event_signal(uint32_t *event, int count)
+{
+   uint32_t old, v = p_atomic_read(event);
+
+   while ((old = p_atomic_cmpxchg(event, v, v + LF_EVENT_SIGNAL)) != v)
+      v = old;
+
+   if (v & LF_EVENT_WAITERS_MASK)
+      futex_wake(event, count);
+}
+
+static bool
+lf_ring_push(struct util_queue *queue,
+             void *job,
+             struct util_queue_fence *fence,
+             util_queue_execute_func execute,
+             util_queue_execute_func cleanup)
+{
+   uint32_t pos = p_atomic_read(&queue->enqueue_pos);
+   struct util_queue_job *slot;
+
+   while (1) {
+      slot = &queue->jobs[pos & queue->ring_mask];
+      int32_t dif = (int32_t)(p_atomic_read(&slot->seq) - pos);
+
+      if (dif == 0) {
+         uint32_t old = p_atomic_cmpxchg(&queue->enqueue_pos, pos, pos + 1);
+         if (old == pos)
+            break;
+         pos = old;
+      } else if (dif < 0) {
+         return false; /* full */
+      } else {
+         pos = p_atomic_read(&queue->enqueue_pos);
+      }
+   }
+
+   util_queue_fence_reset(fence);
+
+   slot->job = job;
+   slot->fence = fence;
+   slot->execute = execute;
+   slot->cleanup = cleanup;
+   slot->claim = pos;
+   p_atomic_set(&slot->seq, pos + 1);
+
+   /* A disabled thread would go back to sleep without running the job. */
+   lf_event_signal(&queue->queued_event,
+                   p_atomic_read(&queue->num_active_threads) <
+                   queue->num_threads ? INT_MAX : 1);
+   return true;
+}
+
+/* Take the oldest job. job->job is NULL if util_queue_drop_job removed it. */
+static bool
+lf_ring_pop(struct util_queue *queue, struct util_queue_job *job)
+{
+   uint32_t pos = p_atomic_read(&queue->dequeue_pos);
+   struct util_queue_job *slot;
+
+   while (1) {
+      slot = &queue->jobs[pos & queue->ring_mask];
+      int32_t dif = (int32_t)(p_atomic_read(&slot->seq) - (pos + 1));
+
+      if (dif == 0) {
+         uint32_t old = p_atomic_cmpxchg(&queue->dequeue_pos, pos, pos + 1);
+         if (old == pos)
+            break;
+         pos = old;
+      } else if (dif < 0) {
+         return false; /* empty */
+      } else {
+         pos = p_atomic_read(&queue->dequeue_pos);
+      }
+   }
+
+   *job = *slot;
+   if (p_atomic_cmpxchg(&slot->claim, pos, pos + 1) != pos)
+      job->job = NULL;
+
+   p_atomic_set(&slot->seq, pos + queue->ring_mask + 1);
+   lf_event_signal(&queue->space_event, 1);
+   return true;
+}
+
+/* Remove the job with the fence if no thread has taken it yet. */
+static bool
+lf_ring_drop(struct util_queue *queue, struct util_queue_fence *fence)
+{
+   uint32_t pos = p_atomic_read(&queue->dequeue_pos);
+   uint32_t end = p_atomic_read(&queue->enqueue_pos);
+
+   for (; pos != end; pos++) {
+      struct util_queue_job *slot = &queue->jobs[pos & queue->ring_mask];
+      struct util_queue_job job;
+
+      if (p_atomic_read(&slot->seq) != pos + 1 || slot->fence != fence)
+         continue;
+
+      /* The copy is only valid if the claim succeeds, because the slot
+       * can't be reused before it's claimed.
+       */
+      job = *slot;
+      if (p_atomic_cmpxchg(&slot->claim, pos, pos + 1) == pos) {
+         if (job.cleanup)
+            job.cleanup(job.job, -1);
+         return true;
+      }
+   }
+   return false;
+}
+
+static bool
+lf_thread_take_job(struct util_queue *queue, int thread_index,
+                   struct util_queue_job *job)
+{
+   return thread_index < (int)p_atomic_read(&queue->num_active_threads) &&
+          lf_ring_pop(queue, job);
+}
+
+static void
+lf_thread_loop(struct util_queue *queue, int thread_index)
+{
+   while (!p_atomic_read(&queue->kill_threads)) {
+      struct util_queue_job job;
+
+      if (!lf_thread_take_job(queue, thread_index, &job)) {
+         uint32_t event = lf_event_prepare_wait(&queue->queued_event);
+
+         if (!lf_thread_take_job(queue, thread_index, &job)) {
+            if (p_atomic_read(&queue->kill_threads))
+               lf_event_cancel_wait(&queue->queued_event);
+            else
+               lf_event_wait(&queue->queued_event, event);
+            continue;
+         }
+         lf_event_cancel_wait(&queue->queued_event);
+      }
+
+      if (job.job) {
+         job.execute(job.job, thread_index);
+         util_queue_fence_signal(job.fence);
+         if (job.cleanup)
+            job.cleanup(job.job, thread_index);
+      }
+   }
+}
+
+static void
+lf_add_job(struct util_queue *queue,
+           void *job,
+           struct util_queue_fence *fence,
+           util_queue_execute_func execute,
+           util_queue_execute_func cleanup)
+{
+   /* Wait until there is a free slot. If the queue is killed, the job is
+    * dropped like in util_queue_add_job.
+    */
+   while (!p_atomic_read(&queue->kill_threads)) {
+      uint32_t event;
+
+      if (lf_ring_push(queue, job, fence, execute, cleanup))
+         return;
+
+      event = lf_event_prepare_wait(&queue->space_event);
+      if (lf_ring_push(queue, job, fence, execute, cleanup)) {
+         lf_event_cancel_wait(&queue->space_event);
+         return;
+      }
+
+      if (p_atomic_read(&queue->kill_threads))
+         lf_event_cancel_wait(&queue->space_event);
+      else
+         lf_event_wait(&queue->space_event, event);
+   }
+}
+#endif
+
 /****************************************************************************
  * util_queue implementation
  */
@@ -245,14 +703,24 @@ util_queue_thread_func(void *input)
       u_thread_setname(name);
    }
 
+#ifdef UTIL_QUEUE_LOCKLESS
+   /* util_queue_killall_and_wait signals the remaining jobs. */
+   if (queue->lockless) {
+      lf_thread_loop(queue, thread_index);
+      return 0;
+   }
+#endif
+
    while (1) {
       struct util_queue_job job;
 
       mtx_lock(&queue->lock);
       assert(queue->num_queued >= 0 && queue->num_queued <= queue->max_jobs);
 
-      /* wait if the queue is empty */
-      while (!queue->kill_threads && queue->num_queued == 0)
+      /* wait if the queue is empty or this thread has been disabled */
+      while (!queue->kill_threads &&
+             (queue->num_queued == 0 ||
+              thread_index >= (int)queue->num_active_threads))
          cnd_wait(&queue->has_queued_cond, &queue->lock);
 
       if (queue->kill_threads) {
@@ -328,15 +796,43 @@ util_queue_init(struct util_queue *queue,
       util_snprintf(queue->name, sizeof(queue->name), "%s", name);
    }
 
+   if ((flags & UTIL_QUEUE_INIT_SHARED) &&
+       !env_var_as_boolean("MESA_SHARED_QUEUES", true))
+      flags &= ~UTIL_QUEUE_INIT_SHARED;
+
+   /* busy_slots has one bit per thread index */
+   if (flags & UTIL_QUEUE_INIT_SHARED)
+      num_threads = MIN2(num_threads, 32);
+
+#ifdef UTIL_QUEUE_LOCKLESS
+   /* Growing the ring needs exclusive access, and shared queues are
+    * scheduled under their lock anyway.
+    */
+   if (!(flags & (UTIL_QUEUE_INIT_SHARED | UTIL_QUEUE_INIT_RESIZE_IF_FULL))) {
+      unsigned size = 2;
+
+      /* The ring is indexed by masking the positions. */
+      while (size < max_jobs)
+         size *= 2;
+      max_jobs = size;
+      queue->lockless = true;
+      queue->ring_mask = size - 1;
+   }
+#endif
+
    queue->flags = flags;
    queue->num_threads = num_threads;
    queue->max_jobs = max_jobs;
+   LIST_INITHEAD(&queue->sched_head);
 
    queue->jobs = (struct util_queue_job*)
                  calloc(max_jobs, sizeof(struct util_queue_job));
    if (!queue->jobs)
       goto fail;
 
+   for (i = 0; i < max_jobs; i++)
+      queue->jobs[i].seq = i;
+
    (void) mtx_init(&queue->lock, mtx_plain);
    (void) mtx_init(&queue->finish_lock, mtx_plain);
 
@@ -344,6 +840,15 @@ util_queue_init(struct util_queue *queue,
    cnd_init(&queue->has_queued_cond);
    cnd_init(&queue->has_space_cond);
 
+   if (flags & UTIL_QUEUE_INIT_SHARED) {
+      if (!util_sched_add_queue())
+         goto fail;
+
+      queue->num_active_threads = num_threads;
+      add_to_atexit_list(queue);
+      return true;
+   }
+
    queue->threads = (thrd_t*) calloc(num_threads, sizeof(thrd_t));
    if (!queue->threads)
       goto fail;
@@ -385,6 +890,10 @@ util_queue_init(struct util_queue *queue,
       }
    }
 
+   mtx_lock(&queue->lock);
+   queue->num_active_threads = queue->num_threads;
+   mtx_unlock(&queue->lock);
+
    add_to_atexit_list(queue);
    return true;
 
@@ -402,17 +911,68 @@ fail:
    return false;
 }
 
+static void
+util_queue_killall_and_wait_shared(struct util_queue *queue)
+{
+   mtx_lock(&sched.lock);
+   mtx_lock(&queue->lock);
+   queue->kill_threads = 1;
+   LIST_DELINIT(&queue->sched_head);
+   mtx_unlock(&sched.lock);
+
+   while (queue->num_running)
+      cnd_wait(&queue->has_queued_cond, &queue->lock);
+
+   /* signal remaining jobs */
+   for (unsigned i = queue->read_idx; i != queue->write_idx;
+        i = (i + 1) % queue->max_jobs) {
+      if (queue->jobs[i].job) {
+         util_queue_fence_signal(queue->jobs[i].fence);
+         queue->jobs[i].job = NULL;
+      }
+   }
+   queue->read_idx = queue->write_idx;
+   queue->num_queued = 0;
+   cnd_broadcast(&queue->has_queued_cond);
+   mtx_unlock(&queue->lock);
+}
+
 static void
 util_queue_killall_and_wait(struct util_queue *queue)
 {
    unsigned i;
 
+   if (queue->flags & UTIL_QUEUE_INIT_SHARED) {
+      util_queue_killall_and_wait_shared(queue);
+      return;
+   }
+
    /* Signal all threads to terminate. */
    mtx_lock(&queue->lock);
    queue->kill_threads = 1;
    cnd_broadcast(&queue->has_queued_cond);
    mtx_unlock(&queue->lock);
 
+#ifdef UTIL_QUEUE_LOCKLESS
+   if (queue->lockless) {
+      struct util_queue_job job;
+
+      lf_event_signal(&queue->queued_event, INT_MAX);
+      lf_event_signal(&queue->space_event, INT_MAX);
+
+      for (i = 0; i < queue->num_threads; i++)
+         thrd_join(queue->threads[i], NULL);
+      queue->num_threads = 0;
+
+      /* signal remaining jobs */
+      while (lf_ring_pop(queue, &job)) {
+         if (job.job)
+            util_queue_fence_signal(job.fence);
+      }
+      return;
+   }
+#endif
+
    for (i = 0; i < queue->num_threads; i++)
       thrd_join(queue->threads[i], NULL);
    queue->num_threads = 0;
@@ -424,6 +984,9 @@ util_queue_destroy(struct util_queue *queue)
    util_queue_killall_and_wait(queue);
    remove_from_atexit_list(queue);
 
+   if (queue->flags & UTIL_QUEUE_INIT_SHARED)
+      util_sched_remove_queue();
+
    cnd_destroy(&queue->has_space_cond);
    cnd_destroy(&queue->has_queued_cond);
    mtx_destroy(&queue->finish_lock);
@@ -441,6 +1004,13 @@ util_queue_add_job(struct util_queue *queue,
 {
    struct util_queue_job *ptr;
 
+#ifdef UTIL_QUEUE_LOCKLESS
+   if (queue->lockless) {
+      lf_add_job(queue, job, fence, execute, cleanup);
+      return;
+   }
+#endif
+
    mtx_lock(&queue->lock);
    if (queue->kill_threads) {
       mtx_unlock(&queue->lock);
@@ -497,10 +1067,49 @@ util_queue_add_job(struct util_queue *queue,
    queue->write_idx = (queue->write_idx + 1) % queue->max_jobs;
 
    queue->num_queued++;
-   cnd_signal(&queue->has_queued_cond);
+
+   if (queue->flags & UTIL_QUEUE_INIT_SHARED) {
+      mtx_unlock(&queue->lock);
+      util_sched_update(queue);
+      return;
+   }
+
+   /* A disabled thread would go back to sleep without running the job. */
+   if (queue->num_active_threads < queue->num_threads)
+      cnd_broadcast(&queue->has_queued_cond);
+   else
+      cnd_signal(&queue->has_queued_cond);
    mtx_unlock(&queue->lock);
 }
 
+/**
+ * Limit the number of threads that execute jobs to \p num_threads, which
+ * is clamped to the range [1, number of threads created at init].  Extra
+ * threads stay idle until they are enabled again.
+ */
+void
+util_queue_adjust_num_threads(struct util_queue *queue, unsigned num_threads)
+{
+   num_threads = MIN2(num_threads, queue->num_threads);
+   num_threads = MAX2(num_threads, 1);
+
+   /* util_queue_finish relies on the number of active threads. */
+   mtx_lock(&queue->finish_lock);
+   mtx_lock(&queue->lock);
+   queue->num_active_threads = num_threads;
+   cnd_broadcast(&queue->has_queued_cond);
+   mtx_unlock(&queue->lock);
+   mtx_unlock(&queue->finish_lock);
+
+#ifdef UTIL_QUEUE_LOCKLESS
+   if (queue->lockless)
+      lf_event_signal(&queue->queued_event, INT_MAX);
+#endif
+
+   if (queue->flags & UTIL_QUEUE_INIT_SHARED)
+      util_sched_update(queue);
+}
+
 /**
  * Remove a queued job. If the job hasn't started execution, it's removed from
  * the queue. If the job has started execution, the function waits for it to
@@ -519,6 +1128,16 @@ util_queue_drop_job(struct util_queue *queue, struct util_queue_fence *fence)
    if (util_queue_fence_is_signalled(fence))
       return;
 
+#ifdef UTIL_QUEUE_LOCKLESS
+   if (queue->lockless) {
+      if (lf_ring_drop(queue, fence))
+         util_queue_fence_signal(fence);
+      else
+         util_queue_fence_wait(fence);
+      return;
+   }
+#endif
+
    mtx_lock(&queue->lock);
    for (unsigned i = queue->read_idx; i != queue->write_idx;
         i = (i + 1) % queue->max_jobs) {
@@ -554,9 +1173,20 @@ void
 util_queue_finish(struct util_queue *queue)
 {
    util_barrier barrier;
-   struct util_queue_fence *fences = malloc(queue->num_threads * sizeof(*fences));
+   struct util_queue_fence *fences;
+   unsigned num_threads;
 
-   util_barrier_init(&barrier, queue->num_threads);
+   /* The barrier below would need all of the queue's jobs to run at the
+    * same time, which the shared workers don't guarantee. Wait until the
+    * queue is idle instead.
+    */
+   if (queue->flags & UTIL_QUEUE_INIT_SHARED) {
+      mtx_lock(&queue->lock);
+      while (queue->num_queued || queue->num_running)
+         cnd_wait(&queue->has_queued_cond, &queue->lock);
+      mtx_unlock(&queue->lock);
+      return;
+   }
 
    /* If 2 threads were adding jobs for 2 different barries at the same time,
     * a deadlock would happen, because 1 barrier requires that all threads
@@ -564,12 +1194,17 @@ util_queue_finish(struct util_queue *queue)
     */
    mtx_lock(&queue->finish_lock);
 
-   for (unsigned i = 0; i < queue->num_threads; ++i) {
+   /* Only the active threads pick up jobs. */
+   num_threads = queue->num_active_threads;
+   fences = malloc(num_threads * sizeof(*fences));
+   util_barrier_init(&barrier, num_threads);
+
+   for (unsigned i = 0; i < num_threads; ++i) {
       util_queue_fence_init(&fences[i]);
       util_queue_add_job(queue, &barrier, &fences[i], util_queue_finish_execute, NULL);
    }
 
-   for (unsigned i = 0; i < queue->num_threads; ++i) {
+   for (unsigned i = 0; i < num_threads; ++i) {
       util_queue_fence_wait(&fences[i]);
       util_queue_fence_destroy(&fences[i]);
    }
@@ -583,8 +1218,10 @@ util_queue_finish(struct util_queue *queue)
 int64_t
 util_queue_get_thread_time_nano(struct util_queue *queue, unsigned thread_index)
 {
-   /* Allow some flexibility by not raising an error. */
-   if (thread_index >= queue->num_threads)
+   /* Allow some flexibility by not raising an error. Shared queues have no
+    * threads of their own.
+    */
+   if (!queue->threads || thread_index >= queue->num_threads)
       return 0;
 
    return u_thread_get_time_nano(queue->threads[thread_index]);
@@ -48,6 +48,11 @@ extern "C" {
 
 #define UTIL_QUEUE_INIT_USE_MINIMUM_PRIORITY      (1 << 0)
 #define UTIL_QUEUE_INIT_RESIZE_IF_FULL            (1 << 1)
+/* Run the jobs on the process-wide worker pool instead of dedicated
+ * threads. num_threads only limits how many jobs of the queue can run at
+ * the same time. The jobs must not wait for jobs of other queues.
+ */
+#define UTIL_QUEUE_INIT_SHARED                    (1 << 2)
 
 #if defined(__GNUC__) && defined(HAVE_LINUX_FUTEX_H)
 #define UTIL_QUEUE_FENCE_FUTEX
@@ -195,6 +200,13 @@ struct util_queue_job {
    struct util_queue_fence *fence;
    util_queue_execute_func execute;
    util_queue_execute_func cleanup;
+
+   /* For the lock-free ring. The slot can be filled for position "pos"
+    * when seq == pos and read when seq == pos + 1. claim holds the position
+    * of the queued job until a thread or util_queue_drop_job takes it.
+    */
+   uint32_t seq;
+   uint32_t claim;
 };
 
 /* Put this into your context. */
@@ -208,11 +220,29 @@ struct util_queue {
    unsigned flags;
    int num_queued;
    unsigned num_threads;
+   unsigned num_active_threads; /* <= num_threads, see util_queue_adjust_num_threads */
    int kill_threads;
    int max_jobs;
    int write_idx, read_idx; /* ring buffer pointers */
    struct util_queue_job *jobs;
 
+   /* Queues with dedicated threads that don't resize use jobs as a
+    * lock-free ring instead, and park threads on the event futexes. The
+    * positions only grow and are masked to index jobs.
+    */
+   bool lockless;
+   uint32_t ring_mask;
+   uint32_t enqueue_pos, dequeue_pos;
+   uint32_t queued_event, space_event;
+
+   /* For UTIL_QUEUE_INIT_SHARED. The queue is linked into the scheduler's
+    * run list while it has jobs that may start. has_queued_cond is
+    * signalled when the last running job completes.
+    */
+   struct list_head sched_head;
+   unsigned num_running;
+   uint32_t busy_slots; /* thread indices used by the running jobs */
+
    /* for cleanup at exit(), protected by exit_mutex */
    struct list_head head;
 };
@@ -234,6 +264,8 @@ void util_queue_drop_job(struct util_queue *queue,
                          struct util_queue_fence *fence);
 
 void util_queue_finish(struct util_queue *queue);
+void util_queue_adjust_num_threads(struct util_queue *queue,
+                                   unsigned num_threads);
 
 int64_t util_queue_get_thread_time_nano(struct util_queue *queue,
                                         unsigned thread_index);
@@ -242,7 +274,7 @@ int64_t util_queue_get_thread_time_nano(struct util_queue *queue,
 static inline bool
 util_queue_is_initialized(struct util_queue *queue)
 {
-   return queue->threads != NULL;
+   return queue->jobs != NULL;
 }
 
 /* Convenient structure for monitoring the queue externally and passing
@@ -36,6 +36,10 @@
 #include <signal.h>
 #endif
 
+#if defined(HAVE_PTHREAD) && defined(__linux__)
+#include <sched.h>
+#endif
+
 
 static inline thrd_t u_thread_create(int (*routine)(void *), void *param)
 {
@@ -70,6 +74,40 @@ static inline void u_thread_setname( const char *name )
    (void)name;
 }
 
+/**
+ * Pin the calling thread to the n-th CPU the process is allowed to run on,
+ * wrapping around if there are fewer CPUs.
+ *
+ * Returns false if the thread could not be pinned.
+ */
+static inline bool
+u_thread_pin_to_cpu(unsigned n)
+{
+#if defined(HAVE_PTHREAD) && defined(__linux__) && defined(CPU_COUNT)
+   cpu_set_t allowed, cpuset;
+   unsigned count, cpu;
+
+   if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0)
+      return false;
+
+   count = CPU_COUNT(&allowed);
+   if (count == 0)
+      return false;
+
+   n %= count;
+   for (cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+      if (CPU_ISSET(cpu, &allowed) && n-- == 0) {
+         CPU_ZERO(&cpuset);
+         CPU_SET(cpu, &cpuset);
+         return pthread_setaffinity_np(pthread_self(), sizeof(cpuset),
+                                       &cpuset) == 0;
+      }
+   }
+#endif
+   (void)n;
+   return false;
+}
+
 /*
  * Thread statistics.
  */
@@ -36,8 +36,12 @@
 #include <math.h>
 #include <unistd.h>
 #include <errno.h>
+#include <sys/stat.h>
 #include "xmlconfig.h"
 #include "u_process.h"
+#include "u_dynarray.h"
+#include "disk_cache.h"
+#include "c11/threads.h"
 
 
 /** \brief Find an option in an option cache with the name as key */
@@ -641,6 +645,201 @@ optInfoEndElem(void *userData, const XML_Char *name)
     }
 }
 
+/**
+ * \brief On-disk cache of parsed option tables
+ *
+ * Parsing the driver's option XML and the drirc files with expat is a
+ * noticeable part of screen and context creation.  The results are stored
+ * in a disk cache in a compact binary form, keyed by everything they
+ * depend on, including the modification times of the drirc files.
+ */
+#define DRICONF_CACHE_VERSION "1"
+
+static struct disk_cache *driconfDiskCache;
+static once_flag driconfDiskCacheOnce = ONCE_FLAG_INIT;
+
+static void
+driconfDiskCacheInit(void)
+{
+    driconfDiskCache = disk_cache_create("driconf", DRICONF_CACHE_VERSION, 0);
+}
+
+static struct disk_cache *
+driconfGetDiskCache(void)
+{
+    call_once(&driconfDiskCacheOnce, driconfDiskCacheInit);
+    return driconfDiskCache;
+}
+
+static void
+writeBytes(struct util_dynarray *buf, const void *data, unsigned size)
+{
+    memcpy(util_dynarray_grow(buf, size), data, size);
+}
+
+static void
+writeUint32(struct util_dynarray *buf, uint32_t value)
+{
+    writeBytes(buf, &value, sizeof value);
+}
+
+static void
+writeString(struct util_dynarray *buf, const char *string)
+{
+    uint32_t len = string ? strlen(string) + 1 : 0;
+    writeUint32(buf, len);
+    writeBytes(buf, string, len);
+}
+
+/** \brief Serialize option values, strings included */
+static void
+writeOptionValues(struct util_dynarray *buf, const driOptionCache *cache)
+{
+    uint32_t i, size = 1 << cache->tableSize;
+    for (i = 0; i < size; ++i) {
+        if (cache->info[i].name == NULL)
+            continue;
+        if (cache->info[i].type == DRI_STRING)
+            writeString(buf, cache->values[i]._string);
+        else
+            writeBytes(buf, &cache->values[i], sizeof cache->values[i]);
+    }
+}
+
+/** \brief Serialize option infos and their default values */
+static void
+writeOptionInfo(struct util_dynarray *buf, const driOptionCache *info)
+{
+    uint32_t i, size = 1 << info->tableSize;
+    writeUint32(buf, info->tableSize);
+    for (i = 0; i < size; ++i) {
+        writeString(buf, info->info[i].name);
+        if (info->info[i].name == NULL)
+            continue;
+        writeUint32(buf, info->info[i].type);
+        writeUint32(buf, info->info[i].nRanges);
+        writeBytes(buf, info->info[i].ranges,
+                   info->info[i].nRanges * sizeof (driOptionRange));
+    }
+    writeOptionValues(buf, info);
+}
+
+struct driconfReader {
+    const uint8_t *cur, *end;
+    bool overrun;
+};
+
+static const void *
+readBytes(struct driconfReader *r, uint32_t size)
+{
+    const void *data = r->cur;
+    if (r->overrun || size > (size_t)(r->end - r->cur)) {
+        r->overrun = true;
+        return NULL;
+    }
+    r->cur += size;
+    return data;
+}
+
+static uint32_t
+readUint32(struct driconfReader *r)
+{
+    uint32_t value = 0;
+    const void *data = readBytes(r, sizeof value);
+    if (data)
+        memcpy(&value, data, sizeof value);
+    return value;
+}
+
+static char *
+readString(struct driconfReader *r)
+{
+    uint32_t len = readUint32(r);
+    const char *data;
+    char *string;
+
+    if (len == 0)
+        return NULL;
+    data = readBytes(r, len);
+    if (data == NULL || data[len - 1] != '\0') {
+        r->overrun = true;
+        return NULL;
+    }
+    XSTRDUP(string, data);
+    return string;
+}
+
+/** \brief Counterpart of writeOptionValues, cache->info must be set up */
+static bool
+readOptionValues(struct driconfReader *r, driOptionCache *cache)
+{
+    uint32_t i, size = 1 << cache->tableSize;
+    for (i = 0; i < size; ++i) {
+        if (cache->info[i].name == NULL)
+            continue;
+        if (cache->info[i].type == DRI_STRING) {
+            free(cache->values[i]._string);
+            cache->values[i]._string = readString(r);
+            if (cache->values[i]._string == NULL)
+                XSTRDUP(cache->values[i]._string, "");
+        } else {
+            const void *data = readBytes(r, sizeof cache->values[i]);
+            if (data)
+                memcpy(&cache->values[i], data, sizeof cache->values[i]);
+        }
+    }
+    return !r->overrun && r->cur == r->end;
+}
+
+/** \brief Counterpart of writeOptionInfo */
+static bool
+readOptionInfo(driOptionCache *info, const void *blob, size_t size)
+{
+    struct driconfReader r = { blob, (const uint8_t *)blob + size, false };
+    uint32_t i, tableSize = readUint32(&r);
+
+    if (r.overrun || tableSize > 16)
+        return false;
+
+    info->tableSize = tableSize;
+    info->info = calloc(1 << tableSize, sizeof (driOptionInfo));
+    info->values = calloc(1 << tableSize, sizeof (driOptionValue));
+    if (info->info == NULL || info->values == NULL) {
+        fprintf (stderr, "%s: %d: out of memory.\n", __FILE__, __LINE__);
+        abort();
+    }
+
+    for (i = 0; i < 1u << tableSize && !r.overrun; ++i) {
+        const void *ranges;
+        info->info[i].name = readString(&r);
+        if (info->info[i].name == NULL)
+            continue;
+        info->info[i].type = readUint32(&r);
+        info->info[i].nRanges = readUint32(&r);
+        if (info->info[i].nRanges > size / sizeof (driOptionRange))
+            r.overrun = true;
+        ranges = readBytes(&r, info->info[i].nRanges * sizeof (driOptionRange));
+        if (ranges && info->info[i].nRanges) {
+            info->info[i].ranges =
+                malloc(info->info[i].nRanges * sizeof (driOptionRange));
+            if (info->info[i].ranges == NULL) {
+                fprintf (stderr, "%s: %d: out of memory.\n", __FILE__, __LINE__);
+                abort();
+            }
+            memcpy(info->info[i].ranges, ranges,
+                   info->info[i].nRanges * sizeof (driOptionRange));
+        }
+    }
+
+    /* String values start out NULL, readOptionValues frees the old ones. */
+    if (!r.overrun && readOptionValues(&r, info))
+        return true;
+
+    driDestroyOptionInfo(info);
+    memset(info, 0, sizeof *info);
+    return false;
+}
+
 void
 driParseOptionInfo(driOptionCache *info, const char *configOptions)
 {
@@ -648,6 +847,28 @@ driParseOptionInfo(driOptionCache *info, const char *configOptions)
     int status;
     struct OptInfoData userData;
     struct OptInfoData *data = &userData;
+    struct disk_cache *diskCache = driconfGetDiskCache();
+    cache_key key;
+
+    if (diskCache) {
+        struct util_dynarray keyData;
+        void *blob;
+        size_t size;
+
+        util_dynarray_init(&keyData, NULL);
+        writeString(&keyData, "driinfo");
+        writeString(&keyData, configOptions);
+        disk_cache_compute_key(diskCache, keyData.data, keyData.size, key);
+        util_dynarray_fini(&keyData);
+
+        blob = disk_cache_get(diskCache, key, &size);
+        if (blob) {
+            bool ok = readOptionInfo(info, blob, size);
+            free(blob);
+            if (ok)
+                return;
+        }
+    }
 
     /* Make the hash table big enough to fit more than the maximum number of
      * config options we've ever seen in a driver.
@@ -679,6 +900,15 @@ driParseOptionInfo(driOptionCache *info, const char *configOptions)
         XML_FATAL ("%s.", XML_ErrorString(XML_GetErrorCode(p)));
 
     XML_ParserFree (p);
+
+    if (diskCache) {
+        struct util_dynarray blob;
+
+        util_dynarray_init(&blob, NULL);
+        writeOptionInfo(&blob, info);
+        disk_cache_put(diskCache, key, blob.data, blob.size, NULL);
+        util_dynarray_fini(&blob);
+    }
 }
 
 /** \brief Parser context for configuration files. */
@@ -919,6 +1149,8 @@ driParseConfigFiles(driOptionCache *cache, const driOptionCache *info,
     char *home;
     uint32_t i;
     struct OptConfData userData;
+    struct disk_cache *diskCache;
+    cache_key key;
 
     initOptionCache (cache, info);
 
@@ -938,6 +1170,51 @@ driParseConfigFiles(driOptionCache *cache, const driOptionCache *info,
         }
     }
 
+    diskCache = driconfGetDiskCache();
+    if (diskCache) {
+        struct util_dynarray keyData;
+        void *blob;
+        size_t size;
+
+        /* The key covers the option infos and defaults, the device and
+         * application being matched and the identity of each drirc file,
+         * so that editing one of them invalidates the entry.
+         */
+        util_dynarray_init(&keyData, NULL);
+        writeString(&keyData, "driconf");
+        writeOptionInfo(&keyData, info);
+        writeUint32(&keyData, screenNum);
+        writeString(&keyData, driverName);
+        writeString(&keyData, userData.execName);
+        for (i = 0; i < 2; ++i) {
+            struct stat st;
+            writeString(&keyData, filenames[i]);
+            if (filenames[i] && stat(filenames[i], &st) == 0) {
+                writeBytes(&keyData, &st.st_dev, sizeof st.st_dev);
+                writeBytes(&keyData, &st.st_ino, sizeof st.st_ino);
+                writeBytes(&keyData, &st.st_size, sizeof st.st_size);
+                writeBytes(&keyData, &st.st_mtime, sizeof st.st_mtime);
+            }
+        }
+        disk_cache_compute_key(diskCache, keyData.data, keyData.size, key);
+        util_dynarray_fini(&keyData);
+
+        blob = disk_cache_get(diskCache, key, &size);
+        if (blob) {
+            struct driconfReader r = { blob, (const uint8_t *)blob + size,
+                                       false };
+            bool ok = readOptionValues(&r, cache);
+            free(blob);
+            if (ok) {
+                free(filenames[1]);
+                return;
+            }
+            /* Start over from the defaults. */
+            driDestroyOptionCache(cache);
+            initOptionCache(cache, info);
+        }
+    }
+
     for (i = 0; i < 2; ++i) {
         XML_Parser p;
         if (filenames[i] == NULL)
@@ -959,6 +1236,15 @@ driParseConfigFiles(driOptionCache *cache, const driOptionCache *info,
         XML_ParserFree (p);
     }
 
+    if (diskCache) {
+        struct util_dynarray blob;
+
+        util_dynarray_init(&blob, NULL);
+        writeOptionValues(&blob, cache);
+        disk_cache_put(diskCache, key, blob.data, blob.size, NULL);
+        util_dynarray_fini(&blob);
+    }
+
     free(filenames[1]);
 }
 
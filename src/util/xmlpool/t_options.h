@@ -468,6 +468,11 @@ DRI_CONF_OPT_BEGIN_B(radeonsi_commutative_blend_add, def) \
         DRI_CONF_DESC(en,gettext("Commutative additive blending optimizations (may cause rendering errors)")) \
 DRI_CONF_OPT_END
 
+#define DRI_CONF_RADEONSI_DPBB_MIN_BIN_SIZE(def) \
+DRI_CONF_OPT_BEGIN_V(radeonsi_dpbb_min_bin_size, int, def, "0:512") \
+        DRI_CONF_DESC(en,gettext("Minimum width and height of primitive binning bins in pixels, rounded up to a power of two (0 = use the default bin sizes)")) \
+DRI_CONF_OPT_END
+
 #define DRI_CONF_RADEONSI_CLEAR_DB_CACHE_BEFORE_CLEAR(def) \
 DRI_CONF_OPT_BEGIN_B(radeonsi_clear_db_cache_before_clear, def) \
         DRI_CONF_DESC(en,"Clear DB cache before fast depth clear") \
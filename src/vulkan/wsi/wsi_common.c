@@ -877,6 +877,8 @@ wsi_common_queue_present(const struct wsi_device *wsi,
 
    const VkPresentRegionsKHR *regions =
       vk_find_struct_const(pPresentInfo->pNext, PRESENT_REGIONS_KHR);
+   const VkPresentTimesInfoGOOGLE *times =
+      vk_find_struct_const(pPresentInfo->pNext, PRESENT_TIMES_INFO_GOOGLE);
 
    for (uint32_t i = 0; i < pPresentInfo->swapchainCount; i++) {
       WSI_FROM_HANDLE(wsi_swapchain, swapchain, pPresentInfo->pSwapchains[i]);
@@ -946,9 +948,13 @@ wsi_common_queue_present(const struct wsi_device *wsi,
       if (regions && regions->pRegions)
          region = &regions->pRegions[i];
 
+      const VkPresentTimeGOOGLE *present_time = NULL;
+      if (times && times->pTimes)
+         present_time = &times->pTimes[i];
+
       result = swapchain->queue_present(swapchain,
                                         pPresentInfo->pImageIndices[i],
-                                        region);
+                                        region, present_time);
       if (result != VK_SUCCESS)
          goto fail_present;
 
@@ -972,3 +978,45 @@ wsi_common_queue_present(const struct wsi_device *wsi,
 
    return final_result;
 }
+
+/* Used when the backend hasn't (yet) measured the display's refresh rate. */
+#define WSI_NOMINAL_REFRESH_DURATION (1000000000ull / 60)
+
+VkResult
+wsi_common_get_refresh_cycle_duration(VkSwapchainKHR _swapchain,
+                                      VkRefreshCycleDurationGOOGLE *pDisplayTimingProperties)
+{
+   WSI_FROM_HANDLE(wsi_swapchain, swapchain, _swapchain);
+
+   pDisplayTimingProperties->refreshDuration = 0;
+
+   if (swapchain->get_refresh_cycle_duration) {
+      VkResult result =
+         swapchain->get_refresh_cycle_duration(swapchain,
+                                               pDisplayTimingProperties);
+      if (result != VK_SUCCESS)
+         return result;
+   }
+
+   if (pDisplayTimingProperties->refreshDuration == 0)
+      pDisplayTimingProperties->refreshDuration = WSI_NOMINAL_REFRESH_DURATION;
+
+   return VK_SUCCESS;
+}
+
+VkResult
+wsi_common_get_past_presentation_timing(VkSwapchainKHR _swapchain,
+                                        uint32_t *pPresentationTimingCount,
+                                        VkPastPresentationTimingGOOGLE *pPresentationTimings)
+{
+   WSI_FROM_HANDLE(wsi_swapchain, swapchain, _swapchain);
+
+   if (!swapchain->get_past_presentation_timing) {
+      *pPresentationTimingCount = 0;
+      return VK_SUCCESS;
+   }
+
+   return swapchain->get_past_presentation_timing(swapchain,
+                                                  pPresentationTimingCount,
+                                                  pPresentationTimings);
+}
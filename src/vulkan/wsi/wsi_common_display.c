@@ -1654,7 +1654,8 @@ _wsi_display_queue_next(struct wsi_swapchain *drv_chain)
 static VkResult
 wsi_display_queue_present(struct wsi_swapchain *drv_chain,
                           uint32_t image_index,
-                          const VkPresentRegionKHR *damage)
+                          const VkPresentRegionKHR *damage,
+                          const VkPresentTimeGOOGLE *present_time)
 {
    struct wsi_display_swapchain *chain =
       (struct wsi_display_swapchain *) drv_chain;
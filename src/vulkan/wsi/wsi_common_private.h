@@ -66,7 +66,17 @@ struct wsi_swapchain {
                                   uint32_t *image_index);
    VkResult (*queue_present)(struct wsi_swapchain *swap_chain,
                              uint32_t image_index,
-                             const VkPresentRegionKHR *damage);
+                             const VkPresentRegionKHR *damage,
+                             const VkPresentTimeGOOGLE *present_time);
+
+   /* Optional VK_GOOGLE_display_timing support.  Backends which can't
+    * report presentation feedback leave these NULL.
+    */
+   VkResult (*get_refresh_cycle_duration)(struct wsi_swapchain *swap_chain,
+                                          VkRefreshCycleDurationGOOGLE *props);
+   VkResult (*get_past_presentation_timing)(struct wsi_swapchain *swap_chain,
+                                            uint32_t *count,
+                                            VkPastPresentationTimingGOOGLE *timings);
 };
 
 VkResult
@@ -105,14 +105,13 @@ wsi_queue_push(struct wsi_queue *queue, uint32_t index)
 #define NSEC_PER_SEC 1000000000
 #define INT_TYPE_MAX(type) ((1ull << (sizeof(type) * 8 - 1)) - 1)
 
-static inline VkResult
-wsi_queue_pull(struct wsi_queue *queue, uint32_t *index, uint64_t timeout)
+/* Converts a relative timeout into an absolute CLOCK_MONOTONIC time suitable
+ * for pthread_cond_timedwait() on a condition initialized as in
+ * wsi_queue_init().
+ */
+static inline struct timespec
+wsi_queue_abs_timeout(uint64_t timeout)
 {
-   VkResult result;
-   int32_t ret;
-
-   pthread_mutex_lock(&queue->mutex);
-
    struct timespec now;
    clock_gettime(CLOCK_MONOTONIC, &now);
 
@@ -128,6 +127,19 @@ wsi_queue_pull(struct wsi_queue *queue, uint32_t *index, uint64_t timeout)
    abstime.tv_nsec = abs_nsec;
    abstime.tv_sec = MIN2(abs_sec, INT_TYPE_MAX(abstime.tv_sec));
 
+   return abstime;
+}
+
+static inline VkResult
+wsi_queue_pull(struct wsi_queue *queue, uint32_t *index, uint64_t timeout)
+{
+   VkResult result;
+   int32_t ret;
+
+   pthread_mutex_lock(&queue->mutex);
+
+   struct timespec abstime = wsi_queue_abs_timeout(timeout);
+
    while (u_vector_length(&queue->vector) == 0) {
       ret = pthread_cond_timedwait(&queue->cond, &queue->mutex, &abstime);
       if (ret == 0) {
@@ -154,9 +154,8 @@ wl_drm_format_for_vk_format(VkFormat vk_format, bool alpha)
 }
 
 static void
-drm_handle_format(void *data, struct wl_drm *drm, uint32_t wl_format)
+wsi_wl_display_add_wl_format(struct wsi_wl_display *display, uint32_t wl_format)
 {
-   struct wsi_wl_display *display = data;
    if (display->formats.element_size == 0)
       return;
 
@@ -212,6 +211,14 @@ drm_handle_format(void *data, struct wl_drm *drm, uint32_t wl_format)
    }
 }
 
+static void
+drm_handle_format(void *data, struct wl_drm *drm, uint32_t wl_format)
+{
+   struct wsi_wl_display *display = data;
+
+   wsi_wl_display_add_wl_format(display, wl_format);
+}
+
 static void
 drm_handle_authenticated(void *data, struct wl_drm *drm)
 {
@@ -252,6 +259,12 @@ dmabuf_handle_modifier(void *data, struct zwp_linux_dmabuf_v1 *dmabuf,
    if (display->formats.element_size == 0)
       return;
 
+   /* Without wl_drm, this is the only place we learn about formats.  An
+    * invalid modifier still tells us the format works with an implicit
+    * layout.
+    */
+   wsi_wl_display_add_wl_format(display, format);
+
    if (modifier_hi == (DRM_FORMAT_MOD_INVALID >> 32) &&
        modifier_lo == (DRM_FORMAT_MOD_INVALID & 0xffffffff))
       return;
@@ -374,19 +387,21 @@ wsi_wl_display_init(struct wsi_wayland *wsi_wl,
 
    wl_registry_add_listener(registry, &registry_listener, display);
 
-   /* Round-trip to get the wl_drm global */
+   /* Round-trip to get the wl_drm and zwp_linux_dmabuf_v1 globals */
    wl_display_roundtrip_queue(display->wl_display, display->queue);
 
-   if (!display->drm) {
+   if (!display->drm && !display->dmabuf) {
       result = VK_ERROR_SURFACE_LOST_KHR;
       goto fail_registry;
    }
 
-   /* Round-trip to get wl_drm formats and capabilities */
+   /* Round-trip to get wl_drm formats and capabilities, and dmabuf
+    * formats and modifiers.
+    */
    wl_display_roundtrip_queue(display->wl_display, display->queue);
 
-   /* We need prime support */
-   if (!(display->capabilities & WL_DRM_CAPABILITY_PRIME)) {
+   /* We need prime support, unless we can share buffers through dmabuf */
+   if (!display->dmabuf && !(display->capabilities & WL_DRM_CAPABILITY_PRIME)) {
       result = VK_ERROR_SURFACE_LOST_KHR;
       goto fail_registry;
    }
@@ -710,7 +725,8 @@ static const struct wl_callback_listener frame_listener = {
 static VkResult
 wsi_wl_swapchain_queue_present(struct wsi_swapchain *wsi_chain,
                                uint32_t image_index,
-                               const VkPresentRegionKHR *damage)
+                               const VkPresentRegionKHR *damage,
+                               const VkPresentTimeGOOGLE *present_time)
 {
    struct wsi_wl_swapchain *chain = (struct wsi_wl_swapchain *)wsi_chain;
 
@@ -800,7 +816,11 @@ wsi_wl_image_init(struct wsi_wl_swapchain *chain,
    if (result != VK_SUCCESS)
       return result;
 
-   if (image->base.drm_modifier != DRM_FORMAT_MOD_INVALID) {
+   /* Prefer wl_drm for implicit modifiers, as older compositors may not
+    * accept DRM_FORMAT_MOD_INVALID through linux-dmabuf.  If there is no
+    * wl_drm, dmabuf is all we have.
+    */
+   if (image->base.drm_modifier != DRM_FORMAT_MOD_INVALID || !chain->drm_wrapper) {
       /* Only request modifiers if we have dmabuf, else it must be implicit. */
       assert(display->dmabuf);
 
@@ -961,13 +981,15 @@ wsi_wl_surface_create_swapchain(VkIcdSurfaceBase *icd_surface,
                       chain->display->queue);
    chain->surface_version = wl_proxy_get_version((void *)surface->surface);
 
-   chain->drm_wrapper = wl_proxy_create_wrapper(chain->display->drm);
-   if (!chain->drm_wrapper) {
-      result = VK_ERROR_OUT_OF_HOST_MEMORY;
-      goto fail;
+   if (chain->display->drm) {
+      chain->drm_wrapper = wl_proxy_create_wrapper(chain->display->drm);
+      if (!chain->drm_wrapper) {
+         result = VK_ERROR_OUT_OF_HOST_MEMORY;
+         goto fail;
+      }
+      wl_proxy_set_queue((struct wl_proxy *) chain->drm_wrapper,
+                         chain->display->queue);
    }
-   wl_proxy_set_queue((struct wl_proxy *) chain->drm_wrapper,
-                      chain->display->queue);
 
    chain->fifo_ready = true;
 
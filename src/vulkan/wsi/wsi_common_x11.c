@@ -37,6 +37,7 @@
 #include <poll.h>
 #include <xf86drm.h>
 #include <drm_fourcc.h>
+#include "util/debug.h"
 #include "util/hash_table.h"
 
 #include "vk_util.h"
@@ -646,8 +647,19 @@ struct x11_image {
    bool                                      busy;
    struct xshmfence *                        shm_fence;
    uint32_t                                  sync_fence;
+
+   /* VK_GOOGLE_display_timing state of the last present of this image */
+   bool                                      has_present_time;
+   uint32_t                                  present_id;
+   uint64_t                                  desired_present_time;
+   uint32_t                                  present_serial;
 };
 
+/* Number of completed presents we keep around for
+ * vkGetPastPresentationTimingGOOGLE before dropping the oldest ones.
+ */
+#define X11_PRESENT_TIMING_HISTORY 16
+
 struct x11_swapchain {
    struct wsi_swapchain                        base;
 
@@ -663,8 +675,23 @@ struct x11_swapchain {
    xcb_special_event_t *                        special_event;
    uint64_t                                     send_sbc;
    uint64_t                                     last_present_msc;
+   uint64_t                                     last_present_ust;
    uint32_t                                     stamp;
 
+   /* Protects the timing history, refresh_duration and presents_pending */
+   pthread_mutex_t                              timing_mutex;
+   pthread_cond_t                               present_done_cond;
+   uint64_t                                     refresh_duration;
+   uint32_t                                     timing_first;
+   uint32_t                                     timing_count;
+   VkPastPresentationTimingGOOGLE               timings[X11_PRESENT_TIMING_HISTORY];
+
+   /* In low-latency mode, acquire waits until every queued present has
+    * landed so that the application samples its input as late as possible.
+    */
+   bool                                         low_latency;
+   uint32_t                                     presents_pending;
+
    bool                                         threaded;
    VkResult                                     status;
    xcb_present_complete_mode_t                  last_present_mode;
@@ -723,6 +750,136 @@ x11_get_wsi_image(struct wsi_swapchain *wsi_chain, uint32_t image_index)
 /**
  * Process an X11 Present event. Does not update chain->status.
  */
+/**
+ * Record the feedback of a completed present: refine our estimate of the
+ * refresh cycle from the distance to the previous completion, and if the
+ * application asked for timing with VkPresentTimeGOOGLE, queue the result
+ * for vkGetPastPresentationTimingGOOGLE.
+ */
+static void
+x11_record_present_timing(struct x11_swapchain *chain,
+                          const xcb_present_complete_notify_event_t *complete)
+{
+   pthread_mutex_lock(&chain->timing_mutex);
+
+   if (chain->last_present_ust != 0 &&
+       complete->msc > chain->last_present_msc &&
+       complete->ust > chain->last_present_ust) {
+      chain->refresh_duration =
+         (complete->ust - chain->last_present_ust) * 1000 /
+         (complete->msc - chain->last_present_msc);
+   }
+
+   for (unsigned i = 0; i < chain->base.image_count; i++) {
+      struct x11_image *image = &chain->images[i];
+
+      if (!image->has_present_time || image->present_serial != complete->serial)
+         continue;
+
+      if (chain->timing_count == X11_PRESENT_TIMING_HISTORY) {
+         chain->timing_first = (chain->timing_first + 1) %
+                               X11_PRESENT_TIMING_HISTORY;
+         chain->timing_count--;
+      }
+
+      uint32_t slot = (chain->timing_first + chain->timing_count) %
+                      X11_PRESENT_TIMING_HISTORY;
+      chain->timings[slot] = (VkPastPresentationTimingGOOGLE) {
+         .presentID = image->present_id,
+         .desiredPresentTime = image->desired_present_time,
+         .actualPresentTime = complete->ust * 1000,
+         .earliestPresentTime = complete->ust * 1000,
+         .presentMargin = 0,
+      };
+      chain->timing_count++;
+
+      image->has_present_time = false;
+      break;
+   }
+
+   pthread_mutex_unlock(&chain->timing_mutex);
+}
+
+static VkResult
+x11_get_refresh_cycle_duration(struct wsi_swapchain *wsi_chain,
+                               VkRefreshCycleDurationGOOGLE *props)
+{
+   struct x11_swapchain *chain = (struct x11_swapchain *)wsi_chain;
+
+   pthread_mutex_lock(&chain->timing_mutex);
+   props->refreshDuration = chain->refresh_duration;
+   pthread_mutex_unlock(&chain->timing_mutex);
+
+   return VK_SUCCESS;
+}
+
+static VkResult
+x11_get_past_presentation_timing(struct wsi_swapchain *wsi_chain,
+                                 uint32_t *count,
+                                 VkPastPresentationTimingGOOGLE *timings)
+{
+   struct x11_swapchain *chain = (struct x11_swapchain *)wsi_chain;
+   VK_OUTARRAY_MAKE(out, timings, count);
+
+   pthread_mutex_lock(&chain->timing_mutex);
+
+   if (timings == NULL) {
+      *count = chain->timing_count;
+      pthread_mutex_unlock(&chain->timing_mutex);
+      return VK_SUCCESS;
+   }
+
+   /* Each timing is only reported once, so drain what we hand out. */
+   while (chain->timing_count > 0) {
+      bool stored = false;
+      vk_outarray_append(&out, timing) {
+         *timing = chain->timings[chain->timing_first];
+         stored = true;
+      }
+      if (!stored)
+         break;
+
+      chain->timing_first = (chain->timing_first + 1) %
+                            X11_PRESENT_TIMING_HISTORY;
+      chain->timing_count--;
+   }
+
+   VkResult result = vk_outarray_status(&out);
+
+   pthread_mutex_unlock(&chain->timing_mutex);
+
+   return result;
+}
+
+/**
+ * Pick the MSC at which to show an image so that it doesn't hit the screen
+ * before the application's desiredPresentTime.  The time is rounded to the
+ * nearest vblank, since the UST we extrapolate from is only approximate.
+ */
+static uint64_t
+x11_present_target_msc(struct x11_swapchain *chain, uint32_t image_index,
+                       uint64_t target_msc)
+{
+   struct x11_image *image = &chain->images[image_index];
+
+   if (!image->has_present_time || image->desired_present_time == 0 ||
+       chain->last_present_ust == 0)
+      return target_msc;
+
+   pthread_mutex_lock(&chain->timing_mutex);
+   uint64_t refresh = chain->refresh_duration;
+   pthread_mutex_unlock(&chain->timing_mutex);
+
+   uint64_t last_time = chain->last_present_ust * 1000;
+   if (refresh == 0 || image->desired_present_time <= last_time)
+      return target_msc;
+
+   uint64_t frames = (image->desired_present_time - last_time +
+                      refresh / 2) / refresh;
+
+   return MAX2(target_msc, chain->last_present_msc + frames);
+}
+
 static VkResult
 x11_handle_dri3_present_event(struct x11_swapchain *chain,
                               xcb_present_generic_event_t *event)
@@ -755,8 +912,11 @@ x11_handle_dri3_present_event(struct x11_swapchain *chain,
 
    case XCB_PRESENT_EVENT_COMPLETE_NOTIFY: {
       xcb_present_complete_notify_event_t *complete = (void *) event;
-      if (complete->kind == XCB_PRESENT_COMPLETE_KIND_PIXMAP)
+      if (complete->kind == XCB_PRESENT_COMPLETE_KIND_PIXMAP) {
+         x11_record_present_timing(chain, complete);
          chain->last_present_msc = complete->msc;
+         chain->last_present_ust = complete->ust;
+      }
 
       VkResult result = VK_SUCCESS;
 
@@ -871,12 +1031,59 @@ x11_acquire_next_image_poll_x11(struct x11_swapchain *chain,
    }
 }
 
+/**
+ * Block until every image handed to the queue manager has been shown.
+ */
+static VkResult
+x11_wait_for_pending_presents(struct x11_swapchain *chain, uint64_t timeout)
+{
+   VkResult result = VK_SUCCESS;
+
+   pthread_mutex_lock(&chain->timing_mutex);
+
+   struct timespec abstime = wsi_queue_abs_timeout(timeout);
+
+   while (chain->presents_pending > 0 && chain->status >= 0) {
+      int ret = pthread_cond_timedwait(&chain->present_done_cond,
+                                       &chain->timing_mutex, &abstime);
+      if (ret == ETIMEDOUT) {
+         result = VK_TIMEOUT;
+         break;
+      } else if (ret != 0) {
+         result = VK_ERROR_OUT_OF_DATE_KHR;
+         break;
+      }
+   }
+
+   pthread_mutex_unlock(&chain->timing_mutex);
+
+   return result;
+}
+
+static void
+x11_present_done(struct x11_swapchain *chain, bool all)
+{
+   pthread_mutex_lock(&chain->timing_mutex);
+   if (all)
+      chain->presents_pending = 0;
+   else if (chain->presents_pending > 0)
+      chain->presents_pending--;
+   pthread_cond_broadcast(&chain->present_done_cond);
+   pthread_mutex_unlock(&chain->timing_mutex);
+}
+
 static VkResult
 x11_acquire_next_image_from_queue(struct x11_swapchain *chain,
                                   uint32_t *image_index_out, uint64_t timeout)
 {
    assert(chain->threaded);
 
+   if (chain->low_latency) {
+      VkResult result = x11_wait_for_pending_presents(chain, timeout);
+      if (result != VK_SUCCESS)
+         return x11_swapchain_result(chain, result);
+   }
+
    uint32_t image_index;
    VkResult result = wsi_queue_pull(&chain->acquire_queue,
                                     &image_index, timeout);
@@ -900,7 +1107,7 @@ x11_acquire_next_image_from_queue(struct x11_swapchain *chain,
 
 static VkResult
 x11_present_to_x11(struct x11_swapchain *chain, uint32_t image_index,
-                   uint32_t target_msc)
+                   uint64_t target_msc)
 {
    struct x11_image *image = &chain->images[image_index];
 
@@ -922,6 +1129,7 @@ x11_present_to_x11(struct x11_swapchain *chain, uint32_t image_index,
    xshmfence_reset(image->shm_fence);
 
    ++chain->send_sbc;
+   image->present_serial = (uint32_t) chain->send_sbc;
    xcb_void_cookie_t cookie =
       xcb_present_pixmap(chain->conn,
                          chain->window,
@@ -964,15 +1172,28 @@ x11_acquire_next_image(struct wsi_swapchain *anv_chain,
 static VkResult
 x11_queue_present(struct wsi_swapchain *anv_chain,
                   uint32_t image_index,
-                  const VkPresentRegionKHR *damage)
+                  const VkPresentRegionKHR *damage,
+                  const VkPresentTimeGOOGLE *present_time)
 {
    struct x11_swapchain *chain = (struct x11_swapchain *)anv_chain;
+   struct x11_image *image = &chain->images[image_index];
+
+   pthread_mutex_lock(&chain->timing_mutex);
+   image->has_present_time = present_time != NULL;
+   if (present_time) {
+      image->present_id = present_time->presentID;
+      image->desired_present_time = present_time->desiredPresentTime;
+   }
+   if (chain->low_latency)
+      chain->presents_pending++;
+   pthread_mutex_unlock(&chain->timing_mutex);
 
    if (chain->threaded) {
       wsi_queue_push(&chain->present_queue, image_index);
       return chain->status;
    } else {
-      return x11_present_to_x11(chain, image_index, 0);
+      uint64_t target_msc = x11_present_target_msc(chain, image_index, 0);
+      return x11_present_to_x11(chain, image_index, target_msc);
    }
 }
 
@@ -1003,7 +1224,9 @@ x11_manage_fifo_queues(void *state)
          return NULL;
       }
 
-      uint64_t target_msc = chain->last_present_msc + 1;
+      uint64_t target_msc =
+         x11_present_target_msc(chain, image_index,
+                                chain->last_present_msc + 1);
       result = x11_present_to_x11(chain, image_index, target_msc);
       if (result < 0)
          goto fail;
@@ -1021,11 +1244,16 @@ x11_manage_fifo_queues(void *state)
          if (result < 0)
             goto fail;
       }
+
+      if (chain->low_latency)
+         x11_present_done(chain, false);
    }
 
 fail:
    result = x11_swapchain_result(chain, result);
    wsi_queue_push(&chain->acquire_queue, UINT32_MAX);
+   if (chain->low_latency)
+      x11_present_done(chain, true);
 
    return NULL;
 }
@@ -1054,6 +1282,7 @@ x11_image_init(VkDevice device_h, struct x11_swapchain *chain,
       return result;
 
    image->pixmap = xcb_generate_id(chain->conn);
+   image->has_present_time = false;
 
 #ifdef HAVE_DRI3_MODIFIERS
    if (image->base.drm_modifier != DRM_FORMAT_MOD_INVALID) {
@@ -1247,6 +1476,9 @@ x11_swapchain_destroy(struct wsi_swapchain *anv_chain,
    for (uint32_t i = 0; i < chain->base.image_count; i++)
       x11_image_finish(chain, pAllocator, &chain->images[i]);
 
+   pthread_cond_destroy(&chain->present_done_cond);
+   pthread_mutex_destroy(&chain->timing_mutex);
+
    xcb_unregister_for_special_event(chain->conn, chain->special_event);
    cookie = xcb_present_select_input_checked(chain->conn, chain->event_id,
                                              chain->window,
@@ -1260,6 +1492,35 @@ x11_swapchain_destroy(struct wsi_swapchain *anv_chain,
    return VK_SUCCESS;
 }
 
+static int
+x11_swapchain_init_timing(struct x11_swapchain *chain)
+{
+   pthread_condattr_t condattr;
+   int ret;
+
+   ret = pthread_mutex_init(&chain->timing_mutex, NULL);
+   if (ret)
+      return ret;
+
+   ret = pthread_condattr_init(&condattr);
+   if (ret)
+      goto fail_mutex;
+
+   /* Matches the clock used by wsi_queue_abs_timeout() */
+   ret = pthread_condattr_setclock(&condattr, CLOCK_MONOTONIC);
+   if (ret == 0)
+      ret = pthread_cond_init(&chain->present_done_cond, &condattr);
+   pthread_condattr_destroy(&condattr);
+   if (ret)
+      goto fail_mutex;
+
+   return 0;
+
+fail_mutex:
+   pthread_mutex_destroy(&chain->timing_mutex);
+   return ret;
+}
+
 static VkResult
 x11_surface_create_swapchain(VkIcdSurfaceBase *icd_surface,
                              VkDevice device,
@@ -1303,10 +1564,17 @@ x11_surface_create_swapchain(VkIcdSurfaceBase *icd_surface,
    if (result != VK_SUCCESS)
       goto fail_alloc;
 
+   if (x11_swapchain_init_timing(chain)) {
+      result = VK_ERROR_OUT_OF_HOST_MEMORY;
+      goto fail_timing;
+   }
+
    chain->base.destroy = x11_swapchain_destroy;
    chain->base.get_wsi_image = x11_get_wsi_image;
    chain->base.acquire_next_image = x11_acquire_next_image;
    chain->base.queue_present = x11_queue_present;
+   chain->base.get_refresh_cycle_duration = x11_get_refresh_cycle_duration;
+   chain->base.get_past_presentation_timing = x11_get_past_presentation_timing;
    chain->base.present_mode = pCreateInfo->presentMode;
    chain->base.image_count = num_images;
    chain->conn = conn;
@@ -1315,6 +1583,12 @@ x11_surface_create_swapchain(VkIcdSurfaceBase *icd_surface,
    chain->extent = pCreateInfo->imageExtent;
    chain->send_sbc = 0;
    chain->last_present_msc = 0;
+   chain->last_present_ust = 0;
+   chain->refresh_duration = 0;
+   chain->timing_first = 0;
+   chain->timing_count = 0;
+   chain->presents_pending = 0;
+   chain->low_latency = false;
    chain->threaded = false;
    chain->status = VK_SUCCESS;
    chain->has_dri3_modifiers = wsi_conn->has_dri3_modifiers;
@@ -1382,6 +1656,7 @@ x11_surface_create_swapchain(VkIcdSurfaceBase *icd_surface,
 
    if (chain->base.present_mode == VK_PRESENT_MODE_FIFO_KHR) {
       chain->threaded = true;
+      chain->low_latency = env_var_as_boolean("MESA_VK_WSI_LOW_LATENCY", false);
 
       /* Initialize our queues.  We make them base.image_count + 1 because we will
        * occasionally use UINT32_MAX to signal the other thread that an error
@@ -1427,6 +1702,10 @@ fail_init_images:
 fail_register:
    xcb_unregister_for_special_event(chain->conn, chain->special_event);
 
+   pthread_cond_destroy(&chain->present_done_cond);
+   pthread_mutex_destroy(&chain->timing_mutex);
+
+fail_timing:
    wsi_swapchain_finish(&chain->base);
 
 fail_alloc: